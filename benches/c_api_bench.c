@@ -0,0 +1,705 @@
+// Latency benchmark for the C API and the MMDB_* compatibility layer
+//
+// Drives matchy_query(), matchy_aget_value(), matchy_result_to_json() and
+// MMDB_lookup_string() from one or more threads over a reproducible key
+// stream and reports latency percentiles and allocations per query.
+//
+// Built twice from this file (see `make bench-c`):
+//   benches/c_api_bench           - against libmatchy
+//   benches/c_api_bench_upstream  - with -DBENCH_UPSTREAM against
+//                                   libmaxminddb (--op mmdb only)
+// The two libraries export the same MMDB_* symbols, so they cannot share
+// a binary. Given the same database, --dist, --pool and --seed both
+// builds query the same keys in the same order.
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef BENCH_UPSTREAM
+#include <maxminddb.h>
+#define BACKEND_NAME "libmaxminddb"
+#else
+#include <matchy/maxminddb.h>
+#define BACKEND_NAME "matchy"
+#endif
+
+#define MAX_PATH_DEPTH 8
+
+// ============================================================================
+// Allocation counting
+// ============================================================================
+
+// glibc allows replacing malloc by defining it in the executable; each
+// replacement here counts the call on this thread and forwards to glibc's
+// own allocator, so memory from either side can be freed by the other.
+// This catches allocations made inside libmatchy, libmaxminddb and libc
+// (e.g. getaddrinfo) alike. Elsewhere allocations are not counted.
+#if defined(__GLIBC__) && !defined(BENCH_NO_ALLOC_COUNT)
+#define COUNT_ALLOCS 1
+
+static _Thread_local uint64_t thread_allocs;
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t align, size_t size);
+extern void __libc_free(void *ptr);
+
+void *malloc(size_t size) {
+    thread_allocs++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size) {
+    thread_allocs++;
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    thread_allocs++;
+    return __libc_realloc(ptr, size);
+}
+
+void *memalign(size_t align, size_t size) {
+    thread_allocs++;
+    return __libc_memalign(align, size);
+}
+
+void *aligned_alloc(size_t align, size_t size) {
+    thread_allocs++;
+    return __libc_memalign(align, size);
+}
+
+int posix_memalign(void **out, size_t align, size_t size) {
+    thread_allocs++;
+    void *ptr = __libc_memalign(align, size);
+    if (ptr == NULL) {
+        return ENOMEM;
+    }
+    *out = ptr;
+    return 0;
+}
+
+void free(void *ptr) {
+    __libc_free(ptr);
+}
+
+static uint64_t allocs_now(void) {
+    return thread_allocs;
+}
+#else
+#define COUNT_ALLOCS 0
+
+static uint64_t allocs_now(void) {
+    return 0;
+}
+#endif
+
+// ============================================================================
+// Configuration
+// ============================================================================
+
+typedef enum { OP_QUERY, OP_AGET, OP_JSON, OP_MMDB } bench_op_t;
+typedef enum { DIST_ZIPF, DIST_HIT, DIST_MISS } bench_dist_t;
+
+typedef struct {
+    const char *database;
+    const char *keys_file;
+    bench_op_t op;
+    bench_dist_t dist;
+    double zipf_s;
+    size_t pool;
+    int threads;
+    size_t ops;
+    size_t warmup;
+    uint64_t seed;
+    long cache;
+    const char *path[MAX_PATH_DEPTH + 1];
+    bool csv;
+} bench_config_t;
+
+static const char *op_names[] = {"query", "aget", "json", "mmdb"};
+static const char *dist_names[] = {"zipf", "hit", "miss"};
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options] <database>\n"
+            "\n"
+            "Options:\n"
+            "  --op OP         query | aget | json | mmdb (default: query;\n"
+            "                  the upstream build only supports mmdb)\n"
+            "  --dist DIST     zipf | hit | miss (default: zipf)\n"
+            "  --zipf-s S      Zipf exponent (default: 0.99)\n"
+            "  --pool N        distinct hit and miss keys each (default: 10000)\n"
+            "  --keys FILE     draw keys from FILE, one per line, instead of\n"
+            "                  random IPv4 addresses\n"
+            "  --threads N     query threads (default: 1)\n"
+            "  --ops N         timed queries per thread (default: 1000000)\n"
+            "  --warmup N      untimed queries per thread (default: 10000)\n"
+            "  --path A/B      lookup path for aget and mmdb (default: country/iso_code)\n"
+            "  --cache N       matchy query cache entries, 0 disables (default: 10000)\n"
+            "  --seed N        key stream seed (default: 1)\n"
+            "  --csv           print one CSV header and row instead of a report\n",
+            prog);
+}
+
+static int parse_path(char *spec, const char **path) {
+    int depth = 0;
+    for (char *part = strtok(spec, "/"); part != NULL; part = strtok(NULL, "/")) {
+        if (depth == MAX_PATH_DEPTH) {
+            return -1;
+        }
+        path[depth++] = part;
+    }
+    path[depth] = NULL;
+    return depth;
+}
+
+static int lookup_name(const char *name, const char **names, int count) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(name, names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int parse_args(int argc, char **argv, bench_config_t *cfg) {
+    static char default_path[] = "country/iso_code";
+
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->op = OP_QUERY;
+    cfg->dist = DIST_ZIPF;
+    cfg->zipf_s = 0.99;
+    cfg->pool = 10000;
+    cfg->threads = 1;
+    cfg->ops = 1000000;
+    cfg->warmup = 10000;
+    cfg->seed = 1;
+    cfg->cache = 10000;
+    parse_path(default_path, cfg->path);
+#ifdef BENCH_UPSTREAM
+    cfg->op = OP_MMDB;
+#endif
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        bool takes_value = true;
+
+        if (strcmp(arg, "--csv") == 0) {
+            cfg->csv = true;
+            takes_value = false;
+        } else if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            return -1;
+        } else if (arg[0] != '-') {
+            cfg->database = arg;
+            takes_value = false;
+        } else if (value == NULL) {
+            fprintf(stderr, "Missing value for %s\n", arg);
+            return -1;
+        } else if (strcmp(arg, "--op") == 0) {
+            int op = lookup_name(value, op_names, 4);
+            if (op < 0) {
+                fprintf(stderr, "Unknown op: %s\n", value);
+                return -1;
+            }
+            cfg->op = (bench_op_t)op;
+        } else if (strcmp(arg, "--dist") == 0) {
+            int dist = lookup_name(value, dist_names, 3);
+            if (dist < 0) {
+                fprintf(stderr, "Unknown distribution: %s\n", value);
+                return -1;
+            }
+            cfg->dist = (bench_dist_t)dist;
+        } else if (strcmp(arg, "--zipf-s") == 0) {
+            cfg->zipf_s = strtod(value, NULL);
+        } else if (strcmp(arg, "--pool") == 0) {
+            cfg->pool = strtoull(value, NULL, 10);
+        } else if (strcmp(arg, "--keys") == 0) {
+            cfg->keys_file = value;
+        } else if (strcmp(arg, "--threads") == 0) {
+            cfg->threads = atoi(value);
+        } else if (strcmp(arg, "--ops") == 0) {
+            cfg->ops = strtoull(value, NULL, 10);
+        } else if (strcmp(arg, "--warmup") == 0) {
+            cfg->warmup = strtoull(value, NULL, 10);
+        } else if (strcmp(arg, "--path") == 0) {
+            if (parse_path(argv[i + 1], cfg->path) < 0) {
+                fprintf(stderr, "Lookup path deeper than %d keys\n", MAX_PATH_DEPTH);
+                return -1;
+            }
+        } else if (strcmp(arg, "--cache") == 0) {
+            cfg->cache = atol(value);
+        } else if (strcmp(arg, "--seed") == 0) {
+            cfg->seed = strtoull(value, NULL, 10);
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", arg);
+            return -1;
+        }
+        if (takes_value) {
+            i++;
+        }
+    }
+
+    if (cfg->database == NULL) {
+        fprintf(stderr, "No database given\n");
+        return -1;
+    }
+    if (cfg->threads < 1 || cfg->ops == 0 || cfg->pool == 0 || cfg->cache < 0) {
+        fprintf(stderr, "--threads, --ops and --pool must be positive\n");
+        return -1;
+    }
+#ifdef BENCH_UPSTREAM
+    if (cfg->op != OP_MMDB) {
+        fprintf(stderr, "The upstream build only supports --op mmdb\n");
+        return -1;
+    }
+#endif
+    return 0;
+}
+
+// ============================================================================
+// Backend
+// ============================================================================
+
+typedef struct {
+    MMDB_s mmdb;
+#ifndef BENCH_UPSTREAM
+    matchy_t *db;
+#endif
+} backend_t;
+
+static int backend_open(backend_t *backend, const bench_config_t *cfg) {
+    memset(backend, 0, sizeof(*backend));
+    if (cfg->op == OP_MMDB) {
+        int status = MMDB_open(cfg->database, MMDB_MODE_MMAP, &backend->mmdb);
+        if (status != MMDB_SUCCESS) {
+            fprintf(stderr, "MMDB_open failed: %s\n", MMDB_strerror(status));
+            return -1;
+        }
+        return 0;
+    }
+#ifndef BENCH_UPSTREAM
+    matchy_open_options_t opts;
+    matchy_init_open_options(&opts);
+    opts.cache_capacity = (uint32_t)cfg->cache;
+    opts.concurrency = (uint32_t)cfg->threads;
+    backend->db = matchy_open_with_options(cfg->database, &opts);
+    if (backend->db == NULL) {
+        fprintf(stderr, "matchy_open_with_options failed: %s\n", cfg->database);
+        return -1;
+    }
+#endif
+    return 0;
+}
+
+static void backend_close(backend_t *backend, const bench_config_t *cfg) {
+    if (cfg->op == OP_MMDB) {
+        MMDB_close(&backend->mmdb);
+        return;
+    }
+#ifndef BENCH_UPSTREAM
+    matchy_close(backend->db);
+#endif
+}
+
+// Run one query; returns 1 on a hit, 0 on a miss
+static int run_op(const backend_t *backend, const bench_config_t *cfg, const char *key) {
+    if (cfg->op == OP_MMDB) {
+        int gai_error = 0;
+        int mmdb_error = 0;
+        MMDB_lookup_result_s result =
+            MMDB_lookup_string(&backend->mmdb, key, &gai_error, &mmdb_error);
+        if (!result.found_entry) {
+            return 0;
+        }
+        MMDB_entry_data_s data;
+        MMDB_aget_value(&result.entry, &data, cfg->path);
+        return 1;
+    }
+#ifndef BENCH_UPSTREAM
+    matchy_result_t result = matchy_query(backend->db, key);
+    int found = result.found;
+    if (found && cfg->op == OP_AGET) {
+        matchy_entry_s entry;
+        matchy_entry_data_t data;
+        if (matchy_result_get_entry(&result, &entry) == MATCHY_SUCCESS) {
+            matchy_aget_value(&entry, &data, cfg->path);
+        }
+    } else if (found && cfg->op == OP_JSON) {
+        char *json = matchy_result_to_json(&result);
+        matchy_free_string(json);
+    }
+    matchy_free_result(&result);
+    return found;
+#else
+    (void)key;
+    return 0;
+#endif
+}
+
+// ============================================================================
+// Key pools
+// ============================================================================
+
+// splitmix64: small, seedable and identical on every platform
+static uint64_t next_random(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static double next_unit(uint64_t *state) {
+    return (double)(next_random(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+typedef struct {
+    char **keys;
+    size_t len;
+    size_t cap;
+} key_list_t;
+
+static void key_list_push(key_list_t *list, const char *key) {
+    if (list->len == list->cap) {
+        list->cap = list->cap ? list->cap * 2 : 1024;
+        list->keys = realloc(list->keys, list->cap * sizeof(char *));
+    }
+    list->keys[list->len++] = strdup(key);
+}
+
+static void key_list_free(key_list_t *list) {
+    for (size_t i = 0; i < list->len; i++) {
+        free(list->keys[i]);
+    }
+    free(list->keys);
+}
+
+// Sort a candidate key into the hit or miss pool by querying it once
+static void classify(const backend_t *backend, const bench_config_t *cfg, const char *key,
+                     key_list_t *hits, key_list_t *misses) {
+    key_list_t *list = run_op(backend, cfg, key) ? hits : misses;
+    if (list->len < cfg->pool) {
+        key_list_push(list, key);
+    }
+}
+
+static int build_pools(const backend_t *backend, const bench_config_t *cfg, key_list_t *hits,
+                       key_list_t *misses) {
+    bool need_hits = cfg->dist != DIST_MISS;
+    bool need_misses = cfg->dist != DIST_HIT;
+
+    if (cfg->keys_file != NULL) {
+        FILE *f = fopen(cfg->keys_file, "r");
+        if (f == NULL) {
+            fprintf(stderr, "Cannot open %s: %s\n", cfg->keys_file, strerror(errno));
+            return -1;
+        }
+        char line[1024];
+        while (fgets(line, sizeof(line), f) != NULL) {
+            line[strcspn(line, "\r\n")] = '\0';
+            if (line[0] != '\0') {
+                classify(backend, cfg, line, hits, misses);
+            }
+        }
+        fclose(f);
+    } else {
+        // Random IPv4 addresses until both pools are full (or clearly can't be)
+        uint64_t state = cfg->seed;
+        size_t limit = cfg->pool * 1000;
+        for (size_t tried = 0; tried < limit; tried++) {
+            if ((!need_hits || hits->len == cfg->pool) &&
+                (!need_misses || misses->len == cfg->pool)) {
+                break;
+            }
+            uint32_t ip = (uint32_t)next_random(&state);
+            char key[16];
+            snprintf(key, sizeof(key), "%u.%u.%u.%u", ip >> 24, (ip >> 16) & 0xff,
+                     (ip >> 8) & 0xff, ip & 0xff);
+            classify(backend, cfg, key, hits, misses);
+        }
+    }
+
+    if ((need_hits && hits->len == 0) || (need_misses && misses->len == 0)) {
+        fprintf(stderr, "No %s keys found for --dist %s\n",
+                need_hits && hits->len == 0 ? "hit" : "miss", dist_names[cfg->dist]);
+        return -1;
+    }
+    return 0;
+}
+
+// ============================================================================
+// Workers
+// ============================================================================
+
+typedef struct {
+    const backend_t *backend;
+    const bench_config_t *cfg;
+    const char **pool;
+    size_t pool_len;
+    const double *zipf_cdf;
+    atomic_int *ready;
+    atomic_bool *go;
+    int id;
+    uint64_t *latencies;
+    uint64_t allocs;
+    uint64_t hits;
+    uint64_t elapsed_ns;
+} worker_t;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Draw the whole key sequence up front so the timed loop only queries
+static size_t *draw_sequence(const worker_t *w, size_t count) {
+    size_t *seq = malloc(count * sizeof(size_t));
+    uint64_t state = w->cfg->seed * 0x100000001b3ULL + (uint64_t)w->id + 1;
+    for (size_t i = 0; i < count; i++) {
+        if (w->zipf_cdf == NULL) {
+            seq[i] = (size_t)(next_random(&state) % w->pool_len);
+            continue;
+        }
+        // Smallest rank whose cumulative probability covers u
+        double u = next_unit(&state);
+        size_t lo = 0;
+        size_t hi = w->pool_len - 1;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (w->zipf_cdf[mid] < u) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        seq[i] = lo;
+    }
+    return seq;
+}
+
+static void *worker_main(void *arg) {
+    worker_t *w = arg;
+    const bench_config_t *cfg = w->cfg;
+    size_t *warm = draw_sequence(w, cfg->warmup);
+    size_t *seq = draw_sequence(w, cfg->ops);
+
+    for (size_t i = 0; i < cfg->warmup; i++) {
+        run_op(w->backend, cfg, w->pool[warm[i]]);
+    }
+
+    // Start every thread's timed loop together
+    atomic_fetch_add(w->ready, 1);
+    while (!atomic_load(w->go)) {
+    }
+
+    uint64_t allocs_before = allocs_now();
+    uint64_t start = now_ns();
+    uint64_t hits = 0;
+    for (size_t i = 0; i < cfg->ops; i++) {
+        const char *key = w->pool[seq[i]];
+        uint64_t t0 = now_ns();
+        hits += (uint64_t)run_op(w->backend, cfg, key);
+        w->latencies[i] = now_ns() - t0;
+    }
+    w->elapsed_ns = now_ns() - start;
+    w->allocs = allocs_now() - allocs_before;
+    w->hits = hits;
+
+    free(warm);
+    free(seq);
+    return NULL;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint64_t percentile(const uint64_t *sorted, size_t n, double q) {
+    size_t rank = (size_t)ceil(q * (double)n);
+    return sorted[rank == 0 ? 0 : rank - 1];
+}
+
+// Shuffle so Zipf ranks are not ordered by hit/miss or by address
+static void shuffle(const char **keys, size_t n, uint64_t seed) {
+    uint64_t state = seed ^ 0x5851f42d4c957f2dULL;
+    for (size_t i = n; i > 1; i--) {
+        size_t j = (size_t)(next_random(&state) % i);
+        const char *tmp = keys[i - 1];
+        keys[i - 1] = keys[j];
+        keys[j] = tmp;
+    }
+}
+
+int main(int argc, char **argv) {
+    bench_config_t cfg;
+    if (parse_args(argc, argv, &cfg) != 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    backend_t backend;
+    if (backend_open(&backend, &cfg) != 0) {
+        return 1;
+    }
+
+    key_list_t hits = {0};
+    key_list_t misses = {0};
+    if (build_pools(&backend, &cfg, &hits, &misses) != 0) {
+        backend_close(&backend, &cfg);
+        return 1;
+    }
+
+    // hit: hit keys uniformly; miss: miss keys uniformly;
+    // zipf: both pools together, Zipf-ranked after a seeded shuffle
+    size_t pool_len = 0;
+    const char **pool = malloc((hits.len + misses.len) * sizeof(char *));
+    if (cfg.dist != DIST_MISS) {
+        for (size_t i = 0; i < hits.len; i++) {
+            pool[pool_len++] = hits.keys[i];
+        }
+    }
+    if (cfg.dist != DIST_HIT) {
+        for (size_t i = 0; i < misses.len; i++) {
+            pool[pool_len++] = misses.keys[i];
+        }
+    }
+
+    double *zipf_cdf = NULL;
+    if (cfg.dist == DIST_ZIPF) {
+        shuffle(pool, pool_len, cfg.seed);
+        zipf_cdf = malloc(pool_len * sizeof(double));
+        double sum = 0.0;
+        for (size_t i = 0; i < pool_len; i++) {
+            sum += 1.0 / pow((double)(i + 1), cfg.zipf_s);
+            zipf_cdf[i] = sum;
+        }
+        for (size_t i = 0; i < pool_len; i++) {
+            zipf_cdf[i] /= sum;
+        }
+    }
+
+    atomic_int ready = 0;
+    atomic_bool go = false;
+    worker_t *workers = calloc((size_t)cfg.threads, sizeof(worker_t));
+    pthread_t *tids = calloc((size_t)cfg.threads, sizeof(pthread_t));
+    uint64_t *latencies = malloc((size_t)cfg.threads * cfg.ops * sizeof(uint64_t));
+    if (workers == NULL || tids == NULL || latencies == NULL) {
+        fprintf(stderr, "Out of memory for %zu latency samples\n", (size_t)cfg.threads * cfg.ops);
+        return 1;
+    }
+
+    for (int t = 0; t < cfg.threads; t++) {
+        workers[t] = (worker_t){
+            .backend = &backend,
+            .cfg = &cfg,
+            .pool = pool,
+            .pool_len = pool_len,
+            .zipf_cdf = zipf_cdf,
+            .ready = &ready,
+            .go = &go,
+            .id = t,
+            .latencies = latencies + (size_t)t * cfg.ops,
+        };
+        pthread_create(&tids[t], NULL, worker_main, &workers[t]);
+    }
+    while (atomic_load(&ready) < cfg.threads) {
+    }
+    atomic_store(&go, true);
+
+    uint64_t total_allocs = 0;
+    uint64_t total_hits = 0;
+    uint64_t wall_ns = 0;
+    for (int t = 0; t < cfg.threads; t++) {
+        pthread_join(tids[t], NULL);
+        total_allocs += workers[t].allocs;
+        total_hits += workers[t].hits;
+        if (workers[t].elapsed_ns > wall_ns) {
+            wall_ns = workers[t].elapsed_ns;
+        }
+    }
+
+    size_t n = (size_t)cfg.threads * cfg.ops;
+    uint64_t sum_ns = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum_ns += latencies[i];
+    }
+    qsort(latencies, n, sizeof(uint64_t), compare_u64);
+
+    double qps = wall_ns > 0 ? (double)n * 1e9 / (double)wall_ns : 0.0;
+    double hit_rate = (double)total_hits / (double)n;
+    double mean_ns = (double)sum_ns / (double)n;
+    uint64_t p50 = percentile(latencies, n, 0.50);
+    uint64_t p99 = percentile(latencies, n, 0.99);
+    uint64_t p999 = percentile(latencies, n, 0.999);
+    uint64_t max = latencies[n - 1];
+    double allocs_per_query = (double)total_allocs / (double)n;
+
+    if (cfg.csv) {
+        printf("backend,op,dist,threads,queries,hit_rate,qps,mean_ns,p50_ns,p99_ns,p999_ns,"
+               "max_ns,allocs_per_query\n");
+        printf("%s,%s,%s,%d,%zu,%.4f,%.0f,%.1f,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64
+               ",",
+               BACKEND_NAME, op_names[cfg.op], dist_names[cfg.dist], cfg.threads, n, hit_rate,
+               qps, mean_ns, p50, p99, p999, max);
+        if (COUNT_ALLOCS) {
+            printf("%.3f\n", allocs_per_query);
+        } else {
+            printf("\n");
+        }
+    } else {
+        printf("Backend:      %s\n", BACKEND_NAME);
+        printf("Database:     %s\n", cfg.database);
+        printf("Operation:    %s", op_names[cfg.op]);
+        if (cfg.op == OP_AGET || cfg.op == OP_MMDB) {
+            printf(" (path");
+            for (int i = 0; cfg.path[i] != NULL; i++) {
+                printf("%s%s", i ? "/" : " ", cfg.path[i]);
+            }
+            printf(")");
+        }
+        printf("\n");
+        if (cfg.dist == DIST_ZIPF) {
+            printf("Keys:         zipf s=%.2f over %zu hit + %zu miss keys\n", cfg.zipf_s,
+                   hits.len, misses.len);
+        } else {
+            printf("Keys:         %s, %zu distinct\n", dist_names[cfg.dist], pool_len);
+        }
+        printf("Threads:      %d x %zu queries (seed %" PRIu64 ")\n", cfg.threads, cfg.ops,
+               cfg.seed);
+        printf("Hit rate:     %.1f%%\n", hit_rate * 100.0);
+        printf("Throughput:   %.0f queries/s\n", qps);
+        printf("Latency (ns): mean %.1f  p50 %" PRIu64 "  p99 %" PRIu64 "  p999 %" PRIu64
+               "  max %" PRIu64 "\n",
+               mean_ns, p50, p99, p999, max);
+        if (COUNT_ALLOCS) {
+            printf("Allocations:  %.3f per query\n", allocs_per_query);
+        } else {
+            printf("Allocations:  not counted on this platform\n");
+        }
+    }
+
+    free(latencies);
+    free(tids);
+    free(workers);
+    free(zipf_cdf);
+    free(pool);
+    key_list_free(&hits);
+    key_list_free(&misses);
+    backend_close(&backend, &cfg);
+    return 0;
+}
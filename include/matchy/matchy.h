@@ -120,6 +120,66 @@ namespace matchy {
  */
 #define MATCHY_ERROR_IO -6
 
+/*
+ Address family for matchy_query_ip(): 4-byte IPv4 address
+ */
+#define MATCHY_FAMILY_IPV4 4
+
+/*
+ Address family for matchy_query_ip(): 16-byte IPv6 address
+ */
+#define MATCHY_FAMILY_IPV6 6
+
+/*
+ Cache policy for matchy_open_options_t: least recently used
+ */
+#define MATCHY_CACHE_LRU 0
+
+/*
+ Cache policy for matchy_open_options_t: CLOCK (second chance)
+ */
+#define MATCHY_CACHE_CLOCK 1
+
+/*
+ Cache policy for matchy_open_options_t: S3-FIFO
+ */
+#define MATCHY_CACHE_S3FIFO 2
+
+/*
+ Cache policy for matchy_open_options_t: W-TinyLFU
+ */
+#define MATCHY_CACHE_TINYLFU 3
+
+/*
+ Profile stage: IP tree walk (matchy_profile_t.stages index)
+ */
+#define MATCHY_STAGE_IP_TREE 0
+
+/*
+ Profile stage: literal hash lookup
+ */
+#define MATCHY_STAGE_LITERAL_HASH 1
+
+/*
+ Profile stage: Aho-Corasick pattern scan (excluding glob verification)
+ */
+#define MATCHY_STAGE_PATTERN_SCAN 2
+
+/*
+ Profile stage: glob verification of scan candidates
+ */
+#define MATCHY_STAGE_GLOB_VERIFY 3
+
+/*
+ Profile stage: result data decoding
+ */
+#define MATCHY_STAGE_DATA_DECODE 4
+
+/*
+ Number of profile stages
+ */
+#define MATCHY_STAGE_COUNT 5
+
 /*
  MMDB data type constants (matching libmaxminddb)
  Extended type marker (internal use)
@@ -207,6 +267,111 @@ namespace matchy {
  */
 #define MATCHY_ERROR_DATA_PARSE -9
 
+/*
+ Extract domain names (matchy_worker_new flag)
+ */
+#define MATCHY_EXTRACT_DOMAINS (1 << 0)
+
+/*
+ Extract email addresses
+ */
+#define MATCHY_EXTRACT_EMAILS (1 << 1)
+
+/*
+ Extract IPv4 addresses
+ */
+#define MATCHY_EXTRACT_IPV4 (1 << 2)
+
+/*
+ Extract IPv6 addresses
+ */
+#define MATCHY_EXTRACT_IPV6 (1 << 3)
+
+/*
+ Extract MD5, SHA1, SHA256, SHA384 and SHA512 hashes
+ */
+#define MATCHY_EXTRACT_HASHES (1 << 4)
+
+/*
+ Extract Bitcoin addresses
+ */
+#define MATCHY_EXTRACT_BITCOIN (1 << 5)
+
+/*
+ Extract Ethereum addresses
+ */
+#define MATCHY_EXTRACT_ETHEREUM (1 << 6)
+
+/*
+ Extract Monero addresses
+ */
+#define MATCHY_EXTRACT_MONERO (1 << 7)
+
+/*
+ Extract every supported indicator type
+ */
+#define MATCHY_EXTRACT_ALL 255
+
+/*
+ Matched indicator is an IPv4 address (matchy_scan_match_t.type_)
+ */
+#define MATCHY_ITEM_IPV4 1
+
+/*
+ Matched indicator is an IPv6 address
+ */
+#define MATCHY_ITEM_IPV6 2
+
+/*
+ Matched indicator is a domain name
+ */
+#define MATCHY_ITEM_DOMAIN 3
+
+/*
+ Matched indicator is an email address
+ */
+#define MATCHY_ITEM_EMAIL 4
+
+/*
+ Matched indicator is an MD5 hash
+ */
+#define MATCHY_ITEM_MD5 5
+
+/*
+ Matched indicator is a SHA1 hash
+ */
+#define MATCHY_ITEM_SHA1 6
+
+/*
+ Matched indicator is a SHA256 hash
+ */
+#define MATCHY_ITEM_SHA256 7
+
+/*
+ Matched indicator is a SHA384 hash
+ */
+#define MATCHY_ITEM_SHA384 8
+
+/*
+ Matched indicator is a SHA512 hash
+ */
+#define MATCHY_ITEM_SHA512 9
+
+/*
+ Matched indicator is a Bitcoin address
+ */
+#define MATCHY_ITEM_BITCOIN 10
+
+/*
+ Matched indicator is an Ethereum address
+ */
+#define MATCHY_ITEM_ETHEREUM 11
+
+/*
+ Matched indicator is a Monero address
+ */
+#define MATCHY_ITEM_MONERO 12
+
 /*
  Standard validation level - all offsets, UTF-8, basic structure
  */
@@ -233,14 +398,118 @@ typedef struct matchy_builder_t {
  Database opening options
 
  Configure how databases are loaded, including cache settings and validation.
+ Always start from matchy_init_open_options(): it fills in `struct_size`,
+ which lets later releases append fields without breaking callers.
  */
 typedef struct matchy_open_options_t {
+  /*
+   Size of this struct as the caller was compiled against it
+   Set by matchy_init_open_options(); matchy_open_with_options() fails
+   on sizes it does not recognize.
+   */
+  uint32_t struct_size;
   /*
    LRU cache capacity
    0 = disable cache, >0 = cache this many entries
    Default: 10000
    */
   uint32_t cache_capacity;
+  /*
+   Cache replacement policy: one of the MATCHY_CACHE_* constants
+   MATCHY_CACHE_S3FIFO and MATCHY_CACHE_TINYLFU keep a burst of unique
+   queries from flushing the hot entries; matchy_get_stats() reports
+   each policy's evictions, rejections and promotions.
+   Unknown values make matchy_open_with_options() fail.
+   Default: MATCHY_CACHE_LRU
+   */
+  uint32_t cache_policy;
+  /*
+   Misses to remember in a separate lock-free negative cache
+   Misses then no longer take LRU entries from hits, and a repeated miss
+   costs one atomic load. Works with or without the LRU cache.
+   Entries are 64-bit fingerprints, not checked against the query: a
+   match whose fingerprint collides with a remembered miss is reported
+   as not found (odds about capacity / 2^64 per lookup).
+   0 = misses share the LRU cache
+   Default: 0
+   */
+  uint32_t negative_cache_capacity;
+  /*
+   Number of threads expected to query the handle concurrently
+   Handles are always thread-safe and give each thread its own pattern
+   scratch; values > 1 also shard the shared cache so threads don't contend.
+   0 or 1 = single shard (lowest memory)
+   Default: 1
+   */
+  uint32_t concurrency;
+  /*
+   Return lazy results that reference the mapped data section
+   A hit then allocates nothing, but each found result holds a reference
+   that keeps its version of the file mapped across matchy_reload(), so
+   lazy results MUST still be freed with matchy_free_result(), which
+   releases that reference. matchy_aget_value() and
+   matchy_get_entry_data_list() decode straight from the file. Lazy
+   queries bypass the cache. String values point into the database, stay
+   valid until the result is freed, and are NOT null-terminated (use data_size).
+   Ignored for pattern-only databases, which have no data section, and
+   for handles with overlays, whose answers can span several files.
+   Default: false
+   */
+  bool lazy_results;
+  /*
+   Build a 2^16-entry direct-index table for IPv4 lookups at open
+   The first 16 bits of every IPv4 lookup become one array read instead
+   of 16 tree levels. Costs 320 KiB per handle and a short walk at open.
+   Default: false
+   */
+  bool ipv4_direct_index;
+  /*
+   Warm the new cache in matchy_reload() before swapping the file in
+   The most recently used cached queries are re-run against the new
+   file, so the cache hit rate survives the reload.
+   Default: true
+   */
+  bool reload_warm_cache;
+  /*
+   Fault in the hot sections (IP tree or stride index, prefilter,
+   literal hash table, glob automaton) before open returns, then read
+   the rest of the file ahead in the background
+   Avoids the page-fault latency spike on the first queries after an
+   open or reload.
+   Default: false
+   */
+  bool prefault;
+  /*
+   Lock the mapped file in RAM (mlock)
+   Needs CAP_IPC_LOCK or a large enough RLIMIT_MEMLOCK; the open fails
+   if the lock is refused.
+   Default: false
+   */
+  bool lock_memory;
+  /*
+   Ask for transparent huge pages over the mapping (Linux only)
+   A hint: ignored where unsupported.
+   Default: false
+   */
+  bool huge_pages;
+  /*
+   Trusted open: skip parsing the string sections at open
+   Only the metadata and section headers are read and checked against
+   the header checksum written at build time; the literal table and
+   glob matcher are set up by the first query that needs them, so open
+   time no longer grows with the file. A malformed section then fails
+   those queries instead of the open. Files without a checksum are
+   opened normally. Only use with files you built or validated.
+   Default: false
+   */
+  bool trusted;
+  /*
+   Profile one query in every N (rounded up to a power of two)
+   Sampled queries record per-stage latency histograms and scan
+   counters, read back with matchy_get_profile(). 0 disables profiling.
+   Default: 0
+   */
+  uint32_t profile_sample_rate;
 } matchy_open_options_t;
 
 /*
@@ -250,6 +519,20 @@ typedef struct matchy_t {
   uint8_t _private[0];
 } matchy_t;
 
+/*
+ Opaque arena handle (see matchy_arena_new)
+ */
+typedef struct matchy_arena_t {
+  uint8_t _private[0];
+} matchy_arena_t;
+
+/*
+ Opaque extract-and-match worker handle (see matchy_worker_new)
+ */
+typedef struct matchy_worker_t {
+  uint8_t _private[0];
+} matchy_worker_t;
+
 /*
  Database statistics
  */
@@ -282,8 +565,93 @@ typedef struct matchy_stats_t {
    Number of string queries (literal or pattern)
    */
   uint64_t string_queries;
+  /*
+   Cache entries evicted to make room for new ones
+   */
+  uint64_t cache_evictions;
+  /*
+   New cache entries refused by the admission filter
+   (MATCHY_CACHE_TINYLFU only; also counted in cache_evictions)
+   */
+  uint64_t cache_rejections;
+  /*
+   Cache entries the policy kept or moved up instead of evicting
+   (CLOCK second chances, S3-FIFO and W-TinyLFU promotions)
+   */
+  uint64_t cache_promotions;
 } matchy_stats_t;
 
+/*
+ Latency summary of one query stage
+ */
+typedef struct matchy_stage_stats_t {
+  /*
+   Sampled queries that ran this stage
+   */
+  uint64_t samples;
+  /*
+   Total time spent in the stage across samples (nanoseconds)
+   */
+  uint64_t total_ns;
+  /*
+   Median latency (nanoseconds, histogram bucket floor)
+   */
+  uint64_t p50_ns;
+  /*
+   90th percentile latency (nanoseconds)
+   */
+  uint64_t p90_ns;
+  /*
+   99th percentile latency (nanoseconds)
+   */
+  uint64_t p99_ns;
+  /*
+   Largest latency seen (nanoseconds)
+   */
+  uint64_t max_ns;
+} matchy_stage_stats_t;
+
+/*
+ Sampled query profile
+
+ Only queries picked by profile_sample_rate contribute; counters cover
+ those queries, not every query.
+ */
+typedef struct matchy_profile_t {
+  /*
+   Queries that were sampled
+   */
+  uint64_t sampled_queries;
+  /*
+   Per-stage latency, indexed by MATCHY_STAGE_*
+   */
+  struct matchy_stage_stats_t stages[MATCHY_STAGE_COUNT];
+  /*
+   Aho-Corasick states entered, including failure transitions
+   */
+  uint64_t ac_states_visited;
+  /*
+   Candidate patterns produced by the pattern scan
+   */
+  uint64_t glob_candidates;
+  /*
+   Candidates run through glob verification
+   */
+  uint64_t globs_checked;
+  /*
+   Candidates glob verification rejected
+   */
+  uint64_t globs_rejected;
+  /*
+   Literal hash lookups sampled
+   */
+  uint64_t literal_lookups;
+  /*
+   Literal hash slots examined by those lookups
+   */
+  uint64_t literal_probes;
+} matchy_profile_t;
+
 /*
  Query result
  */
@@ -304,6 +672,15 @@ typedef struct matchy_result_t {
    Internal database reference (for entry.db population)
    */
   const struct matchy_t *_db_ref;
+  /*
+   Internal data section offset (for lazy results, where `_data_cache` is NULL)
+   */
+  uint32_t _data_offset;
+  /*
+   Internal reference keeping a lazy result's database version mapped
+   across matchy_reload() (released by matchy_free_result)
+   */
+  const void *_db_version;
 } matchy_result_t;
 
 /*
@@ -360,6 +737,73 @@ typedef struct matchy_entry_data_list_t {
   struct matchy_entry_data_list_t *next;
 } matchy_entry_data_list_t;
 
+/*
+ One indicator found by matchy_worker_scan() in one of the worker's databases
+ */
+typedef struct matchy_scan_match_t {
+  /*
+   Byte offset of the indicator in the scanned buffer
+   */
+  uintptr_t offset;
+  /*
+   Length of the indicator in bytes
+   */
+  uintptr_t length;
+  /*
+   The indicator itself, pointing into the scanned buffer (not null-terminated)
+   */
+  const uint8_t *text;
+  /*
+   Indicator type (one of the MATCHY_ITEM_* constants)
+   */
+  uint32_t type_;
+  /*
+   Index of the matching database in the array given to matchy_worker_new
+   */
+  uint32_t db_id;
+  /*
+   The database's result; valid only until the callback returns
+   */
+  struct matchy_result_t result;
+} matchy_scan_match_t;
+
+/*
+ Callback receiving each match from matchy_worker_scan()
+
+ Return 0 to continue scanning, anything else to stop.
+ */
+typedef int32_t (*matchy_scan_callback_t)(const struct matchy_scan_match_t *scan_match, void *ctx);
+
+/*
+ One network delivered by matchy_foreach_network()
+ */
+typedef struct matchy_network_t {
+  /*
+   First address of the network in network order: the first 4 bytes
+   for MATCHY_FAMILY_IPV4, all 16 for MATCHY_FAMILY_IPV6
+   */
+  uint8_t addr[16];
+  /*
+   MATCHY_FAMILY_IPV4 or MATCHY_FAMILY_IPV6
+   */
+  int32_t family;
+  /*
+   Network prefix length (CIDR)
+   */
+  uint8_t prefix_len;
+  /*
+   The network's data; valid only until the callback returns
+   */
+  struct matchy_result_t result;
+} matchy_network_t;
+
+/*
+ Callback receiving each network from matchy_foreach_network()
+
+ Return 0 to continue, anything else to stop.
+ */
+typedef int32_t (*matchy_network_callback_t)(const struct matchy_network_t *network, void *ctx);
+
 #ifdef __cplusplus
 extern "C" {
 #endif // __cplusplus
@@ -497,7 +941,18 @@ void matchy_builder_free(struct matchy_builder_t *builder);
  Initialize database opening options with defaults
 
  Sets default values:
+ - struct_size = sizeof(matchy_open_options_t)
  - cache_capacity = 10000
+ - cache_policy = MATCHY_CACHE_LRU
+ - negative_cache_capacity = 0
+ - concurrency = 1
+ - lazy_results = false
+ - ipv4_direct_index = false
+ - prefault = false
+ - lock_memory = false
+ - huge_pages = false
+ - trusted = false
+ - profile_sample_rate = 0
 
  # Parameters
  * `options` - Pointer to options struct to initialize (must not be NULL)
@@ -520,13 +975,18 @@ void matchy_init_open_options(struct matchy_open_options_t *options);
 
  Opens a database file with configurable cache size and validation settings.
 
+ The returned handle may be shared by any number of threads. Set
+ `concurrency` to the number of querying threads so they share one warm,
+ sharded cache instead of opening a handle per thread.
+
  # Parameters
  * `filename` - Path to database file (null-terminated C string, must not be NULL)
  * `options` - Opening options (must not be NULL)
 
  # Returns
  * Non-null pointer on success
- * NULL on failure
+ * NULL on failure, or if `options->struct_size` is not a known layout
+   (options not set up with matchy_init_open_options())
 
  # Safety
  * `filename` must be a valid null-terminated C string
@@ -544,6 +1004,35 @@ void matchy_init_open_options(struct matchy_open_options_t *options);
      fprintf(stderr, "Failed to open database\n");
      return 1;
  }
+
+ // One handle shared by a 64-thread worker pool
+ opts.concurrency = 64;
+ matchy_t *shared = matchy_open_with_options("threats.mxy", &opts);
+
+ // Allocation-free hits, decoded on demand from the mapped file
+ opts.lazy_results = true;
+ matchy_t *lazy = matchy_open_with_options("GeoLite2-City.mmdb", &opts);
+
+ // Log bursts of one-off URLs: admit only entries that prove popular
+ opts.cache_policy = MATCHY_CACHE_TINYLFU;
+ matchy_t *scan_resistant = matchy_open_with_options("threats.mxy", &opts);
+
+ // Mostly-miss workloads: keep misses from evicting cached hits
+ opts.negative_cache_capacity = 1 << 20;
+ matchy_t *feed = matchy_open_with_options("threats.mxy", &opts);
+
+ // IPv4-heavy traffic: resolve the first 16 bits with one table read
+ opts.ipv4_direct_index = true;
+ matchy_t *fast_v4 = matchy_open_with_options("GeoLite2-City.mmdb", &opts);
+
+ // No page-fault spike on the first queries after open or reload
+ opts.prefault = true;
+ opts.huge_pages = true;
+ matchy_t *warm = matchy_open_with_options("GeoLite2-City.mmdb", &opts);
+
+ // Multi-GB feed on a sensor: open in O(header), set up sections on use
+ opts.trusted = true;
+ matchy_t *quick = matchy_open_with_options("threats.mxy", &opts);
  ```
  */
 struct matchy_t *matchy_open_with_options(const char *filename, const struct matchy_open_options_t *options);
@@ -627,6 +1116,37 @@ struct matchy_t *matchy_open_buffer(const uint8_t *buffer, uintptr_t size);
  */
 void matchy_get_stats(const struct matchy_t *db, struct matchy_stats_t *stats);
 
+/*
+ Get the sampled query profile
+
+ Fills `profile` with per-stage latency percentiles and hot-path counters
+ gathered since the database was opened with a non-zero
+ profile_sample_rate. The profile carries over reloads.
+
+ # Parameters
+ * `db` - Database handle (must not be NULL)
+ * `profile` - Pointer to profile structure to fill (must not be NULL)
+
+ # Returns
+ * MATCHY_SUCCESS on success
+ * MATCHY_ERROR_INVALID_PARAM if a pointer is NULL
+ * MATCHY_ERROR_NO_DATA if profiling was not enabled
+
+ # Safety
+ * `db` must be a valid pointer from matchy_open
+ * `profile` must be a valid pointer to matchy_profile_t
+
+ # Example
+ ```c
+ matchy_profile_t prof;
+ if (matchy_get_profile(db, &prof) == MATCHY_SUCCESS) {
+     const matchy_stage_stats_t *scan = &prof.stages[MATCHY_STAGE_PATTERN_SCAN];
+     printf("pattern scan p99: %llu ns\n", scan->p99_ns);
+ }
+ ```
+ */
+int32_t matchy_get_profile(const struct matchy_t *db, struct matchy_profile_t *profile);
+
 /*
  Clear the query cache
 
@@ -671,6 +1191,62 @@ void matchy_clear_cache(const struct matchy_t *db);
  */
 void matchy_close(struct matchy_t *db);
 
+/*
+ Atomically replace the database behind a handle
+
+ Opens `filename` (or, if NULL, the file the handle was opened from)
+ with the handle's original options and swaps it in while other threads
+ keep querying. Queries already running finish on the old file; queries
+ that start after the swap see the new one, so none are dropped. With
+ `reload_warm_cache` set, the new cache is filled from the old one's
+ most recently used queries before the swap. Statistics carry over.
+
+ Lazy results obtained before the reload stay valid until they are
+ freed. Replace files by renaming a new file over the old path rather
+ than rewriting it in place.
+
+ # Parameters
+ * `db` - Database handle (must not be NULL)
+ * `filename` - Path of the new database (null-terminated C string), or
+   NULL to reopen the current path
+
+ # Returns
+ * MATCHY_SUCCESS (0) on success
+ * MATCHY_ERROR_INVALID_PARAM if `db` is NULL or `filename` is not UTF-8
+ * MATCHY_ERROR_FILE_NOT_FOUND if `filename` does not exist
+ * MATCHY_ERROR_IO or MATCHY_ERROR_INVALID_FORMAT if the new file can't
+   be opened; the handle keeps serving the old file
+
+ # Safety
+ * `db` must be a valid pointer from matchy_open
+ * `filename` must be NULL or a valid null-terminated C string
+
+ # Example
+ ```c
+ // Feed updater thread, every 5 minutes
+ rename("threats.mxy.new", "threats.mxy");
+ if (matchy_reload(db, NULL) != MATCHY_SUCCESS) {
+     fprintf(stderr, "Reload failed, still serving generation %llu\n",
+             (unsigned long long)matchy_generation(db));
+ }
+ ```
+ */
+int32_t matchy_reload(const struct matchy_t *db, const char *filename);
+
+/*
+ Number of successful matchy_reload() calls on a handle
+
+ # Parameters
+ * `db` - Database handle (must not be NULL)
+
+ # Returns
+ * 0 for a handle that was never reloaded, or if db is NULL
+
+ # Safety
+ * `db` must be a valid pointer from matchy_open
+ */
+uint64_t matchy_generation(const struct matchy_t *db);
+
 /*
  Unified query interface - automatically detects IP vs pattern
 
@@ -713,6 +1289,202 @@ void matchy_close(struct matchy_t *db);
  */
 struct matchy_result_t matchy_query(const struct matchy_t *db, const char *query);
 
+/*
+ Query the database with a length-delimited key
+
+ Same as matchy_query(), but the key is given as a pointer and length, so
+ it can be passed in place from a larger buffer (a packet, a log line, a
+ `std::string_view`) without copying it into a null-terminated temporary.
+
+ # Parameters
+ * `db` - Database handle (must not be NULL)
+ * `key` - Key bytes (need not be null-terminated; may be NULL if `len` is 0)
+ * `len` - Key length in bytes
+
+ # Returns
+ * Query result (same as matchy_query)
+ * A not-found result if `key` is not valid UTF-8
+
+ # Safety
+ * `db` must be a valid pointer from matchy_open
+ * `key` must be valid for reading `len` bytes
+
+ # Example
+ ```c
+ const char *line = "src=10.1.2.3 dst=evil.example.com";
+ matchy_result_t result = matchy_query_n(db, (const uint8_t *)line + 4, 8);
+ if (result.found) {
+     // 10.1.2.3 matched
+ }
+ matchy_free_result(&result);
+ ```
+ */
+struct matchy_result_t matchy_query_n(const struct matchy_t *db, const uint8_t *key, uintptr_t len);
+
+/*
+ Query the database with a binary IP address
+
+ Looks up an address in network byte order, as found in packet headers
+ or `struct in_addr` / `struct in6_addr`, without formatting or parsing
+ it as text. Only IP data is searched.
+
+ # Parameters
+ * `db` - Database handle (must not be NULL)
+ * `addr` - Address bytes in network order (must not be NULL): the first
+   4 bytes for MATCHY_FAMILY_IPV4, all 16 for MATCHY_FAMILY_IPV6
+ * `family` - MATCHY_FAMILY_IPV4 or MATCHY_FAMILY_IPV6
+
+ # Returns
+ * Query result (same as matchy_query)
+ * A not-found result if `family` is not recognized
+
+ # Safety
+ * `db` must be a valid pointer from matchy_open
+ * `addr` must be valid for reading 4 (IPv4) or 16 (IPv6) bytes
+
+ # Example
+ ```c
+ struct in_addr src = ip_header->ip_src;
+ matchy_result_t result = matchy_query_ip(db, (const uint8_t *)&src, MATCHY_FAMILY_IPV4);
+ if (result.found) {
+     printf("matched /%u\n", result.prefix_len);
+ }
+ matchy_free_result(&result);
+ ```
+ */
+struct matchy_result_t matchy_query_ip(const struct matchy_t *db, const uint8_t *addr, int32_t family);
+
+/*
+ Query the database with many keys in one call
+
+ Equivalent to calling matchy_query() on each key, but the per-call work
+ is amortized over the batch: IP keys are walked through the search tree
+ together with interleaved prefetching, string keys share one
+ pattern-matching scratch, and statistics are updated once.
+
+ # Parameters
+ * `db` - Database handle (must not be NULL)
+ * `keys` - Array of `n` key pointers (must not be NULL; entries must not be NULL)
+ * `lens` - Array of `n` key lengths in bytes, or NULL if every key is
+   null-terminated. Keys with explicit lengths need not be null-terminated.
+ * `n` - Number of keys
+ * `out` - Array of `n` results to fill (must not be NULL)
+
+ # Returns
+ * MATCHY_SUCCESS (0) on success; `out[i]` holds the result for `keys[i]`
+ * MATCHY_ERROR_INVALID_PARAM if a required pointer is NULL (`out` untouched)
+
+ Keys that are NULL or not valid UTF-8 produce a not-found result.
+ Every result must be freed with matchy_free_result().
+
+ # Safety
+ * `db` must be a valid pointer from matchy_open
+ * `keys` must point to `n` readable key pointers, each valid for
+   `lens[i]` bytes (or null-terminated when `lens` is NULL)
+ * `lens`, if not NULL, must point to `n` readable lengths
+ * `out` must point to `n` writable results
+
+ # Example
+ ```c
+ const char *keys[] = {"1.2.3.4", "evil.example.com", "10.0.0.1"};
+ matchy_result_t results[3];
+
+ if (matchy_query_batch(db, keys, NULL, 3, results) == MATCHY_SUCCESS) {
+     for (size_t i = 0; i < 3; i++) {
+         if (results[i].found) {
+             printf("%s matched\n", keys[i]);
+         }
+         matchy_free_result(&results[i]);
+     }
+ }
+ ```
+ */
+int32_t matchy_query_batch(const struct matchy_t *db, const char *const *keys, const uintptr_t *lens, uintptr_t n, struct matchy_result_t *out);
+
+/*
+ Query the database with many binary IP addresses, walking them in address order
+
+ Equivalent to calling matchy_query_ip() on each address, but built for
+ bulk enrichment: the addresses are sorted and the search tree is walked
+ once from low to high, each lookup resuming where it leaves the previous
+ address's path, and each data record is decoded once per run of
+ addresses that share it. The query cache is bypassed.
+
+ # Parameters
+ * `db` - Database handle (must not be NULL)
+ * `addrs` - `n` addresses in network order, packed back to back: 4 bytes
+   each for MATCHY_FAMILY_IPV4, 16 for MATCHY_FAMILY_IPV6 (must not be NULL)
+ * `family` - MATCHY_FAMILY_IPV4 or MATCHY_FAMILY_IPV6
+ * `n` - Number of addresses
+ * `out` - Array of `n` results to fill (must not be NULL)
+
+ # Returns
+ * MATCHY_SUCCESS (0) on success; `out[i]` holds the result for address `i`
+ * MATCHY_ERROR_INVALID_PARAM if a required pointer is NULL, `family`
+   is not recognized, or `n` addresses overflow the address space
+   (`out` untouched)
+
+ Every result must be freed with matchy_free_result().
+
+ # Safety
+ * `db` must be a valid pointer from matchy_open
+ * `addrs` must be valid for reading `n` addresses of `family`'s size
+ * `out` must point to `n` writable results
+
+ # Example
+ ```c
+ uint32_t addrs[1024];   // IPv4 addresses in network order
+ matchy_result_t results[1024];
+
+ if (matchy_query_ips(db, (const uint8_t *)addrs, MATCHY_FAMILY_IPV4, 1024, results) == MATCHY_SUCCESS) {
+     for (size_t i = 0; i < 1024; i++) {
+         matchy_free_result(&results[i]);
+     }
+ }
+ ```
+ */
+int32_t matchy_query_ips(const struct matchy_t *db, const uint8_t *addrs, int32_t family, uintptr_t n, struct matchy_result_t *out);
+
+/*
+ Visit every network in the database's IP tree, in address order
+
+ Walks the search tree once and calls `callback` for each network that
+ has data, which makes dumping or re-indexing a whole database a single
+ pass with no per-network lookups. A network with more specific networks
+ inside it is delivered as the pieces around them; IPv4 networks of
+ IPv6 databases are delivered as IPv4. Each network's result references
+ the data in place and supports the usual matchy_aget_value() /
+ matchy_get_entry_data_list() accessors; it must not be freed.
+
+ # Parameters
+ * `db` - Database handle (must not be NULL)
+ * `callback` - Called for each network (must not be NULL)
+ * `ctx` - Passed through to `callback`
+
+ # Returns
+ * Number of networks delivered (>= 0), including the one that stopped the walk
+ * MATCHY_ERROR_INVALID_PARAM if `db` or `callback` is NULL
+ * MATCHY_ERROR_NO_DATA if the database has no IP data or has overlays
+ * MATCHY_ERROR_CORRUPT_DATA if the tree is malformed
+
+ # Safety
+ * `db` must be a valid pointer from matchy_open
+
+ # Example
+ ```c
+ int32_t print_network(const matchy_network_t *network, void *ctx) {
+     char text[INET6_ADDRSTRLEN];
+     int af = network->family == MATCHY_FAMILY_IPV4 ? AF_INET : AF_INET6;
+     inet_ntop(af, network->addr, text, sizeof(text));
+     printf("%s/%u\n", text, network->prefix_len);
+     return 0;
+ }
+
+ int64_t count = matchy_foreach_network(db, print_network, NULL);
+ ```
+ */
+int64_t matchy_foreach_network(const struct matchy_t *db, matchy_network_callback_t callback, void *ctx);
+
 /*
  Free query result
 
@@ -1028,6 +1800,197 @@ void matchy_free_entry_data_list(struct matchy_entry_data_list_t *list);
  */
 char *matchy_result_to_json(const struct matchy_result_t *result);
 
+/*
+ Create an arena for allocation-free result rendering
+
+ An arena hands out memory by bumping a pointer through a few large
+ chunks. Output from the `*_arena` functions is carved from it and stays
+ valid until matchy_arena_reset() or matchy_arena_free(), which release
+ all of it in one step. Once the chunks have grown to a batch's working
+ size, later batches make no allocator calls at all.
+
+ An arena is not thread-safe: use one per thread.
+
+ # Parameters
+ * `chunk_size` - Size of the first chunk in bytes (0 for the default, 16KB)
+
+ # Returns
+ * Non-null arena handle (free with matchy_arena_free)
+
+ # Example
+ ```c
+ matchy_arena_t *arena = matchy_arena_new(0);
+ for (;;) {
+     // ... query a batch, render each hit with matchy_result_to_json_arena()
+     matchy_arena_reset(arena);
+ }
+ matchy_arena_free(arena);
+ ```
+ */
+struct matchy_arena_t *matchy_arena_new(uintptr_t chunk_size);
+
+/*
+ Release everything allocated from an arena, keeping its memory for reuse
+
+ Every string and list previously returned from this arena becomes
+ invalid.
+
+ # Safety
+ * `arena` must be NULL or a handle from matchy_arena_new
+ * No pointer into the arena may be used afterwards
+ */
+void matchy_arena_reset(struct matchy_arena_t *arena);
+
+/*
+ Free an arena and everything allocated from it
+
+ # Safety
+ * `arena` must be NULL or a handle from matchy_arena_new
+ * Must not be called twice on the same handle
+ */
+void matchy_arena_free(struct matchy_arena_t *arena);
+
+/*
+ Bytes handed out by an arena since its last reset
+
+ # Safety
+ * `arena` must be NULL or a handle from matchy_arena_new
+ */
+uintptr_t matchy_arena_used(const struct matchy_arena_t *arena);
+
+/*
+ Convert query result data to JSON, allocated from an arena
+
+ Same JSON value as matchy_result_to_json(), but the string lives in
+ `arena` and must not be freed. Lazy results are decoded straight into the
+ arena as well, so no heap allocation happens once the arena has warmed
+ up; their object keys keep the order stored in the file, whereas
+ matchy_result_to_json() emits keys in no particular order. Compare
+ output by value, not byte for byte.
+
+ # Returns
+ * Null-terminated JSON, valid until the arena is reset or freed
+ * NULL if a parameter is NULL, the result is not found, or conversion fails
+
+ # Safety
+ * `result` must be a valid result from a matchy query, not yet freed
+ * `arena` must be a handle from matchy_arena_new
+
+ # Example
+ ```c
+ matchy_result_t result = matchy_query(db, "8.8.8.8");
+ const char *json = matchy_result_to_json_arena(&result, arena);
+ if (json) {
+     printf("Data: %s\n", json);
+ }
+ matchy_free_result(&result);
+ ```
+ */
+const char *matchy_result_to_json_arena(const struct matchy_result_t *result, struct matchy_arena_t *arena);
+
+/*
+ Get full entry data as a linked list allocated from an arena
+
+ Same traversal as matchy_get_entry_data_list(), but nodes (and string
+ copies for decoded results) are carved from `arena`. Do not pass the
+ list to matchy_free_entry_data_list(); it is released by
+ matchy_arena_reset() or matchy_arena_free().
+
+ # Returns
+ * MATCHY_SUCCESS on success
+ * Error code on failure (`*entry_data_list` is untouched)
+
+ # Safety
+ * `entry` must be valid and its result not yet freed
+ * `entry_data_list` must be a valid pointer
+ * `arena` must be a handle from matchy_arena_new
+ */
+int32_t matchy_get_entry_data_list_arena(const struct matchy_entry_s *entry, struct matchy_entry_data_list_t **entry_data_list, struct matchy_arena_t *arena);
+
+/*
+ Create a worker that extracts indicators from raw buffers and matches them
+
+ This is the single-pass pipeline `matchy match` uses: one scan over the
+ buffer finds IP addresses, domains, emails, hashes and cryptocurrency
+ addresses, and each is looked up in every database without being copied
+ out of the buffer.
+
+ # Parameters
+ * `databases` - Array of `count` database handles (must not be NULL)
+ * `count` - Number of databases (at least 1)
+ * `extract_flags` - MATCHY_EXTRACT_* flags OR'ed together (0 for all)
+
+ # Returns
+ * Non-null worker handle (free with matchy_worker_free)
+ * NULL if a parameter is invalid or the extractor can't be built
+
+ The worker borrows the database handles: they must stay open until the
+ worker is freed. Reloads are picked up on the next scan. A worker is not
+ thread-safe; create one per thread (they can share database handles).
+
+ # Safety
+ * `databases` must point to `count` valid handles from matchy_open
+
+ # Example
+ ```c
+ const matchy_t *dbs[] = {threats, allowlist};
+ matchy_worker_t *worker = matchy_worker_new(dbs, 2,
+     MATCHY_EXTRACT_IPV4 | MATCHY_EXTRACT_IPV6 | MATCHY_EXTRACT_DOMAINS);
+ ```
+ */
+struct matchy_worker_t *matchy_worker_new(const struct matchy_t *const *databases, uintptr_t count, uint32_t extract_flags);
+
+/*
+ Extract indicators from a buffer and report every database match
+
+ Calls `callback` once per (indicator, database) match, in buffer order
+ and, for each indicator, in database order. `scan_match->text` points into
+ `buf`; `scan_match->result` behaves like a matchy_query() result (use
+ matchy_result_get_entry(), matchy_aget_value(), ...) but is owned by the
+ worker: don't free it, and don't use it after the callback returns.
+ Handles opened with `lazy_results` decode nothing unless asked to.
+
+ Each database answers the whole buffer from one version, even if it is
+ reloaded during the scan.
+
+ # Parameters
+ * `worker` - Worker handle (must not be NULL)
+ * `buf` - Bytes to scan (may be NULL if `len` is 0)
+ * `len` - Buffer length in bytes
+ * `callback` - Match callback (must not be NULL); return non-zero to stop
+ * `ctx` - Passed through to `callback`
+
+ # Returns
+ * Number of matches delivered to `callback` (>= 0)
+ * MATCHY_ERROR_INVALID_PARAM if a required pointer is NULL
+
+ # Safety
+ * `worker` must be a valid handle from matchy_worker_new
+ * `buf` must be valid for reading `len` bytes
+
+ # Example
+ ```c
+ static int32_t on_match(const matchy_scan_match_t *m, void *ctx) {
+     printf("%.*s in db %u\n", (int)m->length, (const char *)m->text, m->db_id);
+     return 0;
+ }
+
+ int64_t n = matchy_worker_scan(worker, (const uint8_t *)line, strlen(line), on_match, NULL);
+ ```
+ */
+int64_t matchy_worker_scan(struct matchy_worker_t *worker, const uint8_t *buf, uintptr_t len, matchy_scan_callback_t callback, void *ctx);
+
+/*
+ Free a worker
+
+ The database handles it was created from are not closed.
+
+ # Safety
+ * `worker` must be NULL or a handle from matchy_worker_new
+ * Must not be called twice on the same handle
+ */
+void matchy_worker_free(struct matchy_worker_t *worker);
+
 /*
  Validate a database file
 
@@ -149,7 +149,7 @@ typedef struct MMDB_entry_data_s {
 typedef struct MMDB_entry_data_list_s {
     MMDB_entry_data_s entry_data;
     struct MMDB_entry_data_list_s *next;
-    void *pool;  /* Memory pool (not used in matchy) */
+    void *pool;  /* Block pool owning the whole list */
 } MMDB_entry_data_list_s;
 
 /* Search node (for MMDB_read_node - rarely used) */
@@ -263,14 +263,15 @@ extern int MMDB_aget_value(
  * Returns:
  *   MMDB_SUCCESS on success
  * 
- * Note: Caller must free with MMDB_free_entry_data_list()
+ * Note: Caller must free with MMDB_free_entry_data_list(). Nodes and
+ * their strings come from one block pool shared by the list.
  */
 extern int MMDB_get_entry_data_list(
     MMDB_entry_s *start,
     MMDB_entry_data_list_s **entry_data_list
 );
 
-/* Free entry data list */
+/* Free entry data list (the head returned by MMDB_get_entry_data_list) */
 extern void MMDB_free_entry_data_list(
     MMDB_entry_data_list_s *entry_data_list
 );
@@ -12,6 +12,13 @@
 //! - Edge arrays referenced by nodes
 //! - Pattern ID arrays referenced by nodes
 //!
+//! Optionally, states up to a given depth are written as DFA states: a full
+//! 256-entry table with failure transitions already resolved, so the hot
+//! root and near-root states cost one indexed load per byte. Transitions
+//! can also be keyed on byte classes instead of raw bytes (see
+//! [`ByteClasses`]), which shrinks those tables to one entry per class.
+//! Both are chosen per automaton through [`ACBuildOptions`].
+//!
 //! All operations (both building and matching) work directly on this buffer.
 
 use crate::error::ParaglobError;
@@ -38,6 +45,93 @@ pub enum MatchMode {
     CaseInsensitive,
 }
 
+/// Options for [`ACAutomaton::build_with_options`]
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct ACBuildOptions {
+    /// Write states up to this depth as DFA states (`None` = no DFA states)
+    ///
+    /// DFA states hold a transition for every byte with failure links
+    /// already followed, so matching from them is one indexed load and
+    /// never walks the failure chain. `Some(0)` converts only the root,
+    /// `Some(1)` adds its children, and so on.
+    pub dfa_depth: Option<u8>,
+    /// Key transitions on [`ByteClasses`] instead of raw bytes
+    pub byte_classes: bool,
+}
+
+/// Compacted automaton alphabet: byte classes for the bytes patterns use
+///
+/// Indicator patterns use few distinct bytes. Every byte that appears in
+/// some pattern gets its own class (1, 2, ...), and all other bytes share
+/// class 0. No state has a transition on class 0, so matching resets to
+/// the root on those bytes without a lookup, and dense/DFA tables hold one
+/// entry per class instead of 256.
+///
+/// This used-alphabet compaction is also the coarsest byte equivalence
+/// a goto trie allows: the transitions out of a state all lead to distinct
+/// children, so any two used bytes differ at the state where one of them
+/// has an edge, and merging bytes by identical transition columns would
+/// find nothing more to merge.
+///
+/// In case-insensitive mode each uppercase ASCII letter shares its
+/// lowercase letter's class, so the class lookup folds case and the text
+/// no longer needs a lowercased copy.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct ByteClasses {
+    map: [u8; 256],
+    count: usize,
+}
+
+impl ByteClasses {
+    /// Classes for an alphabet where `used[b]` marks bytes that appear in
+    /// patterns; `None` when every byte value is used
+    fn for_alphabet(used: &[bool; 256], mode: MatchMode) -> Option<Self> {
+        if used.iter().all(|&u| u) {
+            return None;
+        }
+
+        let mut map = [0u8; 256];
+        let mut count = 1;
+        for (byte, _) in used.iter().enumerate().filter(|(_, &u)| u) {
+            map[byte] = count as u8;
+            count += 1;
+        }
+        if mode == MatchMode::CaseInsensitive {
+            for upper in b'A'..=b'Z' {
+                map[upper as usize] = map[upper.to_ascii_lowercase() as usize];
+            }
+        }
+        Some(Self { map, count })
+    }
+
+    /// Rebuild from a stored class map
+    pub fn from_map(map: &[u8; 256]) -> Self {
+        let count = map.iter().copied().max().unwrap_or(0) as usize + 1;
+        Self { map: *map, count }
+    }
+
+    /// The byte → class map, as stored in the file
+    pub fn map(&self) -> &[u8; 256] {
+        &self.map
+    }
+
+    /// Number of classes, including class 0
+    pub fn count(&self) -> usize {
+        self.count
+    }
+
+    /// Class of `byte`
+    #[inline(always)]
+    pub fn class(&self, byte: u8) -> u8 {
+        self.map[byte as usize]
+    }
+
+    /// Bytes per dense/DFA table: one `u32` per class, padded to a cache line
+    pub fn table_size(&self) -> usize {
+        (self.count * mem::size_of::<u32>()).div_ceil(64) * 64
+    }
+}
+
 /// Builder for constructing the offset-based AC automaton
 ///
 /// This uses temporary in-memory structures during construction,
@@ -49,6 +143,10 @@ struct ACBuilder {
     mode: MatchMode,
     /// Original patterns
     patterns: Vec<String>,
+    /// States at most this deep are written as DFA states
+    dfa_depth: Option<u8>,
+    /// Alphabet compression, decided once all patterns are in
+    classes: Option<ByteClasses>,
 }
 
 /// Temporary state structure used during construction
@@ -57,14 +155,17 @@ struct BuilderState {
     transitions: HashMap<u8, u32>,
     failure: u32,
     outputs: Vec<u32>, // Pattern IDs
+    /// Distance from the root (saturates at 255)
+    depth: u8,
 }
 
 impl BuilderState {
-    fn new(_id: u32, _depth: u8) -> Self {
+    fn new(_id: u32, depth: u8) -> Self {
         Self {
             transitions: HashMap::new(),
             failure: 0,
             outputs: Vec::new(),
+            depth,
         }
     }
 
@@ -72,11 +173,15 @@ impl BuilderState {
     ///
     /// # State Encoding Selection
     ///
+    /// - **Dfa** (depth <= `dfa_depth`): Full table with failure links folded in
     /// - **Empty** (0 transitions): Terminal states only, no lookups needed
     /// - **One** (1 transition): Store inline, eliminates cache miss (75-80% of states)
     /// - **Sparse** (2-8 transitions): Linear search is optimal for this range
     /// - **Dense** (9+ transitions): O(1) lookup table worth the 1KB overhead
-    fn classify_state_kind(&self) -> StateKind {
+    fn classify_state_kind(&self, dfa_depth: Option<u8>) -> StateKind {
+        if dfa_depth.is_some_and(|max| self.depth <= max) {
+            return StateKind::Dfa;
+        }
         match self.transitions.len() {
             0 => StateKind::Empty,
             1 => StateKind::One,
@@ -87,12 +192,25 @@ impl BuilderState {
 }
 
 impl ACBuilder {
-    fn new(mode: MatchMode) -> Self {
+    fn new(mode: MatchMode, dfa_depth: Option<u8>) -> Self {
         Self {
             states: vec![BuilderState::new(0, 0)], // Root
             mode,
             patterns: Vec::new(),
+            dfa_depth,
+            classes: None,
+        }
+    }
+
+    /// Derive byte classes by compacting the bytes the trie actually uses
+    fn build_byte_classes(&mut self) {
+        let mut used = [false; 256];
+        for state in &self.states {
+            for &ch in state.transitions.keys() {
+                used[ch as usize] = true;
+            }
         }
+        self.classes = ByteClasses::for_alphabet(&used, self.mode);
     }
 
     /// Add a pattern to the automaton
@@ -120,7 +238,7 @@ impl ACBuilder {
         let mut depth = 0u8;
 
         for &ch in &pattern_bytes {
-            depth += 1;
+            depth = depth.saturating_add(1);
 
             // Check if transition already exists
             if let Some(&next) = self.states[current as usize].transitions.get(&ch) {
@@ -206,6 +324,23 @@ impl ACBuilder {
         }
     }
 
+    /// Resolve the DFA transition from `state` on `ch`
+    ///
+    /// Follows failure links until some state has a goto edge for `ch`,
+    /// ending at the root (0) if none does - exactly what the matching loop
+    /// would do at query time.
+    fn dfa_target(&self, mut state: u32, ch: u8) -> u32 {
+        loop {
+            if let Some(&next) = self.states[state as usize].transitions.get(&ch) {
+                return next;
+            }
+            if state == 0 {
+                return 0;
+            }
+            state = self.states[state as usize].failure;
+        }
+    }
+
     /// Serialize into offset-based format with state-specific encoding
     fn serialize(self) -> Result<Vec<u8>, ParaglobError> {
         let mut buffer = Vec::new();
@@ -213,7 +348,13 @@ impl ACBuilder {
         // Calculate section sizes - using cache-optimized ACNodeHot (16 bytes)
         let node_size = mem::size_of::<ACNodeHot>();
         let edge_size = mem::size_of::<ACEdge>();
-        let dense_size = mem::size_of::<DenseLookup>();
+        // One entry per byte, or per class when the alphabet is compressed
+        let dense_size = self
+            .classes
+            .as_ref()
+            .map_or(mem::size_of::<DenseLookup>(), ByteClasses::table_size);
+        let table_entries = self.classes.as_ref().map_or(256, ByteClasses::count);
+        let edge_char = |ch: u8| self.classes.as_ref().map_or(ch, |c| c.class(ch));
 
         let nodes_start = 0;
         let nodes_size = self.states.len() * node_size;
@@ -222,12 +363,13 @@ impl ACBuilder {
         let state_kinds: Vec<StateKind> = self
             .states
             .iter()
-            .map(|s| s.classify_state_kind())
+            .map(|s| s.classify_state_kind(self.dfa_depth))
             .collect();
 
+        // Dense and DFA states share the table layout
         let dense_count = state_kinds
             .iter()
-            .filter(|&&k| k == StateKind::Dense)
+            .filter(|&&k| k == StateKind::Dense || k == StateKind::Dfa)
             .count();
         let sparse_edges: usize = self
             .states
@@ -305,11 +447,11 @@ impl ACBuilder {
             let node_offset = node_offsets[i];
             let kind = state_kinds[i];
 
-            // Prepare sorted edges for this state
+            // Prepare sorted edges for this state (keyed by class if compressed)
             let mut edges: Vec<(u8, u32)> = state
                 .transitions
                 .iter()
-                .map(|(&ch, &target)| (ch, node_offsets[target as usize] as u32))
+                .map(|(&ch, &target)| (edge_char(ch), node_offsets[target as usize] as u32))
                 .collect();
             edges.sort_by_key(|(ch, _)| *ch); // Sort for efficient lookup
 
@@ -342,18 +484,40 @@ impl ACBuilder {
                 StateKind::Dense => {
                     // Write dense lookup table
                     let lookup_offset = dense_offset;
-                    let mut lookup = DenseLookup {
-                        targets: [0u32; 256],
-                    };
+                    let mut targets = vec![0u32; table_entries];
 
                     for (ch, target) in &edges {
-                        lookup.targets[*ch as usize] = *target;
+                        targets[*ch as usize] = *target;
                     }
 
-                    unsafe {
-                        let ptr = buffer.as_mut_ptr().add(dense_offset) as *mut DenseLookup;
-                        ptr.write(lookup);
+                    write_table(&mut buffer, dense_offset, &targets);
+                    dense_offset += dense_size;
+
+                    (lookup_offset as u32, 0u8, 0u32)
+                }
+
+                StateKind::Dfa => {
+                    // Full table: every byte (class) resolves to a state, 0 = root
+                    let lookup_offset = dense_offset;
+                    let mut targets = vec![0u32; table_entries];
+
+                    // Resolve each class once, from its first byte. Uppercase
+                    // letters fold into the lowercase class in case-insensitive
+                    // mode but have no edges, so the lowercase byte stands in.
+                    let mut resolved = vec![false; table_entries];
+                    for ch in 0..=255u8 {
+                        let ch = match self.mode {
+                            MatchMode::CaseInsensitive => ch.to_ascii_lowercase(),
+                            MatchMode::CaseSensitive => ch,
+                        };
+                        let class = edge_char(ch) as usize;
+                        if !mem::replace(&mut resolved[class], true) {
+                            let target = self.dfa_target(i as u32, ch);
+                            targets[class] = node_offsets[target as usize] as u32;
+                        }
                     }
+
+                    write_table(&mut buffer, dense_offset, &targets);
                     dense_offset += dense_size;
 
                     (lookup_offset as u32, 0u8, 0u32)
@@ -407,6 +571,14 @@ impl ACBuilder {
     }
 }
 
+/// Write a dense/DFA table of little-endian target offsets at `offset`
+fn write_table(buffer: &mut [u8], offset: usize, targets: &[u32]) {
+    for (i, target) in targets.iter().enumerate() {
+        let at = offset + i * mem::size_of::<u32>();
+        buffer[at..at + 4].copy_from_slice(&target.to_le_bytes());
+    }
+}
+
 /// Offset-based Aho-Corasick automaton
 ///
 /// All data is stored in a single byte buffer using offsets.
@@ -418,6 +590,8 @@ pub struct ACAutomaton {
     mode: MatchMode,
     /// Original patterns (needed for returning matches)
     patterns: Vec<String>,
+    /// Alphabet compression the buffer was built with
+    classes: Option<ByteClasses>,
 }
 
 impl ACAutomaton {
@@ -427,6 +601,7 @@ impl ACAutomaton {
             buffer: Vec::new(),
             mode,
             patterns: Vec::new(),
+            classes: None,
         }
     }
 
@@ -434,13 +609,29 @@ impl ACAutomaton {
     ///
     /// This constructs the offset-based binary format directly.
     pub fn build(patterns: &[&str], mode: MatchMode) -> Result<Self, ParaglobError> {
+        Self::build_with_options(patterns, mode, ACBuildOptions::default())
+    }
+
+    /// Build the automaton with DFA states and/or byte classes
+    ///
+    /// The root and the first few depths are where scans spend most of
+    /// their time, especially with tens of thousands of patterns. DFA
+    /// states make each byte there a single table load; byte classes shrink
+    /// those tables from 1KB to one cache line or two for typical indicator
+    /// alphabets. Buffers built with byte classes must be matched with the
+    /// same class map (see [`byte_classes`](Self::byte_classes)).
+    pub fn build_with_options(
+        patterns: &[&str],
+        mode: MatchMode,
+        options: ACBuildOptions,
+    ) -> Result<Self, ParaglobError> {
         if patterns.is_empty() {
             return Err(ParaglobError::InvalidPattern(
                 "No patterns provided".to_string(),
             ));
         }
 
-        let mut builder = ACBuilder::new(mode);
+        let mut builder = ACBuilder::new(mode, options.dfa_depth);
 
         for pattern in patterns {
             if pattern.is_empty() {
@@ -450,14 +641,19 @@ impl ACAutomaton {
         }
 
         builder.build_failure_links();
+        if options.byte_classes {
+            builder.build_byte_classes();
+        }
 
         let stored_patterns = builder.patterns.clone();
+        let classes = builder.classes.clone();
         let buffer = builder.serialize()?; // Propagate error
 
         Ok(Self {
             buffer,
             mode,
             patterns: stored_patterns,
+            classes,
         })
     }
 
@@ -491,7 +687,12 @@ impl ACAutomaton {
         let mut matches = Vec::new();
         let mut current_offset = 0usize;
 
-        for (pos, &ch) in text_bytes.iter().enumerate() {
+        for (pos, &byte) in text_bytes.iter().enumerate() {
+            let Some(ch) = self.edge_char(byte) else {
+                // No pattern uses this byte: back to the root, which has no outputs
+                current_offset = 0;
+                continue;
+            };
             let mut next_offset = self.find_transition(current_offset, ch);
 
             while next_offset.is_none() && current_offset != 0 {
@@ -578,7 +779,12 @@ impl ACAutomaton {
         let mut pattern_ids = Vec::new();
         let mut current_offset = 0usize; // Root node
 
-        for &ch in text_bytes.iter() {
+        for &byte in text_bytes.iter() {
+            let Some(ch) = self.edge_char(byte) else {
+                current_offset = 0;
+                continue;
+            };
+
             // Try to find transition from current node
             let mut next_offset = self.find_transition(current_offset, ch);
 
@@ -645,6 +851,21 @@ impl ACAutomaton {
         pattern_ids
     }
 
+    /// The edge label for `byte`: its class when the alphabet is compressed
+    ///
+    /// `None` for bytes no pattern uses (class 0), which always lead back
+    /// to the root.
+    #[inline(always)]
+    fn edge_char(&self, byte: u8) -> Option<u8> {
+        match &self.classes {
+            Some(classes) => match classes.class(byte) {
+                0 => None,
+                class => Some(class),
+            },
+            None => Some(byte),
+        }
+    }
+
     /// Find a transition from a node for a character
     ///
     /// Returns the offset to the target node, or None if no transition exists.
@@ -658,6 +879,7 @@ impl ACAutomaton {
     /// - **ONE** (75-80% of states): Single inline comparison, zero indirection!
     /// - **SPARSE**: Linear search through edge array (2-8 edges)
     /// - **DENSE**: O(1) lookup table access (9+ edges)
+    /// - **DFA**: O(1) lookup that always succeeds (failure links pre-resolved)
     ///
     /// The ONE encoding is the key optimization: by storing the single transition inline,
     /// we eliminate a cache miss that would occur when loading the edge array.
@@ -753,6 +975,15 @@ impl ACAutomaton {
                     None
                 }
             }
+
+            StateKind::Dfa => {
+                // Failure links already resolved: 0 is a real transition to root
+                let target_offset_offset = node.edges_offset as usize + (ch as usize * 4);
+                let bytes = self
+                    .buffer
+                    .get(target_offset_offset..target_offset_offset + 4)?;
+                Some(u32::from_le_bytes([bytes[0], bytes[1], bytes[2], bytes[3]]) as usize)
+            }
         }
     }
 
@@ -771,6 +1002,11 @@ impl ACAutomaton {
         self.mode
     }
 
+    /// Byte classes the buffer's transitions are keyed on, if compressed
+    pub fn byte_classes(&self) -> Option<&ByteClasses> {
+        self.classes.as_ref()
+    }
+
     /// Load from a buffer (for deserialization/mmap)
     pub fn from_buffer(
         buffer: Vec<u8>,
@@ -783,8 +1019,15 @@ impl ACAutomaton {
             buffer,
             mode,
             patterns,
+            classes: None,
         })
     }
+
+    /// Set the byte classes a loaded buffer was built with
+    pub fn with_byte_classes(mut self, classes: Option<ByteClasses>) -> Self {
+        self.classes = classes;
+        self
+    }
 }
 
 #[cfg(test)]
@@ -842,4 +1085,131 @@ mod tests {
         let ids = ac.find_pattern_ids("testing");
         assert_eq!(ids.len(), 3); // All three patterns match
     }
+
+    #[test]
+    fn test_dfa_states_match_plain_automaton() {
+        let patterns = vec!["he", "she", "his", "hers", "ushers", "s", "hhh", "abcab"];
+        let plain = ACAutomaton::build(&patterns, MatchMode::CaseSensitive).unwrap();
+        let texts = [
+            "she sells his shells to ushers",
+            "hhhhhhers abcabcab",
+            "",
+            "zzz\u{0}\u{ff}",
+        ];
+
+        for depth in [0u8, 1, 2, 8] {
+            let options = ACBuildOptions {
+                dfa_depth: Some(depth),
+                ..Default::default()
+            };
+            let dfa = ACAutomaton::build_with_options(&patterns, MatchMode::CaseSensitive, options)
+                .unwrap();
+            assert!(dfa.buffer().len() > plain.buffer().len());
+            for text in texts {
+                assert_eq!(
+                    dfa.find_with_positions(text),
+                    plain.find_with_positions(text),
+                    "depth {} text {:?}",
+                    depth,
+                    text
+                );
+                assert_eq!(dfa.find_pattern_ids(text), plain.find_pattern_ids(text));
+            }
+        }
+    }
+
+    #[test]
+    fn test_byte_classes_match_plain_automaton() {
+        let patterns = vec![
+            "evil.com",
+            "bad-host",
+            "x_y:z",
+            "at@",
+            "path/to",
+            "\u{e9}t\u{e9}",
+        ];
+        let texts = [
+            "www.evil.com/path/to bad-host",
+            "x_y:zat@ \u{e9}t\u{e9} evil.co evil.com",
+            "\u{0}\u{ff}~~~",
+        ];
+
+        for mode in [MatchMode::CaseSensitive, MatchMode::CaseInsensitive] {
+            let plain = ACAutomaton::build(&patterns, mode).unwrap();
+            for dfa_depth in [None, Some(0), Some(3)] {
+                let options = ACBuildOptions {
+                    dfa_depth,
+                    byte_classes: true,
+                };
+                let compressed = ACAutomaton::build_with_options(&patterns, mode, options).unwrap();
+                let classes = compressed.byte_classes().unwrap();
+                assert_eq!(classes.class(b'#'), 0);
+                assert!(classes.count() < 40);
+                if dfa_depth.is_some() {
+                    let full = ACAutomaton::build_with_options(
+                        &patterns,
+                        mode,
+                        ACBuildOptions {
+                            dfa_depth,
+                            byte_classes: false,
+                        },
+                    )
+                    .unwrap();
+                    assert!(compressed.buffer().len() < full.buffer().len());
+                }
+
+                for text in texts {
+                    assert_eq!(
+                        compressed.find_with_positions(text),
+                        plain.find_with_positions(text),
+                        "{:?} {:?} {:?}",
+                        mode,
+                        dfa_depth,
+                        text
+                    );
+                }
+            }
+        }
+
+        // Case folding happens in the class map: no lowercased copy needed
+        let options = ACBuildOptions {
+            dfa_depth: Some(1),
+            byte_classes: true,
+        };
+        let ci = ACAutomaton::build_with_options(&patterns, MatchMode::CaseInsensitive, options)
+            .unwrap();
+        assert_eq!(
+            ci.find_pattern_ids("WWW.EVIL.COM Bad-Host"),
+            ci.find_pattern_ids("www.evil.com bad-host")
+        );
+        assert_eq!(ci.find_pattern_ids("WWW.EVIL.COM Bad-Host"), vec![0, 1]);
+    }
+
+    #[test]
+    fn test_byte_classes_are_coarsest() {
+        // No two used bytes have the same goto column, so compaction leaves
+        // nothing for column merging to find
+        let mut builder = ACBuilder::new(MatchMode::CaseSensitive, None);
+        for pattern in ["abc", "abd", "xbc", "ba", "cab"] {
+            builder.add_pattern(pattern).unwrap();
+        }
+        builder.build_byte_classes();
+        let classes = builder.classes.clone().unwrap();
+
+        let column = |byte: u8| -> Vec<Option<u32>> {
+            builder
+                .states
+                .iter()
+                .map(|state| state.transitions.get(&byte).copied())
+                .collect()
+        };
+        let used: Vec<u8> = (0..=255u8).filter(|&b| classes.class(b) != 0).collect();
+        assert_eq!(used, b"abcdx");
+        assert_eq!(classes.count(), used.len() + 1);
+        for (i, &a) in used.iter().enumerate() {
+            for &b in &used[i + 1..] {
+                assert_ne!(column(a), column(b), "{} {}", a as char, b as char);
+            }
+        }
+    }
 }
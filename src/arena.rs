@@ -0,0 +1,394 @@
+//! Bump Arena for Per-Batch Decoding
+//!
+//! Decoding a hit into a [`DataValue`](crate::DataValue) allocates a map and
+//! a string per field, and rendering it as JSON allocates twice more. On
+//! streams where a large share of lookups hit, that keeps the global
+//! allocator hot. An [`Arena`] hands out memory by bumping an offset through
+//! a few large chunks and takes all of it back with one
+//! [`reset`](Arena::reset), so once its chunks have grown to a batch's
+//! working size, decoding and rendering that batch calls the allocator zero
+//! times.
+//!
+//! Only `Copy` types are stored, so nothing needs dropping on reset. Values
+//! decoded into an arena ([`ArenaValue`](crate::data_section::ArenaValue))
+//! borrow strings straight from the database and keep only map and array
+//! slices in the arena.
+//!
+//! # Examples
+//!
+//! ```no_run
+//! use matchy::{arena, Database};
+//!
+//! let db = Database::from("threats.mxy").open()?;
+//! let decoder = db.data_decoder().expect("database has a data section");
+//!
+//! arena::with_thread_arena(|arena| {
+//!     for query in ["1.2.3.4", "10.0.0.1"] {
+//!         if let Some(hit) = db.lookup_ref(query).unwrap() {
+//!             let value = decoder.decode_in(hit.offset, arena).unwrap();
+//!             println!("{}", arena.alloc_json(&value).unwrap());
+//!         }
+//!     }
+//! }); // everything allocated above is released here in one step
+//! # Ok::<(), Box<dyn std::error::Error>>(())
+//! ```
+
+use std::cell::{Cell, RefCell};
+use std::mem::{self, MaybeUninit};
+use std::ptr::{self, NonNull};
+use std::slice;
+
+/// Size of the first chunk when none is given
+const DEFAULT_CHUNK_SIZE: usize = 16 * 1024;
+
+/// Chunk storage unit; chunk bases are aligned for any value we store
+type Block = MaybeUninit<u128>;
+
+/// One chunk of arena memory, owned through a raw base pointer
+///
+/// Values handed out earlier stay live while later ones are carved from
+/// the same chunk, so the chunk is never reborrowed as a `&mut [Block]`
+/// after creation; every allocation derives from `base` instead.
+struct Chunk {
+    /// Start of the leaked `Box<[Block]>`
+    base: NonNull<Block>,
+    /// Length in blocks
+    blocks: usize,
+}
+
+impl Chunk {
+    fn new(blocks: usize) -> Self {
+        let storage: Box<[Block]> = vec![MaybeUninit::uninit(); blocks].into_boxed_slice();
+        Self {
+            base: NonNull::from(Box::leak(storage)).cast(),
+            blocks,
+        }
+    }
+
+    /// Size in bytes
+    fn capacity(&self) -> usize {
+        self.blocks * mem::size_of::<Block>()
+    }
+}
+
+impl Drop for Chunk {
+    fn drop(&mut self) {
+        // SAFETY: base and blocks describe the box leaked in Chunk::new
+        unsafe {
+            drop(Box::from_raw(ptr::slice_from_raw_parts_mut(
+                self.base.as_ptr(),
+                self.blocks,
+            )));
+        }
+    }
+}
+
+/// Bump allocator released in one step
+///
+/// Allocation takes `&self`, so values carved from the arena can refer to
+/// each other; [`reset`](Self::reset) takes `&mut self`, so it can only run
+/// once nothing borrows from the arena any more. Chunks are kept across
+/// resets and grow by doubling when a batch needs more.
+///
+/// An arena is not `Sync`: give each thread its own, or use
+/// [`with_thread_arena`].
+pub struct Arena {
+    /// Chunk storage; heap allocated so chunks never move when the list grows
+    chunks: RefCell<Vec<Chunk>>,
+    /// Index of the chunk being bumped through
+    current: Cell<usize>,
+    /// Bytes used in the current chunk
+    used: Cell<usize>,
+    /// Bytes handed out since the last reset
+    allocated: Cell<usize>,
+    /// Size of the first chunk
+    chunk_size: usize,
+    /// Render buffer for [`alloc_json`](Self::alloc_json), kept across resets
+    text: RefCell<Vec<u8>>,
+}
+
+// SAFETY: the arena exclusively owns its chunks, like the `Box`es they came
+// from; `&self` allocation is still confined to one thread by the cells
+unsafe impl Send for Arena {}
+
+// Handing out `&mut` from `&self` is the point: every allocation is fresh
+#[allow(clippy::mut_from_ref)]
+impl Arena {
+    /// Create an empty arena (nothing is allocated until first use)
+    pub fn new() -> Self {
+        Self::with_chunk_size(DEFAULT_CHUNK_SIZE)
+    }
+
+    /// Create an arena whose first chunk holds `bytes` bytes
+    ///
+    /// Size it to a typical batch to avoid growing during the first one.
+    pub fn with_chunk_size(bytes: usize) -> Self {
+        Self {
+            chunks: RefCell::new(Vec::new()),
+            current: Cell::new(0),
+            used: Cell::new(0),
+            allocated: Cell::new(0),
+            chunk_size: bytes.max(mem::size_of::<Block>()),
+            text: RefCell::new(Vec::new()),
+        }
+    }
+
+    /// Move `value` into the arena
+    pub fn alloc<T: Copy>(&self, value: T) -> &mut T {
+        let slot = self.alloc_raw(mem::size_of::<T>(), mem::align_of::<T>()) as *mut T;
+        // SAFETY: alloc_raw returned fresh, aligned space for one T
+        unsafe {
+            slot.write(value);
+            &mut *slot
+        }
+    }
+
+    /// Copy a slice into the arena
+    pub fn alloc_slice_copy<T: Copy>(&self, src: &[T]) -> &mut [T] {
+        let dst = self.alloc_uninit_slice::<T>(src.len());
+        // SAFETY: dst has room for src.len() elements and cannot overlap src
+        unsafe {
+            std::ptr::copy_nonoverlapping(src.as_ptr(), dst, src.len());
+            slice::from_raw_parts_mut(dst, src.len())
+        }
+    }
+
+    /// Build a `len`-element slice in the arena from `f(0)`, `f(1)`, ...
+    ///
+    /// `f` may allocate from the arena itself. On error the space already
+    /// used stays allocated until the next reset.
+    pub fn try_alloc_slice_with<T: Copy, E>(
+        &self,
+        len: usize,
+        mut f: impl FnMut(usize) -> Result<T, E>,
+    ) -> Result<&mut [T], E> {
+        let dst = self.alloc_uninit_slice::<T>(len);
+        for i in 0..len {
+            let value = f(i)?;
+            // SAFETY: i < len, and dst has room for len elements
+            unsafe { dst.add(i).write(value) };
+        }
+        // SAFETY: all len elements were written above
+        Ok(unsafe { slice::from_raw_parts_mut(dst, len) })
+    }
+
+    /// Copy a string into the arena
+    pub fn alloc_str(&self, s: &str) -> &mut str {
+        let bytes = self.alloc_slice_copy(s.as_bytes());
+        // SAFETY: copied from a valid str
+        unsafe { std::str::from_utf8_unchecked_mut(bytes) }
+    }
+
+    /// Copy `bytes` into the arena followed by a NUL
+    ///
+    /// Returns a pointer usable as a C string, or `None` if `bytes`
+    /// contains a NUL itself.
+    pub fn alloc_c_str(&self, bytes: &[u8]) -> Option<*const std::os::raw::c_char> {
+        if memchr::memchr(0, bytes).is_some() {
+            return None;
+        }
+        let dst = self.alloc_uninit_slice::<u8>(bytes.len() + 1);
+        // SAFETY: dst has room for the bytes and the terminator
+        unsafe {
+            std::ptr::copy_nonoverlapping(bytes.as_ptr(), dst, bytes.len());
+            dst.add(bytes.len()).write(0);
+        }
+        Some(dst as *const std::os::raw::c_char)
+    }
+
+    /// Render `value` as JSON into the arena
+    ///
+    /// The text is followed by a NUL (not part of the returned `str`), so
+    /// its pointer can be handed to C as a string.
+    pub fn alloc_json<T: serde::Serialize + ?Sized>(&self, value: &T) -> serde_json::Result<&str> {
+        let mut text = self.text.borrow_mut();
+        text.clear();
+        serde_json::to_writer(&mut *text, value)?;
+        text.push(0);
+        let stored = self.alloc_slice_copy(&text);
+        // SAFETY: serde_json writes valid UTF-8; the NUL is left outside
+        Ok(unsafe { std::str::from_utf8_unchecked(&stored[..stored.len() - 1]) })
+    }
+
+    /// Release everything allocated so far, keeping the chunks
+    pub fn reset(&mut self) {
+        self.current.set(0);
+        self.used.set(0);
+        self.allocated.set(0);
+    }
+
+    /// Bytes handed out since the last reset
+    pub fn allocated_bytes(&self) -> usize {
+        self.allocated.get()
+    }
+
+    /// Total bytes held in chunks
+    pub fn capacity(&self) -> usize {
+        self.chunks.borrow().iter().map(Chunk::capacity).sum()
+    }
+
+    /// Uninitialized room for `len` values of `T`
+    fn alloc_uninit_slice<T>(&self, len: usize) -> *mut T {
+        let size = mem::size_of::<T>()
+            .checked_mul(len)
+            .expect("arena allocation too large");
+        self.alloc_raw(size, mem::align_of::<T>()) as *mut T
+    }
+
+    /// `size` bytes aligned to `align`, from the current chunk if they fit
+    fn alloc_raw(&self, size: usize, align: usize) -> *mut u8 {
+        let mut chunks = self.chunks.borrow_mut();
+        loop {
+            let index = self.current.get();
+            if let Some(chunk) = chunks.get(index) {
+                let base = chunk.base.as_ptr() as *mut u8;
+                let capacity = chunk.capacity();
+                let addr = base as usize + self.used.get();
+                let start = addr.next_multiple_of(align) - base as usize;
+                if let Some(end) = start.checked_add(size).filter(|&end| end <= capacity) {
+                    self.used.set(end);
+                    self.allocated.set(self.allocated.get() + size);
+                    // SAFETY: start + size <= capacity
+                    return unsafe { base.add(start) };
+                }
+                // Reuse chunks kept from before the last reset
+                if index + 1 < chunks.len() {
+                    self.current.set(index + 1);
+                    self.used.set(0);
+                    continue;
+                }
+            }
+
+            // Grow: double the last chunk, or more for an oversized request
+            let last = chunks.last().map_or(0, Chunk::capacity);
+            let bytes = self
+                .chunk_size
+                .max(last.saturating_mul(2))
+                .max(size.saturating_add(align));
+            let blocks = bytes.div_ceil(mem::size_of::<Block>());
+            chunks.push(Chunk::new(blocks));
+            self.current.set(chunks.len() - 1);
+            self.used.set(0);
+        }
+    }
+}
+
+impl Default for Arena {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl std::fmt::Debug for Arena {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("Arena")
+            .field("allocated", &self.allocated_bytes())
+            .field("capacity", &self.capacity())
+            .finish()
+    }
+}
+
+thread_local! {
+    static THREAD_ARENA: RefCell<Arena> = RefCell::new(Arena::new());
+}
+
+/// Run `f` with the calling thread's arena
+///
+/// The arena is reset when the scope starts, so everything `f` allocates is
+/// released by the next scope on this thread, and its chunks are reused.
+/// Nothing allocated in the arena can escape `f`. A nested call on the same
+/// thread gets a temporary arena of its own.
+pub fn with_thread_arena<R>(f: impl FnOnce(&Arena) -> R) -> R {
+    THREAD_ARENA.with(|cell| match cell.try_borrow_mut() {
+        Ok(mut arena) => {
+            arena.reset();
+            f(&arena)
+        }
+        Err(_) => f(&Arena::new()),
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_alloc_and_reset_reuses_chunks() {
+        let mut arena = Arena::with_chunk_size(64);
+        let a = arena.alloc(7u64);
+        let b = arena.alloc_slice_copy(&[1u32, 2, 3]);
+        let s = arena.alloc_str("hello");
+        *a += 1;
+        assert_eq!((*a, &*b, &*s), (8, &[1, 2, 3][..], "hello"));
+        assert_eq!(a as *mut u64 as usize % mem::align_of::<u64>(), 0);
+
+        // Grows past the first chunk, then reuses both after a reset
+        let big = arena.alloc_slice_copy(&[0xABu8; 1000]);
+        assert!(big.iter().all(|&b| b == 0xAB));
+        let capacity = arena.capacity();
+        assert!(capacity >= 1064);
+
+        arena.reset();
+        assert_eq!(arena.allocated_bytes(), 0);
+        for i in 0..10u128 {
+            assert_eq!(*arena.alloc(i), i);
+        }
+        arena.alloc_slice_copy(&[0u8; 900]);
+        assert_eq!(arena.capacity(), capacity);
+    }
+
+    #[test]
+    fn test_alignment() {
+        let arena = Arena::with_chunk_size(256);
+        arena.alloc(1u8);
+        let wide = arena.alloc(u128::MAX);
+        assert_eq!(wide as *mut u128 as usize % mem::align_of::<u128>(), 0);
+        arena.alloc(1u8);
+        let words = arena.alloc_slice_copy(&[1u64, 2]);
+        assert_eq!(words.as_ptr() as usize % mem::align_of::<u64>(), 0);
+    }
+
+    #[test]
+    fn test_c_str_and_json() {
+        let arena = Arena::new();
+        let ptr = arena.alloc_c_str(b"evil.com").unwrap();
+        let c = unsafe { std::ffi::CStr::from_ptr(ptr) };
+        assert_eq!(c.to_bytes(), b"evil.com");
+        assert!(arena.alloc_c_str(b"a\0b").is_none());
+
+        let json = arena.alloc_json(&vec!["a", "b"]).unwrap();
+        assert_eq!(json, r#"["a","b"]"#);
+        let terminator = unsafe { *json.as_ptr().add(json.len()) };
+        assert_eq!(terminator, 0);
+    }
+
+    #[test]
+    fn test_try_alloc_slice_with_nested() {
+        let arena = Arena::new();
+        let rows = arena
+            .try_alloc_slice_with(3, |i| {
+                let row = arena.alloc_slice_copy(&[i as u32; 4]);
+                Ok::<_, ()>(&*row)
+            })
+            .unwrap();
+        assert_eq!(rows[2], &[2, 2, 2, 2]);
+
+        let failed = arena.try_alloc_slice_with(3, |i| if i < 2 { Ok(i) } else { Err("bad") });
+        assert_eq!(failed, Err("bad"));
+    }
+
+    #[test]
+    fn test_thread_arena_scopes() {
+        let first = with_thread_arena(|arena| {
+            arena.alloc_slice_copy(&[0u8; 100]);
+            // Nested scopes get their own arena
+            with_thread_arena(|inner| {
+                inner.alloc(1u8);
+                assert_eq!(inner.allocated_bytes(), 1);
+            });
+            arena.allocated_bytes()
+        });
+        assert_eq!(first, 100);
+        with_thread_arena(|arena| assert_eq!(arena.allocated_bytes(), 0));
+    }
+}
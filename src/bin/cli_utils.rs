@@ -164,6 +164,16 @@ pub fn format_bytes(bytes: usize) -> String {
     }
 }
 
+pub fn format_nanos(ns: f64) -> String {
+    if ns >= 1_000_000.0 {
+        format!("{:.2}ms", ns / 1_000_000.0)
+    } else if ns >= 1_000.0 {
+        format!("{:.2}µs", ns / 1_000.0)
+    } else {
+        format!("{:.0}ns", ns)
+    }
+}
+
 pub fn format_qps(qps: f64) -> String {
     if qps >= 1_000_000.0 {
         format!("{:.2}M", qps / 1_000_000.0)
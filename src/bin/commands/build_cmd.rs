@@ -4,14 +4,18 @@ use std::collections::HashMap;
 use std::fs;
 use std::io::{self, BufRead};
 use std::path::PathBuf;
+use std::time::{Duration, Instant};
 
 #[cfg(unix)]
 use std::os::unix::fs::PermissionsExt;
 
 use crate::cli_utils::json_to_data_map;
 
+/// Rows classified and hashed together by `MmdbBuilder::add_entries`
+const ENTRY_BATCH_SIZE: usize = 65_536;
+
 /// Set file permissions to read-only (0444 on Unix, read-only attribute on Windows)
-fn set_readonly(path: &PathBuf) -> Result<()> {
+pub fn set_readonly(path: &PathBuf) -> Result<()> {
     let mut perms = fs::metadata(path)
         .with_context(|| format!("Failed to get metadata for: {}", path.display()))?
         .permissions();
@@ -33,6 +37,34 @@ fn set_readonly(path: &PathBuf) -> Result<()> {
     Ok(())
 }
 
+/// Write a database and rename it over `output`
+///
+/// The bytes go to `<output>.tmp` in the same directory first, so processes
+/// that still map the old file keep its inode intact instead of seeing it
+/// truncated under them. The new file is made read-only before the rename.
+pub fn write_database(output: &PathBuf, bytes: &[u8]) -> Result<()> {
+    let mut tmp_name = output.file_name().unwrap_or_default().to_os_string();
+    tmp_name.push(".tmp");
+    let tmp = output.with_file_name(tmp_name);
+
+    // A read-only leftover from an interrupted run would refuse the write
+    match fs::remove_file(&tmp) {
+        Err(e) if e.kind() != io::ErrorKind::NotFound => {
+            return Err(e).with_context(|| format!("Failed to remove: {}", tmp.display()));
+        }
+        _ => {}
+    }
+    fs::write(&tmp, bytes)
+        .with_context(|| format!("Failed to save database: {}", tmp.display()))?;
+
+    // Set file to read-only to protect mmap integrity
+    set_readonly(&tmp)
+        .with_context(|| format!("Failed to set read-only permissions on: {}", tmp.display()))?;
+
+    fs::rename(&tmp, output)
+        .with_context(|| format!("Failed to rename {} to {}", tmp.display(), output.display()))
+}
+
 #[allow(clippy::too_many_arguments)]
 pub fn cmd_build(
     inputs: Vec<PathBuf>,
@@ -44,6 +76,12 @@ pub fn cmd_build(
     verbose: bool,
     debug: bool,
     case_insensitive: bool,
+    ip_stride_index: bool,
+    glob_dfa_depth: Option<u8>,
+    glob_byte_classes: bool,
+    prefilter: bool,
+    perfect_hash: bool,
+    tombstones: Option<PathBuf>,
 ) -> Result<()> {
     let match_mode = if case_insensitive {
         MatchMode::CaseInsensitive
@@ -70,7 +108,21 @@ pub fn cmd_build(
         println!();
     }
 
-    let mut builder = MmdbBuilder::new(match_mode);
+    let mut builder = MmdbBuilder::new(match_mode)
+        .with_ip_stride_index(ip_stride_index)
+        .with_glob_byte_classes(glob_byte_classes)
+        .with_prefilter(prefilter)
+        .with_perfect_hash_literals(perfect_hash);
+    if let Some(depth) = glob_dfa_depth {
+        builder = builder.with_glob_dfa_depth(depth);
+    }
+
+    if format == "misp" {
+        // Defaults for MISP feeds; --database-type/--description override them
+        builder = builder
+            .with_database_type(matchy::misp_importer::DATABASE_TYPE)
+            .with_description("en", matchy::misp_importer::DATABASE_DESCRIPTION);
+    }
 
     // Apply metadata if provided
     if let Some(db_type) = database_type {
@@ -81,6 +133,7 @@ pub fn cmd_build(
         builder = builder.with_description(desc_lang, desc);
     }
 
+    let read_start = Instant::now();
     match format.as_str() {
         "text" => {
             // Read entries from text file(s) (one per line)
@@ -156,6 +209,7 @@ pub fn cmd_build(
             // First column must be named "entry" (or "key") containing IP/CIDR/pattern
             // Remaining columns become metadata fields
             let mut total_entries = 0;
+            let mut batch = Vec::with_capacity(ENTRY_BATCH_SIZE);
 
             for input in &inputs {
                 if debug && inputs.len() > 1 {
@@ -219,13 +273,17 @@ pub fn cmd_build(
                         }
                     }
 
-                    builder.add_entry(entry, data)?;
+                    batch.push((entry.to_string(), data));
                     total_entries += 1;
 
-                    if debug && total_entries % 1000 == 0 {
-                        println!("    Added {} entries...", total_entries);
+                    if batch.len() == ENTRY_BATCH_SIZE {
+                        builder.add_entries(std::mem::take(&mut batch))?;
+                        if debug {
+                            println!("    Added {} entries...", total_entries);
+                        }
                     }
                 }
+                builder.add_entries(std::mem::take(&mut batch))?;
 
                 if debug && inputs.len() > 1 {
                     println!("    {} entries from this file", reader.position().line());
@@ -240,6 +298,7 @@ pub fn cmd_build(
             // Read entries with data from JSON file(s)
             // Format: [{"key": "192.168.0.0/16" or "*.example.com", "data": {...}}]
             let mut total_entries = 0;
+            let mut batch = Vec::with_capacity(ENTRY_BATCH_SIZE);
 
             for input in &inputs {
                 if debug && inputs.len() > 1 {
@@ -263,13 +322,17 @@ pub fn cmd_build(
                         HashMap::new()
                     };
 
-                    builder.add_entry(key, data)?;
+                    batch.push((key.to_string(), data));
                     total_entries += 1;
 
-                    if debug && total_entries % 1000 == 0 {
-                        println!("    Added {} entries...", total_entries);
+                    if batch.len() == ENTRY_BATCH_SIZE {
+                        builder.add_entries(std::mem::take(&mut batch))?;
+                        if debug {
+                            println!("    Added {} entries...", total_entries);
+                        }
                     }
                 }
+                builder.add_entries(std::mem::take(&mut batch))?;
 
                 if debug && inputs.len() > 1 {
                     println!("    {} entries from this file", entries.len());
@@ -288,20 +351,21 @@ pub fn cmd_build(
                 println!("  Processing MISP JSON files (streaming mode)...");
             }
 
-            // Convert Vec<PathBuf> to Vec<&Path> for build_from_files
-            let input_refs: Vec<&PathBuf> = inputs.iter().collect();
-
-            // Use streaming import to process one file at a time
-            // This keeps memory usage low even for very large datasets
-            builder = MispImporter::build_from_files(
-                &input_refs,
-                MatchMode::CaseSensitive,
+            // Streams events into the configured builder, parsing files in
+            // parallel; memory stays low even for very large datasets
+            let imported = MispImporter::import_files(
+                &inputs,
+                &mut builder,
                 false, // Use full metadata
             )
             .context("Failed to process MISP JSON files")?;
 
             if debug {
                 let stats = builder.stats();
+                println!(
+                    "  Events: {}, attributes: {}, objects: {}",
+                    imported.total_events, imported.total_attributes, imported.total_objects
+                );
                 println!("  Total indicators: {}", stats.total_entries);
             }
         }
@@ -313,6 +377,26 @@ pub fn cmd_build(
         }
     }
 
+    // Keys deleted since the base was built (delta databases)
+    if let Some(path) = &tombstones {
+        let file = fs::File::open(path)
+            .with_context(|| format!("Failed to open tombstone file: {}", path.display()))?;
+        let mut count = 0;
+        for line in io::BufReader::new(file).lines() {
+            let line = line?;
+            let key = line.trim();
+            if !key.is_empty() && !key.starts_with('#') {
+                builder.add_tombstone(key)?;
+                count += 1;
+            }
+        }
+        if debug {
+            println!("  Tombstones: {}", count);
+        }
+    }
+
+    let read_time = read_start.elapsed();
+
     // Always show statistics
     let stats = builder.stats();
     if verbose || debug {
@@ -327,22 +411,15 @@ pub fn cmd_build(
         println!("\nSerializing...");
     }
 
-    let database_bytes = builder.build().context("Failed to build database")?;
+    let (database_bytes, timings) = builder.build_timed().context("Failed to build database")?;
 
     if debug {
         println!("Writing to disk...");
     }
 
-    fs::write(&output, &database_bytes)
-        .with_context(|| format!("Failed to save database: {}", output.display()))?;
-
-    // Set file to read-only to protect mmap integrity
-    set_readonly(&output).with_context(|| {
-        format!(
-            "Failed to set read-only permissions on: {}",
-            output.display()
-        )
-    })?;
+    let write_start = Instant::now();
+    write_database(&output, &database_bytes)?;
+    let write_time = write_start.elapsed();
 
     // Always show success message (always displayed)
     if verbose || debug {
@@ -361,5 +438,23 @@ pub fn cmd_build(
         println!("  Format:        MMDB (extended with patterns)");
     }
 
+    if verbose || debug {
+        // IP tree, globs and literals are built concurrently, so those
+        // three can add up to more than the build total
+        println!("\nPhase timings:");
+        print_phase("Read + encode", read_time);
+        print_phase("IP tree", timings.ip_tree);
+        print_phase("Globs", timings.globs);
+        print_phase("Literals", timings.literals);
+        print_phase("Assemble", timings.assemble);
+        print_phase("Build total", timings.total);
+        print_phase("Write", write_time);
+    }
+
     Ok(())
 }
+
+/// Print one line of the phase timing table
+fn print_phase(name: &str, elapsed: Duration) {
+    println!("  {:<14} {:>10.3} ms", name, elapsed.as_secs_f64() * 1000.0);
+}
@@ -0,0 +1,81 @@
+use anyhow::{Context, Result};
+use matchy::Database;
+use std::path::PathBuf;
+use std::time::Instant;
+
+use super::build_cmd::write_database;
+
+pub fn cmd_compact(
+    base: PathBuf,
+    deltas: Vec<PathBuf>,
+    output: PathBuf,
+    ip_stride_index: bool,
+    glob_dfa_depth: Option<u8>,
+    glob_byte_classes: bool,
+    prefilter: bool,
+    perfect_hash: bool,
+    verbose: bool,
+) -> Result<()> {
+    let start = Instant::now();
+
+    let open = |path: &PathBuf| {
+        Database::from(path)
+            .no_cache()
+            .open()
+            .with_context(|| format!("Failed to open database: {}", path.display()))
+    };
+    let base_db = open(&base)?;
+    let delta_dbs = deltas.iter().map(open).collect::<Result<Vec<_>>>()?;
+
+    if verbose {
+        println!(
+            "Compacting {} delta(s) into {}",
+            deltas.len(),
+            base.display()
+        );
+        for delta in &deltas {
+            println!("    - {}", delta.display());
+        }
+    }
+
+    let mut builder = matchy::delta::compact(&base_db, &delta_dbs)
+        .context("Failed to merge deltas")?
+        .with_ip_stride_index(ip_stride_index)
+        .with_glob_byte_classes(glob_byte_classes)
+        .with_prefilter(prefilter)
+        .with_perfect_hash_literals(perfect_hash);
+    if let Some(depth) = glob_dfa_depth {
+        builder = builder.with_glob_dfa_depth(depth);
+    }
+
+    if verbose {
+        let stats = builder.stats();
+        println!("\nBuilding database:");
+        println!("  Total entries:   {}", stats.total_entries);
+        println!("  IP entries:      {}", stats.ip_entries);
+        println!("  Literal entries: {}", stats.literal_entries);
+        println!("  Glob entries:    {}", stats.glob_entries);
+    }
+
+    let database_bytes = builder.build().context("Failed to build database")?;
+
+    // The output may be renamed over the base, which is still mapped above
+    drop(base_db);
+    drop(delta_dbs);
+    write_database(&output, &database_bytes)?;
+
+    if verbose {
+        println!("\n✓ Database compacted successfully!");
+        println!("  Output:        {}", output.display());
+        println!(
+            "  Database size: {:.2} MB ({} bytes)",
+            database_bytes.len() as f64 / (1024.0 * 1024.0),
+            database_bytes.len()
+        );
+        println!("  Time:          {:.2?}", start.elapsed());
+    } else {
+        println!("✓ Database compacted: {}", output.display());
+    }
+
+    Ok(())
+}
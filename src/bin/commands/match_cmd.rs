@@ -6,12 +6,15 @@ use std::sync::{
 };
 use std::time::Instant;
 
-use crate::cli_utils::{format_number, format_qps};
+use crate::cli_utils::{format_nanos, format_number, format_qps};
 use crate::match_processor::{
-    analyze_performance, follow_files, follow_files_parallel, process_file_with_aggregate,
-    process_parallel, ProcessingStats,
+    analyze_performance, enable_query_profiler, follow_files, follow_files_parallel,
+    process_file_with_aggregate, process_parallel, query_profiler, ProcessingStats,
 };
 
+/// With `--stats`, time one query in this many stage by stage
+const PROFILE_SAMPLE_EVERY: u32 = 64;
+
 #[allow(clippy::too_many_arguments)]
 pub fn cmd_match(
     database: PathBuf,
@@ -64,6 +67,10 @@ pub fn cmd_match(
     } else {
         opener = opener.cache_capacity(cache_size);
     }
+    if show_stats {
+        // Worker databases pick the same profiler up when they open
+        opener = opener.profiler(enable_query_profiler(PROFILE_SAMPLE_EVERY));
+    }
     let db = opener
         .open()
         .with_context(|| format!("Failed to load database: {}", database.display()))?;
@@ -226,6 +233,8 @@ pub fn cmd_match(
             aggregate_stats = follow_files(
                 inputs.clone(),
                 &db,
+                &database,
+                cache_size,
                 &extractor,
                 &format,
                 show_stats,
@@ -433,6 +442,10 @@ pub fn cmd_match(
             );
         }
 
+        if let Some(profiler) = query_profiler() {
+            print_query_stages(&profiler.snapshot());
+        }
+
         // Show routing statistics if available (parallel mode only)
         if let Some(ref rstats) = routing_stats {
             eprintln!();
@@ -445,12 +458,19 @@ pub fn cmd_match(
                 "[INFO] Files to readers (chunked): {}",
                 rstats.files_to_readers
             );
+            if rstats.files_split > 0 {
+                eprintln!(
+                    "[INFO] Files split into ranges: {} ({} ranges)",
+                    rstats.files_split, rstats.ranges
+                );
+            }
             if rstats.total_bytes() > 0 {
                 let mb = |b: u64| b as f64 / (1024.0 * 1024.0);
                 eprintln!(
-                    "[INFO] Data: {:.2} MB to workers, {:.2} MB to readers",
+                    "[INFO] Data: {:.2} MB to workers, {:.2} MB to readers, {:.2} MB split",
                     mb(rstats.bytes_to_workers),
-                    mb(rstats.bytes_to_readers)
+                    mb(rstats.bytes_to_readers),
+                    mb(rstats.bytes_split)
                 );
             }
         }
@@ -488,3 +508,55 @@ pub fn cmd_match(
 
     Ok(())
 }
+
+/// Report sampled per-stage query latency and hot-path counters
+fn print_query_stages(profile: &matchy::ProfileStats) {
+    use matchy::QueryStage;
+
+    if profile.sampled_queries == 0 {
+        return;
+    }
+    eprintln!();
+    eprintln!(
+        "[INFO] === Query Stages (1 in {} queries, {} sampled) ===",
+        PROFILE_SAMPLE_EVERY,
+        format_number(profile.sampled_queries as usize)
+    );
+    for stage in QueryStage::ALL {
+        let histogram = profile.stage(stage);
+        if histogram.count() == 0 {
+            continue;
+        }
+        eprintln!(
+            "[INFO] {:<13} {:>9} samples  mean {:>9}  p50 {:>9}  p99 {:>9}  max {:>9}",
+            stage.name(),
+            format_number(histogram.count() as usize),
+            format_nanos(histogram.mean_ns()),
+            format_nanos(histogram.percentile_ns(0.50) as f64),
+            format_nanos(histogram.percentile_ns(0.99) as f64),
+            format_nanos(histogram.max_ns() as f64)
+        );
+    }
+
+    let scans = profile.stage(QueryStage::PatternScan).count();
+    if scans > 0 {
+        eprintln!(
+            "[INFO] AC states per scan: {:.1}, glob candidates per scan: {:.1}",
+            profile.ac_states_visited as f64 / scans as f64,
+            profile.glob_candidates as f64 / scans as f64
+        );
+    }
+    if profile.globs_checked > 0 {
+        eprintln!(
+            "[INFO] Glob verify reject rate: {:.1}% of {} checked",
+            profile.glob_reject_rate() * 100.0,
+            format_number(profile.globs_checked as usize)
+        );
+    }
+    if profile.literal_lookups > 0 {
+        eprintln!(
+            "[INFO] Literal hash probe length: {:.2} slots",
+            profile.mean_probe_length()
+        );
+    }
+}
@@ -1,5 +1,6 @@
 pub mod bench;
 pub mod build_cmd;
+pub mod compact_cmd;
 pub mod extract_cmd;
 pub mod inspect_cmd;
 pub mod match_cmd;
@@ -8,6 +9,7 @@ pub mod validate_cmd;
 
 pub use bench::cmd_bench;
 pub use build_cmd::cmd_build;
+pub use compact_cmd::cmd_compact;
 pub use extract_cmd::cmd_extract;
 pub use inspect_cmd::cmd_inspect;
 pub use match_cmd::cmd_match;
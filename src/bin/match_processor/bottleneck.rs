@@ -164,7 +164,8 @@ pub fn analyze_performance(
             if is_decompress_bottleneck {
                 recs.push("Decompression is the bottleneck".to_string());
                 recs.push(
-                    "Consider: pre-decompress files, or use parallel decompression (pigz)"
+                    "Consider: recompress with bgzip (BGZF blocks decompress in parallel), \
+                     build with --features zlib-ng, or pre-decompress files"
                         .to_string(),
                 );
             } else {
@@ -1,12 +1,10 @@
 use anyhow::{Context, Result};
 use notify::{Config, Event, EventKind, RecommendedWatcher, RecursiveMode, Watcher};
-use std::collections::HashMap;
-use std::fs::File;
-use std::io::{BufRead, BufReader, Read, Seek, SeekFrom};
+use std::collections::{HashMap, HashSet};
 use std::path::{Path, PathBuf};
 use std::sync::mpsc::{self, Receiver, SyncSender};
 use std::sync::{
-    atomic::{AtomicBool, Ordering},
+    atomic::{AtomicBool, AtomicU64, Ordering},
     Arc, Mutex,
 };
 use std::thread;
@@ -14,13 +12,201 @@ use std::time::{Duration, Instant};
 
 use super::sequential::process_line_matches;
 use super::stats::ProcessingStats;
+use super::tail::TailFile;
 use super::thread_utils::set_thread_name;
 
+/// Quiet period after the last change to the database file before reloading
+const RELOAD_DEBOUNCE: Duration = Duration::from_millis(500);
+
+/// How often every input is checked even without a watcher event
+const RESCAN_INTERVAL: Duration = Duration::from_secs(1);
+
+/// Watches the database file and decides when to reload it
+///
+/// The parent directory is watched, because replacing the file by rename
+/// (as `matchy build` does) ends any watch on the file itself. A reload
+/// waits until the file has stopped changing for `RELOAD_DEBOUNCE`.
+struct DatabaseWatch {
+    path: PathBuf,
+    changed_at: Option<Instant>,
+}
+
+impl DatabaseWatch {
+    fn new(database_path: &Path, watcher: &mut RecommendedWatcher) -> Result<Self> {
+        let path = database_path
+            .canonicalize()
+            .with_context(|| format!("Failed to resolve {}", database_path.display()))?;
+        if let Some(dir) = path.parent() {
+            watcher
+                .watch(dir, RecursiveMode::NonRecursive)
+                .with_context(|| format!("Failed to watch {}", dir.display()))?;
+        }
+        Ok(Self {
+            path,
+            changed_at: None,
+        })
+    }
+
+    /// Record `event` if it touches the database file; returns whether it did
+    fn note(&mut self, event: &Event) -> bool {
+        let changed = matches!(
+            event.kind,
+            EventKind::Create(_) | EventKind::Modify(_) | EventKind::Remove(_)
+        ) && event.paths.iter().any(|p| p == &self.path);
+        if changed {
+            self.changed_at = Some(Instant::now());
+        }
+        changed
+    }
+
+    /// Whether a change has settled and the database should be reloaded
+    fn take_due(&mut self) -> bool {
+        match self.changed_at {
+            Some(at) if at.elapsed() >= RELOAD_DEBOUNCE => {
+                self.changed_at = None;
+                true
+            }
+            _ => false,
+        }
+    }
+}
+
+/// The inputs being followed, each held open as a [`TailFile`]
+///
+/// Parent directories are watched rather than the files, so a file
+/// recreated under the same name after rotation still produces events.
+/// Events only mark files as changed; all queued events are taken before
+/// reading, so a burst of writes to one file costs one read. Every input
+/// is also rechecked each `RESCAN_INTERVAL` in case an event was missed.
+struct FollowSet {
+    tails: Vec<TailFile>,
+    by_path: HashMap<PathBuf, usize>,
+    changed: Vec<bool>,
+    last_rescan: Instant,
+}
+
+impl FollowSet {
+    /// Open every input from its start and watch the directories holding them
+    fn new(inputs: &[PathBuf], watcher: &mut RecommendedWatcher) -> Result<Self> {
+        let mut tails = Vec::with_capacity(inputs.len());
+        let mut by_path = HashMap::with_capacity(inputs.len());
+        let mut dirs = HashSet::new();
+        for input_path in inputs {
+            let tail = TailFile::open(input_path, 0, 1)
+                .with_context(|| format!("Failed to open {}", input_path.display()))?;
+            let path = input_path
+                .canonicalize()
+                .with_context(|| format!("Failed to resolve {}", input_path.display()))?;
+            if let Some(dir) = path.parent() {
+                if dirs.insert(dir.to_path_buf()) {
+                    watcher
+                        .watch(dir, RecursiveMode::NonRecursive)
+                        .with_context(|| format!("Failed to watch {}", dir.display()))?;
+                }
+            }
+            by_path.insert(path, tails.len());
+            tails.push(tail);
+        }
+        Ok(Self {
+            changed: vec![true; tails.len()],
+            tails,
+            by_path,
+            last_rescan: Instant::now(),
+        })
+    }
+
+    /// Mark the inputs `event` touches as changed
+    fn note(&mut self, event: &Event) {
+        if matches!(
+            event.kind,
+            EventKind::Create(_) | EventKind::Modify(_) | EventKind::Remove(_)
+        ) {
+            for path in &event.paths {
+                if let Some(&index) = self.by_path.get(path) {
+                    self.changed[index] = true;
+                }
+            }
+        }
+    }
+
+    /// Hand each run of new complete lines to `f` as `(path, first_line, data)`
+    ///
+    /// A file that cannot be read is reported and skipped until its next change.
+    fn read_changed<F>(&mut self, data: &mut Vec<u8>, mut f: F) -> Result<()>
+    where
+        F: FnMut(&Path, usize, &mut Vec<u8>) -> Result<()>,
+    {
+        if self.last_rescan.elapsed() >= RESCAN_INTERVAL {
+            self.changed.fill(true);
+            self.last_rescan = Instant::now();
+        }
+        for (tail, changed) in self.tails.iter_mut().zip(self.changed.iter_mut()) {
+            if !std::mem::take(changed) {
+                continue;
+            }
+            loop {
+                match tail.read_lines(data) {
+                    Ok(Some(first_line)) => f(tail.path(), first_line, data)?,
+                    Ok(None) => break,
+                    Err(e) => {
+                        eprintln!("[WARN] Failed to read {}: {}", tail.path().display(), e);
+                        break;
+                    }
+                }
+            }
+        }
+        Ok(())
+    }
+}
+
+/// Receive the next watcher event, then everything else already queued
+///
+/// Returns false once the watcher has shut down.
+fn drain_events(
+    rx: &Receiver<notify::Result<Event>>,
+    database_watch: &mut DatabaseWatch,
+    follow: &mut FollowSet,
+) -> bool {
+    let first = match rx.recv_timeout(Duration::from_millis(100)) {
+        Ok(result) => result,
+        // Normal timeout, check shutdown flag
+        Err(mpsc::RecvTimeoutError::Timeout) => return true,
+        Err(mpsc::RecvTimeoutError::Disconnected) => return false,
+    };
+    for result in std::iter::once(first).chain(rx.try_iter()) {
+        match result {
+            Ok(event) => {
+                if !database_watch.note(&event) {
+                    follow.note(&event);
+                }
+            }
+            Err(e) => eprintln!("[WARN] File watcher error: {}", e),
+        }
+    }
+    true
+}
+
+/// Open the new version of the database, with its cache warmed from `current`
+fn reopen_database(
+    database_path: &Path,
+    cache_size: usize,
+    current: &matchy::Database,
+) -> Result<matchy::Database> {
+    let db = super::parallel::init_worker_database(database_path, cache_size)?;
+    db.warm_cache_from(current, usize::MAX);
+    Ok(db)
+}
+
 /// Watch files and process new lines as they appear
+///
+/// The database is reloaded whenever its file is replaced; lines read
+/// after the reload are matched against the new version.
 #[allow(clippy::too_many_arguments)]
 pub fn follow_files(
     inputs: Vec<PathBuf>,
     db: &matchy::Database,
+    database_path: &Path,
+    cache_size: usize,
     extractor: &matchy::extractor::Extractor,
     output_format: &str,
     show_stats: bool,
@@ -41,88 +227,70 @@ pub fn follow_files(
         None
     };
 
-    // Process existing content first
     if show_stats {
         eprintln!("[INFO] Processing existing file content...");
     }
 
-    for input_path in &inputs {
-        let stats = process_existing_content(
-            input_path,
-            db,
-            extractor,
-            output_format,
-            show_stats,
-            false, // Disable per-file progress, we'll show aggregate progress
-            overall_start,
-        )?;
-        aggregate_stats.add(&stats);
-
-        // Show aggregate progress after each file
-        if let Some(ref mut prog) = progress {
-            if prog.should_update() {
-                prog.show(&aggregate_stats, overall_start.elapsed());
-            }
-        }
-    }
-
-    if show_stats {
-        eprintln!("[INFO] Watching for new content (Ctrl+C to stop)...");
-    }
-
-    // Setup file watcher
+    // Setup file watcher; existing content is the first read of each input
     let (tx, rx) = mpsc::channel();
     let mut watcher: RecommendedWatcher =
         Watcher::new(tx, Config::default()).context("Failed to create file watcher")?;
-
-    // Track file positions and watch each file
-    let mut file_positions = Vec::new();
-    for input_path in &inputs {
-        let file = File::open(input_path)
-            .with_context(|| format!("Failed to open {}", input_path.display()))?;
-        let pos = file.metadata()?.len();
-
-        watcher
-            .watch(input_path, RecursiveMode::NonRecursive)
-            .with_context(|| format!("Failed to watch {}", input_path.display()))?;
-
-        file_positions.push((input_path.clone(), pos));
-    }
+    let mut follow = FollowSet::new(&inputs, &mut watcher)?;
+    let mut database_watch = DatabaseWatch::new(database_path, &mut watcher)?;
+    let mut reloaded: Option<matchy::Database> = None;
+    let output_json = output_format == "json";
+    let mut data = Vec::new();
+    let mut watching = false;
 
     // Process events until shutdown signal
     while !shutdown.load(Ordering::Relaxed) {
-        match rx.recv_timeout(Duration::from_millis(100)) {
-            Ok(Ok(event)) => {
-                if let Some(stats) = handle_file_event(
-                    event,
-                    &mut file_positions,
-                    db,
-                    extractor,
-                    output_format,
-                    show_stats,
-                    overall_start,
-                )? {
-                    aggregate_stats.add(&stats);
-
-                    // Show progress after processing new content
-                    if let Some(ref mut prog) = progress {
-                        if prog.should_update() {
-                            prog.show(&aggregate_stats, overall_start.elapsed());
-                        }
+        if database_watch.take_due() {
+            let current = reloaded.as_ref().unwrap_or(db);
+            match reopen_database(database_path, cache_size, current) {
+                Ok(new_db) => {
+                    if show_stats {
+                        eprintln!("[INFO] Reloaded database: {}", database_path.display());
                     }
+                    reloaded = Some(new_db);
                 }
+                Err(e) => eprintln!(
+                    "[WARN] Database reload failed, keeping the current version: {:#}",
+                    e
+                ),
             }
-            Ok(Err(e)) => {
-                eprintln!("[WARN] File watcher error: {}", e);
-            }
-            Err(mpsc::RecvTimeoutError::Timeout) => {
-                // Normal timeout, check shutdown flag
-                continue;
+        }
+
+        let current_db = reloaded.as_ref().unwrap_or(db);
+        follow.read_changed(&mut data, |path, first_line, lines| {
+            let stats = process_appended_lines(
+                path,
+                first_line,
+                lines,
+                current_db,
+                extractor,
+                output_json,
+            )?;
+            aggregate_stats.add(&stats);
+
+            // Show progress after processing new content
+            if let Some(ref mut prog) = progress {
+                if prog.should_update() {
+                    prog.show(&aggregate_stats, overall_start.elapsed());
+                }
             }
-            Err(mpsc::RecvTimeoutError::Disconnected) => {
-                break;
+            Ok(())
+        })?;
+
+        if !watching {
+            watching = true;
+            if show_stats {
+                eprintln!("[INFO] Watching for new content (Ctrl+C to stop)...");
             }
         }
+
+        if !drain_events(&rx, &mut database_watch, &mut follow) {
+            break;
+        }
     }
 
     if show_stats {
@@ -137,125 +305,42 @@ pub fn follow_files(
     Ok(aggregate_stats)
 }
 
-/// Process existing file content up to current position
-fn process_existing_content(
+/// Match a run of complete lines read from a followed file
+fn process_appended_lines(
     input_path: &Path,
+    first_line: usize,
+    data: &[u8],
     db: &matchy::Database,
     extractor: &matchy::extractor::Extractor,
-    output_format: &str,
-    show_stats: bool,
-    show_progress: bool,
-    overall_start: Instant,
-) -> Result<ProcessingStats> {
-    // Reuse the sequential processing logic
-    super::sequential::process_file(
-        input_path,
-        db,
-        extractor,
-        output_format,
-        show_stats,
-        show_progress,
-        overall_start,
-    )
-}
-
-/// Handle a file system event
-fn handle_file_event(
-    event: Event,
-    file_positions: &mut [(PathBuf, u64)],
-    db: &matchy::Database,
-    extractor: &matchy::extractor::Extractor,
-    output_format: &str,
-    show_stats: bool,
-    overall_start: Instant,
-) -> Result<Option<ProcessingStats>> {
-    match event.kind {
-        EventKind::Modify(_) | EventKind::Create(_) => {
-            // Find which file was modified
-            for path in &event.paths {
-                if let Some((_, last_pos)) = file_positions.iter_mut().find(|(p, _)| p == path) {
-                    // Process new content
-                    let stats = process_new_content(
-                        path,
-                        last_pos,
-                        db,
-                        extractor,
-                        output_format,
-                        show_stats,
-                        overall_start,
-                    )?;
-                    return Ok(Some(stats));
-                }
-            }
-        }
-        EventKind::Remove(_) => {
-            // File was deleted/rotated
-            for path in &event.paths {
-                if file_positions.iter().any(|(p, _)| p == path) && show_stats {
-                    eprintln!("[WARN] File deleted/rotated: {}", path.display());
-                }
-                // In a production system, we might try to reopen or handle rotation
-                // For now, just continue watching other files
-            }
-        }
-        _ => {}
-    }
-
-    Ok(None)
-}
-
-/// Process new content added to a file since last read
-fn process_new_content(
-    input_path: &Path,
-    last_pos: &mut u64,
-    db: &matchy::Database,
-    extractor: &matchy::extractor::Extractor,
-    output_format: &str,
-    _show_stats: bool,
-    _overall_start: Instant,
+    output_json: bool,
 ) -> Result<ProcessingStats> {
-    let mut file = File::open(input_path)
-        .with_context(|| format!("Failed to open {}", input_path.display()))?;
-
-    let current_size = file.metadata()?.len();
-
-    // Check if file was truncated (e.g., log rotation)
-    if current_size < *last_pos {
-        *last_pos = 0;
-    }
-
-    // Seek to last known position
-    file.seek(SeekFrom::Start(*last_pos))?;
-
     let mut stats = ProcessingStats::new();
-    let output_json = output_format == "json";
 
-    // Calculate starting line number (approximate - we don't track across follow sessions)
-    let starting_line = 1usize;
+    // One timestamp per read, like the parallel path's batches
+    let timestamp = if output_json {
+        std::time::SystemTime::now()
+            .duration_since(std::time::UNIX_EPOCH)
+            .unwrap()
+            .as_secs_f64()
+    } else {
+        0.0
+    };
 
-    // Read new lines
-    let reader = BufReader::new(file);
-    for (line_offset, line_result) in reader.lines().enumerate() {
-        let line = line_result?;
-        let line_bytes = line.as_bytes();
+    // `data` ends with a newline; trim and skip blank lines like LineScanner
+    let mut start = 0;
+    for (line_offset, end) in memchr::memchr_iter(b'\n', data).enumerate() {
+        let line_bytes = data[start..end].trim_ascii();
+        start = end + 1;
+        if line_bytes.is_empty() {
+            continue;
+        }
 
         stats.lines_processed += 1;
         stats.total_bytes += line_bytes.len();
 
-        // Calculate timestamp
-        let timestamp = if output_json {
-            std::time::SystemTime::now()
-                .duration_since(std::time::UNIX_EPOCH)
-                .unwrap()
-                .as_secs_f64()
-        } else {
-            0.0
-        };
-
-        // Process this line
         process_line_matches(
             line_bytes,
-            starting_line + line_offset,
+            first_line + line_offset,
             input_path,
             timestamp,
             db,
@@ -265,14 +350,14 @@ fn process_new_content(
         )?;
     }
 
-    // Update position
-    let new_file = File::open(input_path)?;
-    *last_pos = new_file.metadata()?.len();
-
     Ok(stats)
 }
 
 /// Parallel follow mode: watch files and process with worker pool
+///
+/// The reader thread watches the database file; when a new version
+/// opens cleanly it bumps a shared generation, and each worker swaps in
+/// its own handle on the new file before its next batch.
 #[allow(clippy::too_many_arguments)]
 pub fn follow_files_parallel(
     inputs: Vec<PathBuf>,
@@ -319,6 +404,9 @@ pub fn follow_files_parallel(
     // Share work receiver across workers
     let work_rx = Arc::new(Mutex::new(work_rx));
 
+    // Bumped by the reader thread each time a new database version is ready
+    let db_generation = Arc::new(AtomicU64::new(0));
+
     // Spawn worker pool - same as parallel but checks shutdown signal
     let mut worker_handles = Vec::new();
     for worker_id in 0..num_threads {
@@ -326,6 +414,7 @@ pub fn follow_files_parallel(
         let result_tx = result_tx.clone();
         let database_path = database_path.to_owned();
         let extractor_config = extractor_config.clone();
+        let db_generation = Arc::clone(&db_generation);
 
         let handle = thread::spawn(move || {
             set_thread_name(&format!("matchy-follow-worker-{}", worker_id));
@@ -334,6 +423,7 @@ pub fn follow_files_parallel(
                 work_rx,
                 result_tx,
                 database_path,
+                db_generation,
                 cache_size,
                 show_stats,
                 extractor_config,
@@ -349,9 +439,18 @@ pub fn follow_files_parallel(
     let reader_handle = {
         let inputs = inputs.clone();
         let shutdown_reader = Arc::clone(&shutdown);
+        let database_path = database_path.to_owned();
         thread::spawn(move || {
             set_thread_name("matchy-follow-reader");
-            reader_watcher_thread(inputs, work_tx, overall_start, shutdown_reader, show_stats)
+            reader_watcher_thread(
+                inputs,
+                work_tx,
+                overall_start,
+                shutdown_reader,
+                show_stats,
+                &database_path,
+                &db_generation,
+            )
         })
     };
 
@@ -396,86 +495,64 @@ fn reader_watcher_thread(
     _overall_start: Instant,
     shutdown: Arc<AtomicBool>,
     show_stats: bool,
+    database_path: &Path,
+    db_generation: &AtomicU64,
 ) -> Result<()> {
-    // Process existing content first
     if show_stats {
         eprintln!("[INFO] Processing existing file content...");
     }
 
-    let mut file_positions: HashMap<PathBuf, u64> = HashMap::new();
-    let mut line_counters: HashMap<PathBuf, usize> = HashMap::new();
-
-    for input_path in &inputs {
-        // Read existing content and send as initial batch
-        if let Ok(file) = File::open(input_path) {
-            if let Ok(metadata) = file.metadata() {
-                let size = metadata.len();
-                if size > 0 {
-                    // Read entire existing file as initial batch
-                    let mut content = Vec::new();
-                    if let Ok(mut f) = File::open(input_path) {
-                        if f.read_to_end(&mut content).is_ok() {
-                            // Pre-compute line offsets for workers
-                            let line_offsets: Vec<usize> =
-                                memchr::memchr_iter(b'\n', &content).collect();
-                            let line_count = line_offsets.len();
-
-                            let batch = super::parallel::LineBatch {
-                                source: input_path.clone(),
-                                starting_line_number: 1,
-                                data: Arc::new(content.clone()),
-                                line_offsets: Arc::new(line_offsets),
-                                word_boundaries: None,
-                            };
-                            let _ = work_tx.send(Some(batch));
-
-                            // Count lines for tracking
-                            line_counters.insert(input_path.clone(), line_count + 1);
-                        }
-                    }
-                }
-                file_positions.insert(input_path.clone(), size);
-            }
-        }
-    }
-
-    if show_stats {
-        eprintln!("[INFO] Watching for new content (Ctrl+C to stop)...");
-    }
-
-    // Setup file watcher
+    // Setup file watcher; existing content is the first read of each input
     let (tx, rx) = mpsc::channel();
     let mut watcher: RecommendedWatcher =
         Watcher::new(tx, Config::default()).context("Failed to create file watcher")?;
-
-    for input_path in &inputs {
-        watcher
-            .watch(input_path, RecursiveMode::NonRecursive)
-            .with_context(|| format!("Failed to watch {}", input_path.display()))?;
-    }
+    let mut follow = FollowSet::new(&inputs, &mut watcher)?;
+    let mut database_watch = DatabaseWatch::new(database_path, &mut watcher)?;
+    let mut data = Vec::new();
+    let mut watching = false;
 
     // Process file modification events
     while !shutdown.load(Ordering::Relaxed) {
-        match rx.recv_timeout(Duration::from_millis(100)) {
-            Ok(Ok(event)) => {
-                handle_file_event_parallel(
-                    event,
-                    &mut file_positions,
-                    &mut line_counters,
-                    &work_tx,
-                )?;
-            }
-            Ok(Err(e)) => {
-                eprintln!("[WARN] File watcher error: {}", e);
-            }
-            Err(mpsc::RecvTimeoutError::Timeout) => {
-                // Normal timeout, check shutdown flag
-                continue;
+        if database_watch.take_due() {
+            // Check the new file once here rather than failing in every worker
+            match matchy::Database::from(database_path).no_cache().open() {
+                Ok(_) => {
+                    db_generation.fetch_add(1, Ordering::Release);
+                    if show_stats {
+                        eprintln!("[INFO] Reloading database: {}", database_path.display());
+                    }
+                }
+                Err(e) => eprintln!(
+                    "[WARN] Database reload failed, keeping the current version: {}",
+                    e
+                ),
             }
-            Err(mpsc::RecvTimeoutError::Disconnected) => {
-                break;
+        }
+
+        // Appended lines go to the workers as-is, no per-line copies
+        follow.read_changed(&mut data, |path, first_line, lines| {
+            let line_offsets: Vec<usize> = memchr::memchr_iter(b'\n', lines).collect();
+            let batch = super::parallel::LineBatch {
+                source: path.to_path_buf(),
+                starting_line_number: first_line,
+                data: Arc::new(std::mem::take(lines)),
+                line_offsets: Arc::new(line_offsets),
+                word_boundaries: None,
+            };
+            let _ = work_tx.send(Some(batch));
+            Ok(())
+        })?;
+
+        if !watching {
+            watching = true;
+            if show_stats {
+                eprintln!("[INFO] Watching for new content (Ctrl+C to stop)...");
             }
         }
+
+        if !drain_events(&rx, &mut database_watch, &mut follow) {
+            break;
+        }
     }
 
     // Send termination signal to workers
@@ -490,6 +567,7 @@ fn worker_thread_follow(
     work_rx: Arc<Mutex<Receiver<Option<super::parallel::LineBatch>>>>,
     result_tx: SyncSender<Option<super::parallel::WorkerMessage>>,
     database_path: PathBuf,
+    db_generation: Arc<AtomicU64>,
     cache_size: usize,
     _show_stats: bool,
     extractor_config: super::parallel::ExtractorConfig,
@@ -533,6 +611,7 @@ fn worker_thread_follow(
 
     // Reusable buffers for match result construction
     let mut match_buffers = MatchBuffers::new();
+    let mut seen_generation = 0;
 
     // Process work batches
     loop {
@@ -541,6 +620,22 @@ fn worker_thread_follow(
             rx.recv()
         };
 
+        // Swap in a new database version before matching the next batch
+        let generation = db_generation.load(Ordering::Acquire);
+        if generation != seen_generation {
+            seen_generation = generation;
+            let current = worker.database("default").expect("default database");
+            match reopen_database(&database_path, cache_size, current) {
+                Ok(new_db) => {
+                    let _ = worker.replace_database("default", new_db);
+                }
+                Err(e) => eprintln!(
+                    "[WARN] Worker {} failed to reload database: {:#}",
+                    worker_id, e
+                ),
+            }
+        }
+
         match batch_opt {
             Ok(Some(batch)) => {
                 // Process batch using library worker (batch is already LineBatch)
@@ -700,72 +795,3 @@ fn output_thread_follow(
 
     stats
 }
-
-/// Handle file modification event - read new content and send as batch
-fn handle_file_event_parallel(
-    event: Event,
-    file_positions: &mut HashMap<PathBuf, u64>,
-    line_counters: &mut HashMap<PathBuf, usize>,
-    work_tx: &SyncSender<Option<super::parallel::LineBatch>>,
-) -> Result<()> {
-    match event.kind {
-        EventKind::Modify(_) | EventKind::Create(_) => {
-            for path in &event.paths {
-                if let Some(last_pos) = file_positions.get_mut(path) {
-                    // Read new content since last position
-                    if let Ok(mut file) = File::open(path) {
-                        if let Ok(current_size) = file.metadata().map(|m| m.len()) {
-                            // Check for truncation (log rotation)
-                            if current_size < *last_pos {
-                                *last_pos = 0;
-                                line_counters.insert(path.clone(), 1);
-                            }
-
-                            if current_size > *last_pos {
-                                // Seek and read new content
-                                if file.seek(SeekFrom::Start(*last_pos)).is_ok() {
-                                    let mut new_content = Vec::new();
-                                    if file.read_to_end(&mut new_content).is_ok()
-                                        && !new_content.is_empty()
-                                    {
-                                        let starting_line =
-                                            line_counters.get(path).copied().unwrap_or(1);
-
-                                        // Pre-compute line offsets for workers
-                                        let line_offsets: Vec<usize> =
-                                            memchr::memchr_iter(b'\n', &new_content).collect();
-                                        let new_lines = line_offsets.len();
-
-                                        let batch = super::parallel::LineBatch {
-                                            source: path.clone(),
-                                            starting_line_number: starting_line,
-                                            data: Arc::new(new_content.clone()),
-                                            line_offsets: Arc::new(line_offsets),
-                                            word_boundaries: None,
-                                        };
-                                        let _ = work_tx.send(Some(batch));
-
-                                        // Update position and line counter
-                                        *last_pos = current_size;
-                                        *line_counters.get_mut(path).unwrap() += new_lines;
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-        }
-        EventKind::Remove(_) => {
-            for path in &event.paths {
-                if file_positions.contains_key(path) {
-                    eprintln!("[WARN] File deleted/rotated: {}", path.display());
-                    // Could implement log rotation handling here
-                }
-            }
-        }
-        _ => {}
-    }
-
-    Ok(())
-}
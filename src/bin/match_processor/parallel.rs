@@ -2,7 +2,7 @@ use anyhow::{Context, Result};
 use serde_json::json;
 use std::collections::HashMap;
 use std::path::{Path, PathBuf};
-use std::sync::{Arc, Mutex};
+use std::sync::{Arc, Mutex, OnceLock};
 use std::time::Instant;
 
 use super::stats::ProcessingStats;
@@ -262,10 +262,17 @@ pub fn process_parallel(
     let db_path = database_path.to_owned();
     let ext_config = extractor_config.clone();
 
-    let result = matchy::processing::process_files_parallel(
+    // NDJSON output keeps input order; summaries only need the counts
+    let options = matchy::processing::ParallelOptions {
+        num_readers: Some(num_readers),
+        num_workers: Some(num_workers),
+        ordered: output_json,
+        ..Default::default()
+    };
+
+    let result = matchy::processing::process_files_parallel_with(
         inputs,
-        Some(num_readers),
-        Some(num_workers),
+        options,
         move || {
             // Create database
             let db = init_worker_database(&db_path, cache_size)
@@ -340,7 +347,25 @@ pub enum WorkerMessage {
     },
 }
 
-/// Initialize database for a worker thread
+/// Query profiler shared by every database this process opens (`--stats`)
+static QUERY_PROFILER: OnceLock<Arc<matchy::QueryProfiler>> = OnceLock::new();
+
+/// Sample one query in `sample_every` on every database opened from now on
+pub fn enable_query_profiler(sample_every: u32) -> Arc<matchy::QueryProfiler> {
+    let threads = std::thread::available_parallelism().map_or(1, |n| n.get());
+    Arc::clone(QUERY_PROFILER.get_or_init(|| {
+        Arc::new(matchy::QueryProfiler::with_concurrency(
+            sample_every,
+            threads,
+        ))
+    }))
+}
+
+/// The shared query profiler, if profiling was enabled
+pub fn query_profiler() -> Option<Arc<matchy::QueryProfiler>> {
+    QUERY_PROFILER.get().cloned()
+}
+
 /// Initialize database for a worker thread
 pub fn init_worker_database(database_path: &Path, cache_size: usize) -> Result<matchy::Database> {
     use matchy::Database;
@@ -351,6 +376,9 @@ pub fn init_worker_database(database_path: &Path, cache_size: usize) -> Result<m
     } else {
         opener = opener.cache_capacity(cache_size);
     }
+    if let Some(profiler) = query_profiler() {
+        opener = opener.profiler(profiler);
+    }
     opener.open().context("Failed to open database")
 }
 
@@ -0,0 +1,232 @@
+use std::fs::{self, File};
+use std::io;
+use std::path::{Path, PathBuf};
+
+/// Most bytes taken from one file per read, so a large backlog arrives in pieces
+pub const MAX_READ: usize = 4 * 1024 * 1024;
+
+/// Identity of the file behind a path, used to notice rotation
+#[cfg(unix)]
+type FileId = (u64, u64);
+#[cfg(not(unix))]
+type FileId = ();
+
+#[cfg(unix)]
+fn file_id(metadata: &fs::Metadata) -> FileId {
+    use std::os::unix::fs::MetadataExt;
+    (metadata.dev(), metadata.ino())
+}
+
+#[cfg(not(unix))]
+fn file_id(_metadata: &fs::Metadata) -> FileId {}
+
+/// Read up to `buf.len()` bytes at `offset` without moving a file cursor
+#[cfg(unix)]
+fn read_at(file: &File, buf: &mut [u8], offset: u64) -> io::Result<usize> {
+    use std::os::unix::fs::FileExt;
+    file.read_at(buf, offset)
+}
+
+#[cfg(not(unix))]
+fn read_at(mut file: &File, buf: &mut [u8], offset: u64) -> io::Result<usize> {
+    use std::io::{Read, Seek, SeekFrom};
+    file.seek(SeekFrom::Start(offset))?;
+    file.read(buf)
+}
+
+/// An input followed across appends, truncation and rotation
+///
+/// The file stays open between reads, so each change costs one `fstat`
+/// and one positional read of the appended range rather than an
+/// open/seek/close. When the path comes to name a different file (log
+/// rotation by rename), whatever was still appended to the old file is
+/// read first, then the new file is followed from its start. A file that
+/// shrinks below the read position was truncated and is re-read from the
+/// beginning. Only complete lines are handed out; a trailing partial line
+/// waits for its newline.
+pub struct TailFile {
+    path: PathBuf,
+    file: File,
+    id: FileId,
+    pos: u64,
+    next_line: usize,
+    partial: Vec<u8>,
+}
+
+impl TailFile {
+    /// Follow `path` from byte `pos`, numbering the line there `next_line`
+    pub fn open(path: &Path, pos: u64, next_line: usize) -> io::Result<Self> {
+        let file = File::open(path)?;
+        let id = file_id(&file.metadata()?);
+        Ok(Self {
+            path: path.to_path_buf(),
+            file,
+            id,
+            pos,
+            next_line,
+            partial: Vec::new(),
+        })
+    }
+
+    pub fn path(&self) -> &Path {
+        &self.path
+    }
+
+    /// Replace `data` with the next run of complete lines
+    ///
+    /// Returns the line number of the first line, or `None` when nothing
+    /// new is available. Call until `None` to drain everything appended.
+    pub fn read_lines(&mut self, data: &mut Vec<u8>) -> io::Result<Option<usize>> {
+        data.clear();
+        let len = self.file.metadata()?.len();
+
+        if len < self.pos {
+            // Truncated in place (copytruncate): start over
+            self.restart();
+        } else if len == self.pos && self.rotated() {
+            // Old file fully read; switch to the one now at the path
+            let pending = std::mem::take(&mut self.partial);
+            let pending_line = self.next_line;
+            self.file = File::open(&self.path)?;
+            self.id = file_id(&self.file.metadata()?);
+            self.restart();
+            if !pending.is_empty() {
+                // The old file ended without a newline; flush its last line
+                data.extend_from_slice(&pending);
+                data.push(b'\n');
+                return Ok(Some(pending_line));
+            }
+        }
+
+        data.extend_from_slice(&self.partial);
+        self.partial.clear();
+        loop {
+            let len = self.file.metadata()?.len();
+            if len <= self.pos {
+                // Nothing but a partial line so far
+                std::mem::swap(&mut self.partial, data);
+                return Ok(None);
+            }
+
+            let want = ((len - self.pos) as usize).min(MAX_READ);
+            let start = data.len();
+            data.resize(start + want, 0);
+            let mut filled = 0;
+            while filled < want {
+                let offset = self.pos + filled as u64;
+                match read_at(&self.file, &mut data[start + filled..], offset) {
+                    Ok(0) => break,
+                    Ok(n) => filled += n,
+                    Err(e) if e.kind() == io::ErrorKind::Interrupted => {}
+                    Err(e) => return Err(e),
+                }
+            }
+            data.truncate(start + filled);
+            self.pos += filled as u64;
+            if filled == 0 {
+                std::mem::swap(&mut self.partial, data);
+                return Ok(None);
+            }
+
+            // Hold back the unterminated tail until its newline arrives
+            if let Some(last) = memchr::memrchr(b'\n', &data[start..]) {
+                let end = start + last + 1;
+                self.partial.extend_from_slice(&data[end..]);
+                data.truncate(end);
+
+                let first_line = self.next_line;
+                self.next_line += memchr::memchr_iter(b'\n', data).count();
+                return Ok(Some(first_line));
+            }
+        }
+    }
+
+    /// Whether the path now names a different file than the one held open
+    fn rotated(&self) -> bool {
+        match fs::metadata(&self.path) {
+            Ok(metadata) => file_id(&metadata) != self.id,
+            // Renamed away and not yet recreated: keep the old file
+            Err(_) => false,
+        }
+    }
+
+    fn restart(&mut self) {
+        self.pos = 0;
+        self.next_line = 1;
+        self.partial.clear();
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::io::Write;
+
+    fn append(path: &Path, text: &str) {
+        let mut file = fs::OpenOptions::new().append(true).open(path).unwrap();
+        file.write_all(text.as_bytes()).unwrap();
+    }
+
+    fn drain(tail: &mut TailFile) -> Vec<(usize, String)> {
+        let mut data = Vec::new();
+        let mut out = Vec::new();
+        while let Some(first) = tail.read_lines(&mut data).unwrap() {
+            let lines = String::from_utf8(data.clone()).unwrap();
+            for (i, line) in lines.lines().enumerate() {
+                out.push((first + i, line.to_string()));
+            }
+        }
+        out
+    }
+
+    #[test]
+    fn test_partial_lines_wait_for_newline() {
+        let dir = tempfile::tempdir().unwrap();
+        let path = dir.path().join("app.log");
+        fs::write(&path, "one\ntw").unwrap();
+
+        let mut tail = TailFile::open(&path, 0, 1).unwrap();
+        assert_eq!(drain(&mut tail), vec![(1, "one".to_string())]);
+
+        append(&path, "o\nthree\n");
+        assert_eq!(
+            drain(&mut tail),
+            vec![(2, "two".to_string()), (3, "three".to_string())]
+        );
+        assert!(drain(&mut tail).is_empty());
+    }
+
+    #[test]
+    fn test_truncation_restarts() {
+        let dir = tempfile::tempdir().unwrap();
+        let path = dir.path().join("app.log");
+        fs::write(&path, "old line one\nold line two\n").unwrap();
+
+        let mut tail = TailFile::open(&path, 0, 1).unwrap();
+        assert_eq!(drain(&mut tail).len(), 2);
+
+        fs::write(&path, "new\n").unwrap();
+        assert_eq!(drain(&mut tail), vec![(1, "new".to_string())]);
+    }
+
+    #[cfg(unix)]
+    #[test]
+    fn test_rotation_drains_old_file_first() {
+        let dir = tempfile::tempdir().unwrap();
+        let path = dir.path().join("app.log");
+        fs::write(&path, "a\n").unwrap();
+
+        let mut tail = TailFile::open(&path, 0, 1).unwrap();
+        assert_eq!(drain(&mut tail), vec![(1, "a".to_string())]);
+
+        // Writer appends after the rename, then a new file takes the path
+        fs::rename(&path, dir.path().join("app.log.1")).unwrap();
+        append(&dir.path().join("app.log.1"), "b\n");
+        fs::write(&path, "c\n").unwrap();
+
+        assert_eq!(
+            drain(&mut tail),
+            vec![(2, "b".to_string()), (1, "c".to_string())]
+        );
+    }
+}
@@ -7,7 +7,7 @@ use clap::{Parser, Subcommand};
 use std::path::PathBuf;
 
 use commands::{
-    cmd_bench, cmd_build, cmd_extract, cmd_inspect, cmd_match, cmd_query, cmd_validate,
+    cmd_bench, cmd_build, cmd_compact, cmd_extract, cmd_inspect, cmd_match, cmd_query, cmd_validate,
 };
 
 #[derive(Parser)]
@@ -204,6 +204,75 @@ enum Commands {
         /// Use case-insensitive matching for patterns (default: case-sensitive)
         #[arg(short = 'i', long)]
         case_insensitive: bool,
+
+        /// Also write a multi-bit stride index for faster IP lookups
+        /// (larger file; still readable by standard MMDB readers)
+        #[arg(long)]
+        ip_stride_index: bool,
+
+        /// Write glob automaton states up to this depth as DFA tables
+        /// (0 = root only; 1KB per state, faster pattern scans)
+        #[arg(long, value_name = "DEPTH")]
+        glob_dfa_depth: Option<u8>,
+
+        /// Key glob automaton transitions by byte class (smaller dense
+        /// and DFA tables, no lowercase copy in case-insensitive mode)
+        #[arg(long)]
+        glob_byte_classes: bool,
+
+        /// Also write a Bloom prefilter that rejects most string misses
+        /// before the literal table and glob automaton (~10 bits per key)
+        #[arg(long)]
+        prefilter: bool,
+
+        /// Store literals in a minimal perfect hash table (one pilot and
+        /// one 32-byte slot per lookup, smaller than the default layout)
+        #[arg(long)]
+        perfect_hash: bool,
+
+        /// File of keys to mark deleted, one per line (builds a delta
+        /// database to layer over a base; see `matchy compact`)
+        #[arg(long, value_name = "FILE")]
+        tombstones: Option<PathBuf>,
+    },
+
+    /// Merge a base database and its delta databases into a new base
+    Compact {
+        /// Base database (.mxy file)
+        #[arg(value_name = "BASE")]
+        base: PathBuf,
+
+        /// Delta databases, oldest first
+        #[arg(value_name = "DELTA", required = true)]
+        deltas: Vec<PathBuf>,
+
+        /// Output database file (.mxy extension)
+        #[arg(short, long, value_name = "FILE")]
+        output: PathBuf,
+
+        /// Also write a multi-bit stride index for faster IP lookups
+        #[arg(long)]
+        ip_stride_index: bool,
+
+        /// Write glob automaton states up to this depth as DFA tables
+        #[arg(long, value_name = "DEPTH")]
+        glob_dfa_depth: Option<u8>,
+
+        /// Key glob automaton transitions by byte class
+        #[arg(long)]
+        glob_byte_classes: bool,
+
+        /// Also write a Bloom prefilter for string misses
+        #[arg(long)]
+        prefilter: bool,
+
+        /// Store literals in a minimal perfect hash table
+        #[arg(long)]
+        perfect_hash: bool,
+
+        /// Verbose output during compaction
+        #[arg(short, long)]
+        verbose: bool,
     },
 
     /// Validate a database file for safety and correctness
@@ -346,6 +415,12 @@ fn main() -> Result<()> {
             verbose,
             debug,
             case_insensitive,
+            ip_stride_index,
+            glob_dfa_depth,
+            glob_byte_classes,
+            prefilter,
+            perfect_hash,
+            tombstones,
         } => cmd_build(
             inputs,
             output,
@@ -356,6 +431,33 @@ fn main() -> Result<()> {
             verbose,
             debug,
             case_insensitive,
+            ip_stride_index,
+            glob_dfa_depth,
+            glob_byte_classes,
+            prefilter,
+            perfect_hash,
+            tombstones,
+        ),
+        Commands::Compact {
+            base,
+            deltas,
+            output,
+            ip_stride_index,
+            glob_dfa_depth,
+            glob_byte_classes,
+            prefilter,
+            perfect_hash,
+            verbose,
+        } => cmd_compact(
+            base,
+            deltas,
+            output,
+            ip_stride_index,
+            glob_dfa_depth,
+            glob_byte_classes,
+            prefilter,
+            perfect_hash,
+            verbose,
         ),
         Commands::Bench {
             db_type,
@@ -3,15 +3,23 @@
 //! This module provides a modern, clean C API for building and querying databases
 //! containing IP addresses and patterns. This is the primary public API.
 
-use crate::data_section::DataValue;
-use crate::database::{Database as RustDatabase, QueryResult};
+use crate::arena::Arena;
+use crate::cache_policy::CachePolicy;
+use crate::data_section::{DataDecoder, DataValue, ValueRef};
+use crate::database::{DataRef, Database as RustDatabase, DatabaseError, QueryResult};
+use crate::extractor::{ExtractedItem, Extractor, HashType};
 use crate::glob::MatchMode;
 use crate::mmdb_builder::MmdbBuilder;
+use crate::profile::{LatencyHistogram, QueryProfiler, QueryStage};
+use crate::reload::ReloadableDatabase;
 use std::collections::HashMap;
-use std::ffi::{CStr, CString};
+use std::ffi::{c_void, CStr, CString};
+use std::mem;
+use std::net::{IpAddr, Ipv4Addr, Ipv6Addr};
 use std::os::raw::c_char;
 use std::ptr;
 use std::slice;
+use std::sync::Arc;
 
 // ============================================================================
 // ERROR CODES
@@ -48,6 +56,18 @@ pub struct matchy_t {
     _private: [u8; 0],
 }
 
+/// Opaque arena handle (see matchy_arena_new)
+#[repr(C)]
+pub struct matchy_arena_t {
+    _private: [u8; 0],
+}
+
+/// Opaque extract-and-match worker handle (see matchy_worker_new)
+#[repr(C)]
+pub struct matchy_worker_t {
+    _private: [u8; 0],
+}
+
 /// Query result
 #[repr(C)]
 pub struct matchy_result_t {
@@ -59,6 +79,120 @@ pub struct matchy_result_t {
     pub _data_cache: *mut (),
     /// Internal database reference (for entry.db population)
     pub _db_ref: *const matchy_t,
+    /// Internal data section offset (for lazy results, where `_data_cache` is NULL)
+    pub _data_offset: u32,
+    /// Internal reference keeping a lazy result's database version mapped
+    /// across matchy_reload() (released by matchy_free_result)
+    pub _db_version: *const (),
+}
+
+impl matchy_result_t {
+    /// Result for a query with no match (nothing to free)
+    fn not_found() -> Self {
+        Self {
+            found: false,
+            prefix_len: 0,
+            _data_cache: ptr::null_mut(),
+            _db_ref: ptr::null(),
+            _data_offset: 0,
+            _db_version: ptr::null(),
+        }
+    }
+
+    /// Build a result holding `data` (freed by matchy_free_result)
+    fn found(db: *const matchy_t, data: DataValue, prefix_len: u8) -> Self {
+        // Cache the DataValue for structured access
+        let data_cache_ptr = Box::into_raw(Box::new(data)) as *mut ();
+        Self {
+            found: true,
+            prefix_len,
+            _data_cache: data_cache_ptr,
+            _db_ref: db,
+            _data_offset: 0,
+            _db_version: ptr::null(),
+        }
+    }
+
+    /// Build a result that references data in place (nothing to allocate)
+    ///
+    /// The result holds a reference to `version`, so the data stays mapped
+    /// until matchy_free_result() even if the handle is reloaded.
+    fn lazy(db: *const matchy_t, version: &Arc<RustDatabase>, data: DataRef) -> Self {
+        Self {
+            found: true,
+            prefix_len: data.prefix_len,
+            _data_cache: ptr::null_mut(),
+            _db_ref: db,
+            _data_offset: data.offset,
+            _db_version: Arc::into_raw(Arc::clone(version)) as *const (),
+        }
+    }
+
+    /// Look up `query` in `current`, lazily if the handle was opened for it
+    fn query(
+        db: *const matchy_t,
+        internal: &MatchyInternal,
+        current: &Arc<RustDatabase>,
+        query: &str,
+    ) -> Self {
+        if internal.lazy(current) {
+            match current.lookup_ref(query) {
+                Ok(Some(data)) => return Self::lazy(db, current, data),
+                Ok(None) => return Self::not_found(),
+                // No in-place answer for this version; decode instead
+                Err(_) => {}
+            }
+        }
+        Self::from_lookup(db, current.lookup(query))
+    }
+
+    /// Look up a binary address in `current`, lazily if the handle was opened for it
+    fn query_ip(
+        db: *const matchy_t,
+        internal: &MatchyInternal,
+        current: &Arc<RustDatabase>,
+        ip: IpAddr,
+    ) -> Self {
+        if internal.lazy(current) {
+            match current.lookup_ip_ref(ip) {
+                Ok(Some(data)) => return Self::lazy(db, current, data),
+                Ok(None) => return Self::not_found(),
+                // No in-place answer for this version; decode instead
+                Err(_) => {}
+            }
+        }
+        Self::from_lookup(db, current.lookup_ip(ip))
+    }
+
+    /// Decoder and offset for a lazy result, None for decoded results
+    unsafe fn lazy_data(&self) -> Option<(DataDecoder<'static>, u32)> {
+        if !self.found || !self._data_cache.is_null() || self._db_version.is_null() {
+            return None;
+        }
+        let version = &*(self._db_version as *const RustDatabase);
+        let decoder = version.data_decoder()?;
+        Some((decoder, self._data_offset))
+    }
+
+    /// Convert a database lookup into a C result
+    ///
+    /// For pattern matches, the first match's data is returned.
+    fn from_lookup(
+        db: *const matchy_t,
+        lookup: Result<Option<QueryResult>, crate::database::DatabaseError>,
+    ) -> Self {
+        match lookup {
+            Ok(Some(QueryResult::Ip { data, prefix_len })) => Self::found(db, data, prefix_len),
+            Ok(Some(QueryResult::Pattern {
+                pattern_ids: _,
+                mut data,
+            })) => match data.first_mut().and_then(Option::take) {
+                Some(first_data) => Self::found(db, first_data, 0),
+                None => Self::not_found(),
+            },
+            _ => Self::not_found(),
+        }
+    }
 }
 
 // ============================================================================
@@ -70,7 +204,27 @@ struct MatchyBuilderInternal {
 }
 
 struct MatchyInternal {
-    database: RustDatabase,
+    database: ReloadableDatabase,
+    /// Queries return data section references instead of decoded data
+    lazy_results: bool,
+}
+
+struct MatchyWorkerInternal {
+    extractor: Extractor,
+    /// Borrowed handles, queried in order; their index is the match's db_id
+    databases: Vec<*const matchy_t>,
+}
+
+impl MatchyInternal {
+    /// Whether queries against `current` return lazy results
+    ///
+    /// Checked per version: a reload may swap in a file without a data
+    /// section. Overlaid handles answer from several files, so a single
+    /// data offset cannot describe their results; they are decoded instead.
+    #[inline]
+    fn lazy(&self, current: &RustDatabase) -> bool {
+        self.lazy_results && current.has_ip_data() && !current.has_overlays()
+    }
 }
 
 // Conversion helpers for opaque types
@@ -102,6 +256,38 @@ impl matchy_t {
     }
 }
 
+impl matchy_worker_t {
+    fn from_internal(internal: Box<MatchyWorkerInternal>) -> *mut Self {
+        Box::into_raw(internal) as *mut Self
+    }
+
+    unsafe fn into_internal(ptr: *mut Self) -> Box<MatchyWorkerInternal> {
+        Box::from_raw(ptr as *mut MatchyWorkerInternal)
+    }
+
+    unsafe fn as_internal(ptr: *const Self) -> &'static MatchyWorkerInternal {
+        &*(ptr as *const MatchyWorkerInternal)
+    }
+}
+
+impl matchy_arena_t {
+    fn from_arena(arena: Box<Arena>) -> *mut Self {
+        Box::into_raw(arena) as *mut Self
+    }
+
+    unsafe fn into_arena(ptr: *mut Self) -> Box<Arena> {
+        Box::from_raw(ptr as *mut Arena)
+    }
+
+    unsafe fn as_arena(ptr: *const Self) -> &'static Arena {
+        &*(ptr as *const Arena)
+    }
+
+    unsafe fn as_arena_mut(ptr: *mut Self) -> &'static mut Arena {
+        &mut *(ptr as *mut Arena)
+    }
+}
+
 // ============================================================================
 // DATABASE BUILDING API
 // ============================================================================
@@ -224,7 +410,7 @@ pub unsafe extern "C" fn matchy_builder_set_description(
 
     let internal = matchy_builder_t::as_internal_mut(builder);
     // Create new builder with description
-    let old_builder = std::mem::replace(
+    let old_builder = mem::replace(
         &mut internal.builder,
         MmdbBuilder::new(MatchMode::CaseSensitive),
     );
@@ -269,7 +455,7 @@ pub unsafe extern "C" fn matchy_builder_save(
 
     let internal = matchy_builder_t::as_internal_mut(builder);
     // Replace builder with a dummy one to take ownership
-    let builder_to_build = std::mem::replace(
+    let builder_to_build = mem::replace(
         &mut internal.builder,
         MmdbBuilder::new(MatchMode::CaseSensitive),
     );
@@ -321,7 +507,7 @@ pub unsafe extern "C" fn matchy_builder_build(
 
     let internal = matchy_builder_t::as_internal_mut(builder);
     // Replace builder with a dummy one to take ownership
-    let builder_to_build = std::mem::replace(
+    let builder_to_build = mem::replace(
         &mut internal.builder,
         MmdbBuilder::new(MatchMode::CaseSensitive),
     );
@@ -366,21 +552,122 @@ pub unsafe extern "C" fn matchy_builder_free(builder: *mut matchy_builder_t) {
 // DATABASE QUERYING API
 // ============================================================================
 
+/// Cache policy for matchy_open_options_t: least recently used
+pub const MATCHY_CACHE_LRU: u32 = 0;
+/// Cache policy for matchy_open_options_t: CLOCK (second chance)
+pub const MATCHY_CACHE_CLOCK: u32 = 1;
+/// Cache policy for matchy_open_options_t: S3-FIFO
+pub const MATCHY_CACHE_S3FIFO: u32 = 2;
+/// Cache policy for matchy_open_options_t: W-TinyLFU
+pub const MATCHY_CACHE_TINYLFU: u32 = 3;
+
 /// Database opening options
 ///
 /// Configure how databases are loaded, including cache settings and validation.
+/// Always start from matchy_init_open_options(): it fills in `struct_size`,
+/// which lets later releases append fields without breaking callers.
 #[repr(C)]
 pub struct matchy_open_options_t {
+    /// Size of this struct as the caller was compiled against it
+    /// Set by matchy_init_open_options(); matchy_open_with_options() fails
+    /// on sizes it does not recognize.
+    pub struct_size: u32,
     /// LRU cache capacity
     /// 0 = disable cache, >0 = cache this many entries
     /// Default: 10000
     pub cache_capacity: u32,
+    /// Cache replacement policy: one of the MATCHY_CACHE_* constants
+    /// MATCHY_CACHE_S3FIFO and MATCHY_CACHE_TINYLFU keep a burst of unique
+    /// queries from flushing the hot entries; matchy_get_stats() reports
+    /// each policy's evictions, rejections and promotions.
+    /// Unknown values make matchy_open_with_options() fail.
+    /// Default: MATCHY_CACHE_LRU
+    pub cache_policy: u32,
+    /// Misses to remember in a separate lock-free negative cache
+    /// Misses then no longer take LRU entries from hits, and a repeated miss
+    /// costs one atomic load. Works with or without the LRU cache.
+    /// Entries are 64-bit fingerprints, not checked against the query: a
+    /// match whose fingerprint collides with a remembered miss is reported
+    /// as not found (odds about capacity / 2^64 per lookup).
+    /// 0 = misses share the LRU cache
+    /// Default: 0
+    pub negative_cache_capacity: u32,
+    /// Number of threads expected to query the handle concurrently
+    /// Handles are always thread-safe and give each thread its own pattern
+    /// scratch; values > 1 also shard the shared cache so threads don't contend.
+    /// 0 or 1 = single shard (lowest memory)
+    /// Default: 1
+    pub concurrency: u32,
+    /// Return lazy results that reference the mapped data section
+    /// A hit then allocates nothing, but each found result holds a reference
+    /// that keeps its version of the file mapped across matchy_reload(), so
+    /// lazy results MUST still be freed with matchy_free_result(), which
+    /// releases that reference. matchy_aget_value() and
+    /// matchy_get_entry_data_list() decode straight from the file. Lazy
+    /// queries bypass the cache. String values point into the database, stay
+    /// valid until the result is freed, and are NOT null-terminated (use data_size).
+    /// Ignored for pattern-only databases, which have no data section, and
+    /// for handles with overlays, whose answers can span several files.
+    /// Default: false
+    pub lazy_results: bool,
+    /// Build a 2^16-entry direct-index table for IPv4 lookups at open
+    /// The first 16 bits of every IPv4 lookup become one array read instead
+    /// of 16 tree levels. Costs 320 KiB per handle and a short walk at open.
+    /// Default: false
+    pub ipv4_direct_index: bool,
+    /// Warm the new cache in matchy_reload() before swapping the file in
+    /// The most recently used cached queries are re-run against the new
+    /// file, so the cache hit rate survives the reload.
+    /// Default: true
+    pub reload_warm_cache: bool,
+    /// Fault in the hot sections (IP tree or stride index, prefilter,
+    /// literal hash table, glob automaton) before open returns, then read
+    /// the rest of the file ahead in the background
+    /// Avoids the page-fault latency spike on the first queries after an
+    /// open or reload.
+    /// Default: false
+    pub prefault: bool,
+    /// Lock the mapped file in RAM (mlock)
+    /// Needs CAP_IPC_LOCK or a large enough RLIMIT_MEMLOCK; the open fails
+    /// if the lock is refused.
+    /// Default: false
+    pub lock_memory: bool,
+    /// Ask for transparent huge pages over the mapping (Linux only)
+    /// A hint: ignored where unsupported.
+    /// Default: false
+    pub huge_pages: bool,
+    /// Trusted open: skip parsing the string sections at open
+    /// Only the metadata and section headers are read and checked against
+    /// the header checksum written at build time; the literal table and
+    /// glob matcher are set up by the first query that needs them, so open
+    /// time no longer grows with the file. A malformed section then fails
+    /// those queries instead of the open. Files without a checksum are
+    /// opened normally. Only use with files you built or validated.
+    /// Default: false
+    pub trusted: bool,
+    /// Profile one query in every N (rounded up to a power of two)
+    /// Sampled queries record per-stage latency histograms and scan
+    /// counters, read back with matchy_get_profile(). 0 disables profiling.
+    /// Default: 0
+    pub profile_sample_rate: u32,
 }
 
 impl Default for matchy_open_options_t {
     fn default() -> Self {
         Self {
+            struct_size: mem::size_of::<Self>() as u32,
             cache_capacity: 10000,
+            cache_policy: MATCHY_CACHE_LRU,
+            negative_cache_capacity: 0,
+            concurrency: 1,
+            lazy_results: false,
+            ipv4_direct_index: false,
+            reload_warm_cache: true,
+            prefault: false,
+            lock_memory: false,
+            huge_pages: false,
+            trusted: false,
+            profile_sample_rate: 0,
         }
     }
 }
@@ -388,7 +675,19 @@ impl Default for matchy_open_options_t {
 /// Initialize database opening options with defaults
 ///
 /// Sets default values:
+/// - struct_size = sizeof(matchy_open_options_t)
 /// - cache_capacity = 10000
+/// - cache_policy = MATCHY_CACHE_LRU
+/// - negative_cache_capacity = 0
+/// - concurrency = 1
+/// - lazy_results = false
+/// - ipv4_direct_index = false
+/// - reload_warm_cache = true
+/// - prefault = false
+/// - lock_memory = false
+/// - huge_pages = false
+/// - trusted = false
+/// - profile_sample_rate = 0
 ///
 /// # Parameters
 /// * `options` - Pointer to options struct to initialize (must not be NULL)
@@ -415,13 +714,18 @@ pub unsafe extern "C" fn matchy_init_open_options(options: *mut matchy_open_opti
 ///
 /// Opens a database file with configurable cache size and validation settings.
 ///
+/// The returned handle may be shared by any number of threads. Set
+/// `concurrency` to the number of querying threads so they share one warm,
+/// sharded cache instead of opening a handle per thread.
+///
 /// # Parameters
 /// * `filename` - Path to database file (null-terminated C string, must not be NULL)
 /// * `options` - Opening options (must not be NULL)
 ///
 /// # Returns
 /// * Non-null pointer on success
-/// * NULL on failure
+/// * NULL on failure, or if `options->struct_size` is not a known layout
+///   (options not set up with matchy_init_open_options())
 ///
 /// # Safety
 /// * `filename` must be a valid null-terminated C string
@@ -439,6 +743,35 @@ pub unsafe extern "C" fn matchy_init_open_options(options: *mut matchy_open_opti
 ///     fprintf(stderr, "Failed to open database\n");
 ///     return 1;
 /// }
+///
+/// // One handle shared by a 64-thread worker pool
+/// opts.concurrency = 64;
+/// matchy_t *shared = matchy_open_with_options("threats.mxy", &opts);
+///
+/// // Allocation-free hits, decoded on demand from the mapped file
+/// opts.lazy_results = true;
+/// matchy_t *lazy = matchy_open_with_options("GeoLite2-City.mmdb", &opts);
+///
+/// // Log bursts of one-off URLs: admit only entries that prove popular
+/// opts.cache_policy = MATCHY_CACHE_TINYLFU;
+/// matchy_t *scan_resistant = matchy_open_with_options("threats.mxy", &opts);
+///
+/// // Mostly-miss workloads: keep misses from evicting cached hits
+/// opts.negative_cache_capacity = 1 << 20;
+/// matchy_t *feed = matchy_open_with_options("threats.mxy", &opts);
+///
+/// // IPv4-heavy traffic: resolve the first 16 bits with one table read
+/// opts.ipv4_direct_index = true;
+/// matchy_t *fast_v4 = matchy_open_with_options("GeoLite2-City.mmdb", &opts);
+///
+/// // No page-fault spike on the first queries after open or reload
+/// opts.prefault = true;
+/// opts.huge_pages = true;
+/// matchy_t *warm = matchy_open_with_options("GeoLite2-City.mmdb", &opts);
+///
+/// // Multi-GB feed on a sensor: open in O(header), set up sections on use
+/// opts.trusted = true;
+/// matchy_t *quick = matchy_open_with_options("threats.mxy", &opts);
 /// ```
 #[no_mangle]
 pub unsafe extern "C" fn matchy_open_with_options(
@@ -454,20 +787,47 @@ pub unsafe extern "C" fn matchy_open_with_options(
         Err(_) => return ptr::null_mut(),
     };
 
+    // Read the size before the rest: a struct from some other layout may be
+    // shorter than ours
+    if ptr::addr_of!((*options).struct_size).read() as usize
+        != mem::size_of::<matchy_open_options_t>()
+    {
+        return ptr::null_mut();
+    }
     let opts = &*options;
+    let Some(cache_policy) = CachePolicy::from_u32(opts.cache_policy) else {
+        return ptr::null_mut();
+    };
 
     // Build database using fluent API
-    let mut opener = RustDatabase::from(path);
+    let mut opener = RustDatabase::from(path).cache_policy(cache_policy);
 
     if opts.cache_capacity == 0 {
         opener = opener.no_cache();
     } else {
         opener = opener.cache_capacity(opts.cache_capacity as usize);
     }
+    opener = opener
+        .negative_cache(opts.negative_cache_capacity as usize)
+        .concurrency(opts.concurrency as usize)
+        .ipv4_direct_index(opts.ipv4_direct_index)
+        .prefault(opts.prefault)
+        .lock_memory(opts.lock_memory)
+        .huge_pages(opts.huge_pages)
+        .trusted(opts.trusted);
+    if opts.profile_sample_rate > 0 {
+        opener = opener.profiler(Arc::new(QueryProfiler::with_concurrency(
+            opts.profile_sample_rate,
+            opts.concurrency as usize,
+        )));
+    }
 
-    match opener.open() {
+    match opener.open_reloadable() {
         Ok(db) => {
-            let internal = Box::new(MatchyInternal { database: db });
+            let internal = Box::new(MatchyInternal {
+                database: db.cache_warmup(opts.reload_warm_cache),
+                lazy_results: opts.lazy_results,
+            });
             matchy_t::from_internal(internal)
         }
         Err(_) => ptr::null_mut(),
@@ -530,7 +890,10 @@ pub unsafe extern "C" fn matchy_open_buffer(buffer: *const u8, size: usize) -> *
     let slice = slice::from_raw_parts(buffer, size);
     match RustDatabase::from_bytes(slice.to_vec()) {
         Ok(db) => {
-            let internal = Box::new(MatchyInternal { database: db });
+            let internal = Box::new(MatchyInternal {
+                database: ReloadableDatabase::from_database(db),
+                lazy_results: false,
+            });
             matchy_t::from_internal(internal)
         }
         Err(_) => ptr::null_mut(),
@@ -555,6 +918,14 @@ pub struct matchy_stats_t {
     pub ip_queries: u64,
     /// Number of string queries (literal or pattern)
     pub string_queries: u64,
+    /// Cache entries evicted to make room for new ones
+    pub cache_evictions: u64,
+    /// New cache entries refused by the admission filter
+    /// (MATCHY_CACHE_TINYLFU only; also counted in cache_evictions)
+    pub cache_rejections: u64,
+    /// Cache entries the policy kept or moved up instead of evicting
+    /// (CLOCK second chances, S3-FIFO and W-TinyLFU promotions)
+    pub cache_promotions: u64,
 }
 
 /// Get database statistics
@@ -591,7 +962,7 @@ pub unsafe extern "C" fn matchy_get_stats(db: *const matchy_t, stats: *mut match
     }
 
     let internal = matchy_t::as_internal(db);
-    let rust_stats = internal.database.stats();
+    let rust_stats = internal.database.current().stats();
 
     *stats = matchy_stats_t {
         total_queries: rust_stats.total_queries,
@@ -601,7 +972,139 @@ pub unsafe extern "C" fn matchy_get_stats(db: *const matchy_t, stats: *mut match
         cache_misses: rust_stats.cache_misses,
         ip_queries: rust_stats.ip_queries,
         string_queries: rust_stats.string_queries,
+        cache_evictions: rust_stats.cache_evictions,
+        cache_rejections: rust_stats.cache_rejections,
+        cache_promotions: rust_stats.cache_promotions,
+    };
+}
+
+/// Profile stage: IP tree walk (matchy_profile_t.stages index)
+pub const MATCHY_STAGE_IP_TREE: u32 = 0;
+/// Profile stage: literal hash lookup
+pub const MATCHY_STAGE_LITERAL_HASH: u32 = 1;
+/// Profile stage: Aho-Corasick pattern scan (excluding glob verification)
+pub const MATCHY_STAGE_PATTERN_SCAN: u32 = 2;
+/// Profile stage: glob verification of scan candidates
+pub const MATCHY_STAGE_GLOB_VERIFY: u32 = 3;
+/// Profile stage: result data decoding
+pub const MATCHY_STAGE_DATA_DECODE: u32 = 4;
+/// Number of profile stages
+pub const MATCHY_STAGE_COUNT: usize = QueryStage::COUNT;
+
+/// Latency summary of one query stage
+#[repr(C)]
+#[derive(Debug, Copy, Clone, Default)]
+pub struct matchy_stage_stats_t {
+    /// Sampled queries that ran this stage
+    pub samples: u64,
+    /// Total time spent in the stage across samples (nanoseconds)
+    pub total_ns: u64,
+    /// Median latency (nanoseconds, histogram bucket floor)
+    pub p50_ns: u64,
+    /// 90th percentile latency (nanoseconds)
+    pub p90_ns: u64,
+    /// 99th percentile latency (nanoseconds)
+    pub p99_ns: u64,
+    /// Largest latency seen (nanoseconds)
+    pub max_ns: u64,
+}
+
+impl From<&LatencyHistogram> for matchy_stage_stats_t {
+    fn from(histogram: &LatencyHistogram) -> Self {
+        Self {
+            samples: histogram.count(),
+            total_ns: histogram.total().as_nanos() as u64,
+            p50_ns: histogram.percentile_ns(0.50),
+            p90_ns: histogram.percentile_ns(0.90),
+            p99_ns: histogram.percentile_ns(0.99),
+            max_ns: histogram.max_ns(),
+        }
+    }
+}
+
+/// Sampled query profile
+///
+/// Only queries picked by profile_sample_rate contribute; counters cover
+/// those queries, not every query.
+#[repr(C)]
+#[derive(Debug, Copy, Clone, Default)]
+pub struct matchy_profile_t {
+    /// Queries that were sampled
+    pub sampled_queries: u64,
+    /// Per-stage latency, indexed by MATCHY_STAGE_*
+    pub stages: [matchy_stage_stats_t; MATCHY_STAGE_COUNT],
+    /// Aho-Corasick states entered, including failure transitions
+    pub ac_states_visited: u64,
+    /// Candidate patterns produced by the pattern scan
+    pub glob_candidates: u64,
+    /// Candidates run through glob verification
+    pub globs_checked: u64,
+    /// Candidates glob verification rejected
+    pub globs_rejected: u64,
+    /// Literal hash lookups sampled
+    pub literal_lookups: u64,
+    /// Literal hash slots examined by those lookups
+    pub literal_probes: u64,
+}
+
+/// Get the sampled query profile
+///
+/// Fills `profile` with per-stage latency percentiles and hot-path counters
+/// gathered since the database was opened with a non-zero
+/// profile_sample_rate. The profile carries over reloads.
+///
+/// # Parameters
+/// * `db` - Database handle (must not be NULL)
+/// * `profile` - Pointer to profile structure to fill (must not be NULL)
+///
+/// # Returns
+/// * MATCHY_SUCCESS on success
+/// * MATCHY_ERROR_INVALID_PARAM if a pointer is NULL
+/// * MATCHY_ERROR_NO_DATA if profiling was not enabled
+///
+/// # Safety
+/// * `db` must be a valid pointer from matchy_open
+/// * `profile` must be a valid pointer to matchy_profile_t
+///
+/// # Example
+/// ```c
+/// matchy_profile_t prof;
+/// if (matchy_get_profile(db, &prof) == MATCHY_SUCCESS) {
+///     const matchy_stage_stats_t *scan = &prof.stages[MATCHY_STAGE_PATTERN_SCAN];
+///     printf("pattern scan p99: %llu ns\n", scan->p99_ns);
+/// }
+/// ```
+#[no_mangle]
+pub unsafe extern "C" fn matchy_get_profile(
+    db: *const matchy_t,
+    profile: *mut matchy_profile_t,
+) -> i32 {
+    if db.is_null() || profile.is_null() {
+        return MATCHY_ERROR_INVALID_PARAM;
+    }
+
+    let internal = matchy_t::as_internal(db);
+    let database = internal.database.current();
+    let Some(profiler) = database.profiler() else {
+        return MATCHY_ERROR_NO_DATA;
+    };
+    let snapshot = profiler.snapshot();
+
+    let mut stages = [matchy_stage_stats_t::default(); MATCHY_STAGE_COUNT];
+    for (out, histogram) in stages.iter_mut().zip(snapshot.stages.iter()) {
+        *out = histogram.into();
+    }
+    *profile = matchy_profile_t {
+        sampled_queries: snapshot.sampled_queries,
+        stages,
+        ac_states_visited: snapshot.ac_states_visited,
+        glob_candidates: snapshot.glob_candidates,
+        globs_checked: snapshot.globs_checked,
+        globs_rejected: snapshot.globs_rejected,
+        literal_lookups: snapshot.literal_lookups,
+        literal_probes: snapshot.literal_probes,
     };
+    MATCHY_SUCCESS
 }
 
 /// Clear the query cache
@@ -630,7 +1133,7 @@ pub unsafe extern "C" fn matchy_clear_cache(db: *const matchy_t) {
     }
 
     let internal = matchy_t::as_internal(db);
-    internal.database.clear_cache();
+    internal.database.current().clear_cache();
 }
 
 /// Close database
@@ -657,6 +1160,88 @@ pub unsafe extern "C" fn matchy_close(db: *mut matchy_t) {
     }
 }
 
+/// Atomically replace the database behind a handle
+///
+/// Opens `filename` (or, if NULL, the file the handle was opened from)
+/// with the handle's original options and swaps it in while other threads
+/// keep querying. Queries already running finish on the old file; queries
+/// that start after the swap see the new one, so none are dropped. With
+/// `reload_warm_cache` set, the new cache is filled from the old one's
+/// most recently used queries before the swap. Statistics carry over.
+///
+/// Lazy results obtained before the reload stay valid until they are
+/// freed. Replace files by renaming a new file over the old path rather
+/// than rewriting it in place.
+///
+/// # Parameters
+/// * `db` - Database handle (must not be NULL)
+/// * `filename` - Path of the new database (null-terminated C string), or
+///   NULL to reopen the current path
+///
+/// # Returns
+/// * MATCHY_SUCCESS (0) on success
+/// * MATCHY_ERROR_INVALID_PARAM if `db` is NULL or `filename` is not UTF-8
+/// * MATCHY_ERROR_FILE_NOT_FOUND if `filename` does not exist
+/// * MATCHY_ERROR_IO or MATCHY_ERROR_INVALID_FORMAT if the new file can't
+///   be opened; the handle keeps serving the old file
+///
+/// # Safety
+/// * `db` must be a valid pointer from matchy_open
+/// * `filename` must be NULL or a valid null-terminated C string
+///
+/// # Example
+/// ```c
+/// // Feed updater thread, every 5 minutes
+/// rename("threats.mxy.new", "threats.mxy");
+/// if (matchy_reload(db, NULL) != MATCHY_SUCCESS) {
+///     fprintf(stderr, "Reload failed, still serving generation %llu\n",
+///             (unsigned long long)matchy_generation(db));
+/// }
+/// ```
+#[no_mangle]
+pub unsafe extern "C" fn matchy_reload(db: *const matchy_t, filename: *const c_char) -> i32 {
+    if db.is_null() {
+        return MATCHY_ERROR_INVALID_PARAM;
+    }
+
+    let internal = matchy_t::as_internal(db);
+    let reloaded = if filename.is_null() {
+        internal.database.reload()
+    } else {
+        match CStr::from_ptr(filename).to_str() {
+            Ok(path) if !std::path::Path::new(path).exists() => return MATCHY_ERROR_FILE_NOT_FOUND,
+            Ok(path) => internal.database.reload_from(path),
+            Err(_) => return MATCHY_ERROR_INVALID_PARAM,
+        }
+    };
+
+    match reloaded {
+        Ok(_) => MATCHY_SUCCESS,
+        Err(DatabaseError::Io(_)) => MATCHY_ERROR_IO,
+        Err(_) => MATCHY_ERROR_INVALID_FORMAT,
+    }
+}
+
+/// Number of successful matchy_reload() calls on a handle
+///
+/// # Parameters
+/// * `db` - Database handle (must not be NULL)
+///
+/// # Returns
+/// * 0 for a handle that was never reloaded, or if db is NULL
+///
+/// # Safety
+/// * `db` must be a valid pointer from matchy_open
+#[no_mangle]
+pub unsafe extern "C" fn matchy_generation(db: *const matchy_t) -> u64 {
+    if db.is_null() {
+        return 0;
+    }
+
+    let internal = matchy_t::as_internal(db);
+    internal.database.generation()
+}
+
 /// Unified query interface - automatically detects IP vs pattern
 ///
 /// Queries the database with an IP address or pattern. The function automatically
@@ -701,126 +1286,500 @@ pub unsafe extern "C" fn matchy_query(
     query: *const c_char,
 ) -> matchy_result_t {
     if db.is_null() || query.is_null() {
-        return matchy_result_t {
-            found: false,
-            prefix_len: 0,
-            _data_cache: ptr::null_mut(),
-            _db_ref: ptr::null(),
-        };
+        return matchy_result_t::not_found();
     }
 
     let query_str = match CStr::from_ptr(query).to_str() {
         Ok(s) => s,
-        Err(_) => {
-            return matchy_result_t {
-                found: false,
-                prefix_len: 0,
-                _data_cache: ptr::null_mut(),
-                _db_ref: ptr::null(),
-            }
-        }
+        Err(_) => return matchy_result_t::not_found(),
     };
 
     let internal = matchy_t::as_internal(db);
-    match internal.database.lookup(query_str) {
-        Ok(Some(QueryResult::Ip { data, prefix_len })) => {
-            // Cache the DataValue for structured access
-            let data_cache = Box::new(data);
-            let data_cache_ptr = Box::into_raw(data_cache) as *mut ();
-
-            matchy_result_t {
-                found: true,
-                prefix_len,
-                _data_cache: data_cache_ptr,
-                _db_ref: db,
-            }
-        }
-        Ok(Some(QueryResult::Pattern {
-            pattern_ids: _,
-            data,
-        })) => {
-            // For patterns, return the first match's data
-            if let Some(Some(first_data)) = data.first() {
-                let data_cache = Box::new(first_data.clone());
-                let data_cache_ptr = Box::into_raw(data_cache) as *mut ();
-
-                return matchy_result_t {
-                    found: true,
-                    prefix_len: 0,
-                    _data_cache: data_cache_ptr,
-                    _db_ref: db,
-                };
-            }
-            matchy_result_t {
-                found: false,
-                prefix_len: 0,
-                _data_cache: ptr::null_mut(),
-                _db_ref: ptr::null(),
-            }
-        }
-        _ => matchy_result_t {
-            found: false,
-            prefix_len: 0,
-            _data_cache: ptr::null_mut(),
-            _db_ref: ptr::null(),
-        },
-    }
+    matchy_result_t::query(db, internal, &internal.database.current(), query_str)
 }
 
-/// Free query result
+/// Query the database with a length-delimited key
 ///
-/// Frees the memory allocated for a query result.
+/// Same as matchy_query(), but the key is given as a pointer and length, so
+/// it can be passed in place from a larger buffer (a packet, a log line, a
+/// `std::string_view`) without copying it into a null-terminated temporary.
 ///
 /// # Parameters
-/// * `result` - Pointer to result from matchy_query (must not be NULL)
+/// * `db` - Database handle (must not be NULL)
+/// * `key` - Key bytes (need not be null-terminated; may be NULL if `len` is 0)
+/// * `len` - Key length in bytes
+///
+/// # Returns
+/// * Query result (same as matchy_query)
+/// * A not-found result if `key` is not valid UTF-8
 ///
 /// # Safety
-/// * `result` must be a valid pointer to a result from matchy_query
-/// * Must not be called twice on the same result
+/// * `db` must be a valid pointer from matchy_open
+/// * `key` must be valid for reading `len` bytes
+///
+/// # Example
+/// ```c
+/// const char *line = "src=10.1.2.3 dst=evil.example.com";
+/// matchy_result_t result = matchy_query_n(db, (const uint8_t *)line + 4, 8);
+/// if (result.found) {
+///     // 10.1.2.3 matched
+/// }
+/// matchy_free_result(&result);
+/// ```
 #[no_mangle]
-pub unsafe extern "C" fn matchy_free_result(result: *mut matchy_result_t) {
-    if !result.is_null() && !(*result)._data_cache.is_null() {
-        // Free the cached DataValue
-        let _ = Box::from_raw((*result)._data_cache as *mut DataValue);
-        (*result)._data_cache = ptr::null_mut();
+pub unsafe extern "C" fn matchy_query_n(
+    db: *const matchy_t,
+    key: *const u8,
+    len: usize,
+) -> matchy_result_t {
+    if db.is_null() || (key.is_null() && len > 0) {
+        return matchy_result_t::not_found();
     }
+
+    let bytes = if len == 0 {
+        &[][..]
+    } else {
+        slice::from_raw_parts(key, len)
+    };
+    let query_str = match std::str::from_utf8(bytes) {
+        Ok(s) => s,
+        Err(_) => return matchy_result_t::not_found(),
+    };
+
+    let internal = matchy_t::as_internal(db);
+    matchy_result_t::query(db, internal, &internal.database.current(), query_str)
 }
 
-/// Free a string returned by matchy
+/// Address family for matchy_query_ip(): 4-byte IPv4 address
+pub const MATCHY_FAMILY_IPV4: i32 = 4;
+/// Address family for matchy_query_ip(): 16-byte IPv6 address
+pub const MATCHY_FAMILY_IPV6: i32 = 6;
+
+/// Query the database with a binary IP address
+///
+/// Looks up an address in network byte order, as found in packet headers
+/// or `struct in_addr` / `struct in6_addr`, without formatting or parsing
+/// it as text. Only IP data is searched.
 ///
 /// # Parameters
-/// * `string` - String pointer returned by matchy (may be NULL)
+/// * `db` - Database handle (must not be NULL)
+/// * `addr` - Address bytes in network order (must not be NULL): the first
+///   4 bytes for MATCHY_FAMILY_IPV4, all 16 for MATCHY_FAMILY_IPV6
+/// * `family` - MATCHY_FAMILY_IPV4 or MATCHY_FAMILY_IPV6
+///
+/// # Returns
+/// * Query result (same as matchy_query)
+/// * A not-found result if `family` is not recognized
 ///
 /// # Safety
-/// * `string` must be NULL or a pointer returned by matchy
-/// * Must not be called twice on the same pointer
+/// * `db` must be a valid pointer from matchy_open
+/// * `addr` must be valid for reading 4 (IPv4) or 16 (IPv6) bytes
+///
+/// # Example
+/// ```c
+/// struct in_addr src = ip_header->ip_src;
+/// matchy_result_t result = matchy_query_ip(db, (const uint8_t *)&src, MATCHY_FAMILY_IPV4);
+/// if (result.found) {
+///     printf("matched /%u\n", result.prefix_len);
+/// }
+/// matchy_free_result(&result);
+/// ```
 #[no_mangle]
-pub unsafe extern "C" fn matchy_free_string(string: *mut c_char) {
-    if !string.is_null() {
-        let _ = CString::from_raw(string);
+pub unsafe extern "C" fn matchy_query_ip(
+    db: *const matchy_t,
+    addr: *const u8,
+    family: i32,
+) -> matchy_result_t {
+    if db.is_null() || addr.is_null() {
+        return matchy_result_t::not_found();
     }
-}
 
-/// Get library version string
-///
-/// # Returns
-/// * Version string (e.g., "0.4.0")
-/// * Pointer is valid for program lifetime, do not free
-#[no_mangle]
-pub extern "C" fn matchy_version() -> *const c_char {
-    // Use the version from Cargo.toml, automatically updated at compile time
-    concat!(env!("CARGO_PKG_VERSION"), "\0").as_ptr() as *const c_char
+    let ip = match family {
+        MATCHY_FAMILY_IPV4 => IpAddr::V4(Ipv4Addr::from(*(addr as *const [u8; 4]))),
+        MATCHY_FAMILY_IPV6 => IpAddr::V6(Ipv6Addr::from(*(addr as *const [u8; 16]))),
+        _ => return matchy_result_t::not_found(),
+    };
+
+    let internal = matchy_t::as_internal(db);
+    matchy_result_t::query_ip(db, internal, &internal.database.current(), ip)
 }
 
-/// Get database format description
+/// Query the database with many keys in one call
+///
+/// Equivalent to calling matchy_query() on each key, but the per-call work
+/// is amortized over the batch: IP keys are walked through the search tree
+/// together with interleaved prefetching, string keys share one
+/// pattern-matching scratch, and statistics are updated once.
 ///
 /// # Parameters
 /// * `db` - Database handle (must not be NULL)
+/// * `keys` - Array of `n` key pointers (must not be NULL; entries must not be NULL)
+/// * `lens` - Array of `n` key lengths in bytes, or NULL if every key is
+///   null-terminated. Keys with explicit lengths need not be null-terminated.
+/// * `n` - Number of keys
+/// * `out` - Array of `n` results to fill (must not be NULL)
 ///
 /// # Returns
-/// * Format string ("IP database", "Pattern database", or "Combined IP+Pattern database")
-/// * Pointer is valid for database lifetime, do not free
-/// * NULL if db is NULL
+/// * MATCHY_SUCCESS (0) on success; `out[i]` holds the result for `keys[i]`
+/// * MATCHY_ERROR_INVALID_PARAM if a required pointer is NULL (`out` untouched)
+///
+/// Keys that are NULL or not valid UTF-8 produce a not-found result.
+/// Every result must be freed with matchy_free_result().
+///
+/// # Safety
+/// * `db` must be a valid pointer from matchy_open
+/// * `keys` must point to `n` readable key pointers, each valid for
+///   `lens[i]` bytes (or null-terminated when `lens` is NULL)
+/// * `lens`, if not NULL, must point to `n` readable lengths
+/// * `out` must point to `n` writable results
+///
+/// # Example
+/// ```c
+/// const char *keys[] = {"1.2.3.4", "evil.example.com", "10.0.0.1"};
+/// matchy_result_t results[3];
+///
+/// if (matchy_query_batch(db, keys, NULL, 3, results) == MATCHY_SUCCESS) {
+///     for (size_t i = 0; i < 3; i++) {
+///         if (results[i].found) {
+///             printf("%s matched\n", keys[i]);
+///         }
+///         matchy_free_result(&results[i]);
+///     }
+/// }
+/// ```
+#[no_mangle]
+pub unsafe extern "C" fn matchy_query_batch(
+    db: *const matchy_t,
+    keys: *const *const c_char,
+    lens: *const usize,
+    n: usize,
+    out: *mut matchy_result_t,
+) -> i32 {
+    if n == 0 {
+        return MATCHY_SUCCESS;
+    }
+    if db.is_null() || keys.is_null() || out.is_null() {
+        return MATCHY_ERROR_INVALID_PARAM;
+    }
+
+    let keys = slice::from_raw_parts(keys, n);
+    let lens = if lens.is_null() {
+        None
+    } else {
+        Some(slice::from_raw_parts(lens, n))
+    };
+    let out = slice::from_raw_parts_mut(out, n);
+
+    // Validate keys once up front; invalid ones are answered directly
+    let mut queries: Vec<&str> = Vec::with_capacity(n);
+    let mut positions: Vec<usize> = Vec::with_capacity(n);
+    for (i, &key) in keys.iter().enumerate() {
+        out[i] = matchy_result_t::not_found();
+        if key.is_null() {
+            continue;
+        }
+        let bytes = match lens {
+            Some(lens) => slice::from_raw_parts(key as *const u8, lens[i]),
+            None => CStr::from_ptr(key).to_bytes(),
+        };
+        if let Ok(query) = std::str::from_utf8(bytes) {
+            queries.push(query);
+            positions.push(i);
+        }
+    }
+
+    // The whole batch is answered by one version of the database
+    let internal = matchy_t::as_internal(db);
+    let current = internal.database.current();
+    if internal.lazy(&current) {
+        for (position, query) in positions.into_iter().zip(queries) {
+            out[position] = matchy_result_t::query(db, internal, &current, query);
+        }
+        return MATCHY_SUCCESS;
+    }
+
+    let mut results = Vec::with_capacity(queries.len());
+    current.lookup_batch(&queries, &mut results);
+
+    for (position, result) in positions.into_iter().zip(results) {
+        out[position] = matchy_result_t::from_lookup(db, result);
+    }
+
+    MATCHY_SUCCESS
+}
+
+/// Query the database with many binary IP addresses, walking them in address order
+///
+/// Equivalent to calling matchy_query_ip() on each address, but built for
+/// bulk enrichment: the addresses are sorted and the search tree is walked
+/// once from low to high, each lookup resuming where it leaves the previous
+/// address's path, and each data record is decoded once per run of
+/// addresses that share it. The query cache is bypassed.
+///
+/// # Parameters
+/// * `db` - Database handle (must not be NULL)
+/// * `addrs` - `n` addresses in network order, packed back to back: 4 bytes
+///   each for MATCHY_FAMILY_IPV4, 16 for MATCHY_FAMILY_IPV6 (must not be NULL)
+/// * `family` - MATCHY_FAMILY_IPV4 or MATCHY_FAMILY_IPV6
+/// * `n` - Number of addresses
+/// * `out` - Array of `n` results to fill (must not be NULL)
+///
+/// # Returns
+/// * MATCHY_SUCCESS (0) on success; `out[i]` holds the result for address `i`
+/// * MATCHY_ERROR_INVALID_PARAM if a required pointer is NULL, `family`
+///   is not recognized, or `n` addresses overflow the address space
+///   (`out` untouched)
+///
+/// Every result must be freed with matchy_free_result().
+///
+/// # Safety
+/// * `db` must be a valid pointer from matchy_open
+/// * `addrs` must be valid for reading `n` addresses of `family`'s size
+/// * `out` must point to `n` writable results
+///
+/// # Example
+/// ```c
+/// uint32_t addrs[1024];   // IPv4 addresses in network order
+/// matchy_result_t results[1024];
+///
+/// if (matchy_query_ips(db, (const uint8_t *)addrs, MATCHY_FAMILY_IPV4, 1024, results) == MATCHY_SUCCESS) {
+///     for (size_t i = 0; i < 1024; i++) {
+///         matchy_free_result(&results[i]);
+///     }
+/// }
+/// ```
+#[no_mangle]
+pub unsafe extern "C" fn matchy_query_ips(
+    db: *const matchy_t,
+    addrs: *const u8,
+    family: i32,
+    n: usize,
+    out: *mut matchy_result_t,
+) -> i32 {
+    let width = match family {
+        MATCHY_FAMILY_IPV4 => 4,
+        MATCHY_FAMILY_IPV6 => 16,
+        _ => return MATCHY_ERROR_INVALID_PARAM,
+    };
+    if n == 0 {
+        return MATCHY_SUCCESS;
+    }
+    if db.is_null() || addrs.is_null() || out.is_null() {
+        return MATCHY_ERROR_INVALID_PARAM;
+    }
+
+    let Some(len) = n.checked_mul(width) else {
+        return MATCHY_ERROR_INVALID_PARAM;
+    };
+    let chunks = slice::from_raw_parts(addrs, len).chunks_exact(width);
+    let ips: Vec<IpAddr> = if width == 4 {
+        chunks
+            .map(|b| IpAddr::V4(Ipv4Addr::new(b[0], b[1], b[2], b[3])))
+            .collect()
+    } else {
+        chunks
+            .map(|b| IpAddr::V6(Ipv6Addr::from(<[u8; 16]>::try_from(b).unwrap())))
+            .collect()
+    };
+    let out = slice::from_raw_parts_mut(out, n);
+
+    // The whole batch is answered by one version of the database
+    let internal = matchy_t::as_internal(db);
+    let current = internal.database.current();
+    if internal.lazy(&current) {
+        let mut refs = Vec::with_capacity(n);
+        // On failure, fall through and answer from decoded lookups instead
+        if current.lookup_ip_refs_sorted(&ips, &mut refs).is_ok() {
+            for (slot, found) in out.iter_mut().zip(refs) {
+                *slot = match found {
+                    Some(data) => matchy_result_t::lazy(db, &current, data),
+                    None => matchy_result_t::not_found(),
+                };
+            }
+            return MATCHY_SUCCESS;
+        }
+    }
+
+    let mut results = Vec::with_capacity(n);
+    current.lookup_ips_sorted(&ips, &mut results);
+    for (slot, result) in out.iter_mut().zip(results) {
+        *slot = matchy_result_t::from_lookup(db, result);
+    }
+
+    MATCHY_SUCCESS
+}
+
+/// One network delivered by matchy_foreach_network()
+#[repr(C)]
+pub struct matchy_network_t {
+    /// First address of the network in network order: the first 4 bytes
+    /// for MATCHY_FAMILY_IPV4, all 16 for MATCHY_FAMILY_IPV6
+    pub addr: [u8; 16],
+    /// MATCHY_FAMILY_IPV4 or MATCHY_FAMILY_IPV6
+    pub family: i32,
+    /// Network prefix length (CIDR)
+    pub prefix_len: u8,
+    /// The network's data; valid only until the callback returns
+    pub result: matchy_result_t,
+}
+
+/// Callback receiving each network from matchy_foreach_network()
+///
+/// Return 0 to continue, anything else to stop.
+#[allow(non_camel_case_types)]
+pub type matchy_network_callback_t =
+    Option<unsafe extern "C" fn(network: *const matchy_network_t, ctx: *mut c_void) -> i32>;
+
+/// Visit every network in the database's IP tree, in address order
+///
+/// Walks the search tree once and calls `callback` for each network that
+/// has data, which makes dumping or re-indexing a whole database a single
+/// pass with no per-network lookups. A network with more specific networks
+/// inside it is delivered as the pieces around them; IPv4 networks of
+/// IPv6 databases are delivered as IPv4. Each network's result references
+/// the data in place and supports the usual matchy_aget_value() /
+/// matchy_get_entry_data_list() accessors; it must not be freed.
+///
+/// # Parameters
+/// * `db` - Database handle (must not be NULL)
+/// * `callback` - Called for each network (must not be NULL)
+/// * `ctx` - Passed through to `callback`
+///
+/// # Returns
+/// * Number of networks delivered (>= 0), including the one that stopped the walk
+/// * MATCHY_ERROR_INVALID_PARAM if `db` or `callback` is NULL
+/// * MATCHY_ERROR_NO_DATA if the database has no IP data or has overlays
+/// * MATCHY_ERROR_CORRUPT_DATA if the tree is malformed
+///
+/// # Safety
+/// * `db` must be a valid pointer from matchy_open
+///
+/// # Example
+/// ```c
+/// int32_t print_network(const matchy_network_t *network, void *ctx) {
+///     char text[INET6_ADDRSTRLEN];
+///     int af = network->family == MATCHY_FAMILY_IPV4 ? AF_INET : AF_INET6;
+///     inet_ntop(af, network->addr, text, sizeof(text));
+///     printf("%s/%u\n", text, network->prefix_len);
+///     return 0;
+/// }
+///
+/// int64_t count = matchy_foreach_network(db, print_network, NULL);
+/// ```
+#[no_mangle]
+pub unsafe extern "C" fn matchy_foreach_network(
+    db: *const matchy_t,
+    callback: matchy_network_callback_t,
+    ctx: *mut c_void,
+) -> i64 {
+    let callback = match callback {
+        Some(callback) if !db.is_null() => callback,
+        _ => return MATCHY_ERROR_INVALID_PARAM as i64,
+    };
+
+    // Pin one version for the whole walk
+    let current = matchy_t::as_internal(db).database.snapshot();
+    let networks = match current.networks() {
+        Ok(networks) => networks,
+        Err(_) => return MATCHY_ERROR_NO_DATA as i64,
+    };
+
+    let mut delivered = 0i64;
+    for network in networks {
+        let (addr, data) = match network {
+            Ok(network) => network,
+            Err(_) => return MATCHY_ERROR_CORRUPT_DATA as i64,
+        };
+        let mut bytes = [0u8; 16];
+        let family = match addr {
+            IpAddr::V4(v4) => {
+                bytes[..4].copy_from_slice(&v4.octets());
+                MATCHY_FAMILY_IPV4
+            }
+            IpAddr::V6(v6) => {
+                bytes = v6.octets();
+                MATCHY_FAMILY_IPV6
+            }
+        };
+        let mut found = matchy_network_t {
+            addr: bytes,
+            family,
+            prefix_len: data.prefix_len,
+            result: matchy_result_t::lazy(db, &current, data),
+        };
+        let stop = callback(&found, ctx) != 0;
+        matchy_free_result(&mut found.result);
+        delivered += 1;
+        if stop {
+            break;
+        }
+    }
+
+    delivered
+}
+
+/// Free query result
+///
+/// Frees the memory allocated for a query result.
+///
+/// # Parameters
+/// * `result` - Pointer to result from matchy_query (must not be NULL)
+///
+/// # Safety
+/// * `result` must be a valid pointer to a result from matchy_query
+/// * Must not be called twice on the same result
+#[no_mangle]
+pub unsafe extern "C" fn matchy_free_result(result: *mut matchy_result_t) {
+    if result.is_null() {
+        return;
+    }
+    if !(*result)._data_cache.is_null() {
+        // Free the cached DataValue
+        let _ = Box::from_raw((*result)._data_cache as *mut DataValue);
+        (*result)._data_cache = ptr::null_mut();
+    }
+    if !(*result)._db_version.is_null() {
+        // Release the lazy result's database version
+        drop(Arc::from_raw((*result)._db_version as *const RustDatabase));
+        (*result)._db_version = ptr::null();
+    }
+}
+
+/// Free a string returned by matchy
+///
+/// # Parameters
+/// * `string` - String pointer returned by matchy (may be NULL)
+///
+/// # Safety
+/// * `string` must be NULL or a pointer returned by matchy
+/// * Must not be called twice on the same pointer
+#[no_mangle]
+pub unsafe extern "C" fn matchy_free_string(string: *mut c_char) {
+    if !string.is_null() {
+        let _ = CString::from_raw(string);
+    }
+}
+
+/// Get library version string
+///
+/// # Returns
+/// * Version string (e.g., "0.4.0")
+/// * Pointer is valid for program lifetime, do not free
+#[no_mangle]
+pub extern "C" fn matchy_version() -> *const c_char {
+    // Use the version from Cargo.toml, automatically updated at compile time
+    concat!(env!("CARGO_PKG_VERSION"), "\0").as_ptr() as *const c_char
+}
+
+/// Get database format description
+///
+/// # Parameters
+/// * `db` - Database handle (must not be NULL)
+///
+/// # Returns
+/// * Format string ("IP database", "Pattern database", or "Combined IP+Pattern database")
+/// * Pointer is valid for database lifetime, do not free
+/// * NULL if db is NULL
 ///
 /// # Safety
 /// * `db` must be a valid pointer from matchy_open
@@ -831,7 +1790,7 @@ pub unsafe extern "C" fn matchy_format(db: *const matchy_t) -> *const c_char {
     }
 
     let internal = matchy_t::as_internal(db);
-    let format_str = internal.database.format();
+    let format_str = internal.database.current().format();
     format_str.as_ptr() as *const c_char
 }
 
@@ -853,7 +1812,7 @@ pub unsafe extern "C" fn matchy_has_ip_data(db: *const matchy_t) -> bool {
     }
 
     let internal = matchy_t::as_internal(db);
-    internal.database.has_ip_data()
+    internal.database.current().has_ip_data()
 }
 
 /// Check if database supports string lookups (literals or globs)
@@ -874,7 +1833,7 @@ pub unsafe extern "C" fn matchy_has_string_data(db: *const matchy_t) -> bool {
     }
 
     let internal = matchy_t::as_internal(db);
-    internal.database.has_string_data()
+    internal.database.current().has_string_data()
 }
 
 /// Check if database supports literal (exact string) lookups
@@ -895,7 +1854,7 @@ pub unsafe extern "C" fn matchy_has_literal_data(db: *const matchy_t) -> bool {
     }
 
     let internal = matchy_t::as_internal(db);
-    internal.database.has_literal_data()
+    internal.database.current().has_literal_data()
 }
 
 /// Check if database supports glob pattern lookups
@@ -916,7 +1875,7 @@ pub unsafe extern "C" fn matchy_has_glob_data(db: *const matchy_t) -> bool {
     }
 
     let internal = matchy_t::as_internal(db);
-    internal.database.has_glob_data()
+    internal.database.current().has_glob_data()
 }
 
 /// Check if database supports pattern matching (deprecated)
@@ -944,7 +1903,7 @@ pub unsafe extern "C" fn matchy_has_pattern_data(db: *const matchy_t) -> bool {
     }
 
     let internal = matchy_t::as_internal(db);
-    internal.database.has_string_data()
+    internal.database.current().has_string_data()
 }
 
 /// Get database metadata as JSON string
@@ -967,7 +1926,7 @@ pub unsafe extern "C" fn matchy_metadata(db: *const matchy_t) -> *mut c_char {
     }
 
     let internal = matchy_t::as_internal(db);
-    match internal.database.metadata() {
+    match internal.database.current().metadata() {
         Some(metadata) => {
             // Convert metadata to JSON string
             match serde_json::to_string(&metadata) {
@@ -1009,7 +1968,7 @@ pub unsafe extern "C" fn matchy_get_pattern_string(
     let internal = matchy_t::as_internal(db);
 
     // Get pattern string from database
-    if let Some(pattern_str) = internal.database.get_pattern_string(pattern_id) {
+    if let Some(pattern_str) = internal.database.current().get_pattern_string(pattern_id) {
         match CString::new(pattern_str) {
             Ok(c_str) => return c_str.into_raw(),
             Err(_) => return ptr::null_mut(),
@@ -1039,7 +1998,7 @@ pub unsafe extern "C" fn matchy_pattern_count(db: *const matchy_t) -> usize {
     }
 
     let internal = matchy_t::as_internal(db);
-    internal.database.pattern_count()
+    internal.database.current().pattern_count()
 }
 
 // ============================================================================
@@ -1114,6 +2073,7 @@ pub union matchy_entry_data_value_u {
 
 /// Entry data structure (like MMDB_entry_data_s)
 #[repr(C)]
+#[derive(Copy, Clone)]
 pub struct matchy_entry_data_t {
     /// Whether data was found
     pub has_data: bool,
@@ -1138,6 +2098,7 @@ pub struct matchy_entry_s {
 
 /// Entry data list node (like MMDB_entry_data_list_s)
 #[repr(C)]
+#[derive(Copy, Clone)]
 pub struct matchy_entry_data_list_t {
     /// The entry data for this node
     pub entry_data: matchy_entry_data_t,
@@ -1160,22 +2121,35 @@ impl matchy_entry_data_t {
     /// Convert DataValue to entry_data_t
     /// Strings are stored in the cache to keep them alive
     unsafe fn from_data_value(value: &DataValue, string_cache: &mut Vec<CString>) -> Option<Self> {
+        Self::from_data_value_with(value, &mut |s| {
+            let c_str = CString::new(s).ok()?;
+            let ptr = c_str.as_ptr();
+            string_cache.push(c_str);
+            Some(ptr)
+        })
+    }
+
+    /// Convert DataValue to entry_data_t, storing strings with `intern`
+    ///
+    /// `intern` returns a null-terminated copy that outlives the entry, or
+    /// None if the string cannot be represented (interior NUL).
+    fn from_data_value_with(
+        value: &DataValue,
+        intern: &mut dyn FnMut(&str) -> Option<*const c_char>,
+    ) -> Option<Self> {
         let (type_, data_value, data_size) = match value {
             DataValue::Pointer(offset) => (
                 MATCHY_DATA_TYPE_POINTER,
                 matchy_entry_data_value_u { pointer: *offset },
                 0,
             ),
-            DataValue::String(s) => {
-                let c_str = CString::new(s.as_str()).ok()?;
-                let ptr = c_str.as_ptr();
-                string_cache.push(c_str);
-                (
-                    MATCHY_DATA_TYPE_UTF8_STRING,
-                    matchy_entry_data_value_u { utf8_string: ptr },
-                    s.len() as u32,
-                )
-            }
+            DataValue::String(s) => (
+                MATCHY_DATA_TYPE_UTF8_STRING,
+                matchy_entry_data_value_u {
+                    utf8_string: intern(s.as_str())?,
+                },
+                s.len() as u32,
+            ),
             DataValue::Double(d) => (
                 MATCHY_DATA_TYPE_DOUBLE,
                 matchy_entry_data_value_u { double_value: *d },
@@ -1247,6 +2221,87 @@ impl matchy_entry_data_t {
             offset: 0,
         })
     }
+
+    /// Convert an in-place decoded value at `offset` to entry_data_t
+    ///
+    /// Strings and bytes point into the database's data section: they stay
+    /// valid until the database is closed and strings are not null-terminated.
+    fn from_value_ref(value: ValueRef<'_>, offset: u32) -> Self {
+        let (type_, data_value, data_size) = match value {
+            ValueRef::String(s) => (
+                MATCHY_DATA_TYPE_UTF8_STRING,
+                matchy_entry_data_value_u {
+                    utf8_string: s.as_ptr() as *const c_char,
+                },
+                s.len() as u32,
+            ),
+            ValueRef::Double(d) => (
+                MATCHY_DATA_TYPE_DOUBLE,
+                matchy_entry_data_value_u { double_value: d },
+                8,
+            ),
+            ValueRef::Bytes(b) => (
+                MATCHY_DATA_TYPE_BYTES,
+                matchy_entry_data_value_u { bytes: b.as_ptr() },
+                b.len() as u32,
+            ),
+            ValueRef::Uint16(n) => (
+                MATCHY_DATA_TYPE_UINT16,
+                matchy_entry_data_value_u { uint16: n },
+                2,
+            ),
+            ValueRef::Uint32(n) => (
+                MATCHY_DATA_TYPE_UINT32,
+                matchy_entry_data_value_u { uint32: n },
+                4,
+            ),
+            ValueRef::Map(len) => (
+                MATCHY_DATA_TYPE_MAP,
+                matchy_entry_data_value_u { uint32: 0 },
+                len as u32,
+            ),
+            ValueRef::Int32(n) => (
+                MATCHY_DATA_TYPE_INT32,
+                matchy_entry_data_value_u { int32: n },
+                4,
+            ),
+            ValueRef::Uint64(n) => (
+                MATCHY_DATA_TYPE_UINT64,
+                matchy_entry_data_value_u { uint64: n },
+                8,
+            ),
+            ValueRef::Uint128(n) => (
+                MATCHY_DATA_TYPE_UINT128,
+                matchy_entry_data_value_u {
+                    uint128: n.to_be_bytes(),
+                },
+                16,
+            ),
+            ValueRef::Array(len) => (
+                MATCHY_DATA_TYPE_ARRAY,
+                matchy_entry_data_value_u { uint32: 0 },
+                len as u32,
+            ),
+            ValueRef::Bool(b) => (
+                MATCHY_DATA_TYPE_BOOLEAN,
+                matchy_entry_data_value_u { boolean: b },
+                1,
+            ),
+            ValueRef::Float(f) => (
+                MATCHY_DATA_TYPE_FLOAT,
+                matchy_entry_data_value_u { float_value: f },
+                4,
+            ),
+        };
+
+        Self {
+            has_data: true,
+            type_,
+            value: data_value,
+            data_size,
+            offset,
+        }
+    }
 }
 
 /// Navigate into DataValue using a path of string keys
@@ -1267,6 +2322,73 @@ fn navigate_path<'a>(mut value: &'a DataValue, path: &[&str]) -> Option<&'a Data
     Some(value)
 }
 
+/// Flatten a decoded value into list nodes, parents before children
+///
+/// Map keys are not listed. Strings are stored with `intern`.
+fn flatten_data(
+    value: &DataValue,
+    intern: &mut dyn FnMut(&str) -> Option<*const c_char>,
+    add_node: &mut dyn FnMut(matchy_entry_data_t),
+) {
+    // Add the current node
+    if let Some(entry_data) = matchy_entry_data_t::from_data_value_with(value, intern) {
+        add_node(entry_data);
+    }
+
+    // Recursively add children
+    match value {
+        DataValue::Map(m) => {
+            for (_key, val) in m.iter() {
+                flatten_data(val, intern, add_node);
+            }
+        }
+        DataValue::Array(a) => {
+            for val in a.iter() {
+                flatten_data(val, intern, add_node);
+            }
+        }
+        _ => {}
+    }
+}
+
+/// Visit every node of an entry's data in list order
+///
+/// Shared by the list builders here and in the libmaxminddb compat layer,
+/// which differ only in where nodes and strings are allocated. Lazy results
+/// are walked straight from the encoded data; map keys are not listed.
+///
+/// # Safety
+/// `entry` must be non-NULL and come from `matchy_result_get_entry`.
+pub(crate) unsafe fn visit_entry_data(
+    entry: *const matchy_entry_s,
+    intern: &mut dyn FnMut(&str) -> Option<*const c_char>,
+    add_node: &mut dyn FnMut(matchy_entry_data_t),
+) -> i32 {
+    let result_ptr = (*entry).data_ptr as *const matchy_result_t;
+    if result_ptr.is_null() {
+        return MATCHY_ERROR_NO_DATA;
+    }
+    let result = &*result_ptr;
+
+    if let Some((decoder, offset)) = result.lazy_data() {
+        let walked = decoder.walk(offset, &mut |at, _key, value| {
+            add_node(matchy_entry_data_t::from_value_ref(value, at))
+        });
+        return if walked.is_err() {
+            MATCHY_ERROR_DATA_PARSE
+        } else {
+            MATCHY_SUCCESS
+        };
+    }
+    if result._data_cache.is_null() {
+        return MATCHY_ERROR_NO_DATA;
+    }
+
+    let data = &*(result._data_cache as *const DataValue);
+    flatten_data(data, intern, add_node);
+    MATCHY_SUCCESS
+}
+
 /// Get entry handle from query result
 ///
 /// This extracts the entry handle which can be used for data navigation.
@@ -1349,6 +2471,28 @@ pub unsafe extern "C" fn matchy_aget_value(
         return MATCHY_ERROR_INVALID_PARAM;
     }
 
+    // Lazy results: follow the path through the encoded data in place
+    let result_ptr = (*entry).data_ptr as *const matchy_result_t;
+    if let Some((decoder, offset)) = result_ptr.as_ref().and_then(|r| r.lazy_data()) {
+        let keys = (0..)
+            .map(|i| *path.offset(i))
+            .take_while(|key| !key.is_null())
+            .map(|key| CStr::from_ptr(key).to_bytes());
+        let status = match decoder.lookup_path(offset, keys) {
+            Ok(Some(at)) => match decoder.decode_ref(at) {
+                Ok(value) => {
+                    (*entry_data) = matchy_entry_data_t::from_value_ref(value, at);
+                    return MATCHY_SUCCESS;
+                }
+                Err(_) => MATCHY_ERROR_DATA_PARSE,
+            },
+            Ok(None) => MATCHY_ERROR_LOOKUP_PATH_INVALID,
+            Err(_) => MATCHY_ERROR_DATA_PARSE,
+        };
+        (*entry_data) = matchy_entry_data_t::empty();
+        return status;
+    }
+
     // Convert path array to Vec
     let mut path_vec = Vec::new();
     let mut i = 0;
@@ -1365,7 +2509,6 @@ pub unsafe extern "C" fn matchy_aget_value(
     }
 
     // Get result and access cached DataValue directly
-    let result_ptr = (*entry).data_ptr as *const matchy_result_t;
     if result_ptr.is_null() {
         (*entry_data) = matchy_entry_data_t::empty();
         return MATCHY_ERROR_NO_DATA;
@@ -1441,19 +2584,6 @@ pub unsafe extern "C" fn matchy_get_entry_data_list(
         return MATCHY_ERROR_INVALID_PARAM;
     }
 
-    // Get result and access cached DataValue (same as aget_value)
-    let result_ptr = (*entry).data_ptr as *const matchy_result_t;
-    if result_ptr.is_null() {
-        return MATCHY_ERROR_NO_DATA;
-    }
-
-    let result = &*result_ptr;
-    if result._data_cache.is_null() {
-        return MATCHY_ERROR_NO_DATA;
-    }
-
-    let data = &*(result._data_cache as *const DataValue);
-
     // Build a flat list by traversing the data structure
     let mut string_cache = Vec::new();
     let mut list_head: *mut matchy_entry_data_list_t = ptr::null_mut();
@@ -1476,37 +2606,21 @@ pub unsafe extern "C" fn matchy_get_entry_data_list(
         }
     };
 
-    // Flatten the data structure recursively
-    fn flatten_data(
-        value: &DataValue,
-        string_cache: &mut Vec<CString>,
-        add_node: &mut impl FnMut(matchy_entry_data_t),
-    ) {
-        // Add the current node
-        if let Some(entry_data) =
-            unsafe { matchy_entry_data_t::from_data_value(value, string_cache) }
-        {
-            add_node(entry_data);
-        }
-
-        // Recursively add children
-        match value {
-            DataValue::Map(m) => {
-                for (_key, val) in m.iter() {
-                    flatten_data(val, string_cache, add_node);
-                }
-            }
-            DataValue::Array(a) => {
-                for val in a.iter() {
-                    flatten_data(val, string_cache, add_node);
-                }
-            }
-            _ => {}
-        }
+    let status = visit_entry_data(
+        entry,
+        &mut |s| {
+            let c_str = CString::new(s).ok()?;
+            let ptr = c_str.as_ptr();
+            string_cache.push(c_str);
+            Some(ptr)
+        },
+        &mut add_node,
+    );
+    if status != MATCHY_SUCCESS {
+        matchy_free_entry_data_list(list_head);
+        return status;
     }
 
-    flatten_data(data, &mut string_cache, &mut add_node);
-
     // Leak the string cache so pointers remain valid
     std::mem::forget(string_cache);
 
@@ -1572,12 +2686,23 @@ pub unsafe extern "C" fn matchy_free_entry_data_list(list: *mut matchy_entry_dat
 /// ```
 #[no_mangle]
 pub unsafe extern "C" fn matchy_result_to_json(result: *const matchy_result_t) -> *mut c_char {
-    if result.is_null() || !(*result).found || (*result)._data_cache.is_null() {
+    if result.is_null() || !(*result).found {
         return ptr::null_mut();
     }
 
-    // Get the cached DataValue
-    let data = &*((*result)._data_cache as *const DataValue);
+    // Lazy results are decoded on demand; others use the cached DataValue
+    let decoded;
+    let data = if let Some((decoder, offset)) = (*result).lazy_data() {
+        decoded = match decoder.decode(offset) {
+            Ok(value) => value,
+            Err(_) => return ptr::null_mut(),
+        };
+        &decoded
+    } else if !(*result)._data_cache.is_null() {
+        &*((*result)._data_cache as *const DataValue)
+    } else {
+        return ptr::null_mut();
+    };
 
     // Convert to JSON
     let json_str = match serde_json::to_string(data) {
@@ -1592,6 +2717,474 @@ pub unsafe extern "C" fn matchy_result_to_json(result: *const matchy_result_t) -
     }
 }
 
+// ============================================================================
+// ARENA API
+// ============================================================================
+
+/// Create an arena for allocation-free result rendering
+///
+/// An arena hands out memory by bumping a pointer through a few large
+/// chunks. Output from the `*_arena` functions is carved from it and stays
+/// valid until matchy_arena_reset() or matchy_arena_free(), which release
+/// all of it in one step. Once the chunks have grown to a batch's working
+/// size, later batches make no allocator calls at all.
+///
+/// An arena is not thread-safe: use one per thread.
+///
+/// # Parameters
+/// * `chunk_size` - Size of the first chunk in bytes (0 for the default, 16KB)
+///
+/// # Returns
+/// * Non-null arena handle (free with matchy_arena_free)
+///
+/// # Example
+/// ```c
+/// matchy_arena_t *arena = matchy_arena_new(0);
+/// for (;;) {
+///     // ... query a batch, render each hit with matchy_result_to_json_arena()
+///     matchy_arena_reset(arena);
+/// }
+/// matchy_arena_free(arena);
+/// ```
+#[no_mangle]
+pub extern "C" fn matchy_arena_new(chunk_size: usize) -> *mut matchy_arena_t {
+    let arena = match chunk_size {
+        0 => Arena::new(),
+        bytes => Arena::with_chunk_size(bytes),
+    };
+    matchy_arena_t::from_arena(Box::new(arena))
+}
+
+/// Release everything allocated from an arena, keeping its memory for reuse
+///
+/// Every string and list previously returned from this arena becomes
+/// invalid.
+///
+/// # Safety
+/// * `arena` must be NULL or a handle from matchy_arena_new
+/// * No pointer into the arena may be used afterwards
+#[no_mangle]
+pub unsafe extern "C" fn matchy_arena_reset(arena: *mut matchy_arena_t) {
+    if !arena.is_null() {
+        matchy_arena_t::as_arena_mut(arena).reset();
+    }
+}
+
+/// Free an arena and everything allocated from it
+///
+/// # Safety
+/// * `arena` must be NULL or a handle from matchy_arena_new
+/// * Must not be called twice on the same handle
+#[no_mangle]
+pub unsafe extern "C" fn matchy_arena_free(arena: *mut matchy_arena_t) {
+    if !arena.is_null() {
+        drop(matchy_arena_t::into_arena(arena));
+    }
+}
+
+/// Bytes handed out by an arena since its last reset
+///
+/// # Safety
+/// * `arena` must be NULL or a handle from matchy_arena_new
+#[no_mangle]
+pub unsafe extern "C" fn matchy_arena_used(arena: *const matchy_arena_t) -> usize {
+    if arena.is_null() {
+        return 0;
+    }
+    matchy_arena_t::as_arena(arena).allocated_bytes()
+}
+
+/// Convert query result data to JSON, allocated from an arena
+///
+/// Same JSON value as matchy_result_to_json(), but the string lives in
+/// `arena` and must not be freed. Lazy results are decoded straight into the
+/// arena as well, so no heap allocation happens once the arena has warmed
+/// up; their object keys keep the order stored in the file, whereas
+/// matchy_result_to_json() emits keys in no particular order. Compare
+/// output by value, not byte for byte.
+///
+/// # Returns
+/// * Null-terminated JSON, valid until the arena is reset or freed
+/// * NULL if a parameter is NULL, the result is not found, or conversion fails
+///
+/// # Safety
+/// * `result` must be a valid result from a matchy query, not yet freed
+/// * `arena` must be a handle from matchy_arena_new
+///
+/// # Example
+/// ```c
+/// matchy_result_t result = matchy_query(db, "8.8.8.8");
+/// const char *json = matchy_result_to_json_arena(&result, arena);
+/// if (json) {
+///     printf("Data: %s\n", json);
+/// }
+/// matchy_free_result(&result);
+/// ```
+#[no_mangle]
+pub unsafe extern "C" fn matchy_result_to_json_arena(
+    result: *const matchy_result_t,
+    arena: *mut matchy_arena_t,
+) -> *const c_char {
+    if result.is_null() || arena.is_null() || !(*result).found {
+        return ptr::null();
+    }
+    let arena = matchy_arena_t::as_arena(arena);
+
+    let json = if let Some((decoder, offset)) = (*result).lazy_data() {
+        decoder
+            .decode_in(offset, arena)
+            .ok()
+            .and_then(|value| arena.alloc_json(&value).ok())
+    } else if !(*result)._data_cache.is_null() {
+        arena
+            .alloc_json(&*((*result)._data_cache as *const DataValue))
+            .ok()
+    } else {
+        None
+    };
+
+    json.map_or(ptr::null(), |json| json.as_ptr() as *const c_char)
+}
+
+/// Get full entry data as a linked list allocated from an arena
+///
+/// Same traversal as matchy_get_entry_data_list(), but nodes (and string
+/// copies for decoded results) are carved from `arena`. Do not pass the
+/// list to matchy_free_entry_data_list(); it is released by
+/// matchy_arena_reset() or matchy_arena_free().
+///
+/// # Returns
+/// * MATCHY_SUCCESS on success
+/// * Error code on failure (`*entry_data_list` is untouched)
+///
+/// # Safety
+/// * `entry` must be valid and its result not yet freed
+/// * `entry_data_list` must be a valid pointer
+/// * `arena` must be a handle from matchy_arena_new
+#[no_mangle]
+pub unsafe extern "C" fn matchy_get_entry_data_list_arena(
+    entry: *const matchy_entry_s,
+    entry_data_list: *mut *mut matchy_entry_data_list_t,
+    arena: *mut matchy_arena_t,
+) -> i32 {
+    if entry.is_null() || entry_data_list.is_null() || arena.is_null() {
+        return MATCHY_ERROR_INVALID_PARAM;
+    }
+    let arena = matchy_arena_t::as_arena(arena);
+
+    let mut list_head: *mut matchy_entry_data_list_t = ptr::null_mut();
+    let mut list_tail: *mut matchy_entry_data_list_t = ptr::null_mut();
+    let mut add_node = |entry_data: matchy_entry_data_t| {
+        let node: *mut matchy_entry_data_list_t = arena.alloc(matchy_entry_data_list_t {
+            entry_data,
+            next: ptr::null_mut(),
+        });
+        if list_head.is_null() {
+            list_head = node;
+        } else {
+            (*list_tail).next = node;
+        }
+        list_tail = node;
+    };
+
+    // Nodes already carved on error are released with the arena
+    let status = visit_entry_data(
+        entry,
+        &mut |s| arena.alloc_c_str(s.as_bytes()),
+        &mut add_node,
+    );
+    if status != MATCHY_SUCCESS {
+        return status;
+    }
+
+    *entry_data_list = list_head;
+    MATCHY_SUCCESS
+}
+
+// ============================================================================
+// EXTRACT-AND-MATCH API
+// ============================================================================
+
+/// Extract domain names (matchy_worker_new flag)
+pub const MATCHY_EXTRACT_DOMAINS: u32 = 1 << 0;
+/// Extract email addresses
+pub const MATCHY_EXTRACT_EMAILS: u32 = 1 << 1;
+/// Extract IPv4 addresses
+pub const MATCHY_EXTRACT_IPV4: u32 = 1 << 2;
+/// Extract IPv6 addresses
+pub const MATCHY_EXTRACT_IPV6: u32 = 1 << 3;
+/// Extract MD5, SHA1, SHA256, SHA384 and SHA512 hashes
+pub const MATCHY_EXTRACT_HASHES: u32 = 1 << 4;
+/// Extract Bitcoin addresses
+pub const MATCHY_EXTRACT_BITCOIN: u32 = 1 << 5;
+/// Extract Ethereum addresses
+pub const MATCHY_EXTRACT_ETHEREUM: u32 = 1 << 6;
+/// Extract Monero addresses
+pub const MATCHY_EXTRACT_MONERO: u32 = 1 << 7;
+/// Extract every supported indicator type
+pub const MATCHY_EXTRACT_ALL: u32 = 0xff;
+
+/// Matched indicator is an IPv4 address (matchy_scan_match_t.type_)
+pub const MATCHY_ITEM_IPV4: u32 = 1;
+/// Matched indicator is an IPv6 address
+pub const MATCHY_ITEM_IPV6: u32 = 2;
+/// Matched indicator is a domain name
+pub const MATCHY_ITEM_DOMAIN: u32 = 3;
+/// Matched indicator is an email address
+pub const MATCHY_ITEM_EMAIL: u32 = 4;
+/// Matched indicator is an MD5 hash
+pub const MATCHY_ITEM_MD5: u32 = 5;
+/// Matched indicator is a SHA1 hash
+pub const MATCHY_ITEM_SHA1: u32 = 6;
+/// Matched indicator is a SHA256 hash
+pub const MATCHY_ITEM_SHA256: u32 = 7;
+/// Matched indicator is a SHA384 hash
+pub const MATCHY_ITEM_SHA384: u32 = 8;
+/// Matched indicator is a SHA512 hash
+pub const MATCHY_ITEM_SHA512: u32 = 9;
+/// Matched indicator is a Bitcoin address
+pub const MATCHY_ITEM_BITCOIN: u32 = 10;
+/// Matched indicator is an Ethereum address
+pub const MATCHY_ITEM_ETHEREUM: u32 = 11;
+/// Matched indicator is a Monero address
+pub const MATCHY_ITEM_MONERO: u32 = 12;
+
+/// One indicator found by matchy_worker_scan() in one of the worker's databases
+#[repr(C)]
+pub struct matchy_scan_match_t {
+    /// Byte offset of the indicator in the scanned buffer
+    pub offset: usize,
+    /// Length of the indicator in bytes
+    pub length: usize,
+    /// The indicator itself, pointing into the scanned buffer (not null-terminated)
+    pub text: *const u8,
+    /// Indicator type (one of the MATCHY_ITEM_* constants)
+    pub type_: u32,
+    /// Index of the matching database in the array given to matchy_worker_new
+    pub db_id: u32,
+    /// The database's result; valid only until the callback returns
+    pub result: matchy_result_t,
+}
+
+/// Callback receiving each match from matchy_worker_scan()
+///
+/// Return 0 to continue scanning, anything else to stop.
+#[allow(non_camel_case_types)]
+pub type matchy_scan_callback_t =
+    Option<unsafe extern "C" fn(scan_match: *const matchy_scan_match_t, ctx: *mut c_void) -> i32>;
+
+/// MATCHY_ITEM_* constant for an extracted item
+fn item_type(item: &ExtractedItem) -> u32 {
+    match item {
+        ExtractedItem::Ipv4(_) => MATCHY_ITEM_IPV4,
+        ExtractedItem::Ipv6(_) => MATCHY_ITEM_IPV6,
+        ExtractedItem::Domain(_) => MATCHY_ITEM_DOMAIN,
+        ExtractedItem::Email(_) => MATCHY_ITEM_EMAIL,
+        ExtractedItem::Hash(HashType::Md5, _) => MATCHY_ITEM_MD5,
+        ExtractedItem::Hash(HashType::Sha1, _) => MATCHY_ITEM_SHA1,
+        ExtractedItem::Hash(HashType::Sha256, _) => MATCHY_ITEM_SHA256,
+        ExtractedItem::Hash(HashType::Sha384, _) => MATCHY_ITEM_SHA384,
+        ExtractedItem::Hash(HashType::Sha512, _) => MATCHY_ITEM_SHA512,
+        ExtractedItem::Bitcoin(_) => MATCHY_ITEM_BITCOIN,
+        ExtractedItem::Ethereum(_) => MATCHY_ITEM_ETHEREUM,
+        ExtractedItem::Monero(_) => MATCHY_ITEM_MONERO,
+    }
+}
+
+/// Create a worker that extracts indicators from raw buffers and matches them
+///
+/// This is the single-pass pipeline `matchy match` uses: one scan over the
+/// buffer finds IP addresses, domains, emails, hashes and cryptocurrency
+/// addresses, and each is looked up in every database without being copied
+/// out of the buffer.
+///
+/// # Parameters
+/// * `databases` - Array of `count` database handles (must not be NULL)
+/// * `count` - Number of databases (at least 1)
+/// * `extract_flags` - MATCHY_EXTRACT_* flags OR'ed together (0 for all)
+///
+/// # Returns
+/// * Non-null worker handle (free with matchy_worker_free)
+/// * NULL if a parameter is invalid or the extractor can't be built
+///
+/// The worker borrows the database handles: they must stay open until the
+/// worker is freed. Reloads are picked up on the next scan. A worker is not
+/// thread-safe; create one per thread (they can share database handles).
+///
+/// # Safety
+/// * `databases` must point to `count` valid handles from matchy_open
+///
+/// # Example
+/// ```c
+/// const matchy_t *dbs[] = {threats, allowlist};
+/// matchy_worker_t *worker = matchy_worker_new(dbs, 2,
+///     MATCHY_EXTRACT_IPV4 | MATCHY_EXTRACT_IPV6 | MATCHY_EXTRACT_DOMAINS);
+/// ```
+#[no_mangle]
+pub unsafe extern "C" fn matchy_worker_new(
+    databases: *const *const matchy_t,
+    count: usize,
+    extract_flags: u32,
+) -> *mut matchy_worker_t {
+    if databases.is_null() || count == 0 {
+        return ptr::null_mut();
+    }
+    let databases = slice::from_raw_parts(databases, count).to_vec();
+    if databases.iter().any(|db| db.is_null()) {
+        return ptr::null_mut();
+    }
+
+    let flags = if extract_flags == 0 {
+        MATCHY_EXTRACT_ALL
+    } else {
+        extract_flags
+    };
+    let extractor = match Extractor::builder()
+        .extract_domains(flags & MATCHY_EXTRACT_DOMAINS != 0)
+        .extract_emails(flags & MATCHY_EXTRACT_EMAILS != 0)
+        .extract_ipv4(flags & MATCHY_EXTRACT_IPV4 != 0)
+        .extract_ipv6(flags & MATCHY_EXTRACT_IPV6 != 0)
+        .extract_hashes(flags & MATCHY_EXTRACT_HASHES != 0)
+        .extract_bitcoin(flags & MATCHY_EXTRACT_BITCOIN != 0)
+        .extract_ethereum(flags & MATCHY_EXTRACT_ETHEREUM != 0)
+        .extract_monero(flags & MATCHY_EXTRACT_MONERO != 0)
+        .build()
+    {
+        Ok(extractor) => extractor,
+        Err(_) => return ptr::null_mut(),
+    };
+
+    matchy_worker_t::from_internal(Box::new(MatchyWorkerInternal {
+        extractor,
+        databases,
+    }))
+}
+
+/// Extract indicators from a buffer and report every database match
+///
+/// Calls `callback` once per (indicator, database) match, in buffer order
+/// and, for each indicator, in database order. `scan_match->text` points into
+/// `buf`; `scan_match->result` behaves like a matchy_query() result (use
+/// matchy_result_get_entry(), matchy_aget_value(), ...) but is owned by the
+/// worker: don't free it, and don't use it after the callback returns.
+/// Handles opened with `lazy_results` decode nothing unless asked to.
+///
+/// Each database answers the whole buffer from one version, even if it is
+/// reloaded during the scan.
+///
+/// # Parameters
+/// * `worker` - Worker handle (must not be NULL)
+/// * `buf` - Bytes to scan (may be NULL if `len` is 0)
+/// * `len` - Buffer length in bytes
+/// * `callback` - Match callback (must not be NULL); return non-zero to stop
+/// * `ctx` - Passed through to `callback`
+///
+/// # Returns
+/// * Number of matches delivered to `callback` (>= 0)
+/// * MATCHY_ERROR_INVALID_PARAM if a required pointer is NULL
+///
+/// # Safety
+/// * `worker` must be a valid handle from matchy_worker_new
+/// * `buf` must be valid for reading `len` bytes
+///
+/// # Example
+/// ```c
+/// static int32_t on_match(const matchy_scan_match_t *m, void *ctx) {
+///     printf("%.*s in db %u\n", (int)m->length, (const char *)m->text, m->db_id);
+///     return 0;
+/// }
+///
+/// int64_t n = matchy_worker_scan(worker, (const uint8_t *)line, strlen(line), on_match, NULL);
+/// ```
+#[no_mangle]
+pub unsafe extern "C" fn matchy_worker_scan(
+    worker: *mut matchy_worker_t,
+    buf: *const u8,
+    len: usize,
+    callback: matchy_scan_callback_t,
+    ctx: *mut c_void,
+) -> i64 {
+    let callback = match callback {
+        Some(callback) if !worker.is_null() && (!buf.is_null() || len == 0) => callback,
+        _ => return MATCHY_ERROR_INVALID_PARAM as i64,
+    };
+    if len == 0 {
+        return 0;
+    }
+
+    let worker = matchy_worker_t::as_internal(worker);
+    let data = slice::from_raw_parts(buf, len);
+    let extracted = worker.extractor.extract_from_chunk(data);
+    if extracted.is_empty() {
+        return 0;
+    }
+
+    // Pin one version per database for the whole buffer; reloads don't
+    // wait for the guards
+    let databases: Vec<_> = worker
+        .databases
+        .iter()
+        .map(|&db| {
+            let internal = matchy_t::as_internal(db);
+            (db, internal, internal.database.current())
+        })
+        .collect();
+
+    let mut delivered = 0i64;
+    for item in &extracted {
+        for (db_id, (db, internal, current)) in databases.iter().enumerate() {
+            let result = match &item.item {
+                ExtractedItem::Ipv4(ip) => {
+                    matchy_result_t::query_ip(*db, internal, current, IpAddr::V4(*ip))
+                }
+                ExtractedItem::Ipv6(ip) => {
+                    matchy_result_t::query_ip(*db, internal, current, IpAddr::V6(*ip))
+                }
+                ExtractedItem::Domain(s)
+                | ExtractedItem::Email(s)
+                | ExtractedItem::Hash(_, s)
+                | ExtractedItem::Bitcoin(s)
+                | ExtractedItem::Ethereum(s)
+                | ExtractedItem::Monero(s) => matchy_result_t::query(*db, internal, current, s),
+            };
+            if !result.found {
+                continue;
+            }
+
+            let mut found = matchy_scan_match_t {
+                offset: item.span.0,
+                length: item.span.1 - item.span.0,
+                text: data.as_ptr().add(item.span.0),
+                type_: item_type(&item.item),
+                db_id: db_id as u32,
+                result,
+            };
+            let stop = callback(&found, ctx) != 0;
+            matchy_free_result(&mut found.result);
+            delivered += 1;
+            if stop {
+                return delivered;
+            }
+        }
+    }
+
+    delivered
+}
+
+/// Free a worker
+///
+/// The database handles it was created from are not closed.
+///
+/// # Safety
+/// * `worker` must be NULL or a handle from matchy_worker_new
+/// * Must not be called twice on the same handle
+#[no_mangle]
+pub unsafe extern "C" fn matchy_worker_free(worker: *mut matchy_worker_t) {
+    if !worker.is_null() {
+        drop(matchy_worker_t::into_internal(worker));
+    }
+}
+
 // ============================================================================
 // VALIDATION API
 // ============================================================================
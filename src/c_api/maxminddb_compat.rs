@@ -3,11 +3,18 @@
 //! This module provides libmaxminddb-compatible C API functions that wrap
 //! matchy's native API. This allows applications using libmaxminddb to
 //! switch to matchy with minimal code changes.
+//!
+//! Entry data lists are carved from a per-lookup block pool (an [`Arena`])
+//! whose address is stored in every node's `pool` field, the way
+//! libmaxminddb does. `MMDB_free_entry_data_list` releases the whole list in
+//! one step, and a reset pool is kept per thread for the next lookup.
 
 use super::matchy::{
-    matchy_aget_value, matchy_close, matchy_entry_data_list_t, matchy_entry_data_t, matchy_entry_s,
-    matchy_get_entry_data_list, matchy_open, matchy_query, matchy_t, MATCHY_SUCCESS,
+    matchy_aget_value, matchy_close, matchy_entry_data_t, matchy_entry_s, matchy_open,
+    matchy_query, matchy_t, visit_entry_data, MATCHY_SUCCESS,
 };
+use crate::arena::Arena;
+use std::cell::Cell;
 use std::ffi::{CStr, CString};
 use std::mem;
 use std::net::{IpAddr, Ipv4Addr, Ipv6Addr};
@@ -57,15 +64,56 @@ pub type MMDB_entry_data_s = matchy_entry_data_t;
 
 /// Entry data list node
 #[repr(C)]
+#[derive(Copy, Clone)]
 pub struct MMDB_entry_data_list_s {
     /// The entry data for this node
     pub entry_data: MMDB_entry_data_s,
     /// Pointer to the next node in the list (NULL if last)
     pub next: *mut MMDB_entry_data_list_s,
-    /// Memory pool pointer (not used in this implementation)
+    /// Block pool that owns this node, its siblings and their strings
     pub pool: *mut c_void,
 }
 
+// ============================================================================
+// ENTRY DATA LIST POOL
+// ============================================================================
+
+/// Nodes that fit in a pool's first chunk
+///
+/// Covers a typical GeoIP2 City record without growing the pool.
+const POOL_NODES_PER_CHUNK: usize = 64;
+
+/// Largest pool kept for reuse; anything bigger is returned to the allocator
+const POOL_REUSE_LIMIT: usize = 64 * 1024;
+
+thread_local! {
+    /// A reset pool left by the last free on this thread
+    static SPARE_POOL: Cell<Option<Box<Arena>>> = Cell::new(None);
+}
+
+/// Take the thread's spare pool, or create one
+fn acquire_pool() -> Box<Arena> {
+    SPARE_POOL
+        .try_with(|spare| spare.take())
+        .ok()
+        .flatten()
+        .unwrap_or_else(|| {
+            Box::new(Arena::with_chunk_size(
+                POOL_NODES_PER_CHUNK * mem::size_of::<MMDB_entry_data_list_s>(),
+            ))
+        })
+}
+
+/// Reset a pool and keep it for the next lookup on this thread
+fn release_pool(mut pool: Box<Arena>) {
+    if pool.capacity() > POOL_REUSE_LIMIT {
+        return;
+    }
+    pool.reset();
+    // During thread teardown the pool is simply dropped
+    let _ = SPARE_POOL.try_with(|spare| spare.set(Some(pool)));
+}
+
 // ============================================================================
 // ERROR CODE MAPPING
 // ============================================================================
@@ -367,6 +415,10 @@ pub unsafe extern "C" fn MMDB_aget_value(
 
 /// Get entry data list (tree traversal)
 ///
+/// Nodes and their strings are allocated from a single block pool, so a
+/// lookup costs a handful of allocations at most (none once the thread has
+/// a spare pool). Release the list with `MMDB_free_entry_data_list`.
+///
 /// # Safety
 /// - `start` must be a valid entry
 /// - `entry_data_list` must be a valid pointer
@@ -379,30 +431,56 @@ pub unsafe extern "C" fn MMDB_get_entry_data_list(
         return MMDB_INVALID_DATA_ERROR;
     }
 
-    // Call matchy's get_entry_data_list
+    let pool = Box::into_raw(acquire_pool());
+    let arena: &Arena = &*pool;
+    let mut list_head: *mut MMDB_entry_data_list_s = ptr::null_mut();
+    let mut list_tail: *mut MMDB_entry_data_list_s = ptr::null_mut();
+    let mut add_node = |entry_data: matchy_entry_data_t| {
+        let node: *mut MMDB_entry_data_list_s = arena.alloc(MMDB_entry_data_list_s {
+            entry_data,
+            next: ptr::null_mut(),
+            pool: pool as *mut c_void,
+        });
+        if list_head.is_null() {
+            list_head = node;
+        } else {
+            (*list_tail).next = node;
+        }
+        list_tail = node;
+    };
+
     let matchy_entry = &(*start)._matchy_entry as *const _;
-    let matchy_list_ptr = entry_data_list as *mut *mut matchy_entry_data_list_t;
-    let status = matchy_get_entry_data_list(matchy_entry, matchy_list_ptr);
+    let status = visit_entry_data(
+        matchy_entry,
+        &mut |s| arena.alloc_c_str(s.as_bytes()),
+        &mut add_node,
+    );
+
+    // The pool is reached through the nodes, so an empty list cannot own it
+    if status != MATCHY_SUCCESS || list_head.is_null() {
+        release_pool(Box::from_raw(pool));
+    }
+    if status != MATCHY_SUCCESS {
+        return map_matchy_error(status);
+    }
 
-    map_matchy_error(status)
+    *entry_data_list = list_head;
+    MMDB_SUCCESS
 }
 
 /// Free entry data list
 ///
+/// Releases every node of the list, and the strings they point to, at once.
+///
 /// # Safety
-/// - `entry_data_list` must be from MMDB_get_entry_data_list or NULL
+/// - `entry_data_list` must be the head returned by MMDB_get_entry_data_list
+///   or NULL
 #[no_mangle]
 pub unsafe extern "C" fn MMDB_free_entry_data_list(entry_data_list: *mut MMDB_entry_data_list_s) {
-    if entry_data_list.is_null() {
+    if entry_data_list.is_null() || (*entry_data_list).pool.is_null() {
         return;
     }
-
-    let mut current = entry_data_list;
-    while !current.is_null() {
-        let next = (*current).next;
-        let _ = Box::from_raw(current);
-        current = next;
-    }
+    release_pool(Box::from_raw((*entry_data_list).pool as *mut Arena));
 }
 
 /// Close database
@@ -91,7 +91,10 @@
 //!
 //! # Thread Safety
 //!
-//! - **Database handles**: Safe for concurrent reads from multiple threads
+//! - **Database handles**: Safe for concurrent queries from multiple threads.
+//!   Share one handle instead of opening one per thread, and set
+//!   `matchy_open_options_t.concurrency` to the thread count so the shared
+//!   query cache is sharded and pattern scratch buffers are per-thread
 //! - **Builders**: NOT thread-safe, use one builder per thread
 //! - **Results**: Thread-local, don't share between threads
 //!
@@ -0,0 +1,706 @@
+//! Replacement policies for the query cache shards
+//!
+//! Strict LRU lets a single burst of unique queries (a log full of one-off
+//! URLs, a port scan) flush the hot working set. [`CachePolicy`] picks one
+//! of several scan-resistant alternatives:
+//!
+//! - **LRU**: the default; evicts the least recently used entry
+//! - **CLOCK**: a ring of entries with a reference bit. A hit only sets the
+//!   bit, so it never reorders anything; the eviction hand gives referenced
+//!   entries a second chance. Approximates LRU at a lower cost per hit, but
+//!   long scans still flush it
+//! - **S3-FIFO**: new entries go to a small FIFO queue and only move to the
+//!   main queue if hit again before they reach its end. Entries evicted
+//!   from the small queue are remembered in a ghost queue of keys, and
+//!   come back straight into the main queue
+//! - **W-TinyLFU**: a small LRU window in front of a main LRU. An entry
+//!   leaving the window only replaces the main victim if a count-min sketch
+//!   of recent accesses says it is used more often
+//!
+//! Every policy counts its evictions, admission rejections and promotions
+//! in [`CacheCounters`], reported through `DatabaseStats`, so capacity can
+//! be tuned against measured behaviour.
+
+use lru::LruCache;
+use rustc_hash::FxHashMap;
+use std::collections::VecDeque;
+use std::hash::{BuildHasher, BuildHasherDefault, Hash};
+use std::num::NonZeroUsize;
+
+/// Hasher for cache maps and sketches
+pub(crate) type FxBuildHasher = BuildHasherDefault<rustc_hash::FxHasher>;
+
+/// Replacement policy of the query cache
+///
+/// The C API passes policies as the `MATCHY_CACHE_*` constants.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum CachePolicy {
+    /// Least recently used (default)
+    #[default]
+    Lru,
+    /// CLOCK (second chance): hits set a reference bit instead of reordering
+    Clock,
+    /// S3-FIFO: small probationary queue, main queue and ghost queue
+    S3Fifo,
+    /// W-TinyLFU: LRU window plus frequency-based admission to a main LRU
+    TinyLfu,
+}
+
+impl CachePolicy {
+    /// Policy for a `MATCHY_CACHE_*` constant (None when unknown)
+    pub fn from_u32(value: u32) -> Option<Self> {
+        match value {
+            0 => Some(CachePolicy::Lru),
+            1 => Some(CachePolicy::Clock),
+            2 => Some(CachePolicy::S3Fifo),
+            3 => Some(CachePolicy::TinyLfu),
+            _ => None,
+        }
+    }
+}
+
+/// Replacement counters of one cache
+///
+/// What counts as a promotion depends on the policy: CLOCK counts second
+/// chances, S3-FIFO moves from the small to the main queue (including
+/// ghost readmissions), and W-TinyLFU admissions from the window to the
+/// main LRU. LRU never promotes or rejects.
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub(crate) struct CacheCounters {
+    /// Entries dropped to make room for new ones
+    pub(crate) evictions: u64,
+    /// Entries refused by the admission filter (W-TinyLFU); each is also
+    /// counted as an eviction
+    pub(crate) rejections: u64,
+    /// Entries kept or moved up by the policy instead of being evicted
+    pub(crate) promotions: u64,
+}
+
+impl CacheCounters {
+    /// Add another cache's counters to these
+    pub(crate) fn add(&mut self, other: &CacheCounters) {
+        self.evictions += other.evictions;
+        self.rejections += other.rejections;
+        self.promotions += other.promotions;
+    }
+}
+
+/// A bounded map with a pluggable replacement policy
+///
+/// Mirrors the parts of `LruCache` the query cache uses. `push` returns
+/// the entry that was replaced or evicted, if any, so callers can recycle
+/// what it owned.
+pub(crate) struct PolicyCache<K, V> {
+    inner: Inner<K, V>,
+    counters: CacheCounters,
+}
+
+enum Inner<K, V> {
+    Lru(LruCache<K, V, FxBuildHasher>),
+    Clock(ClockCache<K, V>),
+    S3Fifo(S3FifoCache<K, V>),
+    TinyLfu(TinyLfuCache<K, V>),
+}
+
+impl<K: Copy + Hash + Eq, V> PolicyCache<K, V> {
+    /// Cache of `capacity` entries under `policy`
+    pub(crate) fn new(policy: CachePolicy, capacity: NonZeroUsize) -> Self {
+        let inner = match policy {
+            CachePolicy::Lru => {
+                Inner::Lru(LruCache::with_hasher(capacity, FxBuildHasher::default()))
+            }
+            CachePolicy::Clock => Inner::Clock(ClockCache::new(capacity.get())),
+            CachePolicy::S3Fifo => Inner::S3Fifo(S3FifoCache::new(capacity.get())),
+            CachePolicy::TinyLfu => Inner::TinyLfu(TinyLfuCache::new(capacity.get())),
+        };
+        Self {
+            inner,
+            counters: CacheCounters::default(),
+        }
+    }
+
+    /// Look up `key`, recording the access for the policy
+    #[inline]
+    pub(crate) fn get(&mut self, key: &K) -> Option<&V> {
+        match &mut self.inner {
+            Inner::Lru(lru) => lru.get(key),
+            Inner::Clock(clock) => clock.get(key),
+            Inner::S3Fifo(fifo) => fifo.get(key),
+            Inner::TinyLfu(lfu) => lfu.get(key),
+        }
+    }
+
+    /// Mutable access to `key`'s value without recording an access
+    #[inline]
+    pub(crate) fn peek_mut(&mut self, key: &K) -> Option<&mut V> {
+        match &mut self.inner {
+            Inner::Lru(lru) => lru.peek_mut(key),
+            Inner::Clock(clock) => clock.peek_mut(key),
+            Inner::S3Fifo(fifo) => fifo.peek_mut(key),
+            Inner::TinyLfu(lfu) => lfu.peek_mut(key),
+        }
+    }
+
+    /// Insert or replace `key`
+    ///
+    /// Returns the old entry for `key` if it was replaced, otherwise the
+    /// entry evicted to make room, if any.
+    pub(crate) fn push(&mut self, key: K, value: V) -> Option<(K, V)> {
+        let counters = &mut self.counters;
+        match &mut self.inner {
+            Inner::Lru(lru) => {
+                let old = lru.push(key, value);
+                if old.as_ref().is_some_and(|(old_key, _)| *old_key != key) {
+                    counters.evictions += 1;
+                }
+                old
+            }
+            Inner::Clock(clock) => clock.push(key, value, counters),
+            Inner::S3Fifo(fifo) => fifo.push(key, value, counters),
+            Inner::TinyLfu(lfu) => lfu.push(key, value, counters),
+        }
+    }
+
+    /// Remove all entries (counters are kept)
+    pub(crate) fn clear(&mut self) {
+        match &mut self.inner {
+            Inner::Lru(lru) => lru.clear(),
+            Inner::Clock(clock) => clock.clear(),
+            Inner::S3Fifo(fifo) => fifo.clear(),
+            Inner::TinyLfu(lfu) => lfu.clear(),
+        }
+    }
+
+    pub(crate) fn len(&self) -> usize {
+        match &self.inner {
+            Inner::Lru(lru) => lru.len(),
+            Inner::Clock(clock) => clock.entries.len(),
+            Inner::S3Fifo(fifo) => fifo.map.len(),
+            Inner::TinyLfu(lfu) => lfu.window.len() + lfu.main.len(),
+        }
+    }
+
+    pub(crate) fn cap(&self) -> usize {
+        match &self.inner {
+            Inner::Lru(lru) => lru.cap().get(),
+            Inner::Clock(clock) => clock.capacity,
+            Inner::S3Fifo(fifo) => fifo.capacity,
+            Inner::TinyLfu(lfu) => lfu.window.cap().get() + lfu.main.cap().get(),
+        }
+    }
+
+    /// Entries, roughly most valuable to keep first
+    ///
+    /// Exact recency order for LRU; for the other policies, the entries
+    /// the policy would evict last come first.
+    pub(crate) fn iter(&self) -> Box<dyn Iterator<Item = (&K, &V)> + '_> {
+        match &self.inner {
+            Inner::Lru(lru) => Box::new(lru.iter()),
+            Inner::Clock(clock) => Box::new(clock.iter()),
+            Inner::S3Fifo(fifo) => Box::new(fifo.iter()),
+            Inner::TinyLfu(lfu) => Box::new(lfu.main.iter().chain(lfu.window.iter())),
+        }
+    }
+
+    /// Replacement counters since the cache was created
+    pub(crate) fn counters(&self) -> CacheCounters {
+        self.counters
+    }
+}
+
+/// CLOCK entry
+struct ClockEntry<K, V> {
+    key: K,
+    value: V,
+    referenced: bool,
+}
+
+/// CLOCK: entries in a ring swept by an eviction hand
+struct ClockCache<K, V> {
+    entries: Vec<ClockEntry<K, V>>,
+    map: FxHashMap<K, usize>,
+    hand: usize,
+    capacity: usize,
+}
+
+impl<K: Copy + Hash + Eq, V> ClockCache<K, V> {
+    fn new(capacity: usize) -> Self {
+        Self {
+            entries: Vec::new(),
+            map: FxHashMap::default(),
+            hand: 0,
+            capacity,
+        }
+    }
+
+    #[inline]
+    fn get(&mut self, key: &K) -> Option<&V> {
+        let entry = &mut self.entries[*self.map.get(key)?];
+        entry.referenced = true;
+        Some(&entry.value)
+    }
+
+    #[inline]
+    fn peek_mut(&mut self, key: &K) -> Option<&mut V> {
+        let index = *self.map.get(key)?;
+        Some(&mut self.entries[index].value)
+    }
+
+    fn push(&mut self, key: K, value: V, counters: &mut CacheCounters) -> Option<(K, V)> {
+        if let Some(&index) = self.map.get(&key) {
+            let entry = &mut self.entries[index];
+            entry.referenced = true;
+            return Some((key, std::mem::replace(&mut entry.value, value)));
+        }
+
+        let fresh = ClockEntry {
+            key,
+            value,
+            referenced: false,
+        };
+        if self.entries.len() < self.capacity {
+            self.map.insert(key, self.entries.len());
+            self.entries.push(fresh);
+            return None;
+        }
+
+        // Referenced entries lose their bit and survive one more sweep
+        while self.entries[self.hand].referenced {
+            self.entries[self.hand].referenced = false;
+            counters.promotions += 1;
+            self.hand = (self.hand + 1) % self.capacity;
+        }
+        let index = self.hand;
+        self.hand = (self.hand + 1) % self.capacity;
+        let old = std::mem::replace(&mut self.entries[index], fresh);
+        self.map.remove(&old.key);
+        self.map.insert(key, index);
+        counters.evictions += 1;
+        Some((old.key, old.value))
+    }
+
+    fn clear(&mut self) {
+        self.entries.clear();
+        self.map.clear();
+        self.hand = 0;
+    }
+
+    /// Entries from the one the hand reaches last to the one it reaches next
+    fn iter(&self) -> impl Iterator<Item = (&K, &V)> {
+        let (next, rest) = self.entries.split_at(self.hand.min(self.entries.len()));
+        next.iter()
+            .rev()
+            .chain(rest.iter().rev())
+            .map(|entry| (&entry.key, &entry.value))
+    }
+}
+
+/// Most accesses an S3-FIFO entry remembers
+const S3_MAX_FREQ: u8 = 3;
+
+/// S3-FIFO entry
+struct FifoEntry<K, V> {
+    key: K,
+    value: V,
+    freq: u8,
+}
+
+/// S3-FIFO: small and main FIFO queues over a slab, plus a ghost queue
+struct S3FifoCache<K, V> {
+    slab: Vec<Option<FifoEntry<K, V>>>,
+    free: Vec<usize>,
+    map: FxHashMap<K, usize>,
+    small: VecDeque<usize>,
+    main: VecDeque<usize>,
+    /// Keys recently evicted from the small queue, with the sequence number
+    /// they were queued at (a stale queue slot has an older number)
+    ghost: VecDeque<(K, u64)>,
+    ghost_map: FxHashMap<K, u64>,
+    ghost_seq: u64,
+    /// Target size of the small queue (10% of capacity)
+    small_target: usize,
+    capacity: usize,
+}
+
+impl<K: Copy + Hash + Eq, V> S3FifoCache<K, V> {
+    fn new(capacity: usize) -> Self {
+        Self {
+            slab: Vec::new(),
+            free: Vec::new(),
+            map: FxHashMap::default(),
+            small: VecDeque::new(),
+            main: VecDeque::new(),
+            ghost: VecDeque::new(),
+            ghost_map: FxHashMap::default(),
+            ghost_seq: 0,
+            small_target: (capacity / 10).max(1),
+            capacity,
+        }
+    }
+
+    #[inline]
+    fn entry_mut(&mut self, index: usize) -> &mut FifoEntry<K, V> {
+        self.slab[index].as_mut().expect("queued slot is occupied")
+    }
+
+    #[inline]
+    fn get(&mut self, key: &K) -> Option<&V> {
+        let index = *self.map.get(key)?;
+        let entry = self.entry_mut(index);
+        entry.freq = (entry.freq + 1).min(S3_MAX_FREQ);
+        Some(&entry.value)
+    }
+
+    #[inline]
+    fn peek_mut(&mut self, key: &K) -> Option<&mut V> {
+        let index = *self.map.get(key)?;
+        Some(&mut self.entry_mut(index).value)
+    }
+
+    fn push(&mut self, key: K, value: V, counters: &mut CacheCounters) -> Option<(K, V)> {
+        if let Some(&index) = self.map.get(&key) {
+            let entry = self.entry_mut(index);
+            return Some((key, std::mem::replace(&mut entry.value, value)));
+        }
+
+        let evicted = if self.map.len() >= self.capacity {
+            self.evict(counters)
+        } else {
+            None
+        };
+
+        let entry = FifoEntry {
+            key,
+            value,
+            freq: 0,
+        };
+        let index = match self.free.pop() {
+            Some(index) => {
+                self.slab[index] = Some(entry);
+                index
+            }
+            None => {
+                self.slab.push(Some(entry));
+                self.slab.len() - 1
+            }
+        };
+        self.map.insert(key, index);
+
+        // Keys seen again soon after leaving the small queue skip it
+        if self.ghost_map.remove(&key).is_some() {
+            counters.promotions += 1;
+            self.main.push_back(index);
+        } else {
+            self.small.push_back(index);
+        }
+        evicted
+    }
+
+    /// Remove one entry, moving hit entries up on the way
+    fn evict(&mut self, counters: &mut CacheCounters) -> Option<(K, V)> {
+        loop {
+            if self.small.len() >= self.small_target || self.main.is_empty() {
+                let index = self.small.pop_front()?;
+                if self.entry_mut(index).freq > 1 {
+                    self.entry_mut(index).freq = 0;
+                    self.main.push_back(index);
+                    counters.promotions += 1;
+                    continue;
+                }
+                let entry = self.remove(index);
+                self.remember_ghost(entry.key);
+                counters.evictions += 1;
+                return Some((entry.key, entry.value));
+            }
+
+            let index = self.main.pop_front()?;
+            let entry = self.entry_mut(index);
+            if entry.freq > 0 {
+                entry.freq -= 1;
+                self.main.push_back(index);
+                continue;
+            }
+            let entry = self.remove(index);
+            counters.evictions += 1;
+            return Some((entry.key, entry.value));
+        }
+    }
+
+    fn remove(&mut self, index: usize) -> FifoEntry<K, V> {
+        let entry = self.slab[index].take().expect("queued slot is occupied");
+        self.map.remove(&entry.key);
+        self.free.push(index);
+        entry
+    }
+
+    /// Queue `key` as a ghost, forgetting the oldest beyond the main queue's size
+    fn remember_ghost(&mut self, key: K) {
+        self.ghost_seq += 1;
+        self.ghost.push_back((key, self.ghost_seq));
+        self.ghost_map.insert(key, self.ghost_seq);
+        while self.ghost.len() > self.capacity - self.small_target.min(self.capacity - 1) {
+            let Some((old, seq)) = self.ghost.pop_front() else {
+                break;
+            };
+            if self.ghost_map.get(&old) == Some(&seq) {
+                self.ghost_map.remove(&old);
+            }
+        }
+    }
+
+    fn clear(&mut self) {
+        self.slab.clear();
+        self.free.clear();
+        self.map.clear();
+        self.small.clear();
+        self.main.clear();
+        self.ghost.clear();
+        self.ghost_map.clear();
+    }
+
+    /// Main queue entries newest first, then the small queue's
+    fn iter(&self) -> impl Iterator<Item = (&K, &V)> {
+        self.main
+            .iter()
+            .rev()
+            .chain(self.small.iter().rev())
+            .filter_map(|&index| self.slab[index].as_ref())
+            .map(|entry| (&entry.key, &entry.value))
+    }
+}
+
+/// Largest count a sketch counter holds
+const SKETCH_MAX: u8 = 15;
+
+/// Count-min sketch of recent key accesses, halved periodically so that
+/// old popularity fades
+struct FrequencySketch {
+    /// `SKETCH_ROWS` rows of `mask + 1` counters
+    counters: Box<[u8]>,
+    mask: usize,
+    additions: usize,
+    /// Additions between halvings
+    sample_size: usize,
+    hasher: FxBuildHasher,
+}
+
+/// Independent hash rows in the sketch
+const SKETCH_ROWS: usize = 4;
+
+impl FrequencySketch {
+    fn new(capacity: usize) -> Self {
+        let width = capacity.next_power_of_two().max(16);
+        Self {
+            counters: vec![0; width * SKETCH_ROWS].into_boxed_slice(),
+            mask: width - 1,
+            additions: 0,
+            sample_size: width * 10,
+            hasher: FxBuildHasher::default(),
+        }
+    }
+
+    /// Counter index of `hash` in `row`
+    #[inline]
+    fn index(&self, hash: u64, row: usize) -> usize {
+        let mixed = (hash ^ (row as u64).wrapping_mul(0x9E37_79B9_7F4A_7C15))
+            .wrapping_mul(0xBF58_476D_1CE4_E5B9);
+        row * (self.mask + 1) + ((mixed >> 32) as usize & self.mask)
+    }
+
+    fn increment<K: Hash>(&mut self, key: &K) {
+        let hash = self.hasher.hash_one(key);
+        for row in 0..SKETCH_ROWS {
+            let index = self.index(hash, row);
+            if self.counters[index] < SKETCH_MAX {
+                self.counters[index] += 1;
+            }
+        }
+        self.additions += 1;
+        if self.additions >= self.sample_size {
+            for counter in self.counters.iter_mut() {
+                *counter /= 2;
+            }
+            self.additions /= 2;
+        }
+    }
+
+    fn frequency<K: Hash>(&self, key: &K) -> u8 {
+        let hash = self.hasher.hash_one(key);
+        (0..SKETCH_ROWS)
+            .map(|row| self.counters[self.index(hash, row)])
+            .min()
+            .unwrap_or(0)
+    }
+
+    fn clear(&mut self) {
+        self.counters.fill(0);
+        self.additions = 0;
+    }
+}
+
+/// W-TinyLFU: an LRU window (1% of capacity) in front of a main LRU
+struct TinyLfuCache<K, V> {
+    window: LruCache<K, V, FxBuildHasher>,
+    main: LruCache<K, V, FxBuildHasher>,
+    sketch: FrequencySketch,
+}
+
+impl<K: Copy + Hash + Eq, V> TinyLfuCache<K, V> {
+    fn new(capacity: usize) -> Self {
+        let window = (capacity / 100).max(1);
+        let main = capacity.saturating_sub(window).max(1);
+        Self {
+            window: LruCache::with_hasher(
+                NonZeroUsize::new(window).unwrap(),
+                FxBuildHasher::default(),
+            ),
+            main: LruCache::with_hasher(NonZeroUsize::new(main).unwrap(), FxBuildHasher::default()),
+            sketch: FrequencySketch::new(capacity),
+        }
+    }
+
+    /// Every lookup counts towards the key's frequency, hit or miss, so a
+    /// miss followed by `push` is counted once
+    #[inline]
+    fn get(&mut self, key: &K) -> Option<&V> {
+        self.sketch.increment(key);
+        if self.main.contains(key) {
+            return self.main.get(key);
+        }
+        self.window.get(key)
+    }
+
+    #[inline]
+    fn peek_mut(&mut self, key: &K) -> Option<&mut V> {
+        if self.main.contains(key) {
+            return self.main.peek_mut(key);
+        }
+        self.window.peek_mut(key)
+    }
+
+    fn push(&mut self, key: K, value: V, counters: &mut CacheCounters) -> Option<(K, V)> {
+        if self.main.contains(&key) {
+            return self.main.push(key, value);
+        }
+
+        // New entries always enter the window; the one it pushes out
+        // competes with the main LRU's victim
+        let (candidate, candidate_value) = match self.window.push(key, value) {
+            Some((old_key, old_value)) if old_key != key => (old_key, old_value),
+            replaced => return replaced,
+        };
+        if self.main.len() < self.main.cap().get() {
+            self.main.put(candidate, candidate_value);
+            counters.promotions += 1;
+            return None;
+        }
+
+        let victim_frequency = self
+            .main
+            .peek_lru()
+            .map_or(0, |(victim, _)| self.sketch.frequency(victim));
+        counters.evictions += 1;
+        if self.sketch.frequency(&candidate) > victim_frequency {
+            let victim = self.main.pop_lru();
+            self.main.put(candidate, candidate_value);
+            counters.promotions += 1;
+            victim
+        } else {
+            counters.rejections += 1;
+            Some((candidate, candidate_value))
+        }
+    }
+
+    fn clear(&mut self) {
+        self.window.clear();
+        self.main.clear();
+        self.sketch.clear();
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const POLICIES: [CachePolicy; 4] = [
+        CachePolicy::Lru,
+        CachePolicy::Clock,
+        CachePolicy::S3Fifo,
+        CachePolicy::TinyLfu,
+    ];
+
+    fn cache(policy: CachePolicy, capacity: usize) -> PolicyCache<u64, u64> {
+        PolicyCache::new(policy, NonZeroUsize::new(capacity).unwrap())
+    }
+
+    #[test]
+    fn test_bounded_and_consistent() {
+        for policy in POLICIES {
+            let mut cache = cache(policy, 100);
+            for key in 0..10_000u64 {
+                // A skewed stream: a few hot keys among many cold ones
+                let key = if key % 3 == 0 { key % 20 } else { key };
+                if cache.get(&key).is_none() {
+                    cache.push(key, key * 2);
+                }
+                assert!(cache.len() <= cache.cap(), "{:?}", policy);
+            }
+            for (key, value) in cache.iter() {
+                assert_eq!(*value, key * 2, "{:?}", policy);
+            }
+            assert_eq!(cache.iter().count(), cache.len(), "{:?}", policy);
+            assert!(cache.counters().evictions > 0, "{:?}", policy);
+
+            cache.clear();
+            assert_eq!(cache.len(), 0);
+            assert!(cache.get(&1).is_none());
+        }
+    }
+
+    #[test]
+    fn test_push_returns_replaced_or_evicted() {
+        for policy in POLICIES {
+            let mut cache = cache(policy, 4);
+            assert!(cache.push(1, 10).is_none());
+            assert_eq!(cache.push(1, 11), Some((1, 10)), "{:?}", policy);
+            *cache.peek_mut(&1).unwrap() = 12;
+            assert_eq!(cache.get(&1), Some(&12));
+
+            let mut dropped = 0;
+            for key in 2..50u64 {
+                if let Some((old, value)) = cache.push(key, key) {
+                    assert_ne!(old, key, "{:?}", policy);
+                    assert!(cache.get(&old).is_none(), "{:?}", policy);
+                    assert!(value == old || (old == 1 && value == 12));
+                    dropped += 1;
+                }
+            }
+            assert_eq!(cache.len() + dropped, 49, "{:?}", policy);
+        }
+    }
+
+    #[test]
+    fn test_scan_resistance() {
+        // A hot set survives a scan of twice the capacity in unique keys
+        // under the policies that filter admission
+        for policy in [CachePolicy::S3Fifo, CachePolicy::TinyLfu] {
+            let mut cache = cache(policy, 200);
+            for _ in 0..5 {
+                for key in 0..50u64 {
+                    if cache.get(&key).is_none() {
+                        cache.push(key, key);
+                    }
+                }
+            }
+            for key in 1000..1400u64 {
+                if cache.get(&key).is_none() {
+                    cache.push(key, key);
+                }
+            }
+            let kept = (0..50u64)
+                .filter(|key| cache.peek_mut(key).is_some())
+                .count();
+            assert!(kept >= 40, "{:?} kept {} hot keys", policy, kept);
+        }
+    }
+}
@@ -27,6 +27,7 @@
 //!
 //! See: <https://maxmind.github.io/MaxMind-DB/>
 
+use crate::arena::Arena;
 use std::collections::HashMap;
 use std::hash::{Hash, Hasher};
 
@@ -620,6 +621,144 @@ impl Default for DataEncoder {
     }
 }
 
+/// A data section value decoded in place
+///
+/// Produced by [`DataDecoder::decode_ref`] without allocating: scalars are
+/// read out directly, strings and bytes borrow from the encoded buffer, and
+/// maps and arrays only report their length. Pointers are always followed,
+/// so a `ValueRef` is never a pointer.
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum ValueRef<'a> {
+    /// UTF-8 string (borrowed, not null-terminated)
+    String(&'a str),
+    /// IEEE 754 double precision float
+    Double(f64),
+    /// Raw byte array (borrowed)
+    Bytes(&'a [u8]),
+    /// Unsigned 16-bit integer
+    Uint16(u16),
+    /// Unsigned 32-bit integer
+    Uint32(u32),
+    /// Map with this many entries
+    Map(usize),
+    /// Signed 32-bit integer
+    Int32(i32),
+    /// Unsigned 64-bit integer
+    Uint64(u64),
+    /// Unsigned 128-bit integer
+    Uint128(u128),
+    /// Array with this many elements
+    Array(usize),
+    /// Boolean value
+    Bool(bool),
+    /// IEEE 754 single precision float
+    Float(f32),
+}
+
+/// A data section value decoded into an [`Arena`]
+///
+/// Produced by [`DataDecoder::decode_in`]. Strings and bytes borrow from the
+/// encoded buffer; map and array contents are slices carved from the arena,
+/// so decoding a record makes no heap allocations. Map entries keep their
+/// encoded order. Serializes to the same JSON as the equivalent
+/// [`DataValue`].
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum ArenaValue<'a> {
+    /// UTF-8 string (borrowed, not null-terminated)
+    String(&'a str),
+    /// IEEE 754 double precision float
+    Double(f64),
+    /// Raw byte array (borrowed)
+    Bytes(&'a [u8]),
+    /// Unsigned 16-bit integer
+    Uint16(u16),
+    /// Unsigned 32-bit integer
+    Uint32(u32),
+    /// Key-value pairs in encoded order
+    Map(&'a [(&'a str, ArenaValue<'a>)]),
+    /// Signed 32-bit integer
+    Int32(i32),
+    /// Unsigned 64-bit integer
+    Uint64(u64),
+    /// Unsigned 128-bit integer
+    Uint128(u128),
+    /// Array of values
+    Array(&'a [ArenaValue<'a>]),
+    /// Boolean value
+    Bool(bool),
+    /// IEEE 754 single precision float
+    Float(f32),
+}
+
+impl ArenaValue<'_> {
+    /// Look up a map entry by key (linear scan; `None` for non-maps)
+    pub fn get(&self, key: &str) -> Option<&Self> {
+        match self {
+            ArenaValue::Map(entries) => entries.iter().find(|(k, _)| *k == key).map(|(_, v)| v),
+            _ => None,
+        }
+    }
+
+    /// Copy into an owned [`DataValue`] (allocates)
+    pub fn to_data_value(&self) -> DataValue {
+        match *self {
+            ArenaValue::String(s) => DataValue::String(s.to_string()),
+            ArenaValue::Double(d) => DataValue::Double(d),
+            ArenaValue::Bytes(b) => DataValue::Bytes(b.to_vec()),
+            ArenaValue::Uint16(n) => DataValue::Uint16(n),
+            ArenaValue::Uint32(n) => DataValue::Uint32(n),
+            ArenaValue::Map(entries) => DataValue::Map(
+                entries
+                    .iter()
+                    .map(|(k, v)| (k.to_string(), v.to_data_value()))
+                    .collect(),
+            ),
+            ArenaValue::Int32(n) => DataValue::Int32(n),
+            ArenaValue::Uint64(n) => DataValue::Uint64(n),
+            ArenaValue::Uint128(n) => DataValue::Uint128(n),
+            ArenaValue::Array(items) => {
+                DataValue::Array(items.iter().map(ArenaValue::to_data_value).collect())
+            }
+            ArenaValue::Bool(b) => DataValue::Bool(b),
+            ArenaValue::Float(f) => DataValue::Float(f),
+        }
+    }
+}
+
+// Mirrors the DataValue serialization, with maps in encoded order
+impl serde::Serialize for ArenaValue<'_> {
+    fn serialize<S>(&self, serializer: S) -> Result<S::Ok, S::Error>
+    where
+        S: serde::Serializer,
+    {
+        use serde::ser::SerializeMap;
+
+        match *self {
+            ArenaValue::String(s) => serializer.serialize_str(s),
+            ArenaValue::Double(d) => serializer.serialize_f64(d),
+            ArenaValue::Bytes(b) => serializer.serialize_bytes(b),
+            ArenaValue::Uint16(n) => serializer.serialize_u16(n),
+            ArenaValue::Uint32(n) => serializer.serialize_u32(n),
+            ArenaValue::Map(entries) => {
+                let mut map = serializer.serialize_map(Some(entries.len()))?;
+                for (key, value) in entries {
+                    map.serialize_entry(key, value)?;
+                }
+                map.end()
+            }
+            ArenaValue::Int32(n) => serializer.serialize_i32(n),
+            ArenaValue::Uint64(n) => serializer.serialize_u64(n),
+            ArenaValue::Uint128(n) => serializer.serialize_u128(n),
+            ArenaValue::Array(items) => serializer.collect_seq(items),
+            ArenaValue::Bool(b) => serializer.serialize_bool(b),
+            ArenaValue::Float(f) => serializer.serialize_f32(f),
+        }
+    }
+}
+
+/// Longest pointer chain followed before data is treated as corrupt
+const MAX_POINTER_CHAIN: usize = 8;
+
 /// Data section decoder
 ///
 /// Decodes values from an encoded data section buffer.
@@ -654,6 +793,356 @@ impl<'a> DataDecoder<'a> {
         self.resolve_pointers(value)
     }
 
+    /// Decode the value at `offset` in place, without allocating
+    ///
+    /// Pointers are followed. For maps and arrays only the length is
+    /// returned; use [`lookup_path`](Self::lookup_path) or
+    /// [`walk`](Self::walk) to reach their contents.
+    pub fn decode_ref(&self, offset: u32) -> Result<ValueRef<'a>, &'static str> {
+        let mut cursor = self.follow_pointers(self.cursor_for(offset)?)?;
+        self.decode_ref_at(&mut cursor)
+    }
+
+    /// Decode the value at `offset` into `arena`, without heap allocation
+    ///
+    /// Like [`decode`](Self::decode), but strings and bytes borrow from the
+    /// data section and map and array contents are carved from `arena`.
+    /// Pointers are followed. Everything is released by the arena's next
+    /// reset.
+    pub fn decode_in<'b>(
+        &self,
+        offset: u32,
+        arena: &'b Arena,
+    ) -> Result<ArenaValue<'b>, &'static str>
+    where
+        'a: 'b,
+    {
+        let mut cursor = self.cursor_for(offset)?;
+        self.decode_in_at(&mut cursor, arena)
+    }
+
+    /// Find the value at `path` below the value at `offset`
+    ///
+    /// Each path element is a map key or, for arrays, a decimal index.
+    /// Siblings that are not on the path are skipped over without being
+    /// decoded, so the cost is proportional to the bytes before the target
+    /// rather than the size of the whole record. Nothing is allocated.
+    ///
+    /// Returns the offset of the target value (pointers already followed),
+    /// or `None` if the path does not exist.
+    pub fn lookup_path<I, K>(&self, offset: u32, path: I) -> Result<Option<u32>, &'static str>
+    where
+        I: IntoIterator<Item = K>,
+        K: AsRef<[u8]>,
+    {
+        let mut cursor = self.follow_pointers(self.cursor_for(offset)?)?;
+
+        for key in path {
+            let key = key.as_ref();
+            let mut pos = cursor;
+            let (type_id, payload) = self.read_control(&mut pos)?;
+            let len = self.decode_size(&mut pos, payload)?;
+
+            match type_id {
+                7 => {
+                    let mut found = false;
+                    for _ in 0..len {
+                        if self.decode_key(&mut pos)? == key {
+                            found = true;
+                            break;
+                        }
+                        self.skip_at(&mut pos)?;
+                    }
+                    if !found {
+                        return Ok(None);
+                    }
+                }
+                11 => {
+                    let index = match std::str::from_utf8(key).ok().and_then(|k| k.parse().ok()) {
+                        Some(index) if index < len => index,
+                        _ => return Ok(None),
+                    };
+                    for _ in 0..index {
+                        self.skip_at(&mut pos)?;
+                    }
+                }
+                _ => return Ok(None),
+            }
+
+            cursor = self.follow_pointers(pos)?;
+        }
+
+        Ok(Some((cursor + self.base_offset) as u32))
+    }
+
+    /// Visit every value below `offset` in encoded (pre-)order
+    ///
+    /// `visit` receives each value's offset, its map key (`None` for the
+    /// root and for array elements) and the value itself. Map and array
+    /// values are visited before their children. Nothing is allocated.
+    pub fn walk<F>(&self, offset: u32, visit: &mut F) -> Result<(), &'static str>
+    where
+        F: FnMut(u32, Option<&'a str>, ValueRef<'a>),
+    {
+        let mut cursor = self.cursor_for(offset)?;
+        self.walk_at(&mut cursor, None, visit)
+    }
+
+    fn walk_at<F>(
+        &self,
+        cursor: &mut usize,
+        key: Option<&'a str>,
+        visit: &mut F,
+    ) -> Result<(), &'static str>
+    where
+        F: FnMut(u32, Option<&'a str>, ValueRef<'a>),
+    {
+        // A pointer is walked where it points; the cursor moves past it
+        let mut target = self.follow_pointers(*cursor)?;
+        let in_place = target == *cursor;
+        if !in_place {
+            self.skip_at(cursor)?;
+        }
+
+        let value_offset = (target + self.base_offset) as u32;
+        let value = self.decode_ref_at(&mut target)?;
+        visit(value_offset, key, value);
+
+        match value {
+            ValueRef::Map(len) => {
+                for _ in 0..len {
+                    let key = std::str::from_utf8(self.decode_key(&mut target)?)
+                        .map_err(|_| "Invalid UTF-8")?;
+                    self.walk_at(&mut target, Some(key), visit)?;
+                }
+            }
+            ValueRef::Array(len) => {
+                for _ in 0..len {
+                    self.walk_at(&mut target, None, visit)?;
+                }
+            }
+            _ => {}
+        }
+
+        if in_place {
+            *cursor = target;
+        }
+        Ok(())
+    }
+
+    fn decode_in_at<'b>(
+        &self,
+        cursor: &mut usize,
+        arena: &'b Arena,
+    ) -> Result<ArenaValue<'b>, &'static str>
+    where
+        'a: 'b,
+    {
+        // A pointer is decoded where it points; the cursor moves past it
+        let mut target = self.follow_pointers(*cursor)?;
+        let in_place = target == *cursor;
+        if !in_place {
+            self.skip_at(cursor)?;
+        }
+
+        let value = match self.decode_ref_at(&mut target)? {
+            ValueRef::Map(len) => {
+                // Every entry takes at least two bytes: refuse impossible sizes
+                // before reserving arena space for them
+                if len > self.buffer.len().saturating_sub(target) / 2 {
+                    return Err("Map too large");
+                }
+                ArenaValue::Map(arena.try_alloc_slice_with(len, |_| {
+                    let key = std::str::from_utf8(self.decode_key(&mut target)?)
+                        .map_err(|_| "Invalid UTF-8")?;
+                    Ok((key, self.decode_in_at(&mut target, arena)?))
+                })?)
+            }
+            ValueRef::Array(len) => {
+                if len > self.buffer.len().saturating_sub(target) {
+                    return Err("Array too large");
+                }
+                ArenaValue::Array(
+                    arena.try_alloc_slice_with(len, |_| self.decode_in_at(&mut target, arena))?,
+                )
+            }
+            ValueRef::String(s) => ArenaValue::String(s),
+            ValueRef::Double(d) => ArenaValue::Double(d),
+            ValueRef::Bytes(b) => ArenaValue::Bytes(b),
+            ValueRef::Uint16(n) => ArenaValue::Uint16(n),
+            ValueRef::Uint32(n) => ArenaValue::Uint32(n),
+            ValueRef::Int32(n) => ArenaValue::Int32(n),
+            ValueRef::Uint64(n) => ArenaValue::Uint64(n),
+            ValueRef::Uint128(n) => ArenaValue::Uint128(n),
+            ValueRef::Bool(b) => ArenaValue::Bool(b),
+            ValueRef::Float(f) => ArenaValue::Float(f),
+        };
+
+        if in_place {
+            *cursor = target;
+        }
+        Ok(value)
+    }
+
+    /// Convert a public offset into a buffer cursor
+    fn cursor_for(&self, offset: u32) -> Result<usize, &'static str> {
+        (offset as usize)
+            .checked_sub(self.base_offset)
+            .ok_or("Offset before base")
+    }
+
+    /// Resolve a (chain of) pointer(s) at `cursor` to the value's cursor
+    fn follow_pointers(&self, mut cursor: usize) -> Result<usize, &'static str> {
+        for _ in 0..MAX_POINTER_CHAIN {
+            let ctrl = *self.buffer.get(cursor).ok_or("Cursor out of bounds")?;
+            if ctrl >> 5 != 1 {
+                return Ok(cursor);
+            }
+            cursor += 1;
+            match self.decode_pointer(&mut cursor, ctrl & 0x1F)? {
+                DataValue::Pointer(offset) => cursor = self.cursor_for(offset)?,
+                _ => return Err("Invalid pointer"),
+            }
+        }
+        Err("Pointer chain too long")
+    }
+
+    /// Read a control byte, returning `(type_id, payload)`
+    ///
+    /// Extended types are folded into `type_id` (8 and up).
+    fn read_control(&self, cursor: &mut usize) -> Result<(u8, u8), &'static str> {
+        let ctrl = *self.buffer.get(*cursor).ok_or("Cursor out of bounds")?;
+        *cursor += 1;
+
+        let type_id = ctrl >> 5;
+        let payload = ctrl & 0x1F;
+        if type_id != 0 {
+            return Ok((type_id, payload));
+        }
+
+        let raw_ext_type = *self.buffer.get(*cursor).ok_or("Extended type truncated")?;
+        *cursor += 1;
+        let type_id = raw_ext_type.checked_add(7).ok_or("Unknown extended type")?;
+        Ok((type_id, payload))
+    }
+
+    /// Decode a map key (string or pointer to string) as raw bytes
+    fn decode_key(&self, cursor: &mut usize) -> Result<&'a [u8], &'static str> {
+        let mut target = self.follow_pointers(*cursor)?;
+        let in_place = target == *cursor;
+        if !in_place {
+            self.skip_at(cursor)?;
+        }
+
+        let (type_id, payload) = self.read_control(&mut target)?;
+        if type_id != 2 {
+            return Err("Map key must be string or pointer to string");
+        }
+        let len = self.decode_size(&mut target, payload)?;
+        let key = self.take(&mut target, len)?;
+
+        if in_place {
+            *cursor = target;
+        }
+        Ok(key)
+    }
+
+    /// Borrow the next `len` bytes
+    fn take(&self, cursor: &mut usize, len: usize) -> Result<&'a [u8], &'static str> {
+        let end = cursor.checked_add(len).ok_or("Data out of bounds")?;
+        let bytes = self.buffer.get(*cursor..end).ok_or("Data out of bounds")?;
+        *cursor = end;
+        Ok(bytes)
+    }
+
+    /// Read a big-endian unsigned integer of `size` bytes (at most `max`)
+    fn read_uint(&self, cursor: &mut usize, size: usize, max: usize) -> Result<u128, &'static str> {
+        if size > max {
+            return Err("Integer size too large");
+        }
+        let bytes = self.take(cursor, size)?;
+        Ok(bytes.iter().fold(0u128, |acc, &b| (acc << 8) | b as u128))
+    }
+
+    fn decode_ref_at(&self, cursor: &mut usize) -> Result<ValueRef<'a>, &'static str> {
+        let (type_id, payload) = self.read_control(cursor)?;
+        if type_id == 1 {
+            return Err("Unexpected pointer");
+        }
+        let size = self.decode_size(cursor, payload)?;
+
+        Ok(match type_id {
+            2 => ValueRef::String(
+                std::str::from_utf8(self.take(cursor, size)?).map_err(|_| "Invalid UTF-8")?,
+            ),
+            3 => {
+                let bytes = self.take(cursor, 8)?;
+                ValueRef::Double(f64::from_be_bytes(bytes.try_into().unwrap()))
+            }
+            4 => ValueRef::Bytes(self.take(cursor, size)?),
+            5 => ValueRef::Uint16(self.read_uint(cursor, size, 2)? as u16),
+            6 => ValueRef::Uint32(self.read_uint(cursor, size, 4)? as u32),
+            7 => ValueRef::Map(size),
+            8 => {
+                let raw = self.read_uint(cursor, size, 4)? as u32;
+                // Sign-extend from the encoded width
+                let shift = 32 - 8 * size as u32;
+                ValueRef::Int32(if size == 0 {
+                    0
+                } else {
+                    ((raw << shift) as i32) >> shift
+                })
+            }
+            9 => ValueRef::Uint64(self.read_uint(cursor, size, 8)? as u64),
+            10 => ValueRef::Uint128(self.read_uint(cursor, size, 16)?),
+            11 => ValueRef::Array(size),
+            14 => ValueRef::Bool(size != 0),
+            15 => {
+                if size != 4 {
+                    return Err("Float must be 4 bytes");
+                }
+                let bytes = self.take(cursor, 4)?;
+                ValueRef::Float(f32::from_be_bytes(bytes.try_into().unwrap()))
+            }
+            _ => return Err("Unknown extended type"),
+        })
+    }
+
+    /// Move the cursor past one complete value without decoding it
+    ///
+    /// Pointers are stepped over, not followed.
+    fn skip_at(&self, cursor: &mut usize) -> Result<(), &'static str> {
+        let mut pending = 1usize;
+        while pending > 0 {
+            pending -= 1;
+
+            let (type_id, payload) = self.read_control(cursor)?;
+            if type_id == 1 {
+                let pointer_len = ((payload >> 3) & 0x3) as usize + 1;
+                self.take(cursor, pointer_len)?;
+                continue;
+            }
+
+            let size = self.decode_size(cursor, payload)?;
+            match type_id {
+                2 | 4 | 5 | 6 | 8 | 9 | 10 => {
+                    self.take(cursor, size)?;
+                }
+                3 => {
+                    self.take(cursor, 8)?;
+                }
+                15 => {
+                    self.take(cursor, 4)?;
+                }
+                14 => {}
+                7 => pending = pending.checked_add(size * 2).ok_or("Map too large")?,
+                11 => pending = pending.checked_add(size).ok_or("Array too large")?,
+                _ => return Err("Unknown extended type"),
+            }
+        }
+        Ok(())
+    }
+
     fn decode_at(&self, cursor: &mut usize) -> Result<DataValue, &'static str> {
         if *cursor >= self.buffer.len() {
             return Err("Cursor out of bounds");
@@ -1350,4 +1839,179 @@ mod tests {
             panic!("Expected Map, got {:?}", decoded);
         }
     }
+
+    #[test]
+    fn test_decode_ref_matches_decode() {
+        let mut encoder = DataEncoder::new();
+        let values = [
+            DataValue::String("hello".to_string()),
+            DataValue::Uint16(12345),
+            DataValue::Uint32(0xDEADBEEF),
+            DataValue::Uint64(0x123456789ABCDEF0),
+            DataValue::Uint128(0x0123456789ABCDEF0123456789ABCDEF),
+            DataValue::Int32(-42),
+            DataValue::Int32(7),
+            DataValue::Double(std::f64::consts::PI),
+            DataValue::Float(std::f32::consts::E),
+            DataValue::Bool(true),
+            DataValue::Bytes(vec![0xDE, 0xAD, 0xBE, 0xEF]),
+        ];
+        let offsets: Vec<u32> = values.iter().map(|v| encoder.encode(v)).collect();
+
+        let bytes = encoder.into_bytes();
+        let decoder = DataDecoder::new(&bytes, 0);
+
+        let expected = [
+            ValueRef::String("hello"),
+            ValueRef::Uint16(12345),
+            ValueRef::Uint32(0xDEADBEEF),
+            ValueRef::Uint64(0x123456789ABCDEF0),
+            ValueRef::Uint128(0x0123456789ABCDEF0123456789ABCDEF),
+            ValueRef::Int32(-42),
+            ValueRef::Int32(7),
+            ValueRef::Double(std::f64::consts::PI),
+            ValueRef::Float(std::f32::consts::E),
+            ValueRef::Bool(true),
+            ValueRef::Bytes(&[0xDE, 0xAD, 0xBE, 0xEF]),
+        ];
+        for (offset, expected) in offsets.iter().zip(expected.iter()) {
+            assert_eq!(&decoder.decode_ref(*offset).unwrap(), expected);
+        }
+    }
+
+    #[test]
+    fn test_lookup_path_in_place() {
+        let mut encoder = DataEncoder::new();
+
+        let mut names = HashMap::new();
+        names.insert("en".to_string(), DataValue::String("Germany".to_string()));
+        names.insert(
+            "de".to_string(),
+            DataValue::String("Deutschland".to_string()),
+        );
+        let mut country = HashMap::new();
+        country.insert("iso_code".to_string(), DataValue::String("DE".to_string()));
+        country.insert("names".to_string(), DataValue::Map(names));
+        let mut root = HashMap::new();
+        root.insert("country".to_string(), DataValue::Map(country));
+        root.insert(
+            "tags".to_string(),
+            DataValue::Array(vec![
+                DataValue::String("a".to_string()),
+                DataValue::Uint32(2),
+                DataValue::Bool(false),
+            ]),
+        );
+        // Encode the strings first so the record's keys and values are pointers
+        let seed = [
+            "country", "iso_code", "DE", "names", "en", "de", "tags", "a",
+        ];
+        encoder.encode(&DataValue::Array(
+            seed.iter()
+                .map(|s| DataValue::String(s.to_string()))
+                .collect(),
+        ));
+        let offset = encoder.encode(&DataValue::Map(root));
+
+        let bytes = encoder.into_bytes();
+        let decoder = DataDecoder::new(&bytes, 0);
+
+        let at = |path: &[&str]| {
+            decoder
+                .lookup_path(offset, path)
+                .unwrap()
+                .map(|o| decoder.decode_ref(o).unwrap())
+        };
+        assert_eq!(at(&["country", "iso_code"]), Some(ValueRef::String("DE")));
+        assert_eq!(
+            at(&["country", "names", "de"]),
+            Some(ValueRef::String("Deutschland"))
+        );
+        assert_eq!(at(&["tags", "1"]), Some(ValueRef::Uint32(2)));
+        assert_eq!(at(&["tags", "2"]), Some(ValueRef::Bool(false)));
+        assert_eq!(at(&["country", "names"]), Some(ValueRef::Map(2)));
+        assert_eq!(at(&[]), Some(ValueRef::Map(2)));
+        assert_eq!(at(&["tags", "3"]), None);
+        assert_eq!(at(&["tags", "x"]), None);
+        assert_eq!(at(&["country", "missing"]), None);
+        assert_eq!(at(&["country", "iso_code", "deeper"]), None);
+    }
+
+    #[test]
+    fn test_walk_visits_every_value() {
+        let mut encoder = DataEncoder::new();
+        let mut map = HashMap::new();
+        map.insert("name".to_string(), DataValue::String("x".to_string()));
+        map.insert(
+            "list".to_string(),
+            DataValue::Array(vec![DataValue::Uint16(1), DataValue::Uint16(2)]),
+        );
+        // Seed the interner so "name" and "x" are encoded as pointers
+        encoder.encode(&DataValue::Array(vec![
+            DataValue::String("name".to_string()),
+            DataValue::String("x".to_string()),
+        ]));
+        let offset = encoder.encode(&DataValue::Map(map));
+
+        let bytes = encoder.into_bytes();
+        let decoder = DataDecoder::new(&bytes, 0);
+
+        let mut seen = Vec::new();
+        decoder
+            .walk(offset, &mut |_, key, value| seen.push((key, value)))
+            .unwrap();
+
+        assert_eq!(seen.len(), 5);
+        assert_eq!(seen[0], (None, ValueRef::Map(2)));
+        assert!(seen.contains(&(Some("name"), ValueRef::String("x"))));
+        assert!(seen.contains(&(Some("list"), ValueRef::Array(2))));
+        assert!(seen.contains(&(None, ValueRef::Uint16(1))));
+        assert!(seen.contains(&(None, ValueRef::Uint16(2))));
+    }
+
+    #[test]
+    fn test_decode_in_matches_decode() {
+        let mut encoder = DataEncoder::new();
+        let mut location = HashMap::new();
+        location.insert("latitude".to_string(), DataValue::Double(37.751));
+        location.insert("radius".to_string(), DataValue::Uint16(1000));
+        let mut root = HashMap::new();
+        root.insert("country".to_string(), DataValue::String("US".to_string()));
+        root.insert("location".to_string(), DataValue::Map(location));
+        root.insert(
+            "tags".to_string(),
+            DataValue::Array(vec![
+                DataValue::String("US".to_string()),
+                DataValue::Int32(-5),
+                DataValue::Uint128(1 << 40),
+                DataValue::Bytes(vec![1, 2]),
+                DataValue::Bool(true),
+            ]),
+        );
+        let record = DataValue::Map(root);
+        // Encode twice so the second copy is made of pointers
+        encoder.encode(&record);
+        let offset = encoder.encode(&record);
+
+        let bytes = encoder.into_bytes();
+        let decoder = DataDecoder::new(&bytes, 0);
+        let arena = Arena::with_chunk_size(64);
+
+        let value = decoder.decode_in(offset, &arena).unwrap();
+        assert_eq!(value.to_data_value(), decoder.decode(offset).unwrap());
+        assert_eq!(value.get("country"), Some(&ArenaValue::String("US")));
+        assert_eq!(
+            value.get("location").and_then(|l| l.get("radius")),
+            Some(&ArenaValue::Uint16(1000))
+        );
+
+        // Same JSON as the decoded value, modulo map order
+        let json: serde_json::Value =
+            serde_json::from_str(arena.alloc_json(&value).unwrap()).unwrap();
+        assert_eq!(json, serde_json::to_value(&record).unwrap());
+
+        // Corrupt sizes are rejected before reserving arena space
+        let bogus = [0xFF, 0xFF, 0xFF, 0xFF]; // map of 16M+ entries
+        assert!(DataDecoder::new(&bogus, 0).decode_in(0, &arena).is_err());
+    }
 }
@@ -8,18 +8,29 @@
 //! The database format is automatically detected and the appropriate
 //! lookup method is used transparently.
 
-use crate::data_section::DataValue;
+use crate::cache_policy::CachePolicy;
+use crate::data_section::{DataDecoder, DataValue};
 use crate::literal_hash::LiteralHash;
-use crate::mmdb::{MmdbError, MmdbHeader, SearchTree};
-use crate::paraglob_offset::Paraglob;
-use lru::LruCache;
+use crate::mmdb::types::IpVersion;
+use crate::mmdb::{
+    Ipv4DirectIndex, LookupResult, MmdbError, MmdbHeader, SearchTree, StrideHeader, StrideIndex,
+};
+use crate::paraglob_offset::{Paraglob, ParaglobScratch};
+use crate::prefilter::{Prefilter, PrefilterHeader};
+use crate::profile::{QueryProfiler, QueryStage};
+use crate::query_cache::{
+    lock, thread_slot, CacheKey, CachedResult, MatchData, MatchRef, QueryCache, RecentKey,
+};
 use memmap2::Mmap;
-use std::cell::RefCell;
+use std::borrow::Cow;
+use std::collections::HashSet;
 use std::fs::File;
-use std::hash::BuildHasherDefault;
 use std::net::IpAddr;
-use std::num::NonZeroUsize;
+use std::ops::Range;
 use std::path::PathBuf;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex, MutexGuard, OnceLock};
+use std::time::Instant;
 
 /// Statistics for database queries and cache performance
 #[derive(Debug, Clone, Copy, Default)]
@@ -38,6 +49,14 @@ pub struct DatabaseStats {
     pub ip_queries: u64,
     /// Number of string queries (literal or pattern)
     pub string_queries: u64,
+    /// Cache entries evicted to make room for new ones
+    pub cache_evictions: u64,
+    /// New cache entries refused by the admission filter
+    /// ([`CachePolicy::TinyLfu`] only; also counted in `cache_evictions`)
+    pub cache_rejections: u64,
+    /// Cache entries the policy kept or moved up instead of evicting
+    /// (CLOCK second chances, S3-FIFO and W-TinyLFU promotions)
+    pub cache_promotions: u64,
 }
 
 impl DatabaseStats {
@@ -59,6 +78,146 @@ impl DatabaseStats {
             self.queries_with_match as f64 / self.total_queries as f64
         }
     }
+
+    /// Count one lookup served from the cache
+    fn record_cached(&mut self, handle: &CachedResult) {
+        self.total_queries += 1;
+        self.cache_hits += 1;
+        match handle {
+            CachedResult::NotFound => self.queries_without_match += 1,
+            _ => self.queries_with_match += 1,
+        }
+    }
+
+    /// Count one lookup that was not served from the cache
+    fn record_uncached(&mut self, result: &Option<QueryResult>, cache_enabled: bool) {
+        self.total_queries += 1;
+
+        // Track query type based on result
+        match result {
+            Some(QueryResult::Ip { .. }) => self.ip_queries += 1,
+            Some(QueryResult::Pattern { .. }) | Some(QueryResult::NotFound) | None => {
+                self.string_queries += 1
+            }
+        }
+
+        // Track cache miss if caching enabled
+        if cache_enabled {
+            self.cache_misses += 1;
+        }
+
+        // Track match/no-match (NotFound is NOT a match)
+        match result {
+            Some(QueryResult::NotFound) | None => self.queries_without_match += 1,
+            Some(_) => self.queries_with_match += 1,
+        }
+    }
+}
+
+/// Largest number of stat/scratch stripes worth allocating
+const MAX_STRIPES: usize = 64;
+
+/// One stripe of query counters, padded to its own cache line
+///
+/// Each thread bumps the stripe picked by its thread slot, so concurrent
+/// lookups don't bounce a shared counter line between cores.
+#[repr(align(64))]
+#[derive(Default)]
+struct StatsStripe {
+    total_queries: AtomicU64,
+    queries_with_match: AtomicU64,
+    queries_without_match: AtomicU64,
+    cache_hits: AtomicU64,
+    cache_misses: AtomicU64,
+    ip_queries: AtomicU64,
+    string_queries: AtomicU64,
+}
+
+/// One thread stripe of pattern matching buffers, padded to its own cache line
+///
+/// Neighbouring stripes are locked by different threads; padding keeps
+/// one thread's lock word off another's line.
+#[repr(align(64))]
+#[derive(Default)]
+struct ScratchStripe(Mutex<ParaglobScratch>);
+
+/// Thread-safe query counters, summed into a [`DatabaseStats`] on demand
+struct SharedStats {
+    stripes: Box<[StatsStripe]>,
+    /// `stripes.len() - 1` (stripe count is always a power of two)
+    mask: usize,
+}
+
+impl StatsStripe {
+    /// Publish locally tallied counts (skips untouched counters)
+    #[inline]
+    fn add(&self, tally: &DatabaseStats) {
+        let pairs = [
+            (&self.total_queries, tally.total_queries),
+            (&self.queries_with_match, tally.queries_with_match),
+            (&self.queries_without_match, tally.queries_without_match),
+            (&self.cache_hits, tally.cache_hits),
+            (&self.cache_misses, tally.cache_misses),
+            (&self.ip_queries, tally.ip_queries),
+            (&self.string_queries, tally.string_queries),
+        ];
+        for (counter, value) in pairs {
+            if value != 0 {
+                counter.fetch_add(value, Ordering::Relaxed);
+            }
+        }
+    }
+}
+
+impl SharedStats {
+    fn new(stripe_count: usize) -> Self {
+        Self {
+            stripes: (0..stripe_count).map(|_| StatsStripe::default()).collect(),
+            mask: stripe_count - 1,
+        }
+    }
+
+    /// Counters for the calling thread
+    #[inline]
+    fn local(&self) -> &StatsStripe {
+        &self.stripes[thread_slot() & self.mask]
+    }
+
+    /// Sum all stripes (approximate while queries are in flight)
+    fn snapshot(&self) -> DatabaseStats {
+        let mut stats = DatabaseStats::default();
+        for stripe in self.stripes.iter() {
+            stats.total_queries += stripe.total_queries.load(Ordering::Relaxed);
+            stats.queries_with_match += stripe.queries_with_match.load(Ordering::Relaxed);
+            stats.queries_without_match += stripe.queries_without_match.load(Ordering::Relaxed);
+            stats.cache_hits += stripe.cache_hits.load(Ordering::Relaxed);
+            stats.cache_misses += stripe.cache_misses.load(Ordering::Relaxed);
+            stats.ip_queries += stripe.ip_queries.load(Ordering::Relaxed);
+            stats.string_queries += stripe.string_queries.load(Ordering::Relaxed);
+        }
+        stats
+    }
+}
+
+/// Position of `part` within `data`, if it is a slice of it
+fn range_within(data: &[u8], part: &[u8]) -> Option<Range<usize>> {
+    let start = (part.as_ptr() as usize).checked_sub(data.as_ptr() as usize)?;
+    (start + part.len() <= data.len()).then(|| start..start + part.len())
+}
+
+/// Number of stat/scratch stripes for the expected concurrency
+fn stripe_count_for(concurrency: usize) -> usize {
+    concurrency.max(1).next_power_of_two().min(MAX_STRIPES)
+}
+
+/// Number of pattern scratch stripes for the expected concurrency
+///
+/// Never fewer than one per core: an unhinted handle shared across threads
+/// would otherwise run every glob lookup through a single scratch lock.
+/// Empty scratch owns no heap memory, so idle stripes cost one cache line.
+pub(crate) fn scratch_stripe_count_for(concurrency: usize) -> usize {
+    let cores = std::thread::available_parallelism().map_or(1, |n| n.get());
+    stripe_count_for(concurrency.max(cores))
 }
 
 /// Query result from a database lookup
@@ -82,6 +241,55 @@ pub enum QueryResult {
     NotFound,
 }
 
+/// Location of a match's data in the database's data section
+///
+/// Returned by [`Database::lookup_ref`]. The data stays encoded in the
+/// (usually memory-mapped) file; read it with [`Database::data_decoder`].
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct DataRef {
+    /// Offset of the record within the data section
+    pub offset: u32,
+    /// Network prefix length (CIDR) for IP matches, 0 for string matches
+    pub prefix_len: u8,
+}
+
+/// Iterator over a database's IP networks, from [`Database::networks`]
+pub struct Networks<'a> {
+    db: &'a Database,
+    /// None for pattern-only databases
+    tree: Option<crate::mmdb::tree::Networks<'a>>,
+}
+
+impl Iterator for Networks<'_> {
+    type Item = Result<(IpAddr, DataRef), DatabaseError>;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        for network in self.tree.as_mut()? {
+            match network {
+                Ok((_, _, offset)) if self.db.is_tombstone(offset) => continue,
+                Ok((addr, prefix_len, offset)) => {
+                    return Some(Ok((addr, DataRef { offset, prefix_len })))
+                }
+                Err(e) => return Some(Err(DatabaseError::Format(e))),
+            }
+        }
+        None
+    }
+}
+
+/// Input positions of `addrs` in address order, with the sorted addresses
+///
+/// Already sorted input (the common case for bulk enrichment) is borrowed.
+fn address_order(addrs: &[IpAddr]) -> (Vec<usize>, Cow<'_, [IpAddr]>) {
+    let mut order: Vec<usize> = (0..addrs.len()).collect();
+    if addrs.windows(2).all(|pair| pair[0] <= pair[1]) {
+        return (order, Cow::Borrowed(addrs));
+    }
+    order.sort_by_key(|&index| addrs[index]);
+    let sorted = order.iter().map(|&index| addrs[index]).collect();
+    (order, Cow::Owned(sorted))
+}
+
 /// Database format type
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
 enum DatabaseFormat {
@@ -162,8 +370,51 @@ impl PatternDataMappings {
     }
 }
 
-/// Default LRU cache size for query results
-/// ~1-5 MB memory usage depending on result sizes
+/// Glob matcher of a pattern section with its data offsets
+struct PatternSection {
+    matcher: Paraglob,
+    /// Pattern ID -> data offset table (combined databases only)
+    data_mappings: Option<PatternDataMappings>,
+}
+
+/// A string section parsed at open, or on first use after a trusted open
+///
+/// A failed parse is kept, so every later use reports the same error.
+struct LazySection<T> {
+    /// Where the section starts; None when the file has no such section
+    offset: Option<usize>,
+    value: OnceLock<Result<T, String>>,
+}
+
+impl<T> LazySection<T> {
+    fn new(offset: Option<usize>) -> Self {
+        Self {
+            offset,
+            value: OnceLock::new(),
+        }
+    }
+
+    fn is_present(&self) -> bool {
+        self.offset.is_some()
+    }
+
+    /// The parsed section, running `load` on it the first time
+    fn get_or_load(
+        &self,
+        load: impl FnOnce(usize) -> Result<T, String>,
+    ) -> Result<Option<&T>, DatabaseError> {
+        let Some(offset) = self.offset else {
+            return Ok(None);
+        };
+        match self.value.get_or_init(|| load(offset)) {
+            Ok(value) => Ok(Some(value)),
+            Err(e) => Err(DatabaseError::Unsupported(e.clone())),
+        }
+    }
+}
+
+/// Default LRU cache size for query results, split between string and IP
+/// queries. Entries are fixed-size handles, ~1 MB in total
 const DEFAULT_QUERY_CACHE_SIZE: usize = 10_000;
 
 /// Options for opening a database
@@ -172,9 +423,59 @@ pub struct DatabaseOptions {
     /// Path to the database file (optional for from_bytes)
     pub path: PathBuf,
 
-    /// LRU cache capacity (None = use default, Some(0) = disable)
+    /// LRU cache capacity, split between string and IP queries
+    /// (None = use default, Some(0) = disable)
     pub cache_capacity: Option<usize>,
 
+    /// Replacement policy of the query cache
+    ///
+    /// See [`DatabaseOpener::cache_policy`].
+    pub cache_policy: CachePolicy,
+
+    /// Misses to remember outside the LRU cache (0 = keep them in the LRU)
+    ///
+    /// See [`DatabaseOpener::negative_cache`].
+    pub negative_cache_capacity: usize,
+
+    /// Defer parsing the string sections to their first use
+    ///
+    /// See [`DatabaseOpener::trusted`].
+    pub trusted: bool,
+
+    /// Fault in the hot sections at open, then read the rest ahead
+    ///
+    /// See [`DatabaseOpener::prefault`].
+    pub prefault: bool,
+
+    /// Lock the mapped file in RAM (`mlock`)
+    pub lock_memory: bool,
+
+    /// Ask for transparent huge pages over the mapping (Linux)
+    pub huge_pages: bool,
+
+    /// Expected number of threads querying this handle at once
+    ///
+    /// Handles are always safe to share; this only sizes the cache shards
+    /// and stat stripes. 1 (default) keeps a single shard. Pattern matching
+    /// scratch is per-thread regardless (at least one stripe per core).
+    pub concurrency: usize,
+
+    /// Build a DIR-16 table for IPv4 lookups at open time
+    ///
+    /// Costs 320 KiB and a walk of the tree's top 16 IPv4 levels; ignored
+    /// for files that carry a stride index, which serves lookups instead.
+    pub ipv4_direct_index: bool,
+
+    /// Delta databases layered over this one, oldest first
+    ///
+    /// See [`Database::with_overlay`].
+    pub overlays: Vec<PathBuf>,
+
+    /// Sampled per-stage query timing
+    ///
+    /// See [`DatabaseOpener::profiler`].
+    pub profiler: Option<Arc<QueryProfiler>>,
+
     /// Optional in-memory bytes (for from_bytes builder)
     pub bytes: Option<Vec<u8>>,
 }
@@ -184,6 +485,16 @@ impl Default for DatabaseOptions {
         Self {
             path: PathBuf::new(),
             cache_capacity: Some(DEFAULT_QUERY_CACHE_SIZE),
+            cache_policy: CachePolicy::Lru,
+            negative_cache_capacity: 0,
+            trusted: false,
+            prefault: false,
+            lock_memory: false,
+            huge_pages: false,
+            concurrency: 1,
+            ipv4_direct_index: false,
+            overlays: Vec::new(),
+            profiler: None,
             bytes: None,
         }
     }
@@ -228,7 +539,11 @@ impl DatabaseOpener {
     /// The cache dramatically improves performance for workloads with
     /// repeated queries (80-95% hit rates typical in log analysis).
     ///
-    /// Default: 10,000 entries (~1-5 MB memory)
+    /// String and IP queries are cached separately, each with half of
+    /// `capacity`. An entry is a small fixed-size handle, not a copy of the
+    /// result.
+    ///
+    /// Default: 10,000 entries (~1 MB memory)
     pub fn cache_capacity(mut self, capacity: usize) -> Self {
         self.options.cache_capacity = Some(capacity);
         self
@@ -243,11 +558,175 @@ impl DatabaseOpener {
         self
     }
 
+    /// Choose how the query cache picks entries to evict
+    ///
+    /// Strict LRU (the default) lets one burst of unique queries, such as
+    /// a log full of one-off URLs, flush the hot working set.
+    /// [`CachePolicy::S3Fifo`] and [`CachePolicy::TinyLfu`] only keep new
+    /// entries that prove popular; [`CachePolicy::Clock`] makes hits
+    /// cheaper. Compare policies with the `cache_*` counters of
+    /// [`Database::stats`].
+    ///
+    /// Default: [`CachePolicy::Lru`]
+    pub fn cache_policy(mut self, policy: CachePolicy) -> Self {
+        self.options.cache_policy = policy;
+        self
+    }
+
+    /// Remember about `capacity` misses in a separate negative cache
+    ///
+    /// By default a miss takes an LRU entry like any other result, and a
+    /// workload where most queries miss keeps evicting its hits. With a
+    /// negative cache, misses are instead recorded as 8-byte fingerprints
+    /// in a lock-free direct-mapped table; a repeated miss is answered with
+    /// one atomic load. Misses sharing a slot replace each other, which
+    /// only costs a repeat lookup. Works with or without the LRU cache.
+    ///
+    /// Entries are not checked against the query: a query whose 64-bit
+    /// fingerprint collides with a remembered miss is reported as not
+    /// found even if it matches. Fingerprints are keyed per handle, so the
+    /// chance is about `capacity / 2^64` per lookup and cannot be forced
+    /// by crafted input, but leave this off where a missed match is
+    /// unacceptable.
+    ///
+    /// Default: 0 (disabled)
+    pub fn negative_cache(mut self, capacity: usize) -> Self {
+        self.options.negative_cache_capacity = capacity;
+        self
+    }
+
+    /// Open a file you trust without setting up its string sections
+    ///
+    /// A normal open parses the literal hash table and the glob matcher
+    /// before returning. A trusted open only reads the metadata and the
+    /// section headers, checks them against the header checksum written by
+    /// the builder, and parses each string section on the first query that
+    /// needs it, so opening costs the same for any file size and only the
+    /// queried sections become resident. A section that turns out to be
+    /// malformed fails the queries that use it instead of the open.
+    ///
+    /// The checksum covers the start of every section, not the whole file:
+    /// it catches truncated, mismatched or partially copied files, not
+    /// arbitrary corruption. Validate files from untrusted sources with
+    /// `matchy validate` first. Files built without a checksum are opened
+    /// normally.
+    ///
+    /// Default: off
+    pub fn trusted(mut self, enabled: bool) -> Self {
+        self.options.trusted = enabled;
+        self
+    }
+
+    /// Load the file's pages at open instead of on the first queries
+    ///
+    /// A fresh mapping takes a page fault for every page a query touches,
+    /// so the first queries after an open (or a reload) are slow. With
+    /// prefaulting, the sections lookups read most (the IP tree or stride
+    /// index, the prefilter, the literal hash table and the glob automaton)
+    /// are faulted in before `open` returns, hottest first; the rest of the
+    /// file, mostly the data section, is read ahead in the background.
+    /// Files loaded from bytes are already resident.
+    ///
+    /// Default: off
+    pub fn prefault(mut self, enabled: bool) -> Self {
+        self.options.prefault = enabled;
+        self
+    }
+
+    /// Lock the mapped file in RAM so its pages are never evicted
+    ///
+    /// Faults in the whole file at open. Needs `CAP_IPC_LOCK` or a large
+    /// enough `RLIMIT_MEMLOCK`; opening fails if the lock is refused.
+    ///
+    /// Default: off
+    pub fn lock_memory(mut self, enabled: bool) -> Self {
+        self.options.lock_memory = enabled;
+        self
+    }
+
+    /// Ask the kernel to back the mapping with transparent huge pages
+    ///
+    /// Fewer TLB misses for lookups that jump around a large file. Linux
+    /// only, and file-backed huge pages need kernel support; elsewhere, or
+    /// when unsupported, this is silently ignored.
+    ///
+    /// Default: off
+    pub fn huge_pages(mut self, enabled: bool) -> Self {
+        self.options.huge_pages = enabled;
+        self
+    }
+
+    /// Size the handle for concurrent use by `threads` threads
+    ///
+    /// A `Database` is `Send + Sync` and can always be shared (e.g. via
+    /// `Arc`), and each thread always gets its own pattern matching
+    /// scratch. With a concurrency hint the query cache is also split into
+    /// independently locked shards, so many threads can share one warm
+    /// cache instead of each opening a private handle.
+    ///
+    /// Default: 1 (single shard, lowest memory)
+    pub fn concurrency(mut self, threads: usize) -> Self {
+        self.options.concurrency = threads.max(1);
+        self
+    }
+
+    /// Resolve the first 16 bits of IPv4 lookups with one table read
+    ///
+    /// Builds a 2^16-entry direct-index (DIR-16) table when the database
+    /// is opened, so an IPv4 lookup skips the top 16 levels of the tree.
+    /// Worthwhile for IPv4-heavy traffic; costs 320 KiB per handle.
+    ///
+    /// Default: off
+    pub fn ipv4_direct_index(mut self, enabled: bool) -> Self {
+        self.options.ipv4_direct_index = enabled;
+        self
+    }
+
+    /// Time a sample of queries stage by stage into `profiler`
+    ///
+    /// One query in every [`QueryProfiler::sample_every`] is split into
+    /// IP tree, literal hash, pattern scan, glob verification and data
+    /// decoding time, and counts the work each stage did; see
+    /// [`crate::profile`]. Other queries pay a thread-local counter
+    /// increment. Several handles can share one profiler.
+    ///
+    /// Default: none
+    pub fn profiler(mut self, profiler: Arc<QueryProfiler>) -> Self {
+        self.options.profiler = Some(profiler);
+        self
+    }
+
+    /// Layer a delta database over this one
+    ///
+    /// May be called several times; later overlays take precedence over
+    /// earlier ones. See [`Database::with_overlay`] for the lookup rules.
+    ///
+    /// ```no_run
+    /// use matchy::Database;
+    ///
+    /// let db = Database::from("threats.mxy")
+    ///     .overlay("threats-delta-0001.mxy")
+    ///     .overlay("threats-delta-0002.mxy")
+    ///     .open()?;
+    /// # Ok::<(), Box<dyn std::error::Error>>(())
+    /// ```
+    pub fn overlay(mut self, path: impl Into<PathBuf>) -> Self {
+        self.options.overlays.push(path.into());
+        self
+    }
+
     /// Open the database with configured options
     pub fn open(self) -> Result<Database, DatabaseError> {
         Database::open_with_options(self.options)
     }
 
+    /// Open a handle that can swap in a new version of the file at runtime
+    ///
+    /// See [`ReloadableDatabase`](crate::reload::ReloadableDatabase).
+    pub fn open_reloadable(self) -> Result<crate::reload::ReloadableDatabase, DatabaseError> {
+        crate::reload::ReloadableDatabase::open(self.options)
+    }
+
     /// Create a database opener from bytes (for testing/benchmarking)
     ///
     /// This allows you to configure cache settings before loading.
@@ -285,26 +764,88 @@ pub struct Database {
     data: DatabaseStorage,
     format: DatabaseFormat,
     ip_header: Option<MmdbHeader>,
-    /// Literal hash table for O(1) exact string lookups
-    literal_hash: Option<LiteralHash<'static>>,
+    /// Multi-bit stride index over the IP tree, when the file has one
+    /// IP lookups use it instead of walking the binary tree bit by bit
+    ip_stride: Option<StrideHeader>,
+    /// Optional DIR-16 table for the top of IPv4 lookups, built at open
+    ipv4_index: Option<Ipv4DirectIndex>,
+    /// Literal hash table for O(1) exact string lookups (offset of its marker)
+    literals: LazySection<LiteralHash<'static>>,
+    /// Bloom prefilter that rules out most string misses, when the file has one
+    prefilter: Option<Prefilter<'static>>,
     /// Pattern matcher for glob patterns (Combined or PatternOnly databases)
-    /// Uses RefCell for interior mutability since find_all needs &mut self
-    pattern_matcher: Option<RefCell<Paraglob>>,
-    /// For combined databases: lazy mapping from pattern_id -> data offset in MMDB data section
-    /// None for pattern-only databases (which use Paraglob's internal data)
-    pattern_data_mappings: Option<PatternDataMappings>,
-    /// LRU query cache for recent lookups (IP, string, pattern)
-    /// Uses RefCell for interior mutability on lookups
-    /// Uses FxHasher (same as literal hash table) for fast non-cryptographic hashing
+    /// Combined databases also carry the lazy pattern_id -> data offset
+    /// mapping; pattern-only databases use Paraglob's internal data
+    patterns: LazySection<PatternSection>,
+    /// Match mode recorded in the metadata (string sections only)
+    match_mode: crate::glob::MatchMode,
+    /// Per-thread pattern matching buffers, selected by thread slot
+    /// Lets concurrent lookups share one Paraglob without contending on it
+    pattern_scratch: Box<[ScratchStripe]>,
+    /// Sharded LRU query cache for recent lookups (IP, string, pattern)
+    /// Shared by all threads using this handle; disabled when capacity is 0
     /// Significantly improves performance for repeated queries (80-95% hit rate typical)
-    pub(crate) query_cache:
-        RefCell<LruCache<String, QueryResult, BuildHasherDefault<rustc_hash::FxHasher>>>,
-    /// Whether caching is enabled (false = skip cache operations entirely)
-    cache_enabled: bool,
-    /// Query statistics (uses RefCell for interior mutability)
-    stats: RefCell<DatabaseStats>,
+    query_cache: QueryCache,
+    /// Query statistics (striped atomic counters)
+    stats: SharedStats,
+    /// Data offset of the tombstone record (delta databases only)
+    /// Keys stored with it are treated as absent
+    tombstone_offset: Option<u32>,
+    /// Delta databases consulted before this one, oldest first
+    overlays: Vec<Overlay>,
+    /// Sampled per-stage timing, when profiling was asked for
+    profiler: Option<Arc<QueryProfiler>>,
+}
+
+/// A delta database layered over a base [`Database`]
+struct Overlay {
+    db: Database,
+    /// Glob patterns this layer defines or tombstones; they hide the same
+    /// pattern in older layers
+    globs: HashSet<String>,
+    /// Added to this layer's pattern IDs to keep them distinct from the
+    /// base's and other overlays' IDs
+    id_offset: u32,
+}
+
+/// A key as stored in a database section (see `Database::for_each_stored_entry`)
+pub(crate) enum StoredKey {
+    /// IP tree leaf network
+    Network(IpAddr, u8),
+    /// Literal hash entry (lowercased in case-insensitive databases)
+    Literal(String),
+    /// Glob pattern
+    Glob(String),
 }
 
+/// Where a stored key's data lives
+pub(crate) enum StoredData {
+    /// Record at this offset of the data section
+    Offset(u32),
+    /// Inline data of a pattern-only database
+    Value(Option<DataValue>),
+    /// The key is tombstoned (delta databases)
+    Tombstone,
+}
+
+/// How one layer contributes to a string lookup
+struct StringLayer<'a> {
+    /// 0 for the database itself, `n` for its nth overlay
+    index: u32,
+    /// Added to the layer's pattern IDs
+    id_offset: u32,
+    /// False once a newer layer held the exact key in its literal table
+    with_literal: bool,
+    /// Globs redefined by newer layers (None when there are none)
+    shadowed: Option<&'a dyn Fn(&str) -> bool>,
+}
+
+// Compile-time guarantee that handles can be shared across threads
+const _: () = {
+    const fn assert_send_sync<T: Send + Sync>() {}
+    assert_send_sync::<Database>();
+};
+
 impl Database {
     /// Create a database opener with fluent builder API
     ///
@@ -380,7 +921,7 @@ impl Database {
     /// # Ok::<(), Box<dyn std::error::Error>>(())
     /// ```
     pub fn clear_cache(&self) {
-        self.query_cache.borrow_mut().clear();
+        self.query_cache.clear();
     }
 
     /// Get current cache size (number of entries)
@@ -401,7 +942,54 @@ impl Database {
     /// # Ok::<(), Box<dyn std::error::Error>>(())
     /// ```
     pub fn cache_size(&self) -> usize {
-        self.query_cache.borrow().len()
+        self.query_cache.len()
+    }
+
+    /// Fill this handle's cache from another handle's hot queries
+    ///
+    /// Re-runs up to `limit` of `previous`'s most recently used cached
+    /// queries against this database, so a handle opened to replace
+    /// `previous` starts warm. Results come from this database, never from
+    /// `previous`, and are not counted in its statistics. Returns the number
+    /// of results cached.
+    ///
+    /// ```no_run
+    /// use matchy::Database;
+    ///
+    /// let old = Database::from("threats.mxy").open()?;
+    /// // ... serve queries, then a new feed arrives ...
+    /// let new = Database::from("threats.mxy").open()?;
+    /// new.warm_cache_from(&old, usize::MAX);
+    /// # Ok::<(), Box<dyn std::error::Error>>(())
+    /// ```
+    pub fn warm_cache_from(&self, previous: &Database, limit: usize) -> usize {
+        if !self.query_cache.is_enabled() {
+            return 0;
+        }
+        let limit = limit.min(self.query_cache.capacity());
+        let mut warmed = 0;
+        for key in previous.query_cache.recent_keys(limit) {
+            let resolved = match &key {
+                RecentKey::Ip(addr) => self
+                    .resolve_ip(*addr)
+                    .map(|handle| (CacheKey::Ip(*addr), handle)),
+                RecentKey::Text(query) => self
+                    .resolve_string(query)
+                    .map(|handle| (self.query_cache.text_key(query), handle)),
+            };
+            if let Ok((key, Some(handle))) = resolved {
+                self.query_cache.put(key, handle);
+                warmed += 1;
+            }
+        }
+        warmed
+    }
+
+    /// Add another handle's statistics to this one's
+    ///
+    /// Lets a reloaded handle keep counting where its predecessor stopped.
+    pub(crate) fn absorb_stats(&self, previous: &Database) {
+        self.stats.local().add(&previous.stats());
     }
 
     /// Get database statistics
@@ -428,7 +1016,36 @@ impl Database {
     /// # Ok::<(), Box<dyn std::error::Error>>(())
     /// ```
     pub fn stats(&self) -> DatabaseStats {
-        *self.stats.borrow()
+        let mut stats = self.stats.snapshot();
+        let counters = self.query_cache.counters();
+        stats.cache_evictions = counters.evictions;
+        stats.cache_rejections = counters.rejections;
+        stats.cache_promotions = counters.promotions;
+        stats
+    }
+
+    /// The profiler this handle samples queries into, if any
+    ///
+    /// See [`DatabaseOpener::profiler`].
+    pub fn profiler(&self) -> Option<&Arc<QueryProfiler>> {
+        self.profiler.as_ref()
+    }
+
+    /// Start timing a stage, if this thread's query is being sampled
+    #[inline]
+    fn stage_start(&self) -> Option<Instant> {
+        match &self.profiler {
+            Some(_) if crate::profile::sampling() => Some(Instant::now()),
+            _ => None,
+        }
+    }
+
+    /// Record a stage started with [`stage_start`](Self::stage_start)
+    #[inline]
+    fn stage_end(&self, stage: QueryStage, start: Option<Instant>) {
+        if let Some(profiler) = &self.profiler {
+            profiler.record_since(stage, start);
+        }
     }
 
     /// Get the match mode of the database (case-sensitive or case-insensitive)
@@ -448,31 +1065,31 @@ impl Database {
     /// # Ok::<(), Box<dyn std::error::Error>>(())
     /// ```
     pub fn mode(&self) -> crate::glob::MatchMode {
-        // If there's a pattern matcher, use its mode
-        if let Some(ref pm) = self.pattern_matcher {
-            return pm.borrow().mode;
-        }
-        // If there's a literal hash, use its mode
-        if let Some(ref lh) = self.literal_hash {
-            return lh.mode();
+        // String sections use the metadata's mode; IP-only databases
+        // default to case-sensitive
+        if self.has_string_data() {
+            self.match_mode
+        } else {
+            crate::glob::MatchMode::CaseSensitive
         }
-        // Default to case-sensitive for IP-only databases
-        crate::glob::MatchMode::CaseSensitive
     }
 
     /// Open database with custom options (lower-level API)
     ///
     /// Most users should use `Database::from()` builder instead.
     pub fn open_with_options(options: DatabaseOptions) -> Result<Self, DatabaseError> {
-        let cache_capacity = options.cache_capacity;
+        // Configure cache size (0 means disable, None means use default)
+        let cache_capacity = options.cache_capacity.unwrap_or(DEFAULT_QUERY_CACHE_SIZE);
+        let negative_capacity = options.negative_cache_capacity;
+        let concurrency = options.concurrency;
 
         // Open the database - either from bytes or from file
-        let mut db = if let Some(bytes) = options.bytes {
+        let storage = if let Some(bytes) = options.bytes {
             // Load from bytes
-            Self::from_storage(DatabaseStorage::Owned(bytes))?
+            DatabaseStorage::Owned(bytes)
         } else {
             // Load from file
-            Self::open_internal(
+            Self::map_file(
                 options
                     .path
                     .to_str()
@@ -480,23 +1097,225 @@ impl Database {
             )?
         };
 
-        // Configure cache size (0 means disable, None means use default)
-        if let Some(capacity) = cache_capacity {
-            if capacity == 0 {
-                // Disable cache completely - skip all cache operations
-                db.cache_enabled = false;
-            } else if capacity != DEFAULT_QUERY_CACHE_SIZE {
-                // Resize cache (use FxHasher for speed)
-                db.query_cache = std::cell::RefCell::new(lru::LruCache::with_hasher(
-                    std::num::NonZeroUsize::new(capacity).unwrap(),
-                    BuildHasherDefault::<rustc_hash::FxHasher>::default(),
-                ));
-                db.cache_enabled = true;
+        let mut db = Self::from_storage(
+            storage,
+            cache_capacity,
+            options.cache_policy,
+            negative_capacity,
+            concurrency,
+            options.trusted,
+        )?;
+        db.prepare_pages(options.huge_pages, options.prefault, options.lock_memory)?;
+        db.profiler = options.profiler;
+        if options.ipv4_direct_index {
+            db.build_ipv4_index()?;
+        }
+        for path in options.overlays {
+            // Overlays are only queried through this handle, whose cache
+            // holds the combined results
+            let delta = Database::from(path).no_cache().open()?;
+            db = db.with_overlay(delta)?;
+        }
+        Ok(db)
+    }
+
+    /// Layer a delta database over this one
+    ///
+    /// The delta is usually small: a database built with the entries that
+    /// changed since the base was built, and [`add_tombstone`] for the ones
+    /// that were removed. Lookups consult the newest overlay first:
+    ///
+    /// - **IPs**: the newest layer whose tree covers the address answers;
+    ///   its network shadows the older layers for every address inside it.
+    ///   A tombstone answers "not found".
+    /// - **Literals**: the newest layer holding the exact key answers.
+    /// - **Globs**: matches from all layers are combined, except that a
+    ///   pattern defined or tombstoned in a newer layer hides the same
+    ///   pattern in older ones.
+    ///
+    /// Pattern IDs of overlay matches are offset past those of older
+    /// layers; [`get_pattern_string`](Self::get_pattern_string) resolves
+    /// them. [`lookup_ref`](Self::lookup_ref) is unavailable on a layered
+    /// database because overlay data lives in another file.
+    ///
+    /// `matchy compact` merges a base and its deltas into a new base.
+    ///
+    /// [`add_tombstone`]: crate::DatabaseBuilder::add_tombstone
+    pub fn with_overlay(mut self, delta: Database) -> Result<Self, DatabaseError> {
+        if self.has_string_data() && delta.has_string_data() && self.mode() != delta.mode() {
+            return Err(DatabaseError::Unsupported(
+                "Overlay match mode differs from the base database".to_string(),
+            ));
+        }
+
+        let mut globs = HashSet::new();
+        if let Some(pg) = delta.pattern_section()?.map(|p| &p.matcher) {
+            for pattern_id in 0..pg.pattern_count() as u32 {
+                if let Some(pattern) = pg.get_pattern(pattern_id) {
+                    globs.insert(pattern);
+                }
             }
-            // else: keep default size and enabled
         }
 
-        Ok(db)
+        let id_offset = match self.overlays.last() {
+            Some(last) => last.id_offset + last.db.pattern_id_span(),
+            None => self.pattern_id_span(),
+        };
+        self.overlays.push(Overlay {
+            db: delta,
+            globs,
+            id_offset,
+        });
+        self.clear_cache();
+        Ok(self)
+    }
+
+    /// Number of overlays layered over this database
+    pub fn overlay_count(&self) -> usize {
+        self.overlays.len()
+    }
+
+    /// Visit every key stored in this database's own sections
+    ///
+    /// Networks come from the IP tree's leaves (so a network with more
+    /// specific networks inside it is reported as the pieces around them).
+    /// Used by compaction; overlays are not included.
+    pub(crate) fn for_each_stored_entry(
+        &self,
+        mut f: impl FnMut(StoredKey, StoredData) -> Result<(), DatabaseError>,
+    ) -> Result<(), DatabaseError> {
+        let stored = |offset: u32| {
+            if self.is_tombstone(offset) {
+                StoredData::Tombstone
+            } else {
+                StoredData::Offset(offset)
+            }
+        };
+
+        if let (Some(header), true) = (&self.ip_header, self.format != DatabaseFormat::PatternOnly)
+        {
+            SearchTree::new(self.data.as_slice(), header).for_each_network(
+                |addr, prefix_len, offset| f(StoredKey::Network(addr, prefix_len), stored(offset)),
+            )?;
+        }
+
+        if let Some(literal_hash) = self.literal_section()? {
+            let mut literals = Vec::new();
+            literal_hash.for_each_entry(|literal, _, data_offset| {
+                if let Some(offset) = data_offset {
+                    literals.push((literal.to_string(), offset));
+                }
+            });
+            for (literal, offset) in literals {
+                f(StoredKey::Literal(literal), stored(offset))?;
+            }
+        }
+
+        if let Some(section) = self.pattern_section()? {
+            let pg = &section.matcher;
+            for pattern_id in 0..pg.pattern_count() as u32 {
+                let Some(glob) = pg.get_pattern(pattern_id) else {
+                    continue;
+                };
+                let data = match &section.data_mappings {
+                    Some(mappings) => match mappings.get_offset(pattern_id, self.data.as_slice()) {
+                        Some(offset) => stored(offset),
+                        None => StoredData::Value(None),
+                    },
+                    None => StoredData::Value(pg.get_pattern_data(pattern_id)),
+                };
+                f(StoredKey::Glob(glob), data)?;
+            }
+        }
+        Ok(())
+    }
+
+    /// Decode the data record at `offset` in this database's data section
+    pub(crate) fn decode_record(&self, offset: u32) -> Result<DataValue, DatabaseError> {
+        let header = self.data_section_header()?;
+        self.decode_ip_data(header, offset)
+    }
+
+    /// Size of this database's own pattern ID space (literal and glob IDs)
+    fn pattern_id_span(&self) -> u32 {
+        let literals = self.literal_hash().map_or(0, |lh| lh.entry_count());
+        (self.pattern_count() as u32).max(literals)
+    }
+
+    /// Whether `offset` is this database's tombstone record
+    #[inline]
+    fn is_tombstone(&self, offset: u32) -> bool {
+        self.tombstone_offset == Some(offset)
+    }
+
+    /// Apply page residency options to a mapped file (no-op for bytes)
+    ///
+    /// Huge pages are requested first so the faults that follow can use
+    /// them, and hot sections are faulted in before the lock brings in the
+    /// rest.
+    fn prepare_pages(
+        &self,
+        huge_pages: bool,
+        prefault: bool,
+        lock_memory: bool,
+    ) -> Result<(), DatabaseError> {
+        if !matches!(self.data, DatabaseStorage::Mmap(_)) {
+            return Ok(());
+        }
+        let data = self.data.as_slice();
+
+        if huge_pages {
+            crate::mmap::advise_huge_pages(data);
+        }
+        if prefault {
+            let hot = self.hot_ranges();
+            for range in &hot {
+                crate::mmap::advise_willneed(data, range.clone());
+            }
+            for range in hot {
+                crate::mmap::touch_pages(data, range);
+            }
+            crate::mmap::advise_willneed(data, 0..data.len());
+        }
+        if lock_memory {
+            crate::mmap::lock_pages(data).map_err(|e| {
+                DatabaseError::Io(format!("Failed to lock database in memory: {}", e))
+            })?;
+        }
+        Ok(())
+    }
+
+    /// File ranges that lookups read most, hottest first
+    fn hot_ranges(&self) -> Vec<Range<usize>> {
+        let data = self.data.as_slice();
+        let mut ranges = Vec::new();
+        if let Some(stride) = &self.ip_stride {
+            let size = stride.node_count as usize * crate::mmdb::stride::STRIDE_NODE_BYTES;
+            ranges.push(stride.nodes_offset..stride.nodes_offset + size);
+        } else if let Some(header) = &self.ip_header {
+            ranges.push(0..header.tree_size);
+        }
+        let sections = [
+            self.prefilter.map(|pf| pf.blocks()),
+            self.literal_hash().map(|lh| lh.table_bytes()),
+            self.pattern_matcher().map(|pg| pg.buffer()),
+        ];
+        ranges.extend(
+            sections
+                .into_iter()
+                .flatten()
+                .filter_map(|section| range_within(data, section)),
+        );
+        ranges
+    }
+
+    /// Build the DIR-16 IPv4 table (no-op without a binary tree to index)
+    fn build_ipv4_index(&mut self) -> Result<(), DatabaseError> {
+        if let (Some(header), None) = (&self.ip_header, &self.ip_stride) {
+            let tree = SearchTree::new(self.data.as_slice(), header);
+            self.ipv4_index = Some(Ipv4DirectIndex::build(&tree).map_err(DatabaseError::Format)?);
+        }
+        Ok(())
     }
     /// Open a database file using memory mapping
     ///
@@ -532,39 +1351,67 @@ impl Database {
         Self::from(path).open()
     }
 
-    /// Internal: Open database
-    /// Used by database_opener
-    pub(crate) fn open_internal(path: &str) -> Result<Self, DatabaseError> {
+    /// Internal: Memory-map a database file
+    fn map_file(path: &str) -> Result<DatabaseStorage, DatabaseError> {
         let file = File::open(path)
             .map_err(|e| DatabaseError::Io(format!("Failed to open {}: {}", path, e)))?;
 
         let mmap = unsafe { Mmap::map(&file) }
             .map_err(|e| DatabaseError::Io(format!("Failed to mmap {}: {}", path, e)))?;
 
-        Self::from_storage(DatabaseStorage::Mmap(mmap))
+        Ok(DatabaseStorage::Mmap(mmap))
     }
 
     /// Create database from raw bytes (for testing)
     pub fn from_bytes(data: Vec<u8>) -> Result<Self, DatabaseError> {
-        Self::from_storage(DatabaseStorage::Owned(data))
+        Self::from_storage(
+            DatabaseStorage::Owned(data),
+            DEFAULT_QUERY_CACHE_SIZE,
+            CachePolicy::Lru,
+            0,
+            1,
+            false,
+        )
     }
 
     /// Internal: Create database from storage
-    fn from_storage(storage: DatabaseStorage) -> Result<Self, DatabaseError> {
+    ///
+    /// A trusted open of a file with a header checksum verifies it and
+    /// leaves the string sections to be parsed on first use.
+    fn from_storage(
+        storage: DatabaseStorage,
+        cache_capacity: usize,
+        cache_policy: CachePolicy,
+        negative_capacity: usize,
+        concurrency: usize,
+        trusted: bool,
+    ) -> Result<Self, DatabaseError> {
+        let stripes = stripe_count_for(concurrency);
+
         // First, create the struct with minimal initialization
         let mut db = Self {
             data: storage,
             format: DatabaseFormat::IpOnly, // Temporary, will be set below
             ip_header: None,
-            literal_hash: None,
-            pattern_matcher: None,
-            pattern_data_mappings: None,
-            query_cache: RefCell::new(LruCache::with_hasher(
-                NonZeroUsize::new(DEFAULT_QUERY_CACHE_SIZE).unwrap(),
-                BuildHasherDefault::<rustc_hash::FxHasher>::default(),
-            )),
-            cache_enabled: true, // Default: cache enabled
-            stats: RefCell::new(DatabaseStats::default()),
+            ip_stride: None,
+            ipv4_index: None,
+            literals: LazySection::new(None),
+            prefilter: None,
+            patterns: LazySection::new(None),
+            match_mode: crate::glob::MatchMode::CaseSensitive,
+            pattern_scratch: (0..scratch_stripe_count_for(concurrency))
+                .map(|_| ScratchStripe::default())
+                .collect(),
+            query_cache: QueryCache::new(
+                cache_capacity,
+                cache_policy,
+                concurrency,
+                negative_capacity,
+            ),
+            stats: SharedStats::new(stripes),
+            tombstone_offset: None,
+            overlays: Vec::new(),
+            profiler: None,
         };
 
         // Now we can safely get 'static reference since db owns the data
@@ -573,272 +1420,1021 @@ impl Database {
         // Detect format
         db.format = Self::detect_format(data)?;
 
-        // Parse based on format
+        // Locate the string sections; they are parsed below or on first use
         match db.format {
             DatabaseFormat::IpOnly => {
                 db.ip_header = Some(MmdbHeader::from_file(data).map_err(DatabaseError::Format)?);
             }
             DatabaseFormat::PatternOnly => {
-                // Pattern-only: load from start of file
-                let pg = Self::load_pattern_section(data, 0).map_err(|e| {
-                    DatabaseError::Unsupported(format!("Failed to load pattern section: {}", e))
-                })?;
-                db.pattern_matcher = Some(RefCell::new(pg));
+                // Pattern-only: the pattern section starts the file
+                db.patterns = LazySection::new(Some(0));
             }
             DatabaseFormat::Combined => {
                 // Parse IP header first
                 db.ip_header = Some(MmdbHeader::from_file(data).map_err(DatabaseError::Format)?);
 
-                // Find and load pattern section after MMDB_PATTERN separator
-                if let Some(offset) = Self::find_pattern_section_fast(data) {
-                    let (pg, map) =
-                        Self::load_combined_pattern_section(data, offset).map_err(|e| {
-                            DatabaseError::Unsupported(format!(
-                                "Failed to load pattern section: {}",
-                                e
-                            ))
-                        })?;
-                    db.pattern_matcher = Some(RefCell::new(pg));
-                    db.pattern_data_mappings = Some(map);
-                }
+                // Pattern section follows the MMDB_PATTERN separator
+                db.patterns = LazySection::new(Self::find_pattern_section_fast(data));
+            }
+        }
+        // Literal hash section (offset of its MMDB_LITERAL marker)
+        db.literals = LazySection::new(Self::find_literal_section_fast(data));
+        db.match_mode = Self::read_match_mode_from_metadata(data);
+
+        // Load IP stride index if present (files without one use the binary tree)
+        if db.ip_header.is_some() {
+            if let Some(offset) = Self::find_ip_stride_section(data) {
+                db.ip_stride =
+                    Some(StrideHeader::from_section(data, offset).map_err(DatabaseError::Format)?);
             }
         }
 
-        // Load literal hash section if present (MMDB_LITERAL marker)
-        if let Some(offset) = Self::find_literal_section_fast(data) {
-            // Skip the 16-byte marker
-            let literal_data = &data[offset + 16..];
-            // Read match mode from metadata
-            let match_mode = Self::read_match_mode_from_metadata(data);
-            db.literal_hash = Some(LiteralHash::from_buffer(literal_data, match_mode).map_err(
-                |e| DatabaseError::Unsupported(format!("Failed to load literal hash: {}", e)),
-            )?);
+        // Load string prefilter if present (files without one probe every query)
+        if let Some(offset) = Self::find_prefilter_section(data) {
+            let header = PrefilterHeader::from_section(data, offset).map_err(|e| {
+                DatabaseError::Unsupported(format!("Failed to load prefilter: {}", e))
+            })?;
+            db.prefilter = Some(Prefilter::new(data, &header, db.match_mode));
+        }
+
+        // Delta databases record where their tombstone lives
+        if db.ip_header.is_some() {
+            db.tombstone_offset = Self::read_tombstone_offset_from_metadata(data);
+        }
+
+        // Parse the string sections now unless the checksum vouches for them
+        if !(trusted && Self::verify_header_checksum(data)?) {
+            db.pattern_section()?;
+            db.literal_section()?;
         }
 
         Ok(db)
     }
 
-    /// Look up a query string (IP address or string pattern)
+    /// Check the metadata's header checksum against the file
+    ///
+    /// Returns false when the file has no checksum (older builds).
+    fn verify_header_checksum(data: &[u8]) -> Result<bool, DatabaseError> {
+        let Ok(marker) = crate::mmdb::find_metadata_marker(data) else {
+            return Ok(false);
+        };
+        let Ok(DataValue::Map(map)) =
+            crate::mmdb::MmdbMetadata::from_file(data).and_then(|m| m.as_value())
+        else {
+            return Ok(false);
+        };
+        let Some(DataValue::Uint64(expected)) = map.get(crate::mmdb::HEADER_CHECKSUM_KEY) else {
+            return Ok(false);
+        };
+        if crate::mmdb::header_checksum(&data[..marker], &map) != *expected {
+            return Err(DatabaseError::Unsupported(
+                "Header checksum mismatch: file is truncated or was modified after build"
+                    .to_string(),
+            ));
+        }
+        Ok(true)
+    }
+
+    /// The file's bytes, for sections borrowed for the handle's lifetime
+    fn static_data(&self) -> &'static [u8] {
+        // SAFETY: db owns the data (a Vec or mmap that never moves), and the
+        // sections borrowing it are dropped with it
+        unsafe { std::mem::transmute(self.data.as_slice()) }
+    }
+
+    /// Pattern section, parsed on first use after a trusted open
+    fn pattern_section(&self) -> Result<Option<&PatternSection>, DatabaseError> {
+        self.patterns.get_or_load(|offset| {
+            let data = self.static_data();
+            let section = if self.format == DatabaseFormat::PatternOnly {
+                Self::load_pattern_section(data, offset).map(|matcher| PatternSection {
+                    matcher,
+                    data_mappings: None,
+                })
+            } else {
+                Self::load_combined_pattern_section(data, offset).map(|(matcher, map)| {
+                    PatternSection {
+                        matcher,
+                        data_mappings: Some(map),
+                    }
+                })
+            };
+            section.map_err(|e| format!("Failed to load pattern section: {}", e))
+        })
+    }
+
+    /// Literal hash table, parsed on first use after a trusted open
+    pub(crate) fn literal_section(&self) -> Result<Option<&LiteralHash<'static>>, DatabaseError> {
+        self.literals.get_or_load(|offset| {
+            // Skip the 16-byte marker
+            let literal_data = &self.static_data()[offset + 16..];
+            LiteralHash::from_buffer(literal_data, self.match_mode)
+                .map_err(|e| format!("Failed to load literal hash: {}", e))
+        })
+    }
+
+    /// Glob matcher, if the file has a pattern section that parses
+    fn pattern_matcher(&self) -> Option<&Paraglob> {
+        self.pattern_section().ok().flatten().map(|p| &p.matcher)
+    }
+
+    /// Literal hash table, if the file has one that parses
+    fn literal_hash(&self) -> Option<&LiteralHash<'static>> {
+        self.literal_section().ok().flatten()
+    }
+
+    /// Look up a query string (IP address or string pattern)
+    ///
+    /// Automatically determines if the query is an IP address or string
+    /// and uses the appropriate lookup method.
+    ///
+    /// Queries are cached using an LRU cache. Repeated queries return
+    /// cached results without re-searching: the cache remembers where the
+    /// match's data lives and a hit decodes it from there. Cache hit rates
+    /// of 80-95% are typical in log processing workloads.
+    ///
+    /// Returns `Ok(Some(result))` if found, `Ok(None)` if not found.
+    pub fn lookup(&self, query: &str) -> Result<Option<QueryResult>, DatabaseError> {
+        match query.parse::<IpAddr>() {
+            Ok(addr) => self.lookup_ip(addr),
+            Err(_) => self.lookup_string(query),
+        }
+    }
+
+    /// Serve `key` from the cache, or run `resolve` and cache its result
+    ///
+    /// Shared by all cached lookups so they count stats the same way.
+    /// Either way the result is decoded from the handle, so a hit copies a
+    /// few words out of the cache and nothing more.
+    fn lookup_cached(
+        &self,
+        key: CacheKey<'_>,
+        resolve: impl FnOnce() -> Result<Option<CachedResult>, DatabaseError>,
+    ) -> Result<Option<QueryResult>, DatabaseError> {
+        let stats = self.stats.local();
+        let _sample = self.profiler.as_ref().and_then(|p| p.start_query());
+
+        // Check cache first (no-op if caching is disabled)
+        if let Some(handle) = self.query_cache.get(key) {
+            let mut tally = DatabaseStats::default();
+            tally.record_cached(&handle);
+            stats.add(&tally);
+            let decode_start = self.stage_start();
+            let result = self.materialize(&handle).map(Some);
+            self.stage_end(QueryStage::DataDecode, decode_start);
+            return result;
+        }
+
+        // Cache miss (or cache disabled) - perform actual lookup
+        let handle = resolve()?;
+        let decode_start = self.stage_start();
+        let result = handle.as_ref().map(|h| self.materialize(h)).transpose()?;
+        self.stage_end(QueryStage::DataDecode, decode_start);
+
+        // Update stats (relaxed atomics on this thread's stripe)
+        let mut tally = DatabaseStats::default();
+        tally.record_uncached(&result, self.query_cache.is_enabled());
+        stats.add(&tally);
+
+        // Store in cache if result was found (no-op if caching is disabled)
+        if let Some(handle) = handle {
+            self.query_cache.put(key, handle);
+        }
+
+        Ok(result)
+    }
+
+    /// Find an IP address's result handle, without the cache or stats
+    fn resolve_ip(&self, addr: IpAddr) -> Result<Option<CachedResult>, DatabaseError> {
+        // The newest overlay that covers the address answers for it
+        for (index, overlay) in self.overlays.iter().enumerate().rev() {
+            if let Some(header) = &overlay.db.ip_header {
+                // An IPv4-only tree would read IPv6 bits as an IPv4 address
+                if addr.is_ipv6() && header.ip_version == IpVersion::V4 {
+                    continue;
+                }
+                let found = overlay
+                    .db
+                    .tree_lookup(header, addr)
+                    .map_err(DatabaseError::Format)?;
+                if found.is_some() {
+                    return overlay.db.ip_handle_from_tree(index as u32 + 1, Ok(found));
+                }
+            }
+        }
+
+        let header = match &self.ip_header {
+            Some(h) => h,
+            None => return Ok(None), // No IP data in this database
+        };
+
+        // Traverse tree
+        let tree_start = self.stage_start();
+        let found = self.tree_lookup(header, addr);
+        self.stage_end(QueryStage::IpTree, tree_start);
+        self.ip_handle_from_tree(0, found)
+    }
+
+    /// Find an address's data record, via the stride index when present
+    #[inline]
+    fn tree_lookup(
+        &self,
+        header: &MmdbHeader,
+        addr: IpAddr,
+    ) -> Result<Option<LookupResult>, MmdbError> {
+        match &self.ip_stride {
+            Some(stride) => StrideIndex::new(self.data.as_slice(), stride).lookup(addr),
+            None => self.search_tree(header).lookup(addr),
+        }
+    }
+
+    /// Binary search tree view, with the IPv4 direct index if one was built
+    #[inline]
+    fn search_tree<'a>(&'a self, header: &'a MmdbHeader) -> SearchTree<'a> {
+        let tree = SearchTree::new(self.data.as_slice(), header);
+        match &self.ipv4_index {
+            Some(index) => tree.with_ipv4_index(index),
+            None => tree,
+        }
+    }
+
+    /// Turn a tree lookup outcome in this database (serving as `layer`)
+    /// into a result handle
+    fn ip_handle_from_tree(
+        &self,
+        layer: u32,
+        tree_result: Result<Option<LookupResult>, MmdbError>,
+    ) -> Result<Option<CachedResult>, DatabaseError> {
+        Ok(Some(match tree_result.map_err(DatabaseError::Format)? {
+            Some(r) if !self.is_tombstone(r.data_offset) => CachedResult::Ip {
+                layer,
+                offset: r.data_offset,
+                prefix_len: r.prefix_len,
+            },
+            _ => CachedResult::NotFound,
+        }))
+    }
+
+    /// The database serving as `layer` of this one, and its pattern ID offset
+    #[inline]
+    fn layer(&self, layer: u32) -> (&Database, u32) {
+        match layer.checked_sub(1) {
+            None => (self, 0),
+            Some(index) => {
+                let overlay = &self.overlays[index as usize];
+                (&overlay.db, overlay.id_offset)
+            }
+        }
+    }
+
+    /// Decode the data a result handle points at
+    fn materialize(&self, handle: &CachedResult) -> Result<QueryResult, DatabaseError> {
+        match handle {
+            CachedResult::NotFound => Ok(QueryResult::NotFound),
+            &CachedResult::Ip {
+                layer,
+                offset,
+                prefix_len,
+            } => {
+                let data = self.layer(layer).0.decode_record(offset)?;
+                Ok(QueryResult::Ip { data, prefix_len })
+            }
+            CachedResult::Match(_) | CachedResult::Matches(_) => {
+                let matches = handle.matches();
+                let mut pattern_ids = Vec::with_capacity(matches.len());
+                let mut data = Vec::with_capacity(matches.len());
+                for m in matches {
+                    let (db, id_offset) = self.layer(m.layer);
+                    pattern_ids.push(m.pattern_id);
+                    data.push(match m.data {
+                        MatchData::Offset(offset) => Some(db.decode_record(offset)?),
+                        MatchData::Paraglob => db
+                            .pattern_matcher()
+                            .and_then(|pg| pg.get_pattern_data(m.pattern_id - id_offset)),
+                        MatchData::None => None,
+                    });
+                }
+                Ok(QueryResult::Pattern { pattern_ids, data })
+            }
+        }
+    }
+
+    /// Look up many queries in one call
+    ///
+    /// Equivalent to calling [`lookup`](Self::lookup) on each query, but
+    /// per-call costs are paid once per batch: cache hits are served first,
+    /// the remaining IPs walk the tree together with interleaved prefetching,
+    /// all strings share one pattern-matching scratch, and stats are tallied
+    /// locally and published once.
+    ///
+    /// `results` is cleared and receives one entry per query, in order.
+    ///
+    /// # Examples
+    ///
+    /// ```no_run
+    /// use matchy::Database;
+    ///
+    /// let db = Database::from("threats.mxy").open()?;
+    ///
+    /// let mut results = Vec::new();
+    /// db.lookup_batch(&["1.2.3.4", "evil.com", "10.0.0.1"], &mut results);
+    /// for result in &results {
+    ///     println!("{:?}", result);
+    /// }
+    /// # Ok::<(), Box<dyn std::error::Error>>(())
+    /// ```
+    pub fn lookup_batch(
+        &self,
+        queries: &[&str],
+        results: &mut Vec<Result<Option<QueryResult>, DatabaseError>>,
+    ) {
+        results.clear();
+
+        // Layered lookups consult several files per query; keep it simple
+        if !self.overlays.is_empty() {
+            results.extend(queries.iter().map(|query| self.lookup(query)));
+            return;
+        }
+
+        results.resize_with(queries.len(), || Ok(None));
+
+        let mut tally = DatabaseStats::default();
+        let mut ip_indices = Vec::new();
+        let mut ip_addrs = Vec::new();
+        let mut string_indices = Vec::new();
+
+        // Serve cache hits and split the misses by query type
+        for (index, query) in queries.iter().enumerate() {
+            let key = match query.parse::<IpAddr>() {
+                Ok(addr) => CacheKey::Ip(addr),
+                Err(_) => self.query_cache.text_key(query),
+            };
+            if let Some(handle) = self.query_cache.get(key) {
+                tally.record_cached(&handle);
+                results[index] = self.materialize(&handle).map(Some);
+                continue;
+            }
+            match key {
+                CacheKey::Ip(addr) => {
+                    ip_indices.push(index);
+                    ip_addrs.push(addr);
+                }
+                CacheKey::Text { .. } => string_indices.push(index),
+            }
+        }
+
+        // Handles for everything that was actually looked up
+        let mut handles = Vec::with_capacity(ip_indices.len() + string_indices.len());
+
+        // IPs: one interleaved tree walk for the whole group
+        // (without IP data every IP query is Ok(None), as in lookup())
+        match (&self.ip_header, ip_addrs.is_empty()) {
+            (_, true) => {}
+            (Some(header), false) => {
+                let mut tree_results = Vec::with_capacity(ip_addrs.len());
+                match &self.ip_stride {
+                    Some(stride) => StrideIndex::new(self.data.as_slice(), stride)
+                        .lookup_batch(&ip_addrs, &mut tree_results),
+                    None => self
+                        .search_tree(header)
+                        .lookup_batch(&ip_addrs, &mut tree_results),
+                }
+                for ((&index, &addr), tree_result) in
+                    ip_indices.iter().zip(&ip_addrs).zip(tree_results)
+                {
+                    let handle = self.ip_handle_from_tree(0, tree_result);
+                    handles.push((index, CacheKey::Ip(addr), handle));
+                }
+            }
+            (None, false) => {
+                for (&index, &addr) in ip_indices.iter().zip(&ip_addrs) {
+                    handles.push((index, CacheKey::Ip(addr), Ok(None)));
+                }
+            }
+        }
+
+        // Strings: literal hash then globs, holding this thread's scratch once
+        if !string_indices.is_empty() {
+            let mut scratch = self.local_scratch();
+            for &index in &string_indices {
+                let query = queries[index];
+                handles.push((
+                    index,
+                    self.query_cache.text_key(query),
+                    self.resolve_string_with(query, &mut scratch),
+                ));
+            }
+        }
+
+        // Decode, count and cache everything that was actually looked up
+        let cache_enabled = self.query_cache.is_enabled();
+        for (index, key, handle) in handles {
+            let handle = match handle {
+                Ok(handle) => handle,
+                Err(e) => {
+                    results[index] = Err(e);
+                    continue;
+                }
+            };
+            let result = handle.as_ref().map(|h| self.materialize(h)).transpose();
+            if let Ok(result) = &result {
+                tally.record_uncached(result, cache_enabled);
+                if let Some(handle) = handle {
+                    self.query_cache.put(key, handle);
+                }
+            }
+            results[index] = result;
+        }
+        self.stats.local().add(&tally);
+    }
+
+    /// Look up an IP address (public API, uses cache)
+    ///
+    /// Returns data associated with the IP address if found.
+    /// Counted in [`stats`](Self::stats) like [`lookup`](Self::lookup).
+    pub fn lookup_ip(&self, addr: IpAddr) -> Result<Option<QueryResult>, DatabaseError> {
+        // Keyed by the binary address, so nothing is formatted or hashed as text
+        self.lookup_cached(CacheKey::Ip(addr), || self.resolve_ip(addr))
+    }
+
+    /// Find a string's result handle (literal or glob pattern), without
+    /// the cache or stats
+    ///
+    /// Checks both:
+    /// 1. Literal hash table for O(1) exact matches
+    /// 2. Glob patterns for wildcard matches
+    ///
+    /// A query can match both a literal AND a glob pattern simultaneously.
+    fn resolve_string(&self, pattern: &str) -> Result<Option<CachedResult>, DatabaseError> {
+        if !self.overlays.is_empty() {
+            return self.resolve_string_layered(pattern);
+        }
+        if self.patterns.is_present() {
+            // This thread's scratch keeps concurrent lookups off a shared lock
+            self.resolve_string_with(pattern, &mut self.local_scratch())
+        } else {
+            self.resolve_string_with(pattern, &mut ParaglobScratch::new())
+        }
+    }
+
+    /// Uncached string resolution using the given pattern-matching scratch
+    fn resolve_string_with(
+        &self,
+        pattern: &str,
+        scratch: &mut ParaglobScratch,
+    ) -> Result<Option<CachedResult>, DatabaseError> {
+        let mut matches = Vec::new();
+        let layer = StringLayer {
+            index: 0,
+            id_offset: 0,
+            with_literal: true,
+            shadowed: None,
+        };
+        self.collect_string_matches(pattern, scratch, &layer, &mut matches)?;
+
+        // Only return NotFound if we actually have some pattern data
+        let has_pattern_data = self.has_string_data();
+        Ok(Self::string_result(has_pattern_data, matches))
+    }
+
+    /// Uncached string resolution through the overlays, newest first, then this database
+    fn resolve_string_layered(&self, pattern: &str) -> Result<Option<CachedResult>, DatabaseError> {
+        let mut matches = Vec::new();
+        let mut has_pattern_data = false;
+        let mut literal_answered = false;
+
+        let layers = self
+            .overlays
+            .iter()
+            .enumerate()
+            .map(|(index, overlay)| (&overlay.db, index as u32 + 1, overlay.id_offset))
+            .rev()
+            .chain(std::iter::once((self, 0, 0)));
+        for (depth, (db, index, id_offset)) in layers.enumerate() {
+            let newer = &self.overlays[self.overlays.len() - depth..];
+            let shadowed = |glob: &str| newer.iter().any(|overlay| overlay.globs.contains(glob));
+            let layer = StringLayer {
+                index,
+                id_offset,
+                with_literal: !literal_answered,
+                shadowed: (!newer.is_empty()).then_some(&shadowed as &dyn Fn(&str) -> bool),
+            };
+
+            has_pattern_data |= db.has_string_data();
+            literal_answered |= if db.patterns.is_present() {
+                db.collect_string_matches(pattern, &mut db.local_scratch(), &layer, &mut matches)?
+            } else {
+                db.collect_string_matches(
+                    pattern,
+                    &mut ParaglobScratch::new(),
+                    &layer,
+                    &mut matches,
+                )?
+            };
+        }
+
+        Ok(Self::string_result(has_pattern_data, matches))
+    }
+
+    /// Append this database's own literal and glob matches for `pattern`
+    ///
+    /// Tombstoned entries are skipped. Returns whether the literal table
+    /// held the key (tombstoned or not), so older layers can be skipped.
+    fn collect_string_matches(
+        &self,
+        pattern: &str,
+        scratch: &mut ParaglobScratch,
+        layer: &StringLayer<'_>,
+        matches: &mut Vec<MatchRef>,
+    ) -> Result<bool, DatabaseError> {
+        let mut literal_found = false;
+
+        // 1. Try literal hash table first (O(1) lookup), unless the
+        //    prefilter rules the query out
+        //    (a trusted open parses the table here, on first use)
+        let may_be_literal = self.prefilter.is_none_or(|pf| pf.may_be_literal(pattern));
+        let literal_hash = if layer.with_literal && may_be_literal {
+            self.literal_section()?
+        } else {
+            None
+        };
+        if let Some(literal_hash) = literal_hash {
+            let literal_start = self.stage_start();
+            let entry = literal_hash.lookup_entry(pattern);
+            self.stage_end(QueryStage::LiteralHash, literal_start);
+            if let (Some(profiler), Some(_)) = (&self.profiler, literal_start) {
+                profiler.record_probes(literal_hash.probe_count(pattern));
+            }
+            if let Some(entry) = entry {
+                literal_found = true;
+                self.push_literal_match(entry, layer, matches)?;
+            }
+        }
+
+        // 2. Check glob patterns (for wildcard matches)
+        let may_match_glob = self.prefilter.is_none_or(|pf| pf.may_match_glob(pattern));
+        let patterns = if may_match_glob {
+            self.pattern_section()?
+        } else {
+            None
+        };
+        if let Some(section) = patterns {
+            let pg = &section.matcher;
+            let scan_start = self.stage_start();
+            let (glob_pattern_ids, scan) = pg.find_all_counted(pattern, scratch);
+            if let (Some(profiler), Some(start)) = (&self.profiler, scan_start) {
+                // Verification is timed inside the scan; count it once
+                profiler.record(
+                    QueryStage::PatternScan,
+                    start.elapsed().saturating_sub(scan.verify),
+                );
+                profiler.record_scan(&scan);
+            }
+
+            // Add glob matches
+            for &pattern_id in glob_pattern_ids {
+                if let Some(shadowed) = layer.shadowed {
+                    if pg.pattern_str(pattern_id).is_some_and(shadowed) {
+                        continue;
+                    }
+                }
+                self.push_glob_match(section, pattern_id, layer, matches);
+            }
+        }
+
+        Ok(literal_found)
+    }
+
+    /// Append the match for an exact hit in this database's literal table
+    fn push_literal_match(
+        &self,
+        (pattern_id, data_offset): (u32, Option<u32>),
+        layer: &StringLayer<'_>,
+        matches: &mut Vec<MatchRef>,
+    ) -> Result<(), DatabaseError> {
+        if let Some(data_offset) = data_offset {
+            if self.ip_header.is_none() {
+                return Err(DatabaseError::Format(MmdbError::InvalidFormat(
+                    "Literal hash present but no IP header".to_string(),
+                )));
+            }
+            if !self.is_tombstone(data_offset) {
+                matches.push(MatchRef {
+                    pattern_id: pattern_id + layer.id_offset,
+                    layer: layer.index,
+                    data: MatchData::Offset(data_offset),
+                });
+            }
+        }
+        Ok(())
+    }
+
+    /// Append the match for glob `pattern_id` of this database's pattern section
+    fn push_glob_match(
+        &self,
+        section: &PatternSection,
+        pattern_id: u32,
+        layer: &StringLayer<'_>,
+        matches: &mut Vec<MatchRef>,
+    ) {
+        // For combined databases, use mappings to the MMDB data section
+        // For pattern-only databases, data lives in the Paraglob section
+        let data = if let Some(mappings) = &section.data_mappings {
+            if let Some(data_offset) = mappings.get_offset(pattern_id, self.data.as_slice()) {
+                if self.is_tombstone(data_offset) {
+                    return;
+                }
+                MatchData::Offset(data_offset)
+            } else {
+                MatchData::None
+            }
+        } else {
+            MatchData::Paraglob
+        };
+        matches.push(MatchRef {
+            pattern_id: pattern_id + layer.id_offset,
+            layer: layer.index,
+            data,
+        });
+    }
+
+    /// Answer a string query whose matching was done outside this handle
+    ///
+    /// `literal` is this database's literal table entry for the query and
+    /// `glob_ids` its pattern section matches in ascending order, as
+    /// [`lookup_string`](Self::lookup_string) would find them. Used by
+    /// [`DatabaseSet`](crate::DatabaseSet), which scans once for all of its
+    /// members. Bypasses the cache and stats; not for handles with overlays.
+    pub(crate) fn string_result_from(
+        &self,
+        literal: Option<(u32, Option<u32>)>,
+        glob_ids: &[u32],
+    ) -> Result<Option<QueryResult>, DatabaseError> {
+        let layer = StringLayer {
+            index: 0,
+            id_offset: 0,
+            with_literal: true,
+            shadowed: None,
+        };
+        let mut matches = Vec::new();
+        if let Some(entry) = literal {
+            self.push_literal_match(entry, &layer, &mut matches)?;
+        }
+        if let (false, Some(section)) = (glob_ids.is_empty(), self.pattern_section()?) {
+            for &pattern_id in glob_ids {
+                self.push_glob_match(section, pattern_id, &layer, &mut matches);
+            }
+        }
+        Self::string_result(self.has_string_data(), matches)
+            .map(|handle| self.materialize(&handle))
+            .transpose()
+    }
+
+    /// Glob matcher of the pattern section, parsing it if need be
+    pub(crate) fn glob_matcher(&self) -> Result<Option<&Paraglob>, DatabaseError> {
+        Ok(self.pattern_section()?.map(|section| &section.matcher))
+    }
+
+    /// Whether deltas are layered over this handle
+    pub(crate) fn has_overlays(&self) -> bool {
+        !self.overlays.is_empty()
+    }
+
+    /// Final result handle of a string lookup from its collected matches
+    fn string_result(has_pattern_data: bool, matches: Vec<MatchRef>) -> Option<CachedResult> {
+        if !matches.is_empty() {
+            Some(CachedResult::from_matches(matches))
+        } else if has_pattern_data {
+            Some(CachedResult::NotFound)
+        } else {
+            None // No pattern data in this database
+        }
+    }
+
+    /// Look up a string (literal or glob pattern) - public API, uses cache
+    ///
+    /// Returns matching pattern IDs and associated data.
+    /// Counted in [`stats`](Self::stats) like [`lookup`](Self::lookup).
+    pub fn lookup_string(&self, pattern: &str) -> Result<Option<QueryResult>, DatabaseError> {
+        let key = self.query_cache.text_key(pattern);
+        self.lookup_cached(key, || self.resolve_string(pattern))
+    }
+
+    /// Look up a query without decoding its data
     ///
-    /// Automatically determines if the query is an IP address or string
-    /// and uses the appropriate lookup method.
+    /// Finds the same record that [`lookup`](Self::lookup) would decode first
+    /// (the IP's network, else the literal match, else the first glob match)
+    /// but returns only where it lives, so callers can read just the fields
+    /// they need through [`data_decoder`](Self::data_decoder). The query
+    /// cache is bypassed - a tree walk or hash probe is cheaper than cloning
+    /// a decoded result - and a hit allocates nothing.
     ///
-    /// Queries are cached using an LRU cache. Repeated queries return
-    /// cached results without re-parsing or re-searching. Cache hit rates
-    /// of 80-95% are typical in log processing workloads.
+    /// Returns `Ok(None)` if nothing matched. Pattern-only databases have no
+    /// data section and return `DatabaseError::Unsupported`.
     ///
-    /// Returns `Ok(Some(result))` if found, `Ok(None)` if not found.
-    pub fn lookup(&self, query: &str) -> Result<Option<QueryResult>, DatabaseError> {
-        // Check cache first (only if caching is enabled)
-        if self.cache_enabled {
-            if let Some(cached_result) = self.query_cache.borrow_mut().get(query) {
-                // Cache hit - update stats in single borrow
-                let mut stats = self.stats.borrow_mut();
-                stats.total_queries += 1;
-                stats.cache_hits += 1;
-                drop(stats);
-                return Ok(Some(cached_result.clone()));
-            }
+    /// # Examples
+    ///
+    /// ```no_run
+    /// use matchy::{Database, ValueRef};
+    ///
+    /// let db = Database::from("GeoLite2-Country.mmdb").open()?;
+    /// let decoder = db.data_decoder().unwrap();
+    ///
+    /// if let Some(found) = db.lookup_ref("8.8.8.8")? {
+    ///     if let Some(at) = decoder.lookup_path(found.offset, ["country", "iso_code"])? {
+    ///         if let ValueRef::String(iso) = decoder.decode_ref(at)? {
+    ///             println!("8.8.8.8/{} is in {}", found.prefix_len, iso);
+    ///         }
+    ///     }
+    /// }
+    /// # Ok::<(), Box<dyn std::error::Error>>(())
+    /// ```
+    pub fn lookup_ref(&self, query: &str) -> Result<Option<DataRef>, DatabaseError> {
+        self.check_no_overlays()?;
+        if let Ok(addr) = query.parse::<IpAddr>() {
+            return self.lookup_ip_ref(addr);
         }
 
-        // Cache miss (or cache disabled) - perform actual lookup
-        let result = if let Ok(addr) = query.parse::<IpAddr>() {
-            self.lookup_ip_uncached(addr)?
-        } else {
-            self.lookup_string_uncached(query)?
-        };
+        self.data_section_header()?;
+        let result = self.string_data_ref(query)?;
+        self.record_ref_lookup(false, result.is_some());
+        Ok(result)
+    }
 
-        // Update all stats in single borrow to minimize overhead
-        {
-            let mut stats = self.stats.borrow_mut();
-            stats.total_queries += 1;
-
-            // Track query type based on result
-            match &result {
-                Some(QueryResult::Ip { .. }) => stats.ip_queries += 1,
-                Some(QueryResult::Pattern { .. }) | Some(QueryResult::NotFound) | None => {
-                    stats.string_queries += 1
-                }
-            }
+    /// Look up an IP address without decoding its data
+    ///
+    /// Like [`lookup_ref`](Self::lookup_ref) for an address the caller has
+    /// already parsed, e.g. one taken in binary form from a packet.
+    pub fn lookup_ip_ref(&self, addr: IpAddr) -> Result<Option<DataRef>, DatabaseError> {
+        self.check_no_overlays()?;
+        let header = self.data_section_header()?;
+        let result = self
+            .tree_lookup(header, addr)
+            .map_err(DatabaseError::Format)?
+            .filter(|r| !self.is_tombstone(r.data_offset))
+            .map(|r| DataRef {
+                offset: r.data_offset,
+                prefix_len: r.prefix_len,
+            });
+        self.record_ref_lookup(true, result.is_some());
+        Ok(result)
+    }
 
-            // Track cache miss if caching enabled
-            if self.cache_enabled {
-                stats.cache_misses += 1;
+    /// Look up many IP addresses in address order
+    ///
+    /// Sorts the addresses and walks the search tree from low to high,
+    /// resuming each walk where the address leaves the previous one's path
+    /// (see [`SearchTree::lookup_sorted`]), and decodes each data record
+    /// once per run of addresses that share it. Suited to bulk enrichment
+    /// of log or flow dumps, where addresses cluster in the same networks.
+    /// The query cache is bypassed; lookups are counted in
+    /// [`stats`](Self::stats).
+    ///
+    /// `results` is cleared and receives one entry per address, in input
+    /// order, identical to what [`lookup_ip`](Self::lookup_ip) returns.
+    ///
+    /// # Examples
+    ///
+    /// ```no_run
+    /// use matchy::Database;
+    /// use std::net::IpAddr;
+    ///
+    /// let db = Database::from("geo.mxy").open()?;
+    ///
+    /// let addrs: Vec<IpAddr> = vec!["10.0.0.2".parse()?, "10.0.0.1".parse()?];
+    /// let mut results = Vec::new();
+    /// db.lookup_ips_sorted(&addrs, &mut results);
+    /// for (addr, result) in addrs.iter().zip(&results) {
+    ///     println!("{}: {:?}", addr, result);
+    /// }
+    /// # Ok::<(), Box<dyn std::error::Error>>(())
+    /// ```
+    pub fn lookup_ips_sorted(
+        &self,
+        addrs: &[IpAddr],
+        results: &mut Vec<Result<Option<QueryResult>, DatabaseError>>,
+    ) {
+        results.clear();
+
+        // Layered lookups consult several trees per address
+        let header = match &self.ip_header {
+            Some(header) if self.overlays.is_empty() => header,
+            _ => {
+                results.extend(addrs.iter().map(|&addr| self.lookup_ip(addr)));
+                return;
             }
+        };
 
-            // Track match/no-match (NotFound is NOT a match)
-            match &result {
-                Some(QueryResult::NotFound) | None => {
-                    stats.queries_without_match += 1;
-                }
-                Some(_) => {
-                    stats.queries_with_match += 1;
+        let (order, sorted) = address_order(addrs);
+        let mut tree_results = Vec::with_capacity(addrs.len());
+        SearchTree::new(self.data.as_slice(), header).lookup_sorted(&sorted, &mut tree_results);
+
+        results.resize_with(addrs.len(), || Ok(None));
+        let mut tally = DatabaseStats::default();
+        // (data offset, result index) of the last decoded record
+        let mut last_decoded: Option<(u32, usize)> = None;
+        for (index, tree_result) in order.into_iter().zip(tree_results) {
+            let result = match self.ip_handle_from_tree(0, tree_result) {
+                Ok(Some(CachedResult::Ip {
+                    offset, prefix_len, ..
+                })) => {
+                    let reused = match last_decoded {
+                        Some((last_offset, last_index)) if last_offset == offset => {
+                            match &results[last_index] {
+                                Ok(Some(QueryResult::Ip { data, .. })) => Some(data.clone()),
+                                _ => None,
+                            }
+                        }
+                        _ => None,
+                    };
+                    let data = match reused {
+                        Some(data) => Ok(data),
+                        None => {
+                            last_decoded = Some((offset, index));
+                            self.decode_record(offset)
+                        }
+                    };
+                    data.map(|data| Some(QueryResult::Ip { data, prefix_len }))
                 }
+                Ok(handle) => handle.map(|h| self.materialize(&h)).transpose(),
+                Err(e) => Err(e),
+            };
+            if let Ok(result) = &result {
+                tally.record_uncached(result, false);
             }
+            results[index] = result;
         }
-
-        // Store in cache if result was found AND caching is enabled
-        if self.cache_enabled {
-            if let Some(ref res) = result {
-                self.query_cache
-                    .borrow_mut()
-                    .put(query.to_string(), res.clone());
-            }
-        }
-
-        Ok(result)
+        self.stats.local().add(&tally);
     }
 
-    /// Look up an IP address (uncached internal method)
-    ///
-    /// Returns data associated with the IP address if found.
-    /// This is the internal uncached version used by `lookup()`.
-    fn lookup_ip_uncached(&self, addr: IpAddr) -> Result<Option<QueryResult>, DatabaseError> {
-        let header = match &self.ip_header {
-            Some(h) => h,
-            None => return Ok(None), // No IP data in this database
-        };
-
-        // Traverse tree
-        let tree = SearchTree::new(self.data.as_slice(), header);
-        let tree_result = tree.lookup(addr).map_err(DatabaseError::Format)?;
+    /// Look up many IP addresses in address order without decoding their data
+    ///
+    /// The [`DataRef`] counterpart of
+    /// [`lookup_ips_sorted`](Self::lookup_ips_sorted): `results` is cleared
+    /// and receives one entry per address, in input order, identical to
+    /// what [`lookup_ip_ref`](Self::lookup_ip_ref) returns. Fails as a
+    /// whole on the first malformed tree read.
+    pub fn lookup_ip_refs_sorted(
+        &self,
+        addrs: &[IpAddr],
+        results: &mut Vec<Option<DataRef>>,
+    ) -> Result<(), DatabaseError> {
+        results.clear();
+        self.check_no_overlays()?;
+        let header = self.data_section_header()?;
+
+        let (order, sorted) = address_order(addrs);
+        let mut tree_results = Vec::with_capacity(addrs.len());
+        SearchTree::new(self.data.as_slice(), header).lookup_sorted(&sorted, &mut tree_results);
+
+        results.resize(addrs.len(), None);
+        let mut matched = 0u64;
+        for (index, tree_result) in order.into_iter().zip(tree_results) {
+            results[index] = tree_result
+                .map_err(DatabaseError::Format)?
+                .filter(|r| !self.is_tombstone(r.data_offset))
+                .map(|r| DataRef {
+                    offset: r.data_offset,
+                    prefix_len: r.prefix_len,
+                });
+            matched += results[index].is_some() as u64;
+        }
 
-        let tree_result = match tree_result {
-            Some(r) => r,
-            None => return Ok(Some(QueryResult::NotFound)),
+        let total = addrs.len() as u64;
+        let tally = DatabaseStats {
+            total_queries: total,
+            queries_with_match: matched,
+            queries_without_match: total - matched,
+            ip_queries: total,
+            ..DatabaseStats::default()
         };
-
-        // Decode data
-        let data = self.decode_ip_data(header, tree_result.data_offset)?;
-
-        Ok(Some(QueryResult::Ip {
-            data,
-            prefix_len: tree_result.prefix_len,
-        }))
+        self.stats.local().add(&tally);
+        Ok(())
     }
 
-    /// Look up an IP address (public API, uses cache)
+    /// Iterate over every network in the IP tree that has data
     ///
-    /// Returns data associated with the IP address if found.
-    pub fn lookup_ip(&self, addr: IpAddr) -> Result<Option<QueryResult>, DatabaseError> {
-        // Convert to string for cache key
-        let query = addr.to_string();
+    /// Yields each leaf network in address order with a reference to its
+    /// data (read it with [`data_decoder`](Self::data_decoder)), which makes
+    /// dumping or re-indexing a whole database one pass over the tree with
+    /// no per-network lookups. A network with more specific networks inside
+    /// it is reported as the pieces around them, IPv4 networks of IPv6
+    /// trees are reported as IPv4, and deleted networks are skipped.
+    /// Pattern-only databases yield nothing.
+    ///
+    /// Like [`lookup_ref`](Self::lookup_ref), fails for databases with
+    /// overlays or without a data section.
+    ///
+    /// # Examples
+    ///
+    /// ```no_run
+    /// use matchy::Database;
+    ///
+    /// let db = Database::from("geo.mxy").open()?;
+    /// let decoder = db.data_decoder().expect("IP database");
+    ///
+    /// for network in db.networks()? {
+    ///     let (addr, data) = network?;
+    ///     println!("{}/{}: {:?}", addr, data.prefix_len, decoder.decode(data.offset)?);
+    /// }
+    /// # Ok::<(), Box<dyn std::error::Error>>(())
+    /// ```
+    pub fn networks(&self) -> Result<Networks<'_>, DatabaseError> {
+        self.check_no_overlays()?;
+        let header = self.data_section_header()?;
+        let tree = (self.format != DatabaseFormat::PatternOnly)
+            .then(|| SearchTree::new(self.data.as_slice(), header).networks());
+        Ok(Networks { db: self, tree })
+    }
 
-        // Check cache first
-        if let Some(cached_result) = self.query_cache.borrow_mut().get(&query) {
-            return Ok(Some(cached_result.clone()));
+    /// Refs point into one file's data section, so layered databases have none
+    fn check_no_overlays(&self) -> Result<(), DatabaseError> {
+        if self.overlays.is_empty() {
+            Ok(())
+        } else {
+            Err(DatabaseError::Unsupported(
+                "Data references are not available on databases with overlays".to_string(),
+            ))
         }
+    }
 
-        // Cache miss - do actual lookup
-        let result = self.lookup_ip_uncached(addr)?;
-
-        // Store in cache if found
-        if let Some(ref res) = result {
-            self.query_cache.borrow_mut().put(query, res.clone());
-        }
+    /// Header of the MMDB section holding the data that refs point into
+    fn data_section_header(&self) -> Result<&MmdbHeader, DatabaseError> {
+        self.ip_header.as_ref().ok_or_else(|| {
+            DatabaseError::Unsupported("Database has no data section to reference".to_string())
+        })
+    }
 
-        Ok(result)
+    /// Count one (never cached) reference lookup
+    fn record_ref_lookup(&self, is_ip: bool, matched: bool) {
+        let tally = DatabaseStats {
+            total_queries: 1,
+            queries_with_match: matched as u64,
+            queries_without_match: !matched as u64,
+            ip_queries: is_ip as u64,
+            string_queries: !is_ip as u64,
+            ..DatabaseStats::default()
+        };
+        self.stats.local().add(&tally);
     }
 
-    /// Look up a string (literal or glob pattern) - uncached internal method
-    ///
-    /// Returns matching pattern IDs and associated data.
-    /// Checks both:
-    /// 1. Literal hash table for O(1) exact matches
-    /// 2. Glob patterns for wildcard matches
-    ///
-    /// A query can match both a literal AND a glob pattern simultaneously.
-    fn lookup_string_uncached(&self, pattern: &str) -> Result<Option<QueryResult>, DatabaseError> {
-        let mut all_pattern_ids = Vec::new();
-        let mut all_data_values = Vec::new();
-
-        // 1. Try literal hash table first (O(1) lookup)
-        if let Some(literal_hash) = &self.literal_hash {
-            if let Some(pattern_id) = literal_hash.lookup(pattern) {
-                // Found an exact match!
-                if let Some(data_offset) = literal_hash.get_data_offset(pattern_id) {
-                    let header = self.ip_header.as_ref().ok_or_else(|| {
-                        DatabaseError::Format(MmdbError::InvalidFormat(
-                            "Literal hash present but no IP header".to_string(),
-                        ))
-                    })?;
-                    let data = self.decode_ip_data(header, data_offset)?;
-                    all_pattern_ids.push(pattern_id);
-                    all_data_values.push(Some(data));
+    /// Data location of a string's first match (literal, then glob)
+    fn string_data_ref(&self, query: &str) -> Result<Option<DataRef>, DatabaseError> {
+        if let Some(literal_hash) = self.literal_section()? {
+            if let Some(offset) = literal_hash
+                .lookup_entry(query)
+                .and_then(|(_, data_offset)| data_offset)
+            {
+                if self.is_tombstone(offset) {
+                    return Ok(None);
                 }
+                return Ok(Some(DataRef {
+                    offset,
+                    prefix_len: 0,
+                }));
             }
         }
 
-        // 2. Check glob patterns (for wildcard matches)
-        if let Some(pg_cell) = &self.pattern_matcher {
-            let pg = pg_cell.borrow();
-            let glob_pattern_ids = pg.find_all(pattern);
-
-            // Add glob matches
-            for &pattern_id in &glob_pattern_ids {
-                // For combined databases, use mappings to decode from MMDB data section
-                // For pattern-only databases, use Paraglob's internal data cache
-                let data = if let Some(mappings) = &self.pattern_data_mappings {
-                    // Combined database: decode from MMDB data section using lazy lookup
-                    if let Some(data_offset) = mappings.get_offset(pattern_id, self.data.as_slice())
-                    {
-                        let header = self.ip_header.as_ref().unwrap();
-                        Some(self.decode_ip_data(header, data_offset)?)
-                    } else {
-                        None
-                    }
-                } else {
-                    // Pattern-only database: use Paraglob's lazy data lookup
-                    pg.get_pattern_data(pattern_id)
-                };
-                all_pattern_ids.push(pattern_id);
-                all_data_values.push(data);
-            }
-        }
-
-        // Return results
-        if all_pattern_ids.is_empty() {
-            // Only return NotFound if we actually have some pattern data
-            if self.literal_hash.is_some() || self.pattern_matcher.is_some() {
-                Ok(Some(QueryResult::NotFound))
-            } else {
-                Ok(None) // No pattern data in this database
-            }
-        } else {
-            Ok(Some(QueryResult::Pattern {
-                pattern_ids: all_pattern_ids,
-                data: all_data_values,
+        let Some(section) = self.pattern_section()? else {
+            return Ok(None);
+        };
+        let Some(mappings) = &section.data_mappings else {
+            return Ok(None);
+        };
+        let mut scratch = self.local_scratch();
+        Ok(section
+            .matcher
+            .find_all_with(query, &mut scratch)
+            .iter()
+            .filter_map(|&id| mappings.get_offset(id, self.data.as_slice()))
+            .find(|&offset| !self.is_tombstone(offset))
+            .map(|offset| DataRef {
+                offset,
+                prefix_len: 0,
             }))
-        }
     }
 
-    /// Look up a string (literal or glob pattern) - public API, uses cache
+    /// Decoder over the data section, for reading [`DataRef`] offsets
     ///
-    /// Returns matching pattern IDs and associated data.
-    pub fn lookup_string(&self, pattern: &str) -> Result<Option<QueryResult>, DatabaseError> {
-        // Check cache first
-        if let Some(cached_result) = self.query_cache.borrow_mut().get(pattern) {
-            return Ok(Some(cached_result.clone()));
-        }
-
-        // Cache miss - do actual lookup
-        let result = self.lookup_string_uncached(pattern)?;
-
-        // Store in cache if found
-        if let Some(ref res) = result {
-            self.query_cache
-                .borrow_mut()
-                .put(pattern.to_string(), res.clone());
-        }
+    /// Returns `None` for pattern-only databases, which have no data section.
+    pub fn data_decoder(&self) -> Option<DataDecoder<'_>> {
+        let header = self.ip_header.as_ref()?;
+        let data_section = self.data.as_slice().get(header.tree_size + 16..)?;
+        Some(DataDecoder::new(data_section, 0))
+    }
 
-        Ok(result)
+    /// Lock the calling thread's pattern matching scratch
+    ///
+    /// Threads map onto stripes by thread slot and there are at least as
+    /// many stripes as cores, so the lock is effectively uncontended.
+    #[inline]
+    fn local_scratch(&self) -> MutexGuard<'_, ParaglobScratch> {
+        let index = thread_slot() & (self.pattern_scratch.len() - 1);
+        lock(&self.pattern_scratch[index].0)
     }
 
-    /// Decode IP data at a given offset
     /// Decode IP data at a given offset
     fn decode_ip_data(&self, header: &MmdbHeader, offset: u32) -> Result<DataValue, DatabaseError> {
-        use crate::data_section::DataDecoder;
-
         // Offsets from the tree are relative to the start of the data section (after the 16-byte separator)
         // So we slice the buffer to start at tree_size + 16
         let data_section_start = header.tree_size + 16;
@@ -903,7 +2499,7 @@ impl Database {
     }
 
     /// Get database format
-    pub fn format(&self) -> &str {
+    pub fn format(&self) -> &'static str {
         match self.format {
             DatabaseFormat::IpOnly => "IP database",
             DatabaseFormat::PatternOnly => "Pattern database",
@@ -916,19 +2512,39 @@ impl Database {
         self.ip_header.is_some()
     }
 
+    /// Check if IPv4 lookups start from a DIR-16 direct-index table
+    ///
+    /// True when opened with `DatabaseOpener::ipv4_direct_index(true)`
+    /// and the file has IP data but no stride index.
+    pub fn has_ipv4_direct_index(&self) -> bool {
+        self.ipv4_index.is_some()
+    }
+
+    /// Check if IP lookups use a multi-bit stride index
+    ///
+    /// True for files built with `MmdbBuilder::with_ip_stride_index`.
+    pub fn has_ip_stride_index(&self) -> bool {
+        self.ip_stride.is_some()
+    }
+
+    /// Check if database has a Bloom prefilter for string lookups
+    pub fn has_prefilter(&self) -> bool {
+        self.prefilter.is_some()
+    }
+
     /// Check if database supports string lookups (literals or patterns)
     pub fn has_string_data(&self) -> bool {
-        self.literal_hash.is_some() || self.pattern_matcher.is_some()
+        self.literals.is_present() || self.patterns.is_present()
     }
 
     /// Check if database supports literal (exact string) lookups
     pub fn has_literal_data(&self) -> bool {
-        self.literal_hash.is_some()
+        self.literals.is_present()
     }
 
     /// Check if database supports glob pattern lookups
     pub fn has_glob_data(&self) -> bool {
-        self.pattern_matcher.is_some()
+        self.patterns.is_present()
     }
 
     /// Check if database supports pattern lookups (deprecated, use has_literal_data or has_glob_data)
@@ -959,8 +2575,19 @@ impl Database {
     /// Returns the pattern string for a given pattern ID.
     /// Returns None if the database has no pattern data or pattern ID is invalid.
     pub fn get_pattern_string(&self, pattern_id: u32) -> Option<String> {
-        let pg_cell = self.pattern_matcher.as_ref()?;
-        let pg = pg_cell.borrow();
+        // IDs from overlay matches are offset past the older layers' IDs
+        if let Some(overlay) = self
+            .overlays
+            .iter()
+            .rev()
+            .find(|overlay| pattern_id >= overlay.id_offset)
+        {
+            return overlay
+                .db
+                .get_pattern_string(pattern_id - overlay.id_offset);
+        }
+
+        let pg = self.pattern_matcher()?;
         pg.get_pattern(pattern_id)
     }
 
@@ -969,11 +2596,8 @@ impl Database {
     /// Returns the number of glob patterns in the database.
     /// Returns 0 if the database has no pattern data.
     pub fn pattern_count(&self) -> usize {
-        match &self.pattern_matcher {
-            Some(pg_cell) => {
-                let pg = pg_cell.borrow();
-                pg.pattern_count()
-            }
+        match self.pattern_matcher() {
+            Some(pg) => pg.pattern_count(),
             None => 0,
         }
     }
@@ -1009,7 +2633,7 @@ impl Database {
             }
         }
         // Fallback to literal_hash entry count
-        match &self.literal_hash {
+        match self.literal_hash() {
             Some(lh) => lh.entry_count() as usize,
             None => 0,
         }
@@ -1106,6 +2730,35 @@ impl Database {
         Self::find_literal_section_slow(data)
     }
 
+    /// Find the IP stride index section from its metadata offset
+    /// Returns the offset to the start of the section data (after its marker)
+    ///
+    /// Unlike the other sections there is no scanning fallback: files written
+    /// before the index existed simply don't have one.
+    fn find_ip_stride_section(data: &[u8]) -> Option<usize> {
+        let metadata = crate::mmdb::MmdbMetadata::from_file(data).ok()?;
+        match metadata.as_value().ok()? {
+            DataValue::Map(map) => match map.get("ip_stride_section_offset") {
+                Some(DataValue::Uint32(offset)) if *offset > 0 => Some(*offset as usize),
+                _ => None,
+            },
+            _ => None,
+        }
+    }
+
+    /// Find the string prefilter section from metadata
+    /// Returns the offset of the section header (after its separator)
+    fn find_prefilter_section(data: &[u8]) -> Option<usize> {
+        let metadata = crate::mmdb::MmdbMetadata::from_file(data).ok()?;
+        match metadata.as_value().ok()? {
+            DataValue::Map(map) => match map.get("prefilter_section_offset") {
+                Some(DataValue::Uint32(offset)) if *offset > 0 => Some(*offset as usize),
+                _ => None,
+            },
+            _ => None,
+        }
+    }
+
     /// Find the literal hash section by scanning (slow, for backwards compatibility)
     /// Returns the offset to the start of MMDB_LITERAL marker
     fn find_literal_section_slow(data: &[u8]) -> Option<usize> {
@@ -1222,6 +2875,18 @@ impl Database {
         Ok((paraglob, mappings))
     }
 
+    /// Read the tombstone record offset of a delta database from its metadata
+    fn read_tombstone_offset_from_metadata(data: &[u8]) -> Option<u32> {
+        let metadata = crate::mmdb::MmdbMetadata::from_file(data).ok()?;
+        match metadata.as_value().ok()? {
+            DataValue::Map(map) => match map.get(crate::delta::TOMBSTONE_METADATA_KEY)? {
+                DataValue::Uint32(offset) => Some(*offset),
+                _ => None,
+            },
+            _ => None,
+        }
+    }
+
     /// Read match mode from database metadata
     /// Returns CaseSensitive as default if not found or on error
     fn read_match_mode_from_metadata(data: &[u8]) -> crate::glob::MatchMode {
@@ -1267,6 +2932,12 @@ impl std::fmt::Display for DatabaseError {
 
 impl std::error::Error for DatabaseError {}
 
+impl From<MmdbError> for DatabaseError {
+    fn from(err: MmdbError) -> Self {
+        DatabaseError::Format(err)
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -1347,3 +3018,536 @@ mod tests {
         assert!(result.is_none() || matches!(result, Some(QueryResult::NotFound)));
     }
 }
+
+#[cfg(test)]
+mod concurrency_tests {
+    use super::*;
+    use crate::data_section::ValueRef;
+    use crate::glob::MatchMode;
+    use crate::mmdb_builder::MmdbBuilder;
+    use std::collections::HashMap;
+    use std::sync::Arc;
+
+    fn build_test_db() -> Vec<u8> {
+        let mut builder = MmdbBuilder::new(MatchMode::CaseSensitive);
+        for i in 0..50 {
+            let mut data = HashMap::new();
+            data.insert("id".to_string(), DataValue::Uint32(i));
+            builder
+                .add_entry(&format!("*.evil{}.com", i), data.clone())
+                .unwrap();
+            builder
+                .add_entry(&format!("exact{}.example", i), data.clone())
+                .unwrap();
+            builder
+                .add_entry(&format!("10.0.{}.0/24", i), data)
+                .unwrap();
+        }
+        builder.build().unwrap()
+    }
+
+    #[test]
+    fn test_shared_handle_across_threads() {
+        let db = Arc::new(
+            Database::from_bytes_builder(build_test_db())
+                .concurrency(8)
+                .cache_capacity(1000)
+                .open()
+                .unwrap(),
+        );
+
+        let handles: Vec<_> = (0..8)
+            .map(|t| {
+                let db = Arc::clone(&db);
+                std::thread::spawn(move || {
+                    for round in 0..200 {
+                        let i = (t * 7 + round) % 50;
+                        let glob = db.lookup(&format!("www.evil{}.com", i)).unwrap();
+                        assert!(matches!(glob, Some(QueryResult::Pattern { .. })));
+                        let literal = db.lookup(&format!("exact{}.example", i)).unwrap();
+                        assert!(matches!(literal, Some(QueryResult::Pattern { .. })));
+                        let ip = db.lookup(&format!("10.0.{}.9", i)).unwrap();
+                        assert!(matches!(ip, Some(QueryResult::Ip { .. })));
+                        let miss = db.lookup("nothing.here").unwrap();
+                        assert!(matches!(miss, Some(QueryResult::NotFound)));
+                    }
+                })
+            })
+            .collect();
+        for handle in handles {
+            handle.join().unwrap();
+        }
+
+        let stats = db.stats();
+        assert_eq!(stats.total_queries, 8 * 200 * 4);
+        assert_eq!(stats.cache_hits + stats.cache_misses, stats.total_queries);
+        assert_eq!(
+            stats.queries_with_match + stats.queries_without_match,
+            stats.total_queries
+        );
+        // One handle, one shared cache: every distinct key is cached once
+        assert!(db.cache_size() <= 50 * 3 + 1);
+    }
+
+    #[test]
+    fn test_lookup_batch_matches_lookup() {
+        let batch_db = Database::from_bytes(build_test_db()).unwrap();
+        let single_db = Database::from_bytes(build_test_db()).unwrap();
+
+        let mut queries = Vec::new();
+        for i in 0..20 {
+            queries.push(format!("10.0.{}.1", i));
+            queries.push(format!("a.evil{}.com", i));
+            queries.push(format!("exact{}.example", i));
+            queries.push(format!("192.168.{}.1", i));
+            queries.push(format!("nope{}.example", i));
+        }
+        // Duplicate keys within one batch are looked up independently
+        queries.extend_from_within(0..10);
+        let refs: Vec<&str> = queries.iter().map(|q| q.as_str()).collect();
+
+        let mut results = Vec::new();
+        batch_db.lookup_batch(&refs, &mut results);
+        assert_eq!(results.len(), refs.len());
+
+        // Second batch is all cache hits
+        let mut cached = Vec::new();
+        batch_db.lookup_batch(&refs, &mut cached);
+
+        for ((query, batched), cached) in refs.iter().zip(&results).zip(&cached) {
+            let single = single_db.lookup(query).unwrap();
+            let batched = batched.as_ref().unwrap();
+            assert_eq!(
+                format!("{:?}", batched),
+                format!("{:?}", single),
+                "{}",
+                query
+            );
+            assert_eq!(
+                format!("{:?}", cached.as_ref().unwrap()),
+                format!("{:?}", single)
+            );
+        }
+
+        let batch_stats = batch_db.stats();
+        assert_eq!(batch_stats.total_queries, 2 * refs.len() as u64);
+        assert_eq!(batch_stats.cache_hits, refs.len() as u64);
+        assert_eq!(
+            batch_stats.queries_with_match,
+            2 * single_db.stats().queries_with_match
+        );
+    }
+
+    #[test]
+    fn test_lookup_ref_matches_lookup() {
+        let db = Database::from_bytes(build_test_db()).unwrap();
+        let decoder = db.data_decoder().unwrap();
+
+        for query in ["10.0.7.1", "www.evil7.com", "exact7.example"] {
+            let found = db.lookup_ref(query).unwrap().unwrap();
+            let id = decoder.lookup_path(found.offset, ["id"]).unwrap().unwrap();
+            assert_eq!(decoder.decode_ref(id).unwrap(), ValueRef::Uint32(7));
+
+            let decoded = decoder.decode(found.offset).unwrap();
+            match db.lookup(query).unwrap().unwrap() {
+                QueryResult::Ip { data, prefix_len } => {
+                    assert_eq!(data, decoded);
+                    assert_eq!(prefix_len, found.prefix_len);
+                }
+                QueryResult::Pattern { data, .. } => {
+                    assert_eq!(data[0].as_ref(), Some(&decoded));
+                    assert_eq!(found.prefix_len, 0);
+                }
+                QueryResult::NotFound => panic!("{} should match", query),
+            }
+        }
+
+        assert_eq!(db.lookup_ref("192.168.1.1").unwrap(), None);
+        assert_eq!(db.lookup_ref("nothing.here").unwrap(), None);
+        // Lazy lookups never touch the cache
+        assert_eq!(db.cache_size(), 3);
+    }
+
+    #[test]
+    fn test_lookup_ips_sorted_matches_lookup_ip() {
+        let sorted_db = Database::from_bytes(build_test_db()).unwrap();
+        let single_db = Database::from_bytes(build_test_db()).unwrap();
+
+        // Unsorted, with runs in one network, misses, duplicates and IPv6
+        let mut addrs: Vec<IpAddr> = Vec::new();
+        for i in (0..30).rev() {
+            for host in [200, 1, 77] {
+                addrs.push(format!("10.0.{}.{}", i, host).parse().unwrap());
+            }
+            addrs.push(format!("192.168.{}.1", i).parse().unwrap());
+        }
+        addrs.extend_from_within(0..5);
+        addrs.push("2001:db8::1".parse().unwrap());
+
+        let mut results = Vec::new();
+        sorted_db.lookup_ips_sorted(&addrs, &mut results);
+        let mut refs = Vec::new();
+        sorted_db.lookup_ip_refs_sorted(&addrs, &mut refs).unwrap();
+        assert_eq!(results.len(), addrs.len());
+        assert_eq!(refs.len(), addrs.len());
+
+        for ((addr, result), found) in addrs.iter().zip(&results).zip(&refs) {
+            assert_eq!(
+                format!("{:?}", result.as_ref().unwrap()),
+                format!("{:?}", single_db.lookup_ip(*addr).unwrap()),
+                "{}",
+                addr
+            );
+            assert_eq!(*found, single_db.lookup_ip_ref(*addr).unwrap(), "{}", addr);
+        }
+
+        let stats = sorted_db.stats();
+        assert_eq!(stats.total_queries, 2 * addrs.len() as u64);
+        assert_eq!(stats.cache_hits + stats.cache_misses, 0);
+        assert_eq!(sorted_db.cache_size(), 0);
+    }
+
+    #[test]
+    fn test_networks_lists_ip_tree() {
+        let db = Database::from_bytes(build_test_db()).unwrap();
+        let decoder = db.data_decoder().unwrap();
+
+        let networks: Vec<(IpAddr, DataRef)> = db.networks().unwrap().map(Result::unwrap).collect();
+        assert_eq!(networks.len(), 50);
+        for (i, (addr, data)) in networks.iter().enumerate() {
+            assert_eq!(*addr, format!("10.0.{}.0", i).parse::<IpAddr>().unwrap());
+            assert_eq!(data.prefix_len, 24);
+            assert_eq!(db.lookup_ip_ref(*addr).unwrap(), Some(*data));
+            let id = decoder.lookup_path(data.offset, ["id"]).unwrap().unwrap();
+            assert_eq!(decoder.decode_ref(id).unwrap(), ValueRef::Uint32(i as u32));
+        }
+    }
+
+    #[test]
+    fn test_ipv4_direct_index_option() {
+        let plain = Database::from_bytes(build_test_db()).unwrap();
+        let indexed = Database::from_bytes_builder(build_test_db())
+            .ipv4_direct_index(true)
+            .open()
+            .unwrap();
+        assert!(!plain.has_ipv4_direct_index());
+        assert!(indexed.has_ipv4_direct_index());
+
+        for i in 0..60 {
+            let query = format!("10.0.{}.{}", i, i);
+            let expected = plain.lookup_ref(&query).unwrap();
+            assert_eq!(indexed.lookup_ref(&query).unwrap(), expected, "{}", query);
+        }
+        assert!(indexed.lookup("10.0.7.1").unwrap().is_some());
+    }
+
+    #[test]
+    fn test_cached_results_match_uncached() {
+        let cached = Database::from_bytes(build_test_db()).unwrap();
+        let uncached = Database::from_bytes_builder(build_test_db())
+            .no_cache()
+            .open()
+            .unwrap();
+
+        let queries = ["10.0.7.1", "x.evil7.com", "exact7.example", "nope.example"];
+        for round in 0..2 {
+            for query in queries {
+                assert_eq!(
+                    format!("{:?}", cached.lookup(query).unwrap()),
+                    format!("{:?}", uncached.lookup(query).unwrap()),
+                    "{} (round {})",
+                    query,
+                    round
+                );
+            }
+        }
+        assert_eq!(cached.stats().cache_hits, queries.len() as u64);
+
+        // Textual and binary IP queries share one binary-keyed entry
+        let addr: IpAddr = "10.0.7.1".parse().unwrap();
+        assert!(matches!(
+            cached.lookup_ip(addr).unwrap(),
+            Some(QueryResult::Ip { prefix_len: 24, .. })
+        ));
+        assert_eq!(cached.stats().cache_hits, queries.len() as u64 + 1);
+        assert_eq!(cached.cache_size(), queries.len());
+    }
+
+    #[test]
+    fn test_prefilter_matches_unfiltered() {
+        for extra_glob in [None, Some("*bad*")] {
+            let build = |prefilter: bool| {
+                let mut builder =
+                    MmdbBuilder::new(MatchMode::CaseInsensitive).with_prefilter(prefilter);
+                for i in 0..50 {
+                    builder
+                        .add_entry(&format!("*.Evil{}.com", i), HashMap::new())
+                        .unwrap();
+                    builder
+                        .add_entry(&format!("Exact{}.example", i), HashMap::new())
+                        .unwrap();
+                }
+                if let Some(glob) = extra_glob {
+                    builder.add_entry(glob, HashMap::new()).unwrap();
+                }
+                Database::from_bytes_builder(builder.build().unwrap())
+                    .no_cache()
+                    .open()
+                    .unwrap()
+            };
+            let filtered = build(true);
+            let plain = build(false);
+            assert!(filtered.has_prefilter());
+            assert!(!plain.has_prefilter());
+
+            let queries = [
+                "www.evil7.com",
+                "WWW.EVIL49.COM",
+                "exact3.EXAMPLE",
+                "exact3.example.org",
+                "a.bad.net",
+                "nope.example",
+                "com",
+                "",
+            ];
+            for query in queries {
+                assert_eq!(
+                    format!("{:?}", filtered.lookup_string(query).unwrap()),
+                    format!("{:?}", plain.lookup_string(query).unwrap()),
+                    "{} (extra glob {:?})",
+                    query,
+                    extra_glob
+                );
+            }
+        }
+    }
+
+    #[test]
+    fn test_negative_cache() {
+        let db = Database::from_bytes_builder(build_test_db())
+            .cache_capacity(2)
+            .negative_cache(1024)
+            .open()
+            .unwrap();
+        db.lookup("exact1.example").unwrap();
+        for i in 0..100 {
+            assert!(matches!(
+                db.lookup(&format!("miss{}.example", i)).unwrap(),
+                Some(QueryResult::NotFound)
+            ));
+        }
+        assert!(matches!(
+            db.lookup("miss99.example").unwrap(),
+            Some(QueryResult::NotFound)
+        ));
+        // Misses went to the negative cache, so the hit is still cached
+        db.lookup("exact1.example").unwrap();
+        assert!(matches!(
+            db.lookup("10.99.0.1").unwrap(),
+            Some(QueryResult::NotFound)
+        ));
+        assert!(matches!(
+            db.lookup("10.99.0.1").unwrap(),
+            Some(QueryResult::NotFound)
+        ));
+        assert_eq!(db.stats().cache_hits, 3);
+    }
+
+    #[test]
+    fn test_cache_policies() {
+        for policy in [
+            CachePolicy::Lru,
+            CachePolicy::Clock,
+            CachePolicy::S3Fifo,
+            CachePolicy::TinyLfu,
+        ] {
+            let db = Database::from_bytes_builder(build_test_db())
+                .cache_capacity(20)
+                .cache_policy(policy)
+                .open()
+                .unwrap();
+            let uncached = Database::from_bytes_builder(build_test_db())
+                .no_cache()
+                .open()
+                .unwrap();
+            for round in 0..3 {
+                for i in 0..50 {
+                    let query = format!("exact{}.example", (i * 7 + round) % 50);
+                    assert_eq!(
+                        format!("{:?}", db.lookup(&query).unwrap()),
+                        format!("{:?}", uncached.lookup(&query).unwrap()),
+                        "{:?}",
+                        policy
+                    );
+                }
+            }
+            let stats = db.stats();
+            assert!(db.cache_size() <= 20 + 1, "{:?}", policy);
+            assert_eq!(
+                stats.cache_evictions,
+                stats.cache_misses - db.cache_size() as u64,
+                "{:?}",
+                policy
+            );
+            assert!(stats.cache_rejections <= stats.cache_evictions);
+        }
+    }
+
+    #[test]
+    fn test_prefault_options() {
+        let mut file = tempfile::NamedTempFile::new().unwrap();
+        std::io::Write::write_all(&mut file, &build_test_db()).unwrap();
+
+        let plain = Database::from(file.path()).open().unwrap();
+        let warm = Database::from(file.path())
+            .prefault(true)
+            .huge_pages(true)
+            .open()
+            .unwrap();
+
+        // Tree, literal table and glob automaton, all inside the file
+        let hot = warm.hot_ranges();
+        assert_eq!(hot.len(), 3);
+        assert!(hot
+            .iter()
+            .all(|r| r.start < r.end && r.end <= warm.data.as_slice().len()));
+
+        for query in ["10.0.7.1", "x.evil7.com", "exact7.example", "nope.example"] {
+            assert_eq!(
+                format!("{:?}", warm.lookup(query).unwrap()),
+                format!("{:?}", plain.lookup(query).unwrap()),
+                "{}",
+                query
+            );
+        }
+    }
+
+    #[test]
+    fn test_trusted_open() {
+        let bytes = build_test_db();
+        let plain = Database::from_bytes(bytes.clone()).unwrap();
+        let trusted = Database::from_bytes_builder(bytes.clone())
+            .trusted(true)
+            .open()
+            .unwrap();
+
+        // Nothing parsed yet, and IP lookups don't need the string sections
+        assert!(trusted.has_literal_data() && trusted.has_glob_data());
+        assert!(trusted.literals.value.get().is_none());
+        assert!(trusted.patterns.value.get().is_none());
+        trusted.lookup("10.0.7.1").unwrap();
+        assert!(trusted.literals.value.get().is_none());
+
+        for query in ["10.0.7.1", "x.evil7.com", "exact7.example", "nope.example"] {
+            assert_eq!(
+                format!("{:?}", trusted.lookup(query).unwrap()),
+                format!("{:?}", plain.lookup(query).unwrap()),
+                "{}",
+                query
+            );
+        }
+        assert!(trusted.literals.value.get().is_some());
+        assert!(trusted.patterns.value.get().is_some());
+
+        // A damaged section header fails the checksum
+        let literal = Database::find_literal_section_fast(&bytes).unwrap() + 16;
+        let mut damaged = bytes;
+        damaged[literal + 8] ^= 0xff;
+        let err = Database::from_bytes_builder(damaged)
+            .trusted(true)
+            .open()
+            .err()
+            .unwrap();
+        assert!(err.to_string().contains("checksum"), "{}", err);
+    }
+
+    #[test]
+    fn test_perfect_hash_literals() {
+        let build = |perfect_hash: bool| {
+            let mut builder = MmdbBuilder::new(MatchMode::CaseInsensitive)
+                .with_perfect_hash_literals(perfect_hash);
+            for i in 0..200 {
+                let mut data = HashMap::new();
+                data.insert("id".to_string(), DataValue::Uint32(i));
+                builder
+                    .add_entry(&format!("Exact{}.example", i), data.clone())
+                    .unwrap();
+                builder
+                    .add_entry(&format!("a-much-longer-literal-{}.example.org", i), data)
+                    .unwrap();
+            }
+            builder.add_entry("*.evil.com", HashMap::new()).unwrap();
+            Database::from_bytes(builder.build().unwrap()).unwrap()
+        };
+        let plain = build(false);
+        let perfect = build(true);
+        assert!(!plain.literal_hash().unwrap().is_perfect_hash());
+        assert!(perfect.literal_hash().unwrap().is_perfect_hash());
+
+        // The section is cache-line aligned
+        let offset = Database::find_literal_section_fast(perfect.static_data()).unwrap() + 16;
+        assert_eq!(offset % 64, 0);
+
+        for query in [
+            "exact7.example",
+            "EXACT199.EXAMPLE",
+            "a-much-longer-literal-42.example.org",
+            "a-much-longer-literal-200.example.org",
+            "x.evil.com",
+            "exact.example",
+        ] {
+            assert_eq!(
+                format!("{:?}", perfect.lookup(query).unwrap()),
+                format!("{:?}", plain.lookup(query).unwrap()),
+                "{}",
+                query
+            );
+        }
+    }
+
+    #[test]
+    fn test_no_cache_stays_empty() {
+        let db = Database::from_bytes_builder(build_test_db())
+            .no_cache()
+            .open()
+            .unwrap();
+        db.lookup("www.evil1.com").unwrap();
+        db.lookup_string("exact1.example").unwrap();
+        assert_eq!(db.cache_size(), 0);
+        assert_eq!(db.stats().cache_misses, 0);
+    }
+
+    #[test]
+    fn test_profiler_samples_stages() {
+        use crate::profile::{QueryProfiler, QueryStage};
+
+        let profiler = std::sync::Arc::new(QueryProfiler::new(1));
+        let db = Database::from_bytes_builder(build_test_db())
+            .no_cache()
+            .profiler(std::sync::Arc::clone(&profiler))
+            .open()
+            .unwrap();
+        db.lookup("10.0.3.7").unwrap();
+        db.lookup("www.evil1.com").unwrap();
+        db.lookup("exact2.example").unwrap();
+        db.lookup("nothing.here").unwrap();
+
+        let profile = profiler.snapshot();
+        assert_eq!(profile.sampled_queries, 4);
+        assert_eq!(profile.stage(QueryStage::IpTree).count(), 1);
+        assert_eq!(profile.stage(QueryStage::LiteralHash).count(), 3);
+        assert_eq!(profile.stage(QueryStage::PatternScan).count(), 3);
+        assert_eq!(profile.stage(QueryStage::GlobVerify).count(), 3);
+        assert_eq!(profile.stage(QueryStage::DataDecode).count(), 4);
+        assert_eq!(profile.literal_lookups, 3);
+        assert!(profile.mean_probe_length() >= 1.0);
+        assert!(profile.ac_states_visited > 0);
+        assert!(profile.globs_checked >= profile.globs_rejected);
+
+        // Without a profiler nothing is sampled
+        let plain = Database::from_bytes(build_test_db()).unwrap();
+        plain.lookup("www.evil1.com").unwrap();
+        assert!(plain.profiler().is_none());
+        assert_eq!(profiler.snapshot().sampled_queries, 4);
+    }
+}
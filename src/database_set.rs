@@ -0,0 +1,480 @@
+//! Fused lookups across several databases
+//!
+//! Running many feeds side by side (geo, ASN, blocklists, allowlists) with
+//! one [`Database`] each means every indicator is normalized, hashed and
+//! scanned once per database. A [`DatabaseSet`] merges the glob patterns
+//! of all members that share a match mode into one automaton at build
+//! time, so a string query runs one scan per mode, and hashes its literal
+//! key once per mode for all of the members' literal tables. Matches are
+//! mapped back to each member's own pattern IDs and data, so results are
+//! the same as looking the query up in every member.
+//!
+//! IP queries still walk each member's tree; the trees are separate files
+//! with their own data sections.
+
+use crate::database::{scratch_stripe_count_for, Database, DatabaseError, QueryResult};
+use crate::glob::MatchMode;
+use crate::literal_hash::LiteralKey;
+use crate::paraglob_offset::{Paraglob, ParaglobBuilder, ParaglobScratch};
+use crate::query_cache::{lock, thread_slot};
+use std::net::IpAddr;
+use std::sync::Mutex;
+
+/// Several databases answered by one scan per query
+///
+/// Built once from the member handles; the merged automaton costs about as
+/// much memory as the members' pattern sections together. Fused lookups
+/// bypass the members' query caches and statistics. Members with overlays,
+/// or whose string sections fail to load, are looked up on their own and
+/// report their errors as they would alone.
+///
+/// A set is `Sync`: [`lookup`](Self::lookup) picks the calling thread's
+/// scratch from a stripe per core, so threads sharing a set don't contend.
+///
+/// # Examples
+///
+/// ```no_run
+/// use matchy::{Database, DatabaseSet};
+///
+/// let set = DatabaseSet::new(vec![
+///     ("threats".to_string(), Database::from("threats.mxy").open()?),
+///     ("allowlist".to_string(), Database::from("allowlist.mxy").open()?),
+/// ]);
+///
+/// for (id, result) in set.lookup("www.evil.com")? {
+///     println!("{}: {:?}", id, result);
+/// }
+/// # Ok::<(), Box<dyn std::error::Error>>(())
+/// ```
+pub struct DatabaseSet {
+    members: Vec<(String, Database)>,
+    groups: Vec<FusedGroup>,
+    /// Members with string data that are looked up on their own
+    separate: Vec<usize>,
+    /// Scratch for [`lookup`](Self::lookup), one stripe per thread slot
+    scratch: Box<[ScratchStripe]>,
+}
+
+/// One thread stripe of set scratch, padded to its own cache line
+#[repr(align(64))]
+#[derive(Default)]
+struct ScratchStripe(Mutex<DatabaseSetScratch>);
+
+/// Members that share a match mode, with their globs merged
+struct FusedGroup {
+    mode: MatchMode,
+    members: Vec<usize>,
+    /// Every distinct member glob; None when no member has any
+    matcher: Option<Paraglob>,
+    /// Merged pattern ID -> (member, member pattern ID) for each owner
+    owners: Vec<Vec<(usize, u32)>>,
+}
+
+/// Reusable buffers for [`DatabaseSet::lookup_with`]
+///
+/// Keep one per thread to make lookups allocation-free.
+#[derive(Default)]
+pub struct DatabaseSetScratch {
+    pattern: ParaglobScratch,
+    /// Member index -> that member's glob matches for the current query
+    globs: Vec<Vec<u32>>,
+}
+
+impl DatabaseSetScratch {
+    /// Create empty scratch
+    pub fn new() -> Self {
+        Self::default()
+    }
+}
+
+impl DatabaseSet {
+    /// Fuse `databases`, each tagged with the ID its results are reported under
+    pub fn new(databases: Vec<(String, Database)>) -> Self {
+        let mut pending: Vec<PendingGroup> = Vec::new();
+        let mut separate = Vec::new();
+
+        for (index, (_, database)) in databases.iter().enumerate() {
+            if database.has_overlays() {
+                separate.push(index);
+                continue;
+            }
+            if !database.has_string_data() {
+                // String lookups on IP-only databases find nothing
+                continue;
+            }
+            let (Ok(_), Ok(globs)) = (database.literal_section(), database.glob_matcher()) else {
+                separate.push(index);
+                continue;
+            };
+
+            let mode = database.mode();
+            let group = match pending.iter().position(|g| g.group.mode == mode) {
+                Some(group) => &mut pending[group],
+                None => {
+                    pending.push(PendingGroup::new(mode));
+                    pending.last_mut().unwrap()
+                }
+            };
+            group.group.members.push(index);
+            if let Some(globs) = globs {
+                group.failed |= group.add_globs(index, globs).is_none();
+            }
+        }
+
+        let mut groups = Vec::with_capacity(pending.len());
+        for pending in pending {
+            match pending.finish() {
+                Ok(group) => groups.push(group),
+                // Could not be merged: look its members up on their own
+                Err(members) => separate.extend(members),
+            }
+        }
+        separate.sort_unstable();
+
+        Self {
+            members: databases,
+            groups,
+            separate,
+            scratch: (0..scratch_stripe_count_for(1))
+                .map(|_| ScratchStripe::default())
+                .collect(),
+        }
+    }
+
+    /// Number of member databases
+    pub fn len(&self) -> usize {
+        self.members.len()
+    }
+
+    /// Whether the set has no members
+    pub fn is_empty(&self) -> bool {
+        self.members.is_empty()
+    }
+
+    /// ID of the member at `index`, as passed to [`new`](Self::new)
+    pub fn id(&self, index: usize) -> &str {
+        &self.members[index].0
+    }
+
+    /// Member added under `id`, if any
+    pub fn get(&self, id: &str) -> Option<&Database> {
+        self.members
+            .iter()
+            .find(|(member_id, _)| member_id == id)
+            .map(|(_, database)| database)
+    }
+
+    /// Swap in a new version of the member added under `id`
+    ///
+    /// The merged automaton is rebuilt. Returns the previous database, or
+    /// gives `database` back if no member has that id.
+    pub fn replace(&mut self, id: &str, database: Database) -> Result<Database, Database> {
+        let Some(index) = self
+            .members
+            .iter()
+            .position(|(member_id, _)| member_id == id)
+        else {
+            return Err(database);
+        };
+        let mut members = std::mem::take(&mut self.members);
+        let previous = std::mem::replace(&mut members[index].1, database);
+        let scratch = std::mem::take(&mut self.scratch);
+        *self = Self::new(members);
+        self.scratch = scratch;
+        Ok(previous)
+    }
+
+    /// Look up a query (IP address or string) in every member
+    ///
+    /// Returns the members that matched, in the order they were added,
+    /// tagged with their IDs.
+    pub fn lookup(&self, query: &str) -> Result<Vec<(&str, QueryResult)>, DatabaseError> {
+        let mut found = Vec::new();
+        let stripe = &self.scratch[thread_slot() & (self.scratch.len() - 1)];
+        self.lookup_with(query, &mut lock(&stripe.0), &mut found)?;
+        Ok(found
+            .into_iter()
+            .map(|(index, result)| (self.id(index), result))
+            .collect())
+    }
+
+    /// [`lookup`](Self::lookup) with caller-provided scratch
+    ///
+    /// Replaces `out` with `(member index, result)` for each member that
+    /// matched, in member order; [`id`](Self::id) names the member.
+    pub fn lookup_with(
+        &self,
+        query: &str,
+        scratch: &mut DatabaseSetScratch,
+        out: &mut Vec<(usize, QueryResult)>,
+    ) -> Result<(), DatabaseError> {
+        if let Ok(addr) = query.parse::<IpAddr>() {
+            return self.lookup_ip(addr, out);
+        }
+        self.lookup_string_with(query, scratch, out)
+    }
+
+    /// Look up an IP address in every member
+    ///
+    /// Replaces `out` like [`lookup_with`](Self::lookup_with). Each member
+    /// walks its own tree, through its cache.
+    pub fn lookup_ip(
+        &self,
+        addr: IpAddr,
+        out: &mut Vec<(usize, QueryResult)>,
+    ) -> Result<(), DatabaseError> {
+        out.clear();
+        for (index, (_, database)) in self.members.iter().enumerate() {
+            push_found(out, index, database.lookup_ip(addr)?);
+        }
+        Ok(())
+    }
+
+    /// Look up a string (literal or glob) in every member
+    ///
+    /// Replaces `out` like [`lookup_with`](Self::lookup_with).
+    pub fn lookup_string_with(
+        &self,
+        query: &str,
+        scratch: &mut DatabaseSetScratch,
+        out: &mut Vec<(usize, QueryResult)>,
+    ) -> Result<(), DatabaseError> {
+        out.clear();
+        scratch.globs.resize_with(self.members.len(), Vec::new);
+        scratch.globs.iter_mut().for_each(Vec::clear);
+
+        for &index in &self.separate {
+            push_found(out, index, self.members[index].1.lookup_string(query)?);
+        }
+
+        for group in &self.groups {
+            if let Some(matcher) = &group.matcher {
+                for &merged in matcher.find_all_with(query, &mut scratch.pattern) {
+                    for &(member, pattern_id) in &group.owners[merged as usize] {
+                        scratch.globs[member].push(pattern_id);
+                    }
+                }
+            }
+
+            // Normalized and hashed once for all of the group's tables
+            let key = LiteralKey::new(query, group.mode);
+            for &index in &group.members {
+                let database = &self.members[index].1;
+                let literal = database
+                    .literal_section()?
+                    .and_then(|table| table.lookup_entry_prepared(&key));
+                let globs = &mut scratch.globs[index];
+                // Shared globs can arrive out of member order
+                globs.sort_unstable();
+                push_found(out, index, database.string_result_from(literal, globs)?);
+            }
+        }
+
+        if !self.separate.is_empty() || self.groups.len() > 1 {
+            out.sort_by_key(|&(index, _)| index);
+        }
+        Ok(())
+    }
+}
+
+/// A group whose merged automaton is still being built
+struct PendingGroup {
+    group: FusedGroup,
+    builder: ParaglobBuilder,
+    /// A member glob could not be read back or merged
+    failed: bool,
+}
+
+impl PendingGroup {
+    fn new(mode: MatchMode) -> Self {
+        Self {
+            group: FusedGroup {
+                mode,
+                members: Vec::new(),
+                matcher: None,
+                owners: Vec::new(),
+            },
+            builder: ParaglobBuilder::new(mode),
+            failed: false,
+        }
+    }
+
+    /// Add a member's globs, recording which merged pattern each became
+    fn add_globs(&mut self, member: usize, globs: &Paraglob) -> Option<()> {
+        let owners = &mut self.group.owners;
+        for pattern_id in 0..globs.pattern_count() as u32 {
+            let pattern = globs.get_pattern(pattern_id)?;
+            // Duplicate globs come back with the ID they were first given
+            let merged = self.builder.add_pattern(&pattern).ok()? as usize;
+            if owners.len() <= merged {
+                owners.resize_with(merged + 1, Vec::new);
+            }
+            owners[merged].push((member, pattern_id));
+        }
+        Some(())
+    }
+
+    /// Build the merged automaton, or give back the members if that fails
+    fn finish(self) -> Result<FusedGroup, Vec<usize>> {
+        let mut group = self.group;
+        if self.failed {
+            return Err(group.members);
+        }
+        if self.builder.pattern_count() > 0 {
+            match self.builder.build() {
+                Ok(matcher) => group.matcher = Some(matcher),
+                Err(_) => return Err(group.members),
+            }
+        }
+        Ok(group)
+    }
+}
+
+/// Keep a member's result unless it is a miss
+fn push_found(out: &mut Vec<(usize, QueryResult)>, index: usize, result: Option<QueryResult>) {
+    match result {
+        None | Some(QueryResult::NotFound) => {}
+        Some(result) => out.push((index, result)),
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::data_section::DataValue;
+    use crate::mmdb_builder::MmdbBuilder;
+    use std::collections::HashMap;
+
+    fn build_db(mode: MatchMode, entries: &[&str]) -> Database {
+        let mut builder = MmdbBuilder::new(mode);
+        for (i, entry) in entries.iter().enumerate() {
+            let mut data = HashMap::new();
+            data.insert("id".to_string(), DataValue::Uint32(i as u32));
+            builder.add_entry(entry, data).unwrap();
+        }
+        Database::from_bytes_builder(builder.build().unwrap())
+            .open()
+            .unwrap()
+    }
+
+    fn same(a: &QueryResult, b: &QueryResult) -> bool {
+        match (a, b) {
+            (
+                QueryResult::Ip { data, prefix_len },
+                QueryResult::Ip {
+                    data: other_data,
+                    prefix_len: other_len,
+                },
+            ) => data == other_data && prefix_len == other_len,
+            (
+                QueryResult::Pattern { pattern_ids, data },
+                QueryResult::Pattern {
+                    pattern_ids: other_ids,
+                    data: other_data,
+                },
+            ) => pattern_ids == other_ids && data == other_data,
+            (QueryResult::NotFound, QueryResult::NotFound) => true,
+            _ => false,
+        }
+    }
+
+    #[test]
+    fn test_fused_lookup_matches_each_member() {
+        let specs: [(&str, MatchMode, &[&str]); 4] = [
+            (
+                "threats",
+                MatchMode::CaseSensitive,
+                &["*.evil.com", "bad.example", "10.0.0.0/8", "mal*.net"],
+            ),
+            (
+                "feed",
+                MatchMode::CaseInsensitive,
+                &["*.EVIL.com", "Bad.Example", "*.phish.org", "192.168.1.0/24"],
+            ),
+            (
+                "geo",
+                MatchMode::CaseSensitive,
+                &["10.1.0.0/16", "8.8.8.0/24"],
+            ),
+            (
+                "shared",
+                MatchMode::CaseSensitive,
+                &["mal*.net", "*.evil.com"],
+            ),
+        ];
+        // Each database opened twice: fused, and to look up one at a time
+        let expected: Vec<Database> = specs
+            .iter()
+            .map(|&(_, mode, entries)| build_db(mode, entries))
+            .collect();
+        let set = DatabaseSet::new(
+            specs
+                .iter()
+                .map(|&(id, mode, entries)| (id.to_string(), build_db(mode, entries)))
+                .collect(),
+        );
+
+        let queries = [
+            "www.evil.com",
+            "WWW.EVIL.COM",
+            "bad.example",
+            "BAD.EXAMPLE",
+            "malware.net",
+            "login.phish.org",
+            "nothing.here",
+            "10.1.2.3",
+            "192.168.1.7",
+            "8.8.8.8",
+        ];
+        // Both match modes fused; the IP-only member has no string work
+        assert_eq!(set.groups.len(), 2);
+        assert!(set.separate.is_empty());
+
+        let mut scratch = DatabaseSetScratch::new();
+        let mut out = Vec::new();
+        for query in queries {
+            set.lookup_with(query, &mut scratch, &mut out).unwrap();
+            let mut want = Vec::new();
+            for (index, db) in expected.iter().enumerate() {
+                push_found(&mut want, index, db.lookup(query).unwrap());
+            }
+            assert_eq!(out.len(), want.len(), "{}", query);
+            for ((index, got), (want_index, want)) in out.iter().zip(&want) {
+                assert_eq!(index, want_index, "{}", query);
+                assert!(same(got, want), "{}: {:?} != {:?}", query, got, want);
+            }
+        }
+
+        let ids: Vec<_> = set
+            .lookup("www.evil.com")
+            .unwrap()
+            .into_iter()
+            .map(|(id, _)| id)
+            .collect();
+        assert_eq!(ids, vec!["threats", "feed", "shared"]);
+    }
+
+    #[test]
+    fn test_replace_rebuilds() {
+        let mut set = DatabaseSet::new(vec![
+            (
+                "a".to_string(),
+                build_db(MatchMode::CaseSensitive, &["*.old.com"]),
+            ),
+            (
+                "b".to_string(),
+                build_db(MatchMode::CaseSensitive, &["*.other.com"]),
+            ),
+        ]);
+        assert_eq!(set.lookup("x.old.com").unwrap().len(), 1);
+
+        let fresh = build_db(MatchMode::CaseSensitive, &["*.new.com"]);
+        assert!(set.replace("a", fresh).is_ok());
+        assert!(set.lookup("x.old.com").unwrap().is_empty());
+        assert_eq!(set.lookup("x.new.com").unwrap()[0].0, "a");
+        assert_eq!(set.lookup("x.other.com").unwrap()[0].0, "b");
+
+        let missing = build_db(MatchMode::CaseSensitive, &["*.c.com"]);
+        assert!(set.replace("c", missing).is_err());
+    }
+}
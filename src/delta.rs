@@ -0,0 +1,395 @@
+//! Delta Databases and Compaction
+//!
+//! A delta is an ordinary matchy database holding only what changed since
+//! a base database was built: new or updated keys as regular entries, and
+//! removed keys as tombstones (`MmdbBuilder::add_tombstone`). It is layered
+//! over the base at open time (`DatabaseOpener::overlay`), so a feed update
+//! ships and loads in seconds instead of rebuilding and redeploying the
+//! whole base.
+//!
+//! Tombstones share one data record, `{"__matchy_tombstone__": true}`. Its
+//! offset is written to the metadata key `delta_tombstone_offset`; lookups
+//! compare data offsets against it and never decode it. Entry data equal to
+//! the tombstone record is therefore reserved.
+//!
+//! [`compact`] folds a base and its deltas into a builder for a new base,
+//! with the same answers a layered [`Database`] gives.
+
+use crate::data_section::DataValue;
+use crate::database::{Database, DatabaseError, StoredData, StoredKey};
+use crate::glob::MatchMode;
+use crate::mmdb_builder::MmdbBuilder;
+use std::collections::{BTreeMap, HashMap};
+use std::net::{IpAddr, Ipv4Addr, Ipv6Addr};
+
+/// Metadata key holding the tombstone record's data offset
+pub const TOMBSTONE_METADATA_KEY: &str = "delta_tombstone_offset";
+
+/// Key of the (single-entry) tombstone record map
+pub const TOMBSTONE_FIELD: &str = "__matchy_tombstone__";
+
+/// The data record shared by all tombstoned keys
+pub(crate) fn tombstone_record() -> DataValue {
+    let mut record = HashMap::new();
+    record.insert(TOMBSTONE_FIELD.to_string(), DataValue::Bool(true));
+    DataValue::Map(record)
+}
+
+/// Where a merged entry's data comes from
+#[derive(Clone)]
+enum Record {
+    /// Data section offset in layer `layer` (0 = base)
+    Offset { layer: usize, offset: u32 },
+    /// Already decoded (pattern-only databases)
+    Value(Option<DataValue>),
+}
+
+/// Networks keyed by (start address, depth) in IPv6 tree coordinates,
+/// where IPv4 lives under `::/96`. Entries never overlap.
+type NetworkMap = BTreeMap<(u128, u8), Record>;
+
+/// Merge a base database and its deltas into a builder for a new base
+///
+/// Deltas are applied oldest first with the rules of
+/// [`Database::with_overlay`]: a delta network replaces older data for
+/// every address it covers, a literal or glob replaces the same key, and
+/// tombstones remove. The builder carries over the base's match mode,
+/// database type and description; call `build()` on it to write the file.
+///
+/// All data records must be maps, as they are in databases written by
+/// [`MmdbBuilder`].
+pub fn compact(base: &Database, deltas: &[Database]) -> Result<MmdbBuilder, DatabaseError> {
+    let layers: Vec<&Database> = std::iter::once(base).chain(deltas).collect();
+
+    let mut networks = NetworkMap::new();
+    let mut literals = BTreeMap::new();
+    let mut globs = BTreeMap::new();
+
+    for (layer, db) in layers.iter().enumerate() {
+        db.for_each_stored_entry(|key, data| {
+            let record = match data {
+                StoredData::Offset(offset) => Some(Record::Offset { layer, offset }),
+                StoredData::Value(value) => Some(Record::Value(value)),
+                StoredData::Tombstone => None,
+            };
+            match key {
+                StoredKey::Network(addr, prefix_len) => {
+                    let (start, depth) = tree_coordinates(addr, prefix_len);
+                    carve(&mut networks, start, depth);
+                    if let Some(record) = record {
+                        networks.insert((start, depth), record);
+                    }
+                }
+                StoredKey::Literal(literal) => apply(&mut literals, literal, record),
+                StoredKey::Glob(glob) => apply(&mut globs, glob, record),
+            }
+            Ok(())
+        })?;
+    }
+
+    let mut builder = MmdbBuilder::new(match_mode_of(&layers));
+    if let Some(DataValue::Map(metadata)) = base.metadata() {
+        if let Some(DataValue::String(db_type)) = metadata.get("database_type") {
+            builder = builder.with_database_type(db_type.clone());
+        }
+        if let Some(DataValue::Map(description)) = metadata.get("description") {
+            for (language, text) in description {
+                if let DataValue::String(text) = text {
+                    builder = builder.with_description(language.clone(), text.clone());
+                }
+            }
+        }
+    }
+
+    // Shared records are decoded once per (layer, offset)
+    let mut decoded: HashMap<(usize, u32), HashMap<String, DataValue>> = HashMap::new();
+    let mut data_for = |record: Record| -> Result<HashMap<String, DataValue>, DatabaseError> {
+        match record {
+            Record::Value(None) => Ok(HashMap::new()),
+            Record::Value(Some(value)) => into_map(value),
+            Record::Offset { layer, offset } => {
+                if let Some(map) = decoded.get(&(layer, offset)) {
+                    return Ok(map.clone());
+                }
+                let map = into_map(layers[layer].decode_record(offset)?)?;
+                decoded.insert((layer, offset), map.clone());
+                Ok(map)
+            }
+        }
+    };
+
+    let to_build_error = |e: crate::ParaglobError| DatabaseError::Unsupported(e.to_string());
+    for ((start, depth), record) in networks {
+        let (addr, prefix_len) = from_tree_coordinates(start, depth);
+        builder
+            .add_ip(&format!("{}/{}", addr, prefix_len), data_for(record)?)
+            .map_err(to_build_error)?;
+    }
+    for (literal, record) in literals {
+        builder
+            .add_literal(&literal, data_for(record)?)
+            .map_err(to_build_error)?;
+    }
+    for (glob, record) in globs {
+        builder
+            .add_glob(&glob, data_for(record)?)
+            .map_err(to_build_error)?;
+    }
+
+    Ok(builder)
+}
+
+/// Replace or (for a tombstone) remove a string key
+fn apply(map: &mut BTreeMap<String, Record>, key: String, record: Option<Record>) {
+    match record {
+        Some(record) => {
+            map.insert(key, record);
+        }
+        None => {
+            map.remove(&key);
+        }
+    }
+}
+
+/// Remove every address of `start/depth` from `networks`
+///
+/// Networks inside it are dropped; a network containing it is split into
+/// the pieces around it, which keep their data.
+fn carve(networks: &mut NetworkMap, start: u128, depth: u8) {
+    let end = start | host_mask(depth);
+
+    let inside: Vec<(u128, u8)> = networks
+        .range((start, 0)..=(end, u8::MAX))
+        .map(|(key, _)| *key)
+        .collect();
+    for key in inside {
+        networks.remove(&key);
+    }
+
+    // At most one (disjoint) older network can start before and contain it
+    let containing = networks
+        .range(..(start, 0))
+        .next_back()
+        .map(|(key, _)| *key)
+        .filter(|&(outer_start, outer_depth)| outer_start | host_mask(outer_depth) >= start);
+    if let Some((outer_start, outer_depth)) = containing {
+        let record = networks.remove(&(outer_start, outer_depth)).unwrap();
+        // Siblings along the path from the outer network down to the carved one
+        for d in outer_depth + 1..=depth {
+            let sibling = (start ^ (1u128 << (128 - d as u32))) & !host_mask(d);
+            networks.insert((sibling, d), record.clone());
+        }
+    }
+}
+
+/// Mask of the host bits of a network with `depth` prefix bits
+fn host_mask(depth: u8) -> u128 {
+    if depth == 0 {
+        u128::MAX
+    } else {
+        (1u128 << (128 - depth as u32)) - 1
+    }
+}
+
+/// Network as (start, depth) in an IPv6 tree (IPv4 under `::/96`)
+fn tree_coordinates(addr: IpAddr, prefix_len: u8) -> (u128, u8) {
+    match addr {
+        IpAddr::V4(v4) => (
+            u32::from(v4) as u128 & !host_mask(96 + prefix_len),
+            96 + prefix_len,
+        ),
+        IpAddr::V6(v6) => (u128::from(v6) & !host_mask(prefix_len), prefix_len),
+    }
+}
+
+/// Inverse of [`tree_coordinates`]
+fn from_tree_coordinates(start: u128, depth: u8) -> (IpAddr, u8) {
+    if depth >= 96 && start >> 32 == 0 {
+        (IpAddr::V4(Ipv4Addr::from(start as u32)), depth - 96)
+    } else {
+        (IpAddr::V6(Ipv6Addr::from(start)), depth)
+    }
+}
+
+/// Match mode for the merged database (from the first layer with strings)
+fn match_mode_of(layers: &[&Database]) -> MatchMode {
+    layers
+        .iter()
+        .find(|db| db.has_string_data())
+        .map_or(MatchMode::CaseSensitive, |db| db.mode())
+}
+
+/// Entry data as the builder takes it
+fn into_map(value: DataValue) -> Result<HashMap<String, DataValue>, DatabaseError> {
+    match value {
+        DataValue::Map(map) => Ok(map),
+        _ => Err(DatabaseError::Unsupported(
+            "Cannot compact a database whose entry data is not a map".to_string(),
+        )),
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::QueryResult;
+
+    fn data(value: &str) -> HashMap<String, DataValue> {
+        let mut map = HashMap::new();
+        map.insert("v".to_string(), DataValue::String(value.to_string()));
+        map
+    }
+
+    /// The string values of a result, sorted (pattern IDs differ between
+    /// layered and compacted databases)
+    fn values(result: Option<QueryResult>) -> Vec<String> {
+        let mut out: Vec<String> = match result {
+            Some(QueryResult::Ip { data, .. }) => vec![data],
+            Some(QueryResult::Pattern { data, .. }) => data.into_iter().flatten().collect(),
+            _ => Vec::new(),
+        }
+        .into_iter()
+        .filter_map(|value| match value {
+            DataValue::Map(map) => match map.get("v") {
+                Some(DataValue::String(s)) => Some(s.clone()),
+                _ => None,
+            },
+            _ => None,
+        })
+        .collect();
+        out.sort();
+        out
+    }
+
+    fn build_base() -> Database {
+        let mut base = MmdbBuilder::new(MatchMode::CaseSensitive);
+        base.add_entry("10.0.0.0/8", data("base-10/8")).unwrap();
+        base.add_entry("10.1.2.0/24", data("base-10.1.2/24"))
+            .unwrap();
+        base.add_entry("192.168.0.0/16", data("base-192.168/16"))
+            .unwrap();
+        base.add_entry("2001:db8::/32", data("base-v6")).unwrap();
+        base.add_entry("evil.com", data("base-evil")).unwrap();
+        base.add_entry("gone.com", data("base-gone")).unwrap();
+        base.add_entry("*.evil.com", data("base-glob")).unwrap();
+        base.add_entry("*.bad.net", data("base-bad")).unwrap();
+        Database::from_bytes(base.build().unwrap()).unwrap()
+    }
+
+    fn build_delta() -> Database {
+        let mut delta = MmdbBuilder::new(MatchMode::CaseSensitive);
+        delta
+            .add_entry("10.1.0.0/16", data("delta-10.1/16"))
+            .unwrap();
+        delta.add_entry("172.16.0.1", data("delta-host")).unwrap();
+        delta.add_entry("evil.com", data("delta-evil")).unwrap();
+        delta.add_entry("*.bad.net", data("delta-bad")).unwrap();
+        delta.add_tombstone("192.168.5.0/24").unwrap();
+        delta.add_tombstone("gone.com").unwrap();
+        delta.add_tombstone("*.evil.com").unwrap();
+        Database::from_bytes(delta.build().unwrap()).unwrap()
+    }
+
+    const QUERIES: [&str; 14] = [
+        "10.0.0.1",
+        "10.1.2.3",
+        "10.1.9.9",
+        "10.200.0.1",
+        "192.168.1.1",
+        "192.168.5.5",
+        "172.16.0.1",
+        "2001:db8::1",
+        "8.8.8.8",
+        "evil.com",
+        "gone.com",
+        "www.evil.com",
+        "x.bad.net",
+        "nothing.org",
+    ];
+
+    #[test]
+    fn test_overlay_lookups() {
+        let db = build_base().with_overlay(build_delta()).unwrap();
+        assert_eq!(db.overlay_count(), 1);
+
+        let expected: [&[&str]; 14] = [
+            &["base-10/8"],
+            // The delta /16 shadows the base's more specific /24
+            &["delta-10.1/16"],
+            &["delta-10.1/16"],
+            &["base-10/8"],
+            &["base-192.168/16"],
+            &[],
+            &["delta-host"],
+            &["base-v6"],
+            &[],
+            &["delta-evil"],
+            &[],
+            &[],
+            &["delta-bad"],
+            &[],
+        ];
+        for (query, want) in QUERIES.iter().zip(expected) {
+            assert_eq!(values(db.lookup(query).unwrap()), want, "{}", query);
+        }
+
+        let ids = match db.lookup("x.bad.net").unwrap() {
+            Some(QueryResult::Pattern { pattern_ids, .. }) => pattern_ids,
+            other => panic!("unexpected {:?}", other),
+        };
+        assert_eq!(db.get_pattern_string(ids[0]).as_deref(), Some("*.bad.net"));
+        assert!(db.lookup_ref("evil.com").is_err());
+    }
+
+    #[test]
+    fn test_tombstones_hidden_without_base() {
+        let delta = build_delta();
+        assert!(matches!(
+            delta.lookup("gone.com").unwrap(),
+            Some(QueryResult::NotFound)
+        ));
+        assert!(matches!(
+            delta.lookup("192.168.5.1").unwrap(),
+            Some(QueryResult::NotFound)
+        ));
+        assert_eq!(delta.lookup_ref("gone.com").unwrap(), None);
+    }
+
+    #[test]
+    fn test_compact_matches_overlay() {
+        let compacted = compact(&build_base(), &[build_delta()]).unwrap();
+        let compacted = Database::from_bytes(compacted.build().unwrap()).unwrap();
+        let layered = build_base().with_overlay(build_delta()).unwrap();
+
+        for query in QUERIES {
+            assert_eq!(
+                values(compacted.lookup(query).unwrap()),
+                values(layered.lookup(query).unwrap()),
+                "{}",
+                query
+            );
+        }
+        assert_eq!(compacted.overlay_count(), 0);
+    }
+
+    #[test]
+    fn test_carve_splits_containing_network() {
+        let mut networks = NetworkMap::new();
+        let (start, depth) = tree_coordinates("10.0.0.0".parse().unwrap(), 8);
+        networks.insert((start, depth), Record::Value(None));
+
+        let (hole, hole_depth) = tree_coordinates("10.1.0.0".parse().unwrap(), 16);
+        carve(&mut networks, hole, hole_depth);
+
+        // 10.0.0.0/8 minus 10.1.0.0/16 is 8 networks (/9 down to /16)
+        assert_eq!(networks.len(), 8);
+        assert!(networks
+            .keys()
+            .all(|&(s, d)| s | host_mask(d) < hole || s > (hole | host_mask(hole_depth))));
+        let covered: u128 = networks.keys().map(|&(_, d)| host_mask(d) + 1).sum();
+        assert_eq!(
+            covered,
+            (host_mask(depth) + 1) - (host_mask(hole_depth) + 1)
+        );
+    }
+}
@@ -380,7 +380,8 @@ impl Extractor {
     /// Extract patterns from a chunk (multiple lines) in one pass
     ///
     /// This is MUCH faster than processing line-by-line because:
-    /// - One memchr/memmem scan for all anchor patterns (::, @, .)
+    /// - One SIMD classification pass finds every anchor (`.`, `::`, `@`,
+    ///   `0x`, word boundaries) for all enabled extractors at once
     /// - Better cache locality and SIMD efficiency
     /// - Amortized initialization overhead
     ///
@@ -394,32 +395,43 @@ impl Extractor {
     pub fn extract_from_chunk<'a>(&'a self, chunk: &'a [u8]) -> Vec<Match<'a>> {
         let mut matches = Vec::new();
 
-        // Pre-compute word boundaries once if any boundary-dependent extractors are enabled
-        // This eliminates redundant scans across Bitcoin, hash, and Monero extractors
-        let boundaries = if self.extract_hashes || self.extract_bitcoin || self.extract_monero {
-            Some(find_word_boundaries(chunk))
-        } else {
-            None
-        };
-        let boundaries_ref = boundaries.as_deref();
+        // Classify the chunk once and collect only the anchors some enabled
+        // extractor will walk. Hash, Bitcoin and Monero candidates are
+        // tokens, so they share the boundary list.
+        let mut kinds = 0;
+        if self.extract_ipv4 || self.extract_domains {
+            kinds |= ANCHOR_DOTS;
+        }
+        if self.extract_ipv6 {
+            kinds |= ANCHOR_DOUBLE_COLONS;
+        }
+        if self.extract_emails {
+            kinds |= ANCHOR_ATS;
+        }
+        if self.extract_ethereum {
+            kinds |= ANCHOR_HEX_PREFIXES;
+        }
+        if self.extract_hashes || self.extract_bitcoin || self.extract_monero {
+            kinds |= ANCHOR_BOUNDARIES;
+        }
+        let anchors = ChunkAnchors::scan(chunk, kinds);
+        let boundaries_ref = Some(anchors.boundaries.as_slice());
 
-        // Extract IPv6 (::) in one pass over entire chunk
         if self.extract_ipv6 {
-            self.extract_ipv6_chunk(chunk, &mut matches);
+            self.extract_ipv6_at(chunk, anchors.double_colons.iter().copied(), &mut matches);
         }
 
-        // Extract IPv4 (.) in one pass
         if self.extract_ipv4 {
-            self.extract_ipv4_chunk(chunk, &mut matches);
+            self.extract_ipv4_at(chunk, &anchors.dots, &mut matches);
         }
 
-        // Extract emails (@) in one pass
         if self.extract_emails {
-            self.extract_emails_chunk(chunk, &mut matches);
+            self.extract_emails_at(chunk, &anchors.ats, &mut matches);
         }
 
-        // Extract domains from entire chunk in one pass
-        if self.extract_domains {
+        // Domains still need the TLD automaton; the dots only rule out
+        // chunks that cannot contain one
+        if self.extract_domains && !anchors.dots.is_empty() {
             self.extract_domains_chunk(chunk, &mut matches);
         }
 
@@ -434,7 +446,7 @@ impl Extractor {
         }
 
         if self.extract_ethereum {
-            self.extract_ethereum_chunk(chunk, &mut matches);
+            self.extract_ethereum_at(chunk, anchors.hex_prefixes.iter().copied(), &mut matches);
         }
 
         if self.extract_monero {
@@ -995,12 +1007,19 @@ impl Extractor {
     // ===== CHUNK-BASED EXTRACTION METHODS =====
     // These process entire chunks (multiple lines) in one pass for better performance
 
-    /// Extract IPv6 addresses from entire chunk in one pass
-    fn extract_ipv6_chunk<'a>(&'a self, chunk: &'a [u8], matches: &mut Vec<Match<'a>>) {
+    /// Extract IPv6 addresses from entire chunk, given every `::` position
+    ///
+    /// Overlapping positions (from `:::`) are fine: the second one always
+    /// falls before `last_end`.
+    fn extract_ipv6_at<'a>(
+        &'a self,
+        chunk: &'a [u8],
+        double_colons: impl IntoIterator<Item = usize>,
+        matches: &mut Vec<Match<'a>>,
+    ) {
         let mut last_end = 0;
 
-        // Single scan for all :: in the chunk
-        for double_colon_pos in self.double_colon_finder.find_iter(chunk) {
+        for double_colon_pos in double_colons {
             if double_colon_pos < last_end {
                 continue;
             }
@@ -1070,14 +1089,16 @@ impl Extractor {
         }
     }
 
-    /// Extract IPv4 addresses from entire chunk in one pass
-    fn extract_ipv4_chunk<'a>(&'a self, chunk: &'a [u8], matches: &mut Vec<Match<'a>>) {
-        use memchr::memchr_iter;
-
+    /// Extract IPv4 addresses from entire chunk, given every `.` position
+    fn extract_ipv4_at<'a>(
+        &'a self,
+        chunk: &'a [u8],
+        dots: &[usize],
+        matches: &mut Vec<Match<'a>>,
+    ) {
         let mut last_end = 0;
 
-        // Single scan for all dots in the chunk
-        for dot_pos in memchr_iter(b'.', chunk) {
+        for (index, &dot_pos) in dots.iter().enumerate() {
             if dot_pos == 0 || dot_pos + 6 > chunk.len() {
                 continue;
             }
@@ -1087,11 +1108,19 @@ impl Extractor {
                 continue;
             }
 
-            // Count dots in window
+            // Count dots in window [dot_pos - 3, dot_pos + 12) from the sorted list
             let window_start = dot_pos.saturating_sub(3);
             let window_end = (dot_pos + 12).min(chunk.len());
-            let window = &chunk[window_start..window_end];
-            let dot_count = memchr_iter(b'.', window).count();
+            let before = dots[..index]
+                .iter()
+                .rev()
+                .take_while(|&&pos| pos >= window_start)
+                .count();
+            let after = dots[index..]
+                .iter()
+                .take_while(|&&pos| pos < window_end)
+                .count();
+            let dot_count = before + after;
 
             if dot_count < 3 {
                 continue;
@@ -1118,12 +1147,14 @@ impl Extractor {
         }
     }
 
-    /// Extract emails from entire chunk in one pass
-    fn extract_emails_chunk<'a>(&'a self, chunk: &'a [u8], matches: &mut Vec<Match<'a>>) {
-        use memchr::memchr_iter;
-
-        // Single scan for all @ in the chunk
-        for at_pos in memchr_iter(b'@', chunk) {
+    /// Extract emails from entire chunk, given every `@` position
+    fn extract_emails_at<'a>(
+        &'a self,
+        chunk: &'a [u8],
+        ats: &[usize],
+        matches: &mut Vec<Match<'a>>,
+    ) {
+        for &at_pos in ats {
             if let Some(email_span) = self.extract_email_at(chunk, at_pos) {
                 if let Ok(email_str) = std::str::from_utf8(&chunk[email_span.0..email_span.1]) {
                     matches.push(Match {
@@ -1267,7 +1298,17 @@ impl Extractor {
     /// Format: 0x followed by 40 hex characters
     fn extract_ethereum_chunk<'a>(&'a self, chunk: &'a [u8], matches: &mut Vec<Match<'a>>) {
         // Use pre-built finder for "0x" - much faster than searching for '0' then checking 'x'
-        for start in self.ox_finder.find_iter(chunk) {
+        self.extract_ethereum_at(chunk, self.ox_finder.find_iter(chunk), matches);
+    }
+
+    /// Extract Ethereum addresses, given every `0x` position
+    fn extract_ethereum_at<'a>(
+        &'a self,
+        chunk: &'a [u8],
+        hex_prefixes: impl IntoIterator<Item = usize>,
+        matches: &mut Vec<Match<'a>>,
+    ) {
+        for start in hex_prefixes {
             if start + 42 > chunk.len() {
                 continue;
             }
@@ -1635,12 +1676,130 @@ fn is_all_hex_simd(bytes: &[u8]) -> bool {
     bytes.iter().all(|&b| is_hex_char_fast(b))
 }
 
+/// Which anchor kinds [`ChunkAnchors::scan`] collects
+const ANCHOR_DOTS: u8 = 1 << 0;
+const ANCHOR_DOUBLE_COLONS: u8 = 1 << 1;
+const ANCHOR_ATS: u8 = 1 << 2;
+const ANCHOR_HEX_PREFIXES: u8 = 1 << 3;
+const ANCHOR_BOUNDARIES: u8 = 1 << 4;
+
+/// Candidate positions for every extractor, found in one classified pass
+///
+/// `simd_utils::scan_anchors` yields per-64-byte bitmaps; this turns them
+/// into the sorted position lists the validators walk. Kinds that were not
+/// requested stay empty.
+#[derive(Default)]
+struct ChunkAnchors {
+    /// Every `.`
+    dots: Vec<usize>,
+    /// Every `::`, not overlapping: `:::` yields one
+    double_colons: Vec<usize>,
+    /// Every `@`
+    ats: Vec<usize>,
+    /// Every `0x`
+    hex_prefixes: Vec<usize>,
+    /// Alternating token start/end positions, as from [`find_word_boundaries`]
+    boundaries: Vec<usize>,
+}
+
+impl ChunkAnchors {
+    fn scan(chunk: &[u8], kinds: u8) -> Self {
+        #[inline(always)]
+        fn push_bits(positions: &mut Vec<usize>, base: usize, mut bits: u64) {
+            while bits != 0 {
+                positions.push(base + bits.trailing_zeros() as usize);
+                bits &= bits - 1;
+            }
+        }
+
+        let mut anchors = Self::default();
+        if kinds == 0 {
+            return anchors;
+        }
+
+        // Cross-block state: ':' in the previous block's last byte, and
+        // whether the previous block ended inside a token
+        let mut colon_carry = false;
+        let mut in_token = false;
+
+        crate::simd_utils::scan_anchors(chunk, |base, masks| {
+            let len = (chunk.len() - base).min(64);
+
+            if kinds & ANCHOR_DOTS != 0 {
+                push_bits(&mut anchors.dots, base, masks.dot);
+            }
+
+            if kinds & ANCHOR_DOUBLE_COLONS != 0 {
+                // A `::` starting inside the previous hit is part of a
+                // longer run and is skipped, as `memmem::find_iter` would
+                let positions = &mut anchors.double_colons;
+                let mut push = |pos: usize| {
+                    if positions.last().is_none_or(|&last| pos > last + 1) {
+                        positions.push(pos);
+                    }
+                };
+                if colon_carry && masks.colon & 1 != 0 {
+                    push(base - 1);
+                }
+                let mut bits = masks.colon & (masks.colon >> 1);
+                while bits != 0 {
+                    push(base + bits.trailing_zeros() as usize);
+                    bits &= bits - 1;
+                }
+                colon_carry = masks.colon >> 63 != 0;
+            }
+
+            if kinds & ANCHOR_ATS != 0 {
+                push_bits(&mut anchors.ats, base, masks.at);
+            }
+
+            if kinds & ANCHOR_HEX_PREFIXES != 0 {
+                // 'x' is rare enough that checking the byte before is cheaper
+                // than classifying '0' too
+                let mut bits = masks.x;
+                while bits != 0 {
+                    let pos = base + bits.trailing_zeros() as usize;
+                    if pos > 0 && chunk[pos - 1] == b'0' {
+                        anchors.hex_prefixes.push(pos - 1);
+                    }
+                    bits &= bits - 1;
+                }
+            }
+
+            if kinds & ANCHOR_BOUNDARIES != 0 {
+                let valid = if len == 64 {
+                    u64::MAX
+                } else {
+                    (1u64 << len) - 1
+                };
+                let token = !masks.boundary & valid;
+                let previous = (token << 1) | in_token as u64;
+                let starts = token & !previous;
+                let ends = !token & previous & valid;
+                push_bits(&mut anchors.boundaries, base, starts | ends);
+                in_token = (token >> (len - 1)) & 1 != 0;
+            }
+        });
+
+        if in_token {
+            anchors.boundaries.push(chunk.len());
+        }
+        anchors
+    }
+}
+
 /// Find all word boundary positions in chunk
 /// Returns sorted vec of positions where tokens start/end
 /// A token is a sequence of non-boundary characters
 ///
 /// Public for use by processing infrastructure to pre-compute boundaries
 pub(crate) fn find_word_boundaries(chunk: &[u8]) -> Vec<usize> {
+    ChunkAnchors::scan(chunk, ANCHOR_BOUNDARIES).boundaries
+}
+
+/// Byte-at-a-time reference for [`find_word_boundaries`]
+#[cfg(test)]
+fn find_word_boundaries_scalar(chunk: &[u8]) -> Vec<usize> {
     let mut boundaries = Vec::new();
 
     if chunk.is_empty() {
@@ -3014,6 +3173,74 @@ mod tests {
         assert_eq!(hashes[0].0, "5d41402abc4b2a76b9719d911017c592");
     }
 
+    #[test]
+    fn test_boundary_classes_match_lookup() {
+        for byte in 0..=255u8 {
+            assert_eq!(
+                crate::simd_utils::is_anchor_boundary(byte),
+                is_boundary_fast(byte),
+                "byte {:#x}",
+                byte
+            );
+        }
+    }
+
+    #[test]
+    fn test_word_boundaries_match_scalar() {
+        let text = b"GET /index.html?id=5d41402abc4b2a76b9719d911017c592 HTTP/1.1\r\n\
+                     Host: evil.example.com\t(from 192.168.1.10) [user@example.org]\n\
+                     {\"addr\":\"0x\",\"v6\":\"2001:db8:::1\"}";
+        for start in 0..70 {
+            for end in [
+                start,
+                start + 1,
+                start + 63,
+                start + 64,
+                start + 65,
+                text.len(),
+            ] {
+                let slice = &text[start..end.min(text.len())];
+                assert_eq!(
+                    find_word_boundaries(slice),
+                    find_word_boundaries_scalar(slice)
+                );
+            }
+        }
+    }
+
+    #[test]
+    fn test_chunk_anchors_match_memchr() {
+        // Anchors straddle 64-byte blocks at different offsets on each line
+        let chunk = b"src=192.168.1.10 dst=10.0.0.1 via 2001:db8::8a2e:370:7334\n\
+                      padding padding padding padding padding.. user@example.com\n\
+                      xx 2001:db8:85a3:::7334 and 2001:0db8:85a3::8a2e:0370:7334:\n\
+                      :0x5aAeb6053F3E94C9b9A09f33669435E7Ef1BeAed 0x0x 00x x0 @@";
+        let anchors = ChunkAnchors::scan(chunk, 0xFF);
+
+        let dots: Vec<usize> = memchr::memchr_iter(b'.', chunk).collect();
+        let ats: Vec<usize> = memchr::memchr_iter(b'@', chunk).collect();
+        let hex_prefixes: Vec<usize> = memchr::memmem::find_iter(chunk, b"0x").collect();
+        let double_colons: Vec<usize> = memchr::memmem::find_iter(chunk, b"::").collect();
+
+        assert_eq!(anchors.dots, dots);
+        assert_eq!(anchors.ats, ats);
+        assert_eq!(anchors.hex_prefixes, hex_prefixes);
+        assert_eq!(anchors.double_colons, double_colons);
+        assert_eq!(anchors.boundaries, find_word_boundaries_scalar(chunk));
+        assert!(ChunkAnchors::scan(chunk, ANCHOR_ATS).dots.is_empty());
+
+        // Runs of colons, including one across the first block boundary
+        let mut colons = b"a:::b::::c".to_vec();
+        colons.resize(63, b'x');
+        colons.extend_from_slice(b":::x");
+        let anchors = ChunkAnchors::scan(&colons, ANCHOR_DOUBLE_COLONS);
+        assert_eq!(anchors.double_colons, vec![1, 5, 7, 63]);
+        assert_eq!(
+            anchors.double_colons,
+            memchr::memmem::find_iter(&colons, b"::").collect::<Vec<_>>()
+        );
+    }
+
     #[test]
     fn test_hash_chunk_extraction() {
         let extractor = Extractor::new().unwrap();
@@ -33,15 +33,39 @@
 //! # Ok(())
 //! # }
 //! ```
+//!
+//! # Gzip Decompression
+//!
+//! Gzip input is decompressed on a background thread that runs ahead of
+//! the consumer, handing over filled buffers from a small bounded ring.
+//! Files written as BGZF (`bgzip`, or any gzip made of independent blocks
+//! that record their size) go further: each batch of blocks is inflated
+//! in parallel on the rayon pool. Concatenated multi-member gzip files
+//! are read to the end, including BGZF followed by ordinary gzip members.
+//! Pipes work too, since detection never seeks. Build with the `zlib-ng`
+//! feature for a faster inflate backend.
 
-use flate2::read::GzDecoder;
+use flate2::read::MultiGzDecoder;
+use flate2::{Crc, Decompress, FlushDecompress, Status};
+use rayon::prelude::*;
 use std::fs::File;
-use std::io::{self, stdin, BufRead, BufReader};
+use std::io::{self, stdin, BufRead, BufReader, Read, Seek, SeekFrom};
 use std::path::Path;
+use std::sync::mpsc::{sync_channel, Receiver, SyncSender};
+use std::thread;
 
 /// Buffer size for file reading (128KB, matches CLI default)
 const BUFFER_SIZE: usize = 128 * 1024;
 
+/// Size of each decompressed buffer in the read-ahead ring (1MB)
+const RING_BUFFER_SIZE: usize = 1024 * 1024;
+
+/// Filled buffers allowed to queue ahead of the consumer
+const RING_DEPTH: usize = 4;
+
+/// BGZF blocks inflated together per parallel batch (at most 64KB each)
+const BGZF_BATCH_BLOCKS: usize = 64;
+
 /// Open a file with automatic gzip detection based on file extension
 ///
 /// Files ending in `.gz` (case-insensitive) are automatically decompressed.
@@ -80,23 +104,50 @@ pub fn open<P: AsRef<Path>>(path: P) -> io::Result<Box<dyn BufRead + Send>> {
 
     let file = File::open(path)?;
 
-    // Check if file is gzip-compressed based on extension
-    let is_gzip = path
-        .extension()
-        .and_then(|ext| ext.to_str())
-        .map(|ext| ext.eq_ignore_ascii_case("gz"))
-        .unwrap_or(false);
-
-    if is_gzip {
-        // Gzip-compressed: wrap in decoder then buffer
-        let decoder = GzDecoder::new(file);
-        Ok(Box::new(BufReader::with_capacity(BUFFER_SIZE, decoder)))
+    if is_gzip_path(path) {
+        // Gzip-compressed: decompress ahead on another thread
+        Ok(Box::new(GzReadAhead::new(file)))
     } else {
         // Plain text: just buffer
         Ok(Box::new(BufReader::with_capacity(BUFFER_SIZE, file)))
     }
 }
 
+/// Whether `open` decompresses this path (`.gz` extension, case-insensitive)
+pub fn is_gzip_path(path: &Path) -> bool {
+    path.extension()
+        .and_then(|ext| ext.to_str())
+        .map(|ext| ext.eq_ignore_ascii_case("gz"))
+        .unwrap_or(false)
+}
+
+/// Open the bytes `start..end` of an uncompressed file
+///
+/// Each call opens its own handle, so many threads can read different
+/// ranges of one file at once without sharing a file position.
+///
+/// # Example
+///
+/// ```rust,no_run
+/// use matchy::file_reader;
+///
+/// // Second megabyte of a large log
+/// let reader = file_reader::open_range("huge.log", 1 << 20, 2 << 20)?;
+/// # Ok::<(), std::io::Error>(())
+/// ```
+pub fn open_range<P: AsRef<Path>>(
+    path: P,
+    start: u64,
+    end: u64,
+) -> io::Result<Box<dyn BufRead + Send>> {
+    let mut file = File::open(path)?;
+    file.seek(SeekFrom::Start(start))?;
+    Ok(Box::new(BufReader::with_capacity(
+        BUFFER_SIZE,
+        file.take(end.saturating_sub(start)),
+    )))
+}
+
 /// Create a reader from an already-opened file with explicit gzip flag
 ///
 /// Useful when you need to override extension-based detection or already
@@ -115,13 +166,347 @@ pub fn open<P: AsRef<Path>>(path: P) -> io::Result<Box<dyn BufRead + Send>> {
 /// ```
 pub fn from_file(file: File, is_gzip: bool) -> Box<dyn BufRead + Send> {
     if is_gzip {
-        let decoder = GzDecoder::new(file);
-        Box::new(BufReader::with_capacity(BUFFER_SIZE, decoder))
+        Box::new(GzReadAhead::new(file))
     } else {
         Box::new(BufReader::with_capacity(BUFFER_SIZE, file))
     }
 }
 
+/// Gzip reader whose decompression runs ahead on other threads
+///
+/// A producer thread fills buffers and sends them over a bounded channel;
+/// the reader hands each consumed buffer back for reuse, so at most a few
+/// megabytes are in flight no matter how large the file is. BGZF input is
+/// inflated a batch of blocks at a time across the rayon pool, anything
+/// else is decoded sequentially (including multi-member files).
+///
+/// Returned by [`open`] and [`from_file`] for gzip input.
+pub struct GzReadAhead {
+    filled: Receiver<io::Result<Vec<u8>>>,
+    recycle: SyncSender<Vec<u8>>,
+    current: Vec<u8>,
+    pos: usize,
+    done: bool,
+}
+
+impl GzReadAhead {
+    /// Start decompressing `file` in the background
+    pub fn new(file: File) -> Self {
+        let (filled_tx, filled) = sync_channel(RING_DEPTH);
+        let (recycle, recycle_rx) = sync_channel(RING_DEPTH + 2);
+
+        thread::spawn(move || {
+            let mut producer = Producer {
+                filled: filled_tx,
+                recycle: recycle_rx,
+            };
+            let result = match detect_bgzf(file) {
+                Ok((input, true)) => producer.run_bgzf(input),
+                Ok((input, false)) => producer.run_sequential(input),
+                Err(e) => Err(e),
+            };
+            if let Err(e) = result {
+                // The consumer may already be gone; nothing else to do
+                let _ = producer.filled.send(Err(e));
+            }
+        });
+
+        Self {
+            filled,
+            recycle,
+            current: Vec::new(),
+            pos: 0,
+            done: false,
+        }
+    }
+}
+
+impl BufRead for GzReadAhead {
+    fn fill_buf(&mut self) -> io::Result<&[u8]> {
+        while self.pos >= self.current.len() && !self.done {
+            match self.filled.recv() {
+                Ok(Ok(buf)) => {
+                    let used = std::mem::replace(&mut self.current, buf);
+                    self.pos = 0;
+                    if used.capacity() > 0 {
+                        let _ = self.recycle.try_send(used);
+                    }
+                }
+                Ok(Err(e)) => {
+                    self.done = true;
+                    return Err(e);
+                }
+                // Producer finished and dropped its sender
+                Err(_) => self.done = true,
+            }
+        }
+        let pos = self.pos.min(self.current.len());
+        Ok(&self.current[pos..])
+    }
+
+    fn consume(&mut self, amt: usize) {
+        self.pos = (self.pos + amt).min(self.current.len());
+    }
+}
+
+impl Read for GzReadAhead {
+    fn read(&mut self, out: &mut [u8]) -> io::Result<usize> {
+        let n = {
+            let available = self.fill_buf()?;
+            let n = available.len().min(out.len());
+            out[..n].copy_from_slice(&available[..n]);
+            n
+        };
+        self.consume(n);
+        Ok(n)
+    }
+}
+
+/// Background half of [`GzReadAhead`]
+struct Producer {
+    filled: SyncSender<io::Result<Vec<u8>>>,
+    recycle: Receiver<Vec<u8>>,
+}
+
+impl Producer {
+    /// Take a recycled buffer, or allocate while the ring is filling up
+    fn buffer(&self) -> Vec<u8> {
+        self.recycle
+            .try_recv()
+            .unwrap_or_else(|_| Vec::with_capacity(RING_BUFFER_SIZE))
+    }
+
+    /// Hand a buffer to the consumer; false once the consumer has gone
+    fn send(&self, buf: Vec<u8>) -> bool {
+        self.filled.send(Ok(buf)).is_ok()
+    }
+
+    /// Decode any gzip stream (single or multi-member) on this thread
+    fn run_sequential<R: Read>(&mut self, input: R) -> io::Result<()> {
+        let mut decoder = MultiGzDecoder::new(BufReader::with_capacity(BUFFER_SIZE, input));
+        loop {
+            let mut buf = self.buffer();
+            // Recycled buffers come back full, so this rarely zero-fills
+            buf.resize(RING_BUFFER_SIZE, 0);
+            let mut len = 0;
+            while len < buf.len() {
+                match decoder.read(&mut buf[len..]) {
+                    Ok(0) => break,
+                    Ok(n) => len += n,
+                    Err(e) if e.kind() == io::ErrorKind::Interrupted => {}
+                    Err(e) => {
+                        buf.truncate(len);
+                        if len > 0 && !self.send(buf) {
+                            return Ok(());
+                        }
+                        return Err(e);
+                    }
+                }
+            }
+            buf.truncate(len);
+            if len == 0 || !self.send(buf) {
+                return Ok(());
+            }
+        }
+    }
+
+    /// Inflate BGZF blocks in parallel batches, preserving order
+    ///
+    /// A gzip member that is not a BGZF block (e.g. from `cat a.bgz b.gz`)
+    /// hands it and the rest of the file to the sequential decoder.
+    fn run_bgzf<R: Read>(&mut self, input: R) -> io::Result<()> {
+        let mut input = BufReader::with_capacity(BUFFER_SIZE, input);
+        let mut compressed = Vec::new();
+        let mut blocks = Vec::with_capacity(BGZF_BATCH_BLOCKS);
+        loop {
+            compressed.clear();
+            blocks.clear();
+            let mut plain = None;
+            while blocks.len() < BGZF_BATCH_BLOCKS {
+                match read_bgzf_block(&mut input, &mut compressed)? {
+                    BgzfMember::Block(block) => blocks.push(block),
+                    BgzfMember::Plain(consumed) => {
+                        plain = Some(consumed);
+                        break;
+                    }
+                    BgzfMember::End => break,
+                }
+            }
+
+            if !blocks.is_empty() && !self.send_batch(&compressed, &blocks)? {
+                return Ok(());
+            }
+            if let Some(consumed) = plain {
+                return self.run_sequential(io::Cursor::new(consumed).chain(input));
+            }
+            if blocks.is_empty() {
+                return Ok(());
+            }
+        }
+    }
+
+    /// Inflate a batch of blocks in parallel and hand over the output
+    ///
+    /// Returns false once the consumer has gone.
+    fn send_batch(&self, compressed: &[u8], blocks: &[BgzfBlock]) -> io::Result<bool> {
+        // ISIZE footers give every block its place in the output
+        let total: usize = blocks.iter().map(|b| b.output_len).sum();
+        let mut buf = self.buffer();
+        buf.resize(total, 0);
+        let mut slices = Vec::with_capacity(blocks.len());
+        let mut rest = &mut buf[..];
+        for block in blocks {
+            let (head, tail) = rest.split_at_mut(block.output_len);
+            slices.push(head);
+            rest = tail;
+        }
+        blocks
+            .par_iter()
+            .zip(slices.into_par_iter())
+            .try_for_each(|(block, out)| {
+                inflate_block(&compressed[block.start..block.end], out, block.crc)
+            })?;
+
+        Ok(self.send(buf))
+    }
+}
+
+/// Next gzip member of a BGZF file
+enum BgzfMember {
+    /// A BGZF block, its deflate data appended to the batch buffer
+    Block(BgzfBlock),
+    /// An ordinary gzip member; holds the bytes of it already consumed
+    Plain(Vec<u8>),
+    /// Clean end of file
+    End,
+}
+
+/// One BGZF block: deflate data in the batch buffer plus its footer
+struct BgzfBlock {
+    start: usize,
+    end: usize,
+    crc: u32,
+    output_len: usize,
+}
+
+/// Fixed gzip header bytes before the FEXTRA payload
+const GZIP_HEADER_LEN: usize = 12;
+
+/// Gzip FLG value BGZF requires: FEXTRA only
+const BGZF_FLAGS: u8 = 0x04;
+
+fn invalid(msg: &str) -> io::Error {
+    io::Error::new(io::ErrorKind::InvalidData, msg.to_string())
+}
+
+/// The start of a file read by [`detect_bgzf`], then the rest of it
+type Sniffed = io::Chain<io::Cursor<Vec<u8>>, File>;
+
+/// Check whether a file starts with a BGZF block
+///
+/// The bytes read to decide are chained back in front of the file rather
+/// than rewound, so pipes and FIFOs work as well as regular files.
+fn detect_bgzf(mut file: File) -> io::Result<(Sniffed, bool)> {
+    let mut header = [0u8; GZIP_HEADER_LEN + 64];
+    let mut len = 0;
+    while len < header.len() {
+        match file.read(&mut header[len..]) {
+            Ok(0) => break,
+            Ok(n) => len += n,
+            Err(e) if e.kind() == io::ErrorKind::Interrupted => {}
+            Err(e) => return Err(e),
+        }
+    }
+    let is_bgzf = len >= GZIP_HEADER_LEN && header[..4] == [0x1f, 0x8b, 0x08, BGZF_FLAGS] && {
+        let xlen = u16::from_le_bytes([header[10], header[11]]) as usize;
+        let extra_end = (GZIP_HEADER_LEN + xlen).min(len);
+        bgzf_block_size(&header[GZIP_HEADER_LEN..extra_end]).is_some()
+    };
+    Ok((io::Cursor::new(header[..len].to_vec()).chain(file), is_bgzf))
+}
+
+/// Find the BGZF `BC` subfield and return the total block size
+fn bgzf_block_size(mut extra: &[u8]) -> Option<usize> {
+    while extra.len() >= 4 {
+        let sublen = u16::from_le_bytes([extra[2], extra[3]]) as usize;
+        let payload = extra.get(4..4 + sublen)?;
+        if extra[..2] == *b"BC" && sublen == 2 {
+            return Some(u16::from_le_bytes([payload[0], payload[1]]) as usize + 1);
+        }
+        extra = &extra[4 + sublen..];
+    }
+    None
+}
+
+/// Append the next block's deflate data and footer to `compressed`
+///
+/// Stops at the header of a member that is not a BGZF block, returning the
+/// bytes read from it so it can still be decoded.
+fn read_bgzf_block<R: Read>(input: &mut R, compressed: &mut Vec<u8>) -> io::Result<BgzfMember> {
+    let mut header = [0u8; GZIP_HEADER_LEN];
+    loop {
+        match input.read(&mut header[..1]) {
+            Ok(0) => return Ok(BgzfMember::End),
+            Ok(_) => break,
+            Err(e) if e.kind() == io::ErrorKind::Interrupted => {}
+            Err(e) => return Err(e),
+        }
+    }
+    input.read_exact(&mut header[1..])?;
+    if header[..4] != [0x1f, 0x8b, 0x08, BGZF_FLAGS] {
+        return Ok(BgzfMember::Plain(header.to_vec()));
+    }
+
+    let xlen = u16::from_le_bytes([header[10], header[11]]) as usize;
+    let mut extra = vec![0u8; xlen];
+    input.read_exact(&mut extra)?;
+    let Some(block_size) = bgzf_block_size(&extra) else {
+        // Extra fields, but no BGZF size among them
+        let mut consumed = header.to_vec();
+        consumed.extend_from_slice(&extra);
+        return Ok(BgzfMember::Plain(consumed));
+    };
+    let body_len = block_size
+        .checked_sub(GZIP_HEADER_LEN + xlen + 8)
+        .ok_or_else(|| invalid("BGZF block size too small"))?;
+
+    let start = compressed.len();
+    compressed.resize(start + body_len + 8, 0);
+    input.read_exact(&mut compressed[start..])?;
+    let end = start + body_len;
+    let footer = &compressed[end..];
+    let crc = u32::from_le_bytes([footer[0], footer[1], footer[2], footer[3]]);
+    let output_len = u32::from_le_bytes([footer[4], footer[5], footer[6], footer[7]]) as usize;
+    if output_len > 1 << 16 {
+        return Err(invalid("BGZF block larger than 64KB"));
+    }
+
+    Ok(BgzfMember::Block(BgzfBlock {
+        start,
+        end,
+        crc,
+        output_len,
+    }))
+}
+
+/// Inflate one raw deflate block into exactly `out` and verify its CRC
+fn inflate_block(data: &[u8], out: &mut [u8], expected_crc: u32) -> io::Result<()> {
+    // An empty block (such as the BGZF end-of-file marker) has nothing to inflate
+    if !out.is_empty() {
+        let mut inflater = Decompress::new(false);
+        match inflater.decompress(data, out, FlushDecompress::Finish) {
+            Ok(Status::StreamEnd) if inflater.total_out() as usize == out.len() => {}
+            _ => return Err(invalid("corrupt BGZF block")),
+        }
+    }
+    let mut crc = Crc::new();
+    crc.update(out);
+    if crc.sum() != expected_crc {
+        return Err(invalid("BGZF block CRC mismatch"));
+    }
+    Ok(())
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -204,4 +589,143 @@ mod tests {
 
         assert_eq!(lines, vec!["upper case gz"]);
     }
+
+    #[test]
+    fn test_multi_member_gzip() {
+        // Concatenated members, as written by `cat a.gz b.gz` or pigz
+        let mut file = NamedTempFile::with_suffix(".gz").unwrap();
+        for member in ["first member", "second member"] {
+            let mut encoder = GzEncoder::new(Vec::new(), Compression::default());
+            writeln!(encoder, "{}", member).unwrap();
+            file.write_all(&encoder.finish().unwrap()).unwrap();
+        }
+        file.flush().unwrap();
+
+        let reader = open(file.path()).unwrap();
+        let lines: Vec<String> = reader.lines().collect::<io::Result<Vec<_>>>().unwrap();
+
+        assert_eq!(lines, vec!["first member", "second member"]);
+    }
+
+    /// Write `data` as BGZF: blocks of at most `block_len` bytes plus the EOF marker
+    fn write_bgzf(data: &[u8], block_len: usize) -> Vec<u8> {
+        use flate2::write::DeflateEncoder;
+
+        let mut out = Vec::new();
+        let mut write_block = |chunk: &[u8]| {
+            let mut encoder = DeflateEncoder::new(Vec::new(), Compression::default());
+            encoder.write_all(chunk).unwrap();
+            let deflated = encoder.finish().unwrap();
+            let mut crc = Crc::new();
+            crc.update(chunk);
+
+            let block_size = (18 + deflated.len() + 8 - 1) as u16;
+            out.extend_from_slice(&[0x1f, 0x8b, 0x08, 0x04, 0, 0, 0, 0, 0, 0xff]);
+            out.extend_from_slice(&6u16.to_le_bytes());
+            out.extend_from_slice(b"BC");
+            out.extend_from_slice(&2u16.to_le_bytes());
+            out.extend_from_slice(&block_size.to_le_bytes());
+            out.extend_from_slice(&deflated);
+            out.extend_from_slice(&crc.sum().to_le_bytes());
+            out.extend_from_slice(&(chunk.len() as u32).to_le_bytes());
+        };
+        for chunk in data.chunks(block_len) {
+            write_block(chunk);
+        }
+        write_block(&[]);
+        out
+    }
+
+    #[test]
+    fn test_bgzf_parallel_blocks() {
+        // Enough blocks to span several parallel batches
+        let text: String = (0..20_000).map(|i| format!("line {}\n", i)).collect();
+        let mut file = NamedTempFile::with_suffix(".gz").unwrap();
+        file.write_all(&write_bgzf(text.as_bytes(), 1000)).unwrap();
+        file.flush().unwrap();
+
+        let mut decoded = String::new();
+        open(file.path())
+            .unwrap()
+            .read_to_string(&mut decoded)
+            .unwrap();
+        assert_eq!(decoded, text);
+
+        // BGZF is still ordinary gzip to a sequential decoder
+        let mut sequential = String::new();
+        MultiGzDecoder::new(File::open(file.path()).unwrap())
+            .read_to_string(&mut sequential)
+            .unwrap();
+        assert_eq!(sequential, text);
+    }
+
+    #[test]
+    fn test_bgzf_then_plain_members() {
+        // `cat a.bgz b.gz`: the trailing ordinary member is decoded sequentially
+        let text: String = (0..5_000).map(|i| format!("line {}\n", i)).collect();
+        let mut data = write_bgzf(text.as_bytes(), 1000);
+        let mut encoder = GzEncoder::new(Vec::new(), Compression::default());
+        writeln!(encoder, "plain member").unwrap();
+        data.extend_from_slice(&encoder.finish().unwrap());
+        data.extend_from_slice(&write_bgzf(b"bgzf again\n", 1000));
+
+        let mut file = NamedTempFile::with_suffix(".gz").unwrap();
+        file.write_all(&data).unwrap();
+        file.flush().unwrap();
+
+        let mut decoded = String::new();
+        open(file.path())
+            .unwrap()
+            .read_to_string(&mut decoded)
+            .unwrap();
+        assert_eq!(decoded, format!("{}plain member\nbgzf again\n", text));
+    }
+
+    #[cfg(unix)]
+    #[test]
+    fn test_gzip_from_pipe() {
+        use std::os::fd::OwnedFd;
+        use std::process::{Command, Stdio};
+
+        // Neither kind of gzip may need to seek to sniff the format
+        let text: String = (0..5_000).map(|i| format!("line {}\n", i)).collect();
+        let mut encoder = GzEncoder::new(Vec::new(), Compression::default());
+        encoder.write_all(text.as_bytes()).unwrap();
+        for data in [write_bgzf(text.as_bytes(), 1000), encoder.finish().unwrap()] {
+            let mut file = NamedTempFile::new().unwrap();
+            file.write_all(&data).unwrap();
+            file.flush().unwrap();
+
+            let mut child = Command::new("cat")
+                .arg(file.path())
+                .stdout(Stdio::piped())
+                .spawn()
+                .unwrap();
+            let pipe = File::from(OwnedFd::from(child.stdout.take().unwrap()));
+
+            let mut decoded = String::new();
+            from_file(pipe, true).read_to_string(&mut decoded).unwrap();
+            child.wait().unwrap();
+            assert_eq!(decoded, text);
+        }
+    }
+
+    #[test]
+    fn test_bgzf_crc_mismatch() {
+        let mut data = write_bgzf(b"checked by crc\n", 1000);
+        // Flip a bit in the first block's CRC footer
+        let first_block = u16::from_le_bytes([data[16], data[17]]) as usize + 1;
+        data[first_block - 8] ^= 1;
+
+        let mut file = NamedTempFile::with_suffix(".gz").unwrap();
+        file.write_all(&data).unwrap();
+        file.flush().unwrap();
+
+        let mut decoded = Vec::new();
+        let err = open(file.path())
+            .unwrap()
+            .read_to_end(&mut decoded)
+            .unwrap_err();
+        assert_eq!(err.kind(), io::ErrorKind::InvalidData);
+    }
 }
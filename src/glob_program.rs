@@ -0,0 +1,540 @@
+//! Compiled glob verification programs
+//!
+//! After the Aho-Corasick scan, every candidate glob has to be checked
+//! against the whole query. [`GlobPattern::matches`] does that by
+//! re-walking parsed segments with backtracking over `*`. This module
+//! compiles each glob at build time into a small byte program, stored in
+//! the paraglob section, that is run straight from the buffer without
+//! parsing or allocating.
+//!
+//! A program is the pattern split at its `*`s into chunks. Every chunk
+//! matches a fixed number of characters, so:
+//!
+//! - the first chunk must match at the start of the text,
+//! - the last chunk must match at the end (found by stepping back its
+//!   character count), and
+//! - each middle chunk is taken at its leftmost occurrence between the two,
+//!   located with `memmem` when it starts with a literal.
+//!
+//! Taking the leftmost occurrence is always safe because a later one can
+//! only leave less text for the chunks after it, so matching never
+//! backtracks and is linear in the text for each chunk.
+//!
+//! # Format
+//!
+//! ```text
+//! [Section header]
+//!   magic: [u8; 4]          // "GLBP"
+//!   version: u32            // 1
+//!   pattern_count: u32
+//!   offsets: [u32; pattern_count]   // program offset in the section, 0 = none
+//!
+//! [Program]
+//!   chunk_count: u32
+//!   last_chunk: u32         // offset of the last chunk in the program
+//!   chunks: [Chunk; chunk_count]
+//!
+//! [Chunk]
+//!   char_count: u32         // characters the chunk consumes
+//!   atoms_size: u32
+//!   atoms: [u8; atoms_size]
+//!
+//! [Atom]
+//!   0x01 literal: len: u32, bytes  // ASCII-lowercased in case-insensitive mode
+//!   0x02 any char (`?`)
+//!   0x03 class: negated: u8, ascii: [u8; 16], range_count: u32,
+//!        ranges: [(lo: u32, hi: u32); range_count]  // non-ASCII members
+//! ```
+//!
+//! All integers are little-endian and nothing is aligned, so programs are
+//! read byte-wise from the mapped file.
+
+use crate::glob::{CharClassItem, GlobPattern, GlobSegment, MatchMode};
+
+/// Magic bytes for the glob program section
+const MAGIC: &[u8; 4] = b"GLBP";
+
+/// Format version of the glob program section
+const FORMAT_VERSION: u32 = 1;
+
+/// Section header size before the offset table
+const HEADER_SIZE: usize = 12;
+
+const ATOM_LITERAL: u8 = 0x01;
+const ATOM_ANY: u8 = 0x02;
+const ATOM_CLASS: u8 = 0x03;
+
+/// Serializes compiled programs for a paraglob section
+pub struct GlobProgramBuilder {
+    offsets: Vec<u32>,
+    programs: Vec<u8>,
+}
+
+impl GlobProgramBuilder {
+    /// Create a builder for `pattern_count` pattern IDs
+    pub fn new(pattern_count: usize) -> Self {
+        Self {
+            offsets: vec![0; pattern_count],
+            programs: Vec::new(),
+        }
+    }
+
+    /// Compile `glob` as the program for `pattern_id`
+    pub fn add(&mut self, pattern_id: u32, glob: &GlobPattern) {
+        let base = HEADER_SIZE + self.offsets.len() * 4;
+        self.offsets[pattern_id as usize] = (base + self.programs.len()) as u32;
+        compile(glob, &mut self.programs);
+    }
+
+    /// Whether any program was added
+    pub fn is_empty(&self) -> bool {
+        self.programs.is_empty()
+    }
+
+    /// Serialize the section
+    pub fn build(self) -> Vec<u8> {
+        let mut out =
+            Vec::with_capacity(HEADER_SIZE + self.offsets.len() * 4 + self.programs.len());
+        out.extend_from_slice(MAGIC);
+        out.extend_from_slice(&FORMAT_VERSION.to_le_bytes());
+        out.extend_from_slice(&(self.offsets.len() as u32).to_le_bytes());
+        for offset in &self.offsets {
+            out.extend_from_slice(&offset.to_le_bytes());
+        }
+        out.extend_from_slice(&self.programs);
+        out
+    }
+}
+
+/// Append the program for `glob` to `out`
+fn compile(glob: &GlobPattern, out: &mut Vec<u8>) {
+    let fold = glob.mode() == MatchMode::CaseInsensitive;
+    let mut chunks: Vec<(u32, Vec<u8>)> = vec![(0, Vec::new())];
+
+    for segment in glob.segments() {
+        if let GlobSegment::Star = segment {
+            chunks.push((0, Vec::new()));
+            continue;
+        }
+        let (chars, atoms) = chunks.last_mut().expect("at least one chunk");
+        match segment {
+            GlobSegment::Literal(text) => {
+                let bytes = if fold {
+                    text.to_ascii_lowercase().into_bytes()
+                } else {
+                    text.as_bytes().to_vec()
+                };
+                *chars += text.chars().count() as u32;
+                atoms.push(ATOM_LITERAL);
+                atoms.extend_from_slice(&(bytes.len() as u32).to_le_bytes());
+                atoms.extend_from_slice(&bytes);
+            }
+            GlobSegment::Question => {
+                *chars += 1;
+                atoms.push(ATOM_ANY);
+            }
+            GlobSegment::CharClass {
+                chars: items,
+                negated,
+            } => {
+                *chars += 1;
+                compile_class(items, *negated, fold, atoms);
+            }
+            GlobSegment::Star => unreachable!(),
+        }
+    }
+
+    let start = out.len();
+    out.extend_from_slice(&(chunks.len() as u32).to_le_bytes());
+    let last_chunk_at = out.len();
+    out.extend_from_slice(&0u32.to_le_bytes());
+    let chunk_count = chunks.len();
+    for (i, (chars, atoms)) in chunks.into_iter().enumerate() {
+        if i + 1 == chunk_count {
+            let offset = (out.len() - start) as u32;
+            out[last_chunk_at..last_chunk_at + 4].copy_from_slice(&offset.to_le_bytes());
+        }
+        out.extend_from_slice(&chars.to_le_bytes());
+        out.extend_from_slice(&(atoms.len() as u32).to_le_bytes());
+        out.extend_from_slice(&atoms);
+    }
+}
+
+/// Encode a character class as an ASCII bitmap plus non-ASCII ranges
+///
+/// Membership follows [`GlobPattern::matches`]: in case-insensitive mode
+/// the query character and the class bounds are ASCII-lowercased before
+/// comparing. Queries are lowercased before a program runs, so the
+/// bitmap is indexed by the already-normalized character.
+fn compile_class(items: &[CharClassItem], negated: bool, fold: bool, atoms: &mut Vec<u8>) {
+    let norm = |c: char| if fold { c.to_ascii_lowercase() } else { c };
+    let bounds = |item: &CharClassItem| match *item {
+        CharClassItem::Char(c) => (norm(c), norm(c)),
+        CharClassItem::Range(lo, hi) => (norm(lo), norm(hi)),
+    };
+
+    let mut ascii = [0u8; 16];
+    for byte in 0u8..128 {
+        let ch = byte as char;
+        if items.iter().any(|item| {
+            let (lo, hi) = bounds(item);
+            lo <= ch && ch <= hi
+        }) {
+            ascii[(byte >> 3) as usize] |= 1 << (byte & 7);
+        }
+    }
+    let ranges: Vec<(char, char)> = items
+        .iter()
+        .map(bounds)
+        .filter(|&(_, hi)| !hi.is_ascii())
+        .collect();
+
+    atoms.push(ATOM_CLASS);
+    atoms.push(negated as u8);
+    atoms.extend_from_slice(&ascii);
+    atoms.extend_from_slice(&(ranges.len() as u32).to_le_bytes());
+    for (lo, hi) in ranges {
+        atoms.extend_from_slice(&(lo as u32).to_le_bytes());
+        atoms.extend_from_slice(&(hi as u32).to_le_bytes());
+    }
+}
+
+/// Read-only view of a serialized glob program section
+#[derive(Clone, Copy)]
+pub struct GlobPrograms<'a> {
+    section: &'a [u8],
+    count: usize,
+}
+
+impl<'a> GlobPrograms<'a> {
+    /// View the section at the start of `section`, if its header is sound
+    pub fn new(section: &'a [u8]) -> Option<Self> {
+        if section.get(..4)? != MAGIC || read_u32(section, 4)? != FORMAT_VERSION {
+            return None;
+        }
+        let count = read_u32(section, 8)? as usize;
+        if HEADER_SIZE + count.checked_mul(4)? > section.len() {
+            return None;
+        }
+        Some(Self { section, count })
+    }
+
+    /// Number of pattern IDs the offset table covers
+    pub fn pattern_count(&self) -> usize {
+        self.count
+    }
+
+    /// Run the program for `pattern_id` against `text`
+    ///
+    /// `text` must already be ASCII-lowercased for case-insensitive
+    /// matchers. Returns `None` when the pattern has no program, so the
+    /// caller falls back to [`GlobPattern::matches`]. A malformed program
+    /// never matches.
+    #[inline]
+    pub fn matches(&self, pattern_id: u32, text: &str) -> Option<bool> {
+        if pattern_id as usize >= self.count {
+            return None;
+        }
+        let offset = read_u32(self.section, HEADER_SIZE + pattern_id as usize * 4)? as usize;
+        if offset == 0 {
+            return None;
+        }
+        let program = self.section.get(offset..)?;
+        Some(run(program, text).is_some())
+    }
+
+    /// Check that every program decodes within the section
+    pub fn validate(&self) -> Result<(), String> {
+        for id in 0..self.count {
+            let offset = read_u32(self.section, HEADER_SIZE + id * 4).unwrap_or(0) as usize;
+            if offset == 0 {
+                continue;
+            }
+            let program = self
+                .section
+                .get(offset..)
+                .ok_or_else(|| format!("glob program {} offset {} out of bounds", id, offset))?;
+            check_program(program).ok_or_else(|| format!("glob program {} is malformed", id))?;
+        }
+        Ok(())
+    }
+}
+
+#[inline]
+fn read_u32(bytes: &[u8], at: usize) -> Option<u32> {
+    let b = bytes.get(at..at.checked_add(4)?)?;
+    Some(u32::from_le_bytes([b[0], b[1], b[2], b[3]]))
+}
+
+/// A chunk's character count and atom bytes, starting at `at`
+#[inline]
+fn read_chunk(program: &[u8], at: usize) -> Option<(usize, &[u8], usize)> {
+    let chars = read_u32(program, at)? as usize;
+    let size = read_u32(program, at + 4)? as usize;
+    let atoms = program.get(at + 8..(at + 8).checked_add(size)?)?;
+    Some((chars, atoms, at + 8 + size))
+}
+
+/// Size of the class atom body after its tag
+#[inline]
+fn class_size(body: &[u8]) -> Option<usize> {
+    let ranges = read_u32(body, 17)? as usize;
+    let size = 21 + ranges.checked_mul(8)?;
+    (size <= body.len()).then_some(size)
+}
+
+#[inline]
+fn class_contains(body: &[u8], ch: char) -> bool {
+    let negated = body[0] != 0;
+    let code = ch as u32;
+    let in_class = if code < 128 {
+        body[1 + (code >> 3) as usize] & (1 << (code & 7)) != 0
+    } else {
+        let ranges = read_u32(body, 17).unwrap_or(0) as usize;
+        (0..ranges).any(|i| {
+            let lo = read_u32(body, 21 + i * 8).unwrap_or(u32::MAX);
+            let hi = read_u32(body, 25 + i * 8).unwrap_or(0);
+            lo <= code && code <= hi
+        })
+    };
+    in_class != negated
+}
+
+/// Match a chunk's atoms at `start`; returns the end of the match
+#[inline]
+fn match_at(atoms: &[u8], text: &str, start: usize) -> Option<usize> {
+    let bytes = text.as_bytes();
+    let mut pos = start;
+    let mut at = 0;
+    while at < atoms.len() {
+        match atoms[at] {
+            ATOM_LITERAL => {
+                let len = read_u32(atoms, at + 1)? as usize;
+                let literal = atoms.get(at + 5..(at + 5).checked_add(len)?)?;
+                if bytes.get(pos..pos.checked_add(len)?)? != literal {
+                    return None;
+                }
+                pos += len;
+                at += 5 + len;
+            }
+            ATOM_ANY => {
+                pos += text.get(pos..)?.chars().next()?.len_utf8();
+                at += 1;
+            }
+            ATOM_CLASS => {
+                let body = &atoms[at + 1..];
+                let size = class_size(body)?;
+                let ch = text.get(pos..)?.chars().next()?;
+                if !class_contains(body, ch) {
+                    return None;
+                }
+                pos += ch.len_utf8();
+                at += 1 + size;
+            }
+            _ => return None,
+        }
+    }
+    Some(pos)
+}
+
+/// Leftmost match of a chunk starting in `from..=limit` and ending by `limit`
+///
+/// A chunk consumes a fixed number of characters, so a later start can
+/// never end earlier: the first candidate that matches settles it.
+#[inline]
+fn find_in(atoms: &[u8], text: &str, mut from: usize, limit: usize) -> Option<usize> {
+    let bytes = text.as_bytes();
+    if atoms.first() == Some(&ATOM_LITERAL) {
+        let len = read_u32(atoms, 1)? as usize;
+        let literal = atoms.get(5..5usize.checked_add(len)?)?;
+        loop {
+            let found = memchr::memmem::find(bytes.get(from..limit)?, literal)?;
+            let start = from + found;
+            if let Some(end) = match_at(atoms, text, start) {
+                return (end <= limit).then_some(end);
+            }
+            from = start + 1;
+        }
+    }
+
+    loop {
+        if let Some(end) = match_at(atoms, text, from) {
+            return (end <= limit).then_some(end);
+        }
+        if from >= limit {
+            return None;
+        }
+        from += text.get(from..)?.chars().next()?.len_utf8();
+    }
+}
+
+/// Run a program; `Some(())` when `text` matches
+fn run(program: &[u8], text: &str) -> Option<()> {
+    let chunk_count = read_u32(program, 0)? as usize;
+    let last_at = read_u32(program, 4)? as usize;
+    let (_, first, mut next) = read_chunk(program, 8)?;
+
+    let mut pos = match_at(first, text, 0)?;
+    if chunk_count == 1 {
+        return (pos == text.len()).then_some(());
+    }
+
+    // Last chunk: step back over its characters from the end
+    let (last_chars, last, _) = read_chunk(program, last_at)?;
+    let mut tail = text.len();
+    for _ in 0..last_chars {
+        tail = text[..tail].char_indices().next_back()?.0;
+    }
+    if tail < pos || match_at(last, text, tail)? != text.len() {
+        return None;
+    }
+
+    for _ in 2..chunk_count {
+        let (_, atoms, after) = read_chunk(program, next)?;
+        next = after;
+        if !atoms.is_empty() {
+            pos = find_in(atoms, text, pos, tail)?;
+        }
+    }
+    Some(())
+}
+
+/// Walk a program's structure without matching
+fn check_program(program: &[u8]) -> Option<()> {
+    let chunk_count = read_u32(program, 0)? as usize;
+    let last_at = read_u32(program, 4)? as usize;
+    if chunk_count == 0 {
+        return None;
+    }
+    let mut at = 8;
+    for i in 0..chunk_count {
+        if i + 1 == chunk_count && at != last_at {
+            return None;
+        }
+        let (_, atoms, next) = read_chunk(program, at)?;
+        let mut a = 0;
+        while a < atoms.len() {
+            a += match atoms[a] {
+                ATOM_LITERAL => {
+                    let len = read_u32(atoms, a + 1)? as usize;
+                    atoms.get(a + 5..(a + 5).checked_add(len)?)?;
+                    5 + len
+                }
+                ATOM_ANY => 1,
+                ATOM_CLASS => 1 + class_size(&atoms[a + 1..])?,
+                _ => return None,
+            };
+        }
+        at = next;
+    }
+    Some(())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn program(pattern: &str, mode: MatchMode) -> Vec<u8> {
+        let mut builder = GlobProgramBuilder::new(1);
+        builder.add(0, &GlobPattern::new(pattern, mode).unwrap());
+        builder.build()
+    }
+
+    /// Compare the compiled program with the interpreter on every text
+    fn assert_agrees(pattern: &str, mode: MatchMode, texts: &[&str]) {
+        let glob = GlobPattern::new(pattern, mode).unwrap();
+        let section = program(pattern, mode);
+        let programs = GlobPrograms::new(&section).unwrap();
+        programs.validate().unwrap();
+        for text in texts {
+            let folded = match mode {
+                MatchMode::CaseSensitive => text.to_string(),
+                MatchMode::CaseInsensitive => text.to_ascii_lowercase(),
+            };
+            assert_eq!(
+                programs.matches(0, &folded),
+                Some(glob.matches(text)),
+                "pattern {:?} on {:?}",
+                pattern,
+                text
+            );
+        }
+    }
+
+    const TEXTS: &[&str] = &[
+        "",
+        "a",
+        "example.com",
+        "www.example.com",
+        "a.b.cdn-1.example.org",
+        "x.y.cdn-.example.",
+        "cdn-.example.",
+        "a.b.cdn-1.example",
+        "file1.txt",
+        "fileA.txt",
+        "FILE9.TXT",
+        "abcabcabc",
+        "ümlaut.é",
+        "日本語.jp",
+    ];
+
+    #[test]
+    fn test_agrees_with_interpreter() {
+        let patterns = [
+            "*",
+            "*.*.cdn-*.example.*",
+            "*.example.com",
+            "www.*",
+            "file[0-9].txt",
+            "file[!0-9].txt",
+            "*[a-c]*",
+            "?",
+            "???",
+            "a*b*c",
+            "*abc",
+            "abc*abc",
+            "*.é",
+            "*[é-ü]*",
+            "??.jp",
+            "*.???",
+            "**.com",
+            "exact.com",
+        ];
+        for pattern in patterns {
+            assert_agrees(pattern, MatchMode::CaseSensitive, TEXTS);
+            assert_agrees(pattern, MatchMode::CaseInsensitive, TEXTS);
+        }
+        assert_agrees("FILE[A-Z].TXT", MatchMode::CaseInsensitive, TEXTS);
+    }
+
+    #[test]
+    fn test_no_backtracking_blowup() {
+        // The interpreter gives up on this after its step budget
+        let text = "a".repeat(5000);
+        let section = program("*a*a*a*a*a*a*a*a*b", MatchMode::CaseSensitive);
+        let programs = GlobPrograms::new(&section).unwrap();
+        assert_eq!(programs.matches(0, &text), Some(false));
+        assert_eq!(programs.matches(0, &format!("{}b", text)), Some(true));
+    }
+
+    #[test]
+    fn test_missing_and_malformed_programs() {
+        let mut builder = GlobProgramBuilder::new(2);
+        builder.add(
+            1,
+            &GlobPattern::new("*.com", MatchMode::CaseSensitive).unwrap(),
+        );
+        let mut section = builder.build();
+        let programs = GlobPrograms::new(&section).unwrap();
+        assert_eq!(programs.matches(0, "a.com"), None);
+        assert_eq!(programs.matches(7, "a.com"), None);
+        assert_eq!(programs.matches(1, "a.com"), Some(true));
+
+        // Truncate the program: no panic, no match, caught by validation
+        section.truncate(section.len() - 2);
+        let programs = GlobPrograms::new(&section).unwrap();
+        assert_eq!(programs.matches(1, "a.com"), Some(false));
+        assert!(programs.validate().is_err());
+        assert!(GlobPrograms::new(b"GLBX\x01\0\0\0\0\0\0\0").is_none());
+    }
+}
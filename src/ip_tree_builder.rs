@@ -3,10 +3,23 @@
 //! Builds a binary search tree for IP address lookups following the MMDB specification.
 //! Supports both IPv4 and IPv6 with CIDR prefixes.
 
+use crate::mmdb::stride::{self, EMPTY_ENTRY, STRIDE_BITS, STRIDE_FANOUT};
 use crate::mmdb::types::RecordSize;
 use crate::ParaglobError;
+use rayon::prelude::*;
+use std::collections::HashMap;
 use std::net::IpAddr;
 
+/// Entry count below which `insert_all` inserts sequentially
+const PARALLEL_INSERT_THRESHOLD: usize = 100_000;
+
+/// Address bits that pick an entry's subtree for parallel insertion
+/// (up to 256 IPv4 and 256 IPv6 subtrees built independently)
+const SPLIT_BITS: u8 = 8;
+
+/// Nodes serialized per parallel work item in `build`
+const NODES_PER_WRITE_CHUNK: usize = 64 * 1024;
+
 /// IP tree builder using arena allocation
 pub struct IpTreeBuilder {
     /// Record size for the tree
@@ -94,12 +107,131 @@ impl IpTreeBuilder {
         prefix_len: u8,
         data_offset: u32,
     ) -> Result<(), ParaglobError> {
+        let (bits, depth) = self.entry_path(addr, prefix_len)?;
+        self.insert_bits_u128(bits, depth, data_offset)
+    }
+
+    /// Insert many entries, building independent subtrees in parallel
+    ///
+    /// Equivalent to calling [`insert`](Self::insert) for each entry in
+    /// order. Large batches into an empty tree are split by the first
+    /// `SPLIT_BITS` bits of each address: every /8 (IPv4) or top-byte
+    /// (IPv6) subtree is built on its own thread and grafted onto the
+    /// root, then entries too short to belong to a single subtree are
+    /// inserted on top, backfilling as usual. Pass entries sorted most
+    /// specific first, as `MmdbBuilder` does, to minimize backfill work.
+    pub fn insert_all(&mut self, entries: &[(IpAddr, u8, u32)]) -> Result<(), ParaglobError> {
+        let fresh = self.nodes.len() == 1 && self.nodes[0].is_empty();
+        if !fresh || entries.len() < PARALLEL_INSERT_THRESHOLD || rayon::current_num_threads() < 2 {
+            for (addr, prefix_len, data_offset) in entries {
+                self.insert(*addr, *prefix_len, *data_offset)?;
+            }
+            return Ok(());
+        }
+        self.insert_all_split(entries)
+    }
+
+    /// Parallel path of `insert_all` (tree must be empty)
+    fn insert_all_split(&mut self, entries: &[(IpAddr, u8, u32)]) -> Result<(), ParaglobError> {
+        // Absolute depth where IPv4 subtrees hang (below ::/96 in IPv6 trees)
+        let v4_base: u8 = match self.ip_version {
+            IpVersion::V4 => 0,
+            IpVersion::V6 => 96,
+        };
+
+        // Bucket by (family, top SPLIT_BITS bits), keeping input order
+        let mut buckets: Vec<Vec<(u128, u8, u32)>> = vec![Vec::new(); 512];
+        let mut residual = Vec::new();
+        for &(addr, prefix_len, data_offset) in entries {
+            let (bits, depth) = self.entry_path(addr, prefix_len)?;
+            let (base, bucket_base) = match addr {
+                IpAddr::V4(_) => (v4_base, 0),
+                IpAddr::V6(_) => (0, 256),
+            };
+            let frontier = base + SPLIT_BITS;
+            let key = ((bits << base) >> (128 - SPLIT_BITS as u32)) as usize;
+
+            // IPv6 keys under 0::/8 share their path with the IPv4 subtrees
+            if depth <= frontier || (bucket_base == 256 && key == 0 && v4_base == 96) {
+                residual.push((bits, depth, data_offset));
+            } else {
+                buckets[bucket_base + key].push((bits << frontier, depth - frontier, data_offset));
+            }
+        }
+
+        let record_size = self.record_size;
+        let subtrees: Vec<(usize, Vec<Node>)> = buckets
+            .into_par_iter()
+            .enumerate()
+            .filter(|(_, bucket)| !bucket.is_empty())
+            .map(|(bucket, bucket_entries)| {
+                let mut subtree = IpTreeBuilder::new_v6(record_size);
+                subtree.reserve_nodes(bucket_entries.len() + bucket_entries.len() / 2);
+                for (bits, depth, data_offset) in bucket_entries {
+                    subtree.insert_bits_u128(bits, depth, data_offset)?;
+                }
+                Ok((bucket, subtree.nodes))
+            })
+            .collect::<Result<_, ParaglobError>>()?;
+
+        for (bucket, subtree) in subtrees {
+            let (base, key) = if bucket < 256 {
+                (v4_base, bucket as u128)
+            } else {
+                (0, (bucket - 256) as u128)
+            };
+            let frontier = base + SPLIT_BITS;
+            let path = key << (128 - frontier as u32);
+            self.graft(path, frontier, subtree);
+        }
+
+        for (bits, depth, data_offset) in residual {
+            self.insert_bits_u128(bits, depth, data_offset)?;
+        }
+        Ok(())
+    }
+
+    /// Attach `subtree` (rooted `depth` bits down `path`) to this tree
+    ///
+    /// Creates the path's nodes as needed; the edge at `depth` must be empty.
+    /// Subtree node ids and prefix lengths are rebased onto this tree.
+    fn graft(&mut self, path: u128, depth: u8, subtree: Vec<Node>) {
+        let mut node_id = 0u32;
+        for d in 0..depth - 1 {
+            let bit = (path >> (127 - d)) & 1;
+            node_id = match self.nodes[node_id as usize].child(bit) {
+                NodePointer::Node(child) => child,
+                _ => {
+                    let child = self.allocate_node();
+                    self.nodes[node_id as usize].set_child(bit, NodePointer::Node(child));
+                    child
+                }
+            };
+        }
+
+        let base = self.nodes.len() as u32;
+        let rebase = |pointer: NodePointer| match pointer {
+            NodePointer::Node(id) => NodePointer::Node(id + base),
+            NodePointer::Data(offset, prefix_len) => NodePointer::Data(offset, prefix_len + depth),
+            NodePointer::Empty => NodePointer::Empty,
+        };
+        self.nodes.extend(subtree.into_iter().map(|node| Node {
+            left: rebase(node.left),
+            right: rebase(node.right),
+        }));
+
+        let bit = (path >> (128 - depth as u32)) & 1;
+        self.nodes[node_id as usize].set_child(bit, NodePointer::Node(base));
+    }
+
+    /// Tree path for an entry: address bits from the root and their count
+    fn entry_path(&self, addr: IpAddr, prefix_len: u8) -> Result<(u128, u8), ParaglobError> {
         match addr {
             IpAddr::V4(v4) => {
                 if self.ip_version == IpVersion::V6 {
                     // Insert IPv4 into IPv6 tree (as IPv4-mapped at ::ffff:0:0/96)
                     let bits = ipv4_to_bits(v4) as u128;
-                    self.insert_bits_u128(bits, 96 + prefix_len, data_offset)
+                    Ok((bits, 96 + prefix_len))
                 } else {
                     // Pure IPv4 tree
                     if prefix_len > 32 {
@@ -109,7 +241,7 @@ impl IpTreeBuilder {
                         )));
                     }
                     let bits = ipv4_to_bits(v4) as u128;
-                    self.insert_bits_u128(bits << 96, prefix_len, data_offset)
+                    Ok((bits << 96, prefix_len))
                 }
             }
             IpAddr::V6(v6) => {
@@ -125,7 +257,7 @@ impl IpTreeBuilder {
                     )));
                 }
                 let bits = bits_to_u128(ipv6_to_bits(v6));
-                self.insert_bits_u128(bits, prefix_len, data_offset)
+                Ok((bits, prefix_len))
             }
         }
     }
@@ -338,14 +470,104 @@ impl IpTreeBuilder {
 
         let mut tree_bytes = vec![0u8; tree_size];
 
-        // Write each node from the arena
-        for (node_id, node) in self.nodes.iter().enumerate() {
-            self.write_node(&mut tree_bytes, node_id, node, node_count)?;
-        }
+        // Write each node from the arena; chunks are independent, so large
+        // trees are serialized in parallel (node ids are chunk-relative)
+        tree_bytes
+            .par_chunks_mut(node_size * NODES_PER_WRITE_CHUNK)
+            .zip(self.nodes.par_chunks(NODES_PER_WRITE_CHUNK))
+            .try_for_each(|(tree_chunk, nodes)| {
+                for (node_id, node) in nodes.iter().enumerate() {
+                    self.write_node(tree_chunk, node_id, node, node_count)?;
+                }
+                Ok::<(), ParaglobError>(())
+            })?;
 
         Ok((tree_bytes, node_count))
     }
 
+    /// Build the multi-bit stride index section for this tree
+    ///
+    /// The index mirrors the binary tree four bits at a time (see
+    /// `crate::mmdb::stride`), so lookups through it return the same data
+    /// offsets and prefix lengths. Returns `None` if a data offset is too
+    /// large for the index's entries; the database then simply has no index.
+    pub fn build_stride_index(&self) -> Option<Vec<u8>> {
+        let mut nodes = Vec::new();
+        let mut index_of = HashMap::new();
+
+        self.expand_stride(0, &mut nodes, &mut index_of)?;
+        let ipv4_root = match self.ip_version {
+            IpVersion::V4 => 0,
+            IpVersion::V6 => {
+                self.expand_stride(self.ipv4_start_node(), &mut nodes, &mut index_of)?
+            }
+        };
+
+        Some(stride::write_section(&nodes, ipv4_root))
+    }
+
+    /// Emit the stride node rooted at binary node `node_id`, returning its index
+    ///
+    /// Memoized because the IPv4 start node is also reached from the root.
+    fn expand_stride(
+        &self,
+        node_id: u32,
+        nodes: &mut Vec<[u32; STRIDE_FANOUT]>,
+        index_of: &mut HashMap<u32, u32>,
+    ) -> Option<u32> {
+        if let Some(&index) = index_of.get(&node_id) {
+            return Some(index);
+        }
+
+        let index = nodes.len() as u32;
+        if index >= EMPTY_ENTRY {
+            return None;
+        }
+        nodes.push([EMPTY_ENTRY; STRIDE_FANOUT]);
+        index_of.insert(node_id, index);
+
+        for nibble in 0..STRIDE_FANOUT {
+            let mut current = node_id;
+            let mut entry = EMPTY_ENTRY;
+
+            for depth in 0..STRIDE_BITS {
+                let bit = (nibble >> (STRIDE_BITS - 1 - depth)) & 1;
+                let node = &self.nodes[current as usize];
+                let pointer = if bit == 0 { node.left } else { node.right };
+                match pointer {
+                    NodePointer::Empty => break,
+                    NodePointer::Data(offset, _) => {
+                        entry = stride::data_entry(offset, depth)?;
+                        break;
+                    }
+                    NodePointer::Node(child) if depth + 1 == STRIDE_BITS => {
+                        entry = self.expand_stride(child, nodes, index_of)?;
+                    }
+                    NodePointer::Node(child) => current = child,
+                }
+            }
+
+            nodes[index as usize][nibble] = entry;
+        }
+
+        Some(index)
+    }
+
+    /// Node where IPv4 lookups start in an IPv6 tree
+    ///
+    /// Follows 96 zero bits exactly as `SearchTree` does, stopping early at
+    /// the last node if the path ends, so both agree on IPv4 results.
+    fn ipv4_start_node(&self) -> u32 {
+        let mut node = 0u32;
+        for _ in 0..96 {
+            match self.nodes[node as usize].left {
+                NodePointer::Node(child) => node = child,
+                NodePointer::Data(..) | NodePointer::Empty => break,
+            }
+        }
+        node
+    }
+
     /// Write a single node to the tree bytes
     fn write_node(
         &self,
@@ -502,6 +724,26 @@ impl Node {
             right: NodePointer::Empty,
         }
     }
+
+    fn is_empty(&self) -> bool {
+        self.left == NodePointer::Empty && self.right == NodePointer::Empty
+    }
+
+    fn child(&self, bit: u128) -> NodePointer {
+        if bit == 0 {
+            self.left
+        } else {
+            self.right
+        }
+    }
+
+    fn set_child(&mut self, bit: u128, pointer: NodePointer) {
+        if bit == 0 {
+            self.left = pointer;
+        } else {
+            self.right = pointer;
+        }
+    }
 }
 
 /// Convert IPv4 address to 32-bit integer
@@ -658,4 +900,192 @@ mod tests {
         let result = builder.insert(addr, 128, 100);
         assert!(result.is_err());
     }
+
+    /// Lay a tree and its stride index out in one buffer and compare lookups
+    fn assert_stride_matches_tree(builder: &IpTreeBuilder, addrs: &[IpAddr]) {
+        use crate::mmdb::stride::{find_mismatch, StrideHeader, StrideIndex};
+        use crate::mmdb::types::IpVersion as MmdbIpVersion;
+        use crate::mmdb::{MmdbHeader, SearchTree};
+
+        let (mut data, node_count) = builder.build().unwrap();
+        let mut header = MmdbHeader {
+            node_count,
+            record_size: RecordSize::Bits24,
+            ip_version: match builder.ip_version {
+                IpVersion::V4 => MmdbIpVersion::V4,
+                IpVersion::V6 => MmdbIpVersion::V6,
+            },
+            tree_size: data.len(),
+            ipv4_start_node: 0,
+        };
+        header.resolve_ipv4_start_node(&data).unwrap();
+        let section_offset = data.len().next_multiple_of(64);
+        data.resize(section_offset, 0);
+        data.extend_from_slice(&builder.build_stride_index().unwrap());
+
+        let stride_header = StrideHeader::from_section(&data, section_offset).unwrap();
+        let tree = SearchTree::new(&data, &header);
+        let stride = StrideIndex::new(&data, &stride_header);
+        for addr in addrs {
+            assert_eq!(
+                tree.lookup(*addr).unwrap(),
+                stride.lookup(*addr).unwrap(),
+                "{}",
+                addr
+            );
+        }
+
+        let mut batch = Vec::new();
+        stride.lookup_batch(addrs, &mut batch);
+        for (addr, result) in addrs.iter().zip(batch) {
+            assert_eq!(tree.lookup(*addr).unwrap(), result.unwrap(), "{}", addr);
+        }
+
+        assert_eq!(find_mismatch(&data, &header, &stride_header, 4096), None);
+    }
+
+    #[test]
+    fn test_stride_index_matches_tree_v4() {
+        use std::net::Ipv4Addr;
+
+        let mut builder = IpTreeBuilder::new_v4(RecordSize::Bits24);
+        let networks: [([u8; 4], u8, u32); 6] = [
+            ([10, 0, 0, 0], 8, 100),
+            ([10, 1, 2, 0], 23, 200),
+            ([10, 1, 2, 3], 32, 300),
+            ([192, 168, 0, 0], 17, 400),
+            ([172, 16, 0, 0], 12, 500),
+            ([1, 1, 1, 1], 31, 600),
+        ];
+        for (octets, prefix, offset) in networks {
+            builder
+                .insert(IpAddr::V4(Ipv4Addr::from(octets)), prefix, offset)
+                .unwrap();
+        }
+
+        let probes: [[u8; 4]; 10] = [
+            [10, 0, 0, 1],
+            [10, 1, 2, 3],
+            [10, 1, 3, 255],
+            [10, 1, 4, 0],
+            [192, 168, 127, 1],
+            [192, 168, 128, 1],
+            [172, 31, 255, 255],
+            [1, 1, 1, 0],
+            [1, 1, 1, 2],
+            [8, 8, 8, 8],
+        ];
+        let addrs: Vec<IpAddr> = probes
+            .iter()
+            .map(|o| IpAddr::V4(Ipv4Addr::from(*o)))
+            .collect();
+        assert_stride_matches_tree(&builder, &addrs);
+    }
+
+    #[test]
+    fn test_stride_index_matches_tree_v6() {
+        use std::net::{Ipv4Addr, Ipv6Addr};
+
+        let mut builder = IpTreeBuilder::new_v6(RecordSize::Bits24);
+        builder
+            .insert(IpAddr::V6("2001:db8::".parse().unwrap()), 33, 100)
+            .unwrap();
+        builder
+            .insert(IpAddr::V6("2001:db8:1::1".parse().unwrap()), 128, 200)
+            .unwrap();
+        builder
+            .insert(IpAddr::V4(Ipv4Addr::new(8, 8, 8, 0)), 24, 300)
+            .unwrap();
+        builder
+            .insert(IpAddr::V4(Ipv4Addr::new(9, 9, 9, 9)), 32, 400)
+            .unwrap();
+
+        let addrs = [
+            IpAddr::V6("2001:db8::1".parse().unwrap()),
+            IpAddr::V6("2001:db8:1::1".parse().unwrap()),
+            IpAddr::V6("2001:db8:8000::1".parse().unwrap()),
+            IpAddr::V6(Ipv6Addr::LOCALHOST),
+            IpAddr::V4(Ipv4Addr::new(8, 8, 8, 8)),
+            IpAddr::V4(Ipv4Addr::new(9, 9, 9, 9)),
+            IpAddr::V4(Ipv4Addr::new(9, 9, 9, 8)),
+            IpAddr::V4(Ipv4Addr::new(1, 1, 1, 1)),
+        ];
+        assert_stride_matches_tree(&builder, &addrs);
+    }
+
+    #[test]
+    fn test_split_insert_matches_sequential() {
+        use crate::mmdb::types::IpVersion as MmdbIpVersion;
+        use crate::mmdb::{MmdbHeader, SearchTree};
+        use std::net::{Ipv4Addr, Ipv6Addr};
+
+        // Deterministic spread of networks over many /8s, sorted the way
+        // MmdbBuilder sorts them, plus short prefixes that span subtrees
+        let mut entries = Vec::new();
+        let mut x: u32 = 0x9E37_79B9;
+        for i in 0..2000u32 {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            let prefix = 9 + (x % 24) as u8;
+            entries.push((IpAddr::V4(Ipv4Addr::from(x)), prefix, i));
+            let v6 = ((x as u128) << 96) | ((i as u128) << 64);
+            entries.push((
+                IpAddr::V6(Ipv6Addr::from(v6)),
+                9 + (x % 100) as u8,
+                i + 10_000,
+            ));
+        }
+        entries.push((IpAddr::V4(Ipv4Addr::new(10, 0, 0, 0)), 7, 50_000));
+        entries.push((IpAddr::V4(Ipv4Addr::new(0, 0, 0, 0)), 1, 50_001));
+        entries.push((IpAddr::V6("::".parse().unwrap()), 64, 50_002));
+        entries.push((IpAddr::V6("2000::".parse().unwrap()), 4, 50_003));
+        entries.sort_by(|a, b| b.1.cmp(&a.1).then_with(|| a.0.cmp(&b.0)));
+
+        let mut sequential = IpTreeBuilder::new_v6(RecordSize::Bits32);
+        for (addr, prefix, offset) in &entries {
+            sequential.insert(*addr, *prefix, *offset).unwrap();
+        }
+        let mut split = IpTreeBuilder::new_v6(RecordSize::Bits32);
+        split.insert_all_split(&entries).unwrap();
+
+        let layouts: Vec<(Vec<u8>, MmdbHeader)> = [&sequential, &split]
+            .iter()
+            .map(|builder| {
+                let (data, node_count) = builder.build().unwrap();
+                let mut header = MmdbHeader {
+                    node_count,
+                    record_size: RecordSize::Bits32,
+                    ip_version: MmdbIpVersion::V6,
+                    tree_size: data.len(),
+                    ipv4_start_node: 0,
+                };
+                header.resolve_ipv4_start_node(&data).unwrap();
+                (data, header)
+            })
+            .collect();
+        let expected = SearchTree::new(&layouts[0].0, &layouts[0].1);
+        let actual = SearchTree::new(&layouts[1].0, &layouts[1].1);
+
+        for (addr, _, _) in &entries {
+            let probes = match addr {
+                IpAddr::V4(v4) => {
+                    let bits = u32::from(*v4);
+                    vec![*addr, IpAddr::V4(Ipv4Addr::from(bits ^ 0xFF))]
+                }
+                IpAddr::V6(v6) => {
+                    let bits = u128::from(*v6);
+                    vec![*addr, IpAddr::V6(Ipv6Addr::from(bits ^ 0xFFFF))]
+                }
+            };
+            for probe in probes {
+                assert_eq!(
+                    expected.lookup(probe).unwrap(),
+                    actual.lookup(probe).unwrap(),
+                    "{}",
+                    probe
+                );
+            }
+        }
+    }
 }
@@ -88,10 +88,18 @@
 /// AC literal ID hash table for O(1) lookups
 pub mod ac_literal_hash;
 pub mod ac_offset;
+/// Bump arena for allocation-free decoding and rendering
+pub mod arena;
+/// Replacement policies for the query cache (internal)
+mod cache_policy;
 /// Data section encoding/decoding for v2 format
 pub mod data_section;
 /// Unified database API
 pub mod database;
+/// Fused lookups across several databases with one scan per query
+pub mod database_set;
+/// Delta databases layered over a base, and compaction into a new base
+pub mod delta;
 /// Endianness handling for cross-platform zero-copy support
 pub mod endian;
 /// Error types for Paraglob operations
@@ -101,10 +109,14 @@ pub mod extractor;
 /// File reading utilities with automatic gzip decompression
 pub mod file_reader;
 pub mod glob;
+/// Compiled glob verification programs stored in the paraglob section
+pub mod glob_program;
 /// IP tree builder for MMDB format
 pub mod ip_tree_builder;
 /// Literal string hash table for O(1) exact matching
 pub mod literal_hash;
+/// Minimal perfect hash layout of the literal hash section
+pub mod literal_phf;
 /// MISP JSON threat intelligence importer
 pub mod misp_importer;
 pub mod mmap;
@@ -114,6 +126,8 @@ mod mmdb;
 pub mod mmdb_builder;
 pub mod offset_format;
 pub mod paraglob_offset;
+/// Bloom prefilter that rejects most string misses before the lookup tables
+pub mod prefilter;
 /// Batch processing infrastructure for efficient file analysis
 ///
 /// General-purpose building blocks for sequential or parallel line-oriented processing:
@@ -121,6 +135,12 @@ pub mod paraglob_offset;
 /// - `Worker` - Processes batches with extraction + matching  
 /// - `LineBatch`, `MatchResult`, `LineMatch` - Data structures
 pub mod processing;
+/// Sampled per-stage query latency histograms and work counters
+pub mod profile;
+/// Sharded, thread-safe query result cache (internal)
+mod query_cache;
+/// Database handles that swap in a new file under live query load
+pub mod reload;
 pub mod serialization;
 /// SIMD-accelerated utilities for pattern matching
 ///
@@ -147,12 +167,31 @@ pub mod c_api;
 
 /// Unified database for IP and pattern lookups
 pub use crate::database::{
-    Database, DatabaseError, DatabaseOpener, DatabaseOptions, DatabaseStats, QueryResult,
+    DataRef, Database, DatabaseError, DatabaseOpener, DatabaseOptions, DatabaseStats, Networks,
+    QueryResult,
 };
 
+/// Several databases queried with one scan
+pub use crate::database_set::{DatabaseSet, DatabaseSetScratch};
+
+/// Query cache replacement policy
+pub use crate::cache_policy::CachePolicy;
+
+/// Sampled per-stage query profiling
+pub use crate::profile::{ProfileStats, QueryProfiler, QueryStage};
+
+/// Hot-reloadable database handle
+pub use crate::reload::ReloadableDatabase;
+
 /// Data value type for database entries
 pub use crate::data_section::DataValue;
 
+/// In-place data section decoding (see [`Database::lookup_ref`])
+pub use crate::data_section::{ArenaValue, DataDecoder, ValueRef};
+
+/// Bump arena for decoding batches of hits (see [`DataDecoder::decode_in`])
+pub use crate::arena::Arena;
+
 pub use crate::error::ParaglobError;
 pub use crate::glob::MatchMode;
 
@@ -195,7 +234,7 @@ pub use crate::mmdb_builder::EntryType;
 // Legacy pattern-only APIs - kept for internal use and backward compatibility
 // These are not the primary public API anymore. Use Database and DatabaseBuilder instead.
 #[doc(hidden)]
-pub use crate::paraglob_offset::{Paraglob, ParaglobBuilder};
+pub use crate::paraglob_offset::{Paraglob, ParaglobBuilder, ParaglobScratch};
 #[doc(hidden)]
 pub use crate::serialization::{load, save};
 
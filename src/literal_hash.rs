@@ -36,10 +36,16 @@
 //!   mappings: [(pattern_id: u32, data_offset: u32); count]
 //! ```
 //!
+//! Version 2 of the section is a minimal perfect hash table with the data
+//! offset and key prefix inline in each slot, for one slot probe per
+//! lookup; see [`crate::literal_phf`]. Readers handle both versions.
+//!
 use crate::error::ParaglobError;
 use crate::glob::MatchMode;
+use crate::literal_phf::{PerfectHashTable, PERFECT_HASH_VERSION};
 use rayon::prelude::*;
 use rustc_hash::FxHashMap;
+use std::borrow::Cow;
 use std::mem;
 use xxhash_rust::xxh64::xxh64;
 
@@ -121,6 +127,7 @@ struct Shard {
 pub struct LiteralHashBuilder {
     patterns: Vec<(String, u32, u64)>, // (pattern, pattern_id, hash)
     mode: MatchMode,
+    perfect_hash: bool,
 }
 
 impl LiteralHashBuilder {
@@ -129,9 +136,22 @@ impl LiteralHashBuilder {
         Self {
             patterns: Vec::new(),
             mode,
+            perfect_hash: false,
         }
     }
 
+    /// Write a minimal perfect hash table (format version 2)
+    ///
+    /// Every lookup then probes exactly one 32-byte slot holding a
+    /// fingerprint, the data offset and the first 14 key bytes, instead of
+    /// a run of 16-byte entries and a separate string pool. The section is
+    /// smaller too: no empty slots and no pattern mapping table. Building
+    /// takes longer, and readers older than the format can't load it.
+    pub fn with_perfect_hash(mut self, enabled: bool) -> Self {
+        self.perfect_hash = enabled;
+        self
+    }
+
     /// Add a literal pattern
     pub fn add_pattern(&mut self, pattern: &str, pattern_id: u32) {
         // Normalize pattern based on match mode and pre-compute hash
@@ -155,6 +175,20 @@ impl LiteralHashBuilder {
         }
 
         let start = std::time::Instant::now();
+        if self.perfect_hash {
+            eprintln!(
+                "[LiteralHash] Building perfect hash table for {} patterns...",
+                self.patterns.len()
+            );
+            let keys: Vec<(String, u32)> = self
+                .patterns
+                .into_iter()
+                .map(|(pattern, pattern_id, _)| (pattern, pattern_id))
+                .collect();
+            let buffer = crate::literal_phf::build(&keys, pattern_data_offsets)?;
+            eprintln!("[LiteralHash] Total build time: {:?}", start.elapsed());
+            return Ok(buffer);
+        }
         eprintln!(
             "[LiteralHash] Building hash table for {} patterns...",
             self.patterns.len()
@@ -362,6 +396,32 @@ impl LiteralHashBuilder {
     }
 }
 
+/// A query normalized and hashed once, for probing several tables
+///
+/// Tables in the same match mode store keys normalized and hashed the same
+/// way, so one key serves all of them; see
+/// [`LiteralHash::lookup_entry_prepared`].
+pub struct LiteralKey<'q> {
+    query: &'q str,
+    mode: MatchMode,
+    normalized: Cow<'q, str>,
+    hash: u64,
+}
+
+impl<'q> LiteralKey<'q> {
+    /// Normalize and hash `query` as `mode` tables store their keys
+    pub fn new(query: &'q str, mode: MatchMode) -> Self {
+        let normalized = normalize(query, mode);
+        let hash = compute_hash(&normalized);
+        Self {
+            query,
+            mode,
+            normalized,
+            hash,
+        }
+    }
+}
+
 impl Default for LiteralHashBuilder {
     fn default() -> Self {
         Self::new(MatchMode::CaseSensitive)
@@ -377,6 +437,8 @@ pub struct LiteralHash<'a> {
     mappings_start: usize,
     shard_offsets: Vec<u32>, // Offset of each shard in the table
     mode: MatchMode,
+    /// Set for version 2 (perfect hash) sections, which use none of the above offsets
+    perfect: Option<PerfectHashTable<'a>>,
 }
 
 impl<'a> LiteralHash<'a> {
@@ -400,6 +462,28 @@ impl<'a> LiteralHash<'a> {
         }
 
         let version = u32::from_le_bytes(buffer[4..8].try_into().unwrap());
+        if version == PERFECT_HASH_VERSION {
+            let table = PerfectHashTable::from_buffer(buffer)?;
+            return Ok(Self {
+                buffer,
+                header: LiteralHashHeader {
+                    magic: *LITERAL_HASH_MAGIC,
+                    version,
+                    entry_count: table.entry_count(),
+                    table_size: table.position_count(),
+                    strings_offset: 0,
+                    strings_size: 0,
+                    num_shards: 0,
+                    shard_bits: 0,
+                },
+                table_start: 0,
+                strings_start: table.table_bytes().len(),
+                mappings_start: buffer.len(),
+                shard_offsets: Vec::new(),
+                mode,
+                perfect: Some(table),
+            });
+        }
         if version != LITERAL_HASH_VERSION {
             return Err(ParaglobError::InvalidPattern(format!(
                 "Unsupported literal hash version: {}",
@@ -455,9 +539,23 @@ impl<'a> LiteralHash<'a> {
             mappings_start,
             shard_offsets,
             mode,
+            perfect: None,
         })
     }
 
+    /// Header and hash table bytes (all a miss reads)
+    pub(crate) fn table_bytes(&self) -> &'a [u8] {
+        if let Some(table) = &self.perfect {
+            return table.table_bytes();
+        }
+        &self.buffer[..self.strings_start.min(self.buffer.len())]
+    }
+
+    /// Whether this is a version 2 (minimal perfect hash) table
+    pub fn is_perfect_hash(&self) -> bool {
+        self.perfect.is_some()
+    }
+
     /// Get the match mode of this literal hash table
     pub fn mode(&self) -> MatchMode {
         self.mode
@@ -467,13 +565,34 @@ impl<'a> LiteralHash<'a> {
     ///
     /// Returns the pattern ID if found, None otherwise
     pub fn lookup(&self, query: &str) -> Option<u32> {
-        // Normalize query based on match mode
-        let normalized_query = match self.mode {
-            MatchMode::CaseSensitive => query.to_string(),
-            MatchMode::CaseInsensitive => query.to_lowercase(),
-        };
+        self.probe(query).0
+    }
+
+    /// Number of table slots a lookup of `query` examines
+    ///
+    /// 1 for perfect hash tables and direct hits; longer runs mean the
+    /// shard's linear probing is clustering.
+    pub fn probe_count(&self, query: &str) -> usize {
+        self.probe(query).1
+    }
+
+    /// Lookup returning the pattern ID and the number of slots examined
+    #[inline]
+    fn probe(&self, query: &str) -> (Option<u32>, usize) {
+        let normalized_query = normalize(query, self.mode);
+        if let Some(table) = &self.perfect {
+            let found = table
+                .lookup(&normalized_query)
+                .map(|entry| entry.pattern_id);
+            return (found, 1);
+        }
         let hash = compute_hash(&normalized_query);
+        self.probe_hashed(&normalized_query, hash)
+    }
 
+    /// Sharded-table probe for a normalized query and its hash
+    #[inline]
+    fn probe_hashed(&self, normalized_query: &str, hash: u64) -> (Option<u32>, usize) {
         // Compute shard and shard bounds using offset table
         let num_shards = self.header.num_shards as usize;
         let shard_id = (hash as usize) % num_shards;
@@ -483,7 +602,7 @@ impl<'a> LiteralHash<'a> {
         let shard_capacity = shard_end - shard_start;
 
         if shard_capacity == 0 {
-            return None; // Empty shard
+            return (None, 0); // Empty shard
         }
 
         // Shard capacity is always power of 2, so mask works
@@ -494,10 +613,10 @@ impl<'a> LiteralHash<'a> {
         let entry_size = mem::size_of::<HashEntry>();
 
         // Lookup within shard only
-        for _ in 0..shard_capacity {
+        for probes in 1..=shard_capacity {
             let entry_offset = self.table_start + slot * entry_size;
             if entry_offset + entry_size > self.buffer.len() {
-                return None;
+                return (None, probes);
             }
 
             let entry_bytes = &self.buffer[entry_offset..entry_offset + entry_size];
@@ -507,14 +626,14 @@ impl<'a> LiteralHash<'a> {
 
             // Empty slot - not found
             if string_offset == EMPTY_SLOT {
-                return None;
+                return (None, probes);
             }
 
             // Hash matches - verify string
             if entry_hash == hash {
                 if let Some(stored_string) = self.read_string(string_offset as usize) {
                     if stored_string == normalized_query {
-                        return Some(pattern_id);
+                        return (Some(pattern_id), probes);
                     }
                 }
             }
@@ -523,7 +642,38 @@ impl<'a> LiteralHash<'a> {
             slot = shard_start + ((slot + 1 - shard_start) & shard_mask);
         }
 
-        None
+        (None, shard_capacity)
+    }
+
+    /// Lookup a literal with its data offset
+    ///
+    /// Same as [`lookup`](Self::lookup) followed by
+    /// [`get_data_offset`](Self::get_data_offset), but perfect hash tables
+    /// answer both from the one slot they probe.
+    pub fn lookup_entry(&self, query: &str) -> Option<(u32, Option<u32>)> {
+        if let Some(table) = &self.perfect {
+            let entry = table.lookup(&normalize(query, self.mode))?;
+            return Some((entry.pattern_id, entry.data_offset));
+        }
+        let pattern_id = self.lookup(query)?;
+        Some((pattern_id, self.get_data_offset(pattern_id)))
+    }
+
+    /// [`lookup_entry`](Self::lookup_entry) with the normalizing and
+    /// hashing already done
+    ///
+    /// A key prepared for the other match mode is looked up from scratch.
+    pub fn lookup_entry_prepared(&self, key: &LiteralKey<'_>) -> Option<(u32, Option<u32>)> {
+        if key.mode != self.mode {
+            return self.lookup_entry(key.query);
+        }
+        if let Some(table) = &self.perfect {
+            // Perfect hash tables hash with their own seed
+            let entry = table.lookup(&key.normalized)?;
+            return Some((entry.pattern_id, entry.data_offset));
+        }
+        let pattern_id = self.probe_hashed(&key.normalized, key.hash).0?;
+        Some((pattern_id, self.get_data_offset(pattern_id)))
     }
 
     /// Read a string from the string pool
@@ -545,7 +695,20 @@ impl<'a> LiteralHash<'a> {
     }
 
     /// Get data offset for a pattern ID
+    ///
+    /// O(1) for tables written by `MmdbBuilder`, whose mappings are in
+    /// pattern ID order; other tables are scanned. Prefer
+    /// [`lookup_entry`](Self::lookup_entry) when starting from a key.
     pub fn get_data_offset(&self, pattern_id: u32) -> Option<u32> {
+        if let Some(table) = &self.perfect {
+            let mut found = None;
+            table.for_each(|_, entry| {
+                if entry.pattern_id == pattern_id {
+                    found = entry.data_offset;
+                }
+            });
+            return found;
+        }
         if self.mappings_start + 4 > self.buffer.len() {
             return None;
         }
@@ -559,6 +722,16 @@ impl<'a> LiteralHash<'a> {
         let mappings_data_start = self.mappings_start + 4;
         let mapping_size = 8; // pattern_id: u32 + data_offset: u32
 
+        // Mappings are usually stored by pattern ID: try its own position first
+        if pattern_id < count {
+            let offset = mappings_data_start + pattern_id as usize * mapping_size;
+            if let Some(mapping) = self.buffer.get(offset..offset + mapping_size) {
+                if u32::from_le_bytes(mapping[0..4].try_into().ok()?) == pattern_id {
+                    return Some(u32::from_le_bytes(mapping[4..8].try_into().ok()?));
+                }
+            }
+        }
+
         for i in 0..count {
             let offset = mappings_data_start + (i as usize) * mapping_size;
             if offset + mapping_size > self.buffer.len() {
@@ -576,6 +749,43 @@ impl<'a> LiteralHash<'a> {
         None
     }
 
+    /// Visit every stored literal with its pattern ID
+    ///
+    /// Literals are yielded in table order, as stored (lowercased for
+    /// case-insensitive tables).
+    pub fn for_each_pattern(&self, mut f: impl FnMut(&str, u32)) {
+        if let Some(table) = &self.perfect {
+            table.for_each(|literal, entry| f(literal, entry.pattern_id));
+            return;
+        }
+        let entry_size = mem::size_of::<HashEntry>();
+        for slot in 0..self.header.table_size as usize {
+            let entry_offset = self.table_start + slot * entry_size;
+            let Some(entry_bytes) = self.buffer.get(entry_offset..entry_offset + entry_size) else {
+                return;
+            };
+            let string_offset = u32::from_le_bytes(entry_bytes[8..12].try_into().unwrap());
+            if string_offset == EMPTY_SLOT {
+                continue;
+            }
+            let pattern_id = u32::from_le_bytes(entry_bytes[12..16].try_into().unwrap());
+            if let Some(pattern) = self.read_string(string_offset as usize) {
+                f(pattern, pattern_id);
+            }
+        }
+    }
+
+    /// Visit every stored literal with its pattern ID and data offset
+    pub fn for_each_entry(&self, mut f: impl FnMut(&str, u32, Option<u32>)) {
+        if let Some(table) = &self.perfect {
+            table.for_each(|literal, entry| f(literal, entry.pattern_id, entry.data_offset));
+            return;
+        }
+        self.for_each_pattern(|literal, pattern_id| {
+            f(literal, pattern_id, self.get_data_offset(pattern_id))
+        });
+    }
+
     /// Get statistics
     pub fn entry_count(&self) -> u32 {
         self.header.entry_count
@@ -664,6 +874,21 @@ fn build_shard_auto_size(shard_id: usize, entries: Vec<(String, u32, u64)>) -> S
     }
 }
 
+/// Normalize a query as keys were stored, per the match mode
+///
+/// Borrows the query unless lowercasing actually changes it.
+fn normalize(query: &str, mode: MatchMode) -> Cow<'_, str> {
+    match mode {
+        MatchMode::CaseSensitive => Cow::Borrowed(query),
+        MatchMode::CaseInsensitive
+            if query.is_ascii() && !query.bytes().any(|b| b.is_ascii_uppercase()) =>
+        {
+            Cow::Borrowed(query)
+        }
+        MatchMode::CaseInsensitive => Cow::Owned(query.to_lowercase()),
+    }
+}
+
 /// Compute XXH64 with fixed seed for stable, portable on-disk hashing
 const HASH_SEED_1: u64 = 0;
 
@@ -714,4 +939,31 @@ mod tests {
             assert_eq!(hash.lookup(&format!("pattern_{}", i)), Some(i));
         }
     }
+
+    #[test]
+    fn test_prepared_key_matches_lookup_entry() {
+        for perfect in [false, true] {
+            let mut builder =
+                LiteralHashBuilder::new(MatchMode::CaseInsensitive).with_perfect_hash(perfect);
+            for i in 0..50 {
+                builder.add_pattern(&format!("Host{}.Example", i), i);
+            }
+            let pattern_data: Vec<_> = (0..50).map(|i| (i, i * 10)).collect();
+            let bytes = builder.build(&pattern_data).unwrap();
+            let hash = LiteralHash::from_buffer(&bytes, MatchMode::CaseInsensitive).unwrap();
+
+            for query in ["host7.example", "HOST49.EXAMPLE", "host50.example"] {
+                let expected = hash.lookup_entry(query);
+                let key = LiteralKey::new(query, MatchMode::CaseInsensitive);
+                assert_eq!(hash.lookup_entry_prepared(&key), expected);
+                // A key for the other mode falls back to a full lookup
+                let other = LiteralKey::new(query, MatchMode::CaseSensitive);
+                assert_eq!(hash.lookup_entry_prepared(&other), expected);
+            }
+            assert_eq!(
+                hash.lookup_entry_prepared(&LiteralKey::new("host7.example", hash.mode())),
+                Some((7, Some(70)))
+            );
+        }
+    }
 }
@@ -0,0 +1,501 @@
+//! Minimal Perfect Hash Layout for the Literal Hash Section
+//!
+//! Version 2 of the `LHSH` section replaces the sharded open-addressing
+//! table with a PTHash-style minimal perfect hash: every stored literal owns
+//! exactly one slot, and a lookup reads one bucket pilot and then exactly
+//! one slot. The slot carries a fingerprint, the pattern ID, the data offset
+//! and the first bytes of the key inline, so a miss is usually rejected and
+//! a hit usually verified without leaving the slot's cache line.
+//!
+//! # Construction
+//!
+//! Keys are hashed into `entry_count / 5` buckets. Buckets are placed
+//! largest first: for each one the builder searches for a 16-bit *pilot*
+//! that sends all its keys to free positions. Positions range over
+//! `entry_count / 0.97` so the last buckets still find room quickly; keys
+//! that land past `entry_count` are redirected through a small remap table
+//! into the slots left free below it, keeping the table minimal. If some
+//! bucket finds no pilot the build retries with a new seed.
+//!
+//! # Format
+//!
+//! ```text
+//! [Header]                  // 32 bytes, shares magic/version with v1
+//!   magic: [u8; 4]          // "LHSH"
+//!   version: u32            // 2
+//!   entry_count: u32        // Number of literals (= slots)
+//!   position_count: u32     // Hash positions (>= entry_count)
+//!   bucket_count: u32       // Number of pilots
+//!   seed: u32               // Hash seed that produced a perfect placement
+//!   tail_size: u32          // Size of the tail pool
+//!   reserved: u32           // 0
+//!
+//! [Pilots]  [u16; bucket_count], padded to 4 bytes
+//! [Remap]   [u32; position_count - entry_count]
+//! [Slots]   [Slot; entry_count], 32-byte aligned within the section
+//!   fingerprint: u32        // Low half of the key's seeded hash
+//!   pattern_id: u32
+//!   data_offset: u32        // 0xFFFFFFFF when the key has no data
+//!   tail_offset: u32        // Offset of the key's remaining bytes in the tail pool
+//!   key_len: u16
+//!   inline: [u8; 14]        // First bytes of the key (zero padded)
+//!
+//! [Tail Pool]               // Bytes of keys longer than 14, past the inline prefix
+//! ```
+
+use crate::error::ParaglobError;
+use rayon::prelude::*;
+use rustc_hash::FxHashMap;
+use xxhash_rust::xxh64::xxh64;
+
+/// Format version of the perfect hash layout
+pub const PERFECT_HASH_VERSION: u32 = 2;
+
+/// Size of one slot
+pub const SLOT_BYTES: usize = 32;
+
+/// Key bytes stored in the slot itself
+const INLINE_BYTES: usize = SLOT_BYTES - 18;
+
+/// Header size, shared with the v1 layout
+const HEADER_BYTES: usize = 32;
+
+/// Average keys per bucket
+const KEYS_PER_BUCKET: usize = 5;
+
+/// Share of the hash positions occupied by keys
+const LOAD_FACTOR: f64 = 0.97;
+
+/// Seeds tried before giving up on a key set
+const MAX_SEEDS: u32 = 32;
+
+/// Marker for keys without a data offset
+const NO_DATA: u32 = u32::MAX;
+
+#[inline]
+fn key_hash(key: &[u8], seed: u32) -> u64 {
+    xxh64(key, seed as u64)
+}
+
+#[inline]
+fn bucket_of(hash: u64, bucket_count: u32) -> usize {
+    (((hash >> 32) * bucket_count as u64) >> 32) as usize
+}
+
+#[inline]
+fn position_of(hash: u64, pilot: u16, position_count: u32) -> usize {
+    // Mix the pilot into the hash (murmur3 finalizer), then map into range
+    let mut x = hash ^ (pilot as u64 + 1).wrapping_mul(0x9E37_79B9_7F4A_7C15);
+    x ^= x >> 33;
+    x = x.wrapping_mul(0xFF51_AFD7_ED55_8CCD);
+    x ^= x >> 33;
+    x = x.wrapping_mul(0xC4CE_B9FE_1A85_EC53);
+    x ^= x >> 33;
+    ((x as u128 * position_count as u128) >> 64) as usize
+}
+
+#[inline]
+fn read_u32(buffer: &[u8], offset: usize) -> u32 {
+    u32::from_le_bytes(buffer[offset..offset + 4].try_into().unwrap())
+}
+
+/// Section sizes derived from the header
+struct Layout {
+    pilots_start: usize,
+    remap_start: usize,
+    slots_start: usize,
+    tail_start: usize,
+}
+
+impl Layout {
+    fn new(entry_count: usize, position_count: usize, bucket_count: usize) -> Self {
+        let pilots_start = HEADER_BYTES;
+        let remap_start = (pilots_start + bucket_count * 2).next_multiple_of(4);
+        let slots_start =
+            (remap_start + (position_count - entry_count) * 4).next_multiple_of(SLOT_BYTES);
+        let tail_start = slots_start + entry_count * SLOT_BYTES;
+        Self {
+            pilots_start,
+            remap_start,
+            slots_start,
+            tail_start,
+        }
+    }
+}
+
+/// Serialize literals as a minimal perfect hash section
+///
+/// `keys` are normalized literals with their pattern IDs; a key given more
+/// than once keeps its last pattern ID, like the v1 table. `data_offsets`
+/// maps pattern IDs to data section offsets.
+pub fn build(
+    keys: &[(String, u32)],
+    data_offsets: &[(u32, u32)],
+) -> Result<Vec<u8>, ParaglobError> {
+    let mut unique: FxHashMap<&str, u32> = FxHashMap::default();
+    for (key, pattern_id) in keys {
+        if key.len() > u16::MAX as usize {
+            return Err(ParaglobError::InvalidPattern(format!(
+                "Literal of {} bytes is too long for the literal hash table",
+                key.len()
+            )));
+        }
+        unique.insert(key, *pattern_id);
+    }
+    let mut keys: Vec<(&str, u32)> = unique.into_iter().collect();
+    keys.sort_unstable();
+
+    let data: FxHashMap<u32, u32> = data_offsets.iter().copied().collect();
+    let entry_count = keys.len();
+    let position_count = ((entry_count as f64 / LOAD_FACTOR).ceil() as usize).max(entry_count);
+    let bucket_count = entry_count.div_ceil(KEYS_PER_BUCKET).max(1);
+    if position_count > u32::MAX as usize {
+        return Err(ParaglobError::InvalidPattern(
+            "Too many literals for the literal hash table".to_string(),
+        ));
+    }
+
+    let (seed, pilots, positions) = (0..MAX_SEEDS)
+        .find_map(|seed| {
+            let hashes: Vec<u64> = keys
+                .par_iter()
+                .map(|(key, _)| key_hash(key.as_bytes(), seed))
+                .collect();
+            place(&hashes, position_count as u32, bucket_count as u32)
+                .map(|(pilots, positions)| (seed, pilots, positions))
+        })
+        .ok_or_else(|| {
+            ParaglobError::InvalidPattern(
+                "No perfect hash placement found for the literal set".to_string(),
+            )
+        })?;
+
+    // Keys placed past entry_count move to the slots left free below it
+    let mut used = vec![false; entry_count];
+    for &p in positions.iter().filter(|&&p| p < entry_count) {
+        used[p] = true;
+    }
+    let mut free = (0..entry_count).filter(|&slot| !used[slot]);
+    let mut remap = vec![0u32; position_count - entry_count];
+    let mut slots_of = vec![0usize; entry_count];
+    let mut by_position: Vec<(usize, usize)> = positions
+        .iter()
+        .enumerate()
+        .map(|(key, &p)| (p, key))
+        .collect();
+    by_position.sort_unstable();
+    for (p, key) in by_position {
+        slots_of[key] = if p < entry_count {
+            p
+        } else {
+            let slot = free.next().expect("one free slot per overflowed key");
+            remap[p - entry_count] = slot as u32;
+            slot
+        };
+    }
+
+    let layout = Layout::new(entry_count, position_count, bucket_count);
+    let tail_size: usize = keys
+        .iter()
+        .map(|(key, _)| key.len().saturating_sub(INLINE_BYTES))
+        .sum();
+    let mut buffer = vec![0u8; layout.tail_start + tail_size];
+
+    buffer[0..4].copy_from_slice(crate::literal_hash::LITERAL_HASH_MAGIC);
+    let header = [
+        PERFECT_HASH_VERSION,
+        entry_count as u32,
+        position_count as u32,
+        bucket_count as u32,
+        seed,
+        tail_size as u32,
+        0,
+    ];
+    for (i, field) in header.iter().enumerate() {
+        buffer[4 + i * 4..8 + i * 4].copy_from_slice(&field.to_le_bytes());
+    }
+    for (i, pilot) in pilots.iter().enumerate() {
+        let at = layout.pilots_start + i * 2;
+        buffer[at..at + 2].copy_from_slice(&pilot.to_le_bytes());
+    }
+    for (i, slot) in remap.iter().enumerate() {
+        let at = layout.remap_start + i * 4;
+        buffer[at..at + 4].copy_from_slice(&slot.to_le_bytes());
+    }
+
+    let mut tail_offset = 0usize;
+    for (index, (key, pattern_id)) in keys.iter().enumerate() {
+        let bytes = key.as_bytes();
+        let hash = key_hash(bytes, seed);
+        let at = layout.slots_start + slots_of[index] * SLOT_BYTES;
+        let slot = &mut buffer[at..at + SLOT_BYTES];
+        slot[0..4].copy_from_slice(&(hash as u32).to_le_bytes());
+        slot[4..8].copy_from_slice(&pattern_id.to_le_bytes());
+        let data_offset = data.get(pattern_id).copied().unwrap_or(NO_DATA);
+        slot[8..12].copy_from_slice(&data_offset.to_le_bytes());
+        slot[12..16].copy_from_slice(&(tail_offset as u32).to_le_bytes());
+        slot[16..18].copy_from_slice(&(bytes.len() as u16).to_le_bytes());
+        let inline = bytes.len().min(INLINE_BYTES);
+        slot[18..18 + inline].copy_from_slice(&bytes[..inline]);
+
+        let tail = &bytes[inline..];
+        let at = layout.tail_start + tail_offset;
+        buffer[at..at + tail.len()].copy_from_slice(tail);
+        tail_offset += tail.len();
+    }
+
+    Ok(buffer)
+}
+
+/// Find a pilot for every bucket, largest buckets first
+///
+/// Returns the pilots and each key's position, or None if some bucket
+/// cannot be placed with this seed.
+fn place(hashes: &[u64], position_count: u32, bucket_count: u32) -> Option<(Vec<u16>, Vec<usize>)> {
+    // Group keys by bucket (counting sort)
+    let mut starts = vec![0usize; bucket_count as usize + 1];
+    for &hash in hashes {
+        starts[bucket_of(hash, bucket_count) + 1] += 1;
+    }
+    for i in 0..bucket_count as usize {
+        starts[i + 1] += starts[i];
+    }
+    let mut members = vec![0usize; hashes.len()];
+    let mut fill = starts.clone();
+    for (key, &hash) in hashes.iter().enumerate() {
+        let bucket = bucket_of(hash, bucket_count);
+        members[fill[bucket]] = key;
+        fill[bucket] += 1;
+    }
+
+    let mut order: Vec<usize> = (0..bucket_count as usize).collect();
+    order.sort_unstable_by_key(|&b| std::cmp::Reverse(starts[b + 1] - starts[b]));
+
+    let mut taken = vec![false; position_count as usize];
+    let mut pilots = vec![0u16; bucket_count as usize];
+    let mut positions = vec![0usize; hashes.len()];
+    let mut candidate = Vec::with_capacity(16);
+    for bucket in order {
+        let keys = &members[starts[bucket]..starts[bucket + 1]];
+        if keys.is_empty() {
+            break; // Sorted by size: only empty buckets remain
+        }
+        let pilot = (0..=u16::MAX).find(|&pilot| {
+            candidate.clear();
+            for &key in keys {
+                let p = position_of(hashes[key], pilot, position_count);
+                if taken[p] || candidate.contains(&p) {
+                    return false;
+                }
+                candidate.push(p);
+            }
+            true
+        })?;
+        pilots[bucket] = pilot;
+        for (&key, &p) in keys.iter().zip(&candidate) {
+            taken[p] = true;
+            positions[key] = p;
+        }
+    }
+    Some((pilots, positions))
+}
+
+/// One slot of a perfect hash table
+#[derive(Clone, Copy)]
+pub struct SlotEntry<'a> {
+    /// Pattern ID of the literal
+    pub pattern_id: u32,
+    /// Data section offset, if the literal has data
+    pub data_offset: Option<u32>,
+    inline: &'a [u8],
+    tail: &'a [u8],
+}
+
+impl SlotEntry<'_> {
+    /// Whether the stored key is exactly `key`
+    fn matches(&self, key: &[u8]) -> bool {
+        key.len() == self.inline.len() + self.tail.len()
+            && key[..self.inline.len()] == *self.inline
+            && key[self.inline.len()..] == *self.tail
+    }
+
+    /// Append the stored key to `out`
+    fn key_into(&self, out: &mut Vec<u8>) {
+        out.extend_from_slice(self.inline);
+        out.extend_from_slice(self.tail);
+    }
+}
+
+/// Memory-mapped perfect hash table
+pub struct PerfectHashTable<'a> {
+    buffer: &'a [u8],
+    entry_count: u32,
+    position_count: u32,
+    bucket_count: u32,
+    seed: u32,
+    layout: Layout,
+}
+
+impl<'a> PerfectHashTable<'a> {
+    /// Parse the header of a version 2 section (magic and version already checked)
+    pub fn from_buffer(buffer: &'a [u8]) -> Result<Self, ParaglobError> {
+        if buffer.len() < HEADER_BYTES {
+            return Err(ParaglobError::InvalidPattern(
+                "Buffer too small for literal hash header".to_string(),
+            ));
+        }
+        let entry_count = read_u32(buffer, 8);
+        let position_count = read_u32(buffer, 12);
+        let bucket_count = read_u32(buffer, 16);
+        let seed = read_u32(buffer, 20);
+        let tail_size = read_u32(buffer, 24) as usize;
+        if position_count < entry_count || bucket_count == 0 {
+            return Err(ParaglobError::InvalidPattern(format!(
+                "Invalid perfect hash header ({} entries, {} positions, {} buckets)",
+                entry_count, position_count, bucket_count
+            )));
+        }
+
+        let layout = Layout::new(
+            entry_count as usize,
+            position_count as usize,
+            bucket_count as usize,
+        );
+        if layout.tail_start + tail_size > buffer.len() {
+            return Err(ParaglobError::InvalidPattern(
+                "Perfect hash table truncated".to_string(),
+            ));
+        }
+
+        Ok(Self {
+            buffer,
+            entry_count,
+            position_count,
+            bucket_count,
+            seed,
+            layout,
+        })
+    }
+
+    /// Header, pilots, remap table and slots (all a miss reads)
+    pub fn table_bytes(&self) -> &'a [u8] {
+        &self.buffer[..self.layout.tail_start]
+    }
+
+    /// Number of stored literals
+    pub fn entry_count(&self) -> u32 {
+        self.entry_count
+    }
+
+    /// Number of hash positions (table size before remapping)
+    pub fn position_count(&self) -> u32 {
+        self.position_count
+    }
+
+    /// Look up a normalized key: one pilot read, then one slot
+    pub fn lookup(&self, key: &str) -> Option<SlotEntry<'a>> {
+        if self.entry_count == 0 {
+            return None;
+        }
+        let key = key.as_bytes();
+        let hash = key_hash(key, self.seed);
+        let pilot_at = self.layout.pilots_start + bucket_of(hash, self.bucket_count) * 2;
+        let pilot = u16::from_le_bytes(self.buffer[pilot_at..pilot_at + 2].try_into().unwrap());
+
+        let mut slot = position_of(hash, pilot, self.position_count);
+        if slot >= self.entry_count as usize {
+            slot = read_u32(
+                self.buffer,
+                self.layout.remap_start + (slot - self.entry_count as usize) * 4,
+            ) as usize;
+        }
+
+        // The fingerprint rejects almost every miss before the key compare
+        let at = self.layout.slots_start + slot * SLOT_BYTES;
+        if self.buffer.get(at..at + 4)? != (hash as u32).to_le_bytes() {
+            return None;
+        }
+        self.slot(slot).filter(|entry| entry.matches(key))
+    }
+
+    /// Decode slot `index`
+    fn slot(&self, index: usize) -> Option<SlotEntry<'a>> {
+        let at = self.layout.slots_start + index * SLOT_BYTES;
+        let bytes = self.buffer.get(at..at + SLOT_BYTES)?;
+        let data_offset = read_u32(bytes, 8);
+        let tail_offset = read_u32(bytes, 12) as usize;
+        let len = u16::from_le_bytes([bytes[16], bytes[17]]) as usize;
+        let inline = len.min(INLINE_BYTES);
+        let tail_start = self.layout.tail_start + tail_offset;
+        Some(SlotEntry {
+            pattern_id: read_u32(bytes, 4),
+            data_offset: (data_offset != NO_DATA).then_some(data_offset),
+            inline: &bytes[18..18 + inline],
+            tail: self.buffer.get(tail_start..tail_start + (len - inline))?,
+        })
+    }
+
+    /// Visit every stored literal (in slot order) with its slot
+    pub fn for_each(&self, mut f: impl FnMut(&str, &SlotEntry<'a>)) {
+        let mut key = Vec::new();
+        for index in 0..self.entry_count as usize {
+            let Some(entry) = self.slot(index) else {
+                return;
+            };
+            key.clear();
+            entry.key_into(&mut key);
+            if let Ok(literal) = std::str::from_utf8(&key) {
+                f(literal, &entry);
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_every_key_found_once() {
+        let keys: Vec<(String, u32)> = (0..5000)
+            .map(|i| (format!("host-{}.example.com", i), i))
+            .collect();
+        let data: Vec<(u32, u32)> = (0..5000).map(|i| (i, i * 3)).collect();
+        let bytes = build(&keys, &data).unwrap();
+        let table = PerfectHashTable::from_buffer(&bytes).unwrap();
+        assert_eq!(table.entry_count(), 5000);
+
+        for (key, id) in &keys {
+            let entry = table.lookup(key).unwrap();
+            assert_eq!(entry.pattern_id, *id);
+            assert_eq!(entry.data_offset, Some(id * 3));
+        }
+        assert!(table.lookup("host-5000.example.com").is_none());
+        assert!(table.lookup("host-1.example.co").is_none());
+
+        let mut seen = 0;
+        table.for_each(|key, entry| {
+            assert_eq!(keys[entry.pattern_id as usize].0, key);
+            seen += 1;
+        });
+        assert_eq!(seen, 5000);
+    }
+
+    #[test]
+    fn test_short_long_and_duplicate_keys() {
+        let long = "x".repeat(300);
+        let keys = vec![
+            ("".to_string(), 0),
+            ("a".to_string(), 1),
+            (long.clone(), 2),
+            ("a".to_string(), 3),
+        ];
+        let bytes = build(&keys, &[(0, 10), (3, 30)]).unwrap();
+        let table = PerfectHashTable::from_buffer(&bytes).unwrap();
+        assert_eq!(table.entry_count(), 3);
+        assert_eq!(table.lookup("").unwrap().data_offset, Some(10));
+        assert_eq!(table.lookup("a").unwrap().pattern_id, 3);
+        assert_eq!(table.lookup(&long).unwrap().data_offset, None);
+        assert!(table.lookup(&long[1..]).is_none());
+    }
+}
@@ -53,12 +53,30 @@
 use crate::data_section::DataValue;
 use crate::error::ParaglobError;
 use crate::glob::MatchMode;
-use crate::mmdb_builder::MmdbBuilder;
+use crate::mmdb_builder::{hash_data, EntryType, MmdbBuilder};
+use rayon::prelude::*;
+use serde::de::{self, DeserializeSeed, IgnoredAny, MapAccess, SeqAccess, Visitor};
 use serde::{Deserialize, Deserializer, Serialize};
 use std::collections::HashMap;
+use std::fmt;
 use std::fs;
+use std::io::{self, BufReader, Read};
 use std::path::Path;
 
+/// Database type set by [`MispImporter::build_from_files`]
+pub const DATABASE_TYPE: &str = "MISP-ThreatIntel";
+
+/// English description set by [`MispImporter::build_from_files`]
+pub const DATABASE_DESCRIPTION: &str = "Threat intelligence database from MISP JSON feeds";
+
+/// Files up to this size are read whole and parsed from memory (faster);
+/// larger ones are parsed from a buffered reader, so a multi-gigabyte
+/// export never has to fit in memory as text
+const SLURP_LIMIT: u64 = 64 * 1024 * 1024;
+
+/// Bytes of an unparseable file checked for whether it looks like MISP JSON
+const SNIFF_BYTES: u64 = 1024 * 1024;
+
 /// Custom deserializer for value field that accepts strings, numbers, booleans, and null
 fn deserialize_value<'de, D>(deserializer: D) -> Result<String, D::Error>
 where
@@ -296,139 +314,121 @@ impl MispImporter {
 
     /// Build a database directly from files with streaming processing (low memory)
     ///
-    /// This processes files one at a time without loading all events into memory,
-    /// making it suitable for very large datasets. Files that don't contain valid
-    /// MISP events (like manifest.json) are skipped with a warning.
-    pub fn build_from_files<P: AsRef<Path>>(
+    /// Same as [`import_files`](Self::import_files) into a new builder
+    /// tagged with [`DATABASE_TYPE`] and [`DATABASE_DESCRIPTION`].
+    pub fn build_from_files<P: AsRef<Path> + Sync>(
         paths: &[P],
         match_mode: MatchMode,
         minimal_metadata: bool,
     ) -> Result<MmdbBuilder, ParaglobError> {
         let mut builder = MmdbBuilder::new(match_mode)
-            .with_database_type("MISP-ThreatIntel")
-            .with_description("en", "Threat intelligence database from MISP JSON feeds");
+            .with_database_type(DATABASE_TYPE)
+            .with_description("en", DATABASE_DESCRIPTION);
+        Self::import_files(paths, &mut builder, minimal_metadata)?;
+        Ok(builder)
+    }
 
+    /// Add the indicators of MISP JSON files to an existing builder
+    ///
+    /// Events are parsed one at a time and dropped once their indicators
+    /// are extracted, so memory is bounded by the builder and the largest
+    /// event rather than by the size of the feed. Files are parsed in
+    /// parallel, a few per thread at a time; each file's indicators are
+    /// classified and their metadata hashed on its parse thread, with each
+    /// distinct metadata record kept once, and merged into `builder` in
+    /// `paths` order.
+    ///
+    /// Each file may hold one event (`{"Event": {...}}`), a list of them,
+    /// or a REST search response (`{"response": [{"Event": {...}}, ...]}`).
+    /// Files that don't contain valid MISP events (like manifest.json) are
+    /// skipped with a warning.
+    ///
+    /// # Example
+    ///
+    /// ```rust,no_run
+    /// use matchy::glob::MatchMode;
+    /// use matchy::misp_importer::MispImporter;
+    /// use matchy::mmdb_builder::MmdbBuilder;
+    ///
+    /// let mut builder = MmdbBuilder::new(MatchMode::CaseInsensitive).with_prefilter(true);
+    /// let stats = MispImporter::import_files(&["feed/event1.json", "feed/event2.json"], &mut builder, false)?;
+    /// println!("{} events, {} attributes", stats.total_events, stats.total_attributes);
+    /// let bytes = builder.build()?;
+    /// # Ok::<(), Box<dyn std::error::Error>>(())
+    /// ```
+    pub fn import_files<P: AsRef<Path> + Sync>(
+        paths: &[P],
+        builder: &mut MmdbBuilder,
+        minimal_metadata: bool,
+    ) -> Result<ImportStats, ParaglobError> {
+        // Extraction only needs the importer for its helpers
+        let importer = Self { events: Vec::new() };
+        let mut stats = ImportStats::default();
         let mut skipped_files = Vec::new();
-        let mut processed_events = 0;
-
-        for path in paths {
-            let path_ref = path.as_ref();
-            let json = fs::read_to_string(path_ref).map_err(|e| {
-                ParaglobError::InvalidPattern(format!("Failed to read file: {}", e))
-            })?;
-
-            // Try to parse as MISP event document
-            match serde_json::from_str::<MispDocument>(&json) {
-                Ok(doc) => {
-                    // Process event immediately and drop it
-                    let temp_importer = Self {
-                        events: vec![doc.event],
-                    };
 
-                    for event in &temp_importer.events {
+        // Enough files in flight to keep every thread busy, without
+        // holding the indicators of the whole feed at once
+        let batch = rayon::current_num_threads().max(1) * 2;
+        for chunk in paths.chunks(batch) {
+            let parsed: Vec<_> = chunk
+                .par_iter()
+                .map(|path| {
+                    let mut indicators = FileIndicators::default();
+                    let skipped = read_events(path.as_ref(), &mut |event| {
+                        indicators.stats.add_event(&event);
                         if minimal_metadata {
-                            temp_importer.process_event_minimal(event, &mut builder)?;
+                            importer.process_event_minimal(&event, &mut indicators)
                         } else {
-                            temp_importer.process_event(event, &mut builder)?;
+                            importer.process_event(&event, &mut indicators)
                         }
-                    }
-                    processed_events += 1;
-                    // Event is dropped here, freeing memory
-                }
-                Err(e) => {
-                    // Check if it's a known non-event file
-                    let filename = path_ref
-                        .file_name()
-                        .and_then(|n| n.to_str())
-                        .unwrap_or("unknown");
-
-                    if filename == "manifest.json" || filename == "hashes.csv" {
-                        // Known metadata files - skip silently
-                        skipped_files.push((filename.to_string(), "metadata file".to_string()));
-                    } else if json.trim_start().starts_with('{') && json.contains("\"Event\"") {
-                        // Looks like it should be a MISP file but failed to parse - this is an error
-                        return Err(ParaglobError::InvalidPattern(format!(
-                            "Failed to parse MISP JSON in {}: {}",
-                            filename, e
-                        )));
-                    } else {
-                        // Doesn't look like a MISP event file - skip with warning
-                        skipped_files.push((filename.to_string(), "not a MISP event".to_string()));
+                    })?;
+                    Ok((indicators, skipped))
+                })
+                .collect::<Vec<Result<_, ParaglobError>>>();
+
+            for result in parsed {
+                let (indicators, skipped) = result?;
+                match skipped {
+                    Some(skip) => skipped_files.push(skip),
+                    None => {
+                        stats.merge(&indicators.stats);
+                        indicators.add_to(builder);
                     }
                 }
             }
         }
 
-        // Print warnings for skipped files
-        if !skipped_files.is_empty() {
-            eprintln!("Warning: Skipped {} non-MISP file(s):", skipped_files.len());
-            for (filename, reason) in &skipped_files {
-                eprintln!("  - {}: {}", filename, reason);
-            }
-        }
-
-        if processed_events == 0 {
+        warn_skipped(&skipped_files);
+        if stats.total_events == 0 {
             return Err(ParaglobError::InvalidPattern(
                 "No valid MISP events found in provided files".to_string(),
             ));
         }
 
-        Ok(builder)
+        Ok(stats)
     }
 
     /// Create importer from multiple MISP JSON files (loads all into memory)
     ///
-    /// Files that don't contain valid MISP events (like manifest.json) are skipped with a warning.
+    /// Accepts the same files as [`import_files`](Self::import_files);
+    /// files that don't contain valid MISP events (like manifest.json) are
+    /// skipped with a warning.
     ///
-    /// **Note:** For large datasets, use `build_from_files()` instead which streams
-    /// files one at a time without loading everything into memory.
+    /// **Note:** For large datasets, use `build_from_files()` or
+    /// `import_files()` instead, which stream events without keeping them.
     pub fn from_files<P: AsRef<Path>>(paths: &[P]) -> Result<Self, ParaglobError> {
         let mut events = Vec::new();
         let mut skipped_files = Vec::new();
 
         for path in paths {
-            let path_ref = path.as_ref();
-            let json = fs::read_to_string(path_ref).map_err(|e| {
-                ParaglobError::InvalidPattern(format!("Failed to read file: {}", e))
+            let skipped = read_events(path.as_ref(), &mut |event| {
+                events.push(event);
+                Ok(())
             })?;
-
-            // Try to parse as MISP event document
-            match serde_json::from_str::<MispDocument>(&json) {
-                Ok(doc) => {
-                    events.push(doc.event);
-                }
-                Err(e) => {
-                    // Check if it's a known non-event file
-                    let filename = path_ref
-                        .file_name()
-                        .and_then(|n| n.to_str())
-                        .unwrap_or("unknown");
-
-                    if filename == "manifest.json" || filename == "hashes.csv" {
-                        // Known metadata files - skip silently
-                        skipped_files.push((filename.to_string(), "metadata file".to_string()));
-                    } else if json.trim_start().starts_with('{') && json.contains("\"Event\"") {
-                        // Looks like it should be a MISP file but failed to parse - this is an error
-                        return Err(ParaglobError::InvalidPattern(format!(
-                            "Failed to parse MISP JSON in {}: {}",
-                            filename, e
-                        )));
-                    } else {
-                        // Doesn't look like a MISP event file - skip with warning
-                        skipped_files.push((filename.to_string(), "not a MISP event".to_string()));
-                    }
-                }
-            }
-        }
-
-        // Print warnings for skipped files
-        if !skipped_files.is_empty() {
-            eprintln!("Warning: Skipped {} non-MISP file(s):", skipped_files.len());
-            for (filename, reason) in &skipped_files {
-                eprintln!("  - {}: {}", filename, reason);
-            }
+            skipped_files.extend(skipped);
         }
 
+        warn_skipped(&skipped_files);
         if events.is_empty() {
             return Err(ParaglobError::InvalidPattern(
                 "No valid MISP events found in provided files".to_string(),
@@ -475,7 +475,7 @@ impl MispImporter {
     fn process_event_minimal(
         &self,
         event: &MispEvent,
-        builder: &mut MmdbBuilder,
+        builder: &mut impl IndicatorSink,
     ) -> Result<(), ParaglobError> {
         // Build minimal event metadata
         let mut event_metadata = HashMap::new();
@@ -574,7 +574,7 @@ impl MispImporter {
     fn process_event(
         &self,
         event: &MispEvent,
-        builder: &mut MmdbBuilder,
+        builder: &mut impl IndicatorSink,
     ) -> Result<(), ParaglobError> {
         // Build event-level metadata
         let event_metadata = self.build_event_metadata(event);
@@ -670,7 +670,7 @@ impl MispImporter {
         &self,
         attr: &MispAttribute,
         base_metadata: &HashMap<String, DataValue>,
-        builder: &mut MmdbBuilder,
+        builder: &mut impl IndicatorSink,
     ) -> Result<(), ParaglobError> {
         // Build metadata for this attribute
         let mut metadata = base_metadata.clone();
@@ -728,7 +728,7 @@ impl MispImporter {
         attr_type: &str,
         value: &str,
         metadata: HashMap<String, DataValue>,
-        builder: &mut MmdbBuilder,
+        builder: &mut impl IndicatorSink,
     ) -> Result<(), ParaglobError> {
         // Skip empty values (from null or missing data)
         if value.trim().is_empty() {
@@ -922,13 +922,7 @@ impl MispImporter {
         let mut stats = ImportStats::default();
 
         for event in &self.events {
-            stats.total_events += 1;
-            stats.total_attributes += event.attributes.len();
-
-            for obj in &event.objects {
-                stats.total_objects += 1;
-                stats.total_attributes += obj.attributes.len();
-            }
+            stats.add_event(event);
         }
 
         stats
@@ -946,6 +940,315 @@ pub struct ImportStats {
     pub total_objects: usize,
 }
 
+impl ImportStats {
+    /// Count one event with its attributes and objects
+    fn add_event(&mut self, event: &MispEvent) {
+        self.total_events += 1;
+        self.total_attributes += event.attributes.len();
+
+        for obj in &event.objects {
+            self.total_objects += 1;
+            self.total_attributes += obj.attributes.len();
+        }
+    }
+
+    /// Add another file's counts
+    fn merge(&mut self, other: &ImportStats) {
+        self.total_events += other.total_events;
+        self.total_attributes += other.total_attributes;
+        self.total_objects += other.total_objects;
+    }
+}
+
+/// Where extracted indicators go
+trait IndicatorSink {
+    fn add_ip(
+        &mut self,
+        ip_or_cidr: &str,
+        metadata: HashMap<String, DataValue>,
+    ) -> Result<(), ParaglobError>;
+
+    fn add_literal(
+        &mut self,
+        literal: &str,
+        metadata: HashMap<String, DataValue>,
+    ) -> Result<(), ParaglobError>;
+}
+
+impl IndicatorSink for MmdbBuilder {
+    fn add_ip(
+        &mut self,
+        ip_or_cidr: &str,
+        metadata: HashMap<String, DataValue>,
+    ) -> Result<(), ParaglobError> {
+        MmdbBuilder::add_ip(self, ip_or_cidr, metadata)
+    }
+
+    fn add_literal(
+        &mut self,
+        literal: &str,
+        metadata: HashMap<String, DataValue>,
+    ) -> Result<(), ParaglobError> {
+        MmdbBuilder::add_literal(self, literal, metadata)
+    }
+}
+
+/// One file's indicators, classified and hashed off the builder
+#[derive(Default)]
+struct FileIndicators {
+    /// Entries in extraction order, with the hash of their metadata
+    entries: Vec<(EntryType, u64)>,
+    /// Each distinct metadata record once, by hash
+    records: HashMap<u64, DataValue>,
+    stats: ImportStats,
+}
+
+impl FileIndicators {
+    fn push(&mut self, entry_type: EntryType, metadata: HashMap<String, DataValue>) {
+        let data = DataValue::Map(metadata);
+        let hash = hash_data(&data);
+        self.records.entry(hash).or_insert(data);
+        self.entries.push((entry_type, hash));
+    }
+
+    /// Add the entries to `builder` as if extracted into it directly
+    fn add_to(self, builder: &mut MmdbBuilder) {
+        for (entry_type, hash) in self.entries {
+            builder.add_hashed(entry_type, hash, &self.records[&hash]);
+        }
+    }
+}
+
+impl IndicatorSink for FileIndicators {
+    fn add_ip(
+        &mut self,
+        ip_or_cidr: &str,
+        metadata: HashMap<String, DataValue>,
+    ) -> Result<(), ParaglobError> {
+        let entry_type = MmdbBuilder::parse_ip_entry(ip_or_cidr)?;
+        self.push(entry_type, metadata);
+        Ok(())
+    }
+
+    fn add_literal(
+        &mut self,
+        literal: &str,
+        metadata: HashMap<String, DataValue>,
+    ) -> Result<(), ParaglobError> {
+        self.push(EntryType::Literal(literal.to_string()), metadata);
+        Ok(())
+    }
+}
+
+/// Callback handed each event of a file as it is parsed
+type EventFn<'f> = dyn FnMut(MispEvent) -> Result<(), ParaglobError> + 'f;
+
+/// Stream the events of one MISP JSON file into `on_event`
+///
+/// Returns the file name and reason for files skipped as not holding MISP
+/// events. A file that looks like MISP JSON but fails to parse is an
+/// error, as is any error from `on_event`.
+fn read_events(
+    path: &Path,
+    on_event: &mut EventFn<'_>,
+) -> Result<Option<(String, String)>, ParaglobError> {
+    let read_error =
+        |e: io::Error| ParaglobError::InvalidPattern(format!("Failed to read file: {}", e));
+    let file = fs::File::open(path).map_err(read_error)?;
+    let size = file.metadata().map_err(read_error)?.len();
+
+    let mut events = Events {
+        on_event,
+        count: 0,
+        failed: None,
+    };
+    let parsed = if size <= SLURP_LIMIT {
+        let mut json = Vec::with_capacity(size as usize);
+        BufReader::new(file)
+            .read_to_end(&mut json)
+            .map_err(read_error)?;
+        stream_events(
+            &mut serde_json::Deserializer::from_slice(&json),
+            &mut events,
+        )
+    } else {
+        let reader = BufReader::with_capacity(1024 * 1024, file);
+        stream_events(
+            &mut serde_json::Deserializer::from_reader(reader),
+            &mut events,
+        )
+    };
+    if let Some(e) = events.failed {
+        return Err(e);
+    }
+
+    let filename = path
+        .file_name()
+        .and_then(|n| n.to_str())
+        .unwrap_or("unknown")
+        .to_string();
+    match parsed {
+        Ok(()) if events.count > 0 => Ok(None),
+        Ok(()) => Ok(Some((filename, "not a MISP event".to_string()))),
+        Err(e) => {
+            if filename == "manifest.json" || filename == "hashes.csv" {
+                // Known metadata files - skip silently
+                Ok(Some((filename, "metadata file".to_string())))
+            } else if events.count > 0 || looks_like_misp(path) {
+                // Looks like it should be a MISP file but failed to parse - this is an error
+                Err(ParaglobError::InvalidPattern(format!(
+                    "Failed to parse MISP JSON in {}: {}",
+                    filename, e
+                )))
+            } else {
+                // Doesn't look like a MISP event file - skip with warning
+                Ok(Some((filename, "not a MISP event".to_string())))
+            }
+        }
+    }
+}
+
+/// Parse a whole file, handing each event to `events` as it completes
+fn stream_events<'de, R: serde_json::de::Read<'de>>(
+    deserializer: &mut serde_json::Deserializer<R>,
+    events: &mut Events<'_>,
+) -> Result<(), serde_json::Error> {
+    Document {
+        events,
+        top_level: true,
+    }
+    .deserialize(&mut *deserializer)?;
+    deserializer.end()
+}
+
+/// Whether the start of a file that failed to parse looks like MISP JSON
+fn looks_like_misp(path: &Path) -> bool {
+    let mut start = Vec::new();
+    let read = fs::File::open(path).and_then(|file| file.take(SNIFF_BYTES).read_to_end(&mut start));
+    if read.is_err() {
+        return false;
+    }
+    let text = String::from_utf8_lossy(&start);
+    let trimmed = text.trim_start();
+    (trimmed.starts_with('{') || trimmed.starts_with('[')) && trimmed.contains("\"Event\"")
+}
+
+/// Print warnings for skipped files
+fn warn_skipped(skipped_files: &[(String, String)]) {
+    if !skipped_files.is_empty() {
+        eprintln!("Warning: Skipped {} non-MISP file(s):", skipped_files.len());
+        for (filename, reason) in skipped_files {
+            eprintln!("  - {}: {}", filename, reason);
+        }
+    }
+}
+
+/// Sink state while a file's events are deserialized
+struct Events<'a> {
+    on_event: &'a mut EventFn<'a>,
+    count: usize,
+    /// Error returned by `on_event`, which stopped the parse
+    failed: Option<ParaglobError>,
+}
+
+impl Events<'_> {
+    fn emit<E: de::Error>(&mut self, event: MispEvent) -> Result<(), E> {
+        self.count += 1;
+        (self.on_event)(event).map_err(|e| {
+            let message = e.to_string();
+            self.failed = Some(e);
+            E::custom(message)
+        })
+    }
+}
+
+/// A `{"Event": {...}}` document; at the top level also a list of them
+/// or a `{"response": [...]}` search result
+struct Document<'e, 'a> {
+    events: &'e mut Events<'a>,
+    top_level: bool,
+}
+
+impl<'de> DeserializeSeed<'de> for Document<'_, '_> {
+    type Value = ();
+
+    fn deserialize<D: Deserializer<'de>>(self, deserializer: D) -> Result<(), D::Error> {
+        if self.top_level {
+            deserializer.deserialize_any(self)
+        } else {
+            deserializer.deserialize_map(self)
+        }
+    }
+}
+
+impl<'de> Visitor<'de> for Document<'_, '_> {
+    type Value = ();
+
+    fn expecting(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        f.write_str("a MISP event document")
+    }
+
+    fn visit_map<A: MapAccess<'de>>(self, mut map: A) -> Result<(), A::Error> {
+        while let Some(key) = map.next_key::<String>()? {
+            match key.as_str() {
+                "Event" => {
+                    let event = map.next_value::<MispEvent>()?;
+                    self.events.emit(event)?;
+                }
+                "response" if self.top_level => map.next_value_seed(DocumentList {
+                    events: &mut *self.events,
+                })?,
+                _ => {
+                    map.next_value::<IgnoredAny>()?;
+                }
+            }
+        }
+        Ok(())
+    }
+
+    fn visit_seq<A: SeqAccess<'de>>(self, seq: A) -> Result<(), A::Error> {
+        if !self.top_level {
+            return Err(de::Error::invalid_type(de::Unexpected::Seq, &self));
+        }
+        DocumentList {
+            events: self.events,
+        }
+        .visit_seq(seq)
+    }
+}
+
+/// A list of `{"Event": {...}}` documents
+struct DocumentList<'e, 'a> {
+    events: &'e mut Events<'a>,
+}
+
+impl<'de> DeserializeSeed<'de> for DocumentList<'_, '_> {
+    type Value = ();
+
+    fn deserialize<D: Deserializer<'de>>(self, deserializer: D) -> Result<(), D::Error> {
+        deserializer.deserialize_seq(self)
+    }
+}
+
+impl<'de> Visitor<'de> for DocumentList<'_, '_> {
+    type Value = ();
+
+    fn expecting(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        f.write_str("a list of MISP event documents")
+    }
+
+    fn visit_seq<A: SeqAccess<'de>>(self, mut seq: A) -> Result<(), A::Error> {
+        while seq
+            .next_element_seed(Document {
+                events: &mut *self.events,
+                top_level: false,
+            })?
+            .is_some()
+        {}
+        Ok(())
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -993,4 +1296,143 @@ mod tests {
         assert_eq!(importer.events.len(), 1);
         assert_eq!(importer.events[0].attributes.len(), 1);
     }
+
+    /// Result with its maps' entries in key order, for comparison
+    fn sorted(result: crate::QueryResult) -> Vec<Vec<(String, String)>> {
+        let records = match result {
+            crate::QueryResult::Ip { data, .. } => vec![Some(data)],
+            crate::QueryResult::Pattern { data, .. } => data,
+            crate::QueryResult::NotFound => Vec::new(),
+        };
+        records
+            .into_iter()
+            .map(|record| match record {
+                Some(DataValue::Map(map)) => {
+                    let mut fields: Vec<_> = map
+                        .into_iter()
+                        .map(|(k, v)| (k, format!("{:?}", v)))
+                        .collect();
+                    fields.sort();
+                    fields
+                }
+                other => vec![(String::new(), format!("{:?}", other))],
+            })
+            .collect()
+    }
+
+    fn event_json(uuid: &str, tags: &str, domain: &str) -> String {
+        format!(
+            r#"{{"uuid": "{uuid}", "info": "Event {uuid}", "threat_level_id": "1",
+                "Attribute": [
+                    {{"type": "domain", "value": "{domain}", "category": "Network activity"}},
+                    {{"type": "ip-dst", "value": "10.0.0.{n}", "to_ids": true}},
+                    {{"type": "url", "value": "http://{domain}/x", "Tag": [{{"name": "tlp:red"}}]}}
+                ],
+                "Object": [{{"name": "file", "Attribute": [
+                    {{"type": "md5", "value": "{uuid}00000000000000000000000000"}}
+                ]}}],
+                "Tag": [{tags}]}}"#,
+            n = uuid.len()
+        )
+    }
+
+    #[test]
+    fn test_import_files_streams_all_layouts() {
+        let dir = tempfile::tempdir().unwrap();
+        let single = dir.path().join("single.json");
+        fs::write(
+            &single,
+            format!(
+                r#"{{"Event": {}}}"#,
+                event_json("a", r#"{"name": "apt"}"#, "one.example")
+            ),
+        )
+        .unwrap();
+        let response = dir.path().join("response.json");
+        fs::write(
+            &response,
+            format!(
+                r#"{{"response": [{{"Event": {}}}, {{"Event": {}}}]}}"#,
+                event_json("bb", "", "two.example"),
+                event_json("ccc", r#"{"name": "apt"}"#, "three.example")
+            ),
+        )
+        .unwrap();
+        let list = dir.path().join("list.json");
+        fs::write(
+            &list,
+            format!(
+                r#"[{{"Event": {}}}]"#,
+                event_json("dddd", "", "four.example")
+            ),
+        )
+        .unwrap();
+        let manifest = dir.path().join("manifest.json");
+        fs::write(&manifest, r#"{"uuid": {"info": "not an event"}}"#).unwrap();
+
+        let paths = [&single, &response, &manifest, &list];
+        for minimal in [false, true] {
+            let mut builder = MmdbBuilder::new(MatchMode::CaseSensitive);
+            let stats = MispImporter::import_files(&paths, &mut builder, minimal).unwrap();
+            assert_eq!(stats.total_events, 4);
+            assert_eq!(stats.total_objects, 4);
+            assert_eq!(stats.total_attributes, 16);
+
+            // Same entries and data as extracting from fully loaded events
+            let expected = MispImporter::from_files(&paths)
+                .unwrap()
+                .build_database_with_options(MatchMode::CaseSensitive, minimal)
+                .unwrap();
+            assert_eq!(builder.stats().total_entries, 20);
+            assert_eq!(builder.stats().ip_entries, expected.stats().ip_entries);
+            assert_eq!(
+                builder.stats().literal_entries,
+                expected.stats().literal_entries
+            );
+            let streamed = crate::Database::from_bytes(builder.build().unwrap()).unwrap();
+            let loaded = crate::Database::from_bytes(expected.build().unwrap()).unwrap();
+            for query in [
+                "one.example",
+                "http://three.example/x",
+                "10.0.0.2",
+                "dddd00000000000000000000000000",
+                "missing.example",
+            ] {
+                assert_eq!(
+                    format!("{:?}", streamed.lookup(query).unwrap().map(sorted)),
+                    format!("{:?}", loaded.lookup(query).unwrap().map(sorted)),
+                    "{}",
+                    query
+                );
+            }
+        }
+
+        let builder =
+            MispImporter::build_from_files(&paths, MatchMode::CaseSensitive, false).unwrap();
+        let db = crate::Database::from_bytes(builder.build().unwrap()).unwrap();
+        assert!(matches!(
+            db.lookup("three.example").unwrap(),
+            Some(crate::QueryResult::Pattern { .. })
+        ));
+        assert!(matches!(
+            db.lookup("10.0.0.4").unwrap(),
+            Some(crate::QueryResult::Ip { .. })
+        ));
+    }
+
+    #[test]
+    fn test_import_files_rejects_broken_event() {
+        let dir = tempfile::tempdir().unwrap();
+        let broken = dir.path().join("broken.json");
+        fs::write(&broken, r#"{"Event": {"Attribute": [{"type": "domain""#).unwrap();
+        let other = dir.path().join("notes.json");
+        fs::write(&other, r#"{"unrelated": true}"#).unwrap();
+
+        let mut builder = MmdbBuilder::new(MatchMode::CaseSensitive);
+        let err = MispImporter::import_files(&[&broken], &mut builder, false).unwrap_err();
+        assert!(err.to_string().contains("broken.json"));
+
+        // Nothing but non-MISP files
+        assert!(MispImporter::import_files(&[&other], &mut builder, false).is_err());
+    }
 }
@@ -25,12 +25,13 @@
 //! # Ok::<(), matchy::mmap::MmapError>(())
 //! ```
 
-use crate::offset_format::{ParaglobHeader, MAGIC, VERSION};
+use crate::offset_format::{ParaglobHeader, MAGIC, VERSION, VERSION_V5};
 use memmap2::Mmap;
 use std::fmt;
 use std::fs::File;
 use std::io;
 use std::mem;
+use std::ops::Range;
 use std::path::Path;
 
 /// Validate a Paraglob header from a buffer
@@ -57,10 +58,10 @@ fn validate_paraglob_header(buffer: &[u8]) -> Result<&ParaglobHeader, String> {
     }
 
     // Check version
-    if header.version != VERSION {
+    if header.version != VERSION && header.version != VERSION_V5 {
         return Err(format!(
-            "Unsupported format version: found {}, supported {}",
-            header.version, VERSION
+            "Unsupported format version: found {}, supported {} and {}",
+            header.version, VERSION, VERSION_V5
         ));
     }
 
@@ -206,8 +207,7 @@ impl MmapFile {
         // Linux-specific: request transparent huge pages (2MB)
         #[cfg(target_os = "linux")]
         {
-            const MADV_HUGEPAGE: libc::c_int = 14;
-            madvise(ptr, size, MADV_HUGEPAGE);
+            madvise(ptr, size, libc::MADV_HUGEPAGE);
         }
 
         // FreeBSD: Supports MADV_NOSYNC for better performance with mmap
@@ -271,6 +271,93 @@ impl MmapFile {
     }
 }
 
+/// Page-aligned address and length of `range` within a mapping, for
+/// `madvise` and `mlock` (None when empty or `data` is not page-aligned)
+#[cfg(unix)]
+fn page_range(data: &[u8], range: Range<usize>) -> Option<(*mut libc::c_void, usize)> {
+    let page = page_size();
+    let end = range.end.min(data.len());
+    // Mappings are page-aligned, so rounding the offset keeps the address aligned
+    let start = range.start & !(page - 1);
+    if start >= end || data.as_ptr() as usize % page != 0 {
+        return None;
+    }
+    let ptr = unsafe { data.as_ptr().add(start) } as *mut libc::c_void;
+    Some((ptr, end - start))
+}
+
+/// System page size in bytes
+fn page_size() -> usize {
+    #[cfg(unix)]
+    {
+        let size = unsafe { libc::sysconf(libc::_SC_PAGESIZE) };
+        if size > 0 {
+            return size as usize;
+        }
+    }
+    4096
+}
+
+/// Start reading `range` of a mapping into the page cache in the background
+///
+/// A hint only: `data` must come from a file mapping, and errors are ignored.
+pub(crate) fn advise_willneed(data: &[u8], range: Range<usize>) {
+    #[cfg(unix)]
+    {
+        if let Some((ptr, len)) = page_range(data, range) {
+            unsafe {
+                libc::madvise(ptr, len, libc::MADV_WILLNEED);
+            }
+        }
+    }
+    #[cfg(not(unix))]
+    let _ = (data, range);
+}
+
+/// Fault in every page of `range` now, so later reads don't
+pub(crate) fn touch_pages(data: &[u8], range: Range<usize>) {
+    let end = range.end.min(data.len());
+    let mut sum = 0u8;
+    for offset in (range.start..end).step_by(page_size()) {
+        sum = sum.wrapping_add(data[offset]);
+    }
+    std::hint::black_box(sum);
+}
+
+/// Ask for transparent huge pages over the whole mapping
+///
+/// Linux only (a no-op elsewhere); file-backed huge pages also need
+/// kernel support, so this is a hint and errors are ignored.
+pub(crate) fn advise_huge_pages(data: &[u8]) {
+    #[cfg(target_os = "linux")]
+    {
+        if let Some((ptr, len)) = page_range(data, 0..data.len()) {
+            unsafe {
+                libc::madvise(ptr, len, libc::MADV_HUGEPAGE);
+            }
+        }
+    }
+    #[cfg(not(target_os = "linux"))]
+    let _ = data;
+}
+
+/// Lock a mapping's pages in RAM (faulting them all in)
+///
+/// Usually needs `CAP_IPC_LOCK` or a large enough `RLIMIT_MEMLOCK`.
+pub(crate) fn lock_pages(data: &[u8]) -> io::Result<()> {
+    #[cfg(unix)]
+    {
+        if let Some((ptr, len)) = page_range(data, 0..data.len()) {
+            if unsafe { libc::mlock(ptr, len) } != 0 {
+                return Err(io::Error::last_os_error());
+            }
+        }
+    }
+    #[cfg(not(unix))]
+    let _ = data;
+    Ok(())
+}
+
 impl fmt::Debug for MmapFile {
     fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
         f.debug_struct("MmapFile")
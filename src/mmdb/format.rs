@@ -9,13 +9,14 @@
 //! - Tree traversal works with pure offsets (zero allocation)
 //! - Data decoding only allocates when returning results to users
 
+use super::tree::SearchTree;
 use super::types::{IpVersion, MmdbError, RecordSize, METADATA_MARKER};
 use crate::data_section::{DataDecoder, DataValue};
 
 /// MMDB file header - minimal heap usage
 ///
 /// Contains only the essential information needed for IP lookups.
-/// Total heap usage: ~16 bytes.
+/// Total heap usage: ~24 bytes.
 #[derive(Debug, Clone, Copy)]
 pub struct MmdbHeader {
     /// Number of nodes in the search tree
@@ -26,6 +27,11 @@ pub struct MmdbHeader {
     pub ip_version: IpVersion,
     /// Size of the search tree in bytes
     pub tree_size: usize,
+    /// Node where IPv4 lookups start
+    ///
+    /// The root for IPv4 trees; for IPv6 trees the node reached after the
+    /// 96 zero bits leading to the IPv4 subtree, resolved once at parse time.
+    pub ipv4_start_node: u32,
 }
 
 impl MmdbHeader {
@@ -78,12 +84,28 @@ impl MmdbHeader {
         // Calculate tree size
         let tree_size = (node_count as usize) * record_size.node_bytes();
 
-        Ok(MmdbHeader {
+        let mut header = MmdbHeader {
             node_count: node_count as u32,
             record_size,
             ip_version,
             tree_size,
-        })
+            ipv4_start_node: 0,
+        };
+        header.resolve_ipv4_start_node(data)?;
+        Ok(header)
+    }
+
+    /// Compute `ipv4_start_node` from the tree in `data`
+    ///
+    /// Done by [`from_file`](Self::from_file); only needed for headers
+    /// assembled by hand.
+    pub fn resolve_ipv4_start_node(&mut self, data: &[u8]) -> Result<(), MmdbError> {
+        let start_node = match self.ip_version {
+            IpVersion::V4 => 0,
+            IpVersion::V6 => SearchTree::new(data, self).find_ipv4_start_node()?,
+        };
+        self.ipv4_start_node = start_node;
+        Ok(())
     }
 }
 
@@ -149,6 +171,46 @@ pub fn find_metadata_marker(data: &[u8]) -> Result<usize, MmdbError> {
     last_marker.ok_or(MmdbError::MetadataNotFound)
 }
 
+/// Metadata key of the checksum verified by trusted opens
+pub const HEADER_CHECKSUM_KEY: &str = "header_checksum";
+
+/// Metadata keys of the sections covered by the header checksum
+const CHECKSUMMED_SECTION_KEYS: [&str; 4] = [
+    "pattern_section_offset",
+    "literal_section_offset",
+    "ip_stride_section_offset",
+    "prefilter_section_offset",
+];
+
+/// Bytes hashed from the start of each section (one page)
+const HEADER_CHECKSUM_SPAN: usize = 4096;
+
+/// Checksum over the layout of a database file
+///
+/// `body` is the file up to its metadata marker and `metadata` the decoded
+/// metadata map. Hashes the body length and the first page of the search
+/// tree and of every section listed in the metadata, where their headers
+/// and offset tables live. Reading it costs a few pages, so trusted opens
+/// can detect truncated or mismatched files without reading them whole.
+pub fn header_checksum(
+    body: &[u8],
+    metadata: &std::collections::HashMap<String, DataValue>,
+) -> u64 {
+    let mut hasher = xxhash_rust::xxh64::Xxh64::new(0);
+    hasher.update(&(body.len() as u64).to_le_bytes());
+    let sections = CHECKSUMMED_SECTION_KEYS
+        .iter()
+        .filter_map(|key| match metadata.get(*key) {
+            Some(DataValue::Uint32(offset)) if *offset > 0 => Some(*offset as usize),
+            _ => None,
+        });
+    for offset in std::iter::once(0).chain(sections) {
+        let start = body.get(offset..).unwrap_or_default();
+        hasher.update(&start[..start.len().min(HEADER_CHECKSUM_SPAN)]);
+    }
+    hasher.digest()
+}
+
 // Helper functions to extract values from metadata map (temporary during parsing)
 
 fn extract_uint(
@@ -12,16 +12,21 @@
 //! - **types**: MMDB-specific types and constants
 //! - **format**: Binary format parsing and metadata extraction
 //! - **tree**: Search tree traversal for IP lookups
+//! - **stride**: Optional multi-bit copy of the tree for faster lookups
 //! - **metadata**: Metadata parsing
 //!
 //! Data decoding reuses `crate::data_section::DataDecoder` since
 //! MMDB data format is what we already implemented for v2.
 
 pub mod format;
+pub mod stride;
 pub mod tree;
 pub mod types;
 
 // Re-export key types
-pub use format::{find_metadata_marker, MmdbHeader, MmdbMetadata};
-pub use tree::SearchTree;
+pub use format::{
+    find_metadata_marker, header_checksum, MmdbHeader, MmdbMetadata, HEADER_CHECKSUM_KEY,
+};
+pub use stride::{StrideHeader, StrideIndex};
+pub use tree::{Ipv4DirectIndex, LookupResult, SearchTree};
 pub use types::MmdbError;
@@ -0,0 +1,352 @@
+//! Multi-bit Stride Index for IP Lookups
+//!
+//! An optional copy of the search tree that consumes four address bits per
+//! step instead of one. Each stride node holds sixteen entries of four
+//! bytes, so a node is exactly one 64-byte cache line: an IPv4 lookup
+//! touches at most 8 lines instead of up to 32 binary nodes, and an IPv6
+//! lookup at most 32 instead of 128.
+//!
+//! The index is written by `IpTreeBuilder::build_stride_index` after the
+//! other sections and found through the `ip_stride_section_offset` metadata
+//! key. The standard MMDB tree is always present as well, so readers that
+//! don't know about the index (including libmaxminddb) are unaffected.
+//!
+//! ## Layout
+//!
+//! ```text
+//! [magic "IPST"][version u32][node_count u32][ipv4_root u32][reserved 48 bytes]
+//! [node 0: 16 x u32][node 1: 16 x u32]...
+//! ```
+//!
+//! All integers are little-endian and the section starts 64-byte aligned.
+//! Each entry is one of:
+//! - `DATA_FLAG` set: a data record. Bits 29-30 hold the bit within the
+//!   stride where the binary tree reached it (0-3), bits 0-28 its data offset
+//! - `EMPTY_ENTRY`: no data for this address
+//! - anything else: index of the child stride node
+
+use super::format::MmdbHeader;
+use super::tree::{LookupResult, BATCH_LANES};
+use super::types::MmdbError;
+use std::net::{IpAddr, Ipv4Addr, Ipv6Addr};
+
+/// Magic bytes at the start of the stride section
+pub const STRIDE_MAGIC: &[u8; 4] = b"IPST";
+
+/// Current stride section format version
+pub const STRIDE_VERSION: u32 = 1;
+
+/// Separator written before the section (same convention as `MMDB_LITERAL`)
+pub const STRIDE_SEPARATOR: &[u8; 16] = b"MMDB_IPSTRIDE\x00\x00\x00";
+
+/// Address bits consumed per stride node
+pub const STRIDE_BITS: u32 = 4;
+
+/// Entries per stride node
+pub const STRIDE_FANOUT: usize = 1 << STRIDE_BITS;
+
+/// Size of the section header, and of each node
+pub const STRIDE_NODE_BYTES: usize = STRIDE_FANOUT * 4;
+
+/// Entry flag marking a data record
+pub const DATA_FLAG: u32 = 0x8000_0000;
+
+/// Entry value for "not found"
+pub const EMPTY_ENTRY: u32 = 0x7FFF_FFFF;
+
+/// Largest data offset an entry can hold (29 bits)
+pub const MAX_DATA_OFFSET: u32 = (1 << 29) - 1;
+
+/// Encode a data entry, or `None` if the offset doesn't fit
+pub fn data_entry(data_offset: u32, depth: u32) -> Option<u32> {
+    if data_offset > MAX_DATA_OFFSET || depth >= STRIDE_BITS {
+        return None;
+    }
+    Some(DATA_FLAG | (depth << 29) | data_offset)
+}
+
+/// Serialize stride nodes into a complete section (header + nodes)
+pub fn write_section(nodes: &[[u32; STRIDE_FANOUT]], ipv4_root: u32) -> Vec<u8> {
+    let mut section = Vec::with_capacity(STRIDE_NODE_BYTES * (nodes.len() + 1));
+    section.extend_from_slice(STRIDE_MAGIC);
+    section.extend_from_slice(&STRIDE_VERSION.to_le_bytes());
+    section.extend_from_slice(&(nodes.len() as u32).to_le_bytes());
+    section.extend_from_slice(&ipv4_root.to_le_bytes());
+    section.resize(STRIDE_NODE_BYTES, 0);
+
+    for node in nodes {
+        for entry in node {
+            section.extend_from_slice(&entry.to_le_bytes());
+        }
+    }
+    section
+}
+
+/// Parsed stride section header
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct StrideHeader {
+    /// File offset of the first stride node
+    pub nodes_offset: usize,
+    /// Number of stride nodes
+    pub node_count: u32,
+    /// Node where IPv4 lookups start (node 0 for IPv4 trees)
+    pub ipv4_root: u32,
+}
+
+impl StrideHeader {
+    /// Parse the stride section starting at `offset` in the file
+    ///
+    /// Checks that every node lies inside `data`; entries are bounds-checked
+    /// again as lookups follow them.
+    pub fn from_section(data: &[u8], offset: usize) -> Result<Self, MmdbError> {
+        let header = data
+            .get(offset..offset + STRIDE_NODE_BYTES)
+            .ok_or_else(|| {
+                MmdbError::InvalidFormat(format!(
+                    "Stride section offset {} exceeds file size {}",
+                    offset,
+                    data.len()
+                ))
+            })?;
+
+        if &header[0..4] != STRIDE_MAGIC {
+            return Err(MmdbError::InvalidFormat(
+                "Stride section has invalid magic".to_string(),
+            ));
+        }
+
+        let read_u32 = |at: usize| u32::from_le_bytes(header[at..at + 4].try_into().unwrap());
+        let version = read_u32(4);
+        if version != STRIDE_VERSION {
+            return Err(MmdbError::InvalidFormat(format!(
+                "Unsupported stride section version {}",
+                version
+            )));
+        }
+
+        let node_count = read_u32(8);
+        let ipv4_root = read_u32(12);
+        let nodes_offset = offset + STRIDE_NODE_BYTES;
+        let nodes_end = (node_count as usize)
+            .checked_mul(STRIDE_NODE_BYTES)
+            .and_then(|size| size.checked_add(nodes_offset));
+
+        if node_count == 0
+            || ipv4_root >= node_count
+            || nodes_end.is_none_or(|end| end > data.len())
+        {
+            return Err(MmdbError::InvalidFormat(format!(
+                "Stride section with {} nodes (IPv4 root {}) does not fit the file",
+                node_count, ipv4_root
+            )));
+        }
+
+        Ok(Self {
+            nodes_offset,
+            node_count,
+            ipv4_root,
+        })
+    }
+}
+
+/// In-flight state of one batched stride lookup
+#[derive(Clone, Copy)]
+struct Lane {
+    /// Position of this address in the caller's slice
+    index: usize,
+    /// Current stride node
+    node: u32,
+    /// Remaining address bits, next nibble in the top position
+    bits: u128,
+    /// Address bits left to consume
+    remaining: u8,
+    /// Address bits consumed by completed strides
+    consumed: u8,
+}
+
+/// Stride index over a database file
+///
+/// Returns exactly what [`SearchTree`](super::SearchTree) returns for the
+/// same address, including the prefix length.
+pub struct StrideIndex<'a> {
+    /// The raw file data containing the section
+    data: &'a [u8],
+    /// Parsed section header
+    header: &'a StrideHeader,
+}
+
+impl<'a> StrideIndex<'a> {
+    /// Create a stride index view
+    pub fn new(data: &'a [u8], header: &'a StrideHeader) -> Self {
+        Self { data, header }
+    }
+
+    /// Look up an IP address
+    pub fn lookup(&self, ip: IpAddr) -> Result<Option<LookupResult>, MmdbError> {
+        let lane = self.start_lane(0, ip);
+        self.walk(lane)
+    }
+
+    /// Look up many IP addresses with interleaved traversal
+    ///
+    /// Same contract as [`SearchTree::lookup_batch`](super::SearchTree::lookup_batch):
+    /// `results` is cleared and filled with one entry per address.
+    pub fn lookup_batch(
+        &self,
+        addrs: &[IpAddr],
+        results: &mut Vec<Result<Option<LookupResult>, MmdbError>>,
+    ) {
+        results.clear();
+        results.resize_with(addrs.len(), || Ok(None));
+
+        for (chunk_index, chunk) in addrs.chunks(BATCH_LANES).enumerate() {
+            let mut lanes = [Lane {
+                index: 0,
+                node: 0,
+                bits: 0,
+                remaining: 0,
+                consumed: 0,
+            }; BATCH_LANES];
+            let mut active = 0;
+
+            for (offset, addr) in chunk.iter().enumerate() {
+                lanes[active] = self.start_lane(chunk_index * BATCH_LANES + offset, *addr);
+                self.prefetch_node(lanes[active].node);
+                active += 1;
+            }
+
+            // Round-robin over live lanes; finished lanes are swap-removed
+            while active > 0 {
+                let mut i = 0;
+                while i < active {
+                    match self.step_lane(&mut lanes[i]) {
+                        None => {
+                            self.prefetch_node(lanes[i].node);
+                            i += 1;
+                        }
+                        Some(result) => {
+                            results[lanes[i].index] = result;
+                            active -= 1;
+                            lanes[i] = lanes[active];
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /// Initial lane for an address
+    fn start_lane(&self, index: usize, ip: IpAddr) -> Lane {
+        match ip {
+            IpAddr::V4(v4) => Lane {
+                index,
+                node: self.header.ipv4_root,
+                bits: (u32::from(v4) as u128) << 96,
+                remaining: 32,
+                consumed: 0,
+            },
+            IpAddr::V6(v6) => Lane {
+                index,
+                node: 0,
+                bits: u128::from(v6),
+                remaining: 128,
+                consumed: 0,
+            },
+        }
+    }
+
+    /// Run a single lookup to completion
+    fn walk(&self, mut lane: Lane) -> Result<Option<LookupResult>, MmdbError> {
+        loop {
+            if let Some(result) = self.step_lane(&mut lane) {
+                return result;
+            }
+        }
+    }
+
+    /// Advance a lookup by one stride
+    ///
+    /// Returns `None` while the lookup is still descending, or its final result.
+    #[inline]
+    fn step_lane(&self, lane: &mut Lane) -> Option<Result<Option<LookupResult>, MmdbError>> {
+        if lane.remaining == 0 {
+            return Some(Ok(None));
+        }
+
+        let nibble = (lane.bits >> (128 - STRIDE_BITS)) as usize;
+        let entry = match self.read_entry(lane.node, nibble) {
+            Ok(e) => e,
+            Err(e) => return Some(Err(e)),
+        };
+
+        if entry & DATA_FLAG != 0 {
+            let depth = ((entry >> 29) & 0x3) as u8;
+            return Some(Ok(Some(LookupResult {
+                data_offset: entry & MAX_DATA_OFFSET,
+                prefix_len: lane.consumed + depth + 1,
+            })));
+        }
+        if entry == EMPTY_ENTRY {
+            return Some(Ok(None));
+        }
+
+        lane.node = entry;
+        lane.bits <<= STRIDE_BITS;
+        lane.remaining -= STRIDE_BITS as u8;
+        lane.consumed += STRIDE_BITS as u8;
+        None
+    }
+
+    /// Read one entry of a stride node
+    #[inline]
+    fn read_entry(&self, node: u32, nibble: usize) -> Result<u32, MmdbError> {
+        if node >= self.header.node_count {
+            return Err(MmdbError::InvalidFormat(format!(
+                "Stride node {} exceeds node count {}",
+                node, self.header.node_count
+            )));
+        }
+        let at = self.header.nodes_offset + node as usize * STRIDE_NODE_BYTES + nibble * 4;
+        Ok(u32::from_le_bytes(
+            self.data[at..at + 4].try_into().unwrap(),
+        ))
+    }
+
+    /// Prefetch the cache line holding a stride node
+    #[inline(always)]
+    fn prefetch_node(&self, node: u32) {
+        let offset = self.header.nodes_offset + node as usize * STRIDE_NODE_BYTES;
+        if offset < self.data.len() {
+            crate::simd_utils::prefetch_read(self.data[offset..].as_ptr());
+        }
+    }
+}
+
+/// Check whether a stride section matches the tree it was built from
+///
+/// Compares lookups of a spread of addresses against the binary tree, for
+/// validation. Returns the first address whose results differ.
+pub fn find_mismatch(
+    data: &[u8],
+    tree_header: &MmdbHeader,
+    stride_header: &StrideHeader,
+    samples: usize,
+) -> Option<IpAddr> {
+    use super::types::IpVersion;
+
+    let tree = super::SearchTree::new(data, tree_header);
+    let stride = StrideIndex::new(data, stride_header);
+    let step = (u32::MAX / samples.max(1) as u32).max(1);
+
+    (0..samples as u32)
+        .flat_map(|i| {
+            let v4 = IpAddr::V4(Ipv4Addr::from(i.wrapping_mul(step)));
+            let v6 = (tree_header.ip_version == IpVersion::V6).then(|| {
+                IpAddr::V6(Ipv6Addr::from(
+                    ((i.wrapping_mul(step) as u128) << 96) | i as u128,
+                ))
+            });
+            std::iter::once(v4).chain(v6)
+        })
+        .find(|&addr| tree.lookup(addr).ok() != stride.lookup(addr).ok())
+}
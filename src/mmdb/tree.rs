@@ -8,8 +8,9 @@
 //! - A "not found" marker
 
 use super::format::MmdbHeader;
-use super::types::{MmdbError, RecordSize};
+use super::types::{IpVersion, MmdbError, RecordSize};
 use std::net::{IpAddr, Ipv4Addr, Ipv6Addr};
+use std::ops::ControlFlow;
 
 /// Result of an IP lookup
 #[derive(Debug, Clone, PartialEq)]
@@ -20,18 +21,145 @@ pub struct LookupResult {
     pub prefix_len: u8,
 }
 
+/// Number of lookups `lookup_batch` keeps in flight at once
+///
+/// Enough independent traversals to cover main-memory latency with
+/// prefetches, small enough that lane state stays in registers/L1.
+pub(super) const BATCH_LANES: usize = 8;
+
+/// In-flight state of one batched lookup
+#[derive(Clone, Copy)]
+struct Lane {
+    /// Position of this address in the caller's slice
+    index: usize,
+    /// Current tree node
+    node: u32,
+    /// Remaining address bits, next bit in the top position
+    bits: u128,
+    /// Address bits left to consume
+    remaining: u8,
+    /// Address bits consumed so far (the prefix length on a data hit)
+    consumed: u8,
+}
+
+/// Walk state carried between the lookups of `lookup_sorted`
+///
+/// Keeps the nodes the previous lookup passed through, so the next one can
+/// resume below the prefix both addresses share instead of at the root.
+struct SortedWalk {
+    /// Node the walk for this address family starts at
+    start: u32,
+    /// Address bits for this family (32 or 128)
+    width: u8,
+    /// `path[d]` is the node read for address bit `d` by the previous lookup
+    path: [u32; 128],
+    /// Previous address, top-aligned
+    prev: u128,
+    /// Bits the previous lookup consumed, with its result (None if it
+    /// failed or there was no previous lookup)
+    last: Option<(u8, Option<LookupResult>)>,
+}
+
+impl SortedWalk {
+    fn new(start: u32, width: u8) -> Self {
+        Self {
+            start,
+            width,
+            path: [0; 128],
+            prev: 0,
+            last: None,
+        }
+    }
+}
+
+/// Leading IPv4 bits resolved by one [`Ipv4DirectIndex`] read
+const DIRECT_INDEX_BITS: u8 = 16;
+
+/// Direct-index table for the first 16 bits of IPv4 lookups (DIR-16)
+///
+/// Slot `i` holds the record an IPv4 walk reaches after consuming the 16
+/// bits of `i` (a node to continue from, a data record, or "not found" if
+/// the walk ended earlier), plus how many bits that took. A lookup starts
+/// with one array read instead of 16 dependent node reads.
+///
+/// Built from the tree when a database is opened; uses 320 KiB.
+pub struct Ipv4DirectIndex {
+    /// Record reached for each 16-bit prefix
+    records: Box<[u32]>,
+    /// Address bits consumed to reach each record
+    depths: Box<[u8]>,
+}
+
+impl Ipv4DirectIndex {
+    /// Build the table by walking the top 16 IPv4 levels of `tree` once
+    pub fn build(tree: &SearchTree<'_>) -> Result<Self, MmdbError> {
+        let slots = 1usize << DIRECT_INDEX_BITS;
+        let mut index = Self {
+            records: vec![0; slots].into_boxed_slice(),
+            depths: vec![0; slots].into_boxed_slice(),
+        };
+        index.fill(tree, tree.header.ipv4_start_node, 0, 0)?;
+        Ok(index)
+    }
+
+    /// Fill the slots under `prefix` (with `depth` bits) from `node`
+    fn fill(
+        &mut self,
+        tree: &SearchTree<'_>,
+        node: u32,
+        depth: u8,
+        prefix: usize,
+    ) -> Result<(), MmdbError> {
+        if depth == DIRECT_INDEX_BITS {
+            self.records[prefix] = node;
+            self.depths[prefix] = depth;
+            return Ok(());
+        }
+
+        for bit in 0..2u8 {
+            let record = tree.read_record(node as usize, bit)?;
+            let child = (prefix << 1) | bit as usize;
+            if record < tree.header.node_count {
+                self.fill(tree, record, depth + 1, child)?;
+            } else {
+                // Data or "not found": every address under this prefix ends here
+                let shift = DIRECT_INDEX_BITS - depth - 1;
+                let slots = child << shift..(child + 1) << shift;
+                self.records[slots.clone()].fill(record);
+                self.depths[slots].fill(depth + 1);
+            }
+        }
+        Ok(())
+    }
+}
+
 /// Search tree for IP address lookups
+#[derive(Clone, Copy)]
 pub struct SearchTree<'a> {
     /// The raw file data containing the tree
     data: &'a [u8],
     /// Parsed header information
     header: &'a MmdbHeader,
+    /// Optional DIR-16 table for the start of IPv4 lookups
+    ipv4_index: Option<&'a Ipv4DirectIndex>,
 }
 
 impl<'a> SearchTree<'a> {
     /// Create a new search tree
     pub fn new(data: &'a [u8], header: &'a MmdbHeader) -> Self {
-        Self { data, header }
+        Self {
+            data,
+            header,
+            ipv4_index: None,
+        }
+    }
+
+    /// Resolve the first 16 bits of IPv4 lookups through `index`
+    ///
+    /// `index` must have been built from this same tree.
+    pub fn with_ipv4_index(mut self, index: &'a Ipv4DirectIndex) -> Self {
+        self.ipv4_index = Some(index);
+        self
     }
 
     /// Look up an IP address
@@ -42,25 +170,215 @@ impl<'a> SearchTree<'a> {
         }
     }
 
-    /// Look up an IPv4 address
-    pub fn lookup_v4(&self, addr: Ipv4Addr) -> Result<Option<LookupResult>, MmdbError> {
-        use super::types::IpVersion;
-
-        // Check if this is an IPv6 tree
-        let (mut node, mut depth) = if self.header.ip_version == IpVersion::V6 {
-            // IPv4 addresses in IPv6 trees require finding the IPv4 start node first.
-            // Per MMDB spec and libmaxminddb, we traverse 96 zero bits (::ffff:0:0/96)
-            // to reach the IPv4 address space within the IPv6 tree.
-            self.find_ipv4_start_node()?
+    /// Look up many IP addresses with interleaved traversal
+    ///
+    /// Walks up to `BATCH_LANES` lookups in lockstep and prefetches each
+    /// lane's next node before stepping the others, so the cache misses of
+    /// independent lookups overlap instead of serializing. `results` is
+    /// cleared and filled with one entry per address, identical to what
+    /// [`lookup`](Self::lookup) returns for it.
+    pub fn lookup_batch(
+        &self,
+        addrs: &[IpAddr],
+        results: &mut Vec<Result<Option<LookupResult>, MmdbError>>,
+    ) {
+        results.clear();
+        results.resize_with(addrs.len(), || Ok(None));
+
+        for (chunk_index, chunk) in addrs.chunks(BATCH_LANES).enumerate() {
+            let mut lanes = [Lane {
+                index: 0,
+                node: 0,
+                bits: 0,
+                remaining: 0,
+                consumed: 0,
+            }; BATCH_LANES];
+            let mut active = 0;
+
+            for (offset, addr) in chunk.iter().enumerate() {
+                let index = chunk_index * BATCH_LANES + offset;
+                let lane = match addr {
+                    IpAddr::V4(v4) => {
+                        let bits = ipv4_to_bits(*v4);
+                        match self.ipv4_walk_start(bits) {
+                            ControlFlow::Continue((node, consumed)) => Lane {
+                                index,
+                                node,
+                                bits: (bits as u128) << (96 + consumed),
+                                remaining: 32 - consumed,
+                                consumed,
+                            },
+                            ControlFlow::Break(result) => {
+                                results[index] = result;
+                                continue;
+                            }
+                        }
+                    }
+                    IpAddr::V6(v6) => {
+                        let (high, low) = ipv6_to_bits(*v6);
+                        Lane {
+                            index,
+                            node: 0,
+                            bits: ((high as u128) << 64) | low as u128,
+                            remaining: 128,
+                            consumed: 0,
+                        }
+                    }
+                };
+                lanes[active] = lane;
+                active += 1;
+            }
+
+            // Round-robin over live lanes; finished lanes are swap-removed
+            while active > 0 {
+                let mut i = 0;
+                while i < active {
+                    match self.step_lane(&mut lanes[i]) {
+                        None => {
+                            self.prefetch_node(lanes[i].node);
+                            i += 1;
+                        }
+                        Some(result) => {
+                            results[lanes[i].index] = result;
+                            active -= 1;
+                            lanes[i] = lanes[active];
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /// Look up many IP addresses, resuming each walk from the previous one
+    ///
+    /// For addresses in ascending order (as [`IpAddr`]'s `Ord` sorts them),
+    /// consecutive lookups share the leading part of their tree paths:
+    /// each walk restarts at the node where its address leaves the previous
+    /// address's path, and an address still inside the previous network
+    /// reuses its result without reading the tree. `results` is cleared and
+    /// filled with one entry per address, identical to what
+    /// [`lookup`](Self::lookup) returns for it; unsorted input is still
+    /// answered correctly, just without the savings.
+    pub fn lookup_sorted(
+        &self,
+        addrs: &[IpAddr],
+        results: &mut Vec<Result<Option<LookupResult>, MmdbError>>,
+    ) {
+        results.clear();
+        results.reserve(addrs.len());
+
+        let mut v4 = SortedWalk::new(self.header.ipv4_start_node, 32);
+        let mut v6 = SortedWalk::new(0, 128);
+        for addr in addrs {
+            let result = match addr {
+                IpAddr::V4(v4_addr) => {
+                    self.walk_from_previous(&mut v4, (ipv4_to_bits(*v4_addr) as u128) << 96)
+                }
+                IpAddr::V6(v6_addr) => {
+                    let (high, low) = ipv6_to_bits(*v6_addr);
+                    self.walk_from_previous(&mut v6, ((high as u128) << 64) | low as u128)
+                }
+            };
+            results.push(result);
+        }
+    }
+
+    /// One `lookup_sorted` walk for the top-aligned address `bits`
+    fn walk_from_previous(
+        &self,
+        walk: &mut SortedWalk,
+        bits: u128,
+    ) -> Result<Option<LookupResult>, MmdbError> {
+        let shared = (walk.prev ^ bits).leading_zeros().min(walk.width as u32) as u8;
+        let depth = match &walk.last {
+            // Same network as the previous address: same answer
+            Some((consumed, result)) if shared >= *consumed => return Ok(result.clone()),
+            Some(_) => shared,
+            None => 0,
+        };
+
+        walk.prev = bits;
+        walk.last = None;
+        let mut node = if depth == 0 {
+            walk.start
         } else {
-            // Pure IPv4 tree - start at root
-            (0u32, 0u8)
+            walk.path[depth as usize]
         };
+        for bit_index in depth..walk.width {
+            walk.path[bit_index as usize] = node;
+            let bit = ((bits >> (127 - bit_index)) & 1) as u8;
+            let record = self.read_record(node as usize, bit)?;
 
-        // Now traverse the IPv4 address bits
+            let result = if record == self.header.node_count {
+                None
+            } else if record < self.header.node_count {
+                node = record;
+                continue;
+            } else {
+                self.data_result(record, bit_index + 1)?
+            };
+            walk.last = Some((bit_index + 1, result.clone()));
+            return Ok(result);
+        }
+
+        walk.last = Some((walk.width, None));
+        Ok(None)
+    }
+
+    /// Advance one batched lookup by a single bit
+    ///
+    /// Returns `None` while the lookup is still descending, or its final result.
+    #[inline]
+    fn step_lane(&self, lane: &mut Lane) -> Option<Result<Option<LookupResult>, MmdbError>> {
+        if lane.remaining == 0 {
+            return Some(Ok(None));
+        }
+
+        let bit = (lane.bits >> 127) as u8;
+        lane.bits <<= 1;
+        lane.remaining -= 1;
+        lane.consumed += 1;
+
+        let record = match self.read_record(lane.node as usize, bit) {
+            Ok(r) => r,
+            Err(e) => return Some(Err(e)),
+        };
+
+        if record == self.header.node_count {
+            Some(Ok(None))
+        } else if record < self.header.node_count {
+            lane.node = record;
+            None
+        } else {
+            Some(self.calculate_data_offset(record).map(|data_offset| {
+                Some(LookupResult {
+                    data_offset,
+                    prefix_len: lane.consumed,
+                })
+            }))
+        }
+    }
+
+    /// Prefetch the cache line holding `node`'s records
+    #[inline(always)]
+    fn prefetch_node(&self, node: u32) {
+        let offset = node as usize * self.header.record_size.node_bytes();
+        if offset < self.data.len() {
+            crate::simd_utils::prefetch_read(self.data[offset..].as_ptr());
+        }
+    }
+
+    /// Look up an IPv4 address
+    pub fn lookup_v4(&self, addr: Ipv4Addr) -> Result<Option<LookupResult>, MmdbError> {
         let bits = ipv4_to_bits(addr);
 
-        for bit_index in 0..32 {
+        let (mut node, start_bit) = match self.ipv4_walk_start(bits) {
+            ControlFlow::Continue(start) => start,
+            ControlFlow::Break(result) => return result,
+        };
+
+        // Now traverse the remaining IPv4 address bits
+        for bit_index in start_bit..32 {
             let bit = ((bits >> (31 - bit_index)) & 1) as u8;
             let record = self.read_record(node as usize, bit)?;
 
@@ -68,26 +386,52 @@ impl<'a> SearchTree<'a> {
                 return Ok(None);
             } else if record < self.header.node_count {
                 node = record;
-                depth += 1;
             } else {
-                let data_offset = self.calculate_data_offset(record)?;
-                // For IPv4 lookups, report the prefix as IPv4 prefix length
-                // (depth includes the 96 bits traversed for IPv6 tree, so subtract them)
-                let ipv4_prefix = if depth >= 96 {
-                    depth - 96 + 1
-                } else {
-                    depth + 1
-                };
-                return Ok(Some(LookupResult {
-                    data_offset,
-                    prefix_len: ipv4_prefix,
-                }));
+                // Report the prefix as an IPv4 prefix length (excluding the
+                // 96 bits leading to the IPv4 subtree of an IPv6 tree)
+                return self.data_result(record, bit_index + 1);
             }
         }
 
         Ok(None)
     }
 
+    /// Where an IPv4 walk starts: `(node, bits already consumed)`
+    ///
+    /// IPv4 addresses in IPv6 trees live under the start node resolved once
+    /// in [`MmdbHeader`]. With a direct index the first 16 bits are a single
+    /// table read, which may also finish the lookup (`Break`).
+    #[inline]
+    fn ipv4_walk_start(
+        &self,
+        bits: u32,
+    ) -> ControlFlow<Result<Option<LookupResult>, MmdbError>, (u32, u8)> {
+        let index = match self.ipv4_index {
+            Some(index) => index,
+            None => return ControlFlow::Continue((self.header.ipv4_start_node, 0)),
+        };
+
+        let slot = (bits >> (32 - DIRECT_INDEX_BITS)) as usize;
+        let record = index.records[slot];
+        if record < self.header.node_count {
+            ControlFlow::Continue((record, DIRECT_INDEX_BITS))
+        } else if record == self.header.node_count {
+            ControlFlow::Break(Ok(None))
+        } else {
+            ControlFlow::Break(self.data_result(record, index.depths[slot]))
+        }
+    }
+
+    /// Result for a data record reached after `prefix_len` bits
+    #[inline]
+    fn data_result(&self, record: u32, prefix_len: u8) -> Result<Option<LookupResult>, MmdbError> {
+        let data_offset = self.calculate_data_offset(record)?;
+        Ok(Some(LookupResult {
+            data_offset,
+            prefix_len,
+        }))
+    }
+
     /// Look up an IPv6 address
     pub fn lookup_v6(&self, addr: Ipv6Addr) -> Result<Option<LookupResult>, MmdbError> {
         // Convert IPv6 to bits
@@ -247,15 +591,67 @@ impl<'a> SearchTree<'a> {
         Ok(offset)
     }
 
+    /// Visit every network that has data, in address order
+    ///
+    /// Calls `f` with each network yielded by [`networks`](Self::networks)
+    /// and its data offset. Stops at, and returns, the first error from `f`.
+    pub fn for_each_network<E: From<MmdbError>>(
+        &self,
+        mut f: impl FnMut(IpAddr, u8, u32) -> Result<(), E>,
+    ) -> Result<(), E> {
+        for network in self.networks() {
+            let (addr, prefix_len, data_offset) = network?;
+            f(addr, prefix_len, data_offset)?;
+        }
+        Ok(())
+    }
+
+    /// Iterate over every network that has data, in address order
+    ///
+    /// Yields each leaf network as `(address, prefix length, data offset)`.
+    /// Networks under `::/96` in IPv6 trees are reported as IPv4, the way
+    /// `IpTreeBuilder` stores them, and aliases of the IPv4 subtree
+    /// elsewhere (such as `::ffff:0:0/96`) are skipped so each address is
+    /// visited once. A malformed tree yields one error and then ends.
+    pub fn networks(&self) -> Networks<'a> {
+        let ipv4_subtree = match self.header.ip_version {
+            IpVersion::V6 => self.ipv4_subtree_node(),
+            IpVersion::V4 => None,
+        };
+        Networks {
+            tree: *self,
+            stack: vec![(0, 0, 0)],
+            ipv4_subtree,
+        }
+    }
+
+    /// The node at the end of 96 zero bits, if the tree reaches that depth
+    ///
+    /// Unlike [`find_ipv4_start_node`](Self::find_ipv4_start_node) this does
+    /// not settle for a shallower node, since only a node at depth 96 can be
+    /// aliased by `::ffff:0:0/96` and friends.
+    fn ipv4_subtree_node(&self) -> Option<u32> {
+        let mut node = 0u32;
+        for _ in 0..96 {
+            let record = self.read_record(node as usize, 0).ok()?;
+            if record >= self.header.node_count {
+                return None;
+            }
+            node = record;
+        }
+        (node != 0).then_some(node)
+    }
+
     /// Find the IPv4 start node in an IPv6 tree
     ///
     /// Per MMDB spec, IPv4 addresses in IPv6 trees are accessed via the
     /// ::ffff:0:0/96 prefix. We traverse 96 zero bits to find where the
-    /// IPv4 address space begins.
+    /// IPv4 address space begins. The walk stops early at the last node
+    /// if the path ends before that depth.
     ///
-    /// Returns (node, depth) where node is the starting node for IPv4 lookups
-    /// and depth is 96 (the number of bits traversed).
-    fn find_ipv4_start_node(&self) -> Result<(u32, u8), MmdbError> {
+    /// Called once per file by [`MmdbHeader::from_file`]; lookups read the
+    /// result from `MmdbHeader::ipv4_start_node`.
+    pub(super) fn find_ipv4_start_node(&self) -> Result<u32, MmdbError> {
         let mut node = 0u32;
 
         // Traverse 96 zero bits (left record each time)
@@ -264,16 +660,87 @@ impl<'a> SearchTree<'a> {
 
             if record == self.header.node_count {
                 // IPv4 space not found in this tree
-                return Ok((node, 96));
+                return Ok(node);
             } else if record < self.header.node_count {
                 node = record;
             } else {
                 // Shouldn't hit data in the first 96 bits, but handle it
-                return Ok((node, 96));
+                return Ok(node);
             }
         }
 
-        Ok((node, 96))
+        Ok(node)
+    }
+}
+
+/// Iterator over the networks of a search tree, from [`SearchTree::networks`]
+pub struct Networks<'a> {
+    tree: SearchTree<'a>,
+    /// (record, address bits so far (top-aligned), depth); left on top
+    stack: Vec<(u32, u128, u8)>,
+    /// IPv4 subtree root at depth 96 of an IPv6 tree, visited only there
+    ipv4_subtree: Option<u32>,
+}
+
+impl Networks<'_> {
+    /// End the iteration with `error`
+    fn fail(&mut self, error: MmdbError) -> Option<Result<(IpAddr, u8, u32), MmdbError>> {
+        self.stack.clear();
+        Some(Err(error))
+    }
+}
+
+impl Iterator for Networks<'_> {
+    type Item = Result<(IpAddr, u8, u32), MmdbError>;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        let header = self.tree.header;
+        let is_v6 = header.ip_version == IpVersion::V6;
+        let max_depth: u8 = if is_v6 { 128 } else { 32 };
+
+        while let Some((record, bits, depth)) = self.stack.pop() {
+            if record > header.node_count {
+                let data_offset = match self.tree.calculate_data_offset(record) {
+                    Ok(offset) => offset,
+                    Err(e) => return self.fail(e),
+                };
+                let (addr, prefix_len) = if !is_v6 {
+                    (IpAddr::V4(Ipv4Addr::from((bits >> 96) as u32)), depth)
+                } else if depth >= 96 && bits >> 32 == 0 {
+                    (IpAddr::V4(Ipv4Addr::from(bits as u32)), depth - 96)
+                } else {
+                    (IpAddr::V6(Ipv6Addr::from(bits)), depth)
+                };
+                return Some(Ok((addr, prefix_len, data_offset)));
+            }
+            if record == header.node_count {
+                continue;
+            }
+            if depth >= max_depth {
+                return self.fail(MmdbError::InvalidFormat(format!(
+                    "Search tree deeper than {} bits at node {}",
+                    max_depth, record
+                )));
+            }
+
+            let is_alias = self.ipv4_subtree == Some(record);
+            if is_alias && !(bits == 0 && depth == 96) {
+                continue;
+            }
+            for side in [1u8, 0] {
+                match self.tree.read_record(record as usize, side) {
+                    Ok(child) => {
+                        self.stack.push((
+                            child,
+                            bits | ((side as u128) << (127 - depth)),
+                            depth + 1,
+                        ));
+                    }
+                    Err(e) => return self.fail(e),
+                }
+            }
+        }
+        None
     }
 }
 
@@ -321,8 +788,6 @@ mod tests {
 
     #[test]
     fn test_read_24bit_record() {
-        use super::super::types::IpVersion;
-
         // Create a small test tree with 24-bit records
         // Node 0: left=1, right=2
         let mut data = vec![0u8; 1000];
@@ -338,6 +803,7 @@ mod tests {
             record_size: RecordSize::Bits24,
             ip_version: IpVersion::V6,
             tree_size: 60, // 10 nodes * 6 bytes
+            ipv4_start_node: 0,
         };
 
         let tree = SearchTree::new(&data, &header);
@@ -348,8 +814,6 @@ mod tests {
 
     #[test]
     fn test_read_28bit_record() {
-        use super::super::types::IpVersion;
-
         // Create test data for 28-bit records
         let mut data = vec![0u8; 1000];
         // Node 0 with 28-bit records
@@ -367,6 +831,7 @@ mod tests {
             record_size: RecordSize::Bits28,
             ip_version: IpVersion::V6,
             tree_size: 70, // 10 nodes * 7 bytes
+            ipv4_start_node: 0,
         };
 
         let tree = SearchTree::new(&data, &header);
@@ -377,13 +842,12 @@ mod tests {
 
     #[test]
     fn test_calculate_data_offset() {
-        use super::super::types::IpVersion;
-
         let header = MmdbHeader {
             node_count: 100,
             record_size: RecordSize::Bits24,
             ip_version: IpVersion::V6,
             tree_size: 600,
+            ipv4_start_node: 0,
         };
 
         let tree = SearchTree::new(&[], &header);
@@ -397,6 +861,192 @@ mod tests {
         assert_eq!(tree.calculate_data_offset(200).unwrap(), 84);
     }
 
+    #[test]
+    fn test_lookup_batch_matches_single_lookups() {
+        let data = include_bytes!("../../tests/data/GeoLite2-Country.mmdb");
+        let header = MmdbHeader::from_file(data).unwrap();
+        let tree = SearchTree::new(data, &header);
+
+        // More than one chunk of lanes, mixing families, hits and misses
+        let addrs: Vec<IpAddr> = [
+            "1.1.1.1",
+            "8.8.8.8",
+            "127.0.0.1",
+            "2001:4860:4860::8888",
+            "10.0.0.1",
+            "81.2.69.160",
+            "::1",
+            "192.168.1.1",
+            "2a02:ff80::",
+            "203.0.113.7",
+            "9.9.9.9",
+        ]
+        .iter()
+        .map(|s| s.parse().unwrap())
+        .collect();
+
+        let mut results = Vec::new();
+        tree.lookup_batch(&addrs, &mut results);
+        assert_eq!(results.len(), addrs.len());
+
+        for (addr, batched) in addrs.iter().zip(&results) {
+            let single = tree.lookup(*addr).unwrap();
+            assert_eq!(batched.as_ref().unwrap(), &single, "mismatch for {}", addr);
+        }
+    }
+
+    #[test]
+    fn test_lookup_sorted_matches_single_lookups() {
+        let data = include_bytes!("../../tests/data/GeoLite2-Country.mmdb");
+        let header = MmdbHeader::from_file(data).unwrap();
+        let tree = SearchTree::new(data, &header);
+
+        // Dense runs (shared paths and networks) and sparse jumps, both families
+        let mut addrs: Vec<IpAddr> = (0..5_000u32)
+            .map(|i| IpAddr::V4(Ipv4Addr::from(0x5102_4500 + i * 3)))
+            .chain((0..5_000u32).map(|i| IpAddr::V4(Ipv4Addr::from(i.wrapping_mul(858_993)))))
+            .chain(
+                (0..2_000u128).map(|i| IpAddr::V6(Ipv6Addr::from((0x2a02u128 << 112) + (i << 90)))),
+            )
+            .chain(
+                ["::1", "::ffff:8.8.8.8", "ffff::1"]
+                    .iter()
+                    .map(|s| s.parse().unwrap()),
+            )
+            .collect();
+
+        // Sorted input, then the same addresses unsorted
+        addrs.sort();
+        for pass in 0..2 {
+            let mut results = Vec::new();
+            tree.lookup_sorted(&addrs, &mut results);
+            assert_eq!(results.len(), addrs.len());
+            for (addr, walked) in addrs.iter().zip(&results) {
+                let single = tree.lookup(*addr).unwrap();
+                assert_eq!(walked.as_ref().unwrap(), &single, "pass {} {}", pass, addr);
+            }
+            addrs.reverse();
+        }
+    }
+
+    #[test]
+    fn test_networks_cover_lookups() {
+        let data = include_bytes!("../../tests/data/GeoLite2-Country.mmdb");
+        let header = MmdbHeader::from_file(data).unwrap();
+        let tree = SearchTree::new(data, &header);
+
+        let mut count = 0;
+        let mut previous: Option<IpAddr> = None;
+        for network in tree.networks() {
+            let (addr, prefix_len, data_offset) = network.unwrap();
+            // In address order within each family, and each network's
+            // first address looks up to it
+            if let Some(previous) = previous {
+                assert!(previous.is_ipv4() != addr.is_ipv4() || previous < addr);
+            }
+            previous = Some(addr);
+            let found = tree.lookup(addr).unwrap().unwrap();
+            assert_eq!(
+                (found.prefix_len, found.data_offset),
+                (prefix_len, data_offset)
+            );
+            count += 1;
+        }
+
+        let mut visited = 0;
+        tree.for_each_network::<MmdbError>(|_, _, _| {
+            visited += 1;
+            Ok(())
+        })
+        .unwrap();
+        assert!(count > 1000);
+        assert_eq!(visited, count);
+    }
+
+    #[test]
+    fn test_networks_with_shallow_zero_path() {
+        // IPv6 tree holding ::/8 and 0100::/8: the zero path ends at the
+        // depth-7 node, which is not an IPv4 alias and must be walked
+        let node_count = 8u32;
+        let mut data = Vec::new();
+        for node in 0..node_count {
+            let (left, right) = if node < 7 {
+                (node + 1, node_count)
+            } else {
+                (node_count + 16, node_count + 16 + 1)
+            };
+            data.extend_from_slice(&left.to_be_bytes()[1..]);
+            data.extend_from_slice(&right.to_be_bytes()[1..]);
+        }
+        let mut header = MmdbHeader {
+            node_count,
+            record_size: RecordSize::Bits24,
+            ip_version: IpVersion::V6,
+            tree_size: data.len(),
+            ipv4_start_node: 0,
+        };
+        header.ipv4_start_node = SearchTree::new(&data, &header)
+            .find_ipv4_start_node()
+            .unwrap();
+        assert_eq!(header.ipv4_start_node, 7);
+        let tree = SearchTree::new(&data, &header);
+
+        let networks: Vec<(IpAddr, u8, u32)> = tree.networks().map(Result::unwrap).collect();
+        assert_eq!(
+            networks,
+            vec![
+                ("::".parse().unwrap(), 8, 0),
+                ("100::".parse().unwrap(), 8, 1),
+            ]
+        );
+    }
+
+    #[test]
+    fn test_ipv4_direct_index_matches_tree_walk() {
+        let data = include_bytes!("../../tests/data/GeoLite2-Country.mmdb");
+        let header = MmdbHeader::from_file(data).unwrap();
+        let plain = SearchTree::new(data, &header);
+        let index = Ipv4DirectIndex::build(&plain).unwrap();
+        let indexed = SearchTree::new(data, &header).with_ipv4_index(&index);
+
+        // Spread over the whole IPv4 space, plus a few fixed addresses
+        let mut addrs: Vec<IpAddr> = (0..20_000u32)
+            .map(|i| IpAddr::V4(Ipv4Addr::from(i.wrapping_mul(214_749))))
+            .collect();
+        addrs.extend(
+            [
+                "0.0.0.0",
+                "1.1.1.1",
+                "8.8.8.8",
+                "10.0.0.1",
+                "255.255.255.255",
+                "2001:4860::1",
+            ]
+            .iter()
+            .map(|s| s.parse::<IpAddr>().unwrap()),
+        );
+
+        for addr in &addrs {
+            assert_eq!(
+                plain.lookup(*addr).unwrap(),
+                indexed.lookup(*addr).unwrap(),
+                "mismatch for {}",
+                addr
+            );
+        }
+
+        let mut results = Vec::new();
+        indexed.lookup_batch(&addrs, &mut results);
+        for (addr, batched) in addrs.iter().zip(&results) {
+            assert_eq!(
+                batched.as_ref().unwrap(),
+                &plain.lookup(*addr).unwrap(),
+                "batch mismatch for {}",
+                addr
+            );
+        }
+    }
+
     #[test]
     fn test_lookup_with_real_database() {
         // This test uses the actual GeoLite2-Country.mmdb file
@@ -10,10 +10,13 @@ use crate::ip_tree_builder::IpTreeBuilder;
 use crate::literal_hash::LiteralHashBuilder;
 use crate::mmdb::types::RecordSize;
 use crate::paraglob_offset::ParaglobBuilder;
+use crate::prefilter::PrefilterBuilder;
+use rayon::prelude::*;
 use rustc_hash::FxHasher;
 use std::collections::HashMap;
 use std::hash::{Hash, Hasher};
 use std::net::IpAddr;
+use std::time::{Duration, Instant};
 
 /// Entry type classification
 #[derive(Debug, Clone)]
@@ -51,6 +54,18 @@ pub struct MmdbBuilder {
     database_type: Option<String>,
     /// Optional custom description (language -> text)
     description: HashMap<String, String>,
+    /// Whether to write the multi-bit IP stride index section
+    ip_stride_index: bool,
+    /// Glob automaton states up to this depth are written as DFA states
+    glob_dfa_depth: Option<u8>,
+    /// Whether the glob automaton uses a byte-class alphabet
+    glob_byte_classes: bool,
+    /// Whether to write a Bloom prefilter over literals and glob ends
+    prefilter: bool,
+    /// Whether literals go in a minimal perfect hash table
+    perfect_hash_literals: bool,
+    /// Data offset of the tombstone record, once a tombstone was added
+    tombstone_offset: Option<u32>,
 }
 
 impl MmdbBuilder {
@@ -63,6 +78,12 @@ impl MmdbBuilder {
             match_mode,
             database_type: None,
             description: HashMap::new(),
+            ip_stride_index: false,
+            glob_dfa_depth: None,
+            glob_byte_classes: false,
+            prefilter: false,
+            perfect_hash_literals: false,
+            tombstone_offset: None,
         }
     }
 
@@ -106,6 +127,117 @@ impl MmdbBuilder {
         self
     }
 
+    /// Also write a multi-bit stride index of the IP tree
+    ///
+    /// The index is an extra section holding the tree four bits per
+    /// 64-byte node, which cuts IPv4 lookups to at most 8 cache lines.
+    /// The standard tree is still written, so files stay readable by
+    /// libmaxminddb; readers without index support just ignore it.
+    /// Typically adds two to three times the tree's size to the file.
+    ///
+    /// # Example
+    /// ```
+    /// use matchy::mmdb_builder::MmdbBuilder;
+    /// use matchy::glob::MatchMode;
+    ///
+    /// let builder = MmdbBuilder::new(MatchMode::CaseSensitive)
+    ///     .with_ip_stride_index(true);
+    /// ```
+    pub fn with_ip_stride_index(mut self, enabled: bool) -> Self {
+        self.ip_stride_index = enabled;
+        self
+    }
+
+    /// Write the glob automaton's states up to `depth` as DFA states
+    ///
+    /// DFA states resolve every byte with one table load instead of an
+    /// edge search plus failure-link walk, which is where large glob sets
+    /// spend their scan time. Each state costs 1KB, so keep `depth` small:
+    /// `0` is the root only, `1` or `2` covers most hot states. Databases
+    /// built with this need a reader that understands paraglob format v5.
+    /// See [`ParaglobBuilder::with_dfa_depth`].
+    ///
+    /// # Example
+    /// ```
+    /// use matchy::mmdb_builder::MmdbBuilder;
+    /// use matchy::glob::MatchMode;
+    ///
+    /// let builder = MmdbBuilder::new(MatchMode::CaseSensitive)
+    ///     .with_glob_dfa_depth(1);
+    /// ```
+    pub fn with_glob_dfa_depth(mut self, depth: u8) -> Self {
+        self.glob_dfa_depth = Some(depth);
+        self
+    }
+
+    /// Key the glob automaton's transitions by byte class
+    ///
+    /// Shrinks dense and DFA tables to one entry per distinct pattern byte
+    /// (folding case in case-insensitive mode), which makes a deeper
+    /// [`with_glob_dfa_depth`](Self::with_glob_dfa_depth) affordable.
+    /// Databases built with this need a reader that understands paraglob
+    /// format v5. See [`ParaglobBuilder::with_byte_classes`].
+    ///
+    /// # Example
+    /// ```
+    /// use matchy::mmdb_builder::MmdbBuilder;
+    /// use matchy::glob::MatchMode;
+    ///
+    /// let builder = MmdbBuilder::new(MatchMode::CaseInsensitive)
+    ///     .with_glob_byte_classes(true)
+    ///     .with_glob_dfa_depth(2);
+    /// ```
+    pub fn with_glob_byte_classes(mut self, enabled: bool) -> Self {
+        self.glob_byte_classes = enabled;
+        self
+    }
+
+    /// Also write a Bloom prefilter for string lookups
+    ///
+    /// The filter holds every literal and each glob's first or last few
+    /// literal bytes, so most string misses are rejected with one cache
+    /// line read before the literal table or glob automaton is touched.
+    /// Costs about 10 bits per literal and glob. Globs with no literal
+    /// prefix or suffix (such as `*evil*`) leave the glob automaton running
+    /// for every query. Readers without prefilter support ignore the
+    /// section. See [`crate::prefilter`].
+    ///
+    /// # Example
+    /// ```
+    /// use matchy::mmdb_builder::MmdbBuilder;
+    /// use matchy::glob::MatchMode;
+    ///
+    /// let builder = MmdbBuilder::new(MatchMode::CaseInsensitive)
+    ///     .with_prefilter(true);
+    /// ```
+    pub fn with_prefilter(mut self, enabled: bool) -> Self {
+        self.prefilter = enabled;
+        self
+    }
+
+    /// Store literals in a minimal perfect hash table
+    ///
+    /// Each literal gets exactly one 32-byte slot with a fingerprint, its
+    /// data offset and the first 14 key bytes inline; a lookup reads one
+    /// 2-byte bucket pilot and that slot, so hits and misses cost about one
+    /// cache miss instead of a probe run plus a string pool read. The
+    /// section is also smaller. The slots are cache-line aligned in the
+    /// file. Readers older than this layout can't load the literal table.
+    /// See [`crate::literal_phf`].
+    ///
+    /// # Example
+    /// ```
+    /// use matchy::mmdb_builder::MmdbBuilder;
+    /// use matchy::glob::MatchMode;
+    ///
+    /// let builder = MmdbBuilder::new(MatchMode::CaseInsensitive)
+    ///     .with_perfect_hash_literals(true);
+    /// ```
+    pub fn with_perfect_hash_literals(mut self, enabled: bool) -> Self {
+        self.perfect_hash_literals = enabled;
+        self
+    }
+
     /// Add an entry with auto-detection
     ///
     /// Automatically detects whether the key is an IP address, literal string, or glob pattern.
@@ -126,6 +258,41 @@ impl MmdbBuilder {
         Ok(())
     }
 
+    /// Mark a key as deleted (for delta databases)
+    ///
+    /// The key is classified like [`add_entry`](Self::add_entry) and stored
+    /// with a shared tombstone record. When the built file is used as an
+    /// overlay (see [`DatabaseOpener::overlay`](crate::DatabaseOpener::overlay)),
+    /// a tombstoned key hides the same key in older layers; an IP tombstone
+    /// hides every address its network covers. `matchy compact` drops
+    /// tombstoned keys for good.
+    ///
+    /// # Example
+    /// ```
+    /// # use matchy::{DatabaseBuilder, MatchMode};
+    /// let mut delta = DatabaseBuilder::new(MatchMode::CaseSensitive);
+    /// delta.add_tombstone("10.0.0.0/8")?;
+    /// delta.add_tombstone("*.no-longer-evil.com")?;
+    /// # Ok::<(), Box<dyn std::error::Error>>(())
+    /// ```
+    pub fn add_tombstone(&mut self, key: &str) -> Result<(), ParaglobError> {
+        let entry_type = Self::detect_entry_type(key)?;
+        let data_offset = match self.tombstone_offset {
+            Some(offset) => offset,
+            None => {
+                let offset = self.data_encoder.encode(&crate::delta::tombstone_record());
+                self.tombstone_offset = Some(offset);
+                offset
+            }
+        };
+
+        self.entries.push(EntryRef {
+            entry_type,
+            data_offset,
+        });
+        Ok(())
+    }
+
     /// Add a literal string pattern (exact match only, no wildcards)
     ///
     /// Use this when the string contains characters like '*', '?', or '[' that should be
@@ -185,21 +352,77 @@ impl MmdbBuilder {
         Ok(())
     }
 
+    /// Add many entries with auto-detection
+    ///
+    /// Same result as calling [`add_entry`](Self::add_entry) for each entry
+    /// in order, but key classification and data hashing run in parallel.
+    /// Only the final merge into the data section is sequential, and it
+    /// encodes each distinct value once. If any key is invalid, an error is
+    /// returned and none of the entries are added.
+    ///
+    /// # Example
+    /// ```
+    /// # use matchy::{DatabaseBuilder, MatchMode, DataValue};
+    /// # use std::collections::HashMap;
+    /// let mut builder = DatabaseBuilder::new(MatchMode::CaseSensitive);
+    /// let mut data = HashMap::new();
+    /// data.insert("threat".to_string(), DataValue::String("high".to_string()));
+    ///
+    /// builder.add_entries(vec![
+    ///     ("10.0.0.0/8".to_string(), data.clone()),
+    ///     ("*.evil.com".to_string(), data.clone()),
+    ///     ("evil.com".to_string(), data),
+    /// ])?;
+    /// # Ok::<(), Box<dyn std::error::Error>>(())
+    /// ```
+    pub fn add_entries(
+        &mut self,
+        entries: Vec<(String, HashMap<String, DataValue>)>,
+    ) -> Result<(), ParaglobError> {
+        let prepared: Vec<(EntryType, u64, DataValue)> = entries
+            .into_par_iter()
+            .map(|(key, data)| {
+                let entry_type = Self::detect_entry_type(&key)?;
+                let data_value = DataValue::Map(data);
+                let hash = hash_data(&data_value);
+                Ok((entry_type, hash, data_value))
+            })
+            .collect::<Result<_, ParaglobError>>()?;
+
+        self.entries.reserve(prepared.len());
+        for (entry_type, hash, data_value) in prepared {
+            self.add_hashed(entry_type, hash, &data_value);
+        }
+        Ok(())
+    }
+
+    /// Add an entry classified and hashed elsewhere (e.g. on another thread)
+    ///
+    /// `hash` must be [`hash_data`] of `data_value`.
+    pub(crate) fn add_hashed(&mut self, entry_type: EntryType, hash: u64, data_value: &DataValue) {
+        let data_offset = self.intern_data(hash, data_value);
+        self.entries.push(EntryRef {
+            entry_type,
+            data_offset,
+        });
+    }
+
     /// Encode data and deduplicate to save memory
     fn encode_and_deduplicate_data(&mut self, data: HashMap<String, DataValue>) -> u32 {
-        // Fast hash computation without string allocation
         let data_value = DataValue::Map(data);
-        let mut hasher = FxHasher::default();
-        data_value.hash(&mut hasher);
-        let hash = hasher.finish();
+        let hash = hash_data(&data_value);
+        self.intern_data(hash, &data_value)
+    }
 
+    /// Offset of already-hashed data, encoding it on first sight
+    fn intern_data(&mut self, hash: u64, data_value: &DataValue) -> u32 {
         // Check cache
         if let Some(&offset) = self.data_cache.get(&hash) {
             return offset;
         }
 
         // Encode and cache
-        let offset = self.data_encoder.encode(&data_value);
+        let offset = self.data_encoder.encode(data_value);
         self.data_cache.insert(hash, offset);
         offset
     }
@@ -243,7 +466,7 @@ impl MmdbBuilder {
     }
 
     /// Parse IP address or CIDR (used by add_ip)
-    fn parse_ip_entry(key: &str) -> Result<EntryType, ParaglobError> {
+    pub(crate) fn parse_ip_entry(key: &str) -> Result<EntryType, ParaglobError> {
         // Try parsing as plain IP address first
         if let Ok(addr) = key.parse::<IpAddr>() {
             let prefix_len = if addr.is_ipv4() { 32 } else { 128 };
@@ -345,7 +568,17 @@ impl MmdbBuilder {
     }
 
     /// Build the unified MMDB database
-    pub fn build(mut self) -> Result<Vec<u8>, ParaglobError> {
+    pub fn build(self) -> Result<Vec<u8>, ParaglobError> {
+        self.build_timed().map(|(database, _)| database)
+    }
+
+    /// Build the database and report how long each phase took
+    ///
+    /// The IP tree, glob and literal sections are independent and are built
+    /// concurrently, so their durations can add up to more than `total`.
+    pub fn build_timed(mut self) -> Result<(Vec<u8>, BuildTimings), ParaglobError> {
+        let build_start = Instant::now();
+
         // Data is already encoded - just extract from the builder
         let data_section = self.data_encoder.into_bytes();
 
@@ -373,118 +606,49 @@ impl MmdbBuilder {
             }
         }
 
-        // Always build IP tree structure (even if empty) to maintain MMDB format
-        // This ensures pattern-only databases still work with the Database API
-        let (ip_tree_bytes, node_count, record_size, ip_version) = if !ip_entries.is_empty() {
-            // Determine IP version needed
-            let needs_v6 = ip_entries.iter().any(|(addr, _, _)| addr.is_ipv6());
-
-            // Choose record size based on expected tree size
-            // For /32 IPs, worst case is ~ip_count nodes
-            // 24-bit: max 16,777,216 nodes (16M IPs)
-            // 28-bit: max 268,435,456 nodes (268M IPs)
-            // 32-bit: max 4,294,967,296 nodes (4.2B IPs)
-            let estimated_nodes = ip_entries.len();
-            let record_size = if estimated_nodes > 200_000_000 {
-                // Over 200M IPs - use 32-bit for safety
-                RecordSize::Bits32
-            } else if estimated_nodes > 15_000_000 {
-                // Over 15M IPs - use 28-bit
-                RecordSize::Bits28
-            } else {
-                // Under 15M IPs - use 24-bit (most common)
-                RecordSize::Bits24
-            };
-
-            // Sort IPs by prefix length (more specific first), then by address
-            // This minimizes tree reorganization and backfill operations
-            ip_entries.sort_unstable_by(|(addr1, prefix1, _), (addr2, prefix2, _)| {
-                prefix2.cmp(prefix1).then_with(|| addr1.cmp(addr2))
-            });
-
-            let mut tree_builder = if needs_v6 {
-                IpTreeBuilder::new_v6(record_size)
-            } else {
-                IpTreeBuilder::new_v4(record_size)
-            };
-
-            // Pre-allocate nodes (estimate: ~1.5x entries for typical CIDR distributions)
-            tree_builder.reserve_nodes(estimated_nodes + estimated_nodes / 2);
-
-            // Insert all IP entries using pre-encoded offsets
-            for (addr, prefix_len, data_offset) in &ip_entries {
-                tree_builder.insert(*addr, *prefix_len, *data_offset)?;
-            }
-
-            // Build the tree
-            let (tree_bytes, node_cnt) = tree_builder.build()?;
-
-            let ip_ver = if needs_v6 { 6 } else { 4 };
-            (tree_bytes, node_cnt, record_size, ip_ver)
-        } else {
-            // Empty IP tree - create minimal valid tree
-            let record_size = RecordSize::Bits24;
-            let tree_builder = IpTreeBuilder::new_v4(record_size);
-            let (tree_bytes, node_cnt) = tree_builder.build()?;
-            (tree_bytes, node_cnt, record_size, 4)
-        };
-
-        // Build glob pattern section if we have glob entries (NOT literals)
-        let (has_globs, glob_section_bytes) = if !glob_entries.is_empty() {
-            let mut pattern_builder = ParaglobBuilder::new(self.match_mode);
-            let mut pattern_data = Vec::with_capacity(glob_entries.len());
-
-            for (pattern, data_offset) in &glob_entries {
-                let pattern_id = pattern_builder.add_pattern(pattern)?;
-                pattern_data.push((pattern_id, *data_offset));
-            }
-
-            let paraglob = pattern_builder.build()?;
-            let paraglob_bytes = paraglob.buffer().to_vec();
-
-            // Build complete pattern section: [total_size][paraglob_size][paraglob_data][mappings]
-            let mut section = Vec::new();
-
-            // Will fill in sizes at the end
-            let size_placeholder = vec![0u8; 8]; // 2 u32s
-            section.extend_from_slice(&size_placeholder);
-
-            // Paraglob data
-            section.extend_from_slice(&paraglob_bytes);
-
-            // Mappings: pattern_count + data offsets
-            let pattern_count = pattern_data.len() as u32;
-            section.extend_from_slice(&pattern_count.to_le_bytes());
-            for (_pattern_id, data_offset) in pattern_data {
-                section.extend_from_slice(&data_offset.to_le_bytes());
-            }
-
-            // Fill in sizes
-            let total_size = section.len() as u32;
-            let paraglob_size = paraglob_bytes.len() as u32;
-            section[0..4].copy_from_slice(&total_size.to_le_bytes());
-            section[4..8].copy_from_slice(&paraglob_size.to_le_bytes());
-
-            (true, section)
-        } else {
-            (false, Vec::new())
-        };
-
-        // Build literal hash table section for literal_entries
-        let (has_literals, literal_section_bytes) = if !literal_entries.is_empty() {
-            let mut literal_builder = LiteralHashBuilder::new(self.match_mode);
-            let mut literal_pattern_data = Vec::with_capacity(literal_entries.len());
-
-            for (next_pattern_id, (literal, data_offset)) in literal_entries.iter().enumerate() {
-                literal_builder.add_pattern(literal, next_pattern_id as u32);
-                literal_pattern_data.push((next_pattern_id as u32, *data_offset));
-            }
-
-            let literal_bytes = literal_builder.build(&literal_pattern_data)?;
-            (true, literal_bytes)
-        } else {
-            (false, Vec::new())
-        };
+        // The three sections only share the (already final) data offsets,
+        // so build them side by side
+        let match_mode = self.match_mode;
+        let ip_stride_index = self.ip_stride_index;
+        let glob_dfa_depth = self.glob_dfa_depth;
+        let glob_byte_classes = self.glob_byte_classes;
+        let perfect_hash = self.perfect_hash_literals;
+        let (ip_result, (glob_result, literal_result)) = rayon::join(
+            || timed(|| build_ip_section(&mut ip_entries, ip_stride_index)),
+            || {
+                rayon::join(
+                    || {
+                        timed(|| {
+                            build_glob_section(
+                                match_mode,
+                                glob_dfa_depth,
+                                glob_byte_classes,
+                                &glob_entries,
+                            )
+                        })
+                    },
+                    || timed(|| build_literal_section(match_mode, &literal_entries, perfect_hash)),
+                )
+            },
+        );
+        let (ip_section, ip_tree_time) = ip_result;
+        let (glob_section, globs_time) = glob_result;
+        let (literal_section, literals_time) = literal_result;
+
+        let assemble_start = Instant::now();
+        let IpSection {
+            tree_bytes: ip_tree_bytes,
+            node_count,
+            record_size,
+            ip_version,
+            stride_bytes: stride_section_bytes,
+        } = ip_section?;
+        let glob_section_bytes = glob_section?;
+        let literal_section_bytes = literal_section?;
+        let has_globs = !glob_entries.is_empty();
+        let has_literals = !literal_entries.is_empty();
+        let prefilter_section_bytes = (self.prefilter && (has_globs || has_literals))
+            .then(|| build_prefilter_section(match_mode, &literal_entries, &glob_entries));
 
         // Assemble final database - always use MMDB format
         let mut database = Vec::new();
@@ -626,9 +790,11 @@ impl MmdbBuilder {
             );
 
             // Literal section offset (after pattern section if present)
-            // 0 means no literal section present
+            // 0 means no literal section present. Perfect hash tables are
+            // 64-byte aligned so their 32-byte slots never straddle a line
+            let literal_align = if perfect_hash { 64 } else { 1 };
             let literal_offset = if has_literals {
-                if has_globs {
+                let unaligned = if has_globs {
                     tree_and_separator_size
                         + data_section_size
                         + padding_before_paraglob
@@ -637,7 +803,8 @@ impl MmdbBuilder {
                         + 16
                 } else {
                     tree_and_separator_size + data_section_size + 16 // +16 for "MMDB_LITERAL" separator
-                }
+                };
+                unaligned.next_multiple_of(literal_align)
             } else {
                 0 // No literal section
             };
@@ -646,14 +813,51 @@ impl MmdbBuilder {
                 DataValue::Uint32(literal_offset as u32),
             );
 
-            // Encode metadata
-            let mut meta_encoder = DataEncoder::new();
-            let metadata_value = DataValue::Map(metadata);
-            meta_encoder.encode(&metadata_value);
-            let metadata_bytes = meta_encoder.into_bytes();
+            // IP stride index offset (after all other sections, 64-byte aligned
+            // so every stride node is one cache line). 0 means no index present
+            let glob_section_end = if has_globs {
+                pattern_offset + glob_section_bytes.len()
+            } else {
+                tree_and_separator_size + data_section_size
+            };
+            let sections_end = if has_literals {
+                literal_offset + literal_section_bytes.len()
+            } else {
+                glob_section_end
+            };
+            let stride_offset = if stride_section_bytes.is_some() {
+                (sections_end + 16).next_multiple_of(64) // +16 for "MMDB_IPSTRIDE" separator
+            } else {
+                0 // No stride index
+            };
+            metadata.insert(
+                "ip_stride_section_offset".to_string(),
+                DataValue::Uint32(stride_offset as u32),
+            );
 
-            // Save metadata for end of file (will be added after pattern section)
-            // This ensures it's in the last 128KB for the metadata marker search
+            // Prefilter offset (after everything else, 64-byte aligned so no
+            // 32-byte block straddles a cache line). 0 means no prefilter
+            let stride_end = match &stride_section_bytes {
+                Some(stride_bytes) => stride_offset + stride_bytes.len(),
+                None => sections_end,
+            };
+            let prefilter_offset = if prefilter_section_bytes.is_some() {
+                (stride_end + 16).next_multiple_of(64) // +16 for "MMDB_PREFILTER" separator
+            } else {
+                0 // No prefilter
+            };
+            metadata.insert(
+                "prefilter_section_offset".to_string(),
+                DataValue::Uint32(prefilter_offset as u32),
+            );
+
+            // Delta databases: where the shared tombstone record lives
+            if let Some(offset) = self.tombstone_offset {
+                metadata.insert(
+                    crate::delta::TOMBSTONE_METADATA_KEY.to_string(),
+                    DataValue::Uint32(offset),
+                );
+            }
 
             // Add MMDB_PATTERN separator before globs (if any)
             if has_globs {
@@ -663,16 +867,51 @@ impl MmdbBuilder {
 
             // Add MMDB_LITERAL separator before literals (if any)
             if has_literals {
+                database.resize(literal_offset - 16, 0);
                 database.extend_from_slice(b"MMDB_LITERAL\x00\x00\x00\x00");
                 database.extend_from_slice(&literal_section_bytes);
             }
 
+            // Pad, then add MMDB_IPSTRIDE separator before the stride index (if any)
+            if let Some(stride_bytes) = &stride_section_bytes {
+                database.resize(stride_offset - 16, 0);
+                database.extend_from_slice(crate::mmdb::stride::STRIDE_SEPARATOR);
+                database.extend_from_slice(stride_bytes);
+            }
+
+            // Pad, then add MMDB_PREFILTER separator before the prefilter (if any)
+            if let Some(prefilter_bytes) = &prefilter_section_bytes {
+                database.resize(prefilter_offset - 16, 0);
+                database.extend_from_slice(crate::prefilter::PREFILTER_SEPARATOR);
+                database.extend_from_slice(prefilter_bytes);
+            }
+
+            // Checksum the finished layout so trusted opens can skip parsing
+            let checksum = crate::mmdb::header_checksum(&database, &metadata);
+            metadata.insert(
+                crate::mmdb::HEADER_CHECKSUM_KEY.to_string(),
+                DataValue::Uint64(checksum),
+            );
+
+            // Encode metadata
+            let mut meta_encoder = DataEncoder::new();
+            let metadata_value = DataValue::Map(metadata);
+            meta_encoder.encode(&metadata_value);
+            let metadata_bytes = meta_encoder.into_bytes();
+
             // Add metadata at the END of the file so it's within the 128KB search window
             database.extend_from_slice(b"\xAB\xCD\xEFMaxMind.com");
             database.extend_from_slice(&metadata_bytes);
         }
 
-        Ok(database)
+        let timings = BuildTimings {
+            ip_tree: ip_tree_time,
+            globs: globs_time,
+            literals: literals_time,
+            assemble: assemble_start.elapsed(),
+            total: build_start.elapsed(),
+        };
+        Ok((database, timings))
     }
 
     /// Get statistics about the builder
@@ -711,6 +950,214 @@ pub struct BuilderStats {
     pub glob_entries: usize,
 }
 
+/// How long each phase of [`MmdbBuilder::build_timed`] took
+#[derive(Debug, Clone, Copy, Default)]
+pub struct BuildTimings {
+    /// Sorting IP entries, building and serializing the IP tree (and stride index)
+    pub ip_tree: Duration,
+    /// Compiling glob patterns into the Aho-Corasick pattern section
+    pub globs: Duration,
+    /// Building the literal hash table section
+    pub literals: Duration,
+    /// Writing metadata and concatenating the sections
+    pub assemble: Duration,
+    /// Wall-clock time of the whole build
+    pub total: Duration,
+}
+
+/// Serialized IP tree section and its shape
+struct IpSection {
+    tree_bytes: Vec<u8>,
+    node_count: u32,
+    record_size: RecordSize,
+    ip_version: u32,
+    /// Optional multi-bit stride index, built alongside the IP tree
+    stride_bytes: Option<Vec<u8>>,
+}
+
+/// FxHash of an entry's data, the key for builder-level deduplication
+pub(crate) fn hash_data(data_value: &DataValue) -> u64 {
+    // Fast hash computation without string allocation
+    let mut hasher = FxHasher::default();
+    data_value.hash(&mut hasher);
+    hasher.finish()
+}
+
+/// Run `f`, returning its result and how long it took
+fn timed<T>(f: impl FnOnce() -> T) -> (T, Duration) {
+    let start = Instant::now();
+    let result = f();
+    (result, start.elapsed())
+}
+
+/// Build the IP tree section (sorts `ip_entries` in place)
+fn build_ip_section(
+    ip_entries: &mut [(IpAddr, u8, u32)],
+    ip_stride_index: bool,
+) -> Result<IpSection, ParaglobError> {
+    // Always build IP tree structure (even if empty) to maintain MMDB format
+    // This ensures pattern-only databases still work with the Database API
+    if ip_entries.is_empty() {
+        // Empty IP tree - create minimal valid tree
+        let record_size = RecordSize::Bits24;
+        let tree_builder = IpTreeBuilder::new_v4(record_size);
+        let (tree_bytes, node_count) = tree_builder.build()?;
+        return Ok(IpSection {
+            tree_bytes,
+            node_count,
+            record_size,
+            ip_version: 4,
+            stride_bytes: None,
+        });
+    }
+
+    // Determine IP version needed
+    let needs_v6 = ip_entries.iter().any(|(addr, _, _)| addr.is_ipv6());
+
+    // Choose record size based on expected tree size
+    // For /32 IPs, worst case is ~ip_count nodes
+    // 24-bit: max 16,777,216 nodes (16M IPs)
+    // 28-bit: max 268,435,456 nodes (268M IPs)
+    // 32-bit: max 4,294,967,296 nodes (4.2B IPs)
+    let estimated_nodes = ip_entries.len();
+    let record_size = if estimated_nodes > 200_000_000 {
+        // Over 200M IPs - use 32-bit for safety
+        RecordSize::Bits32
+    } else if estimated_nodes > 15_000_000 {
+        // Over 15M IPs - use 28-bit
+        RecordSize::Bits28
+    } else {
+        // Under 15M IPs - use 24-bit (most common)
+        RecordSize::Bits24
+    };
+
+    // Sort IPs by prefix length (more specific first), then by address
+    // This minimizes tree reorganization and backfill operations
+    ip_entries.par_sort_unstable_by(|(addr1, prefix1, _), (addr2, prefix2, _)| {
+        prefix2.cmp(prefix1).then_with(|| addr1.cmp(addr2))
+    });
+
+    let mut tree_builder = if needs_v6 {
+        IpTreeBuilder::new_v6(record_size)
+    } else {
+        IpTreeBuilder::new_v4(record_size)
+    };
+
+    // Pre-allocate nodes (estimate: ~1.5x entries for typical CIDR distributions)
+    tree_builder.reserve_nodes(estimated_nodes + estimated_nodes / 2);
+
+    // Insert all IP entries using pre-encoded offsets (top-level subtrees
+    // are built in parallel for large inputs)
+    tree_builder.insert_all(ip_entries)?;
+
+    // Build the tree
+    let (tree_bytes, node_count) = tree_builder.build()?;
+
+    // Skipped (None) if data offsets don't fit the index's entries
+    let stride_bytes = if ip_stride_index {
+        tree_builder.build_stride_index()
+    } else {
+        None
+    };
+
+    Ok(IpSection {
+        tree_bytes,
+        node_count,
+        record_size,
+        ip_version: if needs_v6 { 6 } else { 4 },
+        stride_bytes,
+    })
+}
+
+/// Build the glob pattern section (empty if there are no globs)
+fn build_glob_section(
+    match_mode: MatchMode,
+    dfa_depth: Option<u8>,
+    byte_classes: bool,
+    glob_entries: &[(&str, u32)],
+) -> Result<Vec<u8>, ParaglobError> {
+    // Build glob pattern section if we have glob entries (NOT literals)
+    if glob_entries.is_empty() {
+        return Ok(Vec::new());
+    }
+
+    let mut pattern_builder = ParaglobBuilder::new(match_mode).with_byte_classes(byte_classes);
+    if let Some(depth) = dfa_depth {
+        pattern_builder = pattern_builder.with_dfa_depth(depth);
+    }
+    let mut pattern_data = Vec::with_capacity(glob_entries.len());
+
+    for (pattern, data_offset) in glob_entries {
+        let pattern_id = pattern_builder.add_pattern(pattern)?;
+        pattern_data.push((pattern_id, *data_offset));
+    }
+
+    let paraglob = pattern_builder.build()?;
+    let paraglob_bytes = paraglob.buffer().to_vec();
+
+    // Build complete pattern section: [total_size][paraglob_size][paraglob_data][mappings]
+    let mut section = Vec::new();
+
+    // Will fill in sizes at the end
+    let size_placeholder = vec![0u8; 8]; // 2 u32s
+    section.extend_from_slice(&size_placeholder);
+
+    // Paraglob data
+    section.extend_from_slice(&paraglob_bytes);
+
+    // Mappings: pattern_count + data offsets
+    let pattern_count = pattern_data.len() as u32;
+    section.extend_from_slice(&pattern_count.to_le_bytes());
+    for (_pattern_id, data_offset) in pattern_data {
+        section.extend_from_slice(&data_offset.to_le_bytes());
+    }
+
+    // Fill in sizes
+    let total_size = section.len() as u32;
+    let paraglob_size = paraglob_bytes.len() as u32;
+    section[0..4].copy_from_slice(&total_size.to_le_bytes());
+    section[4..8].copy_from_slice(&paraglob_size.to_le_bytes());
+
+    Ok(section)
+}
+
+/// Build the literal hash table section (empty if there are no literals)
+fn build_literal_section(
+    match_mode: MatchMode,
+    literal_entries: &[(&str, u32)],
+    perfect_hash: bool,
+) -> Result<Vec<u8>, ParaglobError> {
+    if literal_entries.is_empty() {
+        return Ok(Vec::new());
+    }
+
+    let mut literal_builder = LiteralHashBuilder::new(match_mode).with_perfect_hash(perfect_hash);
+    let mut literal_pattern_data = Vec::with_capacity(literal_entries.len());
+
+    for (next_pattern_id, (literal, data_offset)) in literal_entries.iter().enumerate() {
+        literal_builder.add_pattern(literal, next_pattern_id as u32);
+        literal_pattern_data.push((next_pattern_id as u32, *data_offset));
+    }
+
+    literal_builder.build(&literal_pattern_data)
+}
+
+/// Build the Bloom prefilter section over literals and glob ends
+fn build_prefilter_section(
+    match_mode: MatchMode,
+    literal_entries: &[(&str, u32)],
+    glob_entries: &[(&str, u32)],
+) -> Vec<u8> {
+    let mut prefilter = PrefilterBuilder::new(match_mode);
+    for (literal, _) in literal_entries {
+        prefilter.add_literal(literal);
+    }
+    for (glob, _) in glob_entries {
+        prefilter.add_glob(glob);
+    }
+    prefilter.build()
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -24,6 +24,8 @@
 //! [Data section: optional (v2+)]
 //! [Data mappings: optional (v2+)]
 //! [AC Literal Mapping: optional (v3+)]
+//! [Byte-class map: optional (v5)]
+//! [Glob programs: optional, see crate::glob_program]
 //! ```
 //!
 //! # Design Principles
@@ -42,6 +44,14 @@ pub const MAGIC: &[u8; 8] = b"PARAGLOB";
 /// Current format version (v4: uses ACNodeHot for 50% memory reduction)
 pub const VERSION: u32 = 4;
 
+/// v4 plus DFA automaton states ([`StateKind::Dfa`]) and byte classes
+///
+/// Only written when the automaton has DFA states or a byte-class map
+/// ([`ParaglobHeader::byte_classes_offset`]), so files built without them
+/// stay readable by v4-only readers, and files with them are rejected by
+/// those readers instead of silently missing matches.
+pub const VERSION_V5: u32 = 5;
+
 /// Previous format version (v3: adds AC literal mapping for zero-copy loading)
 pub const VERSION_V3: u32 = 3;
 
@@ -61,13 +71,14 @@ pub const VERSION_V1: u32 = 1;
 /// - v2 (96 bytes): Adds data section support for pattern-associated data
 /// - v3 (104 bytes): Adds AC literal mapping for O(1) zero-copy loading
 /// - v4 (104 bytes): Uses ACNodeHot (16-byte) instead of ACNode (32-byte) - BREAKING
+/// - v5 (104 bytes): v4 plus DFA states; only used when the automaton has them
 #[repr(C)]
 #[derive(Debug, Clone, Copy, FromBytes, IntoBytes, Immutable, KnownLayout)]
 pub struct ParaglobHeader {
     /// Magic bytes: "PARAGLOB"
     pub magic: [u8; 8],
 
-    /// Format version (currently 4)
+    /// Format version (4, or 5 when the automaton has DFA states)
     pub version: u32,
 
     /// Match mode: 0=CaseSensitive, 1=CaseInsensitive
@@ -83,8 +94,12 @@ pub struct ParaglobHeader {
     /// Total size of AC edges data
     pub ac_edges_size: u32,
 
-    /// Total size of AC pattern ID arrays
-    pub ac_patterns_size: u32,
+    /// Offset to the compiled glob program section (0 = none)
+    ///
+    /// Formerly the AC pattern ID array size, which v4+ writers leave at
+    /// zero. Readers that predate it verify globs from the pattern strings
+    /// and ignore the section (see [`crate::glob_program`]).
+    pub glob_programs_offset: u32,
 
     // Pattern section
     /// Total number of original glob patterns
@@ -106,8 +121,9 @@ pub struct ParaglobHeader {
     /// Offset to meta-word mapping array
     pub meta_word_mappings_offset: u32,
 
-    /// Total size of pattern reference arrays
-    pub pattern_refs_size: u32,
+    /// Size of the compiled glob program section (formerly the pattern
+    /// reference array size, always zero in v4+ files without programs)
+    pub glob_programs_size: u32,
 
     /// Number of pure wildcard patterns (no literals)
     pub wildcard_count: u32,
@@ -145,8 +161,11 @@ pub struct ParaglobHeader {
     /// - Bit 1-31: reserved
     pub data_flags: u32,
 
-    /// Reserved for future v2+ features
-    pub reserved_v2: u32,
+    /// Offset to the 256-byte byte→class map (0 = none, v5)
+    ///
+    /// When set, AC edges are keyed by class instead of byte and dense
+    /// tables have one entry per class (see `ac_offset::ByteClasses`).
+    pub byte_classes_offset: u32,
 
     // ===== v3 ADDITIONS (8 bytes) =====
     /// Offset to AC literal→pattern mapping table (0 = no mapping, requires reconstruction)
@@ -174,6 +193,12 @@ pub enum StateKind {
     Sparse = 2,
     /// 9+ transitions - dense lookup table (2-5% of states)
     Dense = 3,
+    /// DFA state - dense lookup table with failure links folded in
+    ///
+    /// Every byte has an entry and 0 means the root, so a lookup never
+    /// falls back to failure links. Opt-in per database for hot shallow
+    /// states (see `ParaglobBuilder::with_dfa_depth`).
+    Dfa = 4,
 }
 
 impl StateKind {
@@ -184,6 +209,7 @@ impl StateKind {
         table[1] = Some(StateKind::One);
         table[2] = Some(StateKind::Sparse);
         table[3] = Some(StateKind::Dense);
+        table[4] = Some(StateKind::Dfa);
         table
     };
 
@@ -207,6 +233,10 @@ impl StateKind {
 /// - **One** (1 transition): Character and target stored inline (no indirection!)
 /// - **Sparse** (2-8 transitions): Offset to edge array, linear search
 /// - **Dense** (9+ transitions): Offset to 256-entry lookup table, O(1) access
+/// - **Dfa**: Offset to 256-entry table that already includes failure transitions
+///
+/// With a byte-class map, characters are class ids and both tables have one
+/// entry per class instead of 256.
 ///
 /// # Field Ordering
 ///
@@ -229,9 +259,9 @@ pub struct ACNodeHot {
     /// Number of pattern IDs at this node - max 255 patterns per node
     pub pattern_count: u8,
 
-    /// SPARSE/DENSE/ONE encoding: offset-based lookup
+    /// SPARSE/DENSE/DFA/ONE encoding: offset-based lookup
     /// - SPARSE: offset to ACEdge array
-    /// - DENSE: offset to DenseLookup table
+    /// - DENSE/DFA: offset to DenseLookup table
     /// - ONE: target offset for single transition
     pub edges_offset: u32,
 
@@ -460,14 +490,14 @@ impl ParaglobHeader {
             ac_node_count: 0,
             ac_nodes_offset: 0,
             ac_edges_size: 0,
-            ac_patterns_size: 0,
+            glob_programs_offset: 0,
             pattern_count: 0,
             patterns_offset: 0,
             pattern_strings_offset: 0,
             pattern_strings_size: 0,
             meta_word_mapping_count: 0,
             meta_word_mappings_offset: 0,
-            pattern_refs_size: 0,
+            glob_programs_size: 0,
             wildcard_count: 0,
             total_buffer_size: 0,
             endianness: EndiannessMarker::LittleEndian as u8,
@@ -478,7 +508,7 @@ impl ParaglobHeader {
             mapping_table_offset: 0,
             mapping_count: 0,
             data_flags: 0,
-            reserved_v2: 0,
+            byte_classes_offset: 0,
             // v3 fields
             ac_literal_map_offset: 0,
             ac_literal_map_count: 0,
@@ -490,8 +520,8 @@ impl ParaglobHeader {
         if &self.magic != MAGIC {
             return Err("Invalid magic bytes");
         }
-        if self.version != VERSION {
-            return Err("Unsupported version - only v4 format supported");
+        if self.version != VERSION && self.version != VERSION_V5 {
+            return Err("Unsupported version - only v4 and v5 formats supported");
         }
         Ok(())
     }
@@ -523,6 +553,23 @@ impl ParaglobHeader {
             }
         }
 
+        // Validate glob program section if present
+        if self.has_glob_programs() {
+            let start = self.glob_programs_offset as usize;
+            let size = self.glob_programs_size as usize;
+            if start.checked_add(size).is_none_or(|end| end > buffer_len) {
+                return Err("Glob program section out of bounds");
+            }
+        }
+
+        // Validate byte-class map if present
+        if self.byte_classes_offset != 0 {
+            let offset = self.byte_classes_offset as usize;
+            if offset.checked_add(256).is_none_or(|end| end > buffer_len) {
+                return Err("Byte-class map out of bounds");
+            }
+        }
+
         // Validate AC nodes section
         if self.ac_node_count > 0 {
             let offset = self.ac_nodes_offset as usize;
@@ -572,6 +619,11 @@ impl ParaglobHeader {
         self.ac_literal_map_count > 0 && self.ac_literal_map_offset > 0
     }
 
+    /// Check if this file has compiled glob programs
+    pub fn has_glob_programs(&self) -> bool {
+        self.glob_programs_offset > 0 && self.glob_programs_size > 0
+    }
+
     /// Check if data is inline (true) or external references (false)
     pub fn has_inline_data(&self) -> bool {
         (self.data_flags & 0x1) != 0
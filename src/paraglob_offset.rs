@@ -11,21 +11,24 @@
 //! 2. AC automaton data (nodes, edges, pattern IDs)
 //! 3. Pattern entries (metadata for each pattern)
 //! 4. Pattern strings (null-terminated)
-//! 5. Glob pattern data (for glob verification)
+//! 5. Compiled glob programs (for glob verification)
 //!
 //! All matching operations work directly on this buffer using offsets.
 
-use crate::ac_offset::{ACAutomaton, MatchMode as ACMatchMode};
+use crate::ac_offset::{ACAutomaton, ACBuildOptions, MatchMode as ACMatchMode};
 use crate::data_section::{DataEncoder, DataValue};
 use crate::error::ParaglobError;
 use crate::glob::{GlobPattern, MatchMode as GlobMatchMode};
+use crate::glob_program::{GlobProgramBuilder, GlobPrograms};
 use crate::offset_format::{
     read_cstring, read_str_checked, ACEdge, ParaglobHeader, PatternDataMapping, PatternEntry,
-    SingleWildcard,
+    SingleWildcard, VERSION_V5,
 };
-use std::cell::RefCell;
+use crate::profile::ScanCounters;
 use std::collections::{HashMap, HashSet};
 use std::mem;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Mutex, MutexGuard, PoisonError};
 use zerocopy::Ref;
 
 /// Pattern classification for optimization
@@ -226,6 +229,10 @@ pub struct ParaglobBuilder {
     patterns: Vec<PatternType>,
     mode: ACMatchMode,
     pattern_set: std::collections::HashSet<String>,
+    /// Write AC states up to this depth as DFA states
+    dfa_depth: Option<u8>,
+    /// Key AC transitions by byte class instead of byte
+    byte_classes: bool,
 }
 
 impl ParaglobBuilder {
@@ -242,9 +249,66 @@ impl ParaglobBuilder {
             patterns: Vec::new(),
             mode: ac_mode,
             pattern_set: std::collections::HashSet::new(),
+            dfa_depth: None,
+            byte_classes: false,
         }
     }
 
+    /// Write automaton states up to `depth` as DFA states
+    ///
+    /// A DFA state is a full 256-entry transition table with failure links
+    /// already followed, so scanning from it is one indexed load per byte.
+    /// `0` converts only the root, `1` the root and its children, and so
+    /// on. Each converted state adds 1KB to the file; large pattern sets
+    /// spend most of their scan time in these shallow states.
+    ///
+    /// Files with DFA states are written as format v5, which older readers
+    /// reject rather than mis-match.
+    ///
+    /// # Example
+    /// ```
+    /// use matchy::ParaglobBuilder;
+    /// use matchy::glob::MatchMode;
+    ///
+    /// let mut builder = ParaglobBuilder::new(MatchMode::CaseSensitive).with_dfa_depth(1);
+    /// builder.add_pattern("*.evil.com").unwrap();
+    /// let pg = builder.build().unwrap();
+    /// assert_eq!(pg.find_all("www.evil.com"), vec![0]);
+    /// assert_eq!(pg.version(), 5);
+    /// ```
+    pub fn with_dfa_depth(mut self, depth: u8) -> Self {
+        self.dfa_depth = Some(depth);
+        self
+    }
+
+    /// Key automaton transitions by byte class instead of raw byte
+    ///
+    /// Bytes that behave the same in every literal share a class; bytes no
+    /// literal uses share class 0, which always returns to the root. Dense
+    /// and DFA tables then need one entry per class instead of 256, which
+    /// for typical domain and path literals (~40 distinct bytes) cuts each
+    /// table from 1KB to under 200 bytes. In case-insensitive mode the map
+    /// also folds case, so queries skip the lowercase copy.
+    ///
+    /// The 256-byte map is stored in the file, which is written as format
+    /// v5.
+    ///
+    /// # Example
+    /// ```
+    /// use matchy::ParaglobBuilder;
+    /// use matchy::glob::MatchMode;
+    ///
+    /// let mut builder = ParaglobBuilder::new(MatchMode::CaseInsensitive).with_byte_classes(true);
+    /// builder.add_pattern("*.evil.com").unwrap();
+    /// let pg = builder.build().unwrap();
+    /// assert_eq!(pg.find_all("WWW.EVIL.COM"), vec![0]);
+    /// assert_eq!(pg.version(), 5);
+    /// ```
+    pub fn with_byte_classes(mut self, enabled: bool) -> Self {
+        self.byte_classes = enabled;
+        self
+    }
+
     /// Add a pattern without associated data
     ///
     /// Returns the pattern ID that can be used later to retrieve data or identify matches.
@@ -375,13 +439,10 @@ impl ParaglobBuilder {
         Ok(Paraglob {
             buffer: BufferStorage::Owned(buffer),
             mode,
-            glob_cache: RefCell::new(HashMap::new()),
+            id: next_matcher_id(),
             ac_literal_hash,
             pattern_data_map,
-            candidate_buffer: RefCell::new(HashSet::new()),
-            ac_literal_buffer: RefCell::new(HashSet::new()),
-            result_buffer: RefCell::new(Vec::new()),
-            normalized_text_buffer: RefCell::new(Vec::new()),
+            scratch: Mutex::new(ParaglobScratch::new()),
         })
     }
 
@@ -438,7 +499,11 @@ impl ParaglobBuilder {
         // Build AC automaton
         let ac_automaton = if !ac_literals.is_empty() {
             let ac_refs: Vec<&str> = ac_literals.iter().map(|s| s.as_str()).collect();
-            ACAutomaton::build(&ac_refs, self.mode)?
+            let options = ACBuildOptions {
+                dfa_depth: self.dfa_depth,
+                byte_classes: self.byte_classes,
+            };
+            ACAutomaton::build_with_options(&ac_refs, self.mode, options)?
         } else {
             ACAutomaton::new(self.mode)
         };
@@ -539,6 +604,38 @@ impl ParaglobBuilder {
         let ac_hash_bytes = ac_hash_builder.build()?;
         let ac_literal_map_size = ac_hash_bytes.len();
 
+        // Byte-class map (v5, optional)
+        let byte_classes_start = ac_literal_map_start + ac_literal_map_size;
+        let byte_classes_size = if ac_automaton.byte_classes().is_some() {
+            256
+        } else {
+            0
+        };
+
+        // Compiled glob programs go last
+        let glob_mode = match self.mode {
+            ACMatchMode::CaseSensitive => GlobMatchMode::CaseSensitive,
+            ACMatchMode::CaseInsensitive => GlobMatchMode::CaseInsensitive,
+        };
+        let mut glob_programs = GlobProgramBuilder::new(self.patterns.len());
+        for pat in &self.patterns {
+            if let PatternType::Glob { pattern, id, .. }
+            | PatternType::PureWildcard { pattern, id, .. } = pat
+            {
+                // A pattern without a program is verified by the interpreter
+                if let Ok(glob) = GlobPattern::new(pattern, glob_mode) {
+                    glob_programs.add(*id, &glob);
+                }
+            }
+        }
+        let glob_programs_bytes = if glob_programs.is_empty() {
+            Vec::new()
+        } else {
+            glob_programs.build()
+        };
+        let glob_programs_start = byte_classes_start + byte_classes_size;
+        let glob_programs_size = glob_programs_bytes.len();
+
         // Allocate buffer (including padding for alignment)
         let total_size = header_size
             + ac_size
@@ -550,11 +647,16 @@ impl ParaglobBuilder {
             + data_section_size
             + data_padding  // Alignment padding before mapping table
             + mappings_size
-            + ac_literal_map_size;
+            + ac_literal_map_size
+            + byte_classes_size
+            + glob_programs_size;
         let mut buffer = vec![0u8; total_size];
 
         // Write header (v2 if we have data, v1 otherwise)
         let mut header = ParaglobHeader::new();
+        if (self.dfa_depth.is_some() || byte_classes_size > 0) && !ac_literals.is_empty() {
+            header.version = VERSION_V5;
+        }
         header.match_mode = match self.mode {
             ACMatchMode::CaseSensitive => 0,
             ACMatchMode::CaseInsensitive => 1,
@@ -583,6 +685,17 @@ impl ParaglobBuilder {
         header.ac_literal_map_offset = ac_literal_map_start as u32;
         header.ac_literal_map_count = ac_literal_to_patterns.len() as u32;
 
+        // v5 byte-class map
+        if byte_classes_size > 0 {
+            header.byte_classes_offset = byte_classes_start as u32;
+        }
+
+        // Compiled glob programs (ignored by readers that predate them)
+        if glob_programs_size > 0 {
+            header.glob_programs_offset = glob_programs_start as u32;
+            header.glob_programs_size = glob_programs_size as u32;
+        }
+
         unsafe {
             let ptr = buffer.as_mut_ptr() as *mut ParaglobHeader;
             ptr.write(header);
@@ -656,6 +769,16 @@ impl ParaglobBuilder {
                 .copy_from_slice(&ac_hash_bytes);
         }
 
+        // Write byte-class map (v5)
+        if let Some(classes) = ac_automaton.byte_classes() {
+            buffer[byte_classes_start..byte_classes_start + byte_classes_size]
+                .copy_from_slice(classes.map());
+        }
+
+        // Write compiled glob programs
+        buffer[glob_programs_start..glob_programs_start + glob_programs_size]
+            .copy_from_slice(&glob_programs_bytes);
+
         Ok(buffer)
     }
 }
@@ -683,6 +806,51 @@ struct PatternDataMetadata {
     count: u32,
 }
 
+/// Reusable working buffers for [`Paraglob`] queries
+///
+/// Holds the per-query collections (AC literal hits, candidate pattern IDs,
+/// results, lowercased text) and the cache of compiled glob patterns. A
+/// `Paraglob` keeps one internally for its `&self` methods; threads sharing a
+/// matcher should each own one and call [`Paraglob::find_all_with`].
+///
+/// A scratch remembers the ID of the matcher it last served and drops its
+/// compiled globs when used with a different one, so moving it between
+/// matchers is safe (even to one built at a freed matcher's address).
+#[derive(Default)]
+pub struct ParaglobScratch {
+    /// ID of the matcher the glob cache belongs to (0 = none yet)
+    owner: u64,
+    /// Compiled glob patterns (cached on first use)
+    glob_cache: HashMap<u32, GlobPattern>,
+    /// Candidate patterns from AC literal hits
+    candidates: HashSet<u32>,
+    /// AC literal IDs found in the text
+    ac_literals: HashSet<u32>,
+    /// Final match results (sorted, deduplicated)
+    results: Vec<u32>,
+    /// Normalized text (case-insensitive matching)
+    normalized_text: Vec<u8>,
+    /// ASCII-lowercased query for compiled glob programs (case-insensitive)
+    glob_text: String,
+    /// Work done by the last query, for a sampling profiler
+    scan: ScanCounters,
+}
+
+impl ParaglobScratch {
+    /// Create empty scratch buffers
+    pub fn new() -> Self {
+        Self::default()
+    }
+}
+
+/// Source of [`Paraglob::id`] values; 0 is left for "no matcher"
+static NEXT_MATCHER_ID: AtomicU64 = AtomicU64::new(1);
+
+/// Unique ID for a newly constructed matcher
+fn next_matcher_id() -> u64 {
+    NEXT_MATCHER_ID.fetch_add(1, Ordering::Relaxed)
+}
+
 /// Offset-based Paraglob pattern matcher
 ///
 /// All data stored in a single byte buffer for zero-copy operation.
@@ -700,23 +868,16 @@ pub struct Paraglob {
     buffer: BufferStorage,
     /// Matching mode (public for Database::mode() access)
     pub(crate) mode: GlobMatchMode,
-    /// Compiled glob patterns (cached on first use)
-    /// Uses RefCell for interior mutability - allows &self methods while caching patterns
-    glob_cache: RefCell<HashMap<u32, GlobPattern>>,
+    /// Process-unique ID that scratch glob caches are keyed on
+    id: u64,
     /// Memory-mapped hash table for AC literal ID to pattern IDs mapping (O(1) lookup)
     ac_literal_hash: Option<crate::ac_literal_hash::ACLiteralHash<'static>>,
     /// Pattern ID to data mapping (lazy-loaded from buffer)
     pattern_data_map: Option<PatternDataMetadata>,
-    /// Reusable buffer for candidate patterns (avoids allocation on every query)
-    /// Uses RefCell for interior mutability - allows &self methods while mutating buffers
-    candidate_buffer: RefCell<HashSet<u32>>,
-    /// Reusable buffer for AC literal IDs (avoids allocation on every query)
-    /// Uses RefCell for interior mutability - allows &self methods while mutating buffers
-    ac_literal_buffer: RefCell<HashSet<u32>>,
-    /// Reusable buffer for final match results (avoids allocation on every query)
-    result_buffer: RefCell<Vec<u32>>,
-    /// Reusable buffer for normalized text (case-insensitive matching)
-    normalized_text_buffer: RefCell<Vec<u8>>,
+    /// Reusable query buffers and compiled globs for `&self` queries
+    /// A Mutex (rather than RefCell) keeps Paraglob Send + Sync; hot shared
+    /// callers should pass their own scratch to `find_all_with` instead
+    scratch: Mutex<ParaglobScratch>,
 }
 
 impl Paraglob {
@@ -730,13 +891,10 @@ impl Paraglob {
         Self {
             buffer: BufferStorage::Owned(Vec::new()),
             mode,
-            glob_cache: RefCell::new(HashMap::new()),
+            id: next_matcher_id(),
             ac_literal_hash: None,
             pattern_data_map: None,
-            candidate_buffer: RefCell::new(HashSet::new()),
-            ac_literal_buffer: RefCell::new(HashSet::new()),
-            result_buffer: RefCell::new(Vec::new()),
-            normalized_text_buffer: RefCell::new(Vec::new()),
+            scratch: Mutex::new(ParaglobScratch::new()),
         }
     }
 
@@ -829,8 +987,9 @@ impl Paraglob {
         }
 
         let ac_buffer = &buffer[ac_start..ac_start + ac_size];
+        let classes = Self::byte_class_map(buffer, &header);
         let mut matches = Vec::new();
-        Self::run_ac_matching_with_positions(ac_buffer, text, self.mode, &mut matches);
+        Self::run_ac_matching_with_positions(ac_buffer, classes, text, self.mode, &mut matches);
         matches
     }
 
@@ -879,198 +1038,70 @@ impl Paraglob {
         }
 
         let ac_buffer = &buffer[ac_start..ac_start + ac_size];
-        Self::run_ac_matching_with_positions_with_buffer(
-            ac_buffer,
-            text,
-            self.mode,
-            output,
-            &self.normalized_text_buffer,
-        );
-    }
-
-    /// Find all matching pattern IDs
-    pub fn find_all(&self, text: &str) -> Vec<u32> {
-        let buffer = self.buffer.as_slice();
-        if buffer.is_empty() {
-            return Vec::new();
-        }
-
-        // SAFETY: Fast path - header is at offset 0, always aligned
-        let header = unsafe {
-            if buffer.len() < mem::size_of::<ParaglobHeader>() {
-                return Vec::new();
-            }
-            let ptr = buffer.as_ptr() as *const ParaglobHeader;
-            ptr.read()
-        };
-
-        // Phase 1: Use AC automaton to find literal matches and candidate patterns
-        let ac_start = header.ac_nodes_offset as usize;
-        let ac_size = header.ac_edges_size as usize;
-
-        // Reuse buffers (clear from previous query)
-        self.candidate_buffer.borrow_mut().clear();
-        self.ac_literal_buffer.borrow_mut().clear();
-
-        if ac_size > 0 {
-            // Extract AC buffer and run AC matching on it
-            let ac_buffer = &buffer[ac_start..ac_start + ac_size];
-
-            // Run AC automaton matching directly on text bytes (AC handles case-insensitivity)
-            let text_bytes = text.as_bytes();
-            let mode = self.mode;
-            Self::run_ac_matching_into_static(
+        let classes = Self::byte_class_map(buffer, &header);
+        if classes.is_some() || self.mode == GlobMatchMode::CaseSensitive {
+            // No lowercase copy needed, so no need to take the scratch lock
+            Self::run_ac_matching_with_positions_with_buffer(
                 ac_buffer,
-                text_bytes,
-                mode,
-                &mut self.ac_literal_buffer.borrow_mut(),
+                classes,
+                text,
+                self.mode,
+                output,
+                &mut Vec::new(),
+            );
+        } else {
+            Self::run_ac_matching_with_positions_with_buffer(
+                ac_buffer,
+                None,
+                text,
+                self.mode,
+                output,
+                &mut self.lock_scratch().normalized_text,
             );
-
-            // Map AC literal IDs to pattern IDs using hash table lookup (O(1))
-            if !self.ac_literal_buffer.borrow().is_empty() {
-                if let Some(ref ac_hash) = self.ac_literal_hash {
-                    for &literal_id in self.ac_literal_buffer.borrow().iter() {
-                        let pattern_ids = ac_hash.lookup_slice(literal_id);
-                        self.candidate_buffer.borrow_mut().extend(pattern_ids);
-                    }
-                }
-            }
-        }
-
-        // Phase 2: Verify candidates (or all patterns if no AC)
-        // Reuse result buffer to avoid allocation
-        self.result_buffer.borrow_mut().clear();
-
-        // CRITICAL: Always check pure wildcards first (patterns with no literals)
-        // These must be checked on every query regardless of AC results
-        // Wildcards are stored after pattern strings with 8-byte alignment padding
-        let unaligned_offset =
-            (header.pattern_strings_offset + header.pattern_strings_size) as usize;
-        let alignment = 8;
-        let padding = (alignment - (unaligned_offset % alignment)) % alignment;
-        let wildcards_offset = unaligned_offset + padding;
-        let wildcard_count = header.wildcard_count as usize;
-
-        if wildcard_count > 0 {
-            for i in 0..wildcard_count {
-                let wildcard_offset_val = wildcards_offset + i * mem::size_of::<SingleWildcard>();
-                let buffer_slice = match buffer.get(wildcard_offset_val..) {
-                    Some(s) => s,
-                    None => continue, // Skip corrupted wildcard
-                };
-                let (wildcard_ref, _) = match Ref::<_, SingleWildcard>::from_prefix(buffer_slice) {
-                    Ok(r) => r,
-                    Err(_) => continue, // Skip corrupted wildcard
-                };
-                let wildcard = *wildcard_ref;
-
-                // Look up PatternEntry to get the string length
-                let patterns_offset = header.patterns_offset as usize;
-                let entry_offset = patterns_offset
-                    + (wildcard.pattern_id as usize) * mem::size_of::<PatternEntry>();
-                let entry_slice = match buffer.get(entry_offset..) {
-                    Some(s) => s,
-                    None => continue, // Skip corrupted entry
-                };
-                let (entry_ref, _) = match Ref::<_, PatternEntry>::from_prefix(entry_slice) {
-                    Ok(r) => r,
-                    Err(_) => continue, // Skip corrupted entry
-                };
-                let entry = *entry_ref;
-
-                // Validate UTF-8 on every string read
-                let pattern_str = match unsafe {
-                    read_str_checked(
-                        buffer,
-                        entry.pattern_string_offset as usize,
-                        entry.pattern_string_length as usize,
-                    )
-                } {
-                    Ok(s) => s,
-                    Err(_) => continue, // Skip corrupted pattern
-                };
-
-                // Check glob pattern - ensure it's cached first
-                if !self.glob_cache.borrow().contains_key(&wildcard.pattern_id) {
-                    self.glob_cache.borrow_mut().insert(
-                        wildcard.pattern_id,
-                        GlobPattern::new(pattern_str, self.mode).expect("Invalid wildcard pattern"),
-                    );
-                }
-
-                if self
-                    .glob_cache
-                    .borrow()
-                    .get(&wildcard.pattern_id)
-                    .unwrap()
-                    .matches(text)
-                {
-                    self.result_buffer.borrow_mut().push(wildcard.pattern_id);
-                }
-            }
         }
+    }
 
-        // Check AC candidates (patterns that have literals that were found)
-        for &pattern_id in self.candidate_buffer.borrow().iter() {
-            let patterns_offset = header.patterns_offset as usize;
-            let entry_offset =
-                patterns_offset + (pattern_id as usize) * mem::size_of::<PatternEntry>();
-            let entry_slice = match buffer.get(entry_offset..) {
-                Some(s) => s,
-                None => continue, // Skip corrupted pattern
-            };
-            let entry_ref = match Ref::<_, PatternEntry>::from_prefix(entry_slice) {
-                Ok((r, _)) => r,
-                Err(_) => continue, // Skip corrupted pattern
-            };
-            let entry = *entry_ref;
-
-            // Check if pattern matches
-            if entry.pattern_type == 0 {
-                // Literal pattern - AC automaton already confirmed this matches!
-                // No need to read string or verify, just add to results.
-                self.result_buffer.borrow_mut().push(entry.pattern_id);
-            } else {
-                // Glob pattern - need to read pattern string and do glob matching
-                // Validate UTF-8 on every string read
-                let pattern_str = match unsafe {
-                    read_str_checked(
-                        buffer,
-                        entry.pattern_string_offset as usize,
-                        entry.pattern_string_length as usize,
-                    )
-                } {
-                    Ok(s) => s,
-                    Err(_) => continue, // Skip corrupted pattern
-                };
-
-                // Ensure pattern is cached first
-                if !self.glob_cache.borrow().contains_key(&entry.pattern_id) {
-                    self.glob_cache.borrow_mut().insert(
-                        entry.pattern_id,
-                        GlobPattern::new(pattern_str, self.mode)
-                            .expect("Invalid cached glob pattern"),
-                    );
-                }
+    /// Find all matching pattern IDs
+    pub fn find_all(&self, text: &str) -> Vec<u32> {
+        let mut scratch = self.lock_scratch();
+        self.find_all_core(text, &mut scratch);
+        // Clone the result (caller owns it)
+        // Use `find_all_with` and a caller-owned scratch to avoid this allocation
+        scratch.results.clone()
+    }
 
-                if self
-                    .glob_cache
-                    .borrow()
-                    .get(&entry.pattern_id)
-                    .unwrap()
-                    .matches(text)
-                {
-                    self.result_buffer.borrow_mut().push(entry.pattern_id);
-                }
-            }
-        }
+    /// Find all matching pattern IDs using caller-provided scratch buffers
+    ///
+    /// This is the shared-matcher variant: it takes `&self`, never touches the
+    /// matcher's internal buffers, and returns a slice into `scratch` that is
+    /// valid until the scratch is used again. Give each thread its own
+    /// [`ParaglobScratch`] to query one `Paraglob` concurrently without contention.
+    ///
+    /// # Example
+    /// ```
+    /// use matchy::{Paraglob, ParaglobScratch, glob::MatchMode};
+    ///
+    /// let patterns = vec!["*.txt", "test_*"];
+    /// let pg = Paraglob::build_from_patterns(&patterns, MatchMode::CaseSensitive).unwrap();
+    ///
+    /// let mut scratch = ParaglobScratch::new();
+    /// let matches = pg.find_all_with("test_file.txt", &mut scratch);
+    /// assert_eq!(matches.len(), 2);
+    /// # Ok::<(), matchy::ParaglobError>(())
+    /// ```
+    pub fn find_all_with<'s>(&self, text: &str, scratch: &'s mut ParaglobScratch) -> &'s [u32] {
+        self.find_all_core(text, scratch);
+        &scratch.results
+    }
 
-        self.result_buffer.borrow_mut().sort_unstable();
-        self.result_buffer.borrow_mut().dedup();
-        // Clone the result (caller owns it)
-        // Note: This still allocates once per query, but it's unavoidable
-        // without changing the API to return &[u32] or using arena allocation
-        self.result_buffer.borrow().clone()
+    /// [`find_all_with`](Self::find_all_with), also returning what the scan did
+    pub(crate) fn find_all_counted<'s>(
+        &self,
+        text: &str,
+        scratch: &'s mut ParaglobScratch,
+    ) -> (&'s [u32], ScanCounters) {
+        self.find_all_core(text, scratch);
+        (&scratch.results, scratch.scan)
     }
 
     /// Find all matching pattern IDs (zero-allocation variant)
@@ -1091,57 +1122,86 @@ impl Paraglob {
     /// # Ok::<(), matchy::ParaglobError>(())
     /// ```
     pub fn find_all_ref(&mut self, text: &str) -> &[u32] {
+        // Exclusive access: take the scratch out of the mutex without locking
+        let mut scratch = mem::take(self.scratch_mut());
+        self.find_all_core(text, &mut scratch);
+        let slot = self.scratch_mut();
+        *slot = scratch;
+        &slot.results
+    }
+
+    /// Lock the internal scratch (shared by all `&self` queries on this matcher)
+    fn lock_scratch(&self) -> MutexGuard<'_, ParaglobScratch> {
+        // A panic mid-query leaves only stale scratch behind; it is cleared on next use
+        self.scratch.lock().unwrap_or_else(PoisonError::into_inner)
+    }
+
+    /// Access the internal scratch through `&mut self` (no locking needed)
+    fn scratch_mut(&mut self) -> &mut ParaglobScratch {
+        self.scratch
+            .get_mut()
+            .unwrap_or_else(PoisonError::into_inner)
+    }
+
+    /// Shared implementation of the `find_all*` family
+    ///
+    /// Leaves sorted, deduplicated pattern IDs in `scratch.results`.
+    fn find_all_core(&self, text: &str, scratch: &mut ParaglobScratch) {
+        // Reuse buffers (clear from previous query)
+        scratch.candidates.clear();
+        scratch.ac_literals.clear();
+        scratch.results.clear();
+        scratch.scan = ScanCounters::default();
+
         let buffer = self.buffer.as_slice();
-        if buffer.is_empty() {
-            return &[];
+
+        // Compiled globs are keyed by pattern ID, so they are only valid for
+        // the matcher that compiled them
+        if scratch.owner != self.id {
+            scratch.glob_cache.clear();
+            scratch.owner = self.id;
         }
 
-        let (header_ref, _) = match Ref::<_, ParaglobHeader>::from_prefix(buffer) {
-            Ok(r) => r,
-            Err(_) => return &[], // Invalid header, return empty
+        if buffer.len() < mem::size_of::<ParaglobHeader>() {
+            return;
+        }
+
+        // SAFETY: Fast path - header is at offset 0, always aligned
+        let header = unsafe {
+            let ptr = buffer.as_ptr() as *const ParaglobHeader;
+            ptr.read()
         };
-        let header = *header_ref;
 
         // Phase 1: Use AC automaton to find literal matches and candidate patterns
         let ac_start = header.ac_nodes_offset as usize;
         let ac_size = header.ac_edges_size as usize;
 
-        // Reuse buffers (clear from previous query)
-        self.candidate_buffer.borrow_mut().clear();
-        self.ac_literal_buffer.borrow_mut().clear();
-
         if ac_size > 0 {
             // Extract AC buffer and run AC matching on it
             let ac_buffer = &buffer[ac_start..ac_start + ac_size];
 
             // Run AC automaton matching directly on text bytes (AC handles case-insensitivity)
-            let text_bytes = text.as_bytes();
-            let mode = self.mode;
             Self::run_ac_matching_into_static(
                 ac_buffer,
-                text_bytes,
-                mode,
-                &mut self.ac_literal_buffer.borrow_mut(),
+                Self::byte_class_map(buffer, &header),
+                text.as_bytes(),
+                self.mode,
+                &mut scratch.ac_literals,
+                &mut scratch.normalized_text,
+                &mut scratch.scan.ac_states,
             );
 
             // Map AC literal IDs to pattern IDs using hash table lookup (O(1))
-            // Use zero-copy lookup_into to avoid allocations
-            if !self.ac_literal_buffer.borrow().is_empty() {
+            if !scratch.ac_literals.is_empty() {
                 if let Some(ref ac_hash) = self.ac_literal_hash {
-                    // Collect literal IDs first to avoid multiple borrows
-                    let literal_ids: Vec<u32> =
-                        self.ac_literal_buffer.borrow().iter().copied().collect();
-                    let mut candidates = self.candidate_buffer.borrow_mut();
-                    for literal_id in literal_ids {
-                        ac_hash.lookup_into(literal_id, &mut *candidates);
+                    for &literal_id in scratch.ac_literals.iter() {
+                        ac_hash.lookup_into(literal_id, &mut scratch.candidates);
                     }
                 }
             }
         }
 
         // Phase 2: Verify candidates (or all patterns if no AC)
-        // Reuse result buffer to avoid allocation
-        self.result_buffer.borrow_mut().clear();
 
         // CRITICAL: Always check pure wildcards first (patterns with no literals)
         // These must be checked on every query regardless of AC results
@@ -1152,69 +1212,86 @@ impl Paraglob {
         let padding = (alignment - (unaligned_offset % alignment)) % alignment;
         let wildcards_offset = unaligned_offset + padding;
         let wildcard_count = header.wildcard_count as usize;
+        let patterns_offset = header.patterns_offset as usize;
+        scratch.scan.candidates = (wildcard_count + scratch.candidates.len()) as u64;
+        let verify_start = crate::profile::sampling().then(std::time::Instant::now);
+
+        // Compiled programs compare against ASCII-lowercased text when
+        // matching case-insensitively; fold it once for every glob
+        let programs = Self::glob_programs(buffer, &header);
+        let folded = match programs {
+            Some(_) if self.mode == GlobMatchMode::CaseInsensitive => {
+                scratch.glob_text.clear();
+                scratch.glob_text.push_str(text);
+                scratch.glob_text.make_ascii_lowercase();
+                scratch.glob_text.as_str()
+            }
+            _ => text,
+        };
 
-        if wildcard_count > 0 {
-            for i in 0..wildcard_count {
-                let wildcard_offset_val = wildcards_offset + i * mem::size_of::<SingleWildcard>();
-                let buffer_slice = match buffer.get(wildcard_offset_val..) {
-                    Some(s) => s,
-                    None => continue, // Skip corrupted wildcard
-                };
-                let (wildcard_ref, _) = match Ref::<_, SingleWildcard>::from_prefix(buffer_slice) {
-                    Ok(r) => r,
-                    Err(_) => continue, // Skip corrupted wildcard
-                };
-                let wildcard = *wildcard_ref;
-
-                // Look up PatternEntry to get the string length
-                let patterns_offset = header.patterns_offset as usize;
-                let entry_offset = patterns_offset
-                    + (wildcard.pattern_id as usize) * mem::size_of::<PatternEntry>();
-                let entry_slice = match buffer.get(entry_offset..) {
-                    Some(s) => s,
-                    None => continue, // Skip corrupted entry
-                };
-                let (entry_ref, _) = match Ref::<_, PatternEntry>::from_prefix(entry_slice) {
-                    Ok(r) => r,
-                    Err(_) => continue, // Skip corrupted entry
-                };
-                let entry = *entry_ref;
-
-                // Validate UTF-8 on every string read
-                let pattern_str = match unsafe {
-                    read_str_checked(
-                        buffer,
-                        entry.pattern_string_offset as usize,
-                        entry.pattern_string_length as usize,
-                    )
-                } {
-                    Ok(s) => s,
-                    Err(_) => continue, // Skip corrupted pattern
-                };
+        for i in 0..wildcard_count {
+            let wildcard_offset_val = wildcards_offset + i * mem::size_of::<SingleWildcard>();
+            let buffer_slice = match buffer.get(wildcard_offset_val..) {
+                Some(s) => s,
+                None => continue, // Skip corrupted wildcard
+            };
+            let (wildcard_ref, _) = match Ref::<_, SingleWildcard>::from_prefix(buffer_slice) {
+                Ok(r) => r,
+                Err(_) => continue, // Skip corrupted wildcard
+            };
+            let wildcard = *wildcard_ref;
 
-                // Check glob pattern - ensure it's cached first
-                if !self.glob_cache.borrow().contains_key(&wildcard.pattern_id) {
-                    self.glob_cache.borrow_mut().insert(
-                        wildcard.pattern_id,
-                        GlobPattern::new(pattern_str, self.mode).expect("Invalid wildcard pattern"),
-                    );
+            if let Some(matched) = programs.and_then(|p| p.matches(wildcard.pattern_id, folded)) {
+                scratch.scan.globs_checked += 1;
+                if matched {
+                    scratch.results.push(wildcard.pattern_id);
+                } else {
+                    scratch.scan.globs_rejected += 1;
                 }
+                continue;
+            }
 
-                if self
-                    .glob_cache
-                    .borrow()
-                    .get(&wildcard.pattern_id)
-                    .unwrap()
-                    .matches(text)
-                {
-                    self.result_buffer.borrow_mut().push(wildcard.pattern_id);
-                }
+            // No compiled program: look up PatternEntry to get the string length
+            let entry_offset =
+                patterns_offset + (wildcard.pattern_id as usize) * mem::size_of::<PatternEntry>();
+            let entry_slice = match buffer.get(entry_offset..) {
+                Some(s) => s,
+                None => continue, // Skip corrupted entry
+            };
+            let (entry_ref, _) = match Ref::<_, PatternEntry>::from_prefix(entry_slice) {
+                Ok(r) => r,
+                Err(_) => continue, // Skip corrupted entry
+            };
+            let entry = *entry_ref;
+
+            // Validate UTF-8 on every string read
+            let pattern_str = match unsafe {
+                read_str_checked(
+                    buffer,
+                    entry.pattern_string_offset as usize,
+                    entry.pattern_string_length as usize,
+                )
+            } {
+                Ok(s) => s,
+                Err(_) => continue, // Skip corrupted pattern
+            };
+
+            scratch.scan.globs_checked += 1;
+            if Self::cached_glob_matches(
+                &mut scratch.glob_cache,
+                wildcard.pattern_id,
+                pattern_str,
+                self.mode,
+                text,
+            ) {
+                scratch.results.push(wildcard.pattern_id);
+            } else {
+                scratch.scan.globs_rejected += 1;
             }
         }
 
         // Check AC candidates (patterns that have literals that were found)
-        for &pattern_id in self.candidate_buffer.borrow().iter() {
-            let patterns_offset = header.patterns_offset as usize;
+        for &pattern_id in scratch.candidates.iter() {
             let entry_offset =
                 patterns_offset + (pattern_id as usize) * mem::size_of::<PatternEntry>();
             let entry_slice = match buffer.get(entry_offset..) {
@@ -1231,7 +1308,16 @@ impl Paraglob {
             if entry.pattern_type == 0 {
                 // Literal pattern - AC automaton already confirmed this matches!
                 // No need to read string or verify, just add to results.
-                self.result_buffer.borrow_mut().push(entry.pattern_id);
+                scratch.results.push(entry.pattern_id);
+            } else if let Some(matched) = programs.and_then(|p| p.matches(entry.pattern_id, folded))
+            {
+                // Glob pattern with a compiled program - no string read needed
+                scratch.scan.globs_checked += 1;
+                if matched {
+                    scratch.results.push(entry.pattern_id);
+                } else {
+                    scratch.scan.globs_rejected += 1;
+                }
             } else {
                 // Glob pattern - need to read pattern string and do glob matching
                 // Validate UTF-8 on every string read
@@ -1246,37 +1332,43 @@ impl Paraglob {
                     Err(_) => continue, // Skip corrupted pattern
                 };
 
-                // Ensure pattern is cached first
-                if !self.glob_cache.borrow().contains_key(&entry.pattern_id) {
-                    self.glob_cache.borrow_mut().insert(
-                        entry.pattern_id,
-                        GlobPattern::new(pattern_str, self.mode)
-                            .expect("Invalid cached glob pattern"),
-                    );
-                }
-
-                if self
-                    .glob_cache
-                    .borrow()
-                    .get(&entry.pattern_id)
-                    .unwrap()
-                    .matches(text)
-                {
-                    self.result_buffer.borrow_mut().push(entry.pattern_id);
+                scratch.scan.globs_checked += 1;
+                if Self::cached_glob_matches(
+                    &mut scratch.glob_cache,
+                    entry.pattern_id,
+                    pattern_str,
+                    self.mode,
+                    text,
+                ) {
+                    scratch.results.push(entry.pattern_id);
+                } else {
+                    scratch.scan.globs_rejected += 1;
                 }
             }
         }
 
-        self.result_buffer.borrow_mut().sort_unstable();
-        self.result_buffer.borrow_mut().dedup();
-        // Return slice (zero allocation!)
-        // SAFETY: This is safe because the function signature guarantees &mut self,
-        // so no other borrows can exist during this call
-        unsafe {
-            let ptr = self.result_buffer.as_ptr();
-            let borrowed = &*ptr;
-            std::slice::from_raw_parts(borrowed.as_ptr(), borrowed.len())
+        if let Some(start) = verify_start {
+            scratch.scan.verify = start.elapsed();
         }
+
+        scratch.results.sort_unstable();
+        scratch.results.dedup();
+    }
+
+    /// Match `text` against a glob, compiling and caching it on first use
+    fn cached_glob_matches(
+        cache: &mut HashMap<u32, GlobPattern>,
+        pattern_id: u32,
+        pattern_str: &str,
+        mode: GlobMatchMode,
+        text: &str,
+    ) -> bool {
+        cache
+            .entry(pattern_id)
+            .or_insert_with(|| {
+                GlobPattern::new(pattern_str, mode).expect("Invalid cached glob pattern")
+            })
+            .matches(text)
     }
 
     /// Find all matching pattern IDs and write into caller's buffer (zero-allocation variant)
@@ -1310,28 +1402,31 @@ impl Paraglob {
     /// Run AC automaton matching with position tracking (allocates normalized buffer)
     fn run_ac_matching_with_positions(
         ac_buffer: &[u8],
+        classes: Option<&[u8; 256]>,
         text: &[u8],
         mode: GlobMatchMode,
         matches: &mut Vec<(usize, u32)>,
     ) {
-        // Stack-allocated buffer for one-off calls
-        let normalized_buf = RefCell::new(Vec::new());
+        // Fresh buffer for one-off calls
+        let mut normalized_buf = Vec::new();
         Self::run_ac_matching_with_positions_with_buffer(
             ac_buffer,
+            classes,
             text,
             mode,
             matches,
-            &normalized_buf,
+            &mut normalized_buf,
         );
     }
 
     /// Run AC automaton matching with position tracking (reusable buffer)
     fn run_ac_matching_with_positions_with_buffer(
         ac_buffer: &[u8],
+        classes: Option<&[u8; 256]>,
         text: &[u8],
         mode: GlobMatchMode,
         matches: &mut Vec<(usize, u32)>,
-        normalized_text_buffer: &RefCell<Vec<u8>>,
+        normalized_text_buffer: &mut Vec<u8>,
     ) {
         use crate::offset_format::ACNodeHot;
 
@@ -1340,21 +1435,24 @@ impl Paraglob {
         }
 
         // Pre-lowercase text once for case-insensitive mode using SIMD (4-8x faster)
-        // Reuse buffer to avoid allocation
+        // Reuse buffer to avoid allocation. A byte-class map already folds case.
         let search_text = match mode {
-            GlobMatchMode::CaseInsensitive => {
-                let mut buf = normalized_text_buffer.borrow_mut();
-                crate::simd_utils::ascii_lowercase(text, &mut buf);
-                // SAFETY: We copy the data out immediately and don't hold the borrow
-                // This is safe because search_text lifetime doesn't escape this function
-                unsafe { std::slice::from_raw_parts(buf.as_ptr(), buf.len()) }
+            GlobMatchMode::CaseInsensitive if classes.is_none() => {
+                crate::simd_utils::ascii_lowercase(text, normalized_text_buffer);
+                normalized_text_buffer.as_slice()
             }
-            GlobMatchMode::CaseSensitive => text,
+            _ => text,
         };
 
         let mut current_offset = 0usize;
 
-        for (pos, &search_ch) in search_text.iter().enumerate() {
+        for (pos, &byte) in search_text.iter().enumerate() {
+            let Some(search_ch) = Self::edge_char(classes, byte) else {
+                // No literal uses this byte: every match attempt restarts
+                current_offset = 0;
+                continue;
+            };
+
             // Traverse to next state
             loop {
                 if let Some(next_offset) =
@@ -1412,9 +1510,12 @@ impl Paraglob {
     /// Writes AC literal IDs into the provided HashSet (avoids allocation)
     fn run_ac_matching_into_static(
         ac_buffer: &[u8],
+        classes: Option<&[u8; 256]>,
         text: &[u8],
         mode: GlobMatchMode,
         matches: &mut HashSet<u32>,
+        normalized_text_buf: &mut Vec<u8>,
+        states_visited: &mut u64,
     ) {
         use crate::offset_format::ACNodeHot;
 
@@ -1423,20 +1524,28 @@ impl Paraglob {
         }
 
         // Pre-lowercase text once for case-insensitive mode using SIMD (4-8x faster)
-        let mut normalized_text_buf: Vec<u8> = Vec::new();
+        // Reuse the scratch buffer to avoid allocation. A byte-class map
+        // already folds case.
         let search_text = match mode {
-            GlobMatchMode::CaseInsensitive => {
-                crate::simd_utils::ascii_lowercase(text, &mut normalized_text_buf);
+            GlobMatchMode::CaseInsensitive if classes.is_none() => {
+                crate::simd_utils::ascii_lowercase(text, normalized_text_buf);
                 normalized_text_buf.as_slice()
             }
-            GlobMatchMode::CaseSensitive => text,
+            _ => text,
         };
 
         let mut current_offset = 0usize; // Start at root node
 
-        for &search_ch in search_text.iter() {
+        for &byte in search_text.iter() {
+            let Some(search_ch) = Self::edge_char(classes, byte) else {
+                // No literal uses this byte: back to the root, no matches here
+                current_offset = 0;
+                continue;
+            };
+
             // Traverse to next state
             loop {
+                *states_visited += 1;
                 // Try to find transition
                 if let Some(next_offset) =
                     Self::find_ac_transition(ac_buffer, current_offset, search_ch)
@@ -1492,6 +1601,41 @@ impl Paraglob {
         }
     }
 
+    /// The stored byte-class map, if the file has one (v5)
+    fn byte_class_map<'a>(buffer: &'a [u8], header: &ParaglobHeader) -> Option<&'a [u8; 256]> {
+        let offset = header.byte_classes_offset as usize;
+        if offset == 0 {
+            return None;
+        }
+        buffer
+            .get(offset..offset.checked_add(256)?)?
+            .try_into()
+            .ok()
+    }
+
+    /// The compiled glob programs section, when the buffer has a valid one
+    fn glob_programs<'a>(buffer: &'a [u8], header: &ParaglobHeader) -> Option<GlobPrograms<'a>> {
+        if !header.has_glob_programs() {
+            return None;
+        }
+        let offset = header.glob_programs_offset as usize;
+        let size = header.glob_programs_size as usize;
+        GlobPrograms::new(buffer.get(offset..offset.checked_add(size)?)?)
+    }
+
+    /// The AC edge label for `byte`: its class when the automaton uses a
+    /// byte-class map, `None` for class 0 (bytes no literal uses)
+    #[inline(always)]
+    fn edge_char(classes: Option<&[u8; 256]>, byte: u8) -> Option<u8> {
+        match classes {
+            Some(map) => match map[byte as usize] {
+                0 => None,
+                class => Some(class),
+            },
+            None => Some(byte),
+        }
+    }
+
     /// Find a transition from a node for a character in AC automaton
     /// Uses state-specific encoding for optimal performance
     #[inline(always)]
@@ -1576,6 +1720,13 @@ impl Paraglob {
                     None
                 }
             }
+
+            StateKind::Dfa => {
+                // Failure links already resolved: 0 is a real transition to root
+                let target_offset_offset = node.edges_offset as usize + (ch as usize * 4);
+                let bytes = ac_buffer.get(target_offset_offset..target_offset_offset + 4)?;
+                Some(u32::from_le_bytes([bytes[0], bytes[1], bytes[2], bytes[3]]) as usize)
+            }
         }
     }
 
@@ -1639,13 +1790,10 @@ impl Paraglob {
         Ok(Self {
             buffer: BufferStorage::Owned(buffer),
             mode,
-            glob_cache: RefCell::new(HashMap::new()),
+            id: next_matcher_id(),
             ac_literal_hash,
             pattern_data_map,
-            candidate_buffer: RefCell::new(HashSet::new()),
-            ac_literal_buffer: RefCell::new(HashSet::new()),
-            result_buffer: RefCell::new(Vec::new()),
-            normalized_text_buffer: RefCell::new(Vec::new()),
+            scratch: Mutex::new(ParaglobScratch::new()),
         })
     }
 
@@ -1709,13 +1857,10 @@ impl Paraglob {
         Ok(Self {
             buffer: BufferStorage::Borrowed(slice),
             mode,
-            glob_cache: RefCell::new(HashMap::new()),
+            id: next_matcher_id(),
             ac_literal_hash,
             pattern_data_map,
-            candidate_buffer: RefCell::new(HashSet::new()),
-            ac_literal_buffer: RefCell::new(HashSet::new()),
-            result_buffer: RefCell::new(Vec::new()),
-            normalized_text_buffer: RefCell::new(Vec::new()),
+            scratch: Mutex::new(ParaglobScratch::new()),
         })
     }
 
@@ -1829,6 +1974,11 @@ impl Paraglob {
 
     /// Get pattern string by ID
     pub fn get_pattern(&self, pattern_id: u32) -> Option<String> {
+        self.pattern_str(pattern_id).map(str::to_string)
+    }
+
+    /// Borrow pattern string by ID from the matcher buffer (no allocation)
+    pub fn pattern_str(&self, pattern_id: u32) -> Option<&str> {
         let buffer = self.buffer.as_slice();
         if buffer.len() < mem::size_of::<ParaglobHeader>() {
             return None;
@@ -1847,7 +1997,6 @@ impl Paraglob {
         let entry = *entry_ref;
 
         unsafe { read_cstring(buffer, entry.pattern_string_offset as usize).ok() }
-            .map(|s| s.to_string())
     }
 
     /// Get database statistics
@@ -1955,6 +2104,22 @@ mod tests {
         assert!(matches.is_empty());
     }
 
+    #[test]
+    fn test_scratch_moves_between_matchers() {
+        let mut scratch = ParaglobScratch::new();
+        let first =
+            Paraglob::build_from_patterns(&["*.txt"], GlobMatchMode::CaseSensitive).unwrap();
+        assert_eq!(first.find_all_with("a.txt", &mut scratch), &[0]);
+
+        // Freeing the first matcher may hand its allocation to the next one;
+        // the scratch must still notice the change of matcher
+        drop(first);
+        let second =
+            Paraglob::build_from_patterns(&["*.log"], GlobMatchMode::CaseSensitive).unwrap();
+        assert!(second.find_all_with("a.txt", &mut scratch).is_empty());
+        assert_eq!(second.find_all_with("a.log", &mut scratch), &[0]);
+    }
+
     #[test]
     fn test_serialization_roundtrip() {
         let patterns = vec!["hello", "*.txt", "test_*"];
@@ -1970,4 +2135,144 @@ mod tests {
         let text = "hello test_file.txt";
         assert_eq!(pg.find_all(text), pg2.find_all(text));
     }
+
+    #[test]
+    fn test_dfa_depth_roundtrip() {
+        let patterns = [
+            "*.evil.com",
+            "malware*",
+            "*phish*login*",
+            "exact.example.org",
+        ];
+        let texts = [
+            "www.evil.com",
+            "malware.exe",
+            "phish-me/login",
+            "exact.example.org",
+            "benign",
+        ];
+
+        let mut plain = ParaglobBuilder::new(GlobMatchMode::CaseInsensitive);
+        let mut dfa = ParaglobBuilder::new(GlobMatchMode::CaseInsensitive).with_dfa_depth(2);
+        for pattern in patterns {
+            plain.add_pattern(pattern).unwrap();
+            dfa.add_pattern(pattern).unwrap();
+        }
+        let plain = plain.build().unwrap();
+        let dfa = dfa.build().unwrap();
+        assert_eq!(plain.version(), crate::offset_format::VERSION);
+        assert_eq!(dfa.version(), VERSION_V5);
+
+        let reloaded =
+            Paraglob::from_buffer(dfa.buffer().to_vec(), GlobMatchMode::CaseInsensitive).unwrap();
+        for text in texts {
+            let upper = text.to_uppercase();
+            assert_eq!(dfa.find_all(text), plain.find_all(text), "{}", text);
+            assert_eq!(
+                reloaded.find_all(&upper),
+                plain.find_all(&upper),
+                "{}",
+                upper
+            );
+            assert_eq!(
+                dfa.find_matches_with_positions(text),
+                plain.find_matches_with_positions(text)
+            );
+        }
+    }
+
+    #[test]
+    fn test_byte_classes_roundtrip() {
+        let patterns = [
+            "*.evil.com",
+            "malware*",
+            "*phish*login*",
+            "Exact.Example.org",
+        ];
+        let texts = [
+            "www.evil.com",
+            "WWW.EVIL.COM",
+            "malware.exe",
+            "phish-me/login",
+            "exact.example.org",
+            "benign \u{e9}vil.com",
+            "\u{0}\u{ff}",
+        ];
+
+        for mode in [GlobMatchMode::CaseSensitive, GlobMatchMode::CaseInsensitive] {
+            let mut plain = ParaglobBuilder::new(mode);
+            let mut classes = ParaglobBuilder::new(mode)
+                .with_byte_classes(true)
+                .with_dfa_depth(1);
+            for pattern in patterns {
+                plain.add_pattern(pattern).unwrap();
+                classes.add_pattern(pattern).unwrap();
+            }
+            let plain = plain.build().unwrap();
+            let classes = classes.build().unwrap();
+            assert_eq!(classes.version(), VERSION_V5);
+
+            let reloaded = Paraglob::from_buffer(classes.buffer().to_vec(), mode).unwrap();
+            for text in texts {
+                assert_eq!(reloaded.find_all(text), plain.find_all(text), "{}", text);
+                assert_eq!(
+                    reloaded.find_matches_with_positions(text),
+                    plain.find_matches_with_positions(text),
+                    "{}",
+                    text
+                );
+                let mut positions = Vec::new();
+                reloaded.find_matches_with_positions_bytes_into(text.as_bytes(), &mut positions);
+                assert_eq!(positions, plain.find_matches_with_positions(text));
+            }
+        }
+    }
+
+    #[test]
+    fn test_glob_programs_match_interpreter() {
+        use zerocopy::IntoBytes;
+
+        let patterns = [
+            "*.*.cdn-*.example.*",
+            "*a*b*c*d",
+            "[a-c]?-*.LOG",
+            "[!0-9]*",
+            "prefix_*",
+            "exact",
+        ];
+        let texts = [
+            "static.assets.cdn-eu-west-1.example.net",
+            "STATIC.ASSETS.CDN-EU.EXAMPLE.NET",
+            "static.cdn-eu.example",
+            "aaaaaaaaaaaaaaaaaaaaabbbbbbbbbbbbbbbbbbbbbcccccccccccccccccccd",
+            "b1-ERRORS.log",
+            "prefix_exact",
+            "9lives",
+            "",
+        ];
+
+        for mode in [GlobMatchMode::CaseSensitive, GlobMatchMode::CaseInsensitive] {
+            let compiled = Paraglob::build_from_patterns(&patterns, mode).unwrap();
+            let mut buffer = compiled.buffer().to_vec();
+            let (header_ref, _) = Ref::<_, ParaglobHeader>::from_prefix(&buffer[..]).unwrap();
+            let mut header = *header_ref;
+            assert!(header.has_glob_programs());
+
+            // Dropping the section from the header forces the interpreter
+            header.glob_programs_offset = 0;
+            header.glob_programs_size = 0;
+            buffer[..mem::size_of::<ParaglobHeader>()].copy_from_slice(header.as_bytes());
+            let interpreted = Paraglob::from_buffer(buffer, mode).unwrap();
+
+            let reloaded = Paraglob::from_buffer(compiled.buffer().to_vec(), mode).unwrap();
+            for text in texts {
+                assert_eq!(
+                    reloaded.find_all(text),
+                    interpreted.find_all(text),
+                    "{}",
+                    text
+                );
+            }
+        }
+    }
 }
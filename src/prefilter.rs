@@ -0,0 +1,433 @@
+//! Bloom Prefilter for String Lookups
+//!
+//! Most string queries against a threat feed miss, and a miss still pays for
+//! a literal hash probe and a pass of the glob automaton. The prefilter is
+//! an optional split-block Bloom filter, written by
+//! `MmdbBuilder::with_prefilter`, that rules out most misses first:
+//!
+//! - every literal key is inserted, normalized the way the literal table
+//!   stores it
+//! - every glob contributes its first or last [`GRAM_LEN`] literal bytes
+//!   (a glob must match the whole query, so the query has to start or end
+//!   with them)
+//!
+//! A query is only looked up in the literal table if it may be a literal,
+//! and only run through the automaton if its own first or last bytes may be
+//! a glob's. Globs such as `*evil*` have no literal prefix or suffix; if the
+//! database holds any, the glob side of the filter is disabled and every
+//! query is matched against the automaton as before.
+//!
+//! Each key sets eight bits in one 32-byte block, so a probe reads a single
+//! cache line. At [`BITS_PER_KEY`] bits per key about 1-2% of misses get
+//! through.
+//!
+//! ## Layout
+//!
+//! ```text
+//! [magic "MXPF"][version u32][flags u32][block_count u32][gram_len u32][reserved 12 bytes]
+//! [block 0: 8 x u32][block 1: 8 x u32]...
+//! ```
+//!
+//! All integers are little-endian. The section follows a `MMDB_PREFILTER`
+//! separator and is found through the `prefilter_section_offset` metadata
+//! key; readers that don't know it ignore the section.
+
+use crate::error::ParaglobError;
+use crate::glob::{GlobPattern, GlobSegment, MatchMode};
+use std::borrow::Cow;
+use xxhash_rust::xxh64::xxh64;
+
+/// Magic bytes at the start of the prefilter section
+pub const PREFILTER_MAGIC: &[u8; 4] = b"MXPF";
+
+/// Current prefilter section format version
+pub const PREFILTER_VERSION: u32 = 1;
+
+/// Separator written before the section (same convention as `MMDB_LITERAL`)
+pub const PREFILTER_SEPARATOR: &[u8; 16] = b"MMDB_PREFILTER\x00\x00";
+
+/// Size of the section header
+pub const PREFILTER_HEADER_BYTES: usize = 32;
+
+/// Bytes taken from the start or end of a glob
+pub const GRAM_LEN: usize = 4;
+
+/// Filter bits per inserted key
+pub const BITS_PER_KEY: usize = 10;
+
+/// Flag: every glob contributed a gram, so glob queries can be rejected
+pub const FLAG_GLOBS_FILTERED: u32 = 1;
+
+/// 32-bit words per block (one bit is set in each)
+const BLOCK_WORDS: usize = 8;
+
+/// Size of one block
+const BLOCK_BYTES: usize = BLOCK_WORDS * 4;
+
+/// Odd multipliers picking each word's bit (from Parquet's split-block filter)
+const SALT: [u32; BLOCK_WORDS] = [
+    0x47b6_137b,
+    0x4497_4d91,
+    0x8824_ad5b,
+    0xa2b7_289d,
+    0x7054_95c7,
+    0x2df1_424b,
+    0x9efc_4947,
+    0x5c6b_fb31,
+];
+
+/// Hash seeds keeping the three kinds of key apart
+const LITERAL_SEED: u64 = 0;
+const PREFIX_SEED: u64 = 1;
+const SUFFIX_SEED: u64 = 2;
+
+/// Block index and bit masks for a key hash
+#[inline]
+fn probe(hash: u64, block_count: u32) -> (usize, [u32; BLOCK_WORDS]) {
+    let block = (((hash >> 32) * block_count as u64) >> 32) as usize;
+    let key = hash as u32;
+    let mut masks = [0u32; BLOCK_WORDS];
+    for (mask, salt) in masks.iter_mut().zip(SALT) {
+        *mask = 1 << (key.wrapping_mul(salt) >> 27);
+    }
+    (block, masks)
+}
+
+/// A literal key as the literal table stores it (lowercased when
+/// case-insensitive, borrowing when that changes nothing)
+#[inline]
+fn normalize_literal(query: &str, mode: MatchMode) -> Cow<'_, str> {
+    match mode {
+        MatchMode::CaseInsensitive
+            if !query.is_ascii() || query.bytes().any(|b| b.is_ascii_uppercase()) =>
+        {
+            Cow::Owned(query.to_lowercase())
+        }
+        _ => Cow::Borrowed(query),
+    }
+}
+
+/// `bytes` as the glob matcher compares them (ASCII case folded when
+/// case-insensitive)
+#[inline]
+fn normalize_gram(bytes: &[u8], mode: MatchMode) -> [u8; GRAM_LEN] {
+    let mut gram = [0u8; GRAM_LEN];
+    gram.copy_from_slice(bytes);
+    if mode == MatchMode::CaseInsensitive {
+        gram.make_ascii_lowercase();
+    }
+    gram
+}
+
+/// Collects keys and writes a prefilter section
+pub struct PrefilterBuilder {
+    mode: MatchMode,
+    hashes: Vec<u64>,
+    globs_filtered: bool,
+}
+
+impl PrefilterBuilder {
+    /// Create a builder for a database with the given match mode
+    pub fn new(mode: MatchMode) -> Self {
+        Self {
+            mode,
+            hashes: Vec::new(),
+            globs_filtered: true,
+        }
+    }
+
+    /// Insert a literal key
+    pub fn add_literal(&mut self, literal: &str) {
+        let key = normalize_literal(literal, self.mode);
+        self.hashes.push(xxh64(key.as_bytes(), LITERAL_SEED));
+    }
+
+    /// Insert a glob's literal prefix, or failing that its literal suffix
+    ///
+    /// Returns false if the glob has neither (or doesn't parse), which turns
+    /// the glob side of the filter off.
+    pub fn add_glob(&mut self, glob: &str) -> bool {
+        let gram = GlobPattern::new(glob, self.mode).ok().and_then(|pattern| {
+            let literal = |segment: Option<&GlobSegment>| match segment {
+                Some(GlobSegment::Literal(text)) if text.len() >= GRAM_LEN => {
+                    Some(text.as_bytes().to_vec())
+                }
+                _ => None,
+            };
+            let segments = pattern.segments();
+            if let Some(text) = literal(segments.first()) {
+                Some((PREFIX_SEED, normalize_gram(&text[..GRAM_LEN], self.mode)))
+            } else {
+                literal(segments.last()).map(|text| {
+                    let tail = &text[text.len() - GRAM_LEN..];
+                    (SUFFIX_SEED, normalize_gram(tail, self.mode))
+                })
+            }
+        });
+
+        match gram {
+            Some((seed, gram)) => {
+                self.hashes.push(xxh64(&gram, seed));
+                true
+            }
+            None => {
+                self.globs_filtered = false;
+                false
+            }
+        }
+    }
+
+    /// Whether every glob added so far contributed a gram
+    pub fn globs_filtered(&self) -> bool {
+        self.globs_filtered
+    }
+
+    /// Serialize the filter into a complete section (header + blocks)
+    pub fn build(&self) -> Vec<u8> {
+        let bits = (self.hashes.len() * BITS_PER_KEY).max(1);
+        let block_count = bits.div_ceil(BLOCK_BYTES * 8) as u32;
+
+        let mut blocks = vec![[0u32; BLOCK_WORDS]; block_count as usize];
+        for &hash in &self.hashes {
+            let (block, masks) = probe(hash, block_count);
+            for (word, mask) in blocks[block].iter_mut().zip(masks) {
+                *word |= mask;
+            }
+        }
+
+        let flags = if self.globs_filtered {
+            FLAG_GLOBS_FILTERED
+        } else {
+            0
+        };
+        let mut section =
+            Vec::with_capacity(PREFILTER_HEADER_BYTES + block_count as usize * BLOCK_BYTES);
+        section.extend_from_slice(PREFILTER_MAGIC);
+        section.extend_from_slice(&PREFILTER_VERSION.to_le_bytes());
+        section.extend_from_slice(&flags.to_le_bytes());
+        section.extend_from_slice(&block_count.to_le_bytes());
+        section.extend_from_slice(&(GRAM_LEN as u32).to_le_bytes());
+        section.resize(PREFILTER_HEADER_BYTES, 0);
+        for block in &blocks {
+            for word in block {
+                section.extend_from_slice(&word.to_le_bytes());
+            }
+        }
+        section
+    }
+}
+
+/// Parsed prefilter section header
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct PrefilterHeader {
+    /// File offset of the first block
+    pub blocks_offset: usize,
+    /// Number of 32-byte blocks
+    pub block_count: u32,
+    /// `FLAG_*` bits
+    pub flags: u32,
+}
+
+impl PrefilterHeader {
+    /// Parse the prefilter section starting at `offset` in the file
+    ///
+    /// Checks that every block lies inside `data`.
+    pub fn from_section(data: &[u8], offset: usize) -> Result<Self, ParaglobError> {
+        let header = data
+            .get(offset..offset + PREFILTER_HEADER_BYTES)
+            .ok_or_else(|| {
+                ParaglobError::Format(format!(
+                    "Prefilter section offset {} exceeds file size {}",
+                    offset,
+                    data.len()
+                ))
+            })?;
+
+        if &header[0..4] != PREFILTER_MAGIC {
+            return Err(ParaglobError::Format(
+                "Prefilter section has invalid magic".to_string(),
+            ));
+        }
+
+        let read_u32 = |at: usize| u32::from_le_bytes(header[at..at + 4].try_into().unwrap());
+        let version = read_u32(4);
+        if version != PREFILTER_VERSION {
+            return Err(ParaglobError::Format(format!(
+                "Unsupported prefilter version {}",
+                version
+            )));
+        }
+        let flags = read_u32(8);
+        let block_count = read_u32(12);
+        let gram_len = read_u32(16);
+        if block_count == 0 || gram_len as usize != GRAM_LEN {
+            return Err(ParaglobError::Format(format!(
+                "Invalid prefilter shape: {} blocks, {}-byte grams",
+                block_count, gram_len
+            )));
+        }
+
+        let blocks_offset = offset + PREFILTER_HEADER_BYTES;
+        let end = (block_count as usize)
+            .checked_mul(BLOCK_BYTES)
+            .and_then(|size| blocks_offset.checked_add(size));
+        if end.is_none_or(|end| end > data.len()) {
+            return Err(ParaglobError::Format(format!(
+                "Prefilter blocks ({} x {} bytes) exceed file size {}",
+                block_count,
+                BLOCK_BYTES,
+                data.len()
+            )));
+        }
+
+        Ok(Self {
+            blocks_offset,
+            block_count,
+            flags,
+        })
+    }
+}
+
+/// Read-only view of a prefilter inside the file
+#[derive(Clone, Copy)]
+pub struct Prefilter<'a> {
+    blocks: &'a [u8],
+    block_count: u32,
+    flags: u32,
+    mode: MatchMode,
+}
+
+impl<'a> Prefilter<'a> {
+    /// View the filter described by `header` (from [`PrefilterHeader::from_section`])
+    pub fn new(data: &'a [u8], header: &PrefilterHeader, mode: MatchMode) -> Self {
+        let size = header.block_count as usize * BLOCK_BYTES;
+        Self {
+            blocks: &data[header.blocks_offset..header.blocks_offset + size],
+            block_count: header.block_count,
+            flags: header.flags,
+            mode,
+        }
+    }
+
+    /// Whether the filter may hold `hash` (false means it certainly doesn't)
+    #[inline]
+    fn contains(&self, hash: u64) -> bool {
+        let (block, masks) = probe(hash, self.block_count);
+        let words = &self.blocks[block * BLOCK_BYTES..(block + 1) * BLOCK_BYTES];
+        masks.iter().enumerate().all(|(i, &mask)| {
+            let word = u32::from_le_bytes(words[i * 4..i * 4 + 4].try_into().unwrap());
+            word & mask != 0
+        })
+    }
+
+    /// Whether `query` may be a literal key
+    #[inline]
+    pub fn may_be_literal(&self, query: &str) -> bool {
+        let key = normalize_literal(query, self.mode);
+        self.contains(xxh64(key.as_bytes(), LITERAL_SEED))
+    }
+
+    /// Whether `query` may match a glob
+    ///
+    /// Always true when the database has globs without a literal prefix or
+    /// suffix.
+    #[inline]
+    pub fn may_match_glob(&self, query: &str) -> bool {
+        if self.flags & FLAG_GLOBS_FILTERED == 0 {
+            return true;
+        }
+        let bytes = query.as_bytes();
+        if bytes.len() < GRAM_LEN {
+            return false;
+        }
+        let prefix = normalize_gram(&bytes[..GRAM_LEN], self.mode);
+        let suffix = normalize_gram(&bytes[bytes.len() - GRAM_LEN..], self.mode);
+        self.contains(xxh64(&prefix, PREFIX_SEED)) || self.contains(xxh64(&suffix, SUFFIX_SEED))
+    }
+
+    /// The filter's blocks, as mapped from the file
+    pub(crate) fn blocks(&self) -> &'a [u8] {
+        self.blocks
+    }
+
+    /// Whether the glob side of the filter is in use
+    pub fn globs_filtered(&self) -> bool {
+        self.flags & FLAG_GLOBS_FILTERED != 0
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn filter_for(
+        mode: MatchMode,
+        literals: &[&str],
+        globs: &[&str],
+    ) -> (Vec<u8>, PrefilterHeader) {
+        let mut builder = PrefilterBuilder::new(mode);
+        for literal in literals {
+            builder.add_literal(literal);
+        }
+        for glob in globs {
+            builder.add_glob(glob);
+        }
+        let section = builder.build();
+        let header = PrefilterHeader::from_section(&section, 0).unwrap();
+        (section, header)
+    }
+
+    #[test]
+    fn test_no_false_negatives() {
+        let literals: Vec<String> = (0..1000).map(|i| format!("host{}.example", i)).collect();
+        let literal_refs: Vec<&str> = literals.iter().map(|s| s.as_str()).collect();
+        let (section, header) = filter_for(
+            MatchMode::CaseSensitive,
+            &literal_refs,
+            &["*.evil.com", "http://bad/*", "x?z*.tail"],
+        );
+        let filter = Prefilter::new(&section, &header, MatchMode::CaseSensitive);
+        assert!(filter.globs_filtered());
+
+        for literal in &literals {
+            assert!(filter.may_be_literal(literal));
+        }
+        assert!(filter.may_match_glob("www.evil.com"));
+        assert!(filter.may_match_glob("http://bad/path"));
+        assert!(filter.may_match_glob("xyz123.tail"));
+        assert!(!filter.may_match_glob("abc"));
+
+        // Roughly BITS_PER_KEY worth of false positives, far from all
+        let passed = (0..10_000)
+            .filter(|i| filter.may_be_literal(&format!("miss{}.example", i)))
+            .count();
+        assert!(passed < 500, "{} false positives", passed);
+    }
+
+    #[test]
+    fn test_case_insensitive() {
+        let (section, header) =
+            filter_for(MatchMode::CaseInsensitive, &["Evil.COM"], &["*.Bad.Org"]);
+        let filter = Prefilter::new(&section, &header, MatchMode::CaseInsensitive);
+        assert!(filter.may_be_literal("evil.com"));
+        assert!(filter.may_be_literal("EVIL.com"));
+        assert!(filter.may_match_glob("WWW.BAD.ORG"));
+    }
+
+    #[test]
+    fn test_unanchored_glob_disables_glob_side() {
+        let (section, header) = filter_for(MatchMode::CaseSensitive, &[], &["*evil*"]);
+        let filter = Prefilter::new(&section, &header, MatchMode::CaseSensitive);
+        assert!(!filter.globs_filtered());
+        assert!(filter.may_match_glob("anything"));
+        assert!(!filter.may_be_literal("anything"));
+    }
+
+    #[test]
+    fn test_rejects_bad_sections() {
+        let (mut section, _) = filter_for(MatchMode::CaseSensitive, &["a"], &[]);
+        assert!(PrefilterHeader::from_section(&section[..40], 0).is_err());
+        section[0] = b'X';
+        assert!(PrefilterHeader::from_section(&section, 0).is_err());
+    }
+}
@@ -39,16 +39,21 @@
 //! Reader Thread → [LineBatch queue] → Worker Pool → [Result queue] → Output Thread
 //! ```
 //!
-//! Build your own parallel pipeline using channels and thread pools with these primitives.
+//! Build your own parallel pipeline using channels and thread pools with these primitives,
+//! or use [`process_files_parallel_with`], which splits large files into newline-aligned
+//! ranges ([`split_file`]) and spreads them over a work-stealing worker pool.
 
+use crate::database_set::{DatabaseSet, DatabaseSetScratch};
 use crate::extractor::{ExtractedItem, Extractor, HashType};
 use crate::{Database, QueryResult};
+use crossbeam_deque::{Injector, Stealer, Worker as LocalQueue};
 use std::fs;
-use std::io::{self, BufRead, Read};
+use std::io::{self, BufRead, Read, Seek, SeekFrom};
 use std::path::{Path, PathBuf};
-use std::sync::mpsc::{channel, Sender};
-use std::sync::{Arc, Mutex};
+use std::sync::atomic::{self, AtomicUsize, Ordering};
+use std::sync::{Arc, Condvar, Mutex, PoisonError};
 use std::thread;
+use std::time::Duration;
 
 // File size thresholds for chunking decisions
 const SMALL_FILE: u64 = 100 * 1024 * 1024; // 100MB
@@ -72,6 +77,16 @@ pub enum WorkUnit {
         /// Pre-chunked batch ready for processing
         batch: LineBatch,
     },
+
+    /// Newline-aligned part of an uncompressed file - worker reads it on its own handle
+    Range {
+        /// Path to the file
+        path: PathBuf,
+        /// Offset of the first byte (the start of a line)
+        start: u64,
+        /// Offset just past the last byte (after a newline, or the end of the file)
+        end: u64,
+    },
 }
 
 /// Pre-chunked batch of line-oriented data ready for parallel processing
@@ -142,6 +157,33 @@ pub struct WorkerStats {
     pub monero_count: usize,
 }
 
+impl WorkerStats {
+    /// Add another worker's counts and timings to these
+    pub fn merge(&mut self, other: &WorkerStats) {
+        self.lines_processed += other.lines_processed;
+        self.candidates_tested += other.candidates_tested;
+        self.matches_found += other.matches_found;
+        self.lines_with_matches += other.lines_with_matches;
+        self.total_bytes += other.total_bytes;
+        self.extraction_time += other.extraction_time;
+        self.extraction_samples += other.extraction_samples;
+        self.lookup_time += other.lookup_time;
+        self.lookup_samples += other.lookup_samples;
+        self.ipv4_count += other.ipv4_count;
+        self.ipv6_count += other.ipv6_count;
+        self.domain_count += other.domain_count;
+        self.email_count += other.email_count;
+        self.md5_count += other.md5_count;
+        self.sha1_count += other.sha1_count;
+        self.sha256_count += other.sha256_count;
+        self.sha384_count += other.sha384_count;
+        self.sha512_count += other.sha512_count;
+        self.bitcoin_count += other.bitcoin_count;
+        self.ethereum_count += other.ethereum_count;
+        self.monero_count += other.monero_count;
+    }
+}
+
 /// Core match result without file/line context
 ///
 /// General-purpose match result suitable for any processing context.
@@ -222,6 +264,39 @@ impl LineFileReader {
         })
     }
 
+    /// Create a reader over the bytes `start..end` of an uncompressed file
+    ///
+    /// The range should start at the beginning of a line and end after a
+    /// newline or at the end of the file, as the ranges from [`split_file`]
+    /// do. Line numbers restart at 1.
+    ///
+    /// # Example
+    ///
+    /// ```rust,no_run
+    /// use matchy::processing::LineFileReader;
+    ///
+    /// let reader = LineFileReader::for_range("huge.log", 0, 64 * 1024 * 1024, 1 << 20)?;
+    /// # Ok::<(), std::io::Error>(())
+    /// ```
+    pub fn for_range<P: AsRef<Path>>(
+        path: P,
+        start: u64,
+        end: u64,
+        chunk_size: usize,
+    ) -> io::Result<Self> {
+        let path = path.as_ref();
+        let reader = crate::file_reader::open_range(path, start, end)?;
+
+        Ok(Self {
+            source_path: path.to_path_buf(),
+            reader,
+            read_buffer: vec![0u8; chunk_size],
+            current_line_number: 1,
+            eof: false,
+            leftover: Vec::new(),
+        })
+    }
+
     /// Read next batch of lines
     ///
     /// Returns `None` when EOF is reached.
@@ -368,10 +443,77 @@ impl Iterator for LineBatchIter {
 /// ```
 pub struct Worker {
     extractor: Extractor,
-    databases: Vec<(String, Database)>, // (database_id, database)
+    databases: WorkerDatabases,
+    /// Reused by every lookup (scratch only by fused ones)
+    set_scratch: DatabaseSetScratch,
+    set_results: Vec<(usize, QueryResult)>,
     stats: WorkerStats,
 }
 
+/// How a worker holds its databases
+enum WorkerDatabases {
+    /// Each database looked up on its own, through its cache
+    Separate(Vec<(String, Database)>), // (database_id, database)
+    /// All databases answered by one fused lookup
+    Fused(DatabaseSet),
+}
+
+impl WorkerDatabases {
+    /// Look one extracted item up in every database
+    ///
+    /// Replaces `out` with `(database index, result)` for each database
+    /// that matched, in the order they were added.
+    fn lookup_item(
+        &self,
+        item: &ExtractedItem,
+        scratch: &mut DatabaseSetScratch,
+        out: &mut Vec<(usize, QueryResult)>,
+    ) -> Result<(), crate::DatabaseError> {
+        // Addresses are looked up in binary form, everything else as text
+        let (addr, text) = match *item {
+            ExtractedItem::Ipv4(ip) => (Some(std::net::IpAddr::V4(ip)), ""),
+            ExtractedItem::Ipv6(ip) => (Some(std::net::IpAddr::V6(ip)), ""),
+            ExtractedItem::Domain(s)
+            | ExtractedItem::Email(s)
+            | ExtractedItem::Hash(_, s)
+            | ExtractedItem::Bitcoin(s)
+            | ExtractedItem::Ethereum(s)
+            | ExtractedItem::Monero(s) => (None, s),
+        };
+
+        match self {
+            // One lookup answers every database
+            WorkerDatabases::Fused(set) => match addr {
+                Some(addr) => set.lookup_ip(addr, out),
+                None => set.lookup_with(text, scratch, out),
+            },
+            WorkerDatabases::Separate(databases) => {
+                out.clear();
+                for (index, (_, database)) in databases.iter().enumerate() {
+                    let result = match addr {
+                        Some(addr) => database.lookup_ip(addr)?,
+                        None => database.lookup(text)?,
+                    };
+                    // Skip QueryResult::NotFound - not a real match
+                    match result {
+                        Some(QueryResult::NotFound) | None => {}
+                        Some(result) => out.push((index, result)),
+                    }
+                }
+                Ok(())
+            }
+        }
+    }
+
+    /// ID of the database at `index`
+    fn id(&self, index: usize) -> &str {
+        match self {
+            WorkerDatabases::Separate(databases) => &databases[index].0,
+            WorkerDatabases::Fused(set) => set.id(index),
+        }
+    }
+}
+
 impl Worker {
     /// Create a worker builder
     pub fn builder() -> WorkerBuilder {
@@ -448,60 +590,43 @@ impl Worker {
             // Sample lookup timing every 100 lookups
             let should_sample_lookup = self.stats.lookup_samples < 100_000
                 && self.stats.candidates_tested.is_multiple_of(100);
+            let lookup_start = if should_sample_lookup {
+                Some(std::time::Instant::now())
+            } else {
+                None
+            };
 
-            // Lookup in all databases
-            for (database_id, database) in &self.databases {
-                let lookup_start = if should_sample_lookup {
-                    Some(std::time::Instant::now())
-                } else {
-                    None
-                };
-
-                let (result_opt, matched_text) = match &item.item {
-                    ExtractedItem::Ipv4(ip) => {
-                        let result = database
-                            .lookup_ip(std::net::IpAddr::V4(*ip))
-                            .map_err(|e| e.to_string())?;
-                        (result, ip.to_string())
-                    }
-                    ExtractedItem::Ipv6(ip) => {
-                        let result = database
-                            .lookup_ip(std::net::IpAddr::V6(*ip))
-                            .map_err(|e| e.to_string())?;
-                        (result, ip.to_string())
-                    }
-                    ExtractedItem::Domain(s)
-                    | ExtractedItem::Email(s)
-                    | ExtractedItem::Hash(_, s)
-                    | ExtractedItem::Bitcoin(s)
-                    | ExtractedItem::Ethereum(s)
-                    | ExtractedItem::Monero(s) => {
-                        let result = database.lookup(s).map_err(|e| e.to_string())?;
-                        (result, s.to_string())
-                    }
-                };
-
-                if let Some(start) = lookup_start {
-                    self.stats.lookup_time += start.elapsed();
-                    self.stats.lookup_samples += 1;
-                }
-
-                if let Some(query_result) = result_opt {
-                    // Skip QueryResult::NotFound - not a real match
-                    if matches!(query_result, crate::QueryResult::NotFound) {
-                        continue;
-                    }
+            self.databases
+                .lookup_item(&item.item, &mut self.set_scratch, &mut self.set_results)
+                .map_err(|e| e.to_string())?;
 
-                    self.stats.matches_found += 1;
+            if let Some(start) = lookup_start {
+                self.stats.lookup_time += start.elapsed();
+                self.stats.lookup_samples += 1;
+            }
 
-                    results.push(MatchResult {
-                        matched_text: matched_text.clone(),
-                        match_type: item.item.type_name().to_string(),
-                        result: query_result,
-                        database_id: database_id.clone(),
-                        byte_offset: item.span.0,
-                    });
-                }
+            if self.set_results.is_empty() {
+                continue;
+            }
+            let matched_text = match &item.item {
+                ExtractedItem::Ipv4(ip) => ip.to_string(),
+                ExtractedItem::Ipv6(ip) => ip.to_string(),
+                ExtractedItem::Domain(s)
+                | ExtractedItem::Email(s)
+                | ExtractedItem::Hash(_, s)
+                | ExtractedItem::Bitcoin(s)
+                | ExtractedItem::Ethereum(s)
+                | ExtractedItem::Monero(s) => s.to_string(),
+            };
+            for (index, query_result) in self.set_results.drain(..) {
+                self.stats.matches_found += 1;
+                results.push(MatchResult {
+                    matched_text: matched_text.clone(),
+                    match_type: item.item.type_name().to_string(),
+                    result: query_result,
+                    database_id: self.databases.id(index).to_string(),
+                    byte_offset: item.span.0,
+                });
             }
         }
 
@@ -584,6 +709,36 @@ impl Worker {
     pub fn reset_stats(&mut self) {
         self.stats = WorkerStats::default();
     }
+
+    /// Database added under `id`, if any
+    pub fn database(&self, id: &str) -> Option<&Database> {
+        match &self.databases {
+            WorkerDatabases::Separate(databases) => databases
+                .iter()
+                .find(|(database_id, _)| database_id == id)
+                .map(|(_, database)| database),
+            WorkerDatabases::Fused(set) => set.get(id),
+        }
+    }
+
+    /// Swap in a new version of the database added under `id`
+    ///
+    /// Returns the previous database, or gives `database` back if no
+    /// database has that id. Statistics are kept. A federated worker
+    /// rebuilds its merged automaton.
+    pub fn replace_database(&mut self, id: &str, database: Database) -> Result<Database, Database> {
+        let databases = match &mut self.databases {
+            WorkerDatabases::Separate(databases) => databases,
+            WorkerDatabases::Fused(set) => return set.replace(id, database),
+        };
+        match databases
+            .iter_mut()
+            .find(|(database_id, _)| database_id == id)
+        {
+            Some((_, current)) => Ok(std::mem::replace(current, database)),
+            None => Err(database),
+        }
+    }
 }
 
 /// Builder for [`Worker`] with support for multiple databases
@@ -608,6 +763,7 @@ impl Worker {
 pub struct WorkerBuilder {
     extractor: Option<Extractor>,
     databases: Vec<(String, Database)>,
+    federated: bool,
 }
 
 impl WorkerBuilder {
@@ -616,6 +772,7 @@ impl WorkerBuilder {
         Self {
             extractor: None,
             databases: Vec::new(),
+            federated: false,
         }
     }
 
@@ -633,6 +790,18 @@ impl WorkerBuilder {
         self
     }
 
+    /// Answer all databases with one fused lookup per extracted item
+    ///
+    /// Globs of databases that share a match mode are merged into one
+    /// automaton, so each string is scanned and its literal key hashed
+    /// once rather than once per database (see [`DatabaseSet`]). Results
+    /// are the same, but lookups bypass the databases' query caches; worth
+    /// it with several string databases and a low cache hit rate.
+    pub fn federated(mut self, enabled: bool) -> Self {
+        self.federated = enabled;
+        self
+    }
+
     /// Build the worker
     ///
     /// # Panics
@@ -647,9 +816,16 @@ impl WorkerBuilder {
             "No databases added - call .add_database() at least once"
         );
 
+        let databases = if self.federated {
+            WorkerDatabases::Fused(DatabaseSet::new(self.databases))
+        } else {
+            WorkerDatabases::Separate(self.databases)
+        };
         Worker {
             extractor,
-            databases: self.databases,
+            databases,
+            set_scratch: DatabaseSetScratch::new(),
+            set_results: Vec::new(),
             stats: WorkerStats::default(),
         }
     }
@@ -711,8 +887,8 @@ fn chunk_size_for(file_size: u64) -> usize {
     }
 }
 
-/// Reader thread: chunks files and sends batches to worker queue
-fn reader_thread(file_path: PathBuf, work_sender: Sender<WorkUnit>) -> Result<(), String> {
+/// Reader thread: chunks a streamed file (stdin, gzip) and queues its batches
+fn reader_thread(file: usize, file_path: PathBuf, scheduler: &Scheduler) -> Result<(), String> {
     // Special handling for stdin (can't stat it)
     let is_stdin = file_path.to_str() == Some("-");
 
@@ -729,18 +905,75 @@ fn reader_thread(file_path: PathBuf, work_sender: Sender<WorkUnit>) -> Result<()
     let mut reader = LineFileReader::new(&file_path, chunk_size)
         .map_err(|e| format!("Failed to open {}: {}", file_path.display(), e))?;
 
+    let mut part = 0;
     while let Some(batch) = reader
         .next_batch()
         .map_err(|e| format!("Read error in {}: {}", file_path.display(), e))?
     {
-        work_sender
-            .send(WorkUnit::Chunk { batch })
-            .map_err(|_| "Worker channel closed")?;
+        scheduler.push(Task {
+            file,
+            part,
+            unit: WorkUnit::Chunk { batch },
+        });
+        part += 1;
     }
 
     Ok(())
 }
 
+/// Split an uncompressed file into newline-aligned byte ranges
+///
+/// Ranges are about `target` bytes long. Every range but the last ends just
+/// after a newline, so each can be read and processed on its own, in any
+/// order, with [`LineFileReader::for_range`].
+///
+/// # Example
+///
+/// ```rust,no_run
+/// use matchy::processing;
+///
+/// for (start, end) in processing::split_file("huge.log", 64 * 1024 * 1024)? {
+///     let reader = processing::LineFileReader::for_range("huge.log", start, end, 1 << 20)?;
+///     // ... hand the reader to a worker thread
+/// }
+/// # Ok::<(), std::io::Error>(())
+/// ```
+pub fn split_file<P: AsRef<Path>>(path: P, target: u64) -> io::Result<Vec<(u64, u64)>> {
+    let mut file = fs::File::open(path)?;
+    let size = file.metadata()?.len();
+    let target = target.max(1);
+
+    let mut ranges = Vec::new();
+    let mut start = 0u64;
+    let mut window = vec![0u8; 64 * 1024];
+    while size - start > target {
+        // First newline at or after the tentative split point
+        let mut probe = start + target - 1;
+        let mut boundary = None;
+        while boundary.is_none() && probe < size {
+            file.seek(SeekFrom::Start(probe))?;
+            let n = file.read(&mut window)?;
+            if n == 0 {
+                break;
+            }
+            boundary = memchr::memchr(b'\n', &window[..n]).map(|pos| probe + pos as u64 + 1);
+            probe += n as u64;
+        }
+
+        match boundary {
+            Some(end) if end < size => {
+                ranges.push((start, end));
+                start = end;
+            }
+            // No newline before the end: the rest is one range
+            _ => break,
+        }
+    }
+    ranges.push((start, size));
+
+    Ok(ranges)
+}
+
 /// Statistics about file routing decisions made by the main thread
 #[derive(Debug, Clone, Default)]
 pub struct RoutingStats {
@@ -748,21 +981,27 @@ pub struct RoutingStats {
     pub files_to_workers: usize,
     /// Files sent to reader threads for chunking
     pub files_to_readers: usize,
+    /// Files split into byte ranges that workers read independently
+    pub files_split: usize,
+    /// Number of byte ranges the split files were cut into
+    pub ranges: usize,
     /// Total bytes in files sent to workers
     pub bytes_to_workers: u64,
     /// Total bytes in files sent to readers
     pub bytes_to_readers: u64,
+    /// Total bytes in split files
+    pub bytes_split: u64,
 }
 
 impl RoutingStats {
     /// Total number of files processed
     pub fn total_files(&self) -> usize {
-        self.files_to_workers + self.files_to_readers
+        self.files_to_workers + self.files_to_readers + self.files_split
     }
 
     /// Total bytes across all files
     pub fn total_bytes(&self) -> u64 {
-        self.bytes_to_workers + self.bytes_to_readers
+        self.bytes_to_workers + self.bytes_to_readers + self.bytes_split
     }
 }
 
@@ -776,17 +1015,153 @@ pub struct ParallelProcessingResult {
     pub worker_stats: WorkerStats,
 }
 
+/// Options for [`process_files_parallel_with`]
+#[derive(Debug, Clone, Default)]
+pub struct ParallelOptions {
+    /// Maximum number of reader threads for streamed (stdin, gzip) files
+    /// (default: num_cpus / 2)
+    pub num_readers: Option<usize>,
+    /// Number of worker threads (default: num_cpus)
+    pub num_workers: Option<usize>,
+    /// Return matches in input order (file by file, line by line)
+    ///
+    /// Off by default: matches then come in completion order, which skips
+    /// a sort when the caller only counts or aggregates them.
+    pub ordered: bool,
+    /// Target size of the byte ranges large uncompressed files are split
+    /// into (default: enough for about four ranges per worker, 8MB-256MB)
+    pub range_bytes: Option<u64>,
+}
+
+// Split files into at least this many bytes per range, and at most this many
+const MIN_RANGE_BYTES: u64 = 8 * 1024 * 1024; // 8MB
+const MAX_RANGE_BYTES: u64 = 256 * 1024 * 1024; // 256MB
+
+// Ranges queued per worker when picking the default range size
+const RANGES_PER_WORKER: u64 = 4;
+
+// Longest an idle worker parks before looking again; pushes wake it sooner,
+// this only bounds how long work left in another worker's deque waits
+const IDLE_PARK: Duration = Duration::from_millis(1);
+
+/// A work unit with its position in the input: file index, then part within the file
+struct Task {
+    file: usize,
+    part: usize,
+    unit: WorkUnit,
+}
+
+/// Matches from one task
+struct PartResult {
+    file: usize,
+    part: usize,
+    /// Lines in the part, for numbering the ranges after it
+    range_lines: Option<usize>,
+    matches: Vec<LineMatch>,
+}
+
+/// Work-stealing task queues shared by the producers and workers
+///
+/// Producers push into a global injector. Each worker pops from its own
+/// deque, refills it from the injector in batches, and when both are empty
+/// steals from the other workers' deques, so a worker that drew a few small
+/// files keeps busy on the ranges of a large one. A worker that finds
+/// nothing parks on a condvar until a push (or the end of input) wakes it.
+struct Scheduler {
+    injector: Injector<Task>,
+    stealers: Vec<Stealer<Task>>,
+    /// Tasks pushed but not yet finished
+    pending: AtomicUsize,
+    /// Threads that may still push tasks (the main thread and readers)
+    producers: AtomicUsize,
+    /// Workers parked (or about to park) in `wait_for_work`
+    sleepers: AtomicUsize,
+    /// Guards the park/wake handshake; holds no data
+    idle: Mutex<()>,
+    wakeup: Condvar,
+}
+
+impl Scheduler {
+    fn new(stealers: Vec<Stealer<Task>>) -> Self {
+        Self {
+            injector: Injector::new(),
+            stealers,
+            pending: AtomicUsize::new(0),
+            producers: AtomicUsize::new(1), // The main thread
+            sleepers: AtomicUsize::new(0),
+            idle: Mutex::new(()),
+            wakeup: Condvar::new(),
+        }
+    }
+
+    fn push(&self, task: Task) {
+        self.pending.fetch_add(1, Ordering::SeqCst);
+        self.injector.push(task);
+        // Pairs with the fence in wait_for_work: either the sleeper sees this
+        // task before parking, or we see the sleeper and wake it
+        atomic::fence(Ordering::SeqCst);
+        if self.sleepers.load(Ordering::SeqCst) > 0 {
+            let _idle = self.idle.lock().unwrap_or_else(PoisonError::into_inner);
+            self.wakeup.notify_one();
+        }
+    }
+
+    /// Park the calling worker until a task may be available or all work is done
+    fn wait_for_work(&self) {
+        let idle = self.idle.lock().unwrap_or_else(PoisonError::into_inner);
+        self.sleepers.fetch_add(1, Ordering::SeqCst);
+        atomic::fence(Ordering::SeqCst);
+        if self.injector.is_empty() && !self.finished() {
+            let _ = self.wakeup.wait_timeout(idle, IDLE_PARK);
+        }
+        self.sleepers.fetch_sub(1, Ordering::SeqCst);
+    }
+
+    /// Wake every parked worker (e.g. so they can see that work is finished)
+    fn wake_all(&self) {
+        let _idle = self.idle.lock().unwrap_or_else(PoisonError::into_inner);
+        self.wakeup.notify_all();
+    }
+
+    fn find_task(&self, local: &LocalQueue<Task>) -> Option<Task> {
+        local.pop().or_else(|| {
+            std::iter::repeat_with(|| {
+                self.injector
+                    .steal_batch_and_pop(local)
+                    .or_else(|| self.stealers.iter().map(|s| s.steal()).collect())
+            })
+            .find(|steal| !steal.is_retry())
+            .and_then(|steal| steal.success())
+        })
+    }
+
+    fn task_done(&self) {
+        if self.pending.fetch_sub(1, Ordering::SeqCst) == 1 && self.finished() {
+            self.wake_all();
+        }
+    }
+
+    fn producer_done(&self) {
+        if self.producers.fetch_sub(1, Ordering::SeqCst) == 1 && self.finished() {
+            self.wake_all();
+        }
+    }
+
+    /// No task is queued or running, and none can be pushed anymore
+    fn finished(&self) -> bool {
+        self.producers.load(Ordering::SeqCst) == 0 && self.pending.load(Ordering::SeqCst) == 0
+    }
+}
+
 /// Process multiple files in parallel using producer/reader/worker architecture
 ///
-/// This function uses a three-tier parallelism model:
-/// - **Main thread**: Analyzes files and routes them to appropriate queues
-/// - **Reader threads**: Parallel I/O and chunking for large files  
-/// - **Worker threads**: Pattern extraction and database matching
+/// Equivalent to [`process_files_parallel_with`] with default options
+/// apart from the thread counts: matches come back in completion order.
 ///
 /// # Arguments
 ///
 /// * `files` - List of file paths to process
-/// * `num_readers` - Number of reader threads for file I/O (default: num_cpus / 2)
+/// * `num_readers` - Maximum reader threads for streamed files (default: num_cpus / 2)
 /// * `num_workers` - Number of worker threads for processing (default: num_cpus)
 /// * `create_worker` - Factory function that creates a Worker for each worker thread
 ///
@@ -822,9 +1197,10 @@ pub struct ParallelProcessingResult {
 /// )?;
 ///
 /// println!("Found {} matches across all files", result.matches.len());
-/// println!("Routing: {} to workers, {} to readers",
+/// println!("Routing: {} to workers, {} split into {} ranges",
 ///     result.routing_stats.files_to_workers,
-///     result.routing_stats.files_to_readers);
+///     result.routing_stats.files_split,
+///     result.routing_stats.ranges);
 /// # Ok::<(), Box<dyn std::error::Error>>(())
 /// ```
 pub fn process_files_parallel<F, P>(
@@ -834,6 +1210,63 @@ pub fn process_files_parallel<F, P>(
     create_worker: F,
     progress_callback: Option<P>,
 ) -> Result<ParallelProcessingResult, String>
+where
+    F: Fn() -> Result<Worker, String> + Sync + Send + 'static,
+    P: Fn(&WorkerStats) + Sync + Send + 'static,
+{
+    let options = ParallelOptions {
+        num_readers,
+        num_workers,
+        ..ParallelOptions::default()
+    };
+    process_files_parallel_with(files, options, create_worker, progress_callback)
+}
+
+/// Process multiple files in parallel on a work-stealing scheduler
+///
+/// The main thread routes each input:
+/// - **Large uncompressed files** are split into newline-aligned byte
+///   ranges; each range is a task a worker reads on its own file handle
+/// - **Streamed inputs** (stdin, and large gzip files when there are fewer
+///   files than workers) go to reader threads that queue line batches
+/// - **Everything else** is queued as a whole file
+///
+/// Workers take tasks from their own deque and steal from each other when
+/// idle, so one 40GB log next to a handful of small ones still occupies
+/// every core. Line numbers are exact for all of them. With
+/// `options.ordered` the matches are put back in input order by task
+/// sequence number.
+///
+/// # Example
+///
+/// ```rust,no_run
+/// use matchy::{Database, processing, extractor::Extractor};
+///
+/// let options = processing::ParallelOptions {
+///     ordered: true,
+///     ..Default::default()
+/// };
+/// let result = processing::process_files_parallel_with(
+///     vec!["huge.log".into(), "small.log".into()],
+///     options,
+///     || {
+///         let extractor = Extractor::new().map_err(|e| e.to_string())?;
+///         let db = Database::from("threats.mxy").open().map_err(|e| e.to_string())?;
+///         Ok::<_, String>(processing::Worker::builder()
+///             .extractor(extractor)
+///             .add_database("threats", db)
+///             .build())
+///     },
+///     None::<fn(&processing::WorkerStats)>,
+/// )?;
+/// # Ok::<(), Box<dyn std::error::Error>>(())
+/// ```
+pub fn process_files_parallel_with<F, P>(
+    files: Vec<PathBuf>,
+    options: ParallelOptions,
+    create_worker: F,
+    progress_callback: Option<P>,
+) -> Result<ParallelProcessingResult, String>
 where
     F: Fn() -> Result<Worker, String> + Sync + Send + 'static,
     P: Fn(&WorkerStats) + Sync + Send + 'static,
@@ -841,12 +1274,33 @@ where
     let num_cpus = thread::available_parallelism()
         .map(|n| n.get())
         .unwrap_or(4);
-    let _num_readers = num_readers.unwrap_or(num_cpus / 2).max(1);
-    let num_workers = num_workers.unwrap_or(num_cpus);
-
-    // Work queue: readers and main thread send WorkUnits here
-    let (work_sender, work_receiver) = channel::<WorkUnit>();
-    let work_receiver = Arc::new(Mutex::new(work_receiver));
+    let num_readers = options.num_readers.unwrap_or(num_cpus / 2).max(1);
+    let num_workers = options.num_workers.unwrap_or(num_cpus).max(1);
+
+    // Stat everything up front: the range size depends on the total
+    let mut sizes = Vec::with_capacity(files.len());
+    for file_path in &files {
+        if file_path.to_str() == Some("-") {
+            sizes.push(None);
+        } else {
+            let size = fs::metadata(file_path)
+                .map_err(|e| format!("Failed to stat {}: {}", file_path.display(), e))?
+                .len();
+            sizes.push(Some(size));
+        }
+    }
+    let total_bytes: u64 = sizes.iter().flatten().sum();
+    let range_bytes = options.range_bytes.unwrap_or_else(|| {
+        (total_bytes / (num_workers as u64 * RANGES_PER_WORKER))
+            .clamp(MIN_RANGE_BYTES, MAX_RANGE_BYTES)
+    });
+
+    // One deque per worker; the stealers let idle workers take from the others
+    let local_queues: Vec<LocalQueue<Task>> =
+        (0..num_workers).map(|_| LocalQueue::new_fifo()).collect();
+    let scheduler = Arc::new(Scheduler::new(
+        local_queues.iter().map(|queue| queue.stealer()).collect(),
+    ));
 
     // Wrap factory and progress callback in Arc for sharing across threads
     let worker_factory = Arc::new(create_worker);
@@ -859,14 +1313,14 @@ where
 
     // Spawn worker threads
     let mut worker_handles = Vec::new();
-    for worker_id in 0..num_workers {
-        let receiver = Arc::clone(&work_receiver);
+    for (worker_id, local) in local_queues.into_iter().enumerate() {
+        let scheduler = Arc::clone(&scheduler);
         let factory = Arc::clone(&worker_factory);
 
         let progress_cb = progress_callback.clone();
         let stats_map = Arc::clone(&worker_stats_map);
 
-        let handle = thread::spawn(move || -> (Vec<LineMatch>, WorkerStats) {
+        let handle = thread::spawn(move || -> (Vec<PartResult>, WorkerStats) {
             // Create worker for this thread
             let mut worker = match factory() {
                 Ok(w) => w,
@@ -876,25 +1330,49 @@ where
                 }
             };
 
-            let mut local_matches = Vec::new();
+            let mut parts = Vec::new();
             let mut last_progress = std::time::Instant::now();
             let progress_interval = std::time::Duration::from_millis(100);
 
-            // Process work units until channel closes
+            // Process tasks until every producer is done and the queues are drained
             loop {
-                let unit = match receiver.lock().unwrap().recv() {
-                    Ok(u) => u,
-                    Err(_) => break, // Channel closed
+                let task = match scheduler.find_task(&local) {
+                    Some(task) => task,
+                    None if scheduler.finished() => break,
+                    None => {
+                        // Wait for readers to catch up
+                        scheduler.wait_for_work();
+                        continue;
+                    }
                 };
 
-                match process_work_unit_with_worker(&unit, &mut worker) {
-                    Ok(matches) => {
-                        local_matches.extend(matches);
-                    }
+                match process_work_unit_with_worker(&task.unit, &mut worker) {
+                    Ok((matches, lines)) => parts.push(PartResult {
+                        file: task.file,
+                        part: task.part,
+                        range_lines: matches!(task.unit, WorkUnit::Range { .. }).then_some(lines),
+                        matches,
+                    }),
                     Err(e) => {
                         eprintln!("Processing error: {}", e);
+                        // Later ranges of the file are numbered from this
+                        // one's line count; without it they are dropped
+                        if let WorkUnit::Range { path, start, end } = &task.unit {
+                            match count_range_lines(path, *start, *end) {
+                                Ok(lines) => parts.push(PartResult {
+                                    file: task.file,
+                                    part: task.part,
+                                    range_lines: Some(lines),
+                                    matches: Vec::new(),
+                                }),
+                                Err(e) => {
+                                    eprintln!("Skipping the rest of {}: {}", path.display(), e)
+                                }
+                            }
+                        }
                     }
                 }
+                scheduler.task_done();
 
                 // Call progress callback periodically
                 if let Some(ref cb) = progress_cb {
@@ -911,19 +1389,7 @@ where
                             let map = stats_map.lock().unwrap();
                             let mut agg = WorkerStats::default();
                             for stats in map.values() {
-                                agg.lines_processed += stats.lines_processed;
-                                agg.candidates_tested += stats.candidates_tested;
-                                agg.matches_found += stats.matches_found;
-                                agg.lines_with_matches += stats.lines_with_matches;
-                                agg.total_bytes += stats.total_bytes;
-                                agg.extraction_time += stats.extraction_time;
-                                agg.extraction_samples += stats.extraction_samples;
-                                agg.lookup_time += stats.lookup_time;
-                                agg.lookup_samples += stats.lookup_samples;
-                                agg.ipv4_count += stats.ipv4_count;
-                                agg.ipv6_count += stats.ipv6_count;
-                                agg.domain_count += stats.domain_count;
-                                agg.email_count += stats.email_count;
+                                agg.merge(stats);
                             }
                             agg
                         };
@@ -936,93 +1402,99 @@ where
 
             // Return matches and stats from this worker
             let stats = worker.stats().clone();
-            (local_matches, stats)
+            (parts, stats)
         });
 
         worker_handles.push(handle);
     }
 
-    // Main thread: analyze files and route to appropriate handling
+    // Main thread: route each file to ranges, a reader thread, or a whole-file task
     let mut reader_handles = Vec::new();
     let mut remaining = files.len();
     let mut routing_stats = RoutingStats::default();
 
-    for file_path in files {
-        // Special handling for stdin
-        let is_stdin = file_path.to_str() == Some("-");
+    for (file, (file_path, size)) in files.into_iter().zip(sizes).enumerate() {
+        let streamed = match size {
+            // Stdin always goes to a reader thread (can't stat or split it)
+            None => true,
+            Some(file_size) if crate::file_reader::is_gzip_path(&file_path) => {
+                // Gzip can't be split: chunk it on a reader when cores would idle
+                remaining < num_workers
+                    && file_size >= SMALL_FILE
+                    && reader_handles.len() < num_readers
+            }
+            Some(file_size) if file_size >= 2 * range_bytes => {
+                let ranges = split_file(&file_path, range_bytes)
+                    .map_err(|e| format!("Failed to split {}: {}", file_path.display(), e))?;
+                routing_stats.files_split += 1;
+                routing_stats.ranges += ranges.len();
+                routing_stats.bytes_split += file_size;
+
+                for (part, (start, end)) in ranges.into_iter().enumerate() {
+                    scheduler.push(Task {
+                        file,
+                        part,
+                        unit: WorkUnit::Range {
+                            path: file_path.clone(),
+                            start,
+                            end,
+                        },
+                    });
+                }
+                remaining -= 1;
+                continue;
+            }
+            Some(_) => false,
+        };
 
-        if is_stdin {
-            // Always route stdin to a reader thread (can't stat it)
+        if streamed {
             routing_stats.files_to_readers += 1;
-            // Size unknown for stdin
-            routing_stats.bytes_to_readers += 0;
-
-            let work_sender_clone = work_sender.clone();
-            let handle = thread::spawn(move || reader_thread(file_path, work_sender_clone));
+            routing_stats.bytes_to_readers += size.unwrap_or(0);
+
+            scheduler.producers.fetch_add(1, Ordering::SeqCst);
+            let scheduler = Arc::clone(&scheduler);
+            let handle = thread::spawn(move || {
+                let result = reader_thread(file, file_path, &scheduler);
+                scheduler.producer_done();
+                result
+            });
             reader_handles.push(handle);
         } else {
-            // Regular file - get size and apply chunking algorithm
-            let file_size = fs::metadata(&file_path)
-                .map_err(|e| format!("Failed to stat {}: {}", file_path.display(), e))?
-                .len();
-
-            // Apply chunking algorithm
-            let should_chunk = remaining < num_workers && file_size >= SMALL_FILE;
-
-            if should_chunk {
-                // Spawn reader thread to chunk this file
-                routing_stats.files_to_readers += 1;
-                routing_stats.bytes_to_readers += file_size;
-
-                let work_sender_clone = work_sender.clone();
-                let handle = thread::spawn(move || reader_thread(file_path, work_sender_clone));
-                reader_handles.push(handle);
-            } else {
-                // Send whole file directly to worker queue
-                routing_stats.files_to_workers += 1;
-                routing_stats.bytes_to_workers += file_size;
-
-                work_sender
-                    .send(WorkUnit::WholeFile { path: file_path })
-                    .map_err(|_| "Worker channel closed")?;
-            }
+            // Send whole file directly to the workers
+            routing_stats.files_to_workers += 1;
+            routing_stats.bytes_to_workers += size.unwrap_or(0);
+
+            scheduler.push(Task {
+                file,
+                part: 0,
+                unit: WorkUnit::WholeFile { path: file_path },
+            });
         }
 
         remaining -= 1;
     }
 
-    // Drop main thread's sender so workers know when all work is queued
-    drop(work_sender);
+    // Workers may stop once this and every reader thread are done
+    scheduler.producer_done();
 
     // Wait for all reader threads to finish
     for handle in reader_handles {
-        if let Err(e) = handle.join() {
-            eprintln!("Reader thread panicked: {:?}", e);
+        match handle.join() {
+            Ok(Err(e)) => eprintln!("Reader error: {}", e),
+            Err(e) => eprintln!("Reader thread panicked: {:?}", e),
+            Ok(Ok(())) => {}
         }
     }
 
     // Wait for all worker threads to finish and collect results
-    let mut all_matches = Vec::new();
+    let mut parts = Vec::new();
     let mut aggregate_stats = WorkerStats::default();
 
     for handle in worker_handles {
         match handle.join() {
-            Ok((matches, stats)) => {
-                all_matches.extend(matches);
-                // Aggregate stats
-                aggregate_stats.lines_processed += stats.lines_processed;
-                aggregate_stats.candidates_tested += stats.candidates_tested;
-                aggregate_stats.matches_found += stats.matches_found;
-                aggregate_stats.lines_with_matches += stats.lines_with_matches;
-                aggregate_stats.total_bytes += stats.total_bytes;
-                aggregate_stats.extraction_time += stats.extraction_time;
-                aggregate_stats.extraction_samples += stats.extraction_samples;
-                aggregate_stats.lookup_time += stats.lookup_time;
-                aggregate_stats.lookup_samples += stats.lookup_samples;
-                aggregate_stats.ipv4_count += stats.ipv4_count;
-                aggregate_stats.ipv6_count += stats.ipv6_count;
-                aggregate_stats.domain_count += stats.domain_count;
-                aggregate_stats.email_count += stats.email_count;
+            Ok((worker_parts, stats)) => {
+                parts.extend(worker_parts);
+                aggregate_stats.merge(&stats);
             }
             Err(e) => {
                 eprintln!("Worker thread panicked: {:?}", e);
@@ -1030,42 +1502,94 @@ where
         }
     }
 
+    // A range's line numbers start after the lines of the ranges before it
+    let mut range_lines: Vec<(usize, usize, usize)> = parts
+        .iter()
+        .filter_map(|p| p.range_lines.map(|lines| (p.file, p.part, lines)))
+        .collect();
+    range_lines.sort_unstable();
+    let mut line_offsets = std::collections::HashMap::new();
+    let mut current_file = usize::MAX;
+    let mut next_part = 0;
+    let mut lines_before = 0;
+    for (file, part, lines) in range_lines {
+        if file != current_file {
+            current_file = file;
+            next_part = 0;
+            lines_before = 0;
+        }
+        // A missing range leaves every later one without a line offset
+        if part == next_part {
+            line_offsets.insert((file, part), lines_before);
+            lines_before += lines;
+            next_part += 1;
+        }
+    }
+    parts.retain(|p| p.range_lines.is_none() || line_offsets.contains_key(&(p.file, p.part)));
+    for p in &mut parts {
+        if let Some(&offset) = line_offsets.get(&(p.file, p.part)) {
+            for m in &mut p.matches {
+                m.line_number += offset;
+            }
+        }
+    }
+
+    if options.ordered {
+        parts.sort_unstable_by_key(|p| (p.file, p.part));
+    }
+
     Ok(ParallelProcessingResult {
-        matches: all_matches,
+        matches: parts.into_iter().flat_map(|p| p.matches).collect(),
         routing_stats,
         worker_stats: aggregate_stats,
     })
 }
 
+/// Count the lines in a byte range, for numbering the ranges after it
+fn count_range_lines(path: &Path, start: u64, end: u64) -> Result<usize, String> {
+    let mut reader = LineFileReader::for_range(path, start, end, 128 * 1024)
+        .map_err(|e| format!("Failed to open {}: {}", path.display(), e))?;
+    let mut lines = 0;
+    while let Some(batch) = reader
+        .next_batch()
+        .map_err(|e| format!("Read error in {}: {}", path.display(), e))?
+    {
+        lines += batch.line_offsets.len();
+    }
+    Ok(lines)
+}
+
 /// Process a work unit using a Worker instance
+///
+/// Returns the matches and the number of lines read.
 fn process_work_unit_with_worker(
     unit: &WorkUnit,
     worker: &mut Worker,
-) -> Result<Vec<LineMatch>, String> {
-    match unit {
-        WorkUnit::WholeFile { path } => {
-            // Open and process entire file
-            let mut reader = LineFileReader::new(path, 128 * 1024)
-                .map_err(|e| format!("Failed to open {}: {}", path.display(), e))?;
-
-            let mut all_matches = Vec::new();
-
-            while let Some(batch) = reader
-                .next_batch()
-                .map_err(|e| format!("Read error in {}: {}", path.display(), e))?
-            {
-                // Use Worker's process_lines method
-                let matches = worker.process_lines(&batch)?;
-                all_matches.extend(matches);
-            }
-
-            Ok(all_matches)
+) -> Result<(Vec<LineMatch>, usize), String> {
+    let mut reader = match unit {
+        WorkUnit::WholeFile { path } => LineFileReader::new(path, 128 * 1024)
+            .map_err(|e| format!("Failed to open {}: {}", path.display(), e))?,
+        WorkUnit::Range { path, start, end } => {
+            LineFileReader::for_range(path, *start, *end, 128 * 1024)
+                .map_err(|e| format!("Failed to open {}: {}", path.display(), e))?
         }
         WorkUnit::Chunk { batch } => {
             // Process pre-chunked data directly using Worker
-            worker.process_lines(batch)
+            return Ok((worker.process_lines(batch)?, batch.line_offsets.len()));
         }
+    };
+
+    let mut all_matches = Vec::new();
+    let mut lines = 0;
+    while let Some(batch) = reader
+        .next_batch()
+        .map_err(|e| format!("Read error in {}: {}", reader.source_path.display(), e))?
+    {
+        lines += batch.line_offsets.len();
+        all_matches.extend(worker.process_lines(&batch)?);
     }
+
+    Ok((all_matches, lines))
 }
 
 #[cfg(test)]
@@ -1105,6 +1629,159 @@ mod tests {
         assert_eq!(total_lines, 10);
     }
 
+    #[test]
+    fn test_split_file_ranges() {
+        let mut file = NamedTempFile::new().unwrap();
+        for i in 0..500 {
+            writeln!(file, "line {} {}", i, "x".repeat(i % 37)).unwrap();
+        }
+        write!(file, "no trailing newline").unwrap();
+        file.flush().unwrap();
+        let contents = fs::read(file.path()).unwrap();
+
+        let ranges = split_file(file.path(), 1000).unwrap();
+        assert!(ranges.len() > 5);
+        assert_eq!(ranges[0].0, 0);
+        assert_eq!(ranges.last().unwrap().1, contents.len() as u64);
+
+        let mut lines = 0;
+        for (i, &(start, end)) in ranges.iter().enumerate() {
+            if i > 0 {
+                assert_eq!(start, ranges[i - 1].1, "ranges must be contiguous");
+            }
+            if i + 1 < ranges.len() {
+                assert_eq!(
+                    contents[end as usize - 1],
+                    b'\n',
+                    "ranges end after a newline"
+                );
+            }
+
+            let mut reader = LineFileReader::for_range(file.path(), start, end, 256).unwrap();
+            let mut read = Vec::new();
+            while let Some(batch) = reader.next_batch().unwrap() {
+                lines += batch.line_offsets.len();
+                read.extend_from_slice(&batch.data);
+            }
+            assert_eq!(read, &contents[start as usize..end as usize]);
+        }
+        assert_eq!(lines, 500);
+
+        // A file without newlines can't be split
+        let mut single = NamedTempFile::new().unwrap();
+        write!(single, "{}", "y".repeat(5000)).unwrap();
+        single.flush().unwrap();
+        assert_eq!(split_file(single.path(), 1000).unwrap(), vec![(0, 5000)]);
+    }
+
+    #[test]
+    fn test_parallel_ranges_keep_line_numbers() {
+        use crate::data_section::DataValue;
+        use crate::glob::MatchMode;
+        use crate::mmdb_builder::MmdbBuilder;
+        use std::collections::HashMap;
+
+        let mut builder = MmdbBuilder::new(MatchMode::CaseSensitive);
+        let mut data = HashMap::new();
+        data.insert("threat".to_string(), DataValue::String("yes".to_string()));
+        builder.add_entry("10.9.8.7", data).unwrap();
+        let db_bytes = builder.build().unwrap();
+
+        let mut large = NamedTempFile::new().unwrap();
+        let mut expected = Vec::new();
+        for line in 1..=2000 {
+            if line % 97 == 0 {
+                writeln!(large, "{} connect from 10.9.8.7", line).unwrap();
+                expected.push(line);
+            } else {
+                writeln!(large, "{} nothing to see here", line).unwrap();
+            }
+        }
+        large.flush().unwrap();
+        let mut small = NamedTempFile::new().unwrap();
+        writeln!(small, "hello\n10.9.8.7").unwrap();
+        small.flush().unwrap();
+
+        let options = ParallelOptions {
+            num_workers: Some(4),
+            ordered: true,
+            range_bytes: Some(2048),
+            ..ParallelOptions::default()
+        };
+        let result = process_files_parallel_with(
+            vec![large.path().to_path_buf(), small.path().to_path_buf()],
+            options,
+            move || {
+                let db = Database::from_bytes(db_bytes.clone()).map_err(|e| e.to_string())?;
+                let extractor = Extractor::new().map_err(|e| e.to_string())?;
+                Ok(Worker::builder()
+                    .extractor(extractor)
+                    .add_database("db", db)
+                    .build())
+            },
+            None::<fn(&WorkerStats)>,
+        )
+        .unwrap();
+
+        assert_eq!(result.routing_stats.files_split, 1);
+        assert!(result.routing_stats.ranges > 4);
+        assert_eq!(result.routing_stats.files_to_workers, 1);
+        assert_eq!(result.worker_stats.lines_processed, 2002);
+
+        // Ordered output: the large file's hits by line, then the small file's
+        let lines: Vec<usize> = result.matches.iter().map(|m| m.line_number).collect();
+        expected.push(2);
+        assert_eq!(lines, expected);
+        for m in &result.matches[..expected.len() - 1] {
+            assert_eq!(m.source, large.path());
+            assert!(m.input_line.starts_with(&m.line_number.to_string()));
+        }
+        assert_eq!(result.matches.last().unwrap().source, small.path());
+    }
+
+    #[test]
+    fn test_federated_worker_matches_separate() {
+        use crate::data_section::DataValue;
+        use crate::glob::MatchMode;
+        use crate::mmdb_builder::MmdbBuilder;
+        use std::collections::HashMap;
+
+        let build = |entries: &[&str]| {
+            let mut builder = MmdbBuilder::new(MatchMode::CaseSensitive);
+            for entry in entries {
+                let mut data = HashMap::new();
+                data.insert("entry".to_string(), DataValue::String(entry.to_string()));
+                builder.add_entry(entry, data).unwrap();
+            }
+            builder.build().unwrap()
+        };
+        let threats = build(&["*.evil.com", "10.9.8.7"]);
+        let allowlist = build(&["www.evil.com", "*.evil.com"]);
+
+        let text = b"GET www.evil.com from 10.9.8.7, then cdn.evil.com and example.org";
+        let run = |federated: bool| {
+            let mut worker = Worker::builder()
+                .extractor(Extractor::new().unwrap())
+                .add_database("threats", Database::from_bytes(threats.clone()).unwrap())
+                .add_database(
+                    "allowlist",
+                    Database::from_bytes(allowlist.clone()).unwrap(),
+                )
+                .federated(federated)
+                .build();
+            worker
+                .process_bytes(text)
+                .unwrap()
+                .into_iter()
+                .map(|m| (m.matched_text, m.database_id, format!("{:?}", m.result)))
+                .collect::<Vec<_>>()
+        };
+
+        let separate = run(false);
+        assert_eq!(separate.len(), 5);
+        assert_eq!(run(true), separate);
+    }
+
     #[test]
     fn test_chunk_size_selection() {
         // Small files: 256KB chunks
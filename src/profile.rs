@@ -0,0 +1,497 @@
+//! Sampled per-stage latency histograms for database queries
+//!
+//! A [`QueryProfiler`] attached to a [`Database`](crate::Database) (see
+//! [`DatabaseOpener::profiler`](crate::DatabaseOpener::profiler)) times one
+//! query in every `sample_every` and splits it into stages: the IP tree
+//! walk, the literal hash probe, the Aho-Corasick scan of the glob matcher,
+//! glob verification of its candidates, and decoding the result data. Each
+//! stage's durations go into a log-linear histogram (four buckets per power
+//! of two, as in HDR histograms), so percentiles are accurate to within a
+//! quarter of their value at any scale.
+//!
+//! Sampled queries also report how much work they did: AC states visited,
+//! candidate patterns the AC scan produced, globs checked and rejected, and
+//! literal hash slots probed.
+//!
+//! Queries that are not sampled pay one thread-local counter increment.
+//! Only lookups through the query cache ([`lookup`](crate::Database::lookup),
+//! [`lookup_ip`](crate::Database::lookup_ip) and
+//! [`lookup_string`](crate::Database::lookup_string)) are sampled; cache hits
+//! are timed as data decoding only.
+//!
+//! # Example
+//!
+//! ```no_run
+//! use matchy::profile::{QueryProfiler, QueryStage};
+//! use matchy::Database;
+//! use std::sync::Arc;
+//!
+//! let profiler = Arc::new(QueryProfiler::new(64));
+//! let db = Database::from("threats.mxy")
+//!     .profiler(Arc::clone(&profiler))
+//!     .open()?;
+//! // ... run queries ...
+//! let profile = profiler.snapshot();
+//! let scan = profile.stage(QueryStage::PatternScan);
+//! println!("AC scan p99: {} ns", scan.percentile_ns(0.99));
+//! # Ok::<(), Box<dyn std::error::Error>>(())
+//! ```
+
+use std::cell::Cell;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::time::{Duration, Instant};
+
+/// A stage of query processing timed by [`QueryProfiler`]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum QueryStage {
+    /// IP search tree or stride index walk
+    IpTree,
+    /// Literal hash table probe
+    LiteralHash,
+    /// Aho-Corasick scan of the glob matcher and candidate collection
+    PatternScan,
+    /// `GlobPattern::matches` over the scan's candidates
+    GlobVerify,
+    /// Decoding result data from the data section
+    DataDecode,
+}
+
+impl QueryStage {
+    /// Number of stages
+    pub const COUNT: usize = 5;
+
+    /// Every stage, in pipeline order
+    pub const ALL: [QueryStage; Self::COUNT] = [
+        QueryStage::IpTree,
+        QueryStage::LiteralHash,
+        QueryStage::PatternScan,
+        QueryStage::GlobVerify,
+        QueryStage::DataDecode,
+    ];
+
+    /// Short display name
+    pub fn name(self) -> &'static str {
+        match self {
+            QueryStage::IpTree => "ip tree",
+            QueryStage::LiteralHash => "literal hash",
+            QueryStage::PatternScan => "pattern scan",
+            QueryStage::GlobVerify => "glob verify",
+            QueryStage::DataDecode => "data decode",
+        }
+    }
+}
+
+/// Buckets per power of two (2 bits of sub-bucket precision)
+const SUB_BUCKETS: usize = 4;
+
+/// Powers of two covered, from 1 ns to about 18 minutes
+const OCTAVES: usize = 40;
+
+/// Buckets in every latency histogram
+pub const HISTOGRAM_BUCKETS: usize = OCTAVES * SUB_BUCKETS;
+
+/// Histogram bucket holding `ns`
+#[inline]
+fn bucket_index(ns: u64) -> usize {
+    if ns < SUB_BUCKETS as u64 {
+        return ns as usize;
+    }
+    let exponent = 63 - ns.leading_zeros() as usize;
+    let mantissa = ((ns >> (exponent - 2)) & 3) as usize;
+    ((exponent - 1) * SUB_BUCKETS + mantissa).min(HISTOGRAM_BUCKETS - 1)
+}
+
+/// Smallest value that lands in bucket `index`
+fn bucket_floor(index: usize) -> u64 {
+    if index < SUB_BUCKETS {
+        return index as u64;
+    }
+    let exponent = index / SUB_BUCKETS + 1;
+    let mantissa = (index % SUB_BUCKETS) as u64;
+    (SUB_BUCKETS as u64 + mantissa) << (exponent - 2)
+}
+
+/// Latency distribution of one stage
+#[derive(Debug, Clone)]
+pub struct LatencyHistogram {
+    counts: Vec<u64>,
+    total_ns: u64,
+    max_ns: u64,
+}
+
+impl Default for LatencyHistogram {
+    fn default() -> Self {
+        Self {
+            counts: vec![0; HISTOGRAM_BUCKETS],
+            total_ns: 0,
+            max_ns: 0,
+        }
+    }
+}
+
+impl LatencyHistogram {
+    /// Number of timed samples
+    pub fn count(&self) -> u64 {
+        self.counts.iter().sum()
+    }
+
+    /// Sum of all sampled durations
+    pub fn total(&self) -> Duration {
+        Duration::from_nanos(self.total_ns)
+    }
+
+    /// Mean sampled duration in nanoseconds (0 without samples)
+    pub fn mean_ns(&self) -> f64 {
+        match self.count() {
+            0 => 0.0,
+            n => self.total_ns as f64 / n as f64,
+        }
+    }
+
+    /// Longest sampled duration in nanoseconds
+    pub fn max_ns(&self) -> u64 {
+        self.max_ns
+    }
+
+    /// Duration at quantile `q` (0.0 to 1.0) in nanoseconds
+    ///
+    /// Reports the top of the bucket holding the quantile, capped at the
+    /// maximum seen: never below the true value, and at most a quarter above.
+    pub fn percentile_ns(&self, q: f64) -> u64 {
+        let total = self.count();
+        if total == 0 {
+            return 0;
+        }
+        let rank = ((q.clamp(0.0, 1.0) * total as f64).ceil() as u64).max(1);
+        let mut seen = 0;
+        for (index, &count) in self.counts.iter().enumerate() {
+            seen += count;
+            if seen >= rank {
+                let top = bucket_floor(index + 1).saturating_sub(1);
+                return top.min(self.max_ns);
+            }
+        }
+        self.max_ns
+    }
+
+    /// Non-empty buckets as `(smallest value in ns, count)`
+    pub fn buckets(&self) -> impl Iterator<Item = (u64, u64)> + '_ {
+        self.counts
+            .iter()
+            .enumerate()
+            .filter(|(_, &count)| count > 0)
+            .map(|(index, &count)| (bucket_floor(index), count))
+    }
+}
+
+/// Snapshot of a [`QueryProfiler`]
+#[derive(Debug, Clone, Default)]
+pub struct ProfileStats {
+    /// Queries that were sampled
+    pub sampled_queries: u64,
+    /// Per-stage histograms, indexed like [`QueryStage::ALL`]
+    pub stages: [LatencyHistogram; QueryStage::COUNT],
+    /// Aho-Corasick states entered, including failure transitions
+    pub ac_states_visited: u64,
+    /// Candidate patterns produced by the AC scan (and pure wildcards)
+    pub glob_candidates: u64,
+    /// Candidates run through `GlobPattern::matches`
+    pub globs_checked: u64,
+    /// Candidates `GlobPattern::matches` rejected
+    pub globs_rejected: u64,
+    /// Literal hash lookups sampled
+    pub literal_lookups: u64,
+    /// Literal hash slots examined by those lookups
+    pub literal_probes: u64,
+}
+
+impl ProfileStats {
+    /// Histogram of one stage
+    pub fn stage(&self, stage: QueryStage) -> &LatencyHistogram {
+        &self.stages[stage as usize]
+    }
+
+    /// Mean slots examined per literal hash lookup
+    pub fn mean_probe_length(&self) -> f64 {
+        match self.literal_lookups {
+            0 => 0.0,
+            n => self.literal_probes as f64 / n as f64,
+        }
+    }
+
+    /// Share of checked globs that did not match (0.0 to 1.0)
+    pub fn glob_reject_rate(&self) -> f64 {
+        match self.globs_checked {
+            0 => 0.0,
+            n => self.globs_rejected as f64 / n as f64,
+        }
+    }
+}
+
+/// Work counts of one pattern scan, left in the scratch by the matcher
+#[derive(Debug, Clone, Copy, Default)]
+pub(crate) struct ScanCounters {
+    pub ac_states: u64,
+    pub candidates: u64,
+    pub globs_checked: u64,
+    pub globs_rejected: u64,
+    /// Time spent verifying candidates (sampled queries only)
+    pub verify: Duration,
+}
+
+/// Largest number of profiler stripes worth allocating
+const MAX_STRIPES: usize = 64;
+
+/// One stripe of profile counters, padded to its own cache lines
+#[repr(align(64))]
+struct ProfileStripe {
+    sampled_queries: AtomicU64,
+    counts: Box<[AtomicU64]>,
+    totals: [AtomicU64; QueryStage::COUNT],
+    maxima: [AtomicU64; QueryStage::COUNT],
+    ac_states_visited: AtomicU64,
+    glob_candidates: AtomicU64,
+    globs_checked: AtomicU64,
+    globs_rejected: AtomicU64,
+    literal_lookups: AtomicU64,
+    literal_probes: AtomicU64,
+}
+
+impl ProfileStripe {
+    fn new() -> Self {
+        Self {
+            sampled_queries: AtomicU64::new(0),
+            counts: (0..QueryStage::COUNT * HISTOGRAM_BUCKETS)
+                .map(|_| AtomicU64::new(0))
+                .collect(),
+            totals: Default::default(),
+            maxima: Default::default(),
+            ac_states_visited: AtomicU64::new(0),
+            glob_candidates: AtomicU64::new(0),
+            globs_checked: AtomicU64::new(0),
+            globs_rejected: AtomicU64::new(0),
+            literal_lookups: AtomicU64::new(0),
+            literal_probes: AtomicU64::new(0),
+        }
+    }
+}
+
+thread_local! {
+    /// Queries this thread has started, for picking samples
+    static QUERY_TICK: Cell<u32> = const { Cell::new(0) };
+    /// Whether the query running on this thread is being sampled
+    static SAMPLING: Cell<bool> = const { Cell::new(false) };
+}
+
+/// Whether the query running on this thread is being sampled
+#[inline]
+pub(crate) fn sampling() -> bool {
+    SAMPLING.with(Cell::get)
+}
+
+/// Marks the current thread's query as sampled until dropped
+pub(crate) struct SampleGuard;
+
+impl Drop for SampleGuard {
+    fn drop(&mut self) {
+        SAMPLING.with(|s| s.set(false));
+    }
+}
+
+/// Sampled per-stage query timing, shareable by several databases
+///
+/// Counters are striped per thread like the database's query stats, so
+/// concurrent samples do not contend. One profiler can be attached to many
+/// handles (e.g. one per worker thread) to profile them together.
+pub struct QueryProfiler {
+    /// `sample_every - 1` (a power of two minus one)
+    mask: u32,
+    stripes: Box<[ProfileStripe]>,
+    stripe_mask: usize,
+}
+
+impl std::fmt::Debug for QueryProfiler {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("QueryProfiler")
+            .field("sample_every", &self.sample_every())
+            .finish_non_exhaustive()
+    }
+}
+
+impl QueryProfiler {
+    /// Sample one query in every `sample_every` (rounded up to a power of two)
+    pub fn new(sample_every: u32) -> Self {
+        Self::with_concurrency(sample_every, 1)
+    }
+
+    /// Like [`new`](Self::new), sized for `threads` threads sampling at once
+    pub fn with_concurrency(sample_every: u32, threads: usize) -> Self {
+        let stripe_count = threads.max(1).next_power_of_two().min(MAX_STRIPES);
+        Self {
+            mask: sample_every.max(1).next_power_of_two() - 1,
+            stripes: (0..stripe_count).map(|_| ProfileStripe::new()).collect(),
+            stripe_mask: stripe_count - 1,
+        }
+    }
+
+    /// Queries per sample
+    pub fn sample_every(&self) -> u32 {
+        self.mask + 1
+    }
+
+    /// Decide whether the query starting on this thread is sampled
+    #[inline]
+    pub(crate) fn start_query(&self) -> Option<SampleGuard> {
+        let tick = QUERY_TICK.with(|t| {
+            let tick = t.get().wrapping_add(1);
+            t.set(tick);
+            tick
+        });
+        if tick & self.mask != 0 {
+            return None;
+        }
+        SAMPLING.with(|s| s.set(true));
+        self.local().sampled_queries.fetch_add(1, Ordering::Relaxed);
+        Some(SampleGuard)
+    }
+
+    #[inline]
+    fn local(&self) -> &ProfileStripe {
+        &self.stripes[crate::query_cache::thread_slot() & self.stripe_mask]
+    }
+
+    /// Add one sampled duration of `stage`
+    pub(crate) fn record(&self, stage: QueryStage, elapsed: Duration) {
+        let ns = elapsed.as_nanos().min(u64::MAX as u128) as u64;
+        let stripe = self.local();
+        let index = stage as usize;
+        stripe.counts[index * HISTOGRAM_BUCKETS + bucket_index(ns)].fetch_add(1, Ordering::Relaxed);
+        stripe.totals[index].fetch_add(ns, Ordering::Relaxed);
+        stripe.maxima[index].fetch_max(ns, Ordering::Relaxed);
+    }
+
+    /// Time since `start` as `stage`, when a sample is running
+    #[inline]
+    pub(crate) fn record_since(&self, stage: QueryStage, start: Option<Instant>) {
+        if let Some(start) = start {
+            self.record(stage, start.elapsed());
+        }
+    }
+
+    /// Add the work counts and verification time of a sampled pattern scan
+    pub(crate) fn record_scan(&self, scan: &ScanCounters) {
+        let stripe = self.local();
+        stripe
+            .ac_states_visited
+            .fetch_add(scan.ac_states, Ordering::Relaxed);
+        stripe
+            .glob_candidates
+            .fetch_add(scan.candidates, Ordering::Relaxed);
+        stripe
+            .globs_checked
+            .fetch_add(scan.globs_checked, Ordering::Relaxed);
+        stripe
+            .globs_rejected
+            .fetch_add(scan.globs_rejected, Ordering::Relaxed);
+        self.record(QueryStage::GlobVerify, scan.verify);
+    }
+
+    /// Add one sampled literal hash lookup that examined `probes` slots
+    pub(crate) fn record_probes(&self, probes: usize) {
+        let stripe = self.local();
+        stripe.literal_lookups.fetch_add(1, Ordering::Relaxed);
+        stripe
+            .literal_probes
+            .fetch_add(probes as u64, Ordering::Relaxed);
+    }
+
+    /// Sum all stripes (approximate while queries are in flight)
+    pub fn snapshot(&self) -> ProfileStats {
+        let mut stats = ProfileStats::default();
+        for stripe in self.stripes.iter() {
+            let load = |counter: &AtomicU64| counter.load(Ordering::Relaxed);
+            stats.sampled_queries += load(&stripe.sampled_queries);
+            for (index, histogram) in stats.stages.iter_mut().enumerate() {
+                let counts = &stripe.counts[index * HISTOGRAM_BUCKETS..][..HISTOGRAM_BUCKETS];
+                for (total, count) in histogram.counts.iter_mut().zip(counts) {
+                    *total += load(count);
+                }
+                histogram.total_ns += load(&stripe.totals[index]);
+                histogram.max_ns = histogram.max_ns.max(load(&stripe.maxima[index]));
+            }
+            stats.ac_states_visited += load(&stripe.ac_states_visited);
+            stats.glob_candidates += load(&stripe.glob_candidates);
+            stats.globs_checked += load(&stripe.globs_checked);
+            stats.globs_rejected += load(&stripe.globs_rejected);
+            stats.literal_lookups += load(&stripe.literal_lookups);
+            stats.literal_probes += load(&stripe.literal_probes);
+        }
+        stats
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_bucket_bounds() {
+        for ns in [
+            0u64,
+            1,
+            3,
+            4,
+            5,
+            7,
+            8,
+            9,
+            15,
+            16,
+            100,
+            1_000,
+            123_456,
+            1 << 30,
+        ] {
+            let index = bucket_index(ns);
+            assert!(bucket_floor(index) <= ns, "{} below bucket {}", ns, index);
+            assert!(
+                ns < bucket_floor(index + 1),
+                "{} above bucket {}",
+                ns,
+                index
+            );
+        }
+        // Buckets are at most a quarter of their value wide
+        for index in SUB_BUCKETS..HISTOGRAM_BUCKETS - 1 {
+            let width = bucket_floor(index + 1) - bucket_floor(index);
+            assert!(width * 4 <= bucket_floor(index));
+        }
+    }
+
+    #[test]
+    fn test_percentiles() {
+        let profiler = QueryProfiler::new(1);
+        for ns in 1..=1000u64 {
+            profiler.record(QueryStage::IpTree, Duration::from_nanos(ns));
+        }
+        let stats = profiler.snapshot();
+        let tree = stats.stage(QueryStage::IpTree);
+        assert_eq!(tree.count(), 1000);
+        assert_eq!(tree.max_ns(), 1000);
+        assert!((tree.mean_ns() - 500.5).abs() < 1e-9);
+        for (q, exact) in [(0.5, 500u64), (0.9, 900), (0.99, 990)] {
+            let p = tree.percentile_ns(q);
+            assert!(p >= exact && p <= exact + exact / 4, "p{} = {}", q, p);
+        }
+        assert_eq!(stats.stage(QueryStage::DataDecode).count(), 0);
+    }
+
+    #[test]
+    fn test_sampling_rate() {
+        let profiler = QueryProfiler::new(8);
+        let sampled = (0..64).filter(|_| profiler.start_query().is_some()).count();
+        assert_eq!(sampled, 8);
+        assert_eq!(profiler.snapshot().sampled_queries, 8);
+        assert!(!sampling());
+    }
+}
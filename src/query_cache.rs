@@ -0,0 +1,747 @@
+//! Sharded query result cache
+//!
+//! A `Database` handle may be shared by many threads, so its LRU caches are
+//! split into independently locked shards. A query's shard is chosen from the
+//! hash of its key, which spreads concurrent lookups over different locks
+//! while keeping each key in exactly one place.
+//!
+//! Entries are small and fixed-size. String queries are keyed by a 64-bit
+//! fingerprint and IP queries by the binary address, in separate caches that
+//! split the configured capacity, and each entry holds a [`CachedResult`]
+//! locating the match instead of a decoded copy. A string hit is checked
+//! against the stored query text, so colliding fingerprints never share a
+//! result. A hit allocates nothing; the caller decodes what it needs from
+//! the (usually memory-mapped) database.
+//!
+//! Shards are padded to a cache line so that neighbouring locks don't
+//! false-share under contention. Each shard evicts under the handle's
+//! [`CachePolicy`] (LRU unless configured otherwise).
+//!
+//! Misses can optionally be kept out of the LRU caches altogether, in a
+//! direct-mapped table of fingerprints read and written with plain atomics
+//! (see [`NegativeCache`]). Workloads where nearly every query misses then
+//! stop evicting their hits, and a repeated miss takes no lock.
+
+use crate::cache_policy::{CacheCounters, CachePolicy, FxBuildHasher, PolicyCache};
+use std::collections::hash_map::RandomState;
+use std::hash::BuildHasher;
+use std::net::IpAddr;
+use std::num::NonZeroUsize;
+use std::sync::atomic::{AtomicU64, AtomicUsize, Ordering};
+use std::sync::{Arc, Mutex, MutexGuard, PoisonError};
+
+/// Upper bound on shard count (more shards than this buys nothing)
+const MAX_SHARDS: usize = 64;
+
+/// Smallest useful per-shard capacity; tiny caches get fewer shards
+const MIN_SHARD_CAPACITY: usize = 16;
+
+/// Where a cached match's data lives
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub(crate) enum MatchData {
+    /// Record offset within the layer's MMDB data section
+    Offset(u32),
+    /// Stored in the layer's pattern section (pattern-only databases)
+    Paraglob,
+    /// The pattern has no data
+    None,
+}
+
+/// One pattern match, as stored in the cache
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub(crate) struct MatchRef {
+    /// Pattern ID reported to callers (includes the layer's ID offset)
+    pub(crate) pattern_id: u32,
+    /// Layer that matched: 0 for the database itself, `n` for its nth overlay
+    pub(crate) layer: u32,
+    /// Where the match's data lives in that layer
+    pub(crate) data: MatchData,
+}
+
+/// Compact handle for a lookup result
+///
+/// Tombstones are already filtered out, so turning a handle back into a
+/// `QueryResult` only decodes data.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub(crate) enum CachedResult {
+    /// The database has data of the query's kind, but nothing matched
+    NotFound,
+    /// IP address match
+    Ip {
+        /// Layer whose tree answered
+        layer: u32,
+        /// Record offset within that layer's data section
+        offset: u32,
+        /// Network prefix length (CIDR)
+        prefix_len: u8,
+    },
+    /// A single pattern match (the common case, stored inline)
+    Match(MatchRef),
+    /// Several pattern matches, shared so a hit only bumps a count
+    Matches(Arc<[MatchRef]>),
+}
+
+impl CachedResult {
+    /// Handle for a list of pattern matches (`NotFound` when empty)
+    pub(crate) fn from_matches(matches: Vec<MatchRef>) -> Self {
+        match matches.as_slice() {
+            [] => CachedResult::NotFound,
+            [only] => CachedResult::Match(*only),
+            _ => CachedResult::Matches(matches.into()),
+        }
+    }
+
+    /// Pattern matches held by the handle (empty for IP and `NotFound`)
+    pub(crate) fn matches(&self) -> &[MatchRef] {
+        match self {
+            CachedResult::Match(only) => std::slice::from_ref(only),
+            CachedResult::Matches(matches) => matches,
+            CachedResult::NotFound | CachedResult::Ip { .. } => &[],
+        }
+    }
+}
+
+/// Cache key for one query
+#[derive(Debug, Clone, Copy)]
+pub(crate) enum CacheKey<'a> {
+    /// Binary IP address
+    Ip(IpAddr),
+    /// String query with its fingerprint (see [`QueryCache::text_key`])
+    Text {
+        /// The query text, checked on hits and kept for cache warming
+        query: &'a str,
+        /// Keyed 64-bit hash of `query`
+        fingerprint: u64,
+    },
+}
+
+/// A cached query, as replayed by cache warming
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub(crate) enum RecentKey {
+    /// IP query
+    Ip(IpAddr),
+    /// String query
+    Text(String),
+}
+
+/// String cache entry
+struct TextEntry {
+    result: CachedResult,
+    /// Index of the query text in `TextShard::keys`
+    key_slot: u32,
+}
+
+/// String queries of one shard
+///
+/// Query texts live in a side table, read by hits only to confirm that the
+/// fingerprint belongs to the query. An evicted entry's slot (and its
+/// buffer) goes to the entry replacing it, so a full cache stores new texts
+/// without allocating.
+struct TextShard {
+    lru: PolicyCache<u64, TextEntry>,
+    keys: Vec<String>,
+}
+
+/// One independently locked shard, padded to its own cache line
+#[repr(align(64))]
+struct CacheShard<T> {
+    lru: Mutex<T>,
+}
+
+/// Lock-free table of queries known to miss
+///
+/// Each slot holds the fingerprint of one `NotFound` query (0 marks an
+/// empty slot); a new miss simply overwrites whatever shares its slot.
+/// Losing an entry that way only costs a repeat lookup, so slots need no
+/// lock and no ordering beyond their own atomicity.
+///
+/// Only the fingerprint is kept, so a query whose fingerprint equals a
+/// stored miss's is reported as `NotFound` even if it matches. Fingerprints
+/// are keyed per handle, which keeps the odds near `slots / 2^64` per
+/// lookup and stops collisions from being crafted, but the risk is why the
+/// table is opt-in.
+struct NegativeCache {
+    slots: Box<[AtomicU64]>,
+    /// Slot count minus one (slot count is always a power of two)
+    mask: usize,
+}
+
+impl NegativeCache {
+    /// Table with room for at least `capacity` misses (none when 0)
+    fn new(capacity: usize) -> Self {
+        let len = if capacity == 0 {
+            0
+        } else {
+            capacity.next_power_of_two()
+        };
+        Self {
+            slots: (0..len).map(|_| AtomicU64::new(0)).collect(),
+            mask: len.saturating_sub(1),
+        }
+    }
+
+    #[inline]
+    fn is_enabled(&self) -> bool {
+        !self.slots.is_empty()
+    }
+
+    /// Fingerprint as stored, never the empty marker
+    #[inline]
+    fn tag(fingerprint: u64) -> u64 {
+        fingerprint.max(1)
+    }
+
+    #[inline]
+    fn contains(&self, fingerprint: u64) -> bool {
+        let tag = Self::tag(fingerprint);
+        self.slots[tag as usize & self.mask].load(Ordering::Relaxed) == tag
+    }
+
+    #[inline]
+    fn insert(&self, fingerprint: u64) {
+        let tag = Self::tag(fingerprint);
+        self.slots[tag as usize & self.mask].store(tag, Ordering::Relaxed);
+    }
+
+    fn clear(&self) {
+        for slot in self.slots.iter() {
+            slot.store(0, Ordering::Relaxed);
+        }
+    }
+
+    fn len(&self) -> usize {
+        self.slots
+            .iter()
+            .filter(|slot| slot.load(Ordering::Relaxed) != 0)
+            .count()
+    }
+}
+
+/// Thread-safe caches for string and IP queries, split into shards
+///
+/// The capacity is split evenly between string and IP queries, so a burst
+/// of one kind cannot evict the other. A capacity of zero produces a
+/// disabled cache: every `get` misses and `put` is a no-op, without taking
+/// any lock.
+///
+/// With a negative capacity, `NotFound` results go to a separate
+/// [`NegativeCache`] instead of the LRU caches. It works whether or not the
+/// LRU caches are enabled.
+pub(crate) struct QueryCache {
+    text_shards: Box<[CacheShard<TextShard>]>,
+    ip_shards: Box<[CacheShard<PolicyCache<IpAddr, CachedResult>>]>,
+    /// Fingerprints of recent misses (empty when disabled)
+    negative: NegativeCache,
+    /// Shard count minus one (shard count is always a power of two)
+    mask: usize,
+    /// Per-cache random key for query fingerprints, so that colliding
+    /// queries cannot be crafted ahead of time
+    fingerprints: RandomState,
+    hasher: FxBuildHasher,
+}
+
+impl QueryCache {
+    /// Create a cache holding about `capacity` entries in total under
+    /// `policy`, sized for `concurrency` threads querying at once, plus
+    /// about `negative_capacity` misses
+    pub(crate) fn new(
+        capacity: usize,
+        policy: CachePolicy,
+        concurrency: usize,
+        negative_capacity: usize,
+    ) -> Self {
+        let negative = NegativeCache::new(negative_capacity);
+        if capacity == 0 {
+            return Self {
+                text_shards: Box::new([]),
+                ip_shards: Box::new([]),
+                negative,
+                mask: 0,
+                fingerprints: RandomState::new(),
+                hasher: FxBuildHasher::default(),
+            };
+        }
+
+        // Half the budget each for string and IP queries
+        let per_kind = capacity.div_ceil(2);
+        let shard_count = shard_count_for(concurrency, per_kind);
+        let per_shard = NonZeroUsize::new(per_kind.div_ceil(shard_count)).unwrap();
+        let text_shards = (0..shard_count)
+            .map(|_| CacheShard {
+                lru: Mutex::new(TextShard {
+                    lru: PolicyCache::new(policy, per_shard),
+                    keys: Vec::new(),
+                }),
+            })
+            .collect();
+        let ip_shards = (0..shard_count)
+            .map(|_| CacheShard {
+                lru: Mutex::new(PolicyCache::new(policy, per_shard)),
+            })
+            .collect();
+
+        Self {
+            text_shards,
+            ip_shards,
+            negative,
+            mask: shard_count - 1,
+            fingerprints: RandomState::new(),
+            hasher: FxBuildHasher::default(),
+        }
+    }
+
+    /// Whether caching is enabled (either capacity > 0)
+    #[inline]
+    pub(crate) fn is_enabled(&self) -> bool {
+        self.has_lru() || self.negative.is_enabled()
+    }
+
+    /// Whether the LRU caches are enabled
+    #[inline]
+    fn has_lru(&self) -> bool {
+        !self.text_shards.is_empty()
+    }
+
+    /// Key for a string query
+    ///
+    /// Hashes the query once; pass the key to both `get` and `put`.
+    #[inline]
+    pub(crate) fn text_key<'a>(&self, query: &'a str) -> CacheKey<'a> {
+        let fingerprint = if self.is_enabled() {
+            self.fingerprints.hash_one(query)
+        } else {
+            0
+        };
+        CacheKey::Text { query, fingerprint }
+    }
+
+    /// Look up a cached result, refreshing its recency
+    ///
+    /// A string entry only answers for the query it was stored with; a
+    /// different query with the same fingerprint misses.
+    #[inline]
+    pub(crate) fn get(&self, key: CacheKey<'_>) -> Option<CachedResult> {
+        if self.negative.is_enabled() && self.negative.contains(self.fingerprint(key)) {
+            return Some(CachedResult::NotFound);
+        }
+        if !self.has_lru() {
+            return None;
+        }
+        match key {
+            CacheKey::Ip(addr) => self.ip_shard(addr).get(&addr).cloned(),
+            CacheKey::Text { query, fingerprint } => {
+                let mut shard = self.text_shard(fingerprint);
+                let TextShard { lru, keys } = &mut *shard;
+                lru.get(&fingerprint)
+                    .filter(|entry| keys[entry.key_slot as usize] == query)
+                    .map(|entry| entry.result.clone())
+            }
+        }
+    }
+
+    /// Insert a result, evicting one of the shard's entries if full
+    ///
+    /// Misses go to the negative cache instead, when it is enabled.
+    #[inline]
+    pub(crate) fn put(&self, key: CacheKey<'_>, result: CachedResult) {
+        if self.negative.is_enabled() && result == CachedResult::NotFound {
+            self.negative.insert(self.fingerprint(key));
+            return;
+        }
+        if !self.has_lru() {
+            return;
+        }
+        match key {
+            CacheKey::Ip(addr) => {
+                self.ip_shard(addr).push(addr, result);
+            }
+            CacheKey::Text { query, fingerprint } => {
+                let mut shard = self.text_shard(fingerprint);
+                let entry = TextEntry {
+                    result,
+                    key_slot: shard.keys.len() as u32,
+                };
+                // A replaced or evicted entry hands its key slot over
+                match shard.lru.push(fingerprint, entry) {
+                    Some((_, old)) => {
+                        let slot = old.key_slot;
+                        if let Some(entry) = shard.lru.peek_mut(&fingerprint) {
+                            entry.key_slot = slot;
+                        }
+                        let text = &mut shard.keys[slot as usize];
+                        text.clear();
+                        text.push_str(query);
+                    }
+                    None => shard.keys.push(query.to_string()),
+                }
+            }
+        }
+    }
+
+    /// Remove all cached entries
+    pub(crate) fn clear(&self) {
+        self.negative.clear();
+        for shard in self.text_shards.iter() {
+            let mut shard = lock(&shard.lru);
+            shard.lru.clear();
+            shard.keys.clear();
+        }
+        for shard in self.ip_shards.iter() {
+            lock(&shard.lru).clear();
+        }
+    }
+
+    /// Number of cached entries across all shards
+    pub(crate) fn len(&self) -> usize {
+        let text: usize = self
+            .text_shards
+            .iter()
+            .map(|s| lock(&s.lru).lru.len())
+            .sum();
+        let ip: usize = self.ip_shards.iter().map(|s| lock(&s.lru).len()).sum();
+        text + ip + self.negative.len()
+    }
+
+    /// Total entries the cache can hold, all kinds together (0 when disabled)
+    pub(crate) fn capacity(&self) -> usize {
+        let text: usize = self
+            .text_shards
+            .iter()
+            .map(|s| lock(&s.lru).lru.cap())
+            .sum();
+        let ip: usize = self.ip_shards.iter().map(|s| lock(&s.lru).cap()).sum();
+        text + ip + self.negative.slots.len()
+    }
+
+    /// Replacement counters summed over all shards
+    pub(crate) fn counters(&self) -> CacheCounters {
+        let mut counters = CacheCounters::default();
+        for shard in self.text_shards.iter() {
+            counters.add(&lock(&shard.lru).lru.counters());
+        }
+        for shard in self.ip_shards.iter() {
+            counters.add(&lock(&shard.lru).counters());
+        }
+        counters
+    }
+
+    /// Up to `limit` cached queries, most valuable first within each shard
+    ///
+    /// Shards contribute equally, so the result approximates the hottest
+    /// keys overall without merging recency across locks. String and IP
+    /// queries are interleaved. The negative cache keeps no query texts and
+    /// contributes nothing.
+    pub(crate) fn recent_keys(&self, limit: usize) -> Vec<RecentKey> {
+        if !self.has_lru() || limit == 0 {
+            return Vec::new();
+        }
+        let per_shard = limit.div_ceil(self.text_shards.len());
+
+        let mut texts = Vec::new();
+        for shard in self.text_shards.iter() {
+            let shard = lock(&shard.lru);
+            texts.extend(
+                shard
+                    .lru
+                    .iter()
+                    .take(per_shard)
+                    .map(|(_, entry)| RecentKey::Text(shard.keys[entry.key_slot as usize].clone())),
+            );
+        }
+        let mut ips = Vec::new();
+        for shard in self.ip_shards.iter() {
+            let lru = lock(&shard.lru);
+            ips.extend(
+                lru.iter()
+                    .take(per_shard)
+                    .map(|(addr, _)| RecentKey::Ip(*addr)),
+            );
+        }
+
+        let mut keys = Vec::with_capacity(texts.len() + ips.len());
+        let mut texts = texts.into_iter();
+        let mut ips = ips.into_iter();
+        loop {
+            match (texts.next(), ips.next()) {
+                (None, None) => break,
+                (text, ip) => keys.extend(text.into_iter().chain(ip)),
+            }
+        }
+        keys.truncate(limit);
+        keys
+    }
+
+    /// Keyed 64-bit hash of a query, as the negative cache stores it
+    #[inline]
+    fn fingerprint(&self, key: CacheKey<'_>) -> u64 {
+        match key {
+            CacheKey::Ip(addr) => self.fingerprints.hash_one(addr),
+            CacheKey::Text { fingerprint, .. } => fingerprint,
+        }
+    }
+
+    /// Lock the string shard that owns `fingerprint`
+    #[inline]
+    fn text_shard(&self, fingerprint: u64) -> MutexGuard<'_, TextShard> {
+        let index = ((fingerprint >> 32) as usize) & self.mask;
+        lock(&self.text_shards[index].lru)
+    }
+
+    /// Lock the IP shard that owns `addr`
+    #[inline]
+    fn ip_shard(&self, addr: IpAddr) -> MutexGuard<'_, PolicyCache<IpAddr, CachedResult>> {
+        // FxHash mixes upward, so take the shard index from the high bits
+        let hash = self.hasher.hash_one(addr);
+        let index = ((hash >> 32) as usize) & self.mask;
+        lock(&self.ip_shards[index].lru)
+    }
+}
+
+/// Pick a power-of-two shard count for the expected concurrency
+///
+/// Uses roughly two shards per thread to keep collisions rare, but never
+/// splits the capacity so finely that individual shards stop being useful.
+fn shard_count_for(concurrency: usize, capacity: usize) -> usize {
+    if concurrency <= 1 {
+        return 1;
+    }
+    let mut shards = (concurrency * 2).next_power_of_two().min(MAX_SHARDS);
+    while shards > 1 && capacity / shards < MIN_SHARD_CAPACITY {
+        shards /= 2;
+    }
+    shards
+}
+
+/// Lock a mutex, ignoring poisoning
+///
+/// Cached values are only ever replaced whole, so a panic while holding
+/// the lock cannot leave a shard in a state worth refusing to read.
+#[inline]
+pub(crate) fn lock<T>(mutex: &Mutex<T>) -> MutexGuard<'_, T> {
+    mutex.lock().unwrap_or_else(PoisonError::into_inner)
+}
+
+/// Small, stable per-thread index for picking striped state
+///
+/// Threads are numbered in the order they first ask; callers reduce the
+/// number with a mask to select a stripe. Two threads may share a stripe,
+/// so stripes must still be synchronized - this only spreads contention.
+#[inline]
+pub(crate) fn thread_slot() -> usize {
+    static NEXT_SLOT: AtomicUsize = AtomicUsize::new(0);
+    thread_local! {
+        static SLOT: usize = NEXT_SLOT.fetch_add(1, Ordering::Relaxed);
+    }
+    SLOT.with(|slot| *slot)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn not_found() -> CachedResult {
+        CachedResult::NotFound
+    }
+
+    fn put_text(cache: &QueryCache, query: &str, result: CachedResult) {
+        cache.put(cache.text_key(query), result);
+    }
+
+    fn get_text(cache: &QueryCache, query: &str) -> Option<CachedResult> {
+        cache.get(cache.text_key(query))
+    }
+
+    #[test]
+    fn test_disabled_cache() {
+        let cache = QueryCache::new(0, CachePolicy::Lru, 8, 0);
+        assert!(!cache.is_enabled());
+        put_text(&cache, "a", not_found());
+        assert!(get_text(&cache, "a").is_none());
+        assert_eq!(cache.len(), 0);
+    }
+
+    #[test]
+    fn test_get_put_clear() {
+        let cache = QueryCache::new(1000, CachePolicy::Lru, 8, 0);
+        for i in 0..100 {
+            put_text(&cache, &format!("key{}", i), not_found());
+        }
+        assert_eq!(cache.len(), 100);
+        assert!(matches!(
+            get_text(&cache, "key42"),
+            Some(CachedResult::NotFound)
+        ));
+        cache.clear();
+        assert_eq!(cache.len(), 0);
+        assert!(get_text(&cache, "key42").is_none());
+    }
+
+    #[test]
+    fn test_capacity_bounded() {
+        let cache = QueryCache::new(64, CachePolicy::Lru, 4, 0);
+        for i in 0..1000 {
+            put_text(&cache, &format!("key{}", i), not_found());
+        }
+        // Per-shard rounding may add at most one entry per shard
+        assert!(cache.len() <= 64 + cache.text_shards.len());
+        // Evicted entries' key slots are reused rather than grown
+        let slots: usize = cache
+            .text_shards
+            .iter()
+            .map(|s| lock(&s.lru).keys.len())
+            .sum();
+        assert_eq!(slots, cache.len());
+    }
+
+    #[test]
+    fn test_recent_keys() {
+        let cache = QueryCache::new(100, CachePolicy::Lru, 1, 0);
+        for i in 0..10 {
+            put_text(&cache, &format!("key{}", i), not_found());
+        }
+        get_text(&cache, "key3");
+        assert_eq!(cache.capacity(), 100);
+        assert_eq!(
+            cache.recent_keys(2),
+            vec![
+                RecentKey::Text("key3".to_string()),
+                RecentKey::Text("key9".to_string())
+            ]
+        );
+        assert_eq!(cache.recent_keys(1000).len(), 10);
+        assert!(QueryCache::new(0, CachePolicy::Lru, 1, 0)
+            .recent_keys(10)
+            .is_empty());
+    }
+
+    #[test]
+    fn test_fingerprint_collision_misses() {
+        let cache = QueryCache::new(16, CachePolicy::Lru, 1, 0);
+        put_text(&cache, "evil.com", not_found());
+
+        // Force another query onto the same fingerprint
+        let fingerprint = cache.fingerprint(cache.text_key("evil.com"));
+        let other = CacheKey::Text {
+            query: "benign.com",
+            fingerprint,
+        };
+        assert!(cache.get(other).is_none());
+        assert_eq!(get_text(&cache, "evil.com"), Some(not_found()));
+
+        // Storing under the collision replaces the entry and its text
+        cache.put(other, not_found());
+        assert_eq!(cache.get(other), Some(not_found()));
+        assert!(get_text(&cache, "evil.com").is_none());
+    }
+
+    #[test]
+    fn test_ip_keys_are_separate() {
+        let cache = QueryCache::new(100, CachePolicy::Lru, 2, 0);
+        let addr: IpAddr = "10.0.0.1".parse().unwrap();
+        let ip = CachedResult::Ip {
+            layer: 0,
+            offset: 7,
+            prefix_len: 24,
+        };
+        cache.put(CacheKey::Ip(addr), ip.clone());
+        assert_eq!(cache.get(CacheKey::Ip(addr)), Some(ip));
+        assert!(get_text(&cache, "10.0.0.1").is_none());
+        assert_eq!(cache.recent_keys(10), vec![RecentKey::Ip(addr)]);
+    }
+
+    #[test]
+    fn test_replacing_keeps_key_text() {
+        let cache = QueryCache::new(16, CachePolicy::Lru, 1, 0);
+        put_text(&cache, "evil.com", not_found());
+        let one = MatchRef {
+            pattern_id: 3,
+            layer: 0,
+            data: MatchData::Offset(40),
+        };
+        put_text(&cache, "evil.com", CachedResult::from_matches(vec![one]));
+        assert_eq!(get_text(&cache, "evil.com"), Some(CachedResult::Match(one)));
+        assert_eq!(
+            cache.recent_keys(10),
+            vec![RecentKey::Text("evil.com".to_string())]
+        );
+
+        let many = CachedResult::from_matches(vec![one, one]);
+        assert_eq!(many.matches().len(), 2);
+        assert_eq!(CachedResult::from_matches(Vec::new()), not_found());
+    }
+
+    #[test]
+    fn test_negative_cache() {
+        let cache = QueryCache::new(16, CachePolicy::Lru, 1, 100);
+        assert_eq!(cache.capacity(), 16 + 128);
+        let one = CachedResult::Match(MatchRef {
+            pattern_id: 1,
+            layer: 0,
+            data: MatchData::None,
+        });
+        put_text(&cache, "evil.com", one.clone());
+        put_text(&cache, "benign.com", not_found());
+        let addr: IpAddr = "10.0.0.1".parse().unwrap();
+        cache.put(CacheKey::Ip(addr), not_found());
+
+        // Misses skip the LRU caches, so they never evict hits
+        assert_eq!(lock(&cache.text_shards[0].lru).lru.len(), 1);
+        assert_eq!(get_text(&cache, "benign.com"), Some(not_found()));
+        assert_eq!(cache.get(CacheKey::Ip(addr)), Some(not_found()));
+        assert_eq!(get_text(&cache, "evil.com"), Some(one.clone()));
+        assert!(get_text(&cache, "other.com").is_none());
+        assert_eq!(cache.len(), 3);
+        assert_eq!(
+            cache.recent_keys(10),
+            vec![RecentKey::Text("evil.com".to_string())]
+        );
+
+        cache.clear();
+        assert!(get_text(&cache, "benign.com").is_none());
+
+        // Works without the LRU caches too
+        let cache = QueryCache::new(0, CachePolicy::Lru, 1, 8);
+        assert!(cache.is_enabled());
+        put_text(&cache, "benign.com", not_found());
+        put_text(&cache, "evil.com", one);
+        assert_eq!(get_text(&cache, "benign.com"), Some(not_found()));
+        assert!(get_text(&cache, "evil.com").is_none());
+    }
+
+    #[test]
+    fn test_policy_counters() {
+        for policy in [
+            CachePolicy::Lru,
+            CachePolicy::S3Fifo,
+            CachePolicy::TinyLfu,
+            CachePolicy::Clock,
+        ] {
+            let cache = QueryCache::new(16, policy, 1, 0);
+            for i in 0..100 {
+                let key = format!("key{}", i);
+                if get_text(&cache, &key).is_none() {
+                    put_text(&cache, &key, not_found());
+                }
+            }
+            assert!(cache.len() <= cache.capacity() / 2 + 1, "{:?}", policy);
+            assert_eq!(
+                cache.counters().evictions as usize,
+                100 - cache.len(),
+                "{:?}",
+                policy
+            );
+            // Evicted entries' key slots are reused under every policy
+            let slots = lock(&cache.text_shards[0].lru).keys.len();
+            assert_eq!(slots, cache.len(), "{:?}", policy);
+        }
+    }
+
+    #[test]
+    fn test_shard_count() {
+        assert_eq!(shard_count_for(1, 10_000), 1);
+        assert_eq!(shard_count_for(8, 10_000), 16);
+        assert_eq!(shard_count_for(1000, 10_000_000), MAX_SHARDS);
+        // Small caches are not split below MIN_SHARD_CAPACITY per shard
+        assert_eq!(shard_count_for(32, 40), 2);
+    }
+}
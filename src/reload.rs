@@ -0,0 +1,311 @@
+//! Hot-Reloadable Database Handles
+//!
+//! Feeds are rebuilt every few minutes, and closing a handle to open the
+//! new file drops every query that arrives in between. A
+//! [`ReloadableDatabase`] keeps the current [`Database`] behind an `Arc`:
+//! a reload opens (and optionally warms) the new file off to the side while
+//! queries keep running, then swaps the pointer. Queries that started before
+//! the swap finish on the old mapping, which is unmapped when its last user
+//! lets go.
+//!
+//! Replace the file by writing a new one and renaming it over the old path
+//! (as `matchy build` and `matchy compact` do). Rewriting a mapped file in
+//! place changes the bytes under queries that are still running.
+
+use crate::database::{Database, DatabaseError, DatabaseOptions};
+use arc_swap::ArcSwap;
+use std::ops::Deref;
+use std::path::PathBuf;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex, PoisonError};
+
+/// Database handle whose file can be replaced under live query load
+///
+/// Shared by any number of threads like a plain [`Database`]. Each query
+/// goes through [`current`](Self::current), an RCU-style atomic load that
+/// takes no lock and writes no shared cache line, so concurrent queries
+/// don't contend on the handle; [`reload`](Self::reload) publishes the new
+/// database with one atomic pointer swap.
+///
+/// By default the new handle's cache is warmed before the swap by
+/// replaying the old handle's most recently used queries (see
+/// [`Database::warm_cache_from`]), so hit rates don't collapse on every
+/// reload. Query statistics carry over as well.
+///
+/// # Examples
+///
+/// ```no_run
+/// use matchy::Database;
+///
+/// let db = Database::from("threats.mxy")
+///     .concurrency(16)
+///     .open_reloadable()?;
+///
+/// // Query threads
+/// let hit = db.current().lookup("1.2.3.4")?;
+///
+/// // Feed updater, after renaming a new threats.mxy into place
+/// let generation = db.reload()?;
+/// println!("now serving generation {}", generation);
+/// # Ok::<(), Box<dyn std::error::Error>>(())
+/// ```
+pub struct ReloadableDatabase {
+    /// The database new queries see
+    current: ArcSwap<Database>,
+    /// Options used to reopen the file; the lock also serializes reloads
+    options: Mutex<DatabaseOptions>,
+    /// Number of completed swaps
+    generation: AtomicU64,
+    /// Replay the old handle's hot queries into the new cache
+    cache_warmup: bool,
+}
+
+impl ReloadableDatabase {
+    /// Open a reloadable handle (usually via [`DatabaseOpener::open_reloadable`](crate::DatabaseOpener::open_reloadable))
+    ///
+    /// Later reloads reopen `options.path` with the same options. In-memory
+    /// bytes, if set, are used for the first open only.
+    pub fn open(mut options: DatabaseOptions) -> Result<Self, DatabaseError> {
+        let bytes = options.bytes.take();
+        let db = Database::open_with_options(DatabaseOptions {
+            bytes,
+            ..options.clone()
+        })?;
+        Ok(Self {
+            current: ArcSwap::from_pointee(db),
+            options: Mutex::new(options),
+            generation: AtomicU64::new(0),
+            cache_warmup: true,
+        })
+    }
+
+    /// Wrap an already open database
+    ///
+    /// It has no path to reopen, so replacements must come through
+    /// [`reload_from`](Self::reload_from) or [`replace`](Self::replace).
+    pub fn from_database(db: Database) -> Self {
+        Self {
+            current: ArcSwap::from_pointee(db),
+            options: Mutex::new(DatabaseOptions::default()),
+            generation: AtomicU64::new(0),
+            cache_warmup: true,
+        }
+    }
+
+    /// Enable or disable cache warmup on reload
+    ///
+    /// Default: enabled
+    pub fn cache_warmup(mut self, enabled: bool) -> Self {
+        self.cache_warmup = enabled;
+        self
+    }
+
+    /// The database new queries should use
+    ///
+    /// The guard dereferences to the [`Database`] and keeps that version
+    /// alive while held; reloads never wait for it. Hold it for a query or
+    /// batch: each thread has a few cheap guard slots, and guards beyond
+    /// those (or held for long) fall back to a reference count bump. Use
+    /// [`snapshot`](Self::snapshot) to keep a version for longer.
+    #[inline]
+    pub fn current(&self) -> impl Deref<Target = Arc<Database>> {
+        self.current.load()
+    }
+
+    /// A reference to the current database that outlives later reloads
+    pub fn snapshot(&self) -> Arc<Database> {
+        self.current.load_full()
+    }
+
+    /// Number of reloads completed since the handle was opened
+    pub fn generation(&self) -> u64 {
+        self.generation.load(Ordering::Acquire)
+    }
+
+    /// Reopen the file at the handle's path and swap it in
+    ///
+    /// Returns the new generation. On error the current database stays in
+    /// place and keeps serving.
+    pub fn reload(&self) -> Result<u64, DatabaseError> {
+        let options = self.options.lock().unwrap_or_else(PoisonError::into_inner);
+        let db = Database::open_with_options(options.clone())?;
+        Ok(self.install(db))
+    }
+
+    /// Open the file at `path` and swap it in
+    ///
+    /// Uses the handle's other options; later [`reload`](Self::reload)s
+    /// reopen `path`.
+    pub fn reload_from(&self, path: impl Into<PathBuf>) -> Result<u64, DatabaseError> {
+        let mut options = self.options.lock().unwrap_or_else(PoisonError::into_inner);
+        let path = path.into();
+        let db = Database::open_with_options(DatabaseOptions {
+            path: path.clone(),
+            ..options.clone()
+        })?;
+        options.path = path;
+        Ok(self.install(db))
+    }
+
+    /// Swap in an already open database
+    ///
+    /// Warmed like a reload. Returns the new generation.
+    pub fn replace(&self, db: Database) -> u64 {
+        let _serialized = self.options.lock().unwrap_or_else(PoisonError::into_inner);
+        self.install(db)
+    }
+
+    /// Warm `db` from the current database, then make it current
+    ///
+    /// Callers hold the options lock, so installs never interleave.
+    fn install(&self, db: Database) -> u64 {
+        let previous = self.snapshot();
+        if self.cache_warmup {
+            db.warm_cache_from(&previous, usize::MAX);
+        }
+        db.absorb_stats(&previous);
+
+        let replaced = self.current.swap(Arc::new(db));
+        // Unmapped here unless in-flight queries or snapshots still hold it
+        drop(replaced);
+        drop(previous);
+
+        self.generation.fetch_add(1, Ordering::AcqRel) + 1
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::data_section::DataValue;
+    use crate::database::QueryResult;
+    use crate::glob::MatchMode;
+    use crate::mmdb_builder::MmdbBuilder;
+    use std::collections::HashMap;
+    use std::path::Path;
+
+    fn write_db(path: &Path, tag: &str) {
+        let mut data = HashMap::new();
+        data.insert("tag".to_string(), DataValue::String(tag.to_string()));
+        let mut builder = MmdbBuilder::new(MatchMode::CaseSensitive);
+        builder.add_entry("10.0.0.0/8", data.clone()).unwrap();
+        builder.add_entry("evil.com", data).unwrap();
+
+        // Replace by rename, never in place
+        let staging = path.with_extension("tmp");
+        std::fs::write(&staging, builder.build().unwrap()).unwrap();
+        std::fs::rename(&staging, path).unwrap();
+    }
+
+    fn tag(db: &Database, query: &str) -> Option<String> {
+        let data = match db.lookup(query).unwrap()? {
+            QueryResult::Ip { data, .. } => data,
+            QueryResult::Pattern { mut data, .. } => data.remove(0)?,
+            QueryResult::NotFound => return None,
+        };
+        match data {
+            DataValue::Map(mut map) => match map.remove("tag") {
+                Some(DataValue::String(tag)) => Some(tag),
+                _ => None,
+            },
+            _ => None,
+        }
+    }
+
+    #[test]
+    fn test_reload_swaps_and_keeps_snapshots() {
+        let dir = tempfile::tempdir().unwrap();
+        let path = dir.path().join("feed.mxy");
+        write_db(&path, "v1");
+
+        let db = Database::from(path.clone()).open_reloadable().unwrap();
+        assert_eq!(tag(&db.current(), "10.1.2.3").as_deref(), Some("v1"));
+        let old = db.snapshot();
+
+        write_db(&path, "v2");
+        assert_eq!(db.reload().unwrap(), 1);
+        assert_eq!(db.generation(), 1);
+        assert_eq!(tag(&db.current(), "10.1.2.3").as_deref(), Some("v2"));
+        assert_eq!(tag(&db.current(), "evil.com").as_deref(), Some("v2"));
+
+        // A query still holding the old version keeps its answers
+        assert_eq!(tag(&old, "evil.com").as_deref(), Some("v1"));
+
+        // Stats carry over across the swap
+        assert!(db.current().stats().total_queries >= 3);
+    }
+
+    #[test]
+    fn test_failed_reload_keeps_serving() {
+        let dir = tempfile::tempdir().unwrap();
+        let path = dir.path().join("feed.mxy");
+        write_db(&path, "v1");
+        let db = Database::from(path.clone()).open_reloadable().unwrap();
+
+        std::fs::remove_file(&path).unwrap();
+        std::fs::write(&path, b"not a database").unwrap();
+        assert!(db.reload().is_err());
+        assert_eq!(db.generation(), 0);
+        assert_eq!(tag(&db.current(), "10.1.2.3").as_deref(), Some("v1"));
+
+        let other = dir.path().join("other.mxy");
+        write_db(&other, "v3");
+        assert_eq!(db.reload_from(&other).unwrap(), 1);
+        assert_eq!(tag(&db.current(), "10.1.2.3").as_deref(), Some("v3"));
+    }
+
+    #[test]
+    fn test_reload_warms_cache() {
+        let dir = tempfile::tempdir().unwrap();
+        let path = dir.path().join("feed.mxy");
+        write_db(&path, "v1");
+        let db = Database::from(path.clone()).open_reloadable().unwrap();
+        for query in ["10.0.0.1", "10.0.0.2", "evil.com"] {
+            db.current().lookup(query).unwrap();
+        }
+
+        write_db(&path, "v2");
+        db.reload().unwrap();
+        let current = db.snapshot();
+        assert_eq!(current.cache_size(), 3);
+        // Warmed entries hold the new file's data
+        let before = current.stats().cache_hits;
+        assert_eq!(tag(&current, "evil.com").as_deref(), Some("v2"));
+        assert_eq!(current.stats().cache_hits, before + 1);
+    }
+
+    #[test]
+    fn test_queries_during_reload() {
+        let dir = tempfile::tempdir().unwrap();
+        let path = dir.path().join("feed.mxy");
+        write_db(&path, "v1");
+        let db = Arc::new(
+            Database::from(path.clone())
+                .concurrency(4)
+                .open_reloadable()
+                .unwrap(),
+        );
+
+        let readers: Vec<_> = (0..4)
+            .map(|_| {
+                let db = Arc::clone(&db);
+                std::thread::spawn(move || {
+                    for _ in 0..2000 {
+                        // Every query sees a complete version, never a gap
+                        let found = tag(&db.current(), "10.9.9.9");
+                        assert!(matches!(found.as_deref(), Some("v1") | Some("v2")));
+                    }
+                })
+            })
+            .collect();
+
+        for _ in 0..5 {
+            write_db(&path, "v2");
+            db.reload().unwrap();
+        }
+        for reader in readers {
+            reader.join().unwrap();
+        }
+        assert_eq!(db.generation(), 5);
+    }
+}
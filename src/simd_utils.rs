@@ -201,6 +201,293 @@ pub fn ascii_lowercase(text: &[u8], output: &mut Vec<u8>) {
     }
 }
 
+/// Hint the CPU to start loading the cache line at `ptr`
+///
+/// Used by batched lookups to overlap memory latency across independent
+/// traversals: issue the prefetch for one lookup's next node, then work on
+/// the others while it arrives. Never faults, even for invalid addresses.
+#[inline(always)]
+pub fn prefetch_read(ptr: *const u8) {
+    #[cfg(target_arch = "x86_64")]
+    unsafe {
+        _mm_prefetch(ptr as *const i8, _MM_HINT_T0);
+    }
+
+    #[cfg(target_arch = "aarch64")]
+    unsafe {
+        std::arch::asm!("prfm pldl1keep, [{0}]", in(reg) ptr, options(nostack, readonly, preserves_flags));
+    }
+
+    #[cfg(not(any(target_arch = "x86_64", target_arch = "aarch64")))]
+    {
+        let _ = ptr;
+    }
+}
+
+// ===== ANCHOR CLASSIFICATION =====
+//
+// The extractor needs the positions of a handful of anchor bytes ('.', ':',
+// '@', 'x') plus the word-boundary set. Each byte's class is looked up from
+// its two nibbles: class = LO[b & 0xF] & HI[b >> 4]. With SSSE3 `pshufb` or
+// NEON `tbl` that is two table lookups per 16 bytes, and every anchor kind
+// falls out of the same pass as a bitmask.
+
+/// `[` `]` `{` `}`
+const CLASS_BRACKET: u8 = 1 << 0;
+/// `\t` `\n` `\r`
+const CLASS_CONTROL: u8 = 1 << 1;
+/// space `"` `'` `(` `)` `,` `/`
+const CLASS_PUNCT: u8 = 1 << 2;
+/// `:` `;` `<` `=` `>`
+const CLASS_OPERATOR: u8 = 1 << 3;
+/// `@`
+const CLASS_AT: u8 = 1 << 4;
+/// `:`
+const CLASS_COLON: u8 = 1 << 5;
+/// `.`
+const CLASS_DOT: u8 = 1 << 6;
+/// `x`
+const CLASS_X: u8 = 1 << 7;
+
+/// Classes that make up the extractor's word-boundary set
+const CLASS_BOUNDARY: u8 = CLASS_BRACKET | CLASS_CONTROL | CLASS_PUNCT | CLASS_OPERATOR | CLASS_AT;
+
+/// (class, high nibbles, low nibbles) — a byte has the class when both of
+/// its nibbles are listed. Each class must be a full cross product.
+const CLASS_NIBBLES: [(u8, &[u8], &[u8]); 8] = [
+    (CLASS_BRACKET, &[0x5, 0x7], &[0xB, 0xD]),
+    (CLASS_CONTROL, &[0x0], &[0x9, 0xA, 0xD]),
+    (CLASS_PUNCT, &[0x2], &[0x0, 0x2, 0x7, 0x8, 0x9, 0xC, 0xF]),
+    (CLASS_OPERATOR, &[0x3], &[0xA, 0xB, 0xC, 0xD, 0xE]),
+    (CLASS_AT, &[0x4], &[0x0]),
+    (CLASS_COLON, &[0x3], &[0xA]),
+    (CLASS_DOT, &[0x2], &[0xE]),
+    (CLASS_X, &[0x7], &[0x8]),
+];
+
+/// Per-nibble class tables: [low nibble table, high nibble table]
+const NIBBLE_TABLES: [[u8; 16]; 2] = {
+    let mut tables = [[0u8; 16]; 2];
+    let mut i = 0;
+    while i < CLASS_NIBBLES.len() {
+        let (class, highs, lows) = CLASS_NIBBLES[i];
+        let mut j = 0;
+        while j < lows.len() {
+            tables[0][lows[j] as usize] |= class;
+            j += 1;
+        }
+        j = 0;
+        while j < highs.len() {
+            tables[1][highs[j] as usize] |= class;
+            j += 1;
+        }
+        i += 1;
+    }
+    tables
+};
+
+/// Full 256-entry class table for the scalar path, derived from the nibble tables
+const CLASS_TABLE: [u8; 256] = {
+    let mut table = [0u8; 256];
+    let mut b = 0;
+    while b < 256 {
+        table[b] = NIBBLE_TABLES[0][b & 0xF] & NIBBLE_TABLES[1][b >> 4];
+        b += 1;
+    }
+    table
+};
+
+/// Anchor bitmaps for one block of up to 64 bytes (bit `i` = byte `i`)
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq)]
+pub struct AnchorMasks {
+    /// `.`
+    pub dot: u64,
+    /// `:`
+    pub colon: u64,
+    /// `@`
+    pub at: u64,
+    /// `x`
+    pub x: u64,
+    /// Word-boundary bytes (whitespace, brackets, quotes and `/,;:<=>@`)
+    pub boundary: u64,
+}
+
+impl AnchorMasks {
+    #[inline(always)]
+    fn truncate(self, len: usize) -> Self {
+        let keep = if len >= 64 {
+            u64::MAX
+        } else {
+            (1u64 << len) - 1
+        };
+        Self {
+            dot: self.dot & keep,
+            colon: self.colon & keep,
+            at: self.at & keep,
+            x: self.x & keep,
+            boundary: self.boundary & keep,
+        }
+    }
+}
+
+/// Whether `byte` is in the extractor's word-boundary set
+#[inline(always)]
+pub fn is_anchor_boundary(byte: u8) -> bool {
+    CLASS_TABLE[byte as usize] & CLASS_BOUNDARY != 0
+}
+
+/// Classify one block with the 256-entry table
+pub fn classify_anchors_scalar(block: &[u8]) -> AnchorMasks {
+    let mut masks = AnchorMasks::default();
+    for (i, &byte) in block.iter().take(64).enumerate() {
+        let class = CLASS_TABLE[byte as usize];
+        let bit = 1u64 << i;
+        if class & CLASS_DOT != 0 {
+            masks.dot |= bit;
+        }
+        if class & CLASS_COLON != 0 {
+            masks.colon |= bit;
+        }
+        if class & CLASS_AT != 0 {
+            masks.at |= bit;
+        }
+        if class & CLASS_X != 0 {
+            masks.x |= bit;
+        }
+        if class & CLASS_BOUNDARY != 0 {
+            masks.boundary |= bit;
+        }
+    }
+    masks
+}
+
+/// Classify 64 bytes with SSSE3 nibble lookups (x86_64)
+#[cfg(target_arch = "x86_64")]
+#[target_feature(enable = "ssse3")]
+unsafe fn classify_block_ssse3(block: &[u8; 64]) -> AnchorMasks {
+    let lo_table = _mm_loadu_si128(NIBBLE_TABLES[0].as_ptr() as *const __m128i);
+    let hi_table = _mm_loadu_si128(NIBBLE_TABLES[1].as_ptr() as *const __m128i);
+    let nibble = _mm_set1_epi8(0x0F);
+    let zero = _mm_setzero_si128();
+
+    let mut masks = AnchorMasks::default();
+    for lane in 0..4 {
+        let bytes = _mm_loadu_si128(block.as_ptr().add(lane * 16) as *const __m128i);
+        let lo = _mm_and_si128(bytes, nibble);
+        let hi = _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble);
+        let class = _mm_and_si128(
+            _mm_shuffle_epi8(lo_table, lo),
+            _mm_shuffle_epi8(hi_table, hi),
+        );
+
+        let shift = lane * 16;
+        let has = |bits: u8| {
+            let hit = _mm_cmpeq_epi8(_mm_and_si128(class, _mm_set1_epi8(bits as i8)), zero);
+            (!(_mm_movemask_epi8(hit) as u32) & 0xFFFF) as u64
+        };
+        masks.dot |= has(CLASS_DOT) << shift;
+        masks.colon |= has(CLASS_COLON) << shift;
+        masks.at |= has(CLASS_AT) << shift;
+        masks.x |= has(CLASS_X) << shift;
+        masks.boundary |= has(CLASS_BOUNDARY) << shift;
+    }
+    masks
+}
+
+/// Classify 64 bytes with NEON table lookups (aarch64)
+#[cfg(target_arch = "aarch64")]
+unsafe fn classify_block_neon(block: &[u8; 64]) -> AnchorMasks {
+    const WEIGHTS: [u8; 16] = [1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128];
+
+    let lo_table = vld1q_u8(NIBBLE_TABLES[0].as_ptr());
+    let hi_table = vld1q_u8(NIBBLE_TABLES[1].as_ptr());
+    let weights = vld1q_u8(WEIGHTS.as_ptr());
+    let nibble = vdupq_n_u8(0x0F);
+
+    let mut masks = AnchorMasks::default();
+    for lane in 0..4 {
+        let bytes = vld1q_u8(block.as_ptr().add(lane * 16));
+        let class = vandq_u8(
+            vqtbl1q_u8(lo_table, vandq_u8(bytes, nibble)),
+            vqtbl1q_u8(hi_table, vshrq_n_u8(bytes, 4)),
+        );
+
+        // NEON has no movemask: weight each hit lane by its bit and sum halves
+        let shift = lane * 16;
+        let has = |bits: u8| {
+            let hit = vandq_u8(vtstq_u8(class, vdupq_n_u8(bits)), weights);
+            (vaddv_u8(vget_low_u8(hit)) as u64) | ((vaddv_u8(vget_high_u8(hit)) as u64) << 8)
+        };
+        masks.dot |= has(CLASS_DOT) << shift;
+        masks.colon |= has(CLASS_COLON) << shift;
+        masks.at |= has(CLASS_AT) << shift;
+        masks.x |= has(CLASS_X) << shift;
+        masks.boundary |= has(CLASS_BOUNDARY) << shift;
+    }
+    masks
+}
+
+/// Classify `text` in 64-byte blocks, calling `f(block_start, masks)` for each
+///
+/// Picks the SIMD kernel once per call. The last block may be shorter than
+/// 64 bytes; its masks have no bits past the end of `text`.
+///
+/// # Example
+/// ```
+/// use matchy::simd_utils::scan_anchors;
+///
+/// let mut dots = Vec::new();
+/// scan_anchors(b"10.0.0.1 user@host", |start, masks| {
+///     let mut bits = masks.dot;
+///     while bits != 0 {
+///         dots.push(start + bits.trailing_zeros() as usize);
+///         bits &= bits - 1;
+///     }
+/// });
+/// assert_eq!(dots, vec![2, 4, 6]);
+/// ```
+pub fn scan_anchors(text: &[u8], mut f: impl FnMut(usize, AnchorMasks)) {
+    #[cfg(target_arch = "x86_64")]
+    let simd = is_x86_feature_detected!("ssse3");
+    #[cfg(target_arch = "aarch64")]
+    let simd = true;
+    #[cfg(not(any(target_arch = "x86_64", target_arch = "aarch64")))]
+    let simd = false;
+
+    let classify = |block: &[u8; 64]| -> AnchorMasks {
+        if !simd {
+            return classify_anchors_scalar(block);
+        }
+        #[cfg(target_arch = "x86_64")]
+        {
+            unsafe { classify_block_ssse3(block) }
+        }
+        #[cfg(target_arch = "aarch64")]
+        {
+            unsafe { classify_block_neon(block) }
+        }
+        #[cfg(not(any(target_arch = "x86_64", target_arch = "aarch64")))]
+        {
+            classify_anchors_scalar(block)
+        }
+    };
+
+    let mut blocks = text.chunks_exact(64);
+    let mut start = 0;
+    for block in &mut blocks {
+        f(start, classify(block.try_into().unwrap()));
+        start += 64;
+    }
+
+    let tail = blocks.remainder();
+    if !tail.is_empty() {
+        // Pad with a non-anchor byte and drop the padding bits
+        let mut padded = [0u8; 64];
+        padded[..tail.len()].copy_from_slice(tail);
+        f(start, classify(&padded).truncate(tail.len()));
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -284,4 +571,48 @@ mod tests {
             b"this is a long string that should trigger simd path for better performance"
         );
     }
+
+    #[test]
+    fn test_anchor_classes() {
+        let masks = classify_anchors_scalar(b"a.b:c@0x \t[]{}\"',;<=>()/");
+        assert_eq!(masks.dot, 1 << 1);
+        assert_eq!(masks.colon, 1 << 3);
+        assert_eq!(masks.at, 1 << 5);
+        assert_eq!(masks.x, 1 << 7);
+        // ':' '@' and everything from the space on
+        let expected = (1 << 3) | (1 << 5) | (((1u64 << 16) - 1) << 8);
+        assert_eq!(masks.boundary, expected);
+
+        for byte in [
+            b'+', b'-', b'*', b'X', b'|', b'~', b'?', b'#', 0x0B, 0x0C, 0x80, 0xFF,
+        ] {
+            assert!(!is_anchor_boundary(byte), "{:#x}", byte);
+        }
+    }
+
+    #[test]
+    fn test_scan_anchors_matches_scalar() {
+        // Every byte value, at every alignment, plus a short tail
+        let mut text: Vec<u8> = (0..=255u8).cycle().take(64 * 9 + 23).collect();
+        let mut seed = 0x9E37_79B9u32;
+        for byte in text.iter_mut().skip(300) {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            *byte = b"0123456789abcdefx.:@ \n/"[(seed % 23) as usize];
+        }
+
+        let mut blocks = 0;
+        scan_anchors(&text, |start, masks| {
+            let end = (start + 64).min(text.len());
+            assert_eq!(
+                masks,
+                classify_anchors_scalar(&text[start..end]),
+                "block at {}",
+                start
+            );
+            blocks += 1;
+        });
+        assert_eq!(blocks, 10);
+    }
 }
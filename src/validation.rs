@@ -35,10 +35,13 @@
 //! # Ok::<(), Box<dyn std::error::Error>>(())
 //! ```
 
+use crate::ac_offset::ByteClasses;
 use crate::error::{ParaglobError, Result};
+use crate::glob::MatchMode;
+use crate::glob_program::GlobPrograms;
 use crate::offset_format::{
     ACEdge, ACNodeHot, MetaWordMapping, ParaglobHeader, PatternDataMapping, PatternEntry,
-    StateKind, MAGIC, VERSION, VERSION_V1, VERSION_V2, VERSION_V3,
+    StateKind, MAGIC, VERSION, VERSION_V1, VERSION_V2, VERSION_V3, VERSION_V5,
 };
 use std::collections::HashSet;
 use std::fs::File;
@@ -95,7 +98,7 @@ pub struct DatabaseStats {
     /// Has AC literal mapping (v3)
     pub has_ac_literal_mapping: bool,
     /// Number of state encoding types used
-    pub state_encoding_distribution: [u32; 4], // Empty, One, Sparse, Dense
+    pub state_encoding_distribution: [u32; 5], // Empty, One, Sparse, Dense, Dfa
     /// Locations where unsafe code is used (Audit mode only)
     pub unsafe_code_locations: Vec<UnsafeCodeLocation>,
     /// Trust assumptions that would bypass validation
@@ -393,6 +396,60 @@ fn validate_mmdb_database(
                     }
                 }
 
+                // Check for IP stride index
+                if let Some(crate::DataValue::Uint32(stride_offset)) =
+                    map.get("ip_stride_section_offset")
+                {
+                    if *stride_offset > 0 {
+                        let offset = *stride_offset as usize;
+                        report.info(format!("IP stride index found at offset {}", offset));
+                        validate_ip_stride_section(buffer, offset, report, level);
+                    }
+                }
+
+                // Check for string prefilter
+                if let Some(crate::DataValue::Uint32(prefilter_offset)) =
+                    map.get("prefilter_section_offset")
+                {
+                    if *prefilter_offset > 0 {
+                        let offset = *prefilter_offset as usize;
+                        report.info(format!("String prefilter found at offset {}", offset));
+                        let match_mode = match map.get("match_mode") {
+                            Some(crate::DataValue::Uint16(1)) => MatchMode::CaseInsensitive,
+                            _ => MatchMode::CaseSensitive,
+                        };
+                        let literal_offset = match map.get("literal_section_offset") {
+                            Some(crate::DataValue::Uint32(o)) if *o > 0 => Some(*o as usize),
+                            _ => None,
+                        };
+                        validate_prefilter_section(
+                            buffer,
+                            offset,
+                            literal_offset,
+                            match_mode,
+                            report,
+                            level,
+                        );
+                    }
+                }
+
+                // Check the header checksum trusted opens rely on
+                if let Some(checksum) = map.get(crate::mmdb::HEADER_CHECKSUM_KEY) {
+                    let body = crate::mmdb::find_metadata_marker(buffer)
+                        .map_or(buffer, |marker| &buffer[..marker]);
+                    match checksum {
+                        crate::DataValue::Uint64(expected)
+                            if crate::mmdb::header_checksum(body, &map) == *expected =>
+                        {
+                            report.info("Header checksum matches")
+                        }
+                        crate::DataValue::Uint64(_) => report.error(
+                            "Header checksum mismatch: file is truncated or was modified after build",
+                        ),
+                        _ => report.warning("header_checksum has unexpected type"),
+                    }
+                }
+
                 // Store IP count for stats
                 if node_count > 0 {
                     // Rough estimate: nodes roughly correlate with IP entries
@@ -452,6 +509,115 @@ fn validate_mmdb_database(
     Ok(report.clone())
 }
 
+/// Validate the optional IP stride index section
+///
+/// The header must describe nodes that fit in the file. In strict/audit mode
+/// a spread of addresses is also looked up through both the index and the
+/// binary tree, since a stale index would silently return wrong answers.
+fn validate_ip_stride_section(
+    buffer: &[u8],
+    offset: usize,
+    report: &mut ValidationReport,
+    level: ValidationLevel,
+) {
+    use crate::mmdb::stride::{self, StrideHeader, STRIDE_SEPARATOR};
+
+    if offset < 16 || buffer.get(offset - 16..offset) != Some(&STRIDE_SEPARATOR[..]) {
+        report.error("MMDB_IPSTRIDE marker not found before IP stride index");
+        return;
+    }
+
+    let stride_header = match StrideHeader::from_section(buffer, offset) {
+        Ok(h) => h,
+        Err(e) => {
+            report.error(format!("Invalid IP stride index: {}", e));
+            return;
+        }
+    };
+    report.info(format!(
+        "IP stride index: {} nodes",
+        stride_header.node_count
+    ));
+
+    if level == ValidationLevel::Strict || level == ValidationLevel::Audit {
+        match crate::mmdb::MmdbHeader::from_file(buffer) {
+            Ok(tree_header) => {
+                if let Some(addr) =
+                    stride::find_mismatch(buffer, &tree_header, &stride_header, 4096)
+                {
+                    report.error(format!(
+                        "IP stride index disagrees with search tree for {}",
+                        addr
+                    ));
+                }
+            }
+            Err(e) => report.error(format!("Cannot check IP stride index: {}", e)),
+        }
+    }
+}
+
+/// Validate the optional string prefilter section
+///
+/// The header must describe blocks that fit in the file. In strict/audit
+/// mode every literal is also run through the filter, since one it rejects
+/// would silently never match.
+fn validate_prefilter_section(
+    buffer: &[u8],
+    offset: usize,
+    literal_offset: Option<usize>,
+    match_mode: MatchMode,
+    report: &mut ValidationReport,
+    level: ValidationLevel,
+) {
+    use crate::prefilter::{Prefilter, PrefilterHeader, PREFILTER_SEPARATOR};
+
+    if offset < 16 || buffer.get(offset - 16..offset) != Some(&PREFILTER_SEPARATOR[..]) {
+        report.error("MMDB_PREFILTER marker not found before string prefilter");
+        return;
+    }
+
+    let header = match PrefilterHeader::from_section(buffer, offset) {
+        Ok(h) => h,
+        Err(e) => {
+            report.error(format!("Invalid string prefilter: {}", e));
+            return;
+        }
+    };
+    let prefilter = Prefilter::new(buffer, &header, match_mode);
+    report.info(format!(
+        "String prefilter: {} blocks, globs {}",
+        header.block_count,
+        if prefilter.globs_filtered() {
+            "filtered"
+        } else {
+            "not filtered"
+        }
+    ));
+
+    if level == ValidationLevel::Strict || level == ValidationLevel::Audit {
+        let Some(literal_data) = literal_offset.and_then(|o| buffer.get(o..)) else {
+            return;
+        };
+        match crate::literal_hash::LiteralHash::from_buffer(literal_data, match_mode) {
+            Ok(literals) => {
+                let mut rejected = 0usize;
+                literals.for_each_pattern(|literal, _| {
+                    if !prefilter.may_be_literal(literal) {
+                        rejected += 1;
+                    }
+                });
+                if rejected > 0 {
+                    report.error(format!(
+                        "String prefilter rejects {} stored literal(s)",
+                        rejected
+                    ));
+                }
+            }
+            Err(e) => report.error(format!("Cannot check string prefilter: {}", e)),
+        }
+    }
+}
+
 /// Validate literal hash section structure
 fn validate_literal_hash_section(
     buffer: &[u8],
@@ -517,7 +683,12 @@ fn validate_literal_hash_section(
             ));
 
             // Basic sanity checks
-            if version != 1 {
+            if version == crate::literal_phf::PERFECT_HASH_VERSION {
+                match crate::literal_phf::PerfectHashTable::from_buffer(&buffer[offset..]) {
+                    Ok(_) => report.info("Literal hash uses the perfect hash layout"),
+                    Err(e) => report.error(format!("Invalid perfect hash layout: {}", e)),
+                }
+            } else if version != 1 {
                 report.warning(format!("Unexpected literal hash version: {}", version));
             }
 
@@ -1048,6 +1219,9 @@ fn validate_paraglob_header(buffer: &[u8], report: &mut ValidationReport) -> Res
         VERSION => {
             report.info("Format version: v4 (latest - ACNodeHot for 50% memory reduction)");
         }
+        VERSION_V5 => {
+            report.info("Format version: v5 (v4 with DFA automaton states)");
+        }
         VERSION_V3 => {
             report.warning("Format version: v3 (older - uses 32-byte ACNode, no longer supported)");
         }
@@ -1061,7 +1235,7 @@ fn validate_paraglob_header(buffer: &[u8], report: &mut ValidationReport) -> Res
         }
         v => {
             report.error(format!(
-                "Unsupported version: {} (expected 1, 2, 3, or 4)",
+                "Unsupported version: {} (expected 1, 2, 3, 4, or 5)",
                 v
             ));
             return Ok(());
@@ -1213,6 +1387,19 @@ fn validate_paraglob_offsets(
         }
     }
 
+    // Validate compiled glob programs
+    if header.has_glob_programs() {
+        let offset = header.glob_programs_offset as usize;
+        let size = header.glob_programs_size as usize;
+
+        if !validate_range(offset, size, buffer_len) {
+            report.error(format!(
+                "Glob programs section out of bounds: offset={}, size={}, buffer={}",
+                offset, size, buffer_len
+            ));
+        }
+    }
+
     Ok(())
 }
 
@@ -1282,6 +1469,30 @@ fn validate_paraglob_strings(
 }
 
 /// Validate AC automaton structure
+/// The byte-class map (v5), if the header points at one in bounds
+fn byte_class_map<'a>(buffer: &'a [u8], header: &ParaglobHeader) -> Option<&'a [u8; 256]> {
+    let offset = header.byte_classes_offset as usize;
+    if offset == 0 {
+        return None;
+    }
+    buffer
+        .get(offset..offset.checked_add(256)?)?
+        .try_into()
+        .ok()
+}
+
+/// Entries and bytes per dense/DFA table: one per byte class with a
+/// byte-class map, otherwise 256 (1024 bytes)
+fn dense_table_layout(buffer: &[u8], header: &ParaglobHeader) -> (usize, usize) {
+    match byte_class_map(buffer, header) {
+        Some(map) => {
+            let classes = ByteClasses::from_map(map);
+            (classes.count(), classes.table_size())
+        }
+        None => (256, 1024),
+    }
+}
+
 fn validate_ac_structure(
     buffer: &[u8],
     header: &ParaglobHeader,
@@ -1296,7 +1507,25 @@ fn validate_ac_structure(
     let nodes_offset = header.ac_nodes_offset as usize;
     let node_count = header.ac_node_count as usize;
 
-    let mut state_distribution = [0u32; 4];
+    if header.byte_classes_offset != 0 {
+        match byte_class_map(buffer, header) {
+            Some(map) => {
+                let classes = ByteClasses::from_map(map);
+                report.info(format!(
+                    "AC byte classes: {} (dense tables {} bytes)",
+                    classes.count(),
+                    classes.table_size()
+                ));
+            }
+            None => report.error(format!(
+                "Byte-class map out of bounds: offset={}",
+                header.byte_classes_offset
+            )),
+        }
+    }
+    let (table_entries, table_size) = dense_table_layout(buffer, header);
+
+    let mut state_distribution = [0u32; 5];
 
     for i in 0..node_count {
         let node_offset = nodes_offset + i * mem::size_of::<ACNodeHot>();
@@ -1410,10 +1639,10 @@ fn validate_ac_structure(
                     }
                 }
             }
-            StateKind::Dense => {
-                // Validate dense lookup table (256 * 4 bytes = 1024 bytes)
+            StateKind::Dense | StateKind::Dfa => {
+                // Validate dense lookup table (one u32 per byte or byte class)
                 let lookup_offset = node.edges_offset as usize;
-                let lookup_size = 1024;
+                let lookup_size = table_size;
 
                 if !validate_range(lookup_offset, lookup_size, buffer.len()) {
                     report.error(format!(
@@ -1429,7 +1658,7 @@ fn validate_ac_structure(
 
                 // Optionally validate all targets in strict/audit mode
                 if level == ValidationLevel::Strict || level == ValidationLevel::Audit {
-                    for j in 0..256 {
+                    for j in 0..table_entries {
                         let target_offset_pos = lookup_offset + j * 4;
                         if target_offset_pos + 4 <= buffer.len() {
                             let target_offset = u32::from_le_bytes([
@@ -1497,12 +1726,13 @@ fn validate_ac_structure(
     report.stats.state_encoding_distribution = state_distribution;
 
     report.info(format!(
-        "AC automaton: {} nodes, encodings: Empty={}, One={}, Sparse={}, Dense={}",
+        "AC automaton: {} nodes, encodings: Empty={}, One={}, Sparse={}, Dense={}, Dfa={}",
         node_count,
         state_distribution[0],
         state_distribution[1],
         state_distribution[2],
-        state_distribution[3]
+        state_distribution[3],
+        state_distribution[4]
     ));
 
     // Note: Unreachable node detection removed for ACNodeHot (no node_id tracking)
@@ -1605,7 +1835,12 @@ fn validate_paraglob_consistency(
         validate_meta_word_consistency(buffer, header, report)?;
     }
 
-    // 6. Audit mode: track potential performance issues
+    // 6. Validate compiled glob programs
+    if header.has_glob_programs() {
+        validate_glob_programs(buffer, header, report);
+    }
+
+    // 7. Audit mode: track potential performance issues
     if level == ValidationLevel::Audit {
         audit_paraglob_performance(header, report)?;
     }
@@ -1614,6 +1849,34 @@ fn validate_paraglob_consistency(
     Ok(())
 }
 
+/// Check that the compiled glob programs decode and cover the pattern table
+fn validate_glob_programs(buffer: &[u8], header: &ParaglobHeader, report: &mut ValidationReport) {
+    let offset = header.glob_programs_offset as usize;
+    let size = header.glob_programs_size as usize;
+    let Some(section) = offset
+        .checked_add(size)
+        .and_then(|end| buffer.get(offset..end))
+    else {
+        // Already reported by the offset checks
+        return;
+    };
+
+    let Some(programs) = GlobPrograms::new(section) else {
+        report.error("Glob programs section has an invalid header");
+        return;
+    };
+    if programs.pattern_count() != header.pattern_count as usize {
+        report.error(format!(
+            "Glob programs cover {} patterns, but the pattern table has {}",
+            programs.pattern_count(),
+            header.pattern_count
+        ));
+    }
+    if let Err(e) = programs.validate() {
+        report.error(format!("Glob programs section is corrupt: {}", e));
+    }
+}
+
 /// Check that all AC nodes are reachable from root (no orphans)
 fn validate_ac_reachability(
     buffer: &[u8],
@@ -1626,6 +1889,7 @@ fn validate_ac_reachability(
 
     let nodes_offset = header.ac_nodes_offset as usize;
     let node_count = header.ac_node_count as usize;
+    let (table_entries, table_size) = dense_table_layout(buffer, header);
 
     // Track which nodes are reachable via BFS from root
     let mut reachable = vec![false; node_count];
@@ -1697,12 +1961,12 @@ fn validate_ac_reachability(
                     }
                 }
             }
-            StateKind::Dense => {
+            StateKind::Dense | StateKind::Dfa => {
                 let lookup_offset = node.edges_offset as usize;
-                let lookup_size = 1024; // 256 * 4 bytes
+                let lookup_size = table_size;
 
                 if lookup_offset + lookup_size <= buffer.len() {
-                    for i in 0..256 {
+                    for i in 0..table_entries {
                         let target_offset_pos = lookup_offset + i * 4;
                         if target_offset_pos + 4 <= buffer.len() {
                             let target_offset = u32::from_le_bytes([
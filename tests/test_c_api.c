@@ -185,6 +185,21 @@ int main() {
     }
     printf("✓ NULL path rejected\n");
     
+    // Options not set up by matchy_init_open_options() should fail
+    matchy_init_open_options(&opts);
+    if (opts.struct_size != sizeof(opts)) {
+        fprintf(stderr, "struct_size not set by init\n");
+        return 1;
+    }
+    opts.struct_size = sizeof(uint32_t);
+    db_null = matchy_open_with_options(tmpfile, &opts);
+    if (db_null != NULL) {
+        fprintf(stderr, "Should have failed with unknown struct_size\n");
+        matchy_close(db_null);
+        return 1;
+    }
+    printf("✓ Unknown options struct_size rejected\n");
+    
     printf("\n=== All C API tests passed! ===\n");
     return 0;
 }
@@ -475,6 +475,595 @@ void test_null_parameters(matchy_t *db) {
     END_TEST();
 }
 
+void test_query_batch(matchy_t *db) {
+    TEST("matchy_query_batch");
+    
+    const char *keys[] = {"8.8.8.8", "11.11.11.11", "1.1.1.1", "not-an-ip.example", NULL, "9.9.9.9xyz"};
+    size_t lens[] = {7, 11, 7, 17, 0, 7};  // last key truncated to "9.9.9.9"
+    matchy_result_t results[6];
+    
+    int status = matchy_query_batch(db, keys, lens, 6, results);
+    ASSERT(status == MATCHY_SUCCESS, "Batch query should succeed");
+    ASSERT(results[0].found, "Batch should find 8.8.8.8");
+    ASSERT(!results[1].found, "Batch should not find 11.11.11.11");
+    ASSERT(results[2].found, "Batch should find 1.1.1.1");
+    ASSERT(!results[3].found, "Batch should not find unknown string");
+    ASSERT(!results[4].found, "NULL key should be not found");
+    ASSERT(results[5].found, "Length-delimited key should find 9.9.9.9");
+    
+    // Batch results must match single queries
+    matchy_result_t single = matchy_query(db, "8.8.8.8");
+    ASSERT(single.prefix_len == results[0].prefix_len, "Batch prefix_len should match single query");
+    matchy_free_result(&single);
+    
+    char *json = matchy_result_to_json(&results[2]);
+    ASSERT(json != NULL && strstr(json, "simple_string") != NULL, "Batch result data should be accessible");
+    matchy_free_string(json);
+    
+    for (int i = 0; i < 6; i++) {
+        matchy_free_result(&results[i]);
+    }
+    
+    // Null-terminated keys (lens == NULL)
+    const char *cstr_keys[] = {"10.0.0.1", "192.168.1.1"};
+    status = matchy_query_batch(db, cstr_keys, NULL, 2, results);
+    ASSERT(status == MATCHY_SUCCESS && results[0].found && results[1].found,
+           "Batch with NULL lens should find both keys");
+    matchy_free_result(&results[0]);
+    matchy_free_result(&results[1]);
+    
+    // Parameter validation
+    ASSERT(matchy_query_batch(NULL, keys, lens, 6, results) == MATCHY_ERROR_INVALID_PARAM,
+           "NULL db should be rejected");
+    ASSERT(matchy_query_batch(db, keys, lens, 6, NULL) == MATCHY_ERROR_INVALID_PARAM,
+           "NULL out should be rejected");
+    ASSERT(matchy_query_batch(db, NULL, NULL, 0, NULL) == MATCHY_SUCCESS,
+           "Empty batch should succeed");
+    
+    END_TEST();
+}
+
+void test_query_n_and_ip(matchy_t *db) {
+    TEST("matchy_query_n / matchy_query_ip");
+    
+    // Key sliced out of a larger buffer, not null-terminated
+    const char *line = "src=8.8.8.8 dst=example.org";
+    matchy_result_t result = matchy_query_n(db, (const uint8_t *)line + 4, 7);
+    ASSERT(result.found, "matchy_query_n should find 8.8.8.8 in place");
+    matchy_free_result(&result);
+    
+    result = matchy_query_n(db, (const uint8_t *)line + 4, 6);
+    ASSERT(!result.found, "matchy_query_n should honor the length (8.8.8.)");
+    matchy_free_result(&result);
+    
+    const uint8_t invalid_utf8[] = {0xff, 0xfe};
+    result = matchy_query_n(db, invalid_utf8, sizeof(invalid_utf8));
+    ASSERT(!result.found, "matchy_query_n should reject invalid UTF-8");
+    matchy_free_result(&result);
+    
+    // Binary IPv4 and IPv6 forms
+    const uint8_t v4[16] = {1, 1, 1, 1};
+    result = matchy_query_ip(db, v4, MATCHY_FAMILY_IPV4);
+    ASSERT(result.found, "matchy_query_ip should find 1.1.1.1");
+    char *json = matchy_result_to_json(&result);
+    ASSERT(json != NULL && strstr(json, "simple_string") != NULL, "Binary IP result data should be accessible");
+    matchy_free_string(json);
+    
+    matchy_result_t text = matchy_query(db, "1.1.1.1");
+    ASSERT(text.prefix_len == result.prefix_len, "Binary and text lookups should agree on prefix_len");
+    matchy_free_result(&text);
+    matchy_free_result(&result);
+    
+    const uint8_t v4_miss[4] = {11, 11, 11, 11};
+    result = matchy_query_ip(db, v4_miss, MATCHY_FAMILY_IPV4);
+    ASSERT(!result.found, "matchy_query_ip should not find 11.11.11.11");
+    matchy_free_result(&result);
+    
+    const uint8_t v6[16] = {0x20, 0x01, 0x0d, 0xb8};
+    result = matchy_query_ip(db, v6, MATCHY_FAMILY_IPV6);
+    ASSERT(!result.found, "matchy_query_ip should not find 2001:db8::");
+    matchy_free_result(&result);
+    
+    result = matchy_query_ip(db, v4, 5);
+    ASSERT(!result.found, "Unknown family should be not found");
+    result = matchy_query_ip(db, NULL, MATCHY_FAMILY_IPV4);
+    ASSERT(!result.found, "NULL addr should be not found");
+    result = matchy_query_n(NULL, (const uint8_t *)line, 4);
+    ASSERT(!result.found, "NULL db should be not found");
+    
+    END_TEST();
+}
+
+void test_query_ips(matchy_t *db) {
+    TEST("matchy_query_ips");
+    
+    // Unsorted, with a repeat and a miss; results come back in input order
+    const uint8_t addrs[][4] = {
+        {10, 0, 0, 1}, {1, 1, 1, 1}, {11, 11, 11, 11}, {8, 8, 8, 8}, {1, 1, 1, 1},
+    };
+    matchy_result_t results[5];
+    int status = matchy_query_ips(db, &addrs[0][0], MATCHY_FAMILY_IPV4, 5, results);
+    ASSERT(status == MATCHY_SUCCESS, "matchy_query_ips should succeed");
+    
+    for (size_t i = 0; i < 5; i++) {
+        matchy_result_t single = matchy_query_ip(db, addrs[i], MATCHY_FAMILY_IPV4);
+        ASSERT(results[i].found == single.found, "Sorted and single lookups should agree on found");
+        ASSERT(results[i].prefix_len == single.prefix_len, "Sorted and single lookups should agree on prefix_len");
+        matchy_free_result(&single);
+    }
+    ASSERT(!results[2].found, "11.11.11.11 should not be found");
+    char *json = matchy_result_to_json(&results[4]);
+    ASSERT(json != NULL && strstr(json, "simple_string") != NULL, "Repeated address should carry its data");
+    matchy_free_string(json);
+    for (size_t i = 0; i < 5; i++) {
+        matchy_free_result(&results[i]);
+    }
+    
+    ASSERT(matchy_query_ips(db, &addrs[0][0], 5, 5, results) == MATCHY_ERROR_INVALID_PARAM,
+           "Unknown family should be rejected");
+    ASSERT(matchy_query_ips(NULL, &addrs[0][0], MATCHY_FAMILY_IPV4, 5, results) == MATCHY_ERROR_INVALID_PARAM,
+           "NULL db should be rejected");
+    ASSERT(matchy_query_ips(db, NULL, MATCHY_FAMILY_IPV6, 0, NULL) == MATCHY_SUCCESS,
+           "Empty batch should succeed");
+    
+    END_TEST();
+}
+
+typedef struct {
+    int count;
+    uint8_t first[4];
+    int first_has_data;
+} network_ctx_t;
+
+static int32_t collect_network(const matchy_network_t *network, void *ctx) {
+    network_ctx_t *seen = (network_ctx_t *)ctx;
+    if (seen->count == 0 && network->family == MATCHY_FAMILY_IPV4) {
+        memcpy(seen->first, network->addr, 4);
+        char *json = matchy_result_to_json(&network->result);
+        seen->first_has_data = json != NULL && strstr(json, "simple_string") != NULL;
+        matchy_free_string(json);
+    }
+    seen->count++;
+    return 0;
+}
+
+static int32_t stop_after_two(const matchy_network_t *network, void *ctx) {
+    (void)network;
+    return ++*(int *)ctx >= 2;
+}
+
+void test_foreach_network(matchy_t *db) {
+    TEST("matchy_foreach_network");
+    
+    network_ctx_t seen = {0};
+    int64_t count = matchy_foreach_network(db, collect_network, &seen);
+    ASSERT(count == 5 && seen.count == 5, "Should visit the five stored networks");
+    ASSERT(memcmp(seen.first, (uint8_t[]){1, 1, 1, 1}, 4) == 0, "Networks should come in address order");
+    ASSERT(seen.first_has_data, "Network results should carry their data");
+    
+    int calls = 0;
+    ASSERT(matchy_foreach_network(db, stop_after_two, &calls) == 2 && calls == 2,
+           "Non-zero callback return should stop the walk");
+    
+    ASSERT(matchy_foreach_network(db, NULL, NULL) == MATCHY_ERROR_INVALID_PARAM,
+           "NULL callback should be rejected");
+    ASSERT(matchy_foreach_network(NULL, collect_network, &seen) == MATCHY_ERROR_INVALID_PARAM,
+           "NULL db should be rejected");
+    
+    END_TEST();
+}
+
+void test_lazy_results(matchy_t *db) {
+    TEST("lazy_results option");
+    
+    matchy_open_options_t opts;
+    matchy_init_open_options(&opts);
+    ASSERT(!opts.lazy_results, "lazy_results should default to false");
+    opts.lazy_results = true;
+    
+    matchy_t *lazy_db = matchy_open_with_options(TEST_DB_PATH, &opts);
+    ASSERT(lazy_db != NULL, "Should open database with lazy results");
+    if (lazy_db == NULL) {
+        END_TEST();
+        return;
+    }
+    
+    matchy_result_t result = matchy_query(lazy_db, "8.8.8.8");
+    ASSERT(result.found, "Lazy query should find 8.8.8.8");
+    ASSERT(result._data_cache == NULL, "Lazy result should not hold decoded data");
+    matchy_result_t eager = matchy_query(db, "8.8.8.8");
+    ASSERT(result.prefix_len == eager.prefix_len, "Lazy prefix_len should match eager query");
+    
+    matchy_entry_s entry;
+    ASSERT(matchy_result_get_entry(&result, &entry) == MATCHY_SUCCESS, "Should get entry");
+    
+    // Strings borrow from the data section and are not null-terminated
+    matchy_entry_data_t data;
+    const char *iso_path[] = {"country", "iso_code", NULL};
+    ASSERT(matchy_aget_value(&entry, &data, iso_path) == MATCHY_SUCCESS,
+           "Should get country.iso_code lazily");
+    ASSERT(data.type_ == MATCHY_DATA_TYPE_UTF8_STRING && data.data_size == 2
+           && strncmp(data.value.utf8_string, "US", data.data_size) == 0,
+           "Lazy country.iso_code should be 'US'");
+    
+    const char *lat_path[] = {"location", "latitude", NULL};
+    ASSERT(matchy_aget_value(&entry, &data, lat_path) == MATCHY_SUCCESS
+           && data.type_ == MATCHY_DATA_TYPE_DOUBLE && data.value.double_value == 37.751,
+           "Lazy location.latitude should be 37.751");
+    
+    const char *bad_path[] = {"country", "missing", NULL};
+    ASSERT(matchy_aget_value(&entry, &data, bad_path) == MATCHY_ERROR_LOOKUP_PATH_INVALID,
+           "Lazy missing path should be LOOKUP_PATH_INVALID");
+    
+    // Same number of list nodes as the decoded traversal
+    matchy_entry_s eager_entry;
+    matchy_result_get_entry(&eager, &eager_entry);
+    matchy_entry_data_list_t *lazy_list = NULL, *eager_list = NULL;
+    ASSERT(matchy_get_entry_data_list(&entry, &lazy_list) == MATCHY_SUCCESS,
+           "Should get lazy entry data list");
+    matchy_get_entry_data_list(&eager_entry, &eager_list);
+    int lazy_count = 0, eager_count = 0;
+    for (matchy_entry_data_list_t *p = lazy_list; p != NULL; p = p->next) lazy_count++;
+    for (matchy_entry_data_list_t *p = eager_list; p != NULL; p = p->next) eager_count++;
+    ASSERT(lazy_count > 0 && lazy_count == eager_count, "Lazy list should have as many nodes as eager list");
+    ASSERT(lazy_list != NULL && lazy_list->entry_data.type_ == MATCHY_DATA_TYPE_MAP,
+           "Lazy list should start with the root map");
+    matchy_free_entry_data_list(lazy_list);
+    matchy_free_entry_data_list(eager_list);
+    matchy_free_result(&eager);
+    
+    char *json = matchy_result_to_json(&result);
+    ASSERT(json != NULL && strstr(json, "United States") != NULL, "Lazy result should convert to JSON");
+    matchy_free_string(json);
+    
+    matchy_free_result(&result);
+    
+    matchy_result_t miss = matchy_query(lazy_db, "11.11.11.11");
+    ASSERT(!miss.found, "Lazy query should not find 11.11.11.11");
+    matchy_free_result(&miss);
+    
+    const uint8_t addrs[][4] = {{11, 11, 11, 11}, {8, 8, 8, 8}};
+    matchy_result_t batch[2];
+    ASSERT(matchy_query_ips(lazy_db, &addrs[0][0], MATCHY_FAMILY_IPV4, 2, batch) == MATCHY_SUCCESS
+           && !batch[0].found && batch[1].found && batch[1]._data_cache == NULL,
+           "Lazy matchy_query_ips should return lazy results");
+    json = matchy_result_to_json(&batch[1]);
+    ASSERT(json != NULL && strstr(json, "United States") != NULL, "Lazy sorted result should convert to JSON");
+    matchy_free_string(json);
+    matchy_free_result(&batch[0]);
+    matchy_free_result(&batch[1]);
+    
+    matchy_close(lazy_db);
+    END_TEST();
+}
+
+void test_ipv4_direct_index(matchy_t *db) {
+    TEST("ipv4_direct_index option");
+    
+    matchy_open_options_t opts;
+    matchy_init_open_options(&opts);
+    ASSERT(!opts.ipv4_direct_index, "ipv4_direct_index should default to false");
+    opts.ipv4_direct_index = true;
+    
+    matchy_t *indexed_db = matchy_open_with_options(TEST_DB_PATH, &opts);
+    ASSERT(indexed_db != NULL, "Should open database with IPv4 direct index");
+    if (indexed_db == NULL) {
+        END_TEST();
+        return;
+    }
+    
+    const char *queries[] = {"8.8.8.8", "1.1.1.1", "9.9.9.9", "192.168.1.1", "11.11.11.11"};
+    for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); i++) {
+        matchy_result_t expected = matchy_query(db, queries[i]);
+        matchy_result_t result = matchy_query(indexed_db, queries[i]);
+        ASSERT(result.found == expected.found && result.prefix_len == expected.prefix_len,
+               "Indexed lookup should match plain lookup");
+        matchy_free_result(&result);
+        matchy_free_result(&expected);
+    }
+    
+    matchy_close(indexed_db);
+    END_TEST();
+}
+
+void test_negative_cache(matchy_t *db) {
+    TEST("negative_cache_capacity option");
+    
+    matchy_open_options_t opts;
+    matchy_init_open_options(&opts);
+    ASSERT(opts.negative_cache_capacity == 0, "negative_cache_capacity should default to 0");
+    opts.negative_cache_capacity = 1024;
+    
+    matchy_t *neg_db = matchy_open_with_options(TEST_DB_PATH, &opts);
+    ASSERT(neg_db != NULL, "Should open database with a negative cache");
+    if (neg_db == NULL) {
+        END_TEST();
+        return;
+    }
+    
+    const char *queries[] = {"8.8.8.8", "11.11.11.11", "8.8.8.8", "11.11.11.11"};
+    for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); i++) {
+        matchy_result_t expected = matchy_query(db, queries[i]);
+        matchy_result_t result = matchy_query(neg_db, queries[i]);
+        ASSERT(result.found == expected.found && result.prefix_len == expected.prefix_len,
+               "Negative-cached lookup should match plain lookup");
+        matchy_free_result(&result);
+        matchy_free_result(&expected);
+    }
+    
+    matchy_close(neg_db);
+    END_TEST();
+}
+
+void test_cache_policy(matchy_t *db) {
+    TEST("cache_policy option and eviction stats");
+    
+    matchy_open_options_t opts;
+    matchy_init_open_options(&opts);
+    ASSERT(opts.cache_policy == MATCHY_CACHE_LRU, "cache_policy should default to LRU");
+    
+    opts.cache_policy = 99;
+    ASSERT(matchy_open_with_options(TEST_DB_PATH, &opts) == NULL,
+           "Unknown cache policy should fail to open");
+    
+    opts.cache_policy = MATCHY_CACHE_TINYLFU;
+    opts.cache_capacity = 16;
+    matchy_t *policy_db = matchy_open_with_options(TEST_DB_PATH, &opts);
+    ASSERT(policy_db != NULL, "Should open database with W-TinyLFU cache");
+    if (policy_db == NULL) {
+        END_TEST();
+        return;
+    }
+    
+    char query[32];
+    for (int i = 0; i < 100; i++) {
+        snprintf(query, sizeof(query), "10.%d.%d.1", i / 10, i % 10);
+        matchy_result_t expected = matchy_query(db, query);
+        matchy_result_t result = matchy_query(policy_db, query);
+        ASSERT(result.found == expected.found, "Policy cache should not change results");
+        matchy_free_result(&result);
+        matchy_free_result(&expected);
+    }
+    
+    matchy_stats_t stats;
+    matchy_get_stats(policy_db, &stats);
+    ASSERT(stats.cache_evictions > 0, "Overfilled cache should report evictions");
+    ASSERT(stats.cache_rejections <= stats.cache_evictions,
+           "Rejections are a subset of evictions");
+    
+    matchy_close(policy_db);
+    END_TEST();
+}
+
+void test_reload(matchy_t *db) {
+    TEST("matchy_reload");
+    (void)db;
+    
+    const char *reload_path = "/tmp/matchy_extensions_reload.db";
+    matchy_builder_t *builder = matchy_builder_new();
+    matchy_builder_add(builder, "8.8.8.8", "{\"value\":\"reloaded\"}");
+    ASSERT(matchy_builder_save(builder, reload_path) == MATCHY_SUCCESS, "Should save second database");
+    matchy_builder_free(builder);
+    
+    matchy_open_options_t opts;
+    matchy_init_open_options(&opts);
+    ASSERT(opts.reload_warm_cache, "reload_warm_cache should default to true");
+    opts.lazy_results = true;
+    matchy_t *live = matchy_open_with_options(TEST_DB_PATH, &opts);
+    ASSERT(live != NULL, "Should open reloadable handle");
+    if (live == NULL) {
+        END_TEST();
+        return;
+    }
+    ASSERT(matchy_generation(live) == 0, "Fresh handle should be generation 0");
+    
+    matchy_result_t before = matchy_query(live, "8.8.8.8");
+    ASSERT(before.found, "Should find 8.8.8.8 before reload");
+    
+    ASSERT(matchy_reload(live, reload_path) == MATCHY_SUCCESS, "Reload should succeed");
+    ASSERT(matchy_generation(live) == 1, "Reload should bump the generation");
+    
+    // A lazy result from before the swap still reads the old file
+    matchy_entry_s entry;
+    matchy_entry_data_t data;
+    const char *iso_path[] = {"country", "iso_code", NULL};
+    matchy_result_get_entry(&before, &entry);
+    ASSERT(matchy_aget_value(&entry, &data, iso_path) == MATCHY_SUCCESS
+           && data.data_size == 2 && strncmp(data.value.utf8_string, "US", 2) == 0,
+           "Pre-reload lazy result should still decode old data");
+    matchy_free_result(&before);
+    ASSERT(before._db_version == NULL, "Freeing a lazy result should release its version");
+    
+    matchy_result_t after = matchy_query(live, "8.8.8.8");
+    const char *value_path[] = {"value", NULL};
+    matchy_result_get_entry(&after, &entry);
+    ASSERT(after.found && matchy_aget_value(&entry, &data, value_path) == MATCHY_SUCCESS
+           && data.data_size == 8 && strncmp(data.value.utf8_string, "reloaded", 8) == 0,
+           "Post-reload query should see the new file");
+    matchy_free_result(&after);
+    
+    matchy_result_t gone = matchy_query(live, "1.1.1.1");
+    ASSERT(!gone.found, "Entries missing from the new file should not be found");
+    matchy_free_result(&gone);
+    
+    ASSERT(matchy_reload(live, "/tmp/matchy_no_such_file.db") == MATCHY_ERROR_FILE_NOT_FOUND,
+           "Reload of a missing file should fail");
+    ASSERT(matchy_generation(live) == 1, "Failed reload should keep the generation");
+    ASSERT(matchy_reload(live, NULL) == MATCHY_SUCCESS, "Reload of the current path should succeed");
+    ASSERT(matchy_reload(NULL, NULL) == MATCHY_ERROR_INVALID_PARAM, "NULL handle should be rejected");
+    
+    matchy_close(live);
+    remove(reload_path);
+    END_TEST();
+}
+
+void test_arena(matchy_t *db) {
+    TEST("matchy_arena_t");
+    
+    matchy_arena_t *arena = matchy_arena_new(0);
+    ASSERT(arena != NULL, "Should create arena");
+    ASSERT(matchy_arena_used(arena) == 0, "Fresh arena should be empty");
+    
+    matchy_open_options_t opts;
+    matchy_init_open_options(&opts);
+    opts.lazy_results = true;
+    matchy_t *lazy_db = matchy_open_with_options(TEST_DB_PATH, &opts);
+    ASSERT(lazy_db != NULL, "Should open database with lazy results");
+    
+    // Decoded and lazy results render the same fields from the arena
+    matchy_t *dbs[] = {db, lazy_db};
+    for (int i = 0; i < 2 && lazy_db != NULL; i++) {
+        matchy_result_t result = matchy_query(dbs[i], "8.8.8.8");
+        const char *json = matchy_result_to_json_arena(&result, arena);
+        ASSERT(json != NULL && strstr(json, "United States") != NULL
+               && strstr(json, "iso_code") != NULL, "Arena JSON should contain the record");
+        
+        matchy_entry_s entry;
+        matchy_result_get_entry(&result, &entry);
+        matchy_entry_data_list_t *list = NULL, *heap_list = NULL;
+        ASSERT(matchy_get_entry_data_list_arena(&entry, &list, arena) == MATCHY_SUCCESS,
+               "Should get arena entry data list");
+        matchy_get_entry_data_list(&entry, &heap_list);
+        int count = 0, heap_count = 0, strings_ok = 1;
+        for (matchy_entry_data_list_t *p = list; p != NULL; p = p->next) {
+            count++;
+            if (i == 0 && p->entry_data.type_ == MATCHY_DATA_TYPE_UTF8_STRING) {
+                strings_ok &= strlen(p->entry_data.value.utf8_string) == p->entry_data.data_size;
+            }
+        }
+        for (matchy_entry_data_list_t *p = heap_list; p != NULL; p = p->next) heap_count++;
+        ASSERT(count > 0 && count == heap_count, "Arena list should match the heap list");
+        ASSERT(strings_ok, "Decoded arena strings should be null-terminated");
+        matchy_free_entry_data_list(heap_list);
+        matchy_free_result(&result);
+    }
+    
+    size_t used = matchy_arena_used(arena);
+    ASSERT(used > 0, "Arena should account for its allocations");
+    matchy_arena_reset(arena);
+    ASSERT(matchy_arena_used(arena) == 0, "Reset should release everything");
+    
+    matchy_result_t miss = matchy_query(db, "11.11.11.11");
+    ASSERT(matchy_result_to_json_arena(&miss, arena) == NULL, "Not found should render NULL");
+    ASSERT(matchy_result_to_json_arena(&miss, NULL) == NULL, "NULL arena should be rejected");
+    matchy_free_result(&miss);
+    
+    if (lazy_db) matchy_close(lazy_db);
+    matchy_arena_free(arena);
+    END_TEST();
+}
+
+typedef struct {
+    int count;
+    int stop_after;
+    size_t offsets[8];
+    uint32_t db_ids[8];
+    int decoded_ok;
+} scan_ctx_t;
+
+static int32_t collect_match(const matchy_scan_match_t *m, void *ctx) {
+    scan_ctx_t *c = (scan_ctx_t *)ctx;
+    if (c->count < 8) {
+        c->offsets[c->count] = m->offset;
+        c->db_ids[c->count] = m->db_id;
+    }
+    c->count++;
+    
+    // The result decodes like a matchy_query() result while the callback runs
+    matchy_entry_s entry;
+    matchy_entry_data_t data;
+    const char *path[] = {"value", NULL};
+    if (m->type_ == MATCHY_ITEM_IPV4 && m->length == 7 && memcmp(m->text, "1.1.1.1", 7) == 0) {
+        matchy_result_get_entry(&m->result, &entry);
+        c->decoded_ok &= matchy_aget_value(&entry, &data, path) == MATCHY_SUCCESS
+            && data.data_size == 13 && strncmp(data.value.utf8_string, "simple_string", 13) == 0;
+    }
+    return c->stop_after > 0 && c->count >= c->stop_after;
+}
+
+void test_worker_scan(matchy_t *db) {
+    TEST("matchy_worker_scan");
+    
+    matchy_open_options_t opts;
+    matchy_init_open_options(&opts);
+    opts.lazy_results = true;
+    matchy_t *lazy_db = matchy_open_with_options(TEST_DB_PATH, &opts);
+    ASSERT(lazy_db != NULL, "Should open database with lazy results");
+    
+    const matchy_t *dbs[] = {db, lazy_db};
+    matchy_worker_t *worker = matchy_worker_new(dbs, 2, MATCHY_EXTRACT_IPV4 | MATCHY_EXTRACT_DOMAINS);
+    ASSERT(worker != NULL, "Should create worker");
+    if (worker == NULL || lazy_db == NULL) {
+        if (lazy_db) matchy_close(lazy_db);
+        END_TEST();
+        return;
+    }
+    
+    const char *text = "src=1.1.1.1 dst=11.11.11.11 host=example.com via 8.8.8.8\n";
+    scan_ctx_t ctx = {0, 0, {0}, {0}, 1};
+    int64_t n = matchy_worker_scan(worker, (const uint8_t *)text, strlen(text), collect_match, &ctx);
+    ASSERT(n == 4 && ctx.count == 4, "Two indicators should match in both databases");
+    ASSERT(ctx.offsets[0] == 4 && ctx.offsets[1] == 4 && ctx.offsets[2] == 49 && ctx.offsets[3] == 49,
+           "Match offsets should point into the buffer");
+    ASSERT(ctx.db_ids[0] == 0 && ctx.db_ids[1] == 1, "Databases should report in order");
+    ASSERT(ctx.decoded_ok, "Decoded and lazy scan results should read their data");
+    
+    scan_ctx_t stop = {0, 1, {0}, {0}, 1};
+    n = matchy_worker_scan(worker, (const uint8_t *)text, strlen(text), collect_match, &stop);
+    ASSERT(n == 1 && stop.count == 1, "Non-zero callback return should stop the scan");
+    
+    ASSERT(matchy_worker_scan(worker, NULL, 0, collect_match, &ctx) == 0, "Empty buffer has no matches");
+    ASSERT(matchy_worker_scan(worker, (const uint8_t *)text, 4, NULL, NULL) == MATCHY_ERROR_INVALID_PARAM,
+           "NULL callback should be rejected");
+    ASSERT(matchy_worker_new(NULL, 1, 0) == NULL, "NULL database array should be rejected");
+    ASSERT(matchy_worker_new(dbs, 0, 0) == NULL, "Empty database array should be rejected");
+    
+    matchy_worker_free(worker);
+    matchy_worker_free(NULL);
+    matchy_close(lazy_db);
+    END_TEST();
+}
+
+void test_profile(matchy_t *db) {
+    TEST("profile_sample_rate and matchy_get_profile");
+    
+    matchy_profile_t prof;
+    ASSERT(matchy_get_profile(db, &prof) == MATCHY_ERROR_NO_DATA,
+           "Profile should be unavailable when profiling is off");
+    ASSERT(matchy_get_profile(db, NULL) == MATCHY_ERROR_INVALID_PARAM,
+           "NULL profile should be rejected");
+    
+    matchy_open_options_t opts;
+    matchy_init_open_options(&opts);
+    ASSERT(opts.profile_sample_rate == 0, "profile_sample_rate should default to 0");
+    opts.profile_sample_rate = 1;
+    
+    matchy_t *prof_db = matchy_open_with_options(TEST_DB_PATH, &opts);
+    ASSERT(prof_db != NULL, "Should open database with profiling");
+    if (prof_db == NULL) {
+        END_TEST();
+        return;
+    }
+    
+    const char *queries[] = {"8.8.8.8", "1.1.1.1", "11.11.11.11"};
+    for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); i++) {
+        matchy_result_t result = matchy_query(prof_db, queries[i]);
+        matchy_free_result(&result);
+    }
+    
+    ASSERT(matchy_get_profile(prof_db, &prof) == MATCHY_SUCCESS, "Should read profile");
+    ASSERT(prof.sampled_queries == 3, "Every query should be sampled at rate 1");
+    const matchy_stage_stats_t *ip = &prof.stages[MATCHY_STAGE_IP_TREE];
+    ASSERT(ip->samples == 3, "Each IP query should walk the tree");
+    ASSERT(ip->p50_ns <= ip->p99_ns && ip->p99_ns <= ip->max_ns,
+           "Percentiles should be ordered");
+    ASSERT(prof.stages[MATCHY_STAGE_PATTERN_SCAN].samples == 0,
+           "IP queries should not run the pattern scan");
+    
+    matchy_close(prof_db);
+    END_TEST();
+}
+
 int main() {
     printf("========================================\n");
     printf("Matchy C API Extensions Test Suite\n");
@@ -510,6 +1099,18 @@ int main() {
     test_get_entry_data_list_complex(db);
     test_numeric_types(db);
     test_null_parameters(db);
+    test_query_batch(db);
+    test_query_n_and_ip(db);
+    test_query_ips(db);
+    test_foreach_network(db);
+    test_lazy_results(db);
+    test_ipv4_direct_index(db);
+    test_negative_cache(db);
+    test_cache_policy(db);
+    test_reload(db);
+    test_arena(db);
+    test_worker_scan(db);
+    test_profile(db);
     
     // Cleanup
     matchy_close(db);
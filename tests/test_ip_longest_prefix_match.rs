@@ -319,3 +319,81 @@ fn test_ipv6_longest_prefix_match() {
     let level = get_level(result);
     assert_eq!(level, "64", "2001:db8::1:0:0 should match /64 prefix");
 }
+
+#[test]
+fn test_stride_index_matches_binary_tree() {
+    // Same entries with and without the stride index must answer identically
+    let build = |stride: bool| {
+        let mut builder = MmdbBuilder::new(MatchMode::CaseSensitive).with_ip_stride_index(stride);
+        let entries = [
+            "10.0.0.0/8",
+            "10.1.0.0/16",
+            "10.1.2.0/23",
+            "10.1.2.3",
+            "192.0.2.0/25",
+            "2001:db8::/32",
+            "2001:db8:abcd::/48",
+            "2001:db8:abcd::1",
+            "evil.example.com",
+        ];
+        for (i, entry) in entries.iter().enumerate() {
+            let mut data = HashMap::new();
+            data.insert("level".to_string(), DataValue::Uint32(i as u32));
+            builder.add_entry(entry, data).unwrap();
+        }
+        Database::from_bytes(builder.build().unwrap()).unwrap()
+    };
+    let answer = |result: Option<QueryResult>| match result {
+        Some(QueryResult::Ip { data, prefix_len }) => Some((data, prefix_len)),
+        Some(QueryResult::NotFound) | None => None,
+        Some(other) => panic!("Expected IP result, got {:?}", other),
+    };
+
+    let plain = build(false);
+    let strided = build(true);
+    assert!(!plain.has_ip_stride_index());
+    assert!(strided.has_ip_stride_index());
+    assert!(strided.lookup("evil.example.com").unwrap().is_some());
+
+    let queries = [
+        "10.0.0.1",
+        "10.1.0.1",
+        "10.1.3.255",
+        "10.1.2.3",
+        "10.1.4.0",
+        "192.0.2.127",
+        "192.0.2.128",
+        "8.8.8.8",
+        "2001:db8::1",
+        "2001:db8:abcd::1",
+        "2001:db8:abcd::2",
+        "2001:db9::1",
+    ];
+    for query in queries {
+        let expected = answer(plain.lookup(query).unwrap());
+        assert_eq!(
+            expected,
+            answer(strided.lookup(query).unwrap()),
+            "{}",
+            query
+        );
+        assert_eq!(
+            expected,
+            answer(strided.lookup_ip(query.parse().unwrap()).unwrap()),
+            "{}",
+            query
+        );
+    }
+
+    let mut batch = Vec::new();
+    strided.clear_cache();
+    strided.lookup_batch(&queries, &mut batch);
+    for (query, result) in queries.iter().zip(batch) {
+        assert_eq!(
+            answer(plain.lookup(query).unwrap()),
+            answer(result.unwrap()),
+            "{}",
+            query
+        );
+    }
+}
@@ -363,16 +363,35 @@ void test_mmdb_get_entry_data_list() {
             int count = 0;
             MMDB_entry_data_list_s *current = list;
             
+            int same_pool = 1;
+            
             while (current != NULL) {
                 count++;
+                if (current->pool != list->pool) {
+                    same_pool = 0;
+                }
                 current = current->next;
             }
             
             ASSERT(count > 0, "Should have at least one node");
+            ASSERT(list->pool != NULL, "List should be backed by a pool");
+            ASSERT(same_pool, "All nodes should share the list's pool");
             printf("  Total nodes in list: %d\n", count);
             
             MMDB_free_entry_data_list(list);
         }
+        
+        /* Repeated lookups reuse the released pool */
+        int failures = 0;
+        for (int i = 0; i < 100; i++) {
+            MMDB_entry_data_list_s *again = NULL;
+            if (MMDB_get_entry_data_list(&result.entry, &again) != MMDB_SUCCESS ||
+                again == NULL) {
+                failures++;
+            }
+            MMDB_free_entry_data_list(again);
+        }
+        ASSERT(failures == 0, "Repeated list builds should succeed");
     }
     
     MMDB_close(&mmdb);